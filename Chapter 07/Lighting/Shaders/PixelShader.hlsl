@@ -32,6 +32,7 @@ struct VertexOut
 	float4 PosH    : SV_POSITION;
 	float3 PosW    : POSITION;
 	float3 NormalW : NORMAL;
+	float AmbientAccess : AMBIENT;
 };
 
 float4 PS(VertexOut pin) : SV_Target
@@ -66,7 +67,8 @@ float4 PS(VertexOut pin) : SV_Target
 		ComputeDirectionalLight(gMaterial, gDirLights[i], pin.NormalW, toEye,
 			A, D, S);
 
-		ambient += A;
+		// Baked occlusion only darkens the light that arrives from every direction.
+		ambient += A * pin.AmbientAccess;
 		diffuse += D;
 		spec += S;
 	}
@@ -18,6 +18,7 @@ struct VertexIn
 {
 	float3 PosL    : POSITION;
 	float3 NormalL : NORMAL;
+	float AmbientAccess : AMBIENT;
 };
 
 struct VertexOut
@@ -25,6 +26,7 @@ struct VertexOut
 	float4 PosH    : SV_POSITION;
 	float3 PosW    : POSITION;
     float3 NormalW : NORMAL;
+	float AmbientAccess : AMBIENT;
 };
 
 VertexOut VS(VertexIn vin)
@@ -33,6 +35,7 @@ VertexOut VS(VertexIn vin)
 
 	vout.PosW = mul(float4(vin.PosL, 1.0f), gWorld).xyz;
 	vout.NormalW = mul(vin.NormalL, (float3x3)gWorldInvTranspose);
+	vout.AmbientAccess = vin.AmbientAccess;
 
 	// Transform to homogeneous clip space.
 	vout.PosH = mul(float4(vin.PosL, 1.0f), gWorldViewProj);
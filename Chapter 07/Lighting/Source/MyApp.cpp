@@ -6,6 +6,7 @@
 #include "GeometryGenerator.h"
 #include "MathHelper.h"
 #include "D3DCompiler.h"
+#include "GModelFile.h"
 
 MyApp::MyApp(HINSTANCE Instance) :
 	D3DApp(Instance),
@@ -21,7 +22,9 @@ MyApp::MyApp(HINSTANCE Instance) :
 	mPhi(0.1f*MathHelper::Pi),
 	mRadius(15.0f),
 	mInputLayout(0),
-	mWireframeRS(0)
+	mWireframeRS(0),
+	mSkullObject(0),
+	mSkullIndexCount(0)
 {
 	mWindowTitle = L"Lighting Demo";
 }
@@ -52,8 +55,8 @@ bool MyApp::Init()
 	InitUserInput();
 
 	// Create the geometry for the demo and set their world positions
-	mSkullObject = new GObject("Models/skull.txt");
-	BuildGeometryBuffers(mSkullObject);
+	mSkullObject = new GObject();
+	if (!BuildSkullGeometryBuffers()) { return false; }
 
 	BuildShapeGeometryBuffers();
 	PositionObjects();
@@ -183,12 +186,14 @@ void MyApp::BuildShapeGeometryBuffers()
 	{
 		vertices[k].Pos = box.Vertices[i].Position;
 		vertices[k].Normal = box.Vertices[i].Normal;
+		vertices[k].AmbientAccess = 1.0f;
 	}
 
 	for (size_t i = 0; i < grid.Vertices.size(); ++i, ++k)
 	{
 		vertices[k].Pos = grid.Vertices[i].Position;
 		vertices[k].Normal = grid.Vertices[i].Normal;
+		vertices[k].AmbientAccess = 1.0f;
 	}
 
 	//	for (size_t i = 0; i < sphere.Vertices.size(); ++i, ++k)
@@ -234,31 +239,55 @@ void MyApp::BuildShapeGeometryBuffers()
 	HR(mDevice->CreateBuffer(&ibd, &iinitData, &mShapesIndexBuffer));
 }
 
-void MyApp::BuildGeometryBuffers(GObject* obj)
+bool MyApp::BuildSkullGeometryBuffers()
 {
+	// Tools/Model Baker writes skull.bmodel from skull.txt with per-vertex ambient access:
+	//   ModelBaker Models/skull.txt Models/skull.bmodel
+	// The text model still loads without it, lit by the flat ambient term.
+	GModelFile::Mesh mesh;
+	bool bLoaded = GModelFile::ReadAny(L"Models/skull.bmodel", mesh) ||
+		GModelFile::ReadText(L"Models/skull.txt", mesh);
+
+	// The buffers below cannot be created empty.
+	if (!bLoaded || mesh.Indices.empty())
+	{
+		MessageBox(0, L"Skull model missing or empty.", 0, 0);
+		return false;
+	}
+
+	bool bBaked = mesh.AmbientAccess.size() == mesh.Positions.size();
+
+	std::vector<Vertex> vertices(mesh.Positions.size());
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		vertices[i].Pos = mesh.Positions[i];
+		vertices[i].Normal = mesh.Normals[i];
+		vertices[i].AmbientAccess = bBaked ? mesh.AmbientAccess[i] : 1.0f;
+	}
+
+	mSkullIndexCount = static_cast<UINT>(mesh.Indices.size());
+
 	D3D11_BUFFER_DESC vbd;
 	vbd.Usage = D3D11_USAGE_IMMUTABLE;
-	vbd.ByteWidth = sizeof(Vertex) * obj->GetVertexCount();
+	vbd.ByteWidth = sizeof(Vertex) * static_cast<UINT>(vertices.size());
 	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	vbd.CPUAccessFlags = 0;
 	vbd.MiscFlags = 0;
 	D3D11_SUBRESOURCE_DATA vinitData;
-	vinitData.pSysMem = obj->GetVertices();
-	HR(mDevice->CreateBuffer(&vbd, &vinitData, obj->GetVertexBuffer()));
-
-	//
-	// Pack the indices of all the meshes into one index buffer.
-	//
+	vinitData.pSysMem = &vertices[0];
+	HR(mDevice->CreateBuffer(&vbd, &vinitData, mSkullObject->GetVertexBuffer()));
 
 	D3D11_BUFFER_DESC ibd;
 	ibd.Usage = D3D11_USAGE_IMMUTABLE;
-	ibd.ByteWidth = sizeof(UINT) * obj->GetIndexCount();
+	ibd.ByteWidth = sizeof(UINT) * mSkullIndexCount;
 	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	ibd.CPUAccessFlags = 0;
 	ibd.MiscFlags = 0;
 	D3D11_SUBRESOURCE_DATA iinitData;
-	iinitData.pSysMem = obj->GetIndices();
-	HR(mDevice->CreateBuffer(&ibd, &iinitData, obj->GetIndexBuffer()));
+	iinitData.pSysMem = &mesh.Indices[0];
+	HR(mDevice->CreateBuffer(&ibd, &iinitData, mSkullObject->GetIndexBuffer()));
+
+	return true;
 }
 
 void MyApp::PositionObjects()
@@ -298,7 +327,8 @@ void MyApp::BuildVertexShader(ID3D11VertexShader** shader, LPCWSTR filename, LPC
 	D3D11_INPUT_ELEMENT_DESC vertexDesc[] =
 	{
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+		{ "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "AMBIENT",  0, DXGI_FORMAT_R32_FLOAT,       0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 }
 	};
 
 	UINT numElements = sizeof(vertexDesc) / sizeof(D3D11_INPUT_ELEMENT_DESC);
@@ -487,7 +517,7 @@ void MyApp::DrawScene()
 
 	mImmediateContext->VSSetConstantBuffers(1, 1, &mConstBufferPerObject);
 	mImmediateContext->PSSetConstantBuffers(1, 1, &mConstBufferPerObject);
-	mImmediateContext->DrawIndexed(mSkullObject->GetIndexCount(), 0, 0);
+	mImmediateContext->DrawIndexed(mSkullIndexCount, 0, 0);
 
 	HR(mSwapChain->Present(0, 0));
 }
\ No newline at end of file
@@ -45,7 +45,7 @@ public:
 
 private:
 	void BuildShapeGeometryBuffers();
-	void BuildGeometryBuffers(GObject* obj);
+	bool BuildSkullGeometryBuffers();
 
 	void BuildVertexShader(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint);
 	void BuildPixelShader(ID3D11PixelShader** shader, LPCWSTR filename, LPCSTR entryPoint);
@@ -108,6 +108,7 @@ private:
 
 	// Objects
 	GObject* mSkullObject;
+	UINT mSkullIndexCount;
 };
 
 #endif // MYAPP_H
\ No newline at end of file
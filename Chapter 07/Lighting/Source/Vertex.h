@@ -7,6 +7,9 @@ struct Vertex
 {
 	DirectX::XMFLOAT3 Pos;
 	DirectX::XMFLOAT3 Normal;
+
+	// Baked ambient occlusion, 1 for geometry with nothing baked.
+	float AmbientAccess;
 };
 
 #endif // !VERTEX_H
\ No newline at end of file
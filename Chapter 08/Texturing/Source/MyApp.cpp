@@ -6,6 +6,7 @@ Summary: DX11 Chapter 4
 #include "GeometryGenerator.h"
 #include "MathHelper.h"
 #include "D3DCompiler.h"
+#include "GTextureCache.h"
 
 MyApp::MyApp(HINSTANCE Instance) :
 	D3DApp(Instance),
@@ -38,6 +39,9 @@ MyApp::~MyApp()
 	ReleaseCOM(mPixelShader);
 	ReleaseCOM(mInputLayout);
 	ReleaseCOM(mWireframeRS);
+
+	// Drop the cache's references before the device goes away.
+	GTextureCache::Get().Clear();
 }
 
 bool MyApp::Init()
@@ -75,9 +79,8 @@ bool MyApp::Init()
 
 void MyApp::LoadTextureToSRV(LPCWSTR filename, ID3D11ShaderResourceView** SRV)
 {
-	ID3D11Resource* texResource = nullptr;
-	HR(DirectX::CreateDDSTextureFromFile(mDevice, filename, &texResource, SRV));
-	ReleaseCOM(texResource); // view saves reference
+	// Objects that use the same file share one texture.
+	HR(GTextureCache::Get().Acquire(mDevice, filename, SRV));
 }
 
 void MyApp::InitUserInput()
@@ -6,6 +6,9 @@
 #include "GeometryGenerator.h"
 #include "MathHelper.h"
 #include "D3DCompiler.h"
+#include "GTextureCache.h"
+
+#include <sstream>
 
 MyApp::MyApp(HINSTANCE Instance) :
 	D3DApp(Instance),
@@ -19,7 +22,10 @@ MyApp::MyApp(HINSTANCE Instance) :
 	mWireframeRS(0),
 	mSamplerState(0)
 {
-	mWindowTitle = L"Blending Demo";
+	// Step the simulation at 60 Hz and blend between steps when drawing.
+	mFrameScheduler.SetFixedTimestep(1.0 / 60.0);
+
+	UpdateWindowTitle();
 }
 
 MyApp::~MyApp()
@@ -37,6 +43,9 @@ MyApp::~MyApp()
 	ReleaseCOM(mWireframeRS);
 	ReleaseCOM(mSamplerState);
 	ReleaseCOM(mBlendState);
+
+	// Drop the cache's references before the device goes away.
+	GTextureCache::Get().Clear();
 }
 
 bool MyApp::Init()
@@ -48,6 +57,7 @@ bool MyApp::Init()
 	mCamera.SetPosition(30.0f, 50.0f, -100.0f);
 	mCamera.RotateY(-MathHelper::Pi / 8.0f);
 	mCamera.Pitch(MathHelper::Pi / 8.0f);
+	mPrevCameraPos = mCamera.GetPosition();
 
 	// Initialize User Input
 	InitUserInput();
@@ -116,6 +126,53 @@ void MyApp::OnMouseMove(WPARAM btnState, int x, int y)
 	mLastMousePos.y = y;
 }
 
+void MyApp::OnKeyDown(WPARAM key, LPARAM info)
+{
+	if (key == 0x31)
+	{
+		mFrameScheduler.SetFrameRateLimit(0.0);
+	}
+	else if (key == 0x32)
+	{
+		mFrameScheduler.SetFrameRateLimit(60.0);
+	}
+	else if (key == 0x33)
+	{
+		mFrameScheduler.SetFrameRateLimit(144.0);
+	}
+	else if (key == 'L' || key == 'l')
+	{
+		mFrameScheduler.SetLowLatency(!mFrameScheduler.IsLowLatency());
+		ApplyFrameLatency();
+	}
+	else
+	{
+		return;
+	}
+
+	mFrameScheduler.Reset();
+	UpdateWindowTitle();
+}
+
+void MyApp::UpdateWindowTitle()
+{
+	std::wostringstream title;
+	title << L"Blending Demo    ";
+
+	if (mFrameScheduler.GetFrameRateLimit() > 0.0)
+	{
+		title << L"Cap: " << mFrameScheduler.GetFrameRateLimit() << L" fps";
+	}
+	else
+	{
+		title << L"Cap: off";
+	}
+
+	title << (mFrameScheduler.IsLowLatency() ? L"    Low latency" : L"");
+
+	mWindowTitle = title.str();
+}
+
 void MyApp::CreateGeometryBuffers(GObject* obj, bool dynamic)
 {
 	D3D11_BUFFER_DESC vbd;
@@ -210,9 +267,8 @@ void MyApp::CreatePixelShader(ID3D11PixelShader** shader, LPCWSTR filename, LPCS
 
 void MyApp::LoadTextureToSRV(ID3D11ShaderResourceView** SRV, LPCWSTR filename)
 {
-	ID3D11Resource* texResource = nullptr;
-	HR(DirectX::CreateDDSTextureFromFile(mDevice, filename, &texResource, SRV));
-	ReleaseCOM(texResource); // view saves reference
+	// Objects that use the same file share one texture.
+	HR(GTextureCache::Get().Acquire(mDevice, filename, SRV));
 }
 
 void MyApp::CreateConstantBuffer(ID3D11Buffer** buffer, UINT size)
@@ -315,6 +371,8 @@ void MyApp::OnResize()
 
 void MyApp::UpdateScene(float dt)
 {
+	mPrevCameraPos = mCamera.GetPosition();
+
 	//
 	// Control the camera.
 	//
@@ -330,12 +388,7 @@ void MyApp::UpdateScene(float dt)
 	if (GetAsyncKeyState('D') & 0x8000)
 		mCamera.Strafe(10.0f*dt);
 
-	D3D11_MAPPED_SUBRESOURCE mappedData;
-	HR(mImmediateContext->Map(*mWaveObject->GetVertexBuffer(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData));
-
-	mWaveObject->Update(mTimer.TotalTime(), dt, mappedData.pData);
-
-	mImmediateContext->Unmap(*mWaveObject->GetVertexBuffer(), 0);
+	mWaveObject->Update(mTimer.TotalTime(), dt);
 }
 
 void MyApp::DrawScene()
@@ -344,9 +397,25 @@ void MyApp::DrawScene()
 	mImmediateContext->ClearRenderTargetView(mRenderTargetView, reinterpret_cast<const float*>(&Colors::Silver));
 	mImmediateContext->ClearDepthStencilView(mDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
+	// Upload the waves as they are between the last two steps.
+	D3D11_MAPPED_SUBRESOURCE mappedData;
+	HR(mImmediateContext->Map(*mWaveObject->GetVertexBuffer(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData));
+
+	mWaveObject->WriteVertices(mappedData.pData, mFrameScheduler.GetAlpha());
+
+	mImmediateContext->Unmap(*mWaveObject->GetVertexBuffer(), 0);
+
+	// View from the camera position between the last two steps.
+	DirectX::XMFLOAT3 cameraPos = mCamera.GetPosition();
+	DirectX::XMVECTOR prevPos = DirectX::XMLoadFloat3(&mPrevCameraPos);
+	DirectX::XMFLOAT3 drawPos;
+	DirectX::XMStoreFloat3(&drawPos, DirectX::XMVectorLerp(prevPos, mCamera.GetPositionXM(), mFrameScheduler.GetAlpha()));
+	mCamera.SetPosition(drawPos);
+
 	// Multiply the view and projection matrics
 	mCamera.UpdateViewMatrix();
 	DirectX::XMMATRIX viewProj = mCamera.ViewProj();
+	mCamera.SetPosition(cameraPos);
 
 	// Set per frame constants.
 	D3D11_MAPPED_SUBRESOURCE cbPerFrameResource;
@@ -357,7 +426,7 @@ void MyApp::DrawScene()
 	cbPerFrame->dirLight0 = mDirLights[0];
 	cbPerFrame->dirLight1 = mDirLights[1];
 	cbPerFrame->dirLight2 = mDirLights[2];
-	cbPerFrame->eyePosW = mCamera.GetPosition();
+	cbPerFrame->eyePosW = drawPos;
 	cbPerFrame->fogStart = 15.0f;
 	cbPerFrame->fogRange = 175.0f;
 	DirectX::XMStoreFloat4(&cbPerFrame->fogColor, Colors::Silver);
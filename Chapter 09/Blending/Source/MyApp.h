@@ -51,6 +51,9 @@ public:
 	void OnMouseUp(WPARAM btnState, int x, int y);
 	void OnMouseMove(WPARAM btnState, int x, int y);
 
+	// 1, 2 and 3 set the frame-rate cap to off, 60 and 144 fps; L toggles low latency.
+	void OnKeyDown(WPARAM key, LPARAM info);
+
 private:
 	void CreateRasterizerState();
 	void CreateSamplerState();
@@ -67,6 +70,7 @@ private:
 	void InitUserInput();
 	void PositionObjects();
 	void SetupStaticLights();
+	void UpdateWindowTitle();
 
 private:
 	// Constant Buffers
@@ -91,6 +95,7 @@ private:
 
 	// Camera
 	GFirstPersonCamera mCamera;
+	DirectX::XMFLOAT3 mPrevCameraPos;
 
 	// User Input
 	POINT mLastMousePos;
@@ -6,6 +6,7 @@
 #include "GeometryGenerator.h"
 #include "MathHelper.h"
 #include "D3DCompiler.h"
+#include "GTextureCache.h"
 
 MyApp::MyApp(HINSTANCE Instance) :
 	D3DApp(Instance),
@@ -21,7 +22,8 @@ MyApp::MyApp(HINSTANCE Instance) :
 	mMarkMirrorDSS(0),
 	mDrawReflectionDSS(0),
 	mNoDoubleBlendDSS(0),
-	mSamplerState(0)
+	mSamplerState(0),
+	mReflectionDraws(0)
 {
 	mWindowTitle = L"Stencil Mirror Demo";
 }
@@ -45,6 +47,9 @@ MyApp::~MyApp()
 	ReleaseCOM(mDrawReflectionDSS);
 	ReleaseCOM(mNoDoubleBlendDSS);
 	ReleaseCOM(mSamplerState);
+
+	// Drop the cache's references before the device goes away.
+	GTextureCache::Get().Clear();
 }
 
 bool MyApp::Init()
@@ -78,6 +83,7 @@ bool MyApp::Init()
 	CreateGeometryBuffers(mMirrorObject, true);
 
 	PositionObjects();
+	SetupMirror();
 
 	// Compile Shaders
 	CreateVertexShader(&mVertexShader, L"Shaders/VertexShader.hlsl", "VS");
@@ -224,6 +230,38 @@ void MyApp::PositionObjects()
 	LoadTextureToSRV(mMirrorObject->GetDiffuseMapSRV(), L"Textures/ice.dds");
 }
 
+void MyApp::SetupMirror()
+{
+	// The plane's four vertices, taken clockwise from the front: top left, top right, bottom right, bottom left.
+	const UINT ring[4] = { 0, 1, 3, 2 };
+
+	DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&mMirrorObject->GetWorldTransform());
+	Vertex* vertices = static_cast<Vertex*>(mMirrorObject->GetVertices());
+
+	DirectX::XMFLOAT3 corners[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		DirectX::XMStoreFloat3(&corners[i], DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&vertices[ring[i]].Pos), world));
+	}
+
+	mMirror.SetMirror(corners);
+
+	// Nothing moves, so the reflected objects' bounds are built once.
+	mSkullBounds = GetWorldBounds(mSkullObject);
+	mFloorBounds = GetWorldBounds(mFloorObject);
+}
+
+DirectX::BoundingBox MyApp::GetWorldBounds(GObject* object)
+{
+	DirectX::BoundingBox local;
+	DirectX::BoundingBox::CreateFromPoints(local, object->GetVertexCount(),
+		&static_cast<Vertex*>(object->GetVertices())->Pos, sizeof(Vertex));
+
+	DirectX::BoundingBox world;
+	local.Transform(world, DirectX::XMLoadFloat4x4(&object->GetWorldTransform()));
+	return world;
+}
+
 void MyApp::CreateVertexShader(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint)
 {
 	ID3DBlob* VSByteCode = 0;
@@ -259,9 +297,8 @@ void MyApp::CreatePixelShader(ID3D11PixelShader** shader, LPCWSTR filename, LPCS
 
 void MyApp::LoadTextureToSRV(ID3D11ShaderResourceView** SRV, LPCWSTR filename)
 {
-	ID3D11Resource* texResource = nullptr;
-	HR(DirectX::CreateDDSTextureFromFile(mDevice, filename, &texResource, SRV));
-	ReleaseCOM(texResource); // view saves reference
+	// Objects that use the same file share one texture.
+	HR(GTextureCache::Get().Acquire(mDevice, filename, SRV));
 }
 
 void MyApp::CreateConstantBuffer(ID3D11Buffer** buffer, UINT size)
@@ -476,6 +513,15 @@ void MyApp::DrawScene()
 	mCamera.UpdateViewMatrix();
 	float blendFactor[] = { 0.0f, 0.0f, 0.0f, 0.0f };
 
+	// Fit the mirror to the camera; a mirror seen from behind or off screen reflects nothing
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 proj;
+	DirectX::XMStoreFloat4x4(&view, mCamera.View());
+	DirectX::XMStoreFloat4x4(&proj, mCamera.Proj());
+
+	bool bReflection = mMirror.Update(view, proj);
+	UINT reflectionDraws = 0;
+
 	// Set per frame constants
 	{
 		mImmediateContext->Map(mConstBufferPerFrame, 0, D3D11_MAP_WRITE_DISCARD, 0, &cbPerFrameResource);
@@ -532,6 +578,7 @@ void MyApp::DrawScene()
 	}
 
 	// Draw Mirror to Stencil Buffer
+	if (bReflection)
 	{
 		mImmediateContext->OMSetBlendState(mNoRenderTargetWritesBS, blendFactor, 0xffffffff); // Do not write to render target.
 		mImmediateContext->OMSetDepthStencilState(mMarkMirrorDSS, 1); // Render visible mirror pixels to stencil buffer. Do not write mirror depth to depth buffer at this point, otherwise it will occlude the reflection.
@@ -539,10 +586,10 @@ void MyApp::DrawScene()
 		DrawObject(mMirrorObject);
 	}
 
-	// Draw the skull reflection.
+	// Draw the reflections of the objects that can be seen in the mirror.
+	if (bReflection)
 	{
-		DirectX::XMVECTOR mirrorPlane = DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f); // xy plane
-		DirectX::XMMATRIX R = DirectX::XMMatrixReflect(mirrorPlane);
+		DirectX::XMMATRIX R = mMirror.GetReflection();
 
 		DirectionalLight ReflectedDirLights[3];
 		for (int i = 0; i < 3; ++i)
@@ -563,9 +610,29 @@ void MyApp::DrawScene()
 		mImmediateContext->RSSetState(mCullClockwiseRS); // Cull clockwise triangles for reflection.
 		mImmediateContext->OMSetBlendState(0, blendFactor, 0xffffffff);
 		mImmediateContext->OMSetDepthStencilState(mDrawReflectionDSS, 1); // Only draw reflection into visible mirror pixels as marked by the stencil buffer. 
-		mImmediateContext->PSSetShader(mPixelShaderNoTexture, NULL, 0);
+		if (mMirror.IsVisible(mSkullBounds))
+		{
+			mImmediateContext->PSSetShader(mPixelShaderNoTexture, NULL, 0);
+			DrawObjectTransform(mSkullObject, R);
+			++reflectionDraws;
+		}
+
+		if (mMirror.IsVisible(mFloorBounds))
+		{
+			mImmediateContext->PSSetShader(mPixelShader, NULL, 0);
+			DrawObjectTransform(mFloorObject, R);
+			++reflectionDraws;
+		}
+	}
+
+	// Report the reflected draws next to the frame stats.
+	if (reflectionDraws != mReflectionDraws)
+	{
+		mReflectionDraws = reflectionDraws;
 
-		DrawObjectTransform(mSkullObject, R);
+		std::wostringstream title;
+		title << L"Stencil Mirror Demo    Reflected Objects: " << mReflectionDraws << L"/2";
+		mWindowTitle = title.str();
 	}
 
 	// Draw the mirror to the back buffer as usual but with transparency blending so the reflection shows through.
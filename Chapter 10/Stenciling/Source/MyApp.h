@@ -11,6 +11,7 @@
 #include "GPlaneXY.h"
 #include "GPlaneXZ.h"
 #include "GFirstPersonCamera.h"
+#include "GPlanarReflection.h"
 
 struct ConstBufferPerObject
 {
@@ -70,6 +71,9 @@ private:
 	void InitUserInput();
 	void PositionObjects();
 	void SetupStaticLights();
+	void SetupMirror();
+
+	DirectX::BoundingBox GetWorldBounds(GObject* object);
 
 	void DrawObject(GObject* object);
 	void DrawObjectTransform(GObject* object, DirectX::XMMATRIX& tranform);
@@ -119,6 +123,12 @@ private:
 
 	Material mShadowMat;
 
+	// The mirror, and the bounds of the objects it reflects
+	GPlanarReflection mMirror;
+	DirectX::BoundingBox mSkullBounds;
+	DirectX::BoundingBox mFloorBounds;
+	UINT mReflectionDraws;
+
 	D3D11_MAPPED_SUBRESOURCE cbPerFrameResource;
 	ConstBufferPerFrame* cbPerFrame;
 
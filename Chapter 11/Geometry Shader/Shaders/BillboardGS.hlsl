@@ -13,12 +13,14 @@ cbuffer cbPerFrame : register(b0)
     Material gMaterial;
     float3 gEyePosW;
     float pad;
+    float4 gAtlasRects[16];
 };
 
 struct VertexOut
 {
     float3 CenterW : POSITION;
     float2 SizeW : SIZE;
+    uint Type : TYPE;
 };
 
 struct GeoOut
@@ -61,13 +63,16 @@ void GS(point VertexOut gin[1], uint primId : SV_PrimitiveID, inout TriangleStre
 	    float2(1.0f, 0.0f)
     };
 
+	// Each tree picks its image from the atlas.
+    float4 rect = gAtlasRects[gin[0].Type];
+
 	[unroll]
     for (int i = 0; i < 4; ++i)
     {
         gout.PosH = mul(v[i], gViewProj);
         gout.PosW = v[i].xyz;
         gout.NormalW = look;
-        gout.Tex = gQuadTexC[i];
+        gout.Tex = lerp(rect.xy, rect.zw, gQuadTexC[i]);
         gout.PrimID = primId;
 
         triStream.Append(gout);
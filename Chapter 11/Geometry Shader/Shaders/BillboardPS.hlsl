@@ -10,6 +10,7 @@ cbuffer cbPerFrame : register(b0)
     Material gMaterial;
     float3 gEyePosW;
     float pad;
+    float4 gAtlasRects[16];
 };
 
 struct GeoOut
@@ -5,12 +5,14 @@ struct VertexIn
 {
     float3 CenterW : POSITION;
     float2 SizeW   : SIZE;
+    uint Type      : TYPE;
 };
 
 struct VertexOut
 {
     float3 CenterW : POSITION;
     float2 SizeW   : SIZE;
+    uint Type      : TYPE;
 };
 
 VertexOut VS(VertexIn vin)
@@ -19,6 +21,7 @@ VertexOut VS(VertexIn vin)
 	
     vout.CenterW = vin.CenterW;
     vout.SizeW = vin.SizeW;
+    vout.Type = vin.Type;
     	
     return vout;
 }
@@ -6,6 +6,8 @@
 #include "GeometryGenerator.h"
 #include "MathHelper.h"
 #include "D3DCompiler.h"
+#include "GTextureCache.h"
+#include "GTextureAtlas.h"
 
 MyApp::MyApp(HINSTANCE Instance) :
 	D3DApp(Instance),
@@ -20,7 +22,12 @@ MyApp::MyApp(HINSTANCE Instance) :
 	mSamplerState(0),
 	mBillboardVS(0),
 	mBillboardGS(0),
-	mBillboardPS(0)
+	mBillboardPS(0),
+	mBillboardVB(0),
+	mBillboardCapacity(0),
+	mTreeTexSRV(0),
+	mForestSeed(0),
+	bStressForest(false)
 {
 	mWindowTitle = L"Geometry Shader Demo";
 }
@@ -40,6 +47,12 @@ MyApp::~MyApp()
 	ReleaseCOM(mWireframeRS);
 	ReleaseCOM(mSamplerState);
 	ReleaseCOM(mBlendState);
+
+	ReleaseCOM(mBillboardVB);
+	ReleaseCOM(mTreeTexSRV);
+
+	// Drop the cache's references before the device goes away.
+	GTextureCache::Get().Clear();
 }
 
 bool MyApp::Init()
@@ -93,9 +106,9 @@ bool MyApp::Init()
 	CreateBlendState();
 
 	SetupStaticLights();
-	BuildBillboardBuffer();
 
-	LoadTextureToSRV(&mTreeTexSRV, L"Textures/tree0.dds");
+	LoadTreeAtlas();
+	BuildForest();
 
 	return true;
 }
@@ -137,10 +150,16 @@ void MyApp::OnMouseMove(WPARAM btnState, int x, int y)
 
 void MyApp::OnKeyDown(WPARAM key, LPARAM info)
 {
+	// 1 replants the forest; 2 switches to and from a million small trees.
 	if (key == 0x31)
 	{
-		srand(mTimer.TotalTime());
-		BuildBillboardBuffer();
+		mForestSeed = static_cast<UINT>(mTimer.TotalTime() * 1000.0f);
+		BuildForest();
+	}
+	else if (key == 0x32)
+	{
+		bStressForest = !bStressForest;
+		BuildForest();
 	}
 }
 
@@ -242,6 +261,7 @@ void MyApp::CreateVertexShaderBillboard(ID3D11VertexShader** shader, LPCWSTR fil
 	{
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,  D3D11_INPUT_PER_VERTEX_DATA, 0 },
 		{ "SIZE",     0, DXGI_FORMAT_R32G32_FLOAT,    0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TYPE",     0, DXGI_FORMAT_R32_UINT,        0, 20, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 	};
 
 	UINT numElements = sizeof(vertexDesc) / sizeof(D3D11_INPUT_ELEMENT_DESC);
@@ -274,9 +294,8 @@ void MyApp::CreatePixelShader(ID3D11PixelShader** shader, LPCWSTR filename, LPCS
 
 void MyApp::LoadTextureToSRV(ID3D11ShaderResourceView** SRV, LPCWSTR filename)
 {
-	ID3D11Resource* texResource = nullptr;
-	HR(DirectX::CreateDDSTextureFromFile(mDevice, filename, &texResource, SRV));
-	ReleaseCOM(texResource); // view saves reference
+	// Objects that use the same file share one texture.
+	HR(GTextureCache::Get().Acquire(mDevice, filename, SRV));
 }
 
 void MyApp::CreateConstantBuffer(ID3D11Buffer** buffer, UINT size)
@@ -375,38 +394,96 @@ float MyApp::GetHillHeight(float x, float z) const
 	return 0.3f*(z*sinf(0.1f*x) + x*cosf(0.1f*z));
 }
 
-void MyApp::BuildBillboardBuffer()
+void MyApp::LoadTreeAtlas()
 {
-	Billboard v[mTreeCount];
+	// The atlas is built offline from the tree textures:
+	//   TextureTools atlas Textures/trees.dds Textures/tree0.dds Textures/tree1.dds ...
+	// which also writes Textures/trees.atlas.  Without one, every tree uses tree0.dds.
+	if (GTextureAtlas::ReadLayout(L"Textures/trees.atlas", mTreeAtlasRects) && !mTreeAtlasRects.empty())
+	{
+		LoadTextureToSRV(&mTreeTexSRV, L"Textures/trees.dds");
+	}
+	else
+	{
+		mTreeAtlasRects.assign(1, DirectX::XMFLOAT4(0.0f, 0.0f, 1.0f, 1.0f));
+		LoadTextureToSRV(&mTreeTexSRV, L"Textures/tree0.dds");
+	}
 
-	for (UINT i = 0; i < mTreeCount; ++i)
+	// The billboard constant buffer has room for 16.
+	if (mTreeAtlasRects.size() > 16)
 	{
-		float x = -1;
-		float y = -1;
-		float z = -1;
-		while (y < 0)
+		mTreeAtlasRects.resize(16);
+	}
+}
+
+void MyApp::BuildForest()
+{
+	// Trees thin out towards the shore and leave clearings on the slopes.
+	const UINT densityMapSize = 64;
+	std::vector<float> densityMap(densityMapSize * densityMapSize);
+
+	for (UINT i = 0; i < densityMapSize; ++i)
+	{
+		for (UINT j = 0; j < densityMapSize; ++j)
 		{
-			x = MathHelper::RandF(-75.0f, 75.0f);
-			z = MathHelper::RandF(-75.0f, 75.0f);
-			y = GetHillHeight(x, z);
-		}
+			float x = -75.0f + 150.0f * j / (densityMapSize - 1);
+			float z = -75.0f + 150.0f * i / (densityMapSize - 1);
 
-		// Move tree slightly above land height.
-		y += 10.0f;
+			float shore = MathHelper::Clamp(GetHillHeight(x, z) / 10.0f, 0.0f, 1.0f);
+			float clearings = 0.6f + 0.4f * sinf(0.15f * x) * cosf(0.12f * z);
 
-		v[i].centerW = DirectX::XMFLOAT3(x, y, z);
-		v[i].sizeW = DirectX::XMFLOAT2(24.0f, 24.0f);
+			densityMap[i * densityMapSize + j] = shore * clearings;
+		}
 	}
 
-	D3D11_BUFFER_DESC vbd;
-	vbd.Usage = D3D11_USAGE_IMMUTABLE;
-	vbd.ByteWidth = sizeof(Billboard) * mTreeCount;
-	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vbd.CPUAccessFlags = 0;
-	vbd.MiscFlags = 0;
-	D3D11_SUBRESOURCE_DATA vinitData;
-	vinitData.pSysMem = v;
-	HR(mDevice->CreateBuffer(&vbd, &vinitData, &mBillboardVB));
+	GForest::Desc desc;
+	desc.MinX = -75.0f;
+	desc.MinZ = -75.0f;
+	desc.MaxX = 75.0f;
+	desc.MaxZ = 75.0f;
+	desc.DensityMap = &densityMap[0];
+	desc.DensityMapWidth = densityMapSize;
+	desc.DensityMapDepth = densityMapSize;
+	desc.GetHeight = [this](float x, float z) { return GetHillHeight(x, z); };
+	desc.MinHeight = 0.0f;
+	desc.NumSpriteTypes = static_cast<UINT>(mTreeAtlasRects.size());
+	desc.Seed = mForestSeed;
+
+	if (bStressForest)
+	{
+		// About a million trees at this density map.
+		desc.CellSize = 4.0f;
+		desc.Density = 215.0f;
+		desc.MinSize = DirectX::XMFLOAT2(1.5f, 1.5f);
+		desc.MaxSize = DirectX::XMFLOAT2(3.0f, 3.0f);
+	}
+	else
+	{
+		desc.CellSize = 16.0f;
+		desc.Density = 0.02f;
+		desc.MinSize = DirectX::XMFLOAT2(20.0f, 20.0f);
+		desc.MaxSize = DirectX::XMFLOAT2(28.0f, 28.0f);
+	}
+
+	mForest.Generate(desc);
+
+	// Reallocate only when the forest outgrows the buffer.
+	UINT numTrees = mForest.GetTreeCount();
+	if (numTrees > mBillboardCapacity || !mBillboardVB)
+	{
+		ReleaseCOM(mBillboardVB);
+
+		mBillboardCapacity = MathHelper::Max(numTrees, 1u);
+
+		D3D11_BUFFER_DESC vbd;
+		vbd.Usage = D3D11_USAGE_DYNAMIC;
+		vbd.ByteWidth = sizeof(GForest::Sprite) * mBillboardCapacity;
+		vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		vbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		vbd.MiscFlags = 0;
+		vbd.StructureByteStride = 0;
+		HR(mDevice->CreateBuffer(&vbd, 0, &mBillboardVB));
+	}
 }
 
 void MyApp::OnResize()
@@ -600,6 +677,26 @@ void MyApp::DrawGeometry()
 
 void MyApp::DrawTrees()
 {
+	// Cull the forest cells and refill the buffer only when a different set is visible.
+	DirectX::XMFLOAT4 frustumPlanes[6];
+	MathHelper::ExtractFrustumPlanes(frustumPlanes, mCamera.ViewProj());
+
+	if (mForest.Cull(frustumPlanes, mCamera.GetPosition(), 1000.0f))
+	{
+		D3D11_MAPPED_SUBRESOURCE mappedData;
+		HR(mImmediateContext->Map(mBillboardVB, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData));
+
+		mForest.Upload(static_cast<GForest::Sprite*>(mappedData.pData), mBillboardCapacity);
+
+		mImmediateContext->Unmap(mBillboardVB, 0);
+	}
+
+	std::wostringstream title;
+	title.precision(2);
+	title << std::fixed << L"Geometry Shader Demo    Trees: " << mForest.GetVisibleTreeCount() << L"/" << mForest.GetTreeCount()
+		<< L"    Cull: " << mForest.GetCullTime() << L" ms    Upload: " << mForest.GetUploadTime() << L" ms";
+	mWindowTitle = title.str();
+
 	mImmediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
 	mImmediateContext->IASetInputLayout(mVertexBillboard);
 
@@ -611,6 +708,10 @@ void MyApp::DrawTrees()
 	cbPerFrameBillboard->viewProj = DirectX::XMMatrixTranspose(mCamera.ViewProj());
 	cbPerFrameBillboard->material = mTreeMat;
 	cbPerFrameBillboard->eyePosW = mCamera.GetPosition();
+	for (UINT i = 0; i < mTreeAtlasRects.size(); ++i)
+	{
+		cbPerFrameBillboard->atlasRects[i] = mTreeAtlasRects[i];
+	}
 	mImmediateContext->Unmap(mCBPerFrameBillboard, 0);
 
 	mImmediateContext->GSSetConstantBuffers(0, 1, &mCBPerFrameBillboard);
@@ -622,12 +723,12 @@ void MyApp::DrawTrees()
 
 	mImmediateContext->PSSetShaderResources(0, 1, &mTreeTexSRV);
 
-	UINT stride = sizeof(Billboard);
+	UINT stride = sizeof(GForest::Sprite);
 	UINT offset = 0;
 
 	mImmediateContext->IASetVertexBuffers(0, 1, &mBillboardVB, &stride, &offset);
 
-	mImmediateContext->Draw(mTreeCount, 0);
+	mImmediateContext->Draw(mForest.GetVisibleTreeCount(), 0);
 
 	mImmediateContext->GSSetShader(0, NULL, 0);
 }
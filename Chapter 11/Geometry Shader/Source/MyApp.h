@@ -12,6 +12,7 @@
 #include "GHill.h"
 #include "GWave.h"
 #include "GFirstPersonCamera.h"
+#include "GForest.h"
 #include "Waves.h"
 
 struct ConstBufferPerObject
@@ -46,12 +47,9 @@ struct ConstBufferPerFrameBillboard
 
 	DirectX::XMFLOAT3 eyePosW;
 	float pad;
-};
 
-struct Billboard
-{
-	DirectX::XMFLOAT3 centerW;
-	DirectX::XMFLOAT2 sizeW;
+	// (u0, v0, u1, v1) of each tree in the atlas; the size matches gAtlasRects.
+	DirectX::XMFLOAT4 atlasRects[16];
 };
 
 class MyApp : public D3DApp
@@ -94,7 +92,8 @@ private:
 
 	void DrawGeometry();
 	void DrawTrees();
-	void BuildBillboardBuffer();
+	void LoadTreeAtlas();
+	void BuildForest();
 	float GetHillHeight(float x, float z) const;
 
 private:
@@ -140,12 +139,18 @@ private:
 	D3D11_MAPPED_SUBRESOURCE mCBPerFrameBillboardResource;
 	ConstBufferPerFrameBillboard* cbPerFrameBillboard;
 
+	// Holds every tree so any set of visible cells fits; only those cells are written.
 	ID3D11Buffer* mBillboardVB;
+	UINT mBillboardCapacity;
 
 	ID3D11ShaderResourceView* mTreeTexSRV;
+	std::vector<DirectX::XMFLOAT4> mTreeAtlasRects;
 
 	Material mTreeMat;
-	static const UINT mTreeCount = 100;
+
+	GForest mForest;
+	UINT mForestSeed;
+	bool bStressForest;
 };
 
 #endif // MYAPP_H
\ No newline at end of file
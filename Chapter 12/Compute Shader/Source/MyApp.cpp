@@ -6,6 +6,7 @@
 #include "GeometryGenerator.h"
 #include "MathHelper.h"
 #include "D3DCompiler.h"
+#include "GTextureCache.h"
 
 MyApp::MyApp(HINSTANCE Instance) :
 	D3DApp(Instance),
@@ -49,6 +50,9 @@ MyApp::~MyApp()
 	ReleaseCOM(mWireframeRS);
 	ReleaseCOM(mSamplerState);
 	ReleaseCOM(mBlendState);
+
+	// Drop the cache's references before the device goes away.
+	GTextureCache::Get().Clear();
 }
 
 bool MyApp::Init()
@@ -247,9 +251,8 @@ void MyApp::CreateComputeShader(ID3D11ComputeShader** shader, LPCWSTR filename,
 
 void MyApp::LoadTextureToSRV(ID3D11ShaderResourceView** SRV, LPCWSTR filename)
 {
-	ID3D11Resource* texResource = nullptr;
-	HR(DirectX::CreateDDSTextureFromFile(mDevice, filename, &texResource, SRV));
-	ReleaseCOM(texResource); // view saves reference
+	// Objects that use the same file share one texture.
+	HR(GTextureCache::Get().Acquire(mDevice, filename, SRV));
 }
 
 void MyApp::CreateConstantBuffer(ID3D11Buffer** buffer, UINT size)
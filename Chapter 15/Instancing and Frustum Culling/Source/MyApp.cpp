@@ -6,6 +6,7 @@
 #include "GeometryGenerator.h"
 #include "MathHelper.h"
 #include "D3DCompiler.h"
+#include "GTextureCache.h"
 
 MyApp::MyApp(HINSTANCE Instance) :
 	D3DApp(Instance),
@@ -42,6 +43,9 @@ MyApp::~MyApp()
 	ReleaseCOM(mVertexLayout);
 
 	delete mSkullObject;
+
+	// Drop the cache's references before the device goes away.
+	GTextureCache::Get().Clear();
 }
 
 bool MyApp::Init()
@@ -244,9 +248,8 @@ void MyApp::CreatePixelShader(ID3D11PixelShader** shader, LPCWSTR filename, LPCS
 
 void MyApp::LoadTextureToSRV(ID3D11ShaderResourceView** SRV, LPCWSTR filename)
 {
-	ID3D11Resource* texResource = nullptr;
-	HR(DirectX::CreateDDSTextureFromFile(mDevice, filename, &texResource, SRV));
-	ReleaseCOM(texResource); // view saves reference
+	// Objects that use the same file share one texture.
+	HR(GTextureCache::Get().Acquire(mDevice, filename, SRV));
 }
 
 void MyApp::CreateConstantBuffer(ID3D11Buffer** buffer, UINT size)
@@ -389,6 +392,8 @@ void MyApp::UpdateScene(float dt)
 	// Frustum Culling
 	if (bFrustumCulling)
 	{
+		GPROFILE_SCOPE("Frustum Culling");
+
 		mCamera.UpdateViewMatrix();
 		mVisibleObjectCount = 0;
 
@@ -428,6 +433,8 @@ void MyApp::UpdateScene(float dt)
 		}
 
 		mImmediateContext->Unmap(mInstancedBuffer, 0);
+
+		GPROFILE_COUNTER("Visible Instances", mVisibleObjectCount);
 	}
 }
 
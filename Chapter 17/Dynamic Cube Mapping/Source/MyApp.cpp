@@ -6,6 +6,18 @@
 #include "GeometryGenerator.h"
 #include "MathHelper.h"
 #include "D3DCompiler.h"
+#include "GTextureCache.h"
+
+namespace
+{
+	LPCWSTR CubeMapPolicyNames[] =
+	{
+		L"Every Face",
+		L"Culled",
+		L"Round Robin",
+		L"Changed Only"
+	};
+}
 
 MyApp::MyApp(HINSTANCE Instance) :
 	D3DApp(Instance),
@@ -22,7 +34,14 @@ MyApp::MyApp(HINSTANCE Instance) :
 	mBoxObject(0),
 	mSphereObject(0),
 	mDynamicCubeMapDSV(0), 
-	mDynamicCubeMapSRV(0)
+	mDynamicCubeMapSRV(0),
+	mCubeMapPolicy(CUBEMAP_CHANGED_ONLY),
+	mCubeMapFacesPerFrame(2),
+	mSkullCubeMapObject(0),
+	mFloorCubeMapObject(0),
+	mBoxCubeMapObject(0),
+	mCubeMapDraws(0),
+	mCubeMapFrames(0)
 {
 	mWindowTitle = L"Dynamic Cube Map Demo";
 }
@@ -56,6 +75,9 @@ MyApp::~MyApp()
 	delete mFloorObject;
 	delete mBoxObject;
 	delete mSphereObject;
+
+	// Drop the cache's references before the device goes away.
+	GTextureCache::Get().Clear();
 }
 
 bool MyApp::Init()
@@ -101,6 +123,15 @@ bool MyApp::Init()
 	// Initialize Object Placement and Properties
 	PositionObjects();
 
+	// Track what each cube map face sees, with the same frusta as the face cameras
+	mCubeMapScheduler.SetCenter(DirectX::XMFLOAT3(0.0f, 2.0f, 0.0f), 0.1f, 1000.0f);
+	mSkullLocalBounds = GetLocalBounds(mSkullObject);
+	mSkullCubeMapObject = mCubeMapScheduler.AddObject(GetWorldBounds(mSkullObject, mSkullLocalBounds));
+	mFloorCubeMapObject = mCubeMapScheduler.AddObject(GetWorldBounds(mFloorObject, GetLocalBounds(mFloorObject)));
+	mBoxCubeMapObject = mCubeMapScheduler.AddObject(GetWorldBounds(mBoxObject, GetLocalBounds(mBoxObject)));
+
+	SetCubeMapPolicy(mCubeMapPolicy);
+
 	// Compile Shaders
 	CreateVertexShader(&mVertexShader, L"Shaders/VertexShader.hlsl", "VS");
 	CreatePixelShader(&mPixelShader, L"Shaders/PixelShader.hlsl", "PS");
@@ -161,6 +192,25 @@ void MyApp::OnMouseMove(WPARAM btnState, int x, int y)
 	mLastMousePos.y = y;
 }
 
+void MyApp::OnKeyDown(WPARAM key, LPARAM info)
+{
+	// 1-4 pick the cube map policy; up and down change the faces drawn per frame.
+	if (key >= 0x31 && key <= 0x34)
+	{
+		SetCubeMapPolicy(static_cast<CubeMapPolicy>(key - 0x31));
+	}
+	else if (key == VK_UP && mCubeMapFacesPerFrame < GCubeMapScheduler::FaceCount)
+	{
+		++mCubeMapFacesPerFrame;
+		SetCubeMapPolicy(mCubeMapPolicy);
+	}
+	else if (key == VK_DOWN && mCubeMapFacesPerFrame > 1)
+	{
+		--mCubeMapFacesPerFrame;
+		SetCubeMapPolicy(mCubeMapPolicy);
+	}
+}
+
 void MyApp::CreateGeometryBuffers(GObject* obj, bool bDynamic)
 {
 	D3D11_BUFFER_DESC vbd;
@@ -271,9 +321,8 @@ void MyApp::CreatePixelShader(ID3D11PixelShader** shader, LPCWSTR filename, LPCS
 
 void MyApp::LoadTextureToSRV(ID3D11ShaderResourceView** SRV, LPCWSTR filename)
 {
-	ID3D11Resource* texResource = nullptr;
-	HR(DirectX::CreateDDSTextureFromFile(mDevice, filename, &texResource, SRV));
-	ReleaseCOM(texResource); // view saves reference
+	// Objects that use the same file share one texture.
+	HR(GTextureCache::Get().Acquire(mDevice, filename, SRV));
 }
 
 void MyApp::CreateConstantBuffer(ID3D11Buffer** buffer, UINT size)
@@ -344,6 +393,51 @@ void MyApp::BuildCubeFaceCamera(float x, float y, float z)
 	}
 }
 
+DirectX::BoundingBox MyApp::GetLocalBounds(GObject* object)
+{
+	DirectX::BoundingBox local;
+	DirectX::BoundingBox::CreateFromPoints(local, object->GetVertexCount(),
+		&static_cast<Vertex*>(object->GetVertices())->Pos, sizeof(Vertex));
+	return local;
+}
+
+DirectX::BoundingBox MyApp::GetWorldBounds(GObject* object, const DirectX::BoundingBox& localBounds)
+{
+	DirectX::BoundingBox world;
+	localBounds.Transform(world, DirectX::XMLoadFloat4x4(&object->GetWorldTransform()));
+	return world;
+}
+
+void MyApp::SetCubeMapPolicy(CubeMapPolicy policy)
+{
+	mCubeMapPolicy = policy;
+
+	bool bAmortized = policy == CUBEMAP_ROUND_ROBIN || policy == CUBEMAP_CHANGED_ONLY;
+
+	mCubeMapScheduler.SetCulling(policy != CUBEMAP_EVERY_FACE);
+	mCubeMapScheduler.SetFacesPerFrame(bAmortized ? mCubeMapFacesPerFrame : GCubeMapScheduler::FaceCount);
+	mCubeMapScheduler.SetSkipUnchanged(policy == CUBEMAP_CHANGED_ONLY);
+
+	mCubeMapDraws = 0;
+	mCubeMapFrames = 0;
+}
+
+void MyApp::UpdateCubeMapStats()
+{
+	++mCubeMapFrames;
+
+	// Report the average next to the frame stats.
+	std::wostringstream title;
+	title.precision(2);
+	title << std::fixed << L"Dynamic Cube Map Demo    " << CubeMapPolicyNames[mCubeMapPolicy];
+	if (mCubeMapPolicy == CUBEMAP_ROUND_ROBIN || mCubeMapPolicy == CUBEMAP_CHANGED_ONLY)
+	{
+		title << L" (" << mCubeMapFacesPerFrame << L" faces/frame)";
+	}
+	title << L"    Cube Map Draws/Frame: " << static_cast<float>(mCubeMapDraws) / mCubeMapFrames;
+	mWindowTitle = title.str();
+}
+
 void MyApp::BuildDynamicCubeMapViews()
 {
 	//
@@ -573,6 +667,9 @@ void MyApp::UpdateScene(float dt)
 	}
 
 	mSkullObject->Rotate(0.0f, 25.0f*mTimer.TotalTime(), 0.0f);
+
+	// The spinning skull dirties whichever cube map faces see it
+	mCubeMapScheduler.UpdateObject(mSkullCubeMapObject, GetWorldBounds(mSkullObject, mSkullLocalBounds));
 }
 
 void MyApp::DrawScene()
@@ -581,41 +678,55 @@ void MyApp::DrawScene()
 
 	ID3D11RenderTargetView* renderTargets[1];
 
-	// Generate the cube map.
+	// Redraw only the cube map faces scheduled for this frame; the rest keep what they hold.
+	UINT faces[GCubeMapScheduler::FaceCount];
+	UINT faceCount = mCubeMapScheduler.Schedule(faces);
+
 	mImmediateContext->RSSetViewports(1, &mCubeMapViewport);
-	for (int i = 0; i < 6; ++i)
+	for (UINT i = 0; i < faceCount; ++i)
 	{
+		UINT face = faces[i];
+
 		// Clear cube map face and depth buffer.
-		mImmediateContext->ClearRenderTargetView(mDynamicCubeMapRTV[i], reinterpret_cast<const float*>(&Colors::Silver));
+		mImmediateContext->ClearRenderTargetView(mDynamicCubeMapRTV[face], reinterpret_cast<const float*>(&Colors::Silver));
 		mImmediateContext->ClearDepthStencilView(mDynamicCubeMapDSV, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
 		// Bind cube map face as render target.
-		renderTargets[0] = mDynamicCubeMapRTV[i];
+		renderTargets[0] = mDynamicCubeMapRTV[face];
 		mImmediateContext->OMSetRenderTargets(1, renderTargets, mDynamicCubeMapDSV);
 
 		// Draw the scene with the exception of the center sphere to this cube map face.
-		DrawScene(mCubeMapCamera[i], false);
+		DrawScene(mCubeMapCamera[face], face);
 	}
 
+	UpdateCubeMapStats();
+
 	// Restore old viewport and render targets.
 	mImmediateContext->RSSetViewports(1, &mViewport);
 	renderTargets[0] = mRenderTargetView;
 	mImmediateContext->OMSetRenderTargets(1, renderTargets, mDepthStencilView);
 
 	// Have hardware generate lower mipmap levels of cube map.
-	mImmediateContext->GenerateMips(mDynamicCubeMapSRV);
+	if (faceCount > 0)
+	{
+		mImmediateContext->GenerateMips(mDynamicCubeMapSRV);
+	}
 
 	// Now draw the scene as normal, but with the center sphere.
 	mImmediateContext->ClearRenderTargetView(mRenderTargetView, reinterpret_cast<const float*>(&Colors::Silver));
 	mImmediateContext->ClearDepthStencilView(mDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
-	DrawScene(mCamera, true);
+	DrawScene(mCamera, -1);
 
 	HR(mSwapChain->Present(0, 0));
 }
 
-void MyApp::DrawScene(const GFirstPersonCamera& camera, bool drawCenterSphere)
+void MyApp::DrawScene(const GFirstPersonCamera& camera, int cubeFace)
 {
+	// A face of the cube map draws only what its frustum sees, and never the center sphere.
+	bool drawCenterSphere = cubeFace < 0;
+	UINT draws = 0;
+
 	mImmediateContext->IASetInputLayout(mVertexLayout);
 	mImmediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
@@ -655,7 +766,11 @@ void MyApp::DrawScene(const GFirstPersonCamera& camera, bool drawCenterSphere)
 	cbPSParams->bReflection = false;
 	mImmediateContext->Unmap(mConstBufferPSParams, 0);
 
-	DrawObject(mSkullObject, &camera);
+	if (cubeFace < 0 || mCubeMapScheduler.IsVisible(cubeFace, mSkullCubeMapObject))
+	{
+		DrawObject(mSkullObject, &camera);
+		++draws;
+	}
 
 	// Set PS Parameters
 	mImmediateContext->Map(mConstBufferPSParams, 0, D3D11_MAP_WRITE_DISCARD, 0, &cbPSParamsResource);
@@ -666,8 +781,17 @@ void MyApp::DrawScene(const GFirstPersonCamera& camera, bool drawCenterSphere)
 	cbPSParams->bReflection = false;
 	mImmediateContext->Unmap(mConstBufferPSParams, 0);
 
-	DrawObject(mFloorObject, &camera);
-	DrawObject(mBoxObject, &camera);
+	if (cubeFace < 0 || mCubeMapScheduler.IsVisible(cubeFace, mFloorCubeMapObject))
+	{
+		DrawObject(mFloorObject, &camera);
+		++draws;
+	}
+
+	if (cubeFace < 0 || mCubeMapScheduler.IsVisible(cubeFace, mBoxCubeMapObject))
+	{
+		DrawObject(mBoxObject, &camera);
+		++draws;
+	}
 
 	if (drawCenterSphere)
 	{
@@ -683,6 +807,7 @@ void MyApp::DrawScene(const GFirstPersonCamera& camera, bool drawCenterSphere)
 		mImmediateContext->PSSetShaderResources(1, 1, &mDynamicCubeMapSRV);
 
 		DrawObject(mSphereObject, &camera);
+		++draws;
 
 		ID3D11ShaderResourceView* nullSRVs[1] = { NULL };
 		mImmediateContext->PSSetShaderResources(1, 1, nullSRVs);
@@ -697,4 +822,10 @@ void MyApp::DrawScene(const GFirstPersonCamera& camera, bool drawCenterSphere)
 
 	mSkyObject->SetEyePos(camera.GetPosition().x, camera.GetPosition().y, camera.GetPosition().z);
 	DrawObject(mSkyObject, &camera);
+	++draws;
+
+	if (cubeFace >= 0)
+	{
+		mCubeMapDraws += draws;
+	}
 }
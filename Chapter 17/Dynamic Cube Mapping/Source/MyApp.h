@@ -14,6 +14,7 @@
 #include "GSphere.h"
 #include "GPlaneXZ.h"
 #include "GSky.h"
+#include "GCubeMapScheduler.h"
 	
 struct ConstBufferPerObject
 {
@@ -41,6 +42,15 @@ struct ConstBufferPSParams
 	UINT bReflection;
 };
 
+// How the cube map faces are kept up to date; the number keys switch between them.
+enum CubeMapPolicy
+{
+	CUBEMAP_EVERY_FACE,
+	CUBEMAP_CULLED,
+	CUBEMAP_ROUND_ROBIN,
+	CUBEMAP_CHANGED_ONLY
+};
+
 class MyApp : public D3DApp
 {
 public:
@@ -56,6 +66,7 @@ public:
 	void OnMouseDown(WPARAM btnState, int x, int y);
 	void OnMouseUp(WPARAM btnState, int x, int y);
 	void OnMouseMove(WPARAM btnState, int x, int y);
+	void OnKeyDown(WPARAM key, LPARAM info);
 
 private:
 	void CreateGeometryBuffers(GObject* obj, bool dynamic = false);
@@ -75,10 +86,15 @@ private:
 	void DrawShadow(GObject* object, const GFirstPersonCamera* camera, DirectX::XMMATRIX& transform);
 	void Draw(GObject* object, const GFirstPersonCamera* camera, DirectX::XMMATRIX& world, bool bShadow);
 
-	void DrawScene(const GFirstPersonCamera& camera, bool drawSkull);
+	void DrawScene(const GFirstPersonCamera& camera, int cubeFace);
 	void BuildCubeFaceCamera(float x, float y, float z);
 	void BuildDynamicCubeMapViews();
 
+	DirectX::BoundingBox GetLocalBounds(GObject* object);
+	DirectX::BoundingBox GetWorldBounds(GObject* object, const DirectX::BoundingBox& localBounds);
+	void SetCubeMapPolicy(CubeMapPolicy policy);
+	void UpdateCubeMapStats();
+
 private:
 	// Constant Buffers
 	ID3D11Buffer* mConstBufferPerFrame;
@@ -127,6 +143,21 @@ private:
 
 	GFirstPersonCamera mCubeMapCamera[6];
 
+	// Which faces to redraw each frame, and what each one sees.
+	GCubeMapScheduler mCubeMapScheduler;
+	CubeMapPolicy mCubeMapPolicy;
+	UINT mCubeMapFacesPerFrame;
+	UINT mSkullCubeMapObject;
+	UINT mFloorCubeMapObject;
+	UINT mBoxCubeMapObject;
+
+	// The skull spins every frame; its model-space bounds are found once and transformed.
+	DirectX::BoundingBox mSkullLocalBounds;
+
+	// Draws into the cube map since the policy last changed.
+	UINT mCubeMapDraws;
+	UINT mCubeMapFrames;
+
 	static const int CubeMapSize = 256;
 };
 
@@ -3,6 +3,21 @@
 
 #include "LightHelper.hlsl"
 
+cbuffer cbPerFrame : register(b0)
+{
+    DirectionalLight gDirLights[3];
+    float3 gEyePosW;
+    float gMinDist;
+    float gMaxDist;
+    float gMinTess;
+    float gMaxTess;
+    float gTexelCellSpaceU;
+    float gTexelCellSpaceV;
+    float gWorldCellSpace;
+    float gHeightMin;
+    float gHeightRange;
+};
+
 cbuffer cbPerObject : register(b1)
 {
     float4x4 gViewProj;
@@ -39,6 +54,12 @@ SamplerState samHeightmap
     AddressV = CLAMP;
 };
 
+// The heightmap is R16_UNORM over the terrain's height range.
+float SampleHeight(float2 tex)
+{
+    return gHeightMin + gHeightRange * gHeightMap.SampleLevel(samHeightmap, tex, 0).r;
+}
+
 
 // The domain shader is called for every vertex created by the tessellator.  
 // It is like the vertex shader after tessellation.
@@ -64,7 +85,7 @@ DomainOut DS(PatchTess patchTess,
     dout.TiledTex = dout.Tex * 50.0f;
 	
 	// Displacement mapping
-    dout.PosW.y = gHeightMap.SampleLevel(samHeightmap, dout.Tex, 0).r;
+    dout.PosW.y = SampleHeight(dout.Tex);
 
 	// Project to homogeneous clip space.
     dout.PosH = mul(float4(dout.PosW, 1.0f), gViewProj);
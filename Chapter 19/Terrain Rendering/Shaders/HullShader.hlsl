@@ -14,6 +14,9 @@ cbuffer cbPerFrame : register(b0)
     float gTexelCellSpaceU;
     float gTexelCellSpaceV;
     float gWorldCellSpace;
+    float gHeightMin;
+    float gHeightRange;
+    float4 gWorldFrustumPlanes[6];
 };
 
 struct VertexOut
@@ -47,11 +50,68 @@ float CalcTessFactor(float3 p)
     return pow(2, (round(lerp(gMaxTess, gMinTess, s))));
 }
 
+// Returns true if the box is completely behind (in the negative half space of) the plane.
+bool AabbBehindPlaneTest(float3 center, float3 extents, float4 plane)
+{
+    float3 n = abs(plane.xyz);
+
+	// This is always positive.
+    float r = dot(extents, n);
+
+	// Signed distance from center point to plane.
+    float s = dot(float4(center, 1.0f), plane);
+
+	// If the center point of the box is a distance of e or more behind the
+	// plane (in which case s is negative since it is behind the plane),
+	// then the box is completely in the negative half space of the plane.
+    return (s + r) < 0.0f;
+}
+
+// Returns true if the box is completely outside the frustum.
+bool AabbOutsideFrustumTest(float3 center, float3 extents, float4 frustumPlanes[6])
+{
+    for (int i = 0; i < 6; ++i)
+    {
+		// If the box is completely behind any of the frustum planes
+		// then it is outside the frustum.
+        if (AabbBehindPlaneTest(center, extents, frustumPlanes[i]))
+        {
+            return true;
+        }
+    }
+	
+    return false;
+}
+
 PatchTess ConstantHS(InputPatch<VertexOut, 4> patch, uint patchID : SV_PrimitiveID)
 {
 	PatchTess pt;
 
-	// TODO: Add Frustum Culling
+	// Frustum cull.  The y-bounds of the patch are stored in the first control point.
+    float minY = patch[0].BoundsY.x;
+    float maxY = patch[0].BoundsY.y;
+
+	// Build axis-aligned bounding box.  patch[2] is lower-left corner
+	// and patch[1] is upper-right corner.
+    float3 vMin = float3(patch[2].PosW.x, minY, patch[2].PosW.z);
+    float3 vMax = float3(patch[1].PosW.x, maxY, patch[1].PosW.z);
+
+    float3 boxCenter = 0.5f * (vMin + vMax);
+    float3 boxExtents = 0.5f * (vMax - vMin);
+
+    if (AabbOutsideFrustumTest(boxCenter, boxExtents, gWorldFrustumPlanes))
+    {
+		// A tessellation factor of zero discards the patch.
+        pt.EdgeTess[0] = 0.0f;
+        pt.EdgeTess[1] = 0.0f;
+        pt.EdgeTess[2] = 0.0f;
+        pt.EdgeTess[3] = 0.0f;
+
+        pt.InsideTess[0] = 0.0f;
+        pt.InsideTess[1] = 0.0f;
+
+        return pt;
+    }
 
 	// It is important to do the tess factor calculation based on the
 	// edge properties so that edges shared by more than one patch will
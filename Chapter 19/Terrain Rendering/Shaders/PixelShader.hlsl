@@ -23,6 +23,8 @@ cbuffer cbPerFrame : register(b0)
     float gTexelCellSpaceU;
     float gTexelCellSpaceV;
     float gWorldCellSpace;
+    float gHeightMin;
+    float gHeightRange;
 };
 
 cbuffer cbPerObject : register(b1)
@@ -51,6 +53,12 @@ SamplerState samHeightmap : register(s0)
     AddressV = CLAMP;
 };
 
+// The heightmap is R16_UNORM over the terrain's height range.
+float SampleHeight(float2 tex)
+{
+    return gHeightMin + gHeightRange * gHeightMap.SampleLevel(samHeightmap, tex, 0).r;
+}
+
 SamplerState samLinear : register(s1)
 {
     Filter = MIN_MAG_MIP_LINEAR;
@@ -72,10 +80,10 @@ float4 PS(DomainOut pin) : SV_Target
     float2 bottomTex = pin.Tex + float2(0.0f, gTexelCellSpaceV);
     float2 topTex = pin.Tex + float2(0.0f, -gTexelCellSpaceV);
 	
-    float leftY = gHeightMap.SampleLevel(samHeightmap, leftTex, 0).r;
-    float rightY = gHeightMap.SampleLevel(samHeightmap, rightTex, 0).r;
-    float bottomY = gHeightMap.SampleLevel(samHeightmap, bottomTex, 0).r;
-    float topY = gHeightMap.SampleLevel(samHeightmap, topTex, 0).r;
+    float leftY = SampleHeight(leftTex);
+    float rightY = SampleHeight(rightTex);
+    float bottomY = SampleHeight(bottomTex);
+    float topY = SampleHeight(topTex);
 	
     float3 tangent = normalize(float3(2.0f * gWorldCellSpace, rightY - leftY, 0.0f));
     float3 bitan = normalize(float3(0.0f, bottomY - topY, -2.0f * gWorldCellSpace));
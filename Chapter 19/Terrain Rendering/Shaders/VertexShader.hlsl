@@ -1,6 +1,23 @@
 //***************************************************************************************
 //***************************************************************************************
 
+#include "LightHelper.hlsl"
+
+cbuffer cbPerFrame : register(b0)
+{
+    DirectionalLight gDirLights[3];
+    float3 gEyePosW;
+    float gMinDist;
+    float gMaxDist;
+    float gMinTess;
+    float gMaxTess;
+    float gTexelCellSpaceU;
+    float gTexelCellSpaceV;
+    float gWorldCellSpace;
+    float gHeightMin;
+    float gHeightRange;
+};
+
 struct VertexIn
 {
 	float3 PosL    : POSITION;
@@ -25,6 +42,12 @@ SamplerState samHeightmap
     AddressV = CLAMP;
 };
 
+// The heightmap is R16_UNORM over the terrain's height range.
+float SampleHeight(float2 tex)
+{
+    return gHeightMin + gHeightRange * gHeightMap.SampleLevel(samHeightmap, tex, 0).r;
+}
+
 VertexOut VS(VertexIn vin)
 {
     VertexOut vout;
@@ -34,7 +57,7 @@ VertexOut VS(VertexIn vin)
 
 	// Displace the patch corners to world space.  This is to make 
 	// the eye to patch distance calculation more accurate.
-    vout.PosW.y = gHeightMap.SampleLevel(samHeightmap, vin.Tex, 0).r;
+    vout.PosW.y = SampleHeight(vin.Tex);
 
 	// Output vertex attributes to next stage.
     vout.Tex = vin.Tex;
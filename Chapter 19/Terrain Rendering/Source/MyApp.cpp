@@ -6,6 +6,24 @@
 #include "GeometryGenerator.h"
 #include "MathHelper.h"
 #include "D3DCompiler.h"
+#include "GTextureCache.h"
+#include "GHeightmapCodec.h"
+#include "GMipGenerator.h"
+
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+	// Height texture sample under patch edge `edge` of `patches` along an axis of `cells` cells.
+	// The texture holds cells + 1 samples, so uv 0 and 1 land half a texel outside the first
+	// and last sample centers, where clamp addressing repeats the edge.
+	double PatchEdgeToSample(UINT edge, UINT patches, UINT cells)
+	{
+		double sample = static_cast<double>(edge) / patches * (cells + 1) - 0.5;
+		return (std::min)((std::max)(sample, 0.0), static_cast<double>(cells));
+	}
+}
 
 MyApp::MyApp(HINSTANCE Instance) :
 	D3DApp(Instance),
@@ -17,7 +35,10 @@ MyApp::MyApp(HINSTANCE Instance) :
 	mPixelShader(0),
 	mVertexLayout(0),
 	mTerrainVB(0),
-	mTerrainIB(0)
+	mTerrainIB(0),
+	mHeightMin(0.0f),
+	mHeightRange(0.0f),
+	mNumVisiblePatches(0)
 {
 	mWindowTitle = L"Tess Hills Demo";
 }
@@ -39,6 +60,9 @@ MyApp::~MyApp()
 	ReleaseCOM(mPixelShader);
 
 	ReleaseCOM(mVertexLayout);
+
+	// Drop the cache's references before the device goes away.
+	GTextureCache::Get().Clear();
 }
 
 bool MyApp::Init()
@@ -77,8 +101,6 @@ bool MyApp::Init()
 	CreateConstantBuffer(&mConstBufferPerObject, sizeof(ConstBufferPerObject));
 	CreateConstantBuffer(&mConstBufferWVP, sizeof(ConstBufferWVP));
 
-	mNumCellsWide = 2048;
-	mNumCellsDeep = 2048;
 	mCellWidth = 0.5; // meters
 	mCellDepth = 0.5; // meters
 
@@ -87,13 +109,24 @@ bool MyApp::Init()
 
 	mNumPatches = 32 * 32;
 
+	// The heightmap decides the cell count; the bundled map is 2049 x 2049 samples.
+	if (!LoadHeightmap(L"Textures/terrain.raw")) { return false; }
+
 	mTerrainWidth = mNumCellsWide * mCellWidth; // 1024 meters
 	mTerrainDepth = mNumCellsDeep * mCellDepth; // 1024 meters
 
-	LoadHeightmap(L"Textures/terrain.raw");
+	mTerrainQuery.Init(&mHeightmap[0], mNumCellsWide + 1, mNumCellsDeep + 1, mCellWidth);
+
 	LoadTextureToSRV(&mBlendMapSRV, L"Textures/blend.dds");
 	BuildHeightmapSRV();
+
+	// Layer map load time is kept as a profiler counter, so it shows in every profiler report
+	// alongside the frame zones, for comparing asset layouts.
+	auto layerStart = std::chrono::steady_clock::now();
 	BuildLayerMapSRV();
+	std::chrono::duration<double, std::milli> layerTime = std::chrono::steady_clock::now() - layerStart;
+	GPROFILE_COUNTER("Layer Map Load (ms)", layerTime.count());
+
 	BuildTerrainBuffers();
 	SetupStaticLights();
 
@@ -265,9 +298,8 @@ void MyApp::CreatePixelShader(ID3D11PixelShader** shader, LPCWSTR filename, LPCS
 
 void MyApp::LoadTextureToSRV(ID3D11ShaderResourceView** SRV, LPCWSTR filename)
 {
-	ID3D11Resource* texResource = nullptr;
-	HR(DirectX::CreateDDSTextureFromFile(mDevice, filename, &texResource, SRV));
-	ReleaseCOM(texResource); // view saves reference
+	// Objects that use the same file share one texture.
+	HR(GTextureCache::Get().Acquire(mDevice, filename, SRV));
 }
 
 void MyApp::CreateConstantBuffer(ID3D11Buffer** buffer, UINT size)
@@ -331,6 +363,14 @@ void MyApp::UpdateScene(float dt)
 	{
 		mCamera.Strafe(10.0f*dt);
 	}
+
+	// Keep the camera above the ground.
+	DirectX::XMFLOAT3 eyePos = mCamera.GetPosition();
+	float groundHeight = mTerrainQuery.GetHeight(eyePos.x, eyePos.z);
+	if (eyePos.y < groundHeight + 2.0f)
+	{
+		mCamera.SetPosition(eyePos.x, groundHeight + 2.0f, eyePos.z);
+	}
 }
 
 void MyApp::DrawScene()
@@ -341,6 +381,8 @@ void MyApp::DrawScene()
 	// Update Camera
 	mCamera.UpdateViewMatrix();
 
+	CullPatches();
+
 	float blendFactor[] = { 0.0f, 0.0f, 0.0f, 0.0f };
 
 	mImmediateContext->IASetInputLayout(mVertexLayout);
@@ -357,15 +399,24 @@ void MyApp::DrawScene()
 	cbPerFrame->maxDist = 500.0f;
 	cbPerFrame->minTess = 0.0f;
 	cbPerFrame->maxTess = 6.0f;
-	cbPerFrame->texelCellSpaceU = 1.0f / 2049;
-	cbPerFrame->texelCellSpaceV = 1.0f / 2049;
-	cbPerFrame->worldCellSpace = 0.5f;
+	cbPerFrame->texelCellSpaceU = 1.0f / (mNumCellsWide + 1);
+	cbPerFrame->texelCellSpaceV = 1.0f / (mNumCellsDeep + 1);
+	cbPerFrame->worldCellSpace = mCellWidth;
+	cbPerFrame->heightMin = mHeightMin;
+	cbPerFrame->heightRange = mHeightRange;
+	for (UINT i = 0; i < 6; ++i)
+	{
+		cbPerFrame->worldFrustumPlanes[i] = mFrustumPlanes[i];
+	}
 	mImmediateContext->Unmap(mConstBufferPerFrame, 0);
 
 	// Bind Constant Buffers to the Pipeline
+	mImmediateContext->VSSetConstantBuffers(0, 1, &mConstBufferPerFrame);
+
 	mImmediateContext->HSSetConstantBuffers(0, 1, &mConstBufferPerFrame);
 	mImmediateContext->HSSetConstantBuffers(1, 1, &mConstBufferPerObject);
 
+	mImmediateContext->DSSetConstantBuffers(0, 1, &mConstBufferPerFrame);
 	mImmediateContext->DSSetConstantBuffers(1, 1, &mConstBufferPerObject);
 
 	mImmediateContext->PSSetConstantBuffers(0, 1, &mConstBufferPerFrame);
@@ -409,7 +460,11 @@ void MyApp::DrawScene()
 	mImmediateContext->IASetVertexBuffers(0, 1, &mTerrainVB, &stride, &offset);
 	mImmediateContext->IASetIndexBuffer(mTerrainIB, DXGI_FORMAT_R16_UINT, 0);
 
-	mImmediateContext->DrawIndexed(mNumPatches * 4, 0, 0);
+	// Only submit the patches that survived culling; each run is one contiguous index range.
+	for (size_t i = 0; i < mVisiblePatchRuns.size(); ++i)
+	{
+		mImmediateContext->DrawIndexed(mVisiblePatchRuns[i].second * 4, mVisiblePatchRuns[i].first * 4, 0);
+	}
 
 	// Draw Sky
 	mImmediateContext->IASetInputLayout(mSkyVertexLayout);
@@ -462,6 +517,8 @@ void MyApp::BuildTerrainBuffers()
 		Required verts for quads = 33 x 33
 	*/
 
+	BuildPatchBounds();
+
 	std::vector<TerrainVertex> verts(mNumPatchVertRows*mNumPatchVertCols);
 
 	float halfWidth = 0.5f*mTerrainWidth; // 512 meters
@@ -490,14 +547,14 @@ void MyApp::BuildTerrainBuffers()
 	}
 
 	// Store axis-aligned bounding box y-bounds in upper-left patch corner.
-//	for (UINT i = 0; i < mNumPatchVertRows - 1; ++i)
-//	{
-//		for (UINT j = 0; j < mNumPatchVertCols - 1; ++j)
-//		{
-//			UINT patchID = i*(mNumPatchVertCols - 1) + j;
-//			verts[i*mNumPatchVertCols + j].BoundsY = mPatchBoundsY[patchID];
-//		}
-//	}
+	for (UINT i = 0; i < mNumPatchVertRows - 1; ++i)
+	{
+		for (UINT j = 0; j < mNumPatchVertCols - 1; ++j)
+		{
+			UINT patchID = i*(mNumPatchVertCols - 1) + j;
+			verts[i*mNumPatchVertCols + j].BoundsY = mPatchBoundsY[patchID];
+		}
+	}
 
 	D3D11_BUFFER_DESC vbd;
 	vbd.Usage = D3D11_USAGE_IMMUTABLE;
@@ -546,41 +603,185 @@ void MyApp::BuildTerrainBuffers()
 	HR(mDevice->CreateBuffer(&ibd, &iinitData, &mTerrainIB));
 }
 
-void MyApp::LoadHeightmap(LPCWSTR filename)
+void MyApp::BuildPatchBounds()
 {
-	// A height for each vertex
-	std::vector<unsigned char> in(2049 * 2049);
+	mTerrainBounds.Build(&mHeightmap[0], mNumCellsWide + 1, mNumCellsDeep + 1);
+
+	UINT numPatchRows = mNumPatchVertRows - 1;
+	UINT numPatchCols = mNumPatchVertCols - 1;
 
-	// Open the file.
-	std::ifstream inFile;
-	inFile.open(filename, std::ios_base::binary);
+	// Patch j spans u = [j, j + 1] / numPatchCols and the domain shader samples the height
+	// texture across it, so round that span out to whole cells: the bounds then cover every
+	// sample the patch can touch, however the cells divide into patches.
+	mPatchBoundsY.resize(numPatchRows*numPatchCols);
 
-	if (inFile)
+	for (UINT i = 0; i < numPatchRows; ++i)
 	{
-		// Read the RAW bytes.
-		inFile.read((char*)&in[0], (std::streamsize)in.size());
+		UINT z0 = static_cast<UINT>(floor(PatchEdgeToSample(i, numPatchRows, mNumCellsDeep)));
+		UINT z1 = static_cast<UINT>(ceil(PatchEdgeToSample(i + 1, numPatchRows, mNumCellsDeep)));
+
+		for (UINT j = 0; j < numPatchCols; ++j)
+		{
+			UINT x0 = static_cast<UINT>(floor(PatchEdgeToSample(j, numPatchCols, mNumCellsWide)));
+			UINT x1 = static_cast<UINT>(ceil(PatchEdgeToSample(j + 1, numPatchCols, mNumCellsWide)));
 
-		// Done with file.
-		inFile.close();
+			// A span inside one cell still needs that cell.
+			mPatchBoundsY[i*numPatchCols + j] = mTerrainBounds.GetBounds(
+				x0, z0, (std::max)(x1, x0 + 1), (std::max)(z1, z0 + 1));
+		}
 	}
+}
+
+void MyApp::CullPatches()
+{
+	// The terrain is specified directly in world space, so ViewProj gives world space planes.
+	MathHelper::ExtractFrustumPlanes(mFrustumPlanes, mCamera.ViewProj());
+
+	UINT numPatchRows = mNumPatchVertRows - 1;
+	UINT numPatchCols = mNumPatchVertCols - 1;
 
-	// Copy the array data into a float array and scale it.
-	mHeightmap.resize(2049 * 2049, 0);
-	float mHeightScale = 50.0f;
-	for (UINT i = 0; i < 2049 * 2049; ++i)
+	float halfWidth = 0.5f*mTerrainWidth;
+	float halfDepth = 0.5f*mTerrainDepth;
+	float patchWidth = static_cast<float>(mTerrainWidth) / numPatchCols;
+	float patchDepth = static_cast<float>(mTerrainDepth) / numPatchRows;
+
+	UINT prevVisiblePatches = mNumVisiblePatches;
+
+	mVisiblePatchRuns.clear();
+	mNumVisiblePatches = 0;
+
+	for (UINT i = 0; i < numPatchRows; ++i)
 	{
-		mHeightmap[i] = (in[i] / 255.0f)*mHeightScale;
+		for (UINT j = 0; j < numPatchCols; ++j)
+		{
+			UINT patchID = i*numPatchCols + j;
+			const DirectX::XMFLOAT2& boundsY = mPatchBoundsY[patchID];
+
+			DirectX::XMFLOAT3 center(-halfWidth + (j + 0.5f)*patchWidth, 0.5f*(boundsY.x + boundsY.y), halfDepth - (i + 0.5f)*patchDepth);
+			DirectX::XMFLOAT3 extents(0.5f*patchWidth, 0.5f*(boundsY.y - boundsY.x), 0.5f*patchDepth);
+
+			// The box is outside if it lies entirely behind any one plane.
+			bool bVisible = true;
+			for (UINT p = 0; p < 6 && bVisible; ++p)
+			{
+				const DirectX::XMFLOAT4& plane = mFrustumPlanes[p];
+
+				float r = fabsf(plane.x)*extents.x + fabsf(plane.y)*extents.y + fabsf(plane.z)*extents.z;
+				float s = plane.x*center.x + plane.y*center.y + plane.z*center.z + plane.w;
+
+				bVisible = (s + r >= 0.0f);
+			}
+
+			if (!bVisible)
+			{
+				continue;
+			}
+
+			// Extend the current run if this patch follows it in the index buffer.
+			if (!mVisiblePatchRuns.empty() && mVisiblePatchRuns.back().first + mVisiblePatchRuns.back().second == patchID)
+			{
+				++mVisiblePatchRuns.back().second;
+			}
+			else
+			{
+				mVisiblePatchRuns.push_back(std::make_pair(patchID, 1u));
+			}
+
+			++mNumVisiblePatches;
+		}
+	}
+
+	// Report the share of patches drawn next to the frame stats.
+	if (mNumVisiblePatches != prevVisiblePatches)
+	{
+		std::wostringstream title;
+		title << L"Tess Hills Demo    Visible Patches: " << (100 * mNumVisiblePatches) / mNumPatches << L"%";
+		mWindowTitle = title.str();
 	}
 }
 
+bool MyApp::LoadHeightmap(LPCWSTR filename)
+{
+	// Square RAW; the size comes from the file length.  .r16 holds 16-bit samples and .r32
+	// holds float heights in meters; anything else is 8-bit.
+	GHeightmapStream::Format format = GHeightmapStream::FORMAT_R8;
+	float heightScale = 50.0f;
+
+	LPCWSTR ext = wcsrchr(filename, L'.');
+	if (ext && _wcsicmp(ext, L".r16") == 0)
+	{
+		format = GHeightmapStream::FORMAT_R16;
+	}
+	else if (ext && _wcsicmp(ext, L".r32") == 0)
+	{
+		format = GHeightmapStream::FORMAT_R32F;
+		heightScale = 1.0f;
+	}
+
+	if (!mHeightmapStream.Open(filename, format, heightScale))
+	{
+		MessageBox(0, L"Heightmap missing or not square.", 0, 0);
+		return false;
+	}
+
+	// The GPU samples the whole map from one texture, so it cannot be larger than D3D11 allows.
+	if (mHeightmapStream.GetWidth() > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION ||
+		mHeightmapStream.GetDepth() > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+	{
+		wchar_t message[128];
+		swprintf(message, sizeof(message) / sizeof(message[0]), L"Heightmap is %u x %u samples; the height texture holds at most %u x %u.",
+			mHeightmapStream.GetWidth(), mHeightmapStream.GetDepth(),
+			D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION, D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION);
+		MessageBox(0, message, 0, 0);
+
+		mHeightmapStream.Close();
+		return false;
+	}
+
+	mNumCellsWide = mHeightmapStream.GetWidth() - 1;
+	mNumCellsDeep = mHeightmapStream.GetDepth() - 1;
+
+	// Tile streaming is not wired into this demo: the height texture, the patch bounds and the
+	// camera's ground queries all read one full copy of the map, so it is converted straight
+	// from the mapped file once and the stream's tile cache is never used.
+	UINT width = mHeightmapStream.GetWidth();
+	UINT depth = mHeightmapStream.GetDepth();
+
+	mHeightmap.resize(width * depth, 0);
+	mHeightmapStream.ReadRegion(0, 0, width, depth, &mHeightmap[0], width);
+	mHeightmapStream.Close();
+
+	return true;
+}
+
 void MyApp::BuildHeightmapSRV()
 {
+	// Give the heightmap a real chain so the view's lower mips hold averaged heights.
+	std::vector<GMipGenerator::Level> levels;
+	GMipGenerator::GenerateChain(GMipGenerator::FORMAT_R32_FLOAT, GMipGenerator::FILTER_BOX, &mHeightmap[0],
+		mNumCellsWide + 1, mNumCellsDeep + 1, (mNumCellsWide + 1)*sizeof(float), levels);
+
+	// Quantize every level over the whole map's range and upload half the bytes; the shaders
+	// rebuild heights from the range in cbPerFrame.  Averages never leave [min, max].
+	float maxHeight;
+	GHeightmapCodec::FindRange(&mHeightmap[0], mHeightmap.size(), mHeightMin, maxHeight);
+	float step = GHeightmapCodec::GetStep(mHeightMin, maxHeight);
+	mHeightRange = step * GHeightmapCodec::MaxCode;
+
+	std::vector<std::vector<uint16_t>> codes(levels.size());
+	for (UINT mip = 0; mip < levels.size(); ++mip)
+	{
+		size_t count = static_cast<size_t>(levels[mip].Width) * levels[mip].Height;
+		codes[mip].resize(count);
+		GHeightmapCodec::Encode(reinterpret_cast<const float*>(levels[mip].Data.data()), count, mHeightMin, step, codes[mip].data());
+	}
+
 	D3D11_TEXTURE2D_DESC texDesc;
-	texDesc.Width = 2049;
-	texDesc.Height = 2049;
-	texDesc.MipLevels = 1;
+	texDesc.Width = mNumCellsWide + 1;
+	texDesc.Height = mNumCellsDeep + 1;
+	texDesc.MipLevels = static_cast<UINT>(levels.size());
 	texDesc.ArraySize = 1;
-	texDesc.Format = DXGI_FORMAT_R32_FLOAT;
+	texDesc.Format = DXGI_FORMAT_R16_UNORM;
 	texDesc.SampleDesc.Count = 1;
 	texDesc.SampleDesc.Quality = 0;
 	texDesc.Usage = D3D11_USAGE_DEFAULT;
@@ -588,13 +789,16 @@ void MyApp::BuildHeightmapSRV()
 	texDesc.CPUAccessFlags = 0;
 	texDesc.MiscFlags = 0;
 
-	D3D11_SUBRESOURCE_DATA data;
-	data.pSysMem = &mHeightmap[0];
-	data.SysMemPitch = 2049*sizeof(float);
-	data.SysMemSlicePitch = 0;
+	std::vector<D3D11_SUBRESOURCE_DATA> data(levels.size());
+	for (UINT mip = 0; mip < levels.size(); ++mip)
+	{
+		data[mip].pSysMem = codes[mip].data();
+		data[mip].SysMemPitch = levels[mip].Width * sizeof(uint16_t);
+		data[mip].SysMemSlicePitch = 0;
+	}
 
 	ID3D11Texture2D* hmapTex = 0;
-	HR(mDevice->CreateTexture2D(&texDesc, &data, &hmapTex));
+	HR(mDevice->CreateTexture2D(&texDesc, &data[0], &hmapTex));
 
 	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
 	srvDesc.Format = texDesc.Format;
@@ -609,62 +813,12 @@ void MyApp::BuildHeightmapSRV()
 
 void MyApp::BuildLayerMapSRV()
 {
-	std::vector<ID3D11Resource*> texResources;
-	texResources.resize(5);
-
-	HR(DirectX::CreateDDSTextureFromFileEx(mDevice, L"Textures/grass.dds", 0, D3D11_USAGE_STAGING, 0, D3D11_CPU_ACCESS_WRITE | D3D11_CPU_ACCESS_READ, 0, false, &texResources[0], nullptr));
-	HR(DirectX::CreateDDSTextureFromFileEx(mDevice, L"Textures/darkdirt.dds", 0, D3D11_USAGE_STAGING, 0, D3D11_CPU_ACCESS_WRITE | D3D11_CPU_ACCESS_READ, 0, false, &texResources[1], nullptr));
-	HR(DirectX::CreateDDSTextureFromFileEx(mDevice, L"Textures/stone.dds", 0, D3D11_USAGE_STAGING, 0, D3D11_CPU_ACCESS_WRITE | D3D11_CPU_ACCESS_READ, 0, false, &texResources[2], nullptr));
-	HR(DirectX::CreateDDSTextureFromFileEx(mDevice, L"Textures/lightdirt.dds", 0, D3D11_USAGE_STAGING, 0, D3D11_CPU_ACCESS_WRITE | D3D11_CPU_ACCESS_READ, 0, false, &texResources[3], nullptr));
-	HR(DirectX::CreateDDSTextureFromFileEx(mDevice, L"Textures/snow.dds", 0, D3D11_USAGE_STAGING, 0, D3D11_CPU_ACCESS_WRITE | D3D11_CPU_ACCESS_READ, 0, false, &texResources[4], nullptr));
-
-	D3D11_TEXTURE2D_DESC texArrayDesc;
-	texArrayDesc.Width = 512;
-	texArrayDesc.Height = 512;
-	texArrayDesc.MipLevels = 10;
-	texArrayDesc.ArraySize = 5;
-	texArrayDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
-	texArrayDesc.SampleDesc.Count = 1;
-	texArrayDesc.SampleDesc.Quality = 0;
-	texArrayDesc.Usage = D3D11_USAGE_DEFAULT;
-	texArrayDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-	texArrayDesc.CPUAccessFlags = 0;
-	texArrayDesc.MiscFlags = 0;
-
-	HR(mDevice->CreateTexture2D(&texArrayDesc, 0, &mTexArray));
-
-	// Copy individual texture elements into texture array.
-	for (UINT texElement = 0; texElement < 5; ++texElement)
-	{
-		for (UINT mipLevel = 0; mipLevel < 10; ++mipLevel)
-		{
-			D3D11_MAPPED_SUBRESOURCE mappedTex2D;
-			HR(mImmediateContext->Map(texResources[texElement], mipLevel, D3D11_MAP_READ, 0, &mappedTex2D));
-
-			mImmediateContext->UpdateSubresource(mTexArray,
-				D3D11CalcSubresource(mipLevel, texElement, 10),
-				0, mappedTex2D.pData, mappedTex2D.RowPitch, mappedTex2D.DepthPitch);
-
-			mImmediateContext->Unmap(texResources[texElement], mipLevel);
-		}
-	}
-
-	// Create a resource view to the texture array.
-	D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc;
-	viewDesc.Format = texArrayDesc.Format;
-	viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
-	viewDesc.Texture2DArray.MostDetailedMip = 0;
-	viewDesc.Texture2DArray.MipLevels = texArrayDesc.MipLevels;
-	viewDesc.Texture2DArray.FirstArraySlice = 0;
-	viewDesc.Texture2DArray.ArraySize = 5;
-
-	HR(mDevice->CreateShaderResourceView(mTexArray, &viewDesc, &mLayerMapSRV));
-
-	// Cleanup--we only need the resource view.
-	ReleaseCOM(mTexArray);
-
-	for (UINT i = 0; i < 5; ++i)
-	{
-		ReleaseCOM(texResources[i]);
-	}
+	GPROFILE_FUNCTION();
+
+	// The five layers (grass, darkdirt, stone, lightdirt, snow) are packed offline into one
+	// array with their mips:
+	//   TextureTools pack Textures/terrainlayers.dds Textures/grass.dds Textures/darkdirt.dds
+	//     Textures/stone.dds Textures/lightdirt.dds Textures/snow.dds
+	// so the file is mapped and the array and its view are created in a single call.
+	HR(DirectX::CreateDDSTextureFromFile(mDevice, L"Textures/terrainlayers.dds", nullptr, &mLayerMapSRV));
 }
\ No newline at end of file
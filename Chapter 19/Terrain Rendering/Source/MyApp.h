@@ -11,6 +11,9 @@
 #include "GFirstPersonCamera.h"
 #include "GObject.h"
 #include "GSky.h"
+#include "GHeightmapStream.h"
+#include "GTerrainBounds.h"
+#include "GTerrainQuery.h"
 	
 struct ConstBufferPerObject
 {
@@ -29,7 +32,9 @@ struct ConstBufferPerFrame
 	float texelCellSpaceU;
 	float texelCellSpaceV;
 	float worldCellSpace;
-	DirectX::XMFLOAT2 pad;
+	float heightMin;
+	float heightRange;
+	DirectX::XMFLOAT4 worldFrustumPlanes[6];
 };
 
 struct ConstBufferWVP
@@ -73,10 +78,12 @@ private:
 
 	void DrawScene(const GFirstPersonCamera& camera, bool drawSkull);
 
-	void LoadHeightmap(LPCWSTR filename);
+	bool LoadHeightmap(LPCWSTR filename);
 	void BuildHeightmapSRV();
 	void BuildLayerMapSRV();
 	void BuildTerrainBuffers();
+	void BuildPatchBounds();
+	void CullPatches();
 
 private:
 	// Constant Buffers
@@ -136,13 +143,28 @@ private:
 
 	Material mTerrainMaterial;
 
+	GHeightmapStream mHeightmapStream;
 	std::vector<float> mHeightmap;
 	ID3D11ShaderResourceView* mHeightMapSRV;
 
+	// The heightmap texture is R16_UNORM; height = mHeightMin + mHeightRange * texel.
+	float mHeightMin;
+	float mHeightRange;
+
+	GTerrainQuery mTerrainQuery;
+
+	// Patch Culling
+	GTerrainBounds mTerrainBounds;
+	std::vector<DirectX::XMFLOAT2> mPatchBoundsY;
+
+	DirectX::XMFLOAT4 mFrustumPlanes[6];
+
+	// Runs of visible patches as (first patch, patch count), in index buffer order.
+	std::vector<std::pair<UINT, UINT>> mVisiblePatchRuns;
+	UINT mNumVisiblePatches;
+
 	ID3D11ShaderResourceView* mLayerMapSRV;
 	ID3D11ShaderResourceView* mBlendMapSRV;
-
-	ID3D11Texture2D* mTexArray;
 };
 
 #endif // MYAPP_H
\ No newline at end of file
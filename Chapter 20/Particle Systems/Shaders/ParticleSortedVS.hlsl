@@ -0,0 +1,37 @@
+//=============================================================================
+// Vertex shader for particles simulated on the CPU.  Positions arrive already
+// integrated and sorted back to front, so only the fade is computed here.
+//=============================================================================
+
+struct Particle
+{
+    float3 PosW   : POSITION;
+    float3 VelW   : VELOCITY;
+    float2 SizeW  : SIZE;
+    float Age     : AGE; // normalized to [0, 1] over the particle lifetime
+    uint Type     : TYPE;
+};
+
+struct VertexOut
+{
+    float3 PosW  : POSITION;
+    float2 SizeW : SIZE;
+    float4 Color : COLOR;
+    uint Type    : TYPE;
+};
+
+VertexOut VS(Particle vin)
+{
+    VertexOut vout;
+
+    vout.PosW = vin.PosW;
+
+	// fade in quickly, then fade out over the rest of the lifetime
+    float opacity = smoothstep(0.0f, 0.1f, vin.Age) * (1.0f - smoothstep(0.4f, 1.0f, vin.Age));
+    vout.Color = float4(0.6f, 0.6f, 0.6f, 0.5f * opacity);
+
+    vout.SizeW = vin.SizeW;
+    vout.Type = vin.Type;
+
+    return vout;
+}
\ No newline at end of file
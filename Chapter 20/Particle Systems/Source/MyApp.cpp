@@ -5,7 +5,8 @@
 #include "MyApp.h"
 #include "GeometryGenerator.h"
 #include "MathHelper.h"
-#include "D3DCompiler.h"
+#include "GPipelineBuilder.h"
+#include "GTextureCache.h"
 
 MyApp::MyApp(HINSTANCE Instance) :
 	D3DApp(Instance),
@@ -19,7 +20,9 @@ MyApp::MyApp(HINSTANCE Instance) :
 	mVertexLayout(0),
 	mSkullObject(0),
 	mFloorObject(0),
-	mBoxObject(0)
+	mBoxObject(0),
+	mSmokeVB(0),
+	mParticleSortedVS(0)
 {
 	mWindowTitle = L"Particle Systems Demo";
 }
@@ -41,11 +44,17 @@ MyApp::~MyApp()
 
 	ReleaseCOM(mVertexLayout);
 
+	ReleaseCOM(mSmokeVB);
+	ReleaseCOM(mParticleSortedVS);
+
 	delete mSkullObject;
 	delete mFloorObject;
 	delete mBoxObject;
 	delete [] &mSphereObjects;
 	delete [] &mColumnObjects;
+
+	// Drop the cache's references before the device goes away.
+	GTextureCache::Get().Clear();
 }
 
 bool MyApp::Init()
@@ -92,18 +101,7 @@ bool MyApp::Init()
 	PositionObjects();
 
 	// Compile Shaders
-	CreateVertexShader(&mVertexShader, L"Shaders/VertexShader.hlsl", "VS");
-	CreatePixelShader(&mPixelShader, L"Shaders/PixelShader.hlsl", "PS");
-
-	CreateVertexShader(&mSkyVertexShader, L"Shaders/SkyVertexShader.hlsl", "VS");
-	CreatePixelShader(&mSkyPixelShader, L"Shaders/SkyPixelShader.hlsl", "PS");
-
-	CreateVertexShaderParticle(&mParticleStreamOutVS, L"Shaders/ParticleStreamOutVS.hlsl", "VS");
-	CreateGeometryShaderStreamOut(&mParticleStreamOutGS, L"Shaders/ParticleStreamOutGS.hlsl", "GS");
-
-	CreateVertexShaderParticle(&mParticleDrawVS, L"Shaders/ParticleDrawVS.hlsl", "VS");
-	CreateGeometryShader(&mParticleDrawGS, L"Shaders/ParticleDrawGS.hlsl", "GS");
-	CreatePixelShader(&mParticleDrawPS, L"Shaders/ParticleDrawPS.hlsl", "PS");
+	BuildShaders();
 
 	// Create Constant Buffers
 	CreateConstantBuffer(&mConstBufferPerFrame, sizeof(ConstBufferPerFrame));
@@ -124,6 +122,16 @@ bool MyApp::Init()
 	BuildParticleVB();
 	CreateRandomSRV();
 
+	// Initialize smoke particle system
+	mSmokeSystem.Init(4000, 4.0f, 1000.0f);
+	mSmokeSystem.SetEmitter(DirectX::XMFLOAT3(-5.0f, 0.5f, 0.0f), DirectX::XMFLOAT3(-1.0f, 1.0f, 0.0f));
+	mSmokeSystem.SetAcceleration(DirectX::XMFLOAT3(0.0f, 0.4f, 0.0f));
+	mSmokeSystem.SetSpeed(1.5f, 0.6f);
+	mSmokeSystem.SetSize(0.5f, 2.5f);
+
+	BuildSmokeVB();
+	BuildSmokeColliders();
+
 	return true;
 }
 
@@ -260,14 +268,8 @@ void MyApp::PositionObjects()
 	LoadTextureToSRV(&mTexArraySRV, L"Textures/flare0.dds");
 }
 
-void MyApp::CreateVertexShader(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint)
+void MyApp::BuildShaders()
 {
-	ID3DBlob* VSByteCode = 0;
-	HR(D3DCompileFromFile(filename, 0, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, "vs_5_0", D3DCOMPILE_DEBUG, 0, &VSByteCode, 0));
-
-	HR(mDevice->CreateVertexShader(VSByteCode->GetBufferPointer(), VSByteCode->GetBufferSize(), NULL, shader));
-
-	// Create the vertex input layout.
 	D3D11_INPUT_ELEMENT_DESC vertexDesc[] =
 	{
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,  D3D11_INPUT_PER_VERTEX_DATA, 0 },
@@ -276,23 +278,7 @@ void MyApp::CreateVertexShader(ID3D11VertexShader** shader, LPCWSTR filename, LP
 		{ "TANGENT",  0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 32, D3D11_INPUT_PER_VERTEX_DATA, 0 }
 	};
 
-	UINT numElements = sizeof(vertexDesc) / sizeof(D3D11_INPUT_ELEMENT_DESC);
-
-	// Create the input layout
-	HR(mDevice->CreateInputLayout(vertexDesc, numElements, VSByteCode->GetBufferPointer(), VSByteCode->GetBufferSize(), &mVertexLayout));
-
-	VSByteCode->Release();
-}
-
-void MyApp::CreateVertexShaderParticle(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint)
-{
-	ID3DBlob* VSByteCode = 0;
-	HR(D3DCompileFromFile(filename, 0, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, "vs_5_0", D3DCOMPILE_DEBUG, 0, &VSByteCode, 0));
-
-	HR(mDevice->CreateVertexShader(VSByteCode->GetBufferPointer(), VSByteCode->GetBufferSize(), NULL, shader));
-
-	// Create the vertex input layout.
-	D3D11_INPUT_ELEMENT_DESC vertexDesc[] =
+	D3D11_INPUT_ELEMENT_DESC particleDesc[] =
 	{
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,  0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 		{ "VELOCITY", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
@@ -301,61 +287,48 @@ void MyApp::CreateVertexShaderParticle(ID3D11VertexShader** shader, LPCWSTR file
 		{ "TYPE",     0, DXGI_FORMAT_R32_UINT,        0, 36, D3D11_INPUT_PER_VERTEX_DATA, 0 }
 	};
 
-	UINT numElements = sizeof(vertexDesc) / sizeof(D3D11_INPUT_ELEMENT_DESC);
-
-	// Create the input layout
-	HR(mDevice->CreateInputLayout(vertexDesc, numElements, VSByteCode->GetBufferPointer(), VSByteCode->GetBufferSize(), &mVertexLayoutParticle));
-
-	VSByteCode->Release();
-}
-
-void MyApp::CreateGeometryShader(ID3D11GeometryShader** shader, LPCWSTR filename, LPCSTR entryPoint)
-{
-	ID3DBlob* GSByteCode = 0;
-	HR(D3DCompileFromFile(filename, 0, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, "gs_5_0", D3DCOMPILE_DEBUG, 0, &GSByteCode, 0));
-
-	HR(mDevice->CreateGeometryShader(GSByteCode->GetBufferPointer(), GSByteCode->GetBufferSize(), NULL, shader));
-
-	GSByteCode->Release();
-}
-
-void MyApp::CreateGeometryShaderStreamOut(ID3D11GeometryShader** shader, LPCWSTR filename, LPCSTR entryPoint)
-{
-	ID3DBlob* GSByteCode = 0;
-	HR(D3DCompileFromFile(filename, 0, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, "gs_5_0", D3DCOMPILE_DEBUG, 0, &GSByteCode, 0));
-
 	D3D11_SO_DECLARATION_ENTRY soDecl[] =
 	{
-		// semantic name, semantic index, start component, component count, output slot
-		{ 0, "POSITION",    0, 0, 3, 0 },   // output all components of position
-		{ 0, "VELOCITY",    0, 0, 3, 0 },     // output the first 3 of the normal
-		{ 0, "SIZE",        0, 0, 2, 0 },     // output the first 2 texture coordinates
-		{ 0, "AGE",         0, 0, 1, 0 },     // output the first 2 texture coordinates
-		{ 0, "TYPE",        0, 0, 1, 0 },     // output the first 2 texture coordinates
+		// stream, semantic name, semantic index, start component, component count, output slot
+		{ 0, "POSITION", 0, 0, 3, 0 },
+		{ 0, "VELOCITY", 0, 0, 3, 0 },
+		{ 0, "SIZE",     0, 0, 2, 0 },
+		{ 0, "AGE",      0, 0, 1, 0 },
+		{ 0, "TYPE",     0, 0, 1, 0 }
 	};
 
+	UINT numVertexElements = sizeof(vertexDesc) / sizeof(D3D11_INPUT_ELEMENT_DESC);
+	UINT numParticleElements = sizeof(particleDesc) / sizeof(D3D11_INPUT_ELEMENT_DESC);
 	UINT numEntries = sizeof(soDecl) / sizeof(D3D11_SO_DECLARATION_ENTRY);
 
-	HR(mDevice->CreateGeometryShaderWithStreamOutput(GSByteCode->GetBufferPointer(), GSByteCode->GetBufferSize(), soDecl, numEntries, NULL, 0, 0, NULL, shader));
+	// Each input layout is created once, against the first shader that uses it.
+	GPipelineBuilder builder;
 
-	GSByteCode->Release();
-}
+	builder.AddVertexShader(&mVertexShader, L"Shaders/VertexShader.hlsl", "VS", vertexDesc, numVertexElements, &mVertexLayout);
+	builder.AddPixelShader(&mPixelShader, L"Shaders/PixelShader.hlsl", "PS");
 
-void MyApp::CreatePixelShader(ID3D11PixelShader** shader, LPCWSTR filename, LPCSTR entryPoint)
-{
-	ID3DBlob* PSByteCode = 0;
-	HR(D3DCompileFromFile(filename, 0, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, "ps_5_0", D3DCOMPILE_DEBUG, 0, &PSByteCode, 0));
+	builder.AddVertexShader(&mSkyVertexShader, L"Shaders/SkyVertexShader.hlsl", "VS");
+	builder.AddPixelShader(&mSkyPixelShader, L"Shaders/SkyPixelShader.hlsl", "PS");
+
+	builder.AddVertexShader(&mParticleStreamOutVS, L"Shaders/ParticleStreamOutVS.hlsl", "VS", particleDesc, numParticleElements, &mVertexLayoutParticle);
+	builder.AddGeometryShader(&mParticleStreamOutGS, L"Shaders/ParticleStreamOutGS.hlsl", "GS", soDecl, numEntries);
+
+	builder.AddVertexShader(&mParticleDrawVS, L"Shaders/ParticleDrawVS.hlsl", "VS");
+	builder.AddGeometryShader(&mParticleDrawGS, L"Shaders/ParticleDrawGS.hlsl", "GS");
+	builder.AddPixelShader(&mParticleDrawPS, L"Shaders/ParticleDrawPS.hlsl", "PS");
 
-	HR(mDevice->CreatePixelShader(PSByteCode->GetBufferPointer(), PSByteCode->GetBufferSize(), NULL, shader));
+	builder.AddVertexShader(&mParticleSortedVS, L"Shaders/ParticleSortedVS.hlsl", "VS");
 
-	PSByteCode->Release();
+	bool bBuilt = builder.Build(mDevice);
+
+	OutputDebugStringW(builder.GetReport().c_str());
+	HR(bBuilt ? S_OK : E_FAIL);
 }
 
 void MyApp::LoadTextureToSRV(ID3D11ShaderResourceView** SRV, LPCWSTR filename)
 {
-	ID3D11Resource* texResource = nullptr;
-	HR(DirectX::CreateDDSTextureFromFile(mDevice, filename, &texResource, SRV));
-	ReleaseCOM(texResource); // view saves reference
+	// Objects that use the same file share one texture.
+	HR(GTextureCache::Get().Acquire(mDevice, filename, SRV));
 }
 
 void MyApp::CreateConstantBuffer(ID3D11Buffer** buffer, UINT size)
@@ -510,6 +483,9 @@ void MyApp::UpdateScene(float dt)
 	mGameTime = mTimer.TotalTime();
 	mTimeStep = dt;
 	mAge += dt;
+
+	mSmokeSystem.Update(dt);
+	mSmokeCollider.Collide(mSmokeSystem);
 }
 
 void MyApp::OnKeyDown(WPARAM key, LPARAM info)
@@ -594,6 +570,44 @@ void MyApp::BuildParticleVB()
 	HR(mDevice->CreateBuffer(&vbd, 0, &mStreamOutVB));
 }
 
+void MyApp::BuildSmokeVB()
+{
+	D3D11_BUFFER_DESC vbd;
+	vbd.Usage = D3D11_USAGE_DYNAMIC;
+	vbd.ByteWidth = sizeof(Particle) * mSmokeSystem.GetMaxParticles();
+	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	vbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	vbd.MiscFlags = 0;
+	vbd.StructureByteStride = 0;
+
+	HR(mDevice->CreateBuffer(&vbd, 0, &mSmokeVB));
+}
+
+void MyApp::BuildSmokeColliders()
+{
+	// Cells about the size of a sphere keep each particle bucket down to a collider or two
+	mSmokeCollider.Init(1.0f, mSmokeSystem.GetMaxParticles());
+	mSmokeCollider.SetResponse(0.2f, 0.3f);
+
+	for (int i = 0; i < 10; ++i)
+	{
+		DirectX::XMFLOAT4X4 sphereWorld = mSphereObjects[i]->GetWorldTransform();
+		DirectX::XMFLOAT3 sphereCenter(sphereWorld._41, sphereWorld._42, sphereWorld._43);
+		mSmokeCollider.AddSphere(DirectX::BoundingSphere(sphereCenter, 0.5f));
+
+		DirectX::XMFLOAT4X4 columnWorld = mColumnObjects[i]->GetWorldTransform();
+		DirectX::XMFLOAT3 columnCenter(columnWorld._41, columnWorld._42, columnWorld._43);
+		mSmokeCollider.AddBox(DirectX::BoundingBox(columnCenter, DirectX::XMFLOAT3(0.5f, 1.5f, 0.5f)));
+	}
+
+	DirectX::XMFLOAT4X4 boxWorld = mBoxObject->GetWorldTransform();
+	DirectX::XMFLOAT3 boxCenter(boxWorld._41, boxWorld._42, boxWorld._43);
+	mSmokeCollider.AddBox(DirectX::BoundingBox(boxCenter, DirectX::XMFLOAT3(1.5f, 0.5f, 1.5f)));
+
+	// Floor
+	mSmokeCollider.AddPlane(DirectX::XMFLOAT4(0.0f, 1.0f, 0.0f, 0.0f));
+}
+
 void MyApp::RenderScene()
 {
 	// Clear the render target and depth/stencil views
@@ -780,6 +794,67 @@ void MyApp::RenderParticleSystem()
 	mImmediateContext->PSSetShader(0, NULL, 0);
 }
 
+void MyApp::RenderSmoke()
+{
+	UINT numParticles = mSmokeSystem.GetAliveCount();
+	if (numParticles == 0)
+	{
+		return;
+	}
+
+	mSmokeSystem.SortBackToFront(mCamera.GetPosition(), mCamera.GetLook());
+
+	// Write the live particles into the vertex buffer in draw order
+	D3D11_MAPPED_SUBRESOURCE mappedData;
+	HR(mImmediateContext->Map(mSmokeVB, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData));
+
+	Particle* vertices = reinterpret_cast<Particle*>(mappedData.pData);
+	const UINT* drawOrder = mSmokeSystem.GetDrawOrder();
+	float invLifetime = 1.0f / mSmokeSystem.GetLifetime();
+
+	for (UINT i = 0; i < numParticles; ++i)
+	{
+		UINT slot = drawOrder[i];
+		float size = mSmokeSystem.GetSize(slot);
+
+		vertices[i].InitialPos = mSmokeSystem.GetPosition(slot);
+		vertices[i].InitialVel = mSmokeSystem.GetVelocity(slot);
+		vertices[i].Size = DirectX::XMFLOAT2(size, size);
+		vertices[i].Age = mSmokeSystem.GetAge(slot) * invLifetime;
+		vertices[i].Type = PT_FLARE;
+	}
+
+	mImmediateContext->Unmap(mSmokeVB, 0);
+
+	// The per frame particle constants were already set by RenderParticleSystem
+	UINT stride = sizeof(Particle);
+	UINT offset = 0;
+
+	mImmediateContext->IASetInputLayout(mVertexLayoutParticle);
+	mImmediateContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
+	mImmediateContext->IASetVertexBuffers(0, 1, &mSmokeVB, &stride, &offset);
+
+	mImmediateContext->VSSetShader(mParticleSortedVS, NULL, 0);
+	mImmediateContext->GSSetShader(mParticleDrawGS, NULL, 0);
+	mImmediateContext->PSSetShader(mParticleDrawPS, NULL, 0);
+
+	mImmediateContext->GSSetConstantBuffers(0, 1, &mConstBufferPerFrameParticle);
+
+	mImmediateContext->PSSetShaderResources(0, 1, &mTexArraySRV);
+	mImmediateContext->PSSetSamplers(0, 1, &RenderStates::DefaultSS);
+
+	float blendFactor[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	mImmediateContext->OMSetDepthStencilState(RenderStates::NoDepthWritesDSS, 0);
+	mImmediateContext->OMSetBlendState(RenderStates::TransparentBS, blendFactor, 0xffffffff);
+
+	mImmediateContext->Draw(numParticles, 0);
+
+	mImmediateContext->VSSetShader(0, NULL, 0);
+	mImmediateContext->GSSetShader(0, NULL, 0);
+	mImmediateContext->PSSetShader(0, NULL, 0);
+}
+
 void MyApp::DrawScene()
 {
 	// Update Camera
@@ -791,5 +866,8 @@ void MyApp::DrawScene()
 	// Particle System
 	RenderParticleSystem();
 
+	// Alpha-blended smoke must come last, drawn back to front over the scene
+	RenderSmoke();
+
 	HR(mSwapChain->Present(0, 0));
 }
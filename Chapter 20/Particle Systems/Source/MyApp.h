@@ -15,6 +15,8 @@
 #include "GCylinder.h"
 #include "GPlaneXZ.h"
 #include "GSky.h"
+#include "GParticleSystem.h"
+#include "GParticleCollider.h"
 
 struct ConstBufferPerObject
 {
@@ -91,13 +93,7 @@ private:
 	void CreateGeometryBuffers(GObject* obj, bool dynamic = false);
 	void CreateConstantBuffer(ID3D11Buffer** buffer, UINT size);
 
-	void CreateVertexShader(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint);
-	void CreateVertexShaderParticle(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint);
-
-	void CreateGeometryShader(ID3D11GeometryShader** shader, LPCWSTR filename, LPCSTR entryPoint);
-	void CreateGeometryShaderStreamOut(ID3D11GeometryShader** shader, LPCWSTR filename, LPCSTR entryPoint);
-
-	void CreatePixelShader(ID3D11PixelShader** shader, LPCWSTR filename, LPCSTR entryPoint);
+	void BuildShaders();
 
 	void LoadTextureToSRV(ID3D11ShaderResourceView** srv, LPCWSTR filename);
 
@@ -116,6 +112,10 @@ private:
 	void CreateRandomSRV();
 	void BuildParticleVB();
 
+	void BuildSmokeVB();
+	void BuildSmokeColliders();
+	void RenderSmoke();
+
 private:
 	// Constant Buffers
 	ID3D11Buffer* mConstBufferPerFrame;
@@ -187,6 +187,12 @@ private:
 	ID3D11Buffer* mConstBufferPerFrameParticle;
 	D3D11_MAPPED_SUBRESOURCE cbPerFrameParticleResource;
 	ConstBufferPerFrameParticle* cbPerFrameParticle;
+
+	// Smoke Particle System (CPU simulated, sorted back to front)
+	GParticleSystem mSmokeSystem;
+	GParticleCollider mSmokeCollider;
+	ID3D11Buffer* mSmokeVB;
+	ID3D11VertexShader* mParticleSortedVS;
 };
 
 #endif // MYAPP_H
\ No newline at end of file
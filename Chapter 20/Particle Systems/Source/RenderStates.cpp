@@ -16,6 +16,7 @@ ID3D11DepthStencilState* RenderStates::DisableDepthDSS = 0;
 ID3D11DepthStencilState* RenderStates::NoDepthWritesDSS = 0;
 
 ID3D11BlendState* RenderStates::AdditiveBS = 0;
+ID3D11BlendState* RenderStates::TransparentBS = 0;
 
 void RenderStates::InitAll(ID3D11Device* device)
 {
@@ -125,6 +126,21 @@ void RenderStates::InitAll(ID3D11Device* device)
 
 	HR(device->CreateBlendState(&AdditiveBSDesc, &AdditiveBS));
 
+	// Transparent Blend State
+	D3D11_BLEND_DESC TransparentBSDesc;
+	TransparentBSDesc.AlphaToCoverageEnable = false;
+	TransparentBSDesc.IndependentBlendEnable = false;
+	TransparentBSDesc.RenderTarget[0].BlendEnable = true;
+	TransparentBSDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+	TransparentBSDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+	TransparentBSDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+	TransparentBSDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+	TransparentBSDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
+	TransparentBSDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+	TransparentBSDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+
+	HR(device->CreateBlendState(&TransparentBSDesc, &TransparentBS));
+
 	// Default Sampler State
 	D3D11_SAMPLER_DESC DefaultSSDesc;
 	DefaultSSDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
@@ -150,4 +166,7 @@ void RenderStates::DestroyAll()
 	ReleaseCOM(DefaultDSS);
 	ReleaseCOM(DefaultBS);
 	ReleaseCOM(DefaultSS);
+
+	ReleaseCOM(AdditiveBS);
+	ReleaseCOM(TransparentBS);
 }
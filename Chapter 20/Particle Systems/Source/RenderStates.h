@@ -25,6 +25,7 @@ public:
 	static ID3D11DepthStencilState* NoDepthWritesDSS;
 
 	static ID3D11BlendState* AdditiveBS;
+	static ID3D11BlendState* TransparentBS;
 };
 
 #endif // RENDERSTATES_H
\ No newline at end of file
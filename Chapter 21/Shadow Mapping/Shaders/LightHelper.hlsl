@@ -256,6 +256,37 @@ float CalcShadowFactor(SamplerComparisonState samShadow,
 	return percentLit /= 9.0f;
 }
 
+float CalcCascadeShadowFactor(SamplerComparisonState samShadow,
+	Texture2DArray shadowMap,
+	float4 shadowPosH,
+	uint cascade)
+{
+	// Orthographic, so w is 1, but divide anyway to match CalcShadowFactor.
+	shadowPosH.xyz /= shadowPosH.w;
+
+	float depth = shadowPosH.z;
+
+	// Every cascade has the same resolution.
+	const float dx = SMAP_DX;
+
+	float percentLit = 0.0f;
+	const float2 offsets[9] =
+	{
+		float2(-dx,  -dx), float2(0.0f,  -dx), float2(dx,  -dx),
+		float2(-dx, 0.0f), float2(0.0f, 0.0f), float2(dx, 0.0f),
+		float2(-dx,  +dx), float2(0.0f,  +dx), float2(dx,  +dx)
+	};
+
+	[unroll]
+	for (int i = 0; i < 9; ++i)
+	{
+		percentLit += shadowMap.SampleCmpLevelZero(samShadow,
+			float3(shadowPosH.xy + offsets[i], cascade), depth).r;
+	}
+
+	return percentLit /= 9.0f;
+}
+
 
 float CalcShadowFactor2(SamplerState samShadow,
 	Texture2D shadowMap,
@@ -17,6 +17,10 @@ cbuffer cbPerFrame : register(b0)
 	DirectionalLight gDirLights[3];
 	float3 gEyePosW;
 	float pad;
+
+	// World to shadow map space for each cascade, and the view depth each one ends at.
+	float4x4 gShadowTransforms[4];
+	float4 gCascadeSplits;
 };
 
 cbuffer cbPerObject : register(b1)
@@ -25,7 +29,6 @@ cbuffer cbPerObject : register(b1)
 	float4x4 gWorldInvTranspose;
 	float4x4 gWorldViewProj;
 	float4x4 gTexTransform;
-	float4x4 gShadowTransform;
 	Material gMaterial;
 };
 
@@ -41,7 +44,7 @@ cbuffer cbPSParams : register(b2)
 
 Texture2D gDiffuseMap;
 Texture2D gNormalMap;
-Texture2D gShadowMap;
+Texture2DArray gShadowMap;
 TextureCube gCubeMap;
 
 SamplerState samLinear
@@ -78,7 +81,6 @@ struct VertexOut
 	float3 NormalW    : NORMAL;
 	float3 TangentW   : TANGENT;
 	float2 Tex        : TEXCOORD;
-	float4 ShadowPosH : TEXCOORD1;
 };
 
 float4 PS(VertexOut pin) : SV_Target
@@ -137,7 +139,25 @@ float4 PS(VertexOut pin) : SV_Target
 
 		// Only the first light casts a shadow.
 		float3 shadow = float3(1.0f, 1.0f, 1.0f);
-		shadow[0] = CalcShadowFactor(samShadow, gShadowMap, pin.ShadowPosH);
+		// Pick the first cascade that reaches the pixel's view depth; past the last one the
+		// pixel is lit.
+		float viewDepth = pin.PosH.w;
+		uint cascade = 4;
+
+		[unroll]
+		for (int c = 3; c >= 0; --c)
+		{
+			if (viewDepth <= gCascadeSplits[c])
+			{
+				cascade = c;
+			}
+		}
+
+		if (cascade < 4)
+		{
+			float4 shadowPosH = mul(float4(pin.PosW, 1.0f), gShadowTransforms[cascade]);
+			shadow[0] = CalcCascadeShadowFactor(samShadow, gShadowMap, shadowPosH, cascade);
+		}
 
 		// Sum the light contribution from each light source.  
 		[unroll]
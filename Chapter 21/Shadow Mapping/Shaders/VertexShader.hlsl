@@ -12,7 +12,6 @@ cbuffer cbPerObject : register(b1)
 	float4x4 gWorldInvTranspose;
 	float4x4 gWorldViewProj;
 	float4x4 gTexTransform;
-	float4x4 gShadowTransform;
 	Material gMaterial;
 };
 
@@ -31,7 +30,6 @@ struct VertexOut
     float3 NormalW    : NORMAL;
 	float3 TangentW   : TANGENT;
 	float2 Tex        : TEXCOORD0;
-	float4 ShadowPosH : TEXCOORD1;
 };
 
 VertexOut VS(VertexIn vin)
@@ -47,8 +45,5 @@ VertexOut VS(VertexIn vin)
 	
 	vout.Tex = mul(float4(vin.Tex, 0.0f, 1.0f), gTexTransform).xy;
 
-	// Generate projective tex-coords to project shadow map onto scene.
-	vout.ShadowPosH = mul(float4(vin.PosL, 1.0f), gShadowTransform);
-
     return vout;
 }
@@ -6,6 +6,15 @@
 #include "GeometryGenerator.h"
 #include "MathHelper.h"
 #include "D3DCompiler.h"
+#include "GTextureCache.h"
+
+namespace
+{
+	const UINT ShadowMapSize = 2048;
+
+	// Only this much of the view distance receives shadows; the cascades split this range.
+	const float ShadowDistance = 60.0f;
+}
 
 MyApp::MyApp(HINSTANCE Instance) :
 	D3DApp(Instance),
@@ -20,7 +29,12 @@ MyApp::MyApp(HINSTANCE Instance) :
 	mVertexLayout(0),
 	mSkullObject(0),
 	mFloorObject(0),
-	mBoxObject(0)
+	mBoxObject(0),
+	mSkullRotation(0.0f),
+	mShadowMap(0),
+	mStaticShadowMap(0),
+	mShadowDrawCount(0),
+	mShadowDrawsSkipped(0)
 {
 	mWindowTitle = L"Shadow Map Demo";
 }
@@ -44,11 +58,17 @@ MyApp::~MyApp()
 
 	ReleaseCOM(mVertexLayout);
 
+	delete mShadowMap;
+	delete mStaticShadowMap;
+
 	delete mSkullObject;
 	delete mFloorObject;
 	delete mBoxObject;
 	delete [] &mSphereObjects;
 	delete [] &mColumnObjects;
+
+	// Drop the cache's references before the device goes away.
+	GTextureCache::Get().Clear();
 }
 
 bool MyApp::Init()
@@ -58,6 +78,9 @@ bool MyApp::Init()
 
 	// Initiailize Render States
 	RenderStates::InitAll(mDevice);
+
+	// Initialize Texture Loader
+	if (!mTextureLoader.Init(mDevice)) { return false; }
 	
 	// Initialize Camera
 	mCamera.SetPosition(0.0f, 2.0f, -15.0f);
@@ -96,8 +119,15 @@ bool MyApp::Init()
 	// Initialize Object Placement and Properties
 	PositionObjects();
 
-	// Initialize Shadow Map
-	mShadowMap = new ShadowMap(mDevice, 2048, 2048);
+	// Initialize Shadow Map, one slice per cascade, and the cache of its static casters
+	mShadowMap = new ShadowMap(mDevice, ShadowMapSize, ShadowMapSize, GShadowCascades::MaxCascades);
+	mStaticShadowMap = new ShadowMap(mDevice, ShadowMapSize, ShadowMapSize, GShadowCascades::MaxCascades);
+
+	mShadowCascades.SetResolution(ShadowMapSize);
+	mShadowCascades.SetShadowDistance(ShadowDistance);
+
+	BuildShadowCasters();
+	InvalidateStaticShadows();
 
 	// Compile Shaders
 	CreateVertexShader(&mVertexShader, L"Shaders/VertexShader.hlsl", "VS");
@@ -244,19 +274,20 @@ void MyApp::PositionObjects()
 	mSkullObject->SetSpecular(DirectX::XMFLOAT4(0.8f, 0.8f, 0.8f, 16.0f));
 	mSkullObject->SetReflect(DirectX::XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f));
 
-	LoadTextureToSRV(mFloorObject->GetDiffuseMapSRV(), L"Textures/floor.dds");
-	LoadTextureToSRV(mFloorObject->GetNormalMapSRV(), L"Textures/floor_nmap.dds");
+	// Textures stream in while the scene runs; objects draw with placeholders until then.
+	mTextureLoader.Load(L"Textures/floor.dds", mFloorObject->GetDiffuseMapSRV());
+	mTextureLoader.Load(L"Textures/floor_nmap.dds", mFloorObject->GetNormalMapSRV(), GTextureLoader::PLACEHOLDER_FLAT_NORMAL);
 
-	LoadTextureToSRV(mBoxObject->GetDiffuseMapSRV(), L"Textures/grass.dds");
-	LoadTextureToSRV(mBoxObject->GetNormalMapSRV(), L"Textures/bricks_nmap.dds");
+	mTextureLoader.Load(L"Textures/grass.dds", mBoxObject->GetDiffuseMapSRV());
+	mTextureLoader.Load(L"Textures/bricks_nmap.dds", mBoxObject->GetNormalMapSRV(), GTextureLoader::PLACEHOLDER_FLAT_NORMAL);
 
 	for (int i = 0; i < 10; ++i)
 	{
-		LoadTextureToSRV(mSphereObjects[i]->GetDiffuseMapSRV(), L"Textures/ice.dds");
-		LoadTextureToSRV(mColumnObjects[i]->GetDiffuseMapSRV(), L"Textures/stone.dds");
+		mTextureLoader.Load(L"Textures/ice.dds", mSphereObjects[i]->GetDiffuseMapSRV());
+		mTextureLoader.Load(L"Textures/stone.dds", mColumnObjects[i]->GetDiffuseMapSRV());
 	}
 
-	LoadTextureToSRV(mSkyObject->GetDiffuseMapSRV(), L"Textures/grasscube1024.dds");
+	mTextureLoader.Load(L"Textures/grasscube1024.dds", mSkyObject->GetDiffuseMapSRV(), GTextureLoader::PLACEHOLDER_CUBE);
 }
 
 void MyApp::CreateVertexShader(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint)
@@ -314,13 +345,6 @@ void MyApp::CreatePixelShader(ID3D11PixelShader** shader, LPCWSTR filename, LPCS
 	PSByteCode->Release();
 }
 
-void MyApp::LoadTextureToSRV(ID3D11ShaderResourceView** SRV, LPCWSTR filename)
-{
-	ID3D11Resource* texResource = nullptr;
-	HR(DirectX::CreateDDSTextureFromFile(mDevice, filename, &texResource, SRV));
-	ReleaseCOM(texResource); // view saves reference
-}
-
 void MyApp::CreateConstantBuffer(ID3D11Buffer** buffer, UINT size)
 {
 	D3D11_BUFFER_DESC desc;
@@ -357,42 +381,61 @@ void MyApp::SetupStaticLights()
 	mOriginalLightDir[2] = mDirLights[2].Direction;
 }
 
+void MyApp::BuildShadowCasters()
+{
+	mShadowCasters.clear();
+
+	auto addCaster = [this](GObject* object, bool bStatic)
+	{
+		ShadowCaster caster;
+		caster.Object = object;
+		caster.bStatic = bStatic;
+		DirectX::BoundingBox::CreateFromPoints(caster.LocalBounds, object->GetVertexCount(),
+			&static_cast<Vertex*>(object->GetVertices())->Pos, sizeof(Vertex));
+		mShadowCasters.push_back(caster);
+	};
+
+	addCaster(mFloorObject, true);
+	addCaster(mBoxObject, true);
+
+	for (int i = 0; i < 10; ++i)
+	{
+		addCaster(mColumnObjects[i], true);
+		addCaster(mSphereObjects[i], true);
+	}
+
+	// The skull spins, so it is redrawn every frame.
+	addCaster(mSkullObject, false);
+
+	mCasterBounds.resize(mShadowCasters.size());
+	UpdateCasterBounds();
+}
+
+void MyApp::UpdateCasterBounds()
+{
+	for (size_t i = 0; i < mShadowCasters.size(); ++i)
+	{
+		DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&mShadowCasters[i].Object->GetWorldTransform());
+		mShadowCasters[i].LocalBounds.Transform(mCasterBounds[i], world);
+	}
+}
+
+void MyApp::InvalidateStaticShadows()
+{
+	// Call whenever a static caster moves; light and camera changes are caught by the cascades.
+	mStaticShadowCache.Invalidate();
+}
+
 void MyApp::BuildShadowTransform()
 {
-	// Build Directional Light View Matrix
-	float radius = 18.0f;
-
-	DirectX::XMVECTOR lightDir = DirectX::XMLoadFloat3(&mDirLights[0].Direction);
-	DirectX::XMVECTOR lightPos = DirectX::XMVectorScale(lightDir, -2.0f*radius);
-	DirectX::XMVECTOR targetPos = DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
-	DirectX::XMVECTOR up = DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-
-	DirectX::XMMATRIX V = DirectX::XMMatrixLookAtLH(lightPos, targetPos, up);
-
-	// Build Directional Light Ortho Projection Volume Matrix
-	DirectX::XMFLOAT3 center(0.0f, 0.0f, 0.0f);
-	DirectX::XMStoreFloat3(&center, DirectX::XMVector3TransformCoord(targetPos, V));
-
-	DirectX::XMMATRIX P = DirectX::XMMatrixOrthographicOffCenterLH(
-		center.x - radius, center.x + radius,
-		center.y - radius, center.y + radius,
-		center.z - radius, center.z + radius);
-
-	// Build Directional Light Texture Matrix to transform from NDC space to Texture Space
-	DirectX::XMMATRIX T(
-		0.5f, 0.0f, 0.0f, 0.0f,
-		0.0f, -0.5f, 0.0f, 0.0f,
-		0.0f, 0.0f, 1.0f, 0.0f,
-		0.5f, 0.5f, 0.0f, 1.0f);
-
-	// Multiply View, Projection, and Texture matrices to get Shadow Transformation Matrix
-	// Transforms vertices from world space to the view space of the light, to the projection
-	// plane, to texture coordinates.
-	DirectX::XMMATRIX S = V*P*T;
-
-	DirectX::XMStoreFloat4x4(&mLightView, V);
-	DirectX::XMStoreFloat4x4(&mLightProj, P);
-	DirectX::XMStoreFloat4x4(&mShadowTransform, S);
+	// Fit one light projection per slice of the camera frustum
+	mCamera.UpdateViewMatrix();
+
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMStoreFloat4x4(&view, mCamera.View());
+
+	mShadowCascades.Update(view, mCamera.GetFovY(), mCamera.GetAspect(), mCamera.GetNearZ(), mCamera.GetFarZ(),
+		mDirLights[0].Direction, mCasterBounds.data(), static_cast<UINT>(mCasterBounds.size()));
 }
 
 void MyApp::DrawObject(GObject* object)
@@ -419,7 +462,6 @@ void MyApp::Draw(GObject* object, DirectX::XMMATRIX& world, bool bShadow)
 	DirectX::XMMATRIX worldInvTranspose = MathHelper::InverseTranspose(world);
 	DirectX::XMMATRIX worldViewProj = world*mCamera.ViewProj();
 	DirectX::XMMATRIX texTransform = XMLoadFloat4x4(&object->GetTexTransform());
-	DirectX::XMMATRIX shadowTransform = XMLoadFloat4x4(&mShadowTransform);
 
 	// Set per object constants
 	mImmediateContext->Map(mConstBufferPerObject, 0, D3D11_MAP_WRITE_DISCARD, 0, &cbPerObjectResource);
@@ -428,7 +470,6 @@ void MyApp::Draw(GObject* object, DirectX::XMMATRIX& world, bool bShadow)
 	cbPerObject->worldInvTranpose = DirectX::XMMatrixTranspose(worldInvTranspose);
 	cbPerObject->worldViewProj = DirectX::XMMatrixTranspose(worldViewProj);
 	cbPerObject->texTransform = DirectX::XMMatrixTranspose(texTransform);
-	cbPerObject->shadowTransform = DirectX::XMMatrixTranspose(world*shadowTransform);
 
 	// If drawing a shadow, use the object's shadow material
 	if (bShadow == true) 
@@ -486,6 +527,9 @@ void MyApp::OnResize()
 
 void MyApp::UpdateScene(float dt)
 {
+	// Swap in any textures that finished loading.
+	mTextureLoader.ProcessUploads();
+
 	// Control the camera.
 	if (GetAsyncKeyState('W') & 0x8000)
 	{
@@ -507,8 +551,16 @@ void MyApp::UpdateScene(float dt)
 		mCamera.Strafe(10.0f*dt);
 	}
 
-	// Animate the lights
-	mLightRotationAngle += 0.25f*dt;
+	// Rotate the lights while Q or E is held; the cached shadows are rebuilt only then.
+	if (GetAsyncKeyState('Q') & 0x8000)
+	{
+		mLightRotationAngle -= 0.5f*dt;
+	}
+
+	if (GetAsyncKeyState('E') & 0x8000)
+	{
+		mLightRotationAngle += 0.5f*dt;
+	}
 
 	DirectX::XMMATRIX R = DirectX::XMMatrixRotationY(mLightRotationAngle);
 	
@@ -519,6 +571,11 @@ void MyApp::UpdateScene(float dt)
 		DirectX::XMStoreFloat3(&mDirLights[i].Direction, lightDir);
 	}
 
+	// Spin the skull, the one dynamic shadow caster
+	mSkullRotation += 45.0f*dt;
+	mSkullObject->Rotate(0.0f, mSkullRotation, 0.0f);
+
+	UpdateCasterBounds();
 	BuildShadowTransform();
 }
 
@@ -534,16 +591,41 @@ void MyApp::OnKeyDown(WPARAM key, LPARAM info)
 	}
 }
 
-void MyApp::RenderShadowMap()
+void MyApp::DrawShadowCaster(GObject* object, DirectX::CXMMATRIX viewProj)
 {
-	// Set Null Render Target and Shadow Map DSV
-	ID3D11RenderTargetView* renderTargets[] = { nullptr };
-	ID3D11DepthStencilView* shadowMapDSV = mShadowMap->GetDepthMapDSV();
-	mImmediateContext->OMSetRenderTargets(1, renderTargets, shadowMapDSV);
+	DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&object->GetWorldTransform());
+	DirectX::XMMATRIX worldViewProj = world*viewProj;
 
-	// Clear Shadow Map DSV
-	mImmediateContext->ClearDepthStencilView(shadowMapDSV, D3D11_CLEAR_DEPTH, 1.0f, 0);
+	mImmediateContext->Map(mConstBufferPerObjectShadow, 0, D3D11_MAP_WRITE_DISCARD, 0, &cbPerObjectShadowResource);
+	cbPerObjectShadow = (ConstBufferPerObjectShadow*)cbPerObjectShadowResource.pData;
+	cbPerObjectShadow->worldViewProj = DirectX::XMMatrixTranspose(worldViewProj);
+	mImmediateContext->Unmap(mConstBufferPerObjectShadow, 0);
+
+	UINT stride = sizeof(Vertex);
+	UINT offset = 0;
 
+	mImmediateContext->IASetVertexBuffers(0, 1, object->GetVertexBuffer(), &stride, &offset);
+	mImmediateContext->IASetIndexBuffer(*object->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
+
+	mImmediateContext->DrawIndexed(object->GetIndexCount(), 0, 0);
+
+	++mShadowDrawCount;
+}
+
+void MyApp::DrawShadowCasters(bool bStatic, UINT cascade, DirectX::CXMMATRIX viewProj)
+{
+	for (UINT i = 0; i < mShadowCasters.size(); ++i)
+	{
+		// Skip casters outside the cascade's volume, extended toward the light
+		if (mShadowCasters[i].bStatic == bStatic && mShadowCascades.CastsInto(cascade, i))
+		{
+			DrawShadowCaster(mShadowCasters[i].Object, viewProj);
+		}
+	}
+}
+
+void MyApp::RenderShadowMap()
+{
 	// Set Viewport
 	D3D11_VIEWPORT shadowMapViewport = mShadowMap->GetViewport();
 	mImmediateContext->RSSetViewports(1, &shadowMapViewport);
@@ -563,92 +645,67 @@ void MyApp::RenderShadowMap()
 	// Set VS constant buffer 
 	mImmediateContext->VSSetConstantBuffers(0, 1, &mConstBufferPerObjectShadow);
 
-	// Compute ViewProj matrix of the light source
-	DirectX::XMMATRIX view = XMLoadFloat4x4(&mLightView);
-	DirectX::XMMATRIX proj = XMLoadFloat4x4(&mLightProj);
-	DirectX::XMMATRIX viewProj = XMMatrixMultiply(view, proj);
-
-	DirectX::XMMATRIX world;
-	DirectX::XMMATRIX worldViewProj;
+	mShadowDrawCount = 0;
 
-	UINT stride = sizeof(Vertex);
-	UINT offset = 0;
-
-	// Draw the grid
-	world = DirectX::XMLoadFloat4x4(&mFloorObject->GetWorldTransform());
-	worldViewProj = world*viewProj;
-
-	mImmediateContext->Map(mConstBufferPerObjectShadow, 0, D3D11_MAP_WRITE_DISCARD, 0, &cbPerObjectShadowResource);
-	cbPerObjectShadow = (ConstBufferPerObjectShadow*)cbPerObjectShadowResource.pData;
-	cbPerObjectShadow->worldViewProj = DirectX::XMMatrixTranspose(worldViewProj);
-	mImmediateContext->Unmap(mConstBufferPerObjectShadow, 0);
-
-	mImmediateContext->IASetVertexBuffers(0, 1, mFloorObject->GetVertexBuffer(), &stride, &offset);
-	mImmediateContext->IASetIndexBuffer(*mFloorObject->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
-
-	mImmediateContext->DrawIndexed(mFloorObject->GetIndexCount(), 0, 0);
-
-	// Draw the box
-	world = DirectX::XMLoadFloat4x4(&mBoxObject->GetWorldTransform());
-	worldViewProj = world*viewProj;
-
-	mImmediateContext->Map(mConstBufferPerObjectShadow, 0, D3D11_MAP_WRITE_DISCARD, 0, &cbPerObjectShadowResource);
-	cbPerObjectShadow = (ConstBufferPerObjectShadow*)cbPerObjectShadowResource.pData;
-	cbPerObjectShadow->worldViewProj = DirectX::XMMatrixTranspose(worldViewProj);
-	mImmediateContext->Unmap(mConstBufferPerObjectShadow, 0);
-
-	mImmediateContext->IASetVertexBuffers(0, 1, mBoxObject->GetVertexBuffer(), &stride, &offset);
-	mImmediateContext->IASetIndexBuffer(*mBoxObject->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
-
-	mImmediateContext->DrawIndexed(mBoxObject->GetIndexCount(), 0, 0);
+	ID3D11RenderTargetView* renderTargets[] = { nullptr };
 
-	// Draw the cylinders
-	for (int i = 0; i < 10; ++i)
+	for (UINT c = 0; c < mShadowCascades.GetCascadeCount(); ++c)
 	{
-		world = DirectX::XMLoadFloat4x4(&mColumnObjects[i]->GetWorldTransform());
-		worldViewProj = world*viewProj;
-
-		mImmediateContext->Map(mConstBufferPerObjectShadow, 0, D3D11_MAP_WRITE_DISCARD, 0, &cbPerObjectShadowResource);
-		cbPerObjectShadow = (ConstBufferPerObjectShadow*)cbPerObjectShadowResource.pData;
-		cbPerObjectShadow->worldViewProj = DirectX::XMMatrixTranspose(worldViewProj);
-		mImmediateContext->Unmap(mConstBufferPerObjectShadow, 0);
-
-		mImmediateContext->IASetVertexBuffers(0, 1, mColumnObjects[i]->GetVertexBuffer(), &stride, &offset);
-		mImmediateContext->IASetIndexBuffer(*mColumnObjects[i]->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
-
-		mImmediateContext->DrawIndexed(mColumnObjects[i]->GetIndexCount(), 0, 0);
+		// Compute ViewProj matrix of the cascade
+		const GShadowCascades::Cascade& cascade = mShadowCascades.GetCascade(c);
+		DirectX::XMMATRIX viewProj = XMMatrixMultiply(XMLoadFloat4x4(&cascade.View), XMLoadFloat4x4(&cascade.Proj));
+
+		DirectX::XMFLOAT4X4 viewProjF;
+		DirectX::XMStoreFloat4x4(&viewProjF, viewProj);
+
+		bool bDynamic = false;
+		for (UINT i = 0; i < mShadowCasters.size() && !bDynamic; ++i)
+		{
+			bDynamic = !mShadowCasters[i].bStatic && mShadowCascades.CastsInto(c, i);
+		}
+
+		GStaticShadowCache::CascadeUpdate update = mStaticShadowCache.Update(c, viewProjF, bDynamic);
+
+		// Redraw the static layer only if the cascade moved or was invalidated
+		if (update.bRedrawStatic)
+		{
+			ID3D11DepthStencilView* staticDSV = mStaticShadowMap->GetDepthMapDSV(c);
+			mImmediateContext->OMSetRenderTargets(1, renderTargets, staticDSV);
+			mImmediateContext->ClearDepthStencilView(staticDSV, D3D11_CLEAR_DEPTH, 1.0f, 0);
+
+			DrawShadowCasters(true, c, viewProj);
+		}
+
+		// Start the cascade from the static layer, unless it already holds exactly that
+		if (update.bCopyStatic)
+		{
+			mImmediateContext->OMSetRenderTargets(0, nullptr, nullptr);
+
+			UINT subresource = D3D11CalcSubresource(0, c, 1);
+			mImmediateContext->CopySubresourceRegion(mShadowMap->GetDepthMap(), subresource, 0, 0, 0,
+				mStaticShadowMap->GetDepthMap(), subresource, nullptr);
+		}
+
+		// Composite the dynamic casters on top
+		if (update.bDrawDynamic)
+		{
+			mImmediateContext->OMSetRenderTargets(1, renderTargets, mShadowMap->GetDepthMapDSV(c));
+
+			DrawShadowCasters(false, c, viewProj);
+		}
 	}
 
-	// Draw the spheres.
-	for (int i = 0; i < 10; ++i)
+	// Report the draws saved by culling and caching next to the frame stats.
+	UINT drawsSkipped = static_cast<UINT>(mShadowCasters.size()) * mShadowCascades.GetCascadeCount() - mShadowDrawCount;
+	if (drawsSkipped != mShadowDrawsSkipped)
 	{
-		world = DirectX::XMLoadFloat4x4(&mSphereObjects[i]->GetWorldTransform());
-		worldViewProj = world*viewProj;
-
-		mImmediateContext->Map(mConstBufferPerObjectShadow, 0, D3D11_MAP_WRITE_DISCARD, 0, &cbPerObjectShadowResource);
-		cbPerObjectShadow = (ConstBufferPerObjectShadow*)cbPerObjectShadowResource.pData;
-		cbPerObjectShadow->worldViewProj = DirectX::XMMatrixTranspose(worldViewProj);
-		mImmediateContext->Unmap(mConstBufferPerObjectShadow, 0);
-
-		mImmediateContext->IASetVertexBuffers(0, 1, mSphereObjects[i]->GetVertexBuffer(), &stride, &offset);
-		mImmediateContext->IASetIndexBuffer(*mSphereObjects[i]->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
+		mShadowDrawsSkipped = drawsSkipped;
 
-		mImmediateContext->DrawIndexed(mSphereObjects[i]->GetIndexCount(), 0, 0);
+		std::wostringstream title;
+		title << L"Shadow Map Demo    Shadow Draws Skipped: " << mShadowDrawsSkipped << L"/"
+			<< mShadowCasters.size() * mShadowCascades.GetCascadeCount();
+		mWindowTitle = title.str();
 	}
-
-	// Draw the skull.
-	world = DirectX::XMLoadFloat4x4(&mSkullObject->GetWorldTransform());
-	worldViewProj = world*viewProj;
-
-	mImmediateContext->Map(mConstBufferPerObjectShadow, 0, D3D11_MAP_WRITE_DISCARD, 0, &cbPerObjectShadowResource);
-	cbPerObjectShadow = (ConstBufferPerObjectShadow*)cbPerObjectShadowResource.pData;
-	cbPerObjectShadow->worldViewProj = DirectX::XMMatrixTranspose(worldViewProj);
-	mImmediateContext->Unmap(mConstBufferPerObjectShadow, 0);
-
-	mImmediateContext->IASetVertexBuffers(0, 1, mSkullObject->GetVertexBuffer(), &stride, &offset);
-	mImmediateContext->IASetIndexBuffer(*mSkullObject->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
-
-	mImmediateContext->DrawIndexed(mSkullObject->GetIndexCount(), 0, 0);
 }
 
 void MyApp::RenderScene()
@@ -692,6 +749,20 @@ void MyApp::RenderScene()
 	cbPerFrame->dirLight1 = mDirLights[1];
 	cbPerFrame->dirLight2 = mDirLights[2];
 	cbPerFrame->eyePosW = mCamera.GetPosition();
+
+	// Unused cascades get a split of zero, so no pixel ever selects them
+	float splits[GShadowCascades::MaxCascades] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (UINT c = 0; c < GShadowCascades::MaxCascades; ++c)
+	{
+		const GShadowCascades::Cascade& cascade = mShadowCascades.GetCascade(c);
+		cbPerFrame->shadowTransforms[c] = DirectX::XMMatrixTranspose(XMLoadFloat4x4(&cascade.ShadowTransform));
+
+		if (c < mShadowCascades.GetCascadeCount())
+		{
+			splits[c] = cascade.SplitFar;
+		}
+	}
+	cbPerFrame->cascadeSplits = DirectX::XMFLOAT4(splits[0], splits[1], splits[2], splits[3]);
 	mImmediateContext->Unmap(mConstBufferPerFrame, 0);
 
 	// Bind Constant Buffers to the Pipeline
@@ -16,6 +16,10 @@
 #include "GPlaneXZ.h"
 #include "GSky.h"
 #include "ShadowMap.h"
+#include "GShadowCascades.h"
+#include "GStaticShadowCache.h"
+#include "GTextureLoader.h"
+#include <vector>
 
 struct ConstBufferPerObjectShadow
 {
@@ -28,7 +32,6 @@ struct ConstBufferPerObject
 	DirectX::XMMATRIX worldInvTranpose;
 	DirectX::XMMATRIX worldViewProj;
 	DirectX::XMMATRIX texTransform;
-	DirectX::XMMATRIX shadowTransform;
 	Material material;
 };
 	
@@ -39,6 +42,17 @@ struct ConstBufferPerFrame
 	DirectionalLight dirLight2;
 	DirectX::XMFLOAT3 eyePosW;
 	float pad;
+	DirectX::XMMATRIX shadowTransforms[GShadowCascades::MaxCascades];
+	DirectX::XMFLOAT4 cascadeSplits;
+};
+
+// An object drawn into the shadow map.  Static casters are drawn into the cached layer; dynamic
+// ones every frame on top of a copy of it.
+struct ShadowCaster
+{
+	GObject* Object;
+	DirectX::BoundingBox LocalBounds;
+	bool bStatic;
 };
 
 struct ConstBufferPSParams
@@ -77,17 +91,20 @@ private:
 
 	void CreateVertexShaderShadow(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint);
 
-	void LoadTextureToSRV(ID3D11ShaderResourceView** srv, LPCWSTR filename);
-
 	void InitUserInput();
 	void PositionObjects();
 	void SetupStaticLights();
+	void BuildShadowCasters();
+	void UpdateCasterBounds();
+	void InvalidateStaticShadows();
 	void BuildShadowTransform();
 
 	void DrawObject(GObject* object);
 	void DrawObject(GObject* object, DirectX::XMMATRIX& transform);
 	void DrawShadow(GObject* object, DirectX::XMMATRIX& transform);
 	void Draw(GObject* object, DirectX::XMMATRIX& world, bool bShadow);
+	void DrawShadowCaster(GObject* object, DirectX::CXMMATRIX viewProj);
+	void DrawShadowCasters(bool bStatic, UINT cascade, DirectX::CXMMATRIX viewProj);
 
 	void RenderScene();
 	void RenderShadowMap();
@@ -129,10 +146,14 @@ private:
 	GSphere* mSphereObjects[10];
 	GCylinder* mColumnObjects[10];
 	GSky* mSkyObject;
+	float mSkullRotation;
 
 	// Lights
 	DirectionalLight mDirLights[3];
 
+	// Textures
+	GTextureLoader mTextureLoader;
+
 	// Camera
 	GFirstPersonCamera mCamera;
 
@@ -146,9 +167,16 @@ private:
 	float mLightRotationAngle;
 	DirectX::XMFLOAT3 mOriginalLightDir[3];
 
-	DirectX::XMFLOAT4X4 mLightView;
-	DirectX::XMFLOAT4X4 mLightProj;
-	DirectX::XMFLOAT4X4 mShadowTransform;
+	GShadowCascades mShadowCascades;
+	std::vector<ShadowCaster> mShadowCasters;
+	std::vector<DirectX::BoundingBox> mCasterBounds;
+
+	// Static casters only, per cascade, kept while the cascade's matrices stay the same.
+	ShadowMap* mStaticShadowMap;
+	GStaticShadowCache mStaticShadowCache;
+
+	UINT mShadowDrawCount;
+	UINT mShadowDrawsSkipped;
 };
 
 #endif // MYAPP_H
\ No newline at end of file
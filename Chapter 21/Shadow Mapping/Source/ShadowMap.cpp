@@ -1,11 +1,13 @@
 #include "ShadowMap.h"
 #include "D3DUtil.h"
 
-ShadowMap::ShadowMap(ID3D11Device* device, UINT width, UINT height) :
+ShadowMap::ShadowMap(ID3D11Device* device, UINT width, UINT height, UINT arraySize) :
 	mWidth(width),
 	mHeight(height),
+	mArraySize(arraySize),
+	mDepthMap(0),
 	mDepthMapSRV(0),
-	mDepthMapDSV(0)
+	mDepthMapDSVs(arraySize, nullptr)
 {
 	// Setup Viewport
 	mViewport.TopLeftX = 0.0f;
@@ -20,7 +22,7 @@ ShadowMap::ShadowMap(ID3D11Device* device, UINT width, UINT height) :
 	texDesc.Width = mWidth;
 	texDesc.Height = mHeight;
 	texDesc.MipLevels = 1;
-	texDesc.ArraySize = 1;
+	texDesc.ArraySize = mArraySize;
 	texDesc.Format = DXGI_FORMAT_R24G8_TYPELESS;
 	texDesc.SampleDesc.Count = 1;
 	texDesc.SampleDesc.Quality = 0;
@@ -29,30 +31,46 @@ ShadowMap::ShadowMap(ID3D11Device* device, UINT width, UINT height) :
 	texDesc.CPUAccessFlags = 0;
 	texDesc.MiscFlags = 0;
 
-	ID3D11Texture2D* depthMap = 0;
-	HR(device->CreateTexture2D(&texDesc, 0, &depthMap));
+	HR(device->CreateTexture2D(&texDesc, 0, &mDepthMap));
 
-	// Create Depth/Stencil View
-	D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc;
-	dsvDesc.Flags = 0;
-	dsvDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
-	dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
-	dsvDesc.Texture2D.MipSlice = 0;
-	HR(device->CreateDepthStencilView(depthMap, &dsvDesc, &mDepthMapDSV));
+	// Create a Depth/Stencil View per slice
+	for (UINT i = 0; i < mArraySize; ++i)
+	{
+		D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc;
+		dsvDesc.Flags = 0;
+		dsvDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+		dsvDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+		dsvDesc.Texture2DArray.MipSlice = 0;
+		dsvDesc.Texture2DArray.FirstArraySlice = i;
+		dsvDesc.Texture2DArray.ArraySize = 1;
+		HR(device->CreateDepthStencilView(mDepthMap, &dsvDesc, &mDepthMapDSVs[i]));
+	}
 
-	// Create Shader Resource View
+	// Create Shader Resource View over every slice
 	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
 	srvDesc.Format = DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
-	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MipLevels = texDesc.MipLevels;
-	srvDesc.Texture2D.MostDetailedMip = 0;
-	HR(device->CreateShaderResourceView(depthMap, &srvDesc, &mDepthMapSRV));
-
-	ReleaseCOM(depthMap);
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+	srvDesc.Texture2DArray.MipLevels = texDesc.MipLevels;
+	srvDesc.Texture2DArray.MostDetailedMip = 0;
+	srvDesc.Texture2DArray.FirstArraySlice = 0;
+	srvDesc.Texture2DArray.ArraySize = mArraySize;
+	HR(device->CreateShaderResourceView(mDepthMap, &srvDesc, &mDepthMapSRV));
 }
 
 ShadowMap::~ShadowMap()
 {
+	ReleaseCOM(mDepthMapSRV);
+	ReleaseCOM(mDepthMap);
+
+	for (UINT i = 0; i < mArraySize; ++i)
+	{
+		ReleaseCOM(mDepthMapDSVs[i]);
+	}
+}
+
+ID3D11Texture2D* ShadowMap::GetDepthMap()
+{
+	return mDepthMap;
 }
 
 ID3D11ShaderResourceView* ShadowMap::GetDepthMapSRV()
@@ -60,9 +78,9 @@ ID3D11ShaderResourceView* ShadowMap::GetDepthMapSRV()
 	return mDepthMapSRV;
 }
 
-ID3D11DepthStencilView* ShadowMap::GetDepthMapDSV()
+ID3D11DepthStencilView* ShadowMap::GetDepthMapDSV(UINT slice)
 {
-	return mDepthMapDSV;
+	return mDepthMapDSVs[slice];
 }
 
 D3D11_VIEWPORT ShadowMap::GetViewport()
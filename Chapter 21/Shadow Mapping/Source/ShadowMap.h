@@ -2,17 +2,23 @@
 #define SHADOWMAP_H
 
 #include "D3D11.h"
+#include <vector>
 
+// A texture array of depth maps, one slice per shadow cascade.  The shaders read it through one
+// Texture2DArray view; each slice is rendered through its own depth/stencil view.
 class ShadowMap
 {
 public:
-	ShadowMap(ID3D11Device* device, UINT width, UINT height);
+	ShadowMap(ID3D11Device* device, UINT width, UINT height, UINT arraySize = 1);
 	~ShadowMap();
 
+	ID3D11Texture2D* GetDepthMap();
 	ID3D11ShaderResourceView* GetDepthMapSRV();
-	ID3D11DepthStencilView* GetDepthMapDSV();
+	ID3D11DepthStencilView* GetDepthMapDSV(UINT slice = 0);
 	D3D11_VIEWPORT GetViewport();
 
+	inline UINT GetArraySize() const { return mArraySize; }
+
 private:
 	ShadowMap(const ShadowMap& rhs);
 	ShadowMap& operator=(const ShadowMap& rhs);
@@ -20,9 +26,11 @@ private:
 private:
 	UINT mWidth;
 	UINT mHeight;
+	UINT mArraySize;
 
+	ID3D11Texture2D* mDepthMap;
 	ID3D11ShaderResourceView* mDepthMapSRV;
-	ID3D11DepthStencilView* mDepthMapDSV;
+	std::vector<ID3D11DepthStencilView*> mDepthMapDSVs;
 
 	D3D11_VIEWPORT mViewport;
 };
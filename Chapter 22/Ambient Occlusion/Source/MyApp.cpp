@@ -5,7 +5,11 @@
 #include "MyApp.h"
 #include "GeometryGenerator.h"
 #include "MathHelper.h"
-#include "D3DCompiler.h"
+#include "GPipelineBuilder.h"
+#include "GTextureCache.h"
+
+#include <algorithm>
+#include <sstream>
 
 MyApp::MyApp(HINSTANCE Instance) :
 	D3DApp(Instance),
@@ -69,6 +73,9 @@ MyApp::~MyApp()
 	delete mBoxObject;
 	delete [] &mSphereObjects;
 	delete [] &mColumnObjects;
+
+	// Drop the cache's references before the device goes away.
+	GTextureCache::Get().Clear();
 }
 
 bool MyApp::Init()
@@ -117,23 +124,7 @@ bool MyApp::Init()
 	PositionObjects();
 
 	// Compile Shaders
-	CreateVertexShader(&mVertexShader, L"Shaders/VertexShader.hlsl", "VS");
-	CreatePixelShader(&mPixelShader, L"Shaders/PixelShader.hlsl", "PS");
-
-	CreateVertexShader(&mSkyVertexShader, L"Shaders/SkyVertexShader.hlsl", "VS");
-	CreatePixelShader(&mSkyPixelShader, L"Shaders/SkyPixelShader.hlsl", "PS");
-
-	CreateVertexShaderNormalDepth(&mNormalDepthVS, L"Shaders/NormalDepthVS.hlsl", "VS");
-	CreatePixelShader(&mNormalDepthPS, L"Shaders/NormalDepthPS.hlsl", "PS");
-
-	CreateVertexShaderSSAO(&mSsaoVS, L"Shaders/SSAOVS.hlsl", "VS");
-	CreatePixelShader(&mSsaoPS, L"Shaders/SSAOPS.hlsl", "PS");
-
-	CreateVertexShaderSSAO(&mBlurVS, L"Shaders/BlurVS.hlsl", "VS");
-	CreatePixelShader(&mBlurPS, L"Shaders/BlurPS.hlsl", "PS");
-
-	CreateVertexShaderSSAO(&mDebugTextureVS, L"Shaders/DebugTextureVS.hlsl", "VS");
-	CreatePixelShader(&mDebugTexturePS, L"Shaders/DebugTexturePS.hlsl", "PS");
+	BuildShaders();
 
 	// Create Constant Buffers
 	CreateConstantBuffer(&mConstBufferPerFrame, sizeof(ConstBufferPerFrame));
@@ -151,6 +142,7 @@ bool MyApp::Init()
 	BuildFullScreenQuad();
 	BuildRandomVectorTexture();
 	mAOSetting = true;
+	mCompareSSAO = false;
 
 	return true;
 }
@@ -294,14 +286,8 @@ void MyApp::PositionObjects()
 	LoadTextureToSRV(mSkyObject->GetDiffuseMapSRV(), L"Textures/grasscube1024.dds");
 }
 
-void MyApp::CreateVertexShader(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint)
+void MyApp::BuildShaders()
 {
-	ID3DBlob* VSByteCode = 0;
-	HR(D3DCompileFromFile(filename, 0, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, "vs_5_0", D3DCOMPILE_DEBUG, 0, &VSByteCode, 0));
-
-	HR(mDevice->CreateVertexShader(VSByteCode->GetBufferPointer(), VSByteCode->GetBufferSize(), NULL, shader));
-
-	// Create the vertex input layout.
 	D3D11_INPUT_ELEMENT_DESC vertexDesc[] =
 	{
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,  D3D11_INPUT_PER_VERTEX_DATA, 0 },
@@ -310,74 +296,54 @@ void MyApp::CreateVertexShader(ID3D11VertexShader** shader, LPCWSTR filename, LP
 		{ "TANGENT",  0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 32, D3D11_INPUT_PER_VERTEX_DATA, 0 }
 	};
 
-	UINT numElements = sizeof(vertexDesc) / sizeof(D3D11_INPUT_ELEMENT_DESC);
-
-	// Create the input layout
-	HR(mDevice->CreateInputLayout(vertexDesc, numElements, VSByteCode->GetBufferPointer(), VSByteCode->GetBufferSize(), &mVertexLayout));
-
-	VSByteCode->Release();
-}
-
-void MyApp::CreateVertexShaderNormalDepth(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint)
-{
-	ID3DBlob* VSByteCode = 0;
-	HR(D3DCompileFromFile(filename, 0, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, "vs_5_0", D3DCOMPILE_DEBUG, 0, &VSByteCode, 0));
-
-	HR(mDevice->CreateVertexShader(VSByteCode->GetBufferPointer(), VSByteCode->GetBufferSize(), NULL, shader));
-
-	// Create the vertex input layout.
-	D3D11_INPUT_ELEMENT_DESC vertexDesc[] =
+	D3D11_INPUT_ELEMENT_DESC normalDepthDesc[] =
 	{
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,  D3D11_INPUT_PER_VERTEX_DATA, 0 },
 		{ "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 	};
 
-	UINT numElements = sizeof(vertexDesc) / sizeof(D3D11_INPUT_ELEMENT_DESC);
-
-	// Create the input layout
-	HR(mDevice->CreateInputLayout(vertexDesc, numElements, VSByteCode->GetBufferPointer(), VSByteCode->GetBufferSize(), &mVertexLayoutNormalDepth));
-
-	VSByteCode->Release();
-}
-
-void MyApp::CreateVertexShaderSSAO(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint)
-{
-	ID3DBlob* VSByteCode = 0;
-	HR(D3DCompileFromFile(filename, 0, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, "vs_5_0", D3DCOMPILE_DEBUG, 0, &VSByteCode, 0));
-
-	HR(mDevice->CreateVertexShader(VSByteCode->GetBufferPointer(), VSByteCode->GetBufferSize(), NULL, shader));
-
-	// Create the vertex input layout.
-	D3D11_INPUT_ELEMENT_DESC vertexDesc[] =
+	D3D11_INPUT_ELEMENT_DESC ssaoDesc[] =
 	{
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,  D3D11_INPUT_PER_VERTEX_DATA, 0 },
 		{ "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 	};
 
-	UINT numElements = sizeof(vertexDesc) / sizeof(D3D11_INPUT_ELEMENT_DESC);
+	UINT numVertexElements = sizeof(vertexDesc) / sizeof(D3D11_INPUT_ELEMENT_DESC);
+	UINT numNormalDepthElements = sizeof(normalDepthDesc) / sizeof(D3D11_INPUT_ELEMENT_DESC);
+	UINT numSsaoElements = sizeof(ssaoDesc) / sizeof(D3D11_INPUT_ELEMENT_DESC);
 
-	// Create the input layout
-	HR(mDevice->CreateInputLayout(vertexDesc, numElements, VSByteCode->GetBufferPointer(), VSByteCode->GetBufferSize(), &mVertexLayoutSSAO));
+	// Each input layout is created once, against the first shader that uses it.
+	GPipelineBuilder builder;
 
-	VSByteCode->Release();
-}
+	builder.AddVertexShader(&mVertexShader, L"Shaders/VertexShader.hlsl", "VS", vertexDesc, numVertexElements, &mVertexLayout);
+	builder.AddPixelShader(&mPixelShader, L"Shaders/PixelShader.hlsl", "PS");
 
-void MyApp::CreatePixelShader(ID3D11PixelShader** shader, LPCWSTR filename, LPCSTR entryPoint)
-{
-	ID3DBlob* PSByteCode = 0;
-	HR(D3DCompileFromFile(filename, 0, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, "ps_5_0", D3DCOMPILE_DEBUG, 0, &PSByteCode, 0));
+	builder.AddVertexShader(&mSkyVertexShader, L"Shaders/SkyVertexShader.hlsl", "VS");
+	builder.AddPixelShader(&mSkyPixelShader, L"Shaders/SkyPixelShader.hlsl", "PS");
+
+	builder.AddVertexShader(&mNormalDepthVS, L"Shaders/NormalDepthVS.hlsl", "VS", normalDepthDesc, numNormalDepthElements, &mVertexLayoutNormalDepth);
+	builder.AddPixelShader(&mNormalDepthPS, L"Shaders/NormalDepthPS.hlsl", "PS");
+
+	builder.AddVertexShader(&mSsaoVS, L"Shaders/SSAOVS.hlsl", "VS", ssaoDesc, numSsaoElements, &mVertexLayoutSSAO);
+	builder.AddPixelShader(&mSsaoPS, L"Shaders/SSAOPS.hlsl", "PS");
+
+	builder.AddVertexShader(&mBlurVS, L"Shaders/BlurVS.hlsl", "VS");
+	builder.AddPixelShader(&mBlurPS, L"Shaders/BlurPS.hlsl", "PS");
 
-	HR(mDevice->CreatePixelShader(PSByteCode->GetBufferPointer(), PSByteCode->GetBufferSize(), NULL, shader));
+	builder.AddVertexShader(&mDebugTextureVS, L"Shaders/DebugTextureVS.hlsl", "VS");
+	builder.AddPixelShader(&mDebugTexturePS, L"Shaders/DebugTexturePS.hlsl", "PS");
 
-	PSByteCode->Release();
+	bool bBuilt = builder.Build(mDevice);
+
+	OutputDebugStringW(builder.GetReport().c_str());
+	HR(bBuilt ? S_OK : E_FAIL);
 }
 
 void MyApp::LoadTextureToSRV(ID3D11ShaderResourceView** SRV, LPCWSTR filename)
 {
-	ID3D11Resource* texResource = nullptr;
-	HR(DirectX::CreateDDSTextureFromFile(mDevice, filename, &texResource, SRV));
-	ReleaseCOM(texResource); // view saves reference
+	// Objects that use the same file share one texture.
+	HR(GTextureCache::Get().Acquire(mDevice, filename, SRV));
 }
 
 void MyApp::CreateConstantBuffer(ID3D11Buffer** buffer, UINT size)
@@ -540,6 +506,10 @@ void MyApp::OnKeyDown(WPARAM key, LPARAM info)
 	{
 		mAOSetting = false;
 	}
+	else if (key == 0x33)
+	{
+		mCompareSSAO = true;
+	}
 }
 
 void MyApp::SetupNormalDepth()
@@ -639,35 +609,9 @@ void MyApp::BuildFrustumCorners()
 
 void MyApp::BuildOffsetVectors()
 {
-	mOffsets[0] = DirectX::XMFLOAT4(+1.0f, +1.0f, +1.0f, 0.0f);
-	mOffsets[1] = DirectX::XMFLOAT4(-1.0f, -1.0f, -1.0f, 0.0f);
-
-	mOffsets[2] = DirectX::XMFLOAT4(+1.0f, +1.0f, -1.0f, 0.0f);
-	mOffsets[3] = DirectX::XMFLOAT4(-1.0f, -1.0f, +1.0f, 0.0f);
-
-	mOffsets[4] = DirectX::XMFLOAT4(+1.0f, -1.0f, +1.0f, 0.0f);
-	mOffsets[5] = DirectX::XMFLOAT4(-1.0f, +1.0f, -1.0f, 0.0f);
-
-	mOffsets[6] = DirectX::XMFLOAT4(-1.0f, +1.0f, +1.0f, 0.0f);
-	mOffsets[7] = DirectX::XMFLOAT4(+1.0f, -1.0f, -1.0f, 0.0f);
-
-	mOffsets[8] = DirectX::XMFLOAT4(-1.0f, 0.0f, 0.0f, 0.0f);
-	mOffsets[9] = DirectX::XMFLOAT4(+1.0f, 0.0f, 0.0f, 0.0f);
-
-	mOffsets[10] = DirectX::XMFLOAT4(0.0f, +1.0f, 0.0f, 0.0f);
-	mOffsets[11] = DirectX::XMFLOAT4(0.0f, -1.0f, 0.0f, 0.0f);
-
-	mOffsets[12] = DirectX::XMFLOAT4(0.0f, 0.0f, +1.0f, 0.0f);
-	mOffsets[13] = DirectX::XMFLOAT4(0.0f, 0.0f, -1.0f, 0.0f);
-
-	// TODO: Add Random Offsets
-	for (int i = 0; i < 14; ++i)
-	{
-		DirectX::XMVECTOR v = DirectX::XMVector2Normalize(DirectX::XMLoadFloat4(&mOffsets[i]));
-		float s = MathHelper::RandF(0.25, 1.0f);
-		v = DirectX::XMVectorScale(v, s);
-		DirectX::XMStoreFloat4(&mOffsets[i], v);
-	}
+	// Shared with the CPU reference so both sample the same points.
+	GSoftSsao::BuildOffsetVectors(0, mOffsets);
+	mSoftSsao.SetOffsetVectors(mOffsets);
 }
 
 void MyApp::BuildFullScreenQuad()
@@ -726,8 +670,8 @@ void MyApp::BuildFullScreenQuad()
 void MyApp::BuildRandomVectorTexture()
 {
 	D3D11_TEXTURE2D_DESC texDesc;
-	texDesc.Width = 256;
-	texDesc.Height = 256;
+	texDesc.Width = GSoftSsao::RandomVectorMapSize;
+	texDesc.Height = GSoftSsao::RandomVectorMapSize;
 	texDesc.MipLevels = 1;
 	texDesc.ArraySize = 1;
 	texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -738,21 +682,13 @@ void MyApp::BuildRandomVectorTexture()
 	texDesc.CPUAccessFlags = 0;
 	texDesc.MiscFlags = 0;
 
-	D3D11_SUBRESOURCE_DATA initData = { 0 };
-	initData.SysMemPitch = 256 * sizeof(DirectX::PackedVector::XMCOLOR);
-
-	DirectX::PackedVector::XMCOLOR color[256 * 256];
-	for (int i = 0; i < 256; ++i)
-	{
-		for (int j = 0; j < 256; ++j)
-		{
-			DirectX::XMFLOAT3 v(MathHelper::RandF(), MathHelper::RandF(), MathHelper::RandF());
-
-			color[i * 256 + j] = DirectX::PackedVector::XMCOLOR(v.x, v.y, v.z, 0.0f);
-		}
-	}
+	std::vector<uint8_t> randomVectors;
+	GSoftSsao::BuildRandomVectors(0, randomVectors);
+	mSoftSsao.SetRandomVectors(randomVectors.data());
 
-	initData.pSysMem = color;
+	D3D11_SUBRESOURCE_DATA initData = { 0 };
+	initData.SysMemPitch = GSoftSsao::RandomVectorMapSize * 4;
+	initData.pSysMem = randomVectors.data();
 
 	ID3D11Texture2D* randomVectorTex = 0;
 	HR(mDevice->CreateTexture2D(&texDesc, &initData, &randomVectorTex));
@@ -1221,6 +1157,89 @@ void MyApp::DrawSSAOMap()
 	mImmediateContext->DrawIndexed(6, 0, 0);
 }
 
+ID3D11Texture2D* MyApp::CreateStagingCopy(ID3D11ShaderResourceView* srv)
+{
+	ID3D11Resource* resource = 0;
+	srv->GetResource(&resource);
+
+	ID3D11Texture2D* texture = 0;
+	HR(resource->QueryInterface(__uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&texture)));
+
+	D3D11_TEXTURE2D_DESC stagingDesc;
+	texture->GetDesc(&stagingDesc);
+	stagingDesc.Usage = D3D11_USAGE_STAGING;
+	stagingDesc.BindFlags = 0;
+	stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	stagingDesc.MiscFlags = 0;
+
+	ID3D11Texture2D* staging = 0;
+	HR(mDevice->CreateTexture2D(&stagingDesc, 0, &staging));
+	mImmediateContext->CopyResource(staging, texture);
+
+	ReleaseCOM(texture);
+	ReleaseCOM(resource);
+
+	return staging;
+}
+
+void MyApp::CompareSSAOWithReference()
+{
+	// Read back this frame's normal/depth map and the unblurred SSAO map.
+	ID3D11Texture2D* normalDepthStaging = CreateStagingCopy(mNormalDepthSRV);
+	ID3D11Texture2D* ssaoStaging = CreateStagingCopy(mSsaoSRV0);
+
+	UINT width = mClientWidth;
+	UINT height = mClientHeight;
+
+	std::vector<DirectX::XMFLOAT4> normalDepth(width * height);
+	std::vector<float> gpuMap(width * height);
+
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	HR(mImmediateContext->Map(normalDepthStaging, 0, D3D11_MAP_READ, 0, &mapped));
+	for (UINT y = 0; y < height; ++y)
+	{
+		const DirectX::PackedVector::HALF* row = reinterpret_cast<const DirectX::PackedVector::HALF*>(static_cast<const uint8_t*>(mapped.pData) + y * mapped.RowPitch);
+		DirectX::PackedVector::XMConvertHalfToFloatStream(&normalDepth[y * width].x, sizeof(float), row, sizeof(DirectX::PackedVector::HALF), width * 4);
+	}
+	mImmediateContext->Unmap(normalDepthStaging, 0);
+
+	HR(mImmediateContext->Map(ssaoStaging, 0, D3D11_MAP_READ, 0, &mapped));
+	for (UINT y = 0; y < height; ++y)
+	{
+		const DirectX::PackedVector::HALF* row = reinterpret_cast<const DirectX::PackedVector::HALF*>(static_cast<const uint8_t*>(mapped.pData) + y * mapped.RowPitch);
+		DirectX::PackedVector::XMConvertHalfToFloatStream(&gpuMap[y * width], sizeof(float), row, sizeof(DirectX::PackedVector::HALF), width);
+	}
+	mImmediateContext->Unmap(ssaoStaging, 0);
+
+	ReleaseCOM(normalDepthStaging);
+	ReleaseCOM(ssaoStaging);
+
+	std::vector<float> cpuMap;
+	mSoftSsao.Compute(normalDepth.data(), width, height, mCamera.Proj(), mCamera.GetFarZ(), false, cpuMap);
+
+	// The GPU map is stored as 16-bit floats, so differences below about 1e-3 are rounding.
+	float maxDiff = 0.0f;
+	double sumDiff = 0.0;
+	UINT mismatches = 0;
+	for (UINT i = 0; i < width * height; ++i)
+	{
+		float diff = fabsf(cpuMap[i] - gpuMap[i]);
+		maxDiff = (std::max)(maxDiff, diff);
+		sumDiff += diff;
+		if (diff > 1.0f / 255.0f)
+		{
+			++mismatches;
+		}
+	}
+
+	std::wostringstream message;
+	message << L"SSAO reference: max diff " << maxDiff
+		<< L", mean diff " << sumDiff / (width * height)
+		<< L", " << mismatches << L" pixels off by more than 1/255"
+		<< L", " << mSoftSsao.GetComputeTime() << L" ms (" << mSoftSsao.GetMegapixelsPerSecond() << L" MP/s)\n";
+	OutputDebugStringW(message.str().c_str());
+}
+
 void MyApp::DrawScene()
 {
 	// Render Scene Normals and Depth
@@ -1229,6 +1248,12 @@ void MyApp::DrawScene()
 	// Render SSAO Map
 	RenderSSAOMap();
 
+	if (mCompareSSAO)
+	{
+		CompareSSAOWithReference();
+		mCompareSSAO = false;
+	}
+
 	// Blur SSAO Map
 	BlurSSAOMap(4);
 
@@ -15,6 +15,7 @@
 #include "GCylinder.h"
 #include "GPlaneXZ.h"
 #include "GSky.h"
+#include "GSoftSsao.h"
 
 struct ConstBufferPerObjectDebug
 {
@@ -93,11 +94,7 @@ private:
 	void CreateGeometryBuffers(GObject* obj, bool dynamic = false);
 	void CreateConstantBuffer(ID3D11Buffer** buffer, UINT size);
 
-	void CreateVertexShader(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint);
-	void CreatePixelShader(ID3D11PixelShader** shader, LPCWSTR filename, LPCSTR entryPoint);
-
-	void CreateVertexShaderNormalDepth(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint);
-	void CreateVertexShaderSSAO(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint);
+	void BuildShaders();
 
 	void LoadTextureToSRV(ID3D11ShaderResourceView** srv, LPCWSTR filename);
 
@@ -124,6 +121,9 @@ private:
 	void BuildFullScreenQuad();
 	void BuildRandomVectorTexture();
 
+	void CompareSSAOWithReference();
+	ID3D11Texture2D* CreateStagingCopy(ID3D11ShaderResourceView* srv);
+
 private:
 	// Constant Buffers
 	ID3D11Buffer* mConstBufferPerFrame;
@@ -213,6 +213,10 @@ private:
 	ID3D11ShaderResourceView* mRandomVectorSRV;
 
 	bool mAOSetting;
+
+	// CPU reference, run against the GPU map when '3' is pressed.
+	GSoftSsao mSoftSsao;
+	bool mCompareSSAO;
 };
 
 #endif // MYAPP_H
\ No newline at end of file
@@ -19,9 +19,17 @@
 //--------------------------------------------------------------------------------------
 
 #include <assert.h>
+#include <stdlib.h>
 #include <algorithm>
 #include <memory>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "DDSTextureLoader.h"
 
 #if !defined(NO_D3D11_DEBUG_NAME) && ( defined(_DEBUG) || defined(PROFILE) )
@@ -122,11 +130,13 @@ struct DDS_HEADER_DXT10
 namespace
 {
 
+#if defined(_WIN32)
 struct handle_closer { void operator()(HANDLE h) { if (h) CloseHandle(h); } };
 
 typedef public std::unique_ptr<void, handle_closer> ScopedHandle;
 
 inline HANDLE safe_handle( HANDLE h ) { return (h == INVALID_HANDLE_VALUE) ? 0 : h; }
+#endif
 
 template<UINT TNameLength>
 inline void SetDebugObjectName(_In_ ID3D11DeviceChild* resource, _In_ const char (&name)[TNameLength])
@@ -142,18 +152,84 @@ inline void SetDebugObjectName(_In_ ID3D11DeviceChild* resource, _In_ const char
 };
 
 //--------------------------------------------------------------------------------------
-static HRESULT LoadTextureDataFromFile( _In_z_ const wchar_t* fileName,
-                                        std::unique_ptr<uint8_t[]>& ddsData,
-                                        DDS_HEADER** header,
-                                        uint8_t** bitData,
-                                        size_t* bitSize
-                                      )
+// Validates the DDS headers in place and locates the pixel data that follows them
+//--------------------------------------------------------------------------------------
+static HRESULT ParseDDSData( _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                             _In_ size_t ddsDataSize,
+                             _Outptr_ const DDS_HEADER** header,
+                             _Outptr_ const uint8_t** bitData,
+                             _Out_ size_t* bitSize
+                           )
 {
-    if (!header || !bitData || !bitSize)
+    if (!ddsData || !header || !bitData || !bitSize)
     {
         return E_POINTER;
     }
 
+    // Need at least enough data to fill the header and magic number to be a valid DDS
+    if (ddsDataSize < ( sizeof(DDS_HEADER) + sizeof(uint32_t) ) )
+    {
+        return E_FAIL;
+    }
+
+    // DDS files always start with the same magic number ("DDS ")
+    uint32_t dwMagicNumber = *( const uint32_t* )( ddsData );
+    if (dwMagicNumber != DDS_MAGIC)
+    {
+        return E_FAIL;
+    }
+
+    auto hdr = reinterpret_cast<const DDS_HEADER*>( ddsData + sizeof( uint32_t ) );
+
+    // Verify header to validate DDS file
+    if (hdr->size != sizeof(DDS_HEADER) ||
+        hdr->ddspf.size != sizeof(DDS_PIXELFORMAT))
+    {
+        return E_FAIL;
+    }
+
+    // Check for DX10 extension
+    bool bDXT10Header = false;
+    if ((hdr->ddspf.flags & DDS_FOURCC) &&
+        (MAKEFOURCC( 'D', 'X', '1', '0' ) == hdr->ddspf.fourCC))
+    {
+        // Must be long enough for both headers and magic value
+        if (ddsDataSize < ( sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10) ) )
+        {
+            return E_FAIL;
+        }
+
+        bDXT10Header = true;
+    }
+
+    // setup the pointers in the process request
+    *header = hdr;
+    size_t offset = sizeof( uint32_t ) + sizeof( DDS_HEADER )
+                    + (bDXT10Header ? sizeof( DDS_HEADER_DXT10 ) : 0);
+    *bitData = ddsData + offset;
+    *bitSize = ddsDataSize - offset;
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Maps a whole file read-only.  The pixel data is paged in on demand straight from the
+// file cache, so nothing is copied and files over 4 GB work in 64-bit builds.
+//--------------------------------------------------------------------------------------
+static HRESULT MapDDSFile( _In_z_ const wchar_t* fileName,
+                           std::shared_ptr<const uint8_t>& ddsData,
+                           _Out_ size_t* ddsDataSize
+                         )
+{
+    if (!fileName || !ddsDataSize)
+    {
+        return E_POINTER;
+    }
+
+    *ddsDataSize = 0;
+
+#if defined(_WIN32)
     // open the file
 #if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
     ScopedHandle hFile( safe_handle( CreateFile2( fileName,
@@ -190,83 +266,97 @@ static HRESULT LoadTextureDataFromFile( _In_z_ const wchar_t* fileName,
     GetFileSizeEx( hFile.get(), &FileSize );
 #endif
 
-    // File is too big for 32-bit allocation, so reject read
-    if (FileSize.HighPart > 0)
+    // A 32-bit process cannot map more than its address space
+    if (static_cast<uint64_t>( FileSize.QuadPart ) > SIZE_MAX)
     {
-        return E_FAIL;
+        return HRESULT_FROM_WIN32( ERROR_FILE_TOO_LARGE );
     }
 
     // Need at least enough data to fill the header and magic number to be a valid DDS
-    if (FileSize.LowPart < ( sizeof(DDS_HEADER) + sizeof(uint32_t) ) )
+    if (static_cast<uint64_t>( FileSize.QuadPart ) < ( sizeof(DDS_HEADER) + sizeof(uint32_t) ) )
     {
         return E_FAIL;
     }
 
-    // create enough space for the file data
-    ddsData.reset( new (std::nothrow) uint8_t[ FileSize.LowPart ] );
-    if (!ddsData)
+    ScopedHandle hMapping( CreateFileMappingW( hFile.get(), nullptr, PAGE_READONLY, 0, 0, nullptr ) );
+    if ( !hMapping )
     {
-        return E_OUTOFMEMORY;
+        return HRESULT_FROM_WIN32( GetLastError() );
     }
 
-    // read the data in
-    DWORD BytesRead = 0;
-    if (!ReadFile( hFile.get(),
-                   ddsData.get(),
-                   FileSize.LowPart,
-                   &BytesRead,
-                   nullptr
-                 ))
+    // The view keeps the file and mapping alive after their handles close
+    auto view = static_cast<const uint8_t*>( MapViewOfFile( hMapping.get(), FILE_MAP_READ, 0, 0, 0 ) );
+    if ( !view )
     {
         return HRESULT_FROM_WIN32( GetLastError() );
     }
 
-    if (BytesRead < FileSize.LowPart)
+    ddsData.reset( view, []( const uint8_t* p ) { UnmapViewOfFile( p ); } );
+    *ddsDataSize = static_cast<size_t>( FileSize.QuadPart );
+#else
+    char path[4096];
+    size_t pathLength = wcstombs( path, fileName, sizeof(path) );
+    if (pathLength == static_cast<size_t>( -1 ) || pathLength >= sizeof(path))
     {
-        return E_FAIL;
+        return E_INVALIDARG;
     }
 
-    // DDS files always start with the same magic number ("DDS ")
-    uint32_t dwMagicNumber = *( const uint32_t* )( ddsData.get() );
-    if (dwMagicNumber != DDS_MAGIC)
+    int fd = open( path, O_RDONLY );
+    if (fd < 0)
     {
         return E_FAIL;
     }
 
-    auto hdr = reinterpret_cast<DDS_HEADER*>( ddsData.get() + sizeof( uint32_t ) );
-
-    // Verify header to validate DDS file
-    if (hdr->size != sizeof(DDS_HEADER) ||
-        hdr->ddspf.size != sizeof(DDS_PIXELFORMAT))
+    struct stat fileInfo;
+    if (fstat( fd, &fileInfo ) != 0 ||
+        static_cast<uint64_t>( fileInfo.st_size ) > SIZE_MAX ||
+        static_cast<uint64_t>( fileInfo.st_size ) < ( sizeof(DDS_HEADER) + sizeof(uint32_t) ))
     {
+        close( fd );
         return E_FAIL;
     }
 
-    // Check for DX10 extension
-    bool bDXT10Header = false;
-    if ((hdr->ddspf.flags & DDS_FOURCC) &&
-        (MAKEFOURCC( 'D', 'X', '1', '0' ) == hdr->ddspf.fourCC))
-    {
-        // Must be long enough for both headers and magic value
-        if (FileSize.LowPart < ( sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10) ) )
-        {
-            return E_FAIL;
-        }
+    size_t fileSize = static_cast<size_t>( fileInfo.st_size );
+    void* view = mmap( nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
 
-        bDXT10Header = true;
+    if (view == MAP_FAILED)
+    {
+        return E_OUTOFMEMORY;
     }
 
-    // setup the pointers in the process request
-    *header = hdr;
-    ptrdiff_t offset = sizeof( uint32_t ) + sizeof( DDS_HEADER )
-                       + (bDXT10Header ? sizeof( DDS_HEADER_DXT10 ) : 0);
-    *bitData = ddsData.get() + offset;
-    *bitSize = FileSize.LowPart - offset;
+    ddsData.reset( static_cast<const uint8_t*>( view ), [fileSize]( const uint8_t* p ) { munmap( const_cast<uint8_t*>( p ), fileSize ); } );
+    *ddsDataSize = fileSize;
+#endif
 
     return S_OK;
 }
 
 
+//--------------------------------------------------------------------------------------
+static HRESULT LoadTextureDataFromFile( _In_z_ const wchar_t* fileName,
+                                        std::shared_ptr<const uint8_t>& ddsData,
+                                        const DDS_HEADER** header,
+                                        const uint8_t** bitData,
+                                        size_t* bitSize
+                                      )
+{
+    if (!header || !bitData || !bitSize)
+    {
+        return E_POINTER;
+    }
+
+    size_t ddsDataSize = 0;
+    HRESULT hr = MapDDSFile( fileName, ddsData, &ddsDataSize );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    return ParseDDSData( ddsData.get(), ddsDataSize, header, bitData, bitSize );
+}
+
+
 //--------------------------------------------------------------------------------------
 // Return the BPP for a particular format
 //--------------------------------------------------------------------------------------
@@ -932,7 +1022,7 @@ static HRESULT CreateD3DResources( _In_ ID3D11Device* d3dDevice,
                                    _In_ unsigned int miscFlags,
                                    _In_ bool forceSRGB,
                                    _In_ bool isCubeMap,
-                                   _In_reads_opt_(mipCount*arraySize) D3D11_SUBRESOURCE_DATA* initData,
+                                   _In_reads_opt_(mipCount*arraySize) const D3D11_SUBRESOURCE_DATA* initData,
                                    _Outptr_opt_ ID3D11Resource** texture,
                                    _Outptr_opt_ ID3D11ShaderResourceView** textureView )
 {
@@ -1155,32 +1245,26 @@ static HRESULT CreateD3DResources( _In_ ID3D11Device* d3dDevice,
 
 
 //--------------------------------------------------------------------------------------
-static HRESULT CreateTextureFromDDS( _In_ ID3D11Device* d3dDevice,
-                                     _In_opt_ ID3D11DeviceContext* d3dContext,
-                                     _In_ const DDS_HEADER* header,
-                                     _In_reads_bytes_(bitSize) const uint8_t* bitData,
-                                     _In_ size_t bitSize,
-                                     _In_ size_t maxsize,
-                                     _In_ D3D11_USAGE usage,
-                                     _In_ unsigned int bindFlags,
-                                     _In_ unsigned int cpuAccessFlags,
-                                     _In_ unsigned int miscFlags,
-                                     _In_ bool forceSRGB,
-                                     _Outptr_opt_ ID3D11Resource** texture,
-                                     _Outptr_opt_ ID3D11ShaderResourceView** textureView )
+static HRESULT DecodeDDSHeader( _In_ const DDS_HEADER* header,
+                                _Out_ uint32_t& resDim,
+                                _Out_ size_t& width,
+                                _Out_ size_t& height,
+                                _Out_ size_t& depth,
+                                _Out_ size_t& mipCount,
+                                _Out_ size_t& arraySize,
+                                _Out_ DXGI_FORMAT& format,
+                                _Out_ bool& isCubeMap )
 {
-    HRESULT hr = S_OK;
+    width = header->width;
+    height = header->height;
+    depth = header->depth;
 
-    UINT width = header->width;
-    UINT height = header->height;
-    UINT depth = header->depth;
+    resDim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+    arraySize = 1;
+    format = DXGI_FORMAT_UNKNOWN;
+    isCubeMap = false;
 
-    uint32_t resDim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
-    UINT arraySize = 1;
-    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
-    bool isCubeMap = false;
-
-    size_t mipCount = header->mipMapCount;
+    mipCount = header->mipMapCount;
     if (0 == mipCount)
     {
         mipCount = 1;
@@ -1288,6 +1372,12 @@ static HRESULT CreateTextureFromDDS( _In_ ID3D11Device* d3dDevice,
         assert( BitsPerPixel( format ) != 0 );
     }
 
+    // A zero dimension lays out empty subresources that the bounds checks below would pass
+    if (width == 0 || height == 0 || depth == 0)
+    {
+        return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+    }
+
     // Bound sizes (for security purposes we don't trust DDS file metadata larger than the D3D 11.x hardware requirements)
     if (mipCount > D3D11_REQ_MIP_LEVELS)
     {
@@ -1337,6 +1427,75 @@ static HRESULT CreateTextureFromDDS( _In_ ID3D11Device* d3dDevice,
         return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
     }
 
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+static size_t GetFeatureLevelMaxsize( _In_ ID3D11Device* d3dDevice,
+                                      _In_ uint32_t resDim,
+                                      _In_ bool isCubeMap )
+{
+    switch( d3dDevice->GetFeatureLevel() )
+    {
+    case D3D_FEATURE_LEVEL_9_1:
+    case D3D_FEATURE_LEVEL_9_2:
+        if ( isCubeMap )
+        {
+            return 512 /*D3D_FL9_1_REQ_TEXTURECUBE_DIMENSION*/;
+        }
+        else
+        {
+            return (resDim == D3D11_RESOURCE_DIMENSION_TEXTURE3D)
+                   ? 256 /*D3D_FL9_1_REQ_TEXTURE3D_U_V_OR_W_DIMENSION*/
+                   : 2048 /*D3D_FL9_1_REQ_TEXTURE2D_U_OR_V_DIMENSION*/;
+        }
+
+    case D3D_FEATURE_LEVEL_9_3:
+        return (resDim == D3D11_RESOURCE_DIMENSION_TEXTURE3D)
+               ? 256 /*D3D_FL9_1_REQ_TEXTURE3D_U_V_OR_W_DIMENSION*/
+               : 4096 /*D3D_FL9_3_REQ_TEXTURE2D_U_OR_V_DIMENSION*/;
+
+    default: // D3D_FEATURE_LEVEL_10_0 & D3D_FEATURE_LEVEL_10_1
+        return (resDim == D3D11_RESOURCE_DIMENSION_TEXTURE3D)
+               ? 2048 /*D3D10_REQ_TEXTURE3D_U_V_OR_W_DIMENSION*/
+               : 8192 /*D3D10_REQ_TEXTURE2D_U_OR_V_DIMENSION*/;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+static HRESULT CreateTextureFromDDS( _In_ ID3D11Device* d3dDevice,
+                                     _In_opt_ ID3D11DeviceContext* d3dContext,
+                                     _In_ const DDS_HEADER* header,
+                                     _In_reads_bytes_(bitSize) const uint8_t* bitData,
+                                     _In_ size_t bitSize,
+                                     _In_ size_t maxsize,
+                                     _In_ D3D11_USAGE usage,
+                                     _In_ unsigned int bindFlags,
+                                     _In_ unsigned int cpuAccessFlags,
+                                     _In_ unsigned int miscFlags,
+                                     _In_ bool forceSRGB,
+                                     _Outptr_opt_ ID3D11Resource** texture,
+                                     _Outptr_opt_ ID3D11ShaderResourceView** textureView )
+{
+    HRESULT hr = S_OK;
+
+    uint32_t resDim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+    size_t width = 0;
+    size_t height = 0;
+    size_t depth = 0;
+    size_t mipCount = 0;
+    size_t arraySize = 0;
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    bool isCubeMap = false;
+
+    hr = DecodeDDSHeader( header, resDim, width, height, depth, mipCount, arraySize, format, isCubeMap );
+    if ( FAILED(hr) )
+    {
+        return hr;
+    }
+
     bool autogen = false;
     if ( mipCount == 1 && d3dContext != 0 && textureView != 0 ) // Must have context and shader-view to auto generate mipmaps
     {
@@ -1403,7 +1562,7 @@ static HRESULT CreateTextureFromDDS( _In_ ID3D11Device* d3dDevice,
             {
                 const uint8_t* pSrcBits = bitData;
                 const uint8_t* pEndBits = bitData + bitSize;
-                for( UINT item = 0; item < arraySize; ++item )
+                for( UINT item = 0; item < static_cast<UINT>( arraySize ); ++item )
                 {
                     if ( (pSrcBits + numBytes) > pEndBits )
                     {
@@ -1460,34 +1619,7 @@ static HRESULT CreateTextureFromDDS( _In_ ID3D11Device* d3dDevice,
             if ( FAILED(hr) && !maxsize && (mipCount > 1) )
             {
                 // Retry with a maxsize determined by feature level
-                switch( d3dDevice->GetFeatureLevel() )
-                {
-                case D3D_FEATURE_LEVEL_9_1:
-                case D3D_FEATURE_LEVEL_9_2:
-                    if ( isCubeMap )
-                    {
-                        maxsize = 512 /*D3D_FL9_1_REQ_TEXTURECUBE_DIMENSION*/;
-                    }
-                    else
-                    {
-                        maxsize = (resDim == D3D11_RESOURCE_DIMENSION_TEXTURE3D)
-                                  ? 256 /*D3D_FL9_1_REQ_TEXTURE3D_U_V_OR_W_DIMENSION*/
-                                  : 2048 /*D3D_FL9_1_REQ_TEXTURE2D_U_OR_V_DIMENSION*/;
-                    }
-                    break;
-
-                case D3D_FEATURE_LEVEL_9_3:
-                    maxsize = (resDim == D3D11_RESOURCE_DIMENSION_TEXTURE3D)
-                              ? 256 /*D3D_FL9_1_REQ_TEXTURE3D_U_V_OR_W_DIMENSION*/
-                              : 4096 /*D3D_FL9_3_REQ_TEXTURE2D_U_OR_V_DIMENSION*/;
-                    break;
-
-                default: // D3D_FEATURE_LEVEL_10_0 & D3D_FEATURE_LEVEL_10_1
-                    maxsize = (resDim == D3D11_RESOURCE_DIMENSION_TEXTURE3D)
-                              ? 2048 /*D3D10_REQ_TEXTURE3D_U_V_OR_W_DIMENSION*/
-                              : 8192 /*D3D10_REQ_TEXTURE2D_U_OR_V_DIMENSION*/;
-                    break;
-                }
+                maxsize = GetFeatureLevelMaxsize( d3dDevice, resDim, isCubeMap );
 
                 hr = FillInitData( width, height, depth, mipCount, arraySize, format, maxsize, bitSize, bitData,
                                    twidth, theight, tdepth, skipMip, initData.get() );
@@ -1617,48 +1749,20 @@ HRESULT DirectX::CreateDDSTextureFromMemoryEx( ID3D11Device* d3dDevice,
     }
 
     // Validate DDS file in memory
-    if (ddsDataSize < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
-    {
-        return E_FAIL;
-    }
-
-    uint32_t dwMagicNumber = *( const uint32_t* )( ddsData );
-    if (dwMagicNumber != DDS_MAGIC)
-    {
-        return E_FAIL;
-    }
-
-    auto header = reinterpret_cast<const DDS_HEADER*>( ddsData + sizeof( uint32_t ) );
-
-    // Verify header to validate DDS file
-    if (header->size != sizeof(DDS_HEADER) ||
-        header->ddspf.size != sizeof(DDS_PIXELFORMAT))
-    {
-        return E_FAIL;
-    }
+    const DDS_HEADER* header = nullptr;
+    const uint8_t* bitData = nullptr;
+    size_t bitSize = 0;
 
-    // Check for DX10 extension
-    bool bDXT10Header = false;
-    if ((header->ddspf.flags & DDS_FOURCC) &&
-        (MAKEFOURCC( 'D', 'X', '1', '0' ) == header->ddspf.fourCC) )
+    HRESULT hr = ParseDDSData( ddsData, ddsDataSize, &header, &bitData, &bitSize );
+    if (FAILED(hr))
     {
-        // Must be long enough for both headers and magic value
-        if (ddsDataSize < (sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10)))
-        {
-            return E_FAIL;
-        }
-
-        bDXT10Header = true;
+        return hr;
     }
 
-    ptrdiff_t offset = sizeof( uint32_t )
-                       + sizeof( DDS_HEADER )
-                       + (bDXT10Header ? sizeof( DDS_HEADER_DXT10 ) : 0);
-
-    HRESULT hr = CreateTextureFromDDS( d3dDevice, d3dContext, header,
-                                       ddsData + offset, ddsDataSize - offset, maxsize,
-                                       usage, bindFlags, cpuAccessFlags, miscFlags, forceSRGB,
-                                       texture, textureView );
+    hr = CreateTextureFromDDS( d3dDevice, d3dContext, header,
+                               bitData, bitSize, maxsize,
+                               usage, bindFlags, cpuAccessFlags, miscFlags, forceSRGB,
+                               texture, textureView );
     if ( SUCCEEDED(hr) )
     {
         if (texture != 0 && *texture != 0)
@@ -1756,11 +1860,11 @@ HRESULT DirectX::CreateDDSTextureFromFileEx( ID3D11Device* d3dDevice,
         return E_INVALIDARG;
     }
 
-    DDS_HEADER* header = nullptr;
-    uint8_t* bitData = nullptr;
+    const DDS_HEADER* header = nullptr;
+    const uint8_t* bitData = nullptr;
     size_t bitSize = 0;
 
-    std::unique_ptr<uint8_t[]> ddsData;
+    std::shared_ptr<const uint8_t> ddsData;
     HRESULT hr = LoadTextureDataFromFile( fileName,
                                           ddsData,
                                           &header,
@@ -1829,3 +1933,160 @@ HRESULT DirectX::CreateDDSTextureFromFileEx( ID3D11Device* d3dDevice,
 
     return hr;
 }
+
+
+//--------------------------------------------------------------------------------------
+//--------------------------------------------------------------------------------------
+static HRESULT FillTextureData( _In_ const DDS_HEADER* header,
+                                _In_reads_bytes_(bitSize) const uint8_t* bitData,
+                                _In_ size_t bitSize,
+                                _In_ size_t maxsize,
+                                DDS_TEXTURE_DATA& data )
+{
+    HRESULT hr = DecodeDDSHeader( header, data.resDim, data.width, data.height, data.depth,
+                                  data.mipCount, data.arraySize, data.format, data.isCubeMap );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    data.bitData = bitData;
+    data.bitSize = bitSize;
+    data.alphaMode = GetAlphaMode( header );
+    data.maxsize = maxsize;
+
+    // The subresources point straight into the file data; nothing is copied
+    data.initData.resize( data.mipCount * data.arraySize );
+    return FillInitData( data.width, data.height, data.depth, data.mipCount, data.arraySize, data.format, maxsize,
+                         bitSize, bitData, data.twidth, data.theight, data.tdepth, data.skipMip, data.initData.data() );
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::LoadDDSTextureDataFromMemory( const uint8_t* ddsData,
+                                               size_t ddsDataSize,
+                                               DDS_TEXTURE_DATA& data,
+                                               size_t maxsize )
+{
+    data = DDS_TEXTURE_DATA();
+
+    if (!ddsData)
+    {
+        return E_INVALIDARG;
+    }
+
+    const DDS_HEADER* header = nullptr;
+    const uint8_t* bitData = nullptr;
+    size_t bitSize = 0;
+
+    HRESULT hr = ParseDDSData( ddsData, ddsDataSize, &header, &bitData, &bitSize );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    return FillTextureData( header, bitData, bitSize, maxsize, data );
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::LoadDDSTextureDataFromFile( const wchar_t* fileName,
+                                             DDS_TEXTURE_DATA& data,
+                                             size_t maxsize )
+{
+    data = DDS_TEXTURE_DATA();
+
+    if (!fileName)
+    {
+        return E_INVALIDARG;
+    }
+
+    const DDS_HEADER* header = nullptr;
+    const uint8_t* bitData = nullptr;
+    size_t bitSize = 0;
+
+    HRESULT hr = LoadTextureDataFromFile( fileName,
+                                          data.fileData,
+                                          &header,
+                                          &bitData,
+                                          &bitSize
+                                        );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    return FillTextureData( header, bitData, bitSize, maxsize, data );
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTextureFromData( ID3D11Device* d3dDevice,
+                                           const DDS_TEXTURE_DATA& data,
+                                           D3D11_USAGE usage,
+                                           unsigned int bindFlags,
+                                           unsigned int cpuAccessFlags,
+                                           unsigned int miscFlags,
+                                           bool forceSRGB,
+                                           ID3D11Resource** texture,
+                                           ID3D11ShaderResourceView** textureView )
+{
+    if ( texture )
+    {
+        *texture = nullptr;
+    }
+    if ( textureView )
+    {
+        *textureView = nullptr;
+    }
+
+    if (!d3dDevice || !data.bitData || data.initData.empty() || (!texture && !textureView))
+    {
+        return E_INVALIDARG;
+    }
+
+    // The subresources were laid out on the loading thread; only the device calls happen here
+    HRESULT hr = CreateD3DResources( d3dDevice, data.resDim, data.twidth, data.theight, data.tdepth,
+                                     data.mipCount - data.skipMip, data.arraySize,
+                                     data.format, usage, bindFlags, cpuAccessFlags, miscFlags, forceSRGB,
+                                     data.isCubeMap, data.initData.data(), texture, textureView );
+
+    if ( FAILED(hr) && !data.maxsize && (data.mipCount > 1) )
+    {
+        // Retry with a maxsize determined by feature level
+        size_t maxsize = GetFeatureLevelMaxsize( d3dDevice, data.resDim, data.isCubeMap );
+
+        std::unique_ptr<D3D11_SUBRESOURCE_DATA[]> initData( new (std::nothrow) D3D11_SUBRESOURCE_DATA[ data.mipCount * data.arraySize ] );
+        if ( !initData )
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        size_t skipMip = 0;
+        size_t twidth = 0;
+        size_t theight = 0;
+        size_t tdepth = 0;
+        hr = FillInitData( data.width, data.height, data.depth, data.mipCount, data.arraySize, data.format, maxsize,
+                           data.bitSize, data.bitData, twidth, theight, tdepth, skipMip, initData.get() );
+        if ( SUCCEEDED(hr) )
+        {
+            hr = CreateD3DResources( d3dDevice, data.resDim, twidth, theight, tdepth, data.mipCount - skipMip, data.arraySize,
+                                     data.format, usage, bindFlags, cpuAccessFlags, miscFlags, forceSRGB,
+                                     data.isCubeMap, initData.get(), texture, textureView );
+        }
+    }
+
+    if ( SUCCEEDED(hr) )
+    {
+        if (texture != 0 && *texture != 0)
+        {
+            SetDebugObjectName(*texture, "DDSTextureLoader");
+        }
+
+        if (textureView != 0 && *textureView != 0)
+        {
+            SetDebugObjectName(*textureView, "DDSTextureLoader");
+        }
+    }
+
+    return hr;
+}
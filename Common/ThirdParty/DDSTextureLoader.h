@@ -22,6 +22,8 @@
 
 #include <d3d11_1.h>
 #include <stdint.h>
+#include <memory>
+#include <vector>
 
 
 namespace DirectX
@@ -130,4 +132,61 @@ namespace DirectX
                                         _Outptr_opt_ ID3D11ShaderResourceView** textureView,
                                         _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
                                     );
+
+    // Two-phase loading: LoadDDSTextureDataFromFile maps and validates a file and lays out
+    // its subresources without touching Direct3D, so it may run on any thread.  The result is
+    // then turned into a resource on the device's thread with CreateDDSTextureFromData.
+    // The subresources point into the mapped file, which fileData keeps alive.
+    struct DDS_TEXTURE_DATA
+    {
+        std::shared_ptr<const uint8_t>      fileData;
+        const uint8_t*                      bitData;
+        size_t                              bitSize;
+
+        uint32_t                            resDim;
+        size_t                              width;
+        size_t                              height;
+        size_t                              depth;
+        size_t                              mipCount;
+        size_t                              arraySize;
+        DXGI_FORMAT                         format;
+        bool                                isCubeMap;
+        DDS_ALPHA_MODE                      alphaMode;
+
+        // Subresources that fit within maxsize, and the top level they start at
+        size_t                              maxsize;
+        size_t                              skipMip;
+        size_t                              twidth;
+        size_t                              theight;
+        size_t                              tdepth;
+        std::vector<D3D11_SUBRESOURCE_DATA> initData;
+
+        DDS_TEXTURE_DATA() :
+            bitData(nullptr), bitSize(0), resDim(0), width(0), height(0), depth(0), mipCount(0), arraySize(0),
+            format(DXGI_FORMAT_UNKNOWN), isCubeMap(false), alphaMode(DDS_ALPHA_MODE_UNKNOWN),
+            maxsize(0), skipMip(0), twidth(0), theight(0), tdepth(0) {}
+    };
+
+    HRESULT LoadDDSTextureDataFromFile( _In_z_ const wchar_t* szFileName,
+                                        _Out_ DDS_TEXTURE_DATA& data,
+                                        _In_ size_t maxsize = 0
+                                      );
+
+    // Parses a DDS image already in memory.  Nothing is copied, so ddsData must outlive data.
+    HRESULT LoadDDSTextureDataFromMemory( _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                                          _In_ size_t ddsDataSize,
+                                          _Out_ DDS_TEXTURE_DATA& data,
+                                          _In_ size_t maxsize = 0
+                                        );
+
+    HRESULT CreateDDSTextureFromData( _In_ ID3D11Device* d3dDevice,
+                                      _In_ const DDS_TEXTURE_DATA& data,
+                                      _In_ D3D11_USAGE usage,
+                                      _In_ unsigned int bindFlags,
+                                      _In_ unsigned int cpuAccessFlags,
+                                      _In_ unsigned int miscFlags,
+                                      _In_ bool forceSRGB,
+                                      _Outptr_opt_ ID3D11Resource** texture,
+                                      _Outptr_opt_ ID3D11ShaderResourceView** textureView
+                                    );
 }
\ No newline at end of file
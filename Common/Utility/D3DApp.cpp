@@ -62,7 +62,10 @@ int D3DApp::Run()
 {
 	MSG msg = { 0 };
 
+	GPROFILE_THREAD("Main");
+
 	mTimer.Reset();
+	mFrameScheduler.Reset();
 
 	while (msg.message != WM_QUIT)
 	{
@@ -72,21 +75,36 @@ int D3DApp::Run()
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
 		}
-		// Otherwise, do animation/game stuff.
-		else
+		// Nothing to draw while paused, so sleep until the window hears something.
+		else if (mAppPaused)
+		{
+			WaitMessage();
+		}
+		// Otherwise, do animation/game stuff once the frame is due.  A message that arrives
+		// during the wait is handled first, then the wait resumes.
+		else if (mFrameScheduler.WaitForFrame())
 		{
-			mTimer.Tick();
-
-			if (!mAppPaused)
 			{
+				GPROFILE_SCOPE("Frame");
+
+				mTimer.Tick();
+
 				CalculateFrameStats();
-				UpdateScene(mTimer.DeltaTime());
+
+				// Fixed steps, however many fit in the time since the last frame; the frame is then
+				// drawn mFrameScheduler.GetAlpha() of the way from the previous step to the last.
+				UINT steps = mFrameScheduler.BeginFrame(mTimer.DeltaTime());
+				for (UINT i = 0; i < steps; ++i)
+				{
+					GPROFILE_SCOPE("UpdateScene");
+					UpdateScene(static_cast<float>(mFrameScheduler.GetStepTime()));
+				}
+
+				GPROFILE_SCOPE("DrawScene");
 				DrawScene();
 			}
-			else
-			{
-				Sleep(100);
-			}
+
+			GPROFILE_END_FRAME();
 		}
 	}
 
@@ -123,17 +141,21 @@ LRESULT D3DApp::MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 		mClientHeight = HIWORD(lParam);
 		if (mDevice)
 		{
+			// The timer stops while minimized, so the first frame after restoring does not
+			// cover the whole time the window was down.
 			if (wParam == SIZE_MINIMIZED)
 			{
 				mAppPaused = true;
 				mMinimized = true;
 				mMaximized = false;
+				mTimer.Stop();
 			}
 			else if (wParam == SIZE_MAXIMIZED)
 			{
 				mAppPaused = false;
 				mMinimized = false;
 				mMaximized = true;
+				mTimer.Start();
 				OnResize();
 			}
 			else if (wParam == SIZE_RESTORED)
@@ -143,6 +165,7 @@ LRESULT D3DApp::MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 				{
 					mAppPaused = false;
 					mMinimized = false;
+					mTimer.Start();
 					OnResize();
 				}
 
@@ -222,6 +245,15 @@ LRESULT D3DApp::MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 	case WM_CHAR:
 		OnKeyDown(wParam, lParam);
 		return 0;
+
+	// F9 saves a trace of the last few seconds and prints the per-zone summary.
+	case WM_KEYDOWN:
+		if (wParam == VK_F9)
+		{
+			WriteProfile();
+			return 0;
+		}
+		break;
 	}
 
 
@@ -533,6 +565,8 @@ bool D3DApp::InitDirect3D()
 
 	OnResize();
 
+	ApplyFrameLatency();
+
 	return true;
 }
 
@@ -697,3 +731,25 @@ void D3DApp::CalculateFrameStats()
 		timeElapsed += 1.0f;
 	}
 }
+
+void D3DApp::ApplyFrameLatency()
+{
+	// DXGI lets the CPU run up to three frames ahead of the GPU by default.  One is enough to keep
+	// the GPU fed and takes the queued frames out of the time between input and display.
+	IDXGIDevice1* dxgiDevice = 0;
+	if (SUCCEEDED(mDevice->QueryInterface(__uuidof(IDXGIDevice1), (void**)&dxgiDevice)))
+	{
+		dxgiDevice->SetMaximumFrameLatency(mFrameScheduler.IsLowLatency() ? 1 : 3);
+		ReleaseCOM(dxgiDevice);
+	}
+}
+
+void D3DApp::WriteProfile()
+{
+#if GPROFILER_ENABLED
+	std::wostringstream outs;
+	outs << GProfiler::Get().GetReport();
+	outs << (GProfiler::Get().WriteTrace(L"Profile.json") ? L"Trace written to Profile.json\n" : L"Could not write Profile.json\n");
+	OutputDebugStringW(outs.str().c_str());
+#endif
+}
\ No newline at end of file
@@ -8,6 +8,8 @@
 #include "D3D11.h"
 #include "D3DUtil.h"
 #include "GameTimer.h"
+#include "GFrameScheduler.h"
+#include "GProfiler.h"
 
 #include <Windows.h>
 #include <WindowsX.h>
@@ -47,6 +49,12 @@ protected:
 	bool InitDirect3D();
 	void CalculateFrameStats();
 
+	// Applies mFrameScheduler's low-latency setting to the device's frame queue.
+	void ApplyFrameLatency();
+
+	// Writes the profiler's trace to Profile.json and its summary to the debugger output.
+	void WriteProfile();
+
 protected:
 	HINSTANCE mAppInstance;
 	HWND mMainWindow;
@@ -67,6 +75,9 @@ protected:
 
 	GameTimer mTimer;
 
+	// Derived class may set a fixed timestep and a frame-rate cap in its constructor.
+	GFrameScheduler mFrameScheduler;
+
 	bool mAppPaused;
 	bool mMinimized;
 	bool mMaximized;
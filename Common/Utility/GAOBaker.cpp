@@ -0,0 +1,139 @@
+/*  ===============================================
+	Summary: Per-Vertex Ambient Occlusion Baker
+	===============================================  */
+
+#include "GAOBaker.h"
+#include "GMeshBVH.h"
+#include "GThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT VerticesPerJob = 64;
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	inline float GetMilliseconds(Clock::time_point start)
+	{
+		return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+	}
+
+	inline float RadicalInverse(UINT bits)
+	{
+		bits = (bits << 16) | (bits >> 16);
+		bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+		bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+		bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+		bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+		return bits * 2.3283064365386963e-10f;
+	}
+
+	// Well-mixed bits from the vertex index, for the per-vertex shift of the sample set.
+	inline UINT Hash(UINT x)
+	{
+		x ^= x >> 16;
+		x *= 0x7FEB352Du;
+		x ^= x >> 15;
+		x *= 0x846CA68Bu;
+		x ^= x >> 16;
+		return x;
+	}
+
+	inline float Wrap(float x)
+	{
+		return x >= 1.0f ? x - 1.0f : x;
+	}
+}
+
+GAOBaker::GAOBaker() :
+	mBakeTime(0.0f),
+	mRayCount(0)
+{
+}
+
+GAOBaker::~GAOBaker()
+{
+}
+
+void GAOBaker::Bake(const GMeshBVH& bvh, const XMFLOAT3* positions, const XMFLOAT3* normals,
+	UINT vertexCount, const Desc& desc, std::vector<float>& access)
+{
+	Clock::time_point start = Clock::now();
+
+	access.resize(vertexCount);
+
+	const UINT numSamples = (std::max)(desc.SampleCount, 1u);
+
+	// The unshifted sample set, shared by every vertex.
+	std::vector<XMFLOAT2> samples(numSamples);
+	for (UINT i = 0; i < numSamples; ++i)
+	{
+		samples[i] = XMFLOAT2((i + 0.5f) / numSamples, RadicalInverse(i));
+	}
+
+	GThreadPool::Get().ParallelFor(vertexCount, VerticesPerJob, [&](UINT begin, UINT end)
+	{
+		for (UINT v = begin; v < end; ++v)
+		{
+			XMFLOAT3 n = normals[v];
+			float length = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+			if (length == 0.0f)
+			{
+				access[v] = 1.0f;
+				continue;
+			}
+			n = XMFLOAT3(n.x / length, n.y / length, n.z / length);
+
+			// Branchless orthonormal basis around the normal (Duff et al. 2017).
+			float sign = n.z >= 0.0f ? 1.0f : -1.0f;
+			float a = -1.0f / (sign + n.z);
+			float b = n.x * n.y * a;
+			XMFLOAT3 t(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+			XMFLOAT3 s(b, sign + n.y * n.y * a, -n.y);
+
+			const XMFLOAT3& p = positions[v];
+			XMFLOAT3 origin(p.x + n.x * desc.Bias, p.y + n.y * desc.Bias, p.z + n.z * desc.Bias);
+
+			UINT hash = Hash(v);
+			float shiftU = (hash & 0xFFFF) / 65536.0f;
+			float shiftV = (hash >> 16) / 65536.0f;
+
+			UINT numOccluded = 0;
+			for (UINT i = 0; i < numSamples; ++i)
+			{
+				// Cosine-weighted: uniform on the disk, projected up onto the hemisphere.
+				float u = Wrap(samples[i].x + shiftU);
+				float r = sqrtf(u);
+				float phi = XM_2PI * Wrap(samples[i].y + shiftV);
+				float x = r * cosf(phi);
+				float y = r * sinf(phi);
+				float z = sqrtf((std::max)(0.0f, 1.0f - u));
+
+				XMFLOAT3 dir(
+					x * t.x + y * s.x + z * n.x,
+					x * t.y + y * s.y + z * n.y,
+					x * t.z + y * s.z + z * n.z);
+
+				if (bvh.Occluded(origin, dir, desc.MaxDistance))
+				{
+					++numOccluded;
+				}
+			}
+
+			access[v] = 1.0f - static_cast<float>(numOccluded) / numSamples;
+		}
+	});
+
+	mRayCount = static_cast<UINT64>(vertexCount) * numSamples;
+	mBakeTime = GetMilliseconds(start);
+}
+
+float GAOBaker::GetRaysPerSecond() const
+{
+	return mBakeTime > 0.0f ? mRayCount * 1000.0f / mBakeTime : 0.0f;
+}
\ No newline at end of file
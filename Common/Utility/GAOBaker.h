@@ -0,0 +1,57 @@
+/*  ===============================================
+	Summary: Per-Vertex Ambient Occlusion Baker
+	===============================================  */
+
+#ifndef GAOBAKER_H
+#define GAOBAKER_H
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <vector>
+
+class GMeshBVH;
+
+// Bakes ambient access per vertex by casting rays over the hemisphere around each vertex normal
+// against a GMeshBVH of the mesh, or of the whole scene.  Directions come from a Hammersley set
+// mapped to a cosine-weighted hemisphere, shifted per vertex so neighbours do not share the same
+// pattern, which converges far faster than independent random directions.  Vertices are spread
+// across the thread pool.
+class GAOBaker
+{
+public:
+	struct Desc
+	{
+		// Rays per vertex.
+		UINT SampleCount;
+
+		// Occluders further than this do not count.
+		float MaxDistance;
+
+		// Ray origins are pushed this far along the normal to escape the vertex's own triangles.
+		float Bias;
+	};
+
+	GAOBaker();
+	~GAOBaker();
+
+	// Writes the fraction of unoccluded rays for every vertex to access: 1 is fully open, 0 fully
+	// enclosed.  Normals need not be normalized.
+	void Bake(const GMeshBVH& bvh, const DirectX::XMFLOAT3* positions, const DirectX::XMFLOAT3* normals,
+		UINT vertexCount, const Desc& desc, std::vector<float>& access);
+
+	// Milliseconds spent in the last bake.
+	inline float GetBakeTime() const { return mBakeTime; }
+
+	inline UINT64 GetRayCount() const { return mRayCount; }
+	float GetRaysPerSecond() const;
+
+private:
+	GAOBaker(const GAOBaker&);
+	GAOBaker& operator=(const GAOBaker&);
+
+private:
+	float mBakeTime;
+	UINT64 mRayCount;
+};
+
+#endif // GAOBAKER_H
\ No newline at end of file
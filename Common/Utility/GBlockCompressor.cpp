@@ -0,0 +1,577 @@
+/*  ===============================================
+	Summary: BC1/BC3/BC5 Block Compression
+	===============================================  */
+
+#include "GBlockCompressor.h"
+#include "GThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <emmintrin.h>
+
+namespace
+{
+	const UINT BlockRowsPerRange = 2;
+
+	// Palette steps counted from endpoint 0 to the index codes that select them.  Colour
+	// blocks put their two interpolated points after the endpoints; BC4 blocks put six.
+	const uint32_t ColorCodes[4] = { 0, 2, 3, 1 };
+	const uint32_t AlphaCodes[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+
+	inline uint16_t PackRGB565(const int* c)
+	{
+		int r = (c[0] * 31 + 127) / 255;
+		int g = (c[1] * 63 + 127) / 255;
+		int b = (c[2] * 31 + 127) / 255;
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	inline void UnpackRGB565(uint16_t v, int* c)
+	{
+		int r = (v >> 11) & 31;
+		int g = (v >> 5) & 63;
+		int b = v & 31;
+		c[0] = (r << 3) | (r >> 2);
+		c[1] = (g << 2) | (g >> 4);
+		c[2] = (b << 3) | (b >> 2);
+	}
+
+	// Rounds endpoints to what a 565 block can hold.
+	inline void QuantizeRGB565(int* c)
+	{
+		UnpackRGB565(PackRGB565(c), c);
+	}
+
+	// Nearest of the four palette steps between e0 and e1 for every texel, found by projecting
+	// the texels onto the endpoint axis four at a time.
+	void ProjectColors(const uint8_t* block, const int* e0, const int* e1, uint32_t* steps)
+	{
+		int d[3] = { e1[0] - e0[0], e1[1] - e0[1], e1[2] - e0[2] };
+		int lengthSq = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+
+		if (lengthSq == 0)
+		{
+			memset(steps, 0, 16 * sizeof(uint32_t));
+			return;
+		}
+
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i axis = _mm_setr_epi16(static_cast<short>(d[0]), static_cast<short>(d[1]), static_cast<short>(d[2]), 0,
+			static_cast<short>(d[0]), static_cast<short>(d[1]), static_cast<short>(d[2]), 0);
+
+		const __m128 origin = _mm_set1_ps(static_cast<float>(e0[0] * d[0] + e0[1] * d[1] + e0[2] * d[2]));
+		const __m128 scale = _mm_set1_ps(3.0f / lengthSq);
+		const __m128 maxStep = _mm_set1_ps(3.0f);
+
+		for (int i = 0; i < 4; ++i)
+		{
+			__m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+
+			// madd leaves r*dr + g*dg and b*db for each texel in neighbouring lanes.
+			__m128 lo = _mm_cvtepi32_ps(_mm_madd_epi16(_mm_unpacklo_epi8(texels, zero), axis));
+			__m128 hi = _mm_cvtepi32_ps(_mm_madd_epi16(_mm_unpackhi_epi8(texels, zero), axis));
+			__m128 dot = _mm_add_ps(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+
+			__m128 t = _mm_mul_ps(_mm_sub_ps(dot, origin), scale);
+			t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), maxStep);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(steps + 4 * i), _mm_cvtps_epi32(t));
+		}
+	}
+
+	int ColorError(const uint8_t* block, const int* e0, const int* e1, const uint32_t* steps)
+	{
+		int palette[4][3];
+		for (int c = 0; c < 3; ++c)
+		{
+			palette[0][c] = e0[c];
+			palette[1][c] = (2 * e0[c] + e1[c]) / 3;
+			palette[2][c] = (e0[c] + 2 * e1[c]) / 3;
+			palette[3][c] = e1[c];
+		}
+
+		int error = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			const int* p = palette[steps[i]];
+			for (int c = 0; c < 3; ++c)
+			{
+				int diff = block[4 * i + c] - p[c];
+				error += diff * diff;
+			}
+		}
+
+		return error;
+	}
+
+	// Least-squares endpoints for a fixed assignment of texels to palette steps.
+	bool RefineEndpoints(const uint8_t* block, const uint32_t* steps, int* e0, int* e1)
+	{
+		float aa = 0.0f;
+		float ab = 0.0f;
+		float bb = 0.0f;
+		float ax[3] = { 0.0f, 0.0f, 0.0f };
+		float bx[3] = { 0.0f, 0.0f, 0.0f };
+
+		for (int i = 0; i < 16; ++i)
+		{
+			float b = steps[i] / 3.0f;
+			float a = 1.0f - b;
+
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+
+			for (int c = 0; c < 3; ++c)
+			{
+				ax[c] += a * block[4 * i + c];
+				bx[c] += b * block[4 * i + c];
+			}
+		}
+
+		float det = aa * bb - ab * ab;
+		if (std::fabs(det) < 1e-6f)
+		{
+			return false;
+		}
+
+		float invDet = 1.0f / det;
+		for (int c = 0; c < 3; ++c)
+		{
+			float v0 = (bb * ax[c] - ab * bx[c]) * invDet;
+			float v1 = (aa * bx[c] - ab * ax[c]) * invDet;
+			e0[c] = (std::min)((std::max)(static_cast<int>(v0 + 0.5f), 0), 255);
+			e1[c] = (std::min)((std::max)(static_cast<int>(v1 + 0.5f), 0), 255);
+		}
+
+		return true;
+	}
+
+	void EncodeColorBlock(const uint8_t* block, uint8_t* out)
+	{
+		// Per-channel bounds of the 16 texels.
+		__m128i minTexel = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+		__m128i maxTexel = minTexel;
+		for (int i = 1; i < 4; ++i)
+		{
+			__m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+			minTexel = _mm_min_epu8(minTexel, texels);
+			maxTexel = _mm_max_epu8(maxTexel, texels);
+		}
+		minTexel = _mm_min_epu8(minTexel, _mm_shuffle_epi32(minTexel, _MM_SHUFFLE(1, 0, 3, 2)));
+		minTexel = _mm_min_epu8(minTexel, _mm_shuffle_epi32(minTexel, _MM_SHUFFLE(2, 3, 0, 1)));
+		maxTexel = _mm_max_epu8(maxTexel, _mm_shuffle_epi32(maxTexel, _MM_SHUFFLE(1, 0, 3, 2)));
+		maxTexel = _mm_max_epu8(maxTexel, _mm_shuffle_epi32(maxTexel, _MM_SHUFFLE(2, 3, 0, 1)));
+
+		uint32_t minBits = static_cast<uint32_t>(_mm_cvtsi128_si32(minTexel));
+		uint32_t maxBits = static_cast<uint32_t>(_mm_cvtsi128_si32(maxTexel));
+
+		int lo[3];
+		int hi[3];
+		int mean[3] = { 0, 0, 0 };
+		for (int c = 0; c < 3; ++c)
+		{
+			lo[c] = (minBits >> (8 * c)) & 0xff;
+			hi[c] = (maxBits >> (8 * c)) & 0xff;
+
+			for (int i = 0; i < 16; ++i)
+			{
+				mean[c] += block[4 * i + c];
+			}
+			mean[c] = (mean[c] + 8) / 16;
+		}
+
+		// The box diagonal only follows the colours when every channel rises together.  Flip
+		// channels that fall as the widest channel rises.
+		int axis = 0;
+		for (int c = 1; c < 3; ++c)
+		{
+			if (hi[c] - lo[c] > hi[axis] - lo[axis])
+			{
+				axis = c;
+			}
+		}
+
+		for (int c = 0; c < 3; ++c)
+		{
+			if (c == axis)
+			{
+				continue;
+			}
+
+			int covariance = 0;
+			for (int i = 0; i < 16; ++i)
+			{
+				covariance += (block[4 * i + axis] - mean[axis]) * (block[4 * i + c] - mean[c]);
+			}
+
+			if (covariance < 0)
+			{
+				std::swap(lo[c], hi[c]);
+			}
+		}
+
+		// Pull the endpoints in slightly; the extremes are rarely the best palette ends.
+		int e0[3];
+		int e1[3];
+		for (int c = 0; c < 3; ++c)
+		{
+			int inset = (hi[c] - lo[c]) / 16;
+			e0[c] = hi[c] - inset;
+			e1[c] = lo[c] + inset;
+		}
+
+		QuantizeRGB565(e0);
+		QuantizeRGB565(e1);
+
+		uint32_t steps[16];
+		ProjectColors(block, e0, e1, steps);
+		int error = ColorError(block, e0, e1, steps);
+
+		int r0[3];
+		int r1[3];
+		if (error > 0 && RefineEndpoints(block, steps, r0, r1))
+		{
+			QuantizeRGB565(r0);
+			QuantizeRGB565(r1);
+
+			uint32_t refinedSteps[16];
+			ProjectColors(block, r0, r1, refinedSteps);
+
+			if (ColorError(block, r0, r1, refinedSteps) < error)
+			{
+				memcpy(e0, r0, sizeof(e0));
+				memcpy(e1, r1, sizeof(e1));
+				memcpy(steps, refinedSteps, sizeof(steps));
+			}
+		}
+
+		uint16_t c0 = PackRGB565(e0);
+		uint16_t c1 = PackRGB565(e1);
+
+		// Endpoint 0 must be the larger value to select the four-colour palette.
+		uint32_t flip = 0;
+		if (c0 < c1)
+		{
+			std::swap(c0, c1);
+			flip = 1;
+		}
+
+		uint32_t indices = 0;
+		if (c0 != c1)
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				indices |= (ColorCodes[steps[i]] ^ flip) << (2 * i);
+			}
+		}
+
+		out[0] = static_cast<uint8_t>(c0);
+		out[1] = static_cast<uint8_t>(c0 >> 8);
+		out[2] = static_cast<uint8_t>(c1);
+		out[3] = static_cast<uint8_t>(c1 >> 8);
+		out[4] = static_cast<uint8_t>(indices);
+		out[5] = static_cast<uint8_t>(indices >> 8);
+		out[6] = static_cast<uint8_t>(indices >> 16);
+		out[7] = static_cast<uint8_t>(indices >> 24);
+	}
+
+	// BC4 block for one channel of the texels.
+	void EncodeChannelBlock(const uint8_t* block, UINT channel, uint8_t* out)
+	{
+		const __m128i mask = _mm_set1_epi32(0xff);
+
+		__m128 values[4];
+		__m128 minValue = _mm_set1_ps(255.0f);
+		__m128 maxValue = _mm_setzero_ps();
+		for (int i = 0; i < 4; ++i)
+		{
+			__m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+			values[i] = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(texels, _mm_cvtsi32_si128(8 * channel)), mask));
+			minValue = _mm_min_ps(minValue, values[i]);
+			maxValue = _mm_max_ps(maxValue, values[i]);
+		}
+		minValue = _mm_min_ps(minValue, _mm_shuffle_ps(minValue, minValue, _MM_SHUFFLE(1, 0, 3, 2)));
+		minValue = _mm_min_ps(minValue, _mm_shuffle_ps(minValue, minValue, _MM_SHUFFLE(2, 3, 0, 1)));
+		maxValue = _mm_max_ps(maxValue, _mm_shuffle_ps(maxValue, maxValue, _MM_SHUFFLE(1, 0, 3, 2)));
+		maxValue = _mm_max_ps(maxValue, _mm_shuffle_ps(maxValue, maxValue, _MM_SHUFFLE(2, 3, 0, 1)));
+
+		int a0 = _mm_cvtsi128_si32(_mm_cvttps_epi32(maxValue));
+		int a1 = _mm_cvtsi128_si32(_mm_cvttps_epi32(minValue));
+
+		out[0] = static_cast<uint8_t>(a0);
+		out[1] = static_cast<uint8_t>(a1);
+
+		uint64_t indices = 0;
+		if (a0 != a1)
+		{
+			// Steps are counted down from the maximum, which is endpoint 0.
+			__m128 scale = _mm_set1_ps(7.0f / (a0 - a1));
+
+			alignas(16) int32_t steps[16];
+			for (int i = 0; i < 4; ++i)
+			{
+				__m128 t = _mm_mul_ps(_mm_sub_ps(maxValue, values[i]), scale);
+				_mm_store_si128(reinterpret_cast<__m128i*>(steps + 4 * i), _mm_cvtps_epi32(t));
+			}
+
+			for (int i = 0; i < 16; ++i)
+			{
+				indices |= static_cast<uint64_t>(AlphaCodes[steps[i]]) << (3 * i);
+			}
+		}
+
+		for (int i = 0; i < 6; ++i)
+		{
+			out[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+		}
+	}
+
+	void DecodeColorBlock(const uint8_t* in, uint8_t* block, bool bAlwaysFourColors)
+	{
+		uint16_t c0 = static_cast<uint16_t>(in[0] | (in[1] << 8));
+		uint16_t c1 = static_cast<uint16_t>(in[2] | (in[3] << 8));
+		uint32_t indices = in[4] | (in[5] << 8) | (in[6] << 16) | (static_cast<uint32_t>(in[7]) << 24);
+
+		int palette[4][4];
+		UnpackRGB565(c0, palette[0]);
+		UnpackRGB565(c1, palette[1]);
+		palette[0][3] = 255;
+		palette[1][3] = 255;
+
+		for (int c = 0; c < 3; ++c)
+		{
+			if (bAlwaysFourColors || c0 > c1)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		palette[2][3] = 255;
+		palette[3][3] = (bAlwaysFourColors || c0 > c1) ? 255 : 0;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			const int* p = palette[(indices >> (2 * i)) & 3];
+			for (int c = 0; c < 4; ++c)
+			{
+				block[4 * i + c] = static_cast<uint8_t>(p[c]);
+			}
+		}
+	}
+
+	void DecodeChannelBlock(const uint8_t* in, UINT channel, uint8_t* block)
+	{
+		int a0 = in[0];
+		int a1 = in[1];
+
+		int palette[8];
+		palette[0] = a0;
+		palette[1] = a1;
+		if (a0 > a1)
+		{
+			for (int k = 2; k < 8; ++k)
+			{
+				palette[k] = ((8 - k) * a0 + (k - 1) * a1) / 7;
+			}
+		}
+		else
+		{
+			for (int k = 2; k < 6; ++k)
+			{
+				palette[k] = ((6 - k) * a0 + (k - 1) * a1) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		uint64_t indices = 0;
+		for (int i = 0; i < 6; ++i)
+		{
+			indices |= static_cast<uint64_t>(in[2 + i]) << (8 * i);
+		}
+
+		for (int i = 0; i < 16; ++i)
+		{
+			block[4 * i + channel] = static_cast<uint8_t>(palette[(indices >> (3 * i)) & 7]);
+		}
+	}
+
+	// Copies a 4x4 block, repeating the last column and row past the image edge.
+	void LoadBlock(const uint8_t* rgba, UINT width, UINT height, UINT rowPitch, UINT blockX, UINT blockY, uint8_t* block)
+	{
+		UINT x0 = blockX * 4;
+		UINT y0 = blockY * 4;
+
+		for (UINT y = 0; y < 4; ++y)
+		{
+			const uint8_t* row = rgba + static_cast<size_t>((std::min)(y0 + y, height - 1)) * rowPitch;
+
+			if (x0 + 4 <= width)
+			{
+				memcpy(block + 16 * y, row + 4 * x0, 16);
+				continue;
+			}
+
+			for (UINT x = 0; x < 4; ++x)
+			{
+				memcpy(block + 16 * y + 4 * x, row + 4 * (std::min)(x0 + x, width - 1), 4);
+			}
+		}
+	}
+}
+
+UINT GBlockCompressor::GetBlockBytes(Format format)
+{
+	return format == FORMAT_BC1 ? 8 : 16;
+}
+
+UINT64 GBlockCompressor::GetCompressedSize(Format format, UINT width, UINT height)
+{
+	UINT64 blocksX = (width + 3) / 4;
+	UINT64 blocksY = (height + 3) / 4;
+	return blocksX * blocksY * GetBlockBytes(format);
+}
+
+void GBlockCompressor::CompressBlockBC1(const uint8_t* block, uint8_t* out)
+{
+	EncodeColorBlock(block, out);
+}
+
+void GBlockCompressor::CompressBlockBC3(const uint8_t* block, uint8_t* out)
+{
+	EncodeChannelBlock(block, 3, out);
+	EncodeColorBlock(block, out + 8);
+}
+
+void GBlockCompressor::CompressBlockBC5(const uint8_t* block, uint8_t* out)
+{
+	EncodeChannelBlock(block, 0, out);
+	EncodeChannelBlock(block, 1, out + 8);
+}
+
+void GBlockCompressor::DecompressBlockBC1(const uint8_t* in, uint8_t* block)
+{
+	DecodeColorBlock(in, block, false);
+}
+
+void GBlockCompressor::DecompressBlockBC3(const uint8_t* in, uint8_t* block)
+{
+	DecodeColorBlock(in + 8, block, true);
+	DecodeChannelBlock(in, 3, block);
+}
+
+void GBlockCompressor::DecompressBlockBC5(const uint8_t* in, uint8_t* block)
+{
+	for (int i = 0; i < 16; ++i)
+	{
+		block[4 * i + 2] = 0;
+		block[4 * i + 3] = 255;
+	}
+
+	DecodeChannelBlock(in, 0, block);
+	DecodeChannelBlock(in + 8, 1, block);
+}
+
+void GBlockCompressor::Compress(Format format, const uint8_t* rgba, UINT width, UINT height, UINT rowPitch, uint8_t* out)
+{
+	UINT blocksX = (width + 3) / 4;
+	UINT blocksY = (height + 3) / 4;
+	UINT blockBytes = GetBlockBytes(format);
+
+	GThreadPool::Get().ParallelFor(blocksY, BlockRowsPerRange, [&](UINT begin, UINT end)
+	{
+		alignas(16) uint8_t block[64];
+
+		for (UINT by = begin; by < end; ++by)
+		{
+			uint8_t* dest = out + static_cast<size_t>(by) * blocksX * blockBytes;
+
+			for (UINT bx = 0; bx < blocksX; ++bx, dest += blockBytes)
+			{
+				LoadBlock(rgba, width, height, rowPitch, bx, by, block);
+
+				switch (format)
+				{
+				case FORMAT_BC1: CompressBlockBC1(block, dest); break;
+				case FORMAT_BC3: CompressBlockBC3(block, dest); break;
+				case FORMAT_BC5: CompressBlockBC5(block, dest); break;
+				}
+			}
+		}
+	});
+}
+
+void GBlockCompressor::Decompress(Format format, const uint8_t* blocks, UINT width, UINT height, uint8_t* rgba, UINT rowPitch)
+{
+	UINT blocksX = (width + 3) / 4;
+	UINT blocksY = (height + 3) / 4;
+	UINT blockBytes = GetBlockBytes(format);
+
+	GThreadPool::Get().ParallelFor(blocksY, BlockRowsPerRange, [&](UINT begin, UINT end)
+	{
+		uint8_t block[64];
+
+		for (UINT by = begin; by < end; ++by)
+		{
+			const uint8_t* src = blocks + static_cast<size_t>(by) * blocksX * blockBytes;
+
+			for (UINT bx = 0; bx < blocksX; ++bx, src += blockBytes)
+			{
+				switch (format)
+				{
+				case FORMAT_BC1: DecompressBlockBC1(src, block); break;
+				case FORMAT_BC3: DecompressBlockBC3(src, block); break;
+				case FORMAT_BC5: DecompressBlockBC5(src, block); break;
+				}
+
+				UINT rows = (std::min)(4u, height - by * 4);
+				UINT cols = (std::min)(4u, width - bx * 4);
+				for (UINT y = 0; y < rows; ++y)
+				{
+					memcpy(rgba + static_cast<size_t>(by * 4 + y) * rowPitch + bx * 16, block + 16 * y, 4 * cols);
+				}
+			}
+		}
+	});
+}
+
+double GBlockCompressor::ComputePSNR(const uint8_t* a, const uint8_t* b, UINT width, UINT height, UINT rowPitch, UINT channelMask)
+{
+	double sumSq = 0.0;
+	UINT64 count = 0;
+
+	for (UINT y = 0; y < height; ++y)
+	{
+		const uint8_t* rowA = a + static_cast<size_t>(y) * rowPitch;
+		const uint8_t* rowB = b + static_cast<size_t>(y) * rowPitch;
+
+		for (UINT x = 0; x < width; ++x)
+		{
+			for (UINT c = 0; c < 4; ++c)
+			{
+				if (channelMask & (1 << c))
+				{
+					double diff = static_cast<double>(rowA[4 * x + c]) - rowB[4 * x + c];
+					sumSq += diff * diff;
+					++count;
+				}
+			}
+		}
+	}
+
+	if (count == 0 || sumSq == 0.0)
+	{
+		return std::numeric_limits<double>::infinity();
+	}
+
+	double mse = sumSq / count;
+	return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
\ No newline at end of file
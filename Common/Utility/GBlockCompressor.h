@@ -0,0 +1,46 @@
+/*  ===============================================
+	Summary: BC1/BC3/BC5 Block Compression
+	===============================================  */
+
+#ifndef GBLOCKCOMPRESSOR_H
+#define GBLOCKCOMPRESSOR_H
+
+#include <Windows.h>
+#include <cstdint>
+
+// CPU encoder for the block-compressed formats the demos use: BC1 for opaque colour, BC3 for
+// colour with alpha and BC5 for two-channel normal maps.  Sources are RGBA8 images; blocks are
+// written in the layout Direct3D expects, so the output can go straight into a DDS file.
+class GBlockCompressor
+{
+public:
+	enum Format
+	{
+		FORMAT_BC1,
+		FORMAT_BC3,
+		FORMAT_BC5,
+	};
+
+	static UINT GetBlockBytes(Format format);
+	static UINT64 GetCompressedSize(Format format, UINT width, UINT height);
+
+	// Rows of blocks are spread across the thread pool.  Blocks on the right and bottom edges
+	// of images that are not a multiple of four repeat the last column and row.
+	static void Compress(Format format, const uint8_t* rgba, UINT width, UINT height, UINT rowPitch, uint8_t* out);
+	static void Decompress(Format format, const uint8_t* blocks, UINT width, UINT height, uint8_t* rgba, UINT rowPitch);
+
+	// A block is 16 RGBA8 texels in row order.
+	static void CompressBlockBC1(const uint8_t* block, uint8_t* out);
+	static void CompressBlockBC3(const uint8_t* block, uint8_t* out);
+	static void CompressBlockBC5(const uint8_t* block, uint8_t* out);
+
+	static void DecompressBlockBC1(const uint8_t* in, uint8_t* block);
+	static void DecompressBlockBC3(const uint8_t* in, uint8_t* block);
+	static void DecompressBlockBC5(const uint8_t* in, uint8_t* block);
+
+	// Peak signal-to-noise ratio in decibels over the channels in channelMask (bit 0 is red,
+	// bit 3 alpha).  Identical images give infinity.
+	static double ComputePSNR(const uint8_t* a, const uint8_t* b, UINT width, UINT height, UINT rowPitch, UINT channelMask = 0x7);
+};
+
+#endif // GBLOCKCOMPRESSOR_H
\ No newline at end of file
@@ -0,0 +1,161 @@
+/*  ===============================================
+	Summary: Dynamic Cube Map Update Scheduler
+	===============================================  */
+
+#include "GCubeMapScheduler.h"
+
+#include <algorithm>
+#include <cfloat>
+
+using namespace DirectX;
+
+namespace
+{
+	// Distance from zero to the nearest point of [minV, maxV].
+	float NearestToZero(float minV, float maxV)
+	{
+		return minV > 0.0f ? minV : (maxV < 0.0f ? -maxV : 0.0f);
+	}
+}
+
+const UINT GCubeMapScheduler::FaceCount;
+
+GCubeMapScheduler::GCubeMapScheduler() :
+	mCenter(0.0f, 0.0f, 0.0f),
+	mNearZ(0.1f),
+	mFarZ(FLT_MAX),
+	mFacesPerFrame(FaceCount),
+	mNextFace(0),
+	bCullFaces(true),
+	bSkipUnchanged(true)
+{
+	InvalidateAll();
+}
+
+GCubeMapScheduler::~GCubeMapScheduler()
+{
+}
+
+void GCubeMapScheduler::SetCenter(const XMFLOAT3& center, float nearZ, float farZ)
+{
+	mCenter = center;
+	mNearZ = nearZ;
+	mFarZ = farZ;
+
+	for (size_t i = 0; i < mObjectBounds.size(); ++i)
+	{
+		mObjectFaces[i] = GetFaceMask(mObjectBounds[i]);
+	}
+
+	InvalidateAll();
+}
+
+void GCubeMapScheduler::SetFacesPerFrame(UINT count)
+{
+	mFacesPerFrame = (std::min)((std::max)(count, 1u), FaceCount);
+}
+
+UINT GCubeMapScheduler::AddObject(const BoundingBox& bounds)
+{
+	mObjectBounds.push_back(bounds);
+	mObjectFaces.push_back(GetFaceMask(bounds));
+
+	// A new object may show up in any face that sees it.
+	UINT mask = mObjectFaces.back();
+	for (UINT face = 0; face < FaceCount; ++face)
+	{
+		mFaceDirty[face] = mFaceDirty[face] || (mask & (1u << face)) != 0;
+	}
+
+	return static_cast<UINT>(mObjectBounds.size() - 1);
+}
+
+void GCubeMapScheduler::UpdateObject(UINT object, const BoundingBox& bounds)
+{
+	UINT mask = GetFaceMask(bounds);
+	UINT changed = mObjectFaces[object] | mask;
+
+	for (UINT face = 0; face < FaceCount; ++face)
+	{
+		mFaceDirty[face] = mFaceDirty[face] || (changed & (1u << face)) != 0;
+	}
+
+	mObjectBounds[object] = bounds;
+	mObjectFaces[object] = mask;
+}
+
+void GCubeMapScheduler::InvalidateAll()
+{
+	for (UINT face = 0; face < FaceCount; ++face)
+	{
+		mFaceDirty[face] = true;
+	}
+}
+
+UINT GCubeMapScheduler::Schedule(UINT faces[FaceCount])
+{
+	UINT count = 0;
+	UINT lastFace = mNextFace;
+
+	for (UINT i = 0; i < FaceCount && count < mFacesPerFrame; ++i)
+	{
+		UINT face = (mNextFace + i) % FaceCount;
+		if (mFaceDirty[face] || !bSkipUnchanged)
+		{
+			faces[count++] = face;
+			mFaceDirty[face] = false;
+			lastFace = face;
+		}
+	}
+
+	// Pick up next frame after the last face drawn, so every face gets its turn.
+	if (count > 0)
+	{
+		mNextFace = (lastFace + 1) % FaceCount;
+	}
+
+	return count;
+}
+
+UINT GCubeMapScheduler::GetFaceMask(const BoundingBox& bounds) const
+{
+	// The box relative to the center.
+	float minP[3] =
+	{
+		bounds.Center.x - bounds.Extents.x - mCenter.x,
+		bounds.Center.y - bounds.Extents.y - mCenter.y,
+		bounds.Center.z - bounds.Extents.z - mCenter.z
+	};
+	float maxP[3] =
+	{
+		bounds.Center.x + bounds.Extents.x - mCenter.x,
+		bounds.Center.y + bounds.Extents.y - mCenter.y,
+		bounds.Center.z + bounds.Extents.z - mCenter.z
+	};
+
+	UINT mask = 0;
+
+	for (UINT axis = 0; axis < 3; ++axis)
+	{
+		UINT u = (axis + 1) % 3;
+		UINT v = (axis + 2) % 3;
+
+		// A 90-degree face holds the points whose depth along its axis is at least their distance
+		// off the axis on both other axes.  The box overlaps the face exactly if its deepest depth
+		// reaches the off-axis distance of its point nearest the axis.
+		float offAxis = (std::max)(NearestToZero(minP[u], maxP[u]), NearestToZero(minP[v], maxP[v]));
+
+		for (UINT side = 0; side < 2; ++side)
+		{
+			float deepest = side == 0 ? maxP[axis] : -minP[axis];
+			float shallowest = side == 0 ? minP[axis] : -maxP[axis];
+
+			if (deepest >= (std::max)(offAxis, mNearZ) && shallowest <= mFarZ)
+			{
+				mask |= 1u << (axis * 2 + side);
+			}
+		}
+	}
+
+	return mask;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+/*  ===============================================
+	Summary: Dynamic Cube Map Update Scheduler
+	===============================================  */
+
+#ifndef GCUBEMAPSCHEDULER_H
+#define GCUBEMAPSCHEDULER_H
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <vector>
+
+// Decides which faces of a dynamic cube map to redraw each frame and which objects each face sees.
+// Faces are handed out round-robin, at most a budget per frame, and with skipping on a face is only
+// redrawn after something it sees has changed.  Faces follow the D3D cube order: +X, -X, +Y, -Y,
+// +Z, -Z, each a 90-degree frustum about the center.
+class GCubeMapScheduler
+{
+public:
+	static const UINT FaceCount = 6;
+
+	GCubeMapScheduler();
+	~GCubeMapScheduler();
+
+	// Moving the cube map redraws every face.
+	void SetCenter(const DirectX::XMFLOAT3& center, float nearZ, float farZ);
+
+	void SetFacesPerFrame(UINT count);
+	inline UINT GetFacesPerFrame() const { return mFacesPerFrame; }
+
+	// With culling off, every object is visible in every face.
+	inline void SetCulling(bool bCull) { bCullFaces = bCull; }
+
+	// With skipping off, faces are redrawn in turn whether or not anything changed.
+	inline void SetSkipUnchanged(bool bSkip) { bSkipUnchanged = bSkip; }
+
+	// Objects are world-space bounds; returns the index to refer to the object by.
+	UINT AddObject(const DirectX::BoundingBox& bounds);
+
+	// The object moved or its appearance changed.  Faces that saw it before or see it now need redrawing.
+	void UpdateObject(UINT object, const DirectX::BoundingBox& bounds);
+
+	void InvalidateAll();
+
+	// Writes the faces to redraw this frame, up to the budget, and returns how many.
+	UINT Schedule(UINT faces[FaceCount]);
+
+	inline bool IsVisible(UINT face, UINT object) const { return !bCullFaces || (mObjectFaces[object] & (1u << face)) != 0; }
+
+private:
+	// A bit per face whose frustum the box overlaps.
+	UINT GetFaceMask(const DirectX::BoundingBox& bounds) const;
+
+private:
+	DirectX::XMFLOAT3 mCenter;
+	float mNearZ;
+	float mFarZ;
+
+	UINT mFacesPerFrame;
+	UINT mNextFace;
+
+	bool bCullFaces;
+	bool bSkipUnchanged;
+
+	bool mFaceDirty[FaceCount];
+
+	std::vector<DirectX::BoundingBox> mObjectBounds;
+	std::vector<UINT> mObjectFaces;
+};
+
+#endif // GCUBEMAPSCHEDULER_H
\ No newline at end of file
@@ -0,0 +1,263 @@
+/*  ===============================================
+	Summary: DDS File Writer
+	===============================================  */
+
+#include "GDDSWriter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	const uint32_t DDSMagic = 0x20534444; // "DDS "
+
+	const uint32_t DDSFourCC = 0x00000004;
+	const uint32_t DX10FourCC = 0x30315844; // "DX10"
+
+	const uint32_t DDSDCaps = 0x00000001;
+	const uint32_t DDSDHeight = 0x00000002;
+	const uint32_t DDSDWidth = 0x00000004;
+	const uint32_t DDSDPitch = 0x00000008;
+	const uint32_t DDSDPixelFormat = 0x00001000;
+	const uint32_t DDSDMipMapCount = 0x00020000;
+	const uint32_t DDSDLinearSize = 0x00080000;
+
+	const uint32_t DDSCapsComplex = 0x00000008;
+	const uint32_t DDSCapsTexture = 0x00001000;
+	const uint32_t DDSCapsMipMap = 0x00400000;
+	const uint32_t DDSCaps2CubeMapAllFaces = 0x0000fe00;
+
+	const uint32_t ResourceDimensionTexture2D = 3;
+	const uint32_t ResourceMiscTextureCube = 0x4;
+
+#pragma pack(push, 1)
+	struct PixelFormat
+	{
+		uint32_t Size;
+		uint32_t Flags;
+		uint32_t FourCC;
+		uint32_t RGBBitCount;
+		uint32_t RBitMask;
+		uint32_t GBitMask;
+		uint32_t BBitMask;
+		uint32_t ABitMask;
+	};
+
+	struct Header
+	{
+		uint32_t Size;
+		uint32_t Flags;
+		uint32_t Height;
+		uint32_t Width;
+		uint32_t PitchOrLinearSize;
+		uint32_t Depth;
+		uint32_t MipMapCount;
+		uint32_t Reserved1[11];
+		PixelFormat Format;
+		uint32_t Caps;
+		uint32_t Caps2;
+		uint32_t Caps3;
+		uint32_t Caps4;
+		uint32_t Reserved2;
+	};
+
+	struct HeaderDX10
+	{
+		uint32_t Format;
+		uint32_t ResourceDimension;
+		uint32_t MiscFlag;
+		uint32_t ArraySize;
+		uint32_t MiscFlags2;
+	};
+#pragma pack(pop)
+
+	bool IsBlockCompressed(DXGI_FORMAT format)
+	{
+		return format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM;
+	}
+
+	FILE* OpenForWrite(LPCWSTR filename)
+	{
+#if defined(_WIN32)
+		FILE* file = nullptr;
+		return _wfopen_s(&file, filename, L"wb") == 0 ? file : nullptr;
+#else
+		char path[4096];
+		size_t length = wcstombs(path, filename, sizeof(path));
+		if (length == static_cast<size_t>(-1) || length >= sizeof(path))
+		{
+			return nullptr;
+		}
+		return fopen(path, "wb");
+#endif
+	}
+}
+
+bool GDDSWriter::GetSurfaceInfo(DXGI_FORMAT format, UINT width, UINT height, UINT& rowBytes, UINT& numRows)
+{
+	UINT blockBytes = 0;
+	UINT pixelBytes = 0;
+
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_TYPELESS:
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_TYPELESS:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC4_SNORM:
+		blockBytes = 8;
+		break;
+
+	case DXGI_FORMAT_BC2_TYPELESS:
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_TYPELESS:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC5_TYPELESS:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+		blockBytes = 16;
+		break;
+
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		pixelBytes = 16;
+		break;
+
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+	case DXGI_FORMAT_R32G32_FLOAT:
+		pixelBytes = 8;
+		break;
+
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8X8_UNORM:
+	case DXGI_FORMAT_R32_FLOAT:
+	case DXGI_FORMAT_R16G16_UNORM:
+	case DXGI_FORMAT_R16G16_FLOAT:
+		pixelBytes = 4;
+		break;
+
+	case DXGI_FORMAT_R16_UNORM:
+	case DXGI_FORMAT_R16_FLOAT:
+	case DXGI_FORMAT_R8G8_UNORM:
+		pixelBytes = 2;
+		break;
+
+	case DXGI_FORMAT_R8_UNORM:
+		pixelBytes = 1;
+		break;
+
+	default:
+		return false;
+	}
+
+	if (blockBytes > 0)
+	{
+		rowBytes = (std::max)(1u, (width + 3) / 4) * blockBytes;
+		numRows = (std::max)(1u, (height + 3) / 4);
+	}
+	else
+	{
+		rowBytes = width * pixelBytes;
+		numRows = height;
+	}
+
+	return true;
+}
+
+UINT64 GDDSWriter::GetSurfaceBytes(DXGI_FORMAT format, UINT width, UINT height)
+{
+	UINT rowBytes = 0;
+	UINT numRows = 0;
+	if (!GetSurfaceInfo(format, width, height, rowBytes, numRows))
+	{
+		return 0;
+	}
+
+	return static_cast<UINT64>(rowBytes) * numRows;
+}
+
+bool GDDSWriter::Write(LPCWSTR filename, const Desc& desc, const void* const* subresources)
+{
+	UINT rowBytes = 0;
+	UINT numRows = 0;
+	if (!GetSurfaceInfo(desc.Format, desc.Width, desc.Height, rowBytes, numRows) || desc.MipLevels == 0 || desc.ArraySize == 0)
+	{
+		return false;
+	}
+
+	Header header = {};
+	header.Size = sizeof(Header);
+	header.Flags = DDSDCaps | DDSDHeight | DDSDWidth | DDSDPixelFormat | DDSDMipMapCount;
+	header.Height = desc.Height;
+	header.Width = desc.Width;
+	header.MipMapCount = desc.MipLevels;
+	header.Format.Size = sizeof(PixelFormat);
+	header.Format.Flags = DDSFourCC;
+	header.Format.FourCC = DX10FourCC;
+	header.Caps = DDSCapsTexture;
+
+	if (IsBlockCompressed(desc.Format))
+	{
+		header.Flags |= DDSDLinearSize;
+		header.PitchOrLinearSize = rowBytes * numRows;
+	}
+	else
+	{
+		header.Flags |= DDSDPitch;
+		header.PitchOrLinearSize = rowBytes;
+	}
+
+	if (desc.MipLevels > 1)
+	{
+		header.Caps |= DDSCapsComplex | DDSCapsMipMap;
+	}
+
+	if (desc.bCubeMap || desc.ArraySize > 1)
+	{
+		header.Caps |= DDSCapsComplex;
+	}
+
+	if (desc.bCubeMap)
+	{
+		header.Caps2 = DDSCaps2CubeMapAllFaces;
+	}
+
+	HeaderDX10 header10 = {};
+	header10.Format = desc.Format;
+	header10.ResourceDimension = ResourceDimensionTexture2D;
+	header10.MiscFlag = desc.bCubeMap ? ResourceMiscTextureCube : 0;
+	header10.ArraySize = desc.ArraySize;
+
+	FILE* file = OpenForWrite(filename);
+	if (!file)
+	{
+		return false;
+	}
+
+	bool bOk = fwrite(&DDSMagic, sizeof(DDSMagic), 1, file) == 1 &&
+		fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(&header10, sizeof(header10), 1, file) == 1;
+
+	UINT numSlices = desc.ArraySize * (desc.bCubeMap ? 6 : 1);
+	for (UINT slice = 0; slice < numSlices && bOk; ++slice)
+	{
+		for (UINT mip = 0; mip < desc.MipLevels && bOk; ++mip)
+		{
+			UINT width = (std::max)(1u, desc.Width >> mip);
+			UINT height = (std::max)(1u, desc.Height >> mip);
+			size_t bytes = static_cast<size_t>(GetSurfaceBytes(desc.Format, width, height));
+
+			bOk = fwrite(subresources[slice * desc.MipLevels + mip], 1, bytes, file) == bytes;
+		}
+	}
+
+	return fclose(file) == 0 && bOk;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+/*  ===============================================
+	Summary: DDS File Writer
+	===============================================  */
+
+#ifndef GDDSWRITER_H
+#define GDDSWRITER_H
+
+#include <Windows.h>
+#include <dxgiformat.h>
+
+// Writes 2D textures, arrays and cube maps as DDS files with a DX10 header, which
+// DDSTextureLoader reads back directly.
+class GDDSWriter
+{
+public:
+	struct Desc
+	{
+		DXGI_FORMAT Format;
+		UINT Width;
+		UINT Height;
+		UINT MipLevels;
+
+		// Number of textures, or of cubes when bCubeMap is set.
+		UINT ArraySize;
+		bool bCubeMap;
+	};
+
+	// Size of one tightly packed surface.  Returns false for formats the writer does not handle.
+	static bool GetSurfaceInfo(DXGI_FORMAT format, UINT width, UINT height, UINT& rowBytes, UINT& numRows);
+	static UINT64 GetSurfaceBytes(DXGI_FORMAT format, UINT width, UINT height);
+
+	// subresources holds one tightly packed surface per subresource, ordered like
+	// D3D11CalcSubresource: every mip of the first slice, then every mip of the next.
+	static bool Write(LPCWSTR filename, const Desc& desc, const void* const* subresources);
+};
+
+#endif // GDDSWRITER_H
\ No newline at end of file
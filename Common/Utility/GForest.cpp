@@ -0,0 +1,296 @@
+/*  ===============================================
+	Summary: Cell-Culled Billboard Forest
+	===============================================  */
+
+#include "GForest.h"
+#include "GThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	const UINT CellsPerRange = 8;
+	const UINT VisibleCellsPerRange = 16;
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	inline float GetMilliseconds(Clock::time_point start)
+	{
+		return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+	}
+
+	// Small per-cell generator, so cells can be filled on any thread in any order and still
+	// come out the same.  rand() is neither thread-safe nor repeatable across threads.
+	class CellRandom
+	{
+	public:
+		CellRandom(UINT seed, UINT cell)
+		{
+			mState = (seed + 1) * 0x9E3779B9u ^ (cell + 1) * 0x85EBCA6Bu;
+			mState = mState ? mState : 1;
+		}
+
+		UINT Next()
+		{
+			// xorshift32
+			mState ^= mState << 13;
+			mState ^= mState >> 17;
+			mState ^= mState << 5;
+			return mState;
+		}
+
+		// Uniform in [0, 1).
+		float NextFloat()
+		{
+			return (Next() >> 8) * (1.0f / 16777216.0f);
+		}
+
+		float NextFloat(float a, float b)
+		{
+			return a + (b - a) * NextFloat();
+		}
+
+	private:
+		UINT mState;
+	};
+}
+
+GForest::GForest() :
+	mVisibleTrees(0),
+	mGenerateTime(0.0f),
+	mCullTime(0.0f),
+	mUploadTime(0.0f)
+{
+}
+
+GForest::~GForest()
+{
+}
+
+float GForest::SampleDensity(const Desc& desc, float x, float z) const
+{
+	if (!desc.DensityMap)
+	{
+		return 1.0f;
+	}
+
+	// Bilinear, with texel centers spread from edge to edge of the area.
+	float u = (x - desc.MinX) / (desc.MaxX - desc.MinX) * (desc.DensityMapWidth - 1);
+	float v = (z - desc.MinZ) / (desc.MaxZ - desc.MinZ) * (desc.DensityMapDepth - 1);
+
+	u = (std::min)((std::max)(u, 0.0f), static_cast<float>(desc.DensityMapWidth - 1));
+	v = (std::min)((std::max)(v, 0.0f), static_cast<float>(desc.DensityMapDepth - 1));
+
+	UINT x0 = static_cast<UINT>(u);
+	UINT z0 = static_cast<UINT>(v);
+	UINT x1 = (std::min)(x0 + 1, desc.DensityMapWidth - 1);
+	UINT z1 = (std::min)(z0 + 1, desc.DensityMapDepth - 1);
+
+	float s = u - x0;
+	float t = v - z0;
+
+	const float* row0 = desc.DensityMap + static_cast<size_t>(z0) * desc.DensityMapWidth;
+	const float* row1 = desc.DensityMap + static_cast<size_t>(z1) * desc.DensityMapWidth;
+
+	float a = row0[x0] + s * (row0[x1] - row0[x0]);
+	float b = row1[x0] + s * (row1[x1] - row1[x0]);
+
+	return a + t * (b - a);
+}
+
+void GForest::Generate(const Desc& desc)
+{
+	Clock::time_point start = Clock::now();
+
+	UINT cellsX = (std::max)(1u, static_cast<UINT>(ceilf((desc.MaxX - desc.MinX) / desc.CellSize)));
+	UINT cellsZ = (std::max)(1u, static_cast<UINT>(ceilf((desc.MaxZ - desc.MinZ) / desc.CellSize)));
+	UINT numCells = cellsX * cellsZ;
+	UINT numTypes = (std::max)(1u, desc.NumSpriteTypes);
+
+	std::vector<std::vector<Sprite>> cellSprites(numCells);
+	std::vector<Cell> cells(numCells);
+
+	// Desc::GetHeight is called from every worker, so it must not touch shared state.
+	GThreadPool::Get().ParallelFor(numCells, CellsPerRange, [&](UINT begin, UINT end)
+	{
+		for (UINT i = begin; i < end; ++i)
+		{
+			float x0 = desc.MinX + (i % cellsX) * desc.CellSize;
+			float z0 = desc.MinZ + (i / cellsX) * desc.CellSize;
+			float x1 = (std::min)(x0 + desc.CellSize, desc.MaxX);
+			float z1 = (std::min)(z0 + desc.CellSize, desc.MaxZ);
+
+			CellRandom random(desc.Seed, i);
+
+			// Round the expected count up or down at random so small cells still get trees.
+			float expected = desc.Density * (x1 - x0) * (z1 - z0);
+			UINT numCandidates = static_cast<UINT>(expected + random.NextFloat());
+
+			std::vector<Sprite>& sprites = cellSprites[i];
+			sprites.reserve(numCandidates);
+
+			float minY = FLT_MAX;
+			float maxY = -FLT_MAX;
+			float maxHalfWidth = 0.0f;
+
+			for (UINT n = 0; n < numCandidates; ++n)
+			{
+				float x = random.NextFloat(x0, x1);
+				float z = random.NextFloat(z0, z1);
+
+				// Thin the candidates by the density map.
+				if (random.NextFloat() >= SampleDensity(desc, x, z))
+				{
+					continue;
+				}
+
+				float y = desc.GetHeight(x, z);
+				if (y < desc.MinHeight)
+				{
+					continue;
+				}
+
+				float t = random.NextFloat();
+
+				Sprite sprite;
+				sprite.SizeW.x = desc.MinSize.x + t * (desc.MaxSize.x - desc.MinSize.x);
+				sprite.SizeW.y = desc.MinSize.y + t * (desc.MaxSize.y - desc.MinSize.y);
+				sprite.CenterW = DirectX::XMFLOAT3(x, y + 0.5f * sprite.SizeW.y, z);
+				sprite.AtlasIndex = random.Next() % numTypes;
+
+				sprites.push_back(sprite);
+
+				minY = (std::min)(minY, y);
+				maxY = (std::max)(maxY, y + sprite.SizeW.y);
+				maxHalfWidth = (std::max)(maxHalfWidth, 0.5f * sprite.SizeW.x);
+			}
+
+			// Billboards turn to face the camera, so a tree can reach half its width past the cell.
+			Cell& cell = cells[i];
+			cell.Center = DirectX::XMFLOAT3(0.5f * (x0 + x1), 0.5f * (minY + maxY), 0.5f * (z0 + z1));
+			cell.Extents = DirectX::XMFLOAT3(0.5f * (x1 - x0) + maxHalfWidth, 0.5f * (maxY - minY), 0.5f * (z1 - z0) + maxHalfWidth);
+			cell.Count = static_cast<UINT>(sprites.size());
+		}
+	});
+
+	// Lay the cells out one after another, dropping the empty ones.
+	mCells.clear();
+
+	UINT numSprites = 0;
+	std::vector<UINT> cellIndices;
+	for (UINT i = 0; i < numCells; ++i)
+	{
+		if (cells[i].Count > 0)
+		{
+			cells[i].First = numSprites;
+			numSprites += cells[i].Count;
+
+			mCells.push_back(cells[i]);
+			cellIndices.push_back(i);
+		}
+	}
+
+	mSprites.resize(numSprites);
+
+	GThreadPool::Get().ParallelFor(static_cast<UINT>(mCells.size()), CellsPerRange, [&](UINT begin, UINT end)
+	{
+		for (UINT i = begin; i < end; ++i)
+		{
+			const std::vector<Sprite>& sprites = cellSprites[cellIndices[i]];
+			memcpy(&mSprites[mCells[i].First], sprites.data(), sprites.size() * sizeof(Sprite));
+		}
+	});
+
+	mVisibleCells.clear();
+	mPrevVisibleCells.clear();
+	mVisibleTrees = 0;
+
+	mGenerateTime = GetMilliseconds(start);
+}
+
+bool GForest::Cull(const DirectX::XMFLOAT4 planes[6], const DirectX::XMFLOAT3& eyePosW, float maxDistance)
+{
+	Clock::time_point start = Clock::now();
+
+	mPrevVisibleCells.swap(mVisibleCells);
+	mVisibleCells.clear();
+
+	float maxDistanceSq = maxDistance * maxDistance;
+
+	for (UINT i = 0; i < mCells.size(); ++i)
+	{
+		const DirectX::XMFLOAT3& center = mCells[i].Center;
+		const DirectX::XMFLOAT3& extents = mCells[i].Extents;
+
+		// Distance from the eye to the nearest point of the box.
+		float dx = (std::max)(fabsf(eyePosW.x - center.x) - extents.x, 0.0f);
+		float dy = (std::max)(fabsf(eyePosW.y - center.y) - extents.y, 0.0f);
+		float dz = (std::max)(fabsf(eyePosW.z - center.z) - extents.z, 0.0f);
+
+		if (dx*dx + dy*dy + dz*dz > maxDistanceSq)
+		{
+			continue;
+		}
+
+		// The box is outside if it lies entirely behind any one plane.
+		bool bVisible = true;
+		for (UINT p = 0; p < 6 && bVisible; ++p)
+		{
+			const DirectX::XMFLOAT4& plane = planes[p];
+
+			float r = fabsf(plane.x)*extents.x + fabsf(plane.y)*extents.y + fabsf(plane.z)*extents.z;
+			float s = plane.x*center.x + plane.y*center.y + plane.z*center.z + plane.w;
+
+			bVisible = (s + r >= 0.0f);
+		}
+
+		if (bVisible)
+		{
+			mVisibleCells.push_back(i);
+		}
+	}
+
+	mCullTime = GetMilliseconds(start);
+
+	return mVisibleCells != mPrevVisibleCells;
+}
+
+UINT GForest::Upload(Sprite* dst, UINT maxSprites)
+{
+	Clock::time_point start = Clock::now();
+
+	// Where each visible cell starts in dst.  Cells that do not fit are left out.
+	std::vector<UINT> offsets(mVisibleCells.size());
+	UINT numCells = 0;
+	UINT numSprites = 0;
+
+	for (; numCells < mVisibleCells.size(); ++numCells)
+	{
+		UINT count = mCells[mVisibleCells[numCells]].Count;
+		if (numSprites + count > maxSprites)
+		{
+			break;
+		}
+
+		offsets[numCells] = numSprites;
+		numSprites += count;
+	}
+
+	GThreadPool::Get().ParallelFor(numCells, VisibleCellsPerRange, [&](UINT begin, UINT end)
+	{
+		for (UINT i = begin; i < end; ++i)
+		{
+			const Cell& cell = mCells[mVisibleCells[i]];
+			memcpy(dst + offsets[i], &mSprites[cell.First], cell.Count * sizeof(Sprite));
+		}
+	});
+
+	mVisibleTrees = numSprites;
+	mUploadTime = GetMilliseconds(start);
+
+	return numSprites;
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+/*  ===============================================
+	Summary: Cell-Culled Billboard Forest
+	===============================================  */
+
+#ifndef GFOREST_H
+#define GFOREST_H
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <functional>
+#include <vector>
+
+// Scatters tree billboards over an area from a density map and keeps them in square cells.
+// Each frame Cull picks the cells inside the view, and Upload copies only their trees into a
+// vertex buffer.  Placement and the copy are spread across the thread pool, so forests of
+// around a million trees stay within a few milliseconds of CPU time.
+class GForest
+{
+public:
+	// One tree as the billboard vertex shader reads it.
+	struct Sprite
+	{
+		DirectX::XMFLOAT3 CenterW;
+		DirectX::XMFLOAT2 SizeW;
+		UINT AtlasIndex;
+	};
+
+	struct Desc
+	{
+		// Area covered, in world units on the xz-plane.
+		float MinX;
+		float MinZ;
+		float MaxX;
+		float MaxZ;
+
+		// Side of a culling cell.
+		float CellSize;
+
+		// Trees per square unit where the density map is 1.
+		float Density;
+
+		// Row-major values in [0, 1] stretched over the area, or null for uniform density.
+		const float* DensityMap;
+		UINT DensityMapWidth;
+		UINT DensityMapDepth;
+
+		// Ground height at (x, z).  Trees are not placed where it is below MinHeight.
+		std::function<float(float, float)> GetHeight;
+		float MinHeight;
+
+		// Tree sizes are picked uniformly between the two.
+		DirectX::XMFLOAT2 MinSize;
+		DirectX::XMFLOAT2 MaxSize;
+
+		// Atlas entries to choose from.
+		UINT NumSpriteTypes;
+
+		// The same seed and description always give the same forest.
+		UINT Seed;
+	};
+
+	GForest();
+	~GForest();
+
+	void Generate(const Desc& desc);
+
+	// Picks the cells whose bounds touch the frustum (inward-pointing planes, as from
+	// MathHelper::ExtractFrustumPlanes) and lie within maxDistance of the eye.  Returns true
+	// if the set of visible cells changed since the last call, i.e. the trees need uploading.
+	bool Cull(const DirectX::XMFLOAT4 planes[6], const DirectX::XMFLOAT3& eyePosW, float maxDistance);
+
+	// Copies the trees of the visible cells into dst, at most maxSprites of them, and returns
+	// how many were written.
+	UINT Upload(Sprite* dst, UINT maxSprites);
+
+	inline UINT GetTreeCount() const { return static_cast<UINT>(mSprites.size()); }
+	inline UINT GetCellCount() const { return static_cast<UINT>(mCells.size()); }
+	inline UINT GetVisibleCellCount() const { return static_cast<UINT>(mVisibleCells.size()); }
+	inline UINT GetVisibleTreeCount() const { return mVisibleTrees; }
+
+	// Milliseconds spent in the last Generate, Cull and Upload.
+	inline float GetGenerateTime() const { return mGenerateTime; }
+	inline float GetCullTime() const { return mCullTime; }
+	inline float GetUploadTime() const { return mUploadTime; }
+
+private:
+	struct Cell
+	{
+		DirectX::XMFLOAT3 Center;
+		DirectX::XMFLOAT3 Extents;
+
+		// Range of the cell's trees in mSprites.
+		UINT First;
+		UINT Count;
+	};
+
+	float SampleDensity(const Desc& desc, float x, float z) const;
+
+	GForest(const GForest&);
+	GForest& operator=(const GForest&);
+
+private:
+	// Trees sorted by cell, so a cell's trees are copied in one block.
+	std::vector<Sprite> mSprites;
+	std::vector<Cell> mCells;
+
+	std::vector<UINT> mVisibleCells;
+	std::vector<UINT> mPrevVisibleCells;
+	UINT mVisibleTrees;
+
+	float mGenerateTime;
+	float mCullTime;
+	float mUploadTime;
+};
+
+#endif // GFOREST_H
\ No newline at end of file
@@ -0,0 +1,218 @@
+/*  ===============================================
+	Summary: Fixed-Timestep Frame Scheduler
+	===============================================  */
+
+#include "GFrameScheduler.h"
+
+#include <algorithm>
+#include <thread>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+
+// Windows 10 1803 and later; older SDKs do not name it.
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+namespace
+{
+	// A high-resolution timer wakes within a fraction of a millisecond; the classic one only
+	// after timeBeginPeriod(1), and then within a millisecond or two.
+	const std::chrono::microseconds HighResolutionSpin(500);
+	const std::chrono::microseconds LowResolutionSpin(2000);
+
+	const uint32_t DefaultMaxStepsPerFrame = 8;
+	const double DefaultMaxFrameTime = 0.25;
+}
+
+GFrameScheduler::GFrameScheduler() :
+	mFixedTimestep(0.0),
+	mAccumulator(0.0),
+	mStepTime(0.0),
+	mAlpha(1.0f),
+	mMaxStepsPerFrame(DefaultMaxStepsPerFrame),
+	mMaxFrameTime(DefaultMaxFrameTime),
+	mFrameRateLimit(0.0),
+	mFrameInterval(Clock::duration::zero()),
+	mSpinThreshold(HighResolutionSpin),
+	mNextFrame(Clock::now()),
+	bLowLatencyMode(false),
+	mWaitTimer(nullptr),
+	bHighResolutionTimer(false),
+	bTimerPeriodRaised(false)
+{
+#if defined(_WIN32)
+	mWaitTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	bHighResolutionTimer = mWaitTimer != nullptr;
+
+	if (!bHighResolutionTimer)
+	{
+		mWaitTimer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+		mSpinThreshold = LowResolutionSpin;
+	}
+#else
+	bHighResolutionTimer = true;
+#endif
+}
+
+GFrameScheduler::~GFrameScheduler()
+{
+#if defined(_WIN32)
+	if (mWaitTimer)
+	{
+		CloseHandle(mWaitTimer);
+	}
+
+	SetTimerPeriodRaised(false);
+#endif
+}
+
+void GFrameScheduler::SetFrameRateLimit(double framesPerSecond)
+{
+	mFrameRateLimit = framesPerSecond > 0.0 ? framesPerSecond : 0.0;
+	mFrameInterval = mFrameRateLimit > 0.0 ?
+		std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / mFrameRateLimit)) : Clock::duration::zero();
+
+	// Only a capped loop sleeps, so only then is the classic timer worth the system-wide cost of a
+	// 1 ms resolution.
+	SetTimerPeriodRaised(!bHighResolutionTimer && mFrameRateLimit > 0.0);
+}
+
+void GFrameScheduler::SetTimerPeriodRaised(bool bRaised)
+{
+	if (bRaised == bTimerPeriodRaised)
+	{
+		return;
+	}
+
+#if defined(_WIN32)
+	if (bRaised)
+	{
+		timeBeginPeriod(1);
+	}
+	else
+	{
+		timeEndPeriod(1);
+	}
+#endif
+
+	bTimerPeriodRaised = bRaised;
+}
+
+void GFrameScheduler::Reset(Clock::time_point now)
+{
+	mNextFrame = now;
+	mAccumulator = 0.0;
+	mAlpha = mFixedTimestep > 0.0 ? 0.0f : 1.0f;
+}
+
+void GFrameScheduler::Reset()
+{
+	Reset(Clock::now());
+}
+
+bool GFrameScheduler::IsFrameDue(Clock::time_point now) const
+{
+	return mFrameInterval == Clock::duration::zero() || now >= mNextFrame;
+}
+
+bool GFrameScheduler::WaitForFrame()
+{
+	for (;;)
+	{
+		Clock::time_point now = Clock::now();
+		if (IsFrameDue(now))
+		{
+			return true;
+		}
+
+		Clock::duration remaining = mNextFrame - now;
+		if (remaining <= mSpinThreshold)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		Clock::duration sleepTime = remaining - mSpinThreshold;
+
+#if defined(_WIN32)
+		if (mWaitTimer)
+		{
+			// Negative due times are relative, in 100 ns units.
+			LARGE_INTEGER dueTime;
+			dueTime.QuadPart = -static_cast<LONGLONG>(std::chrono::duration_cast<std::chrono::nanoseconds>(sleepTime).count() / 100);
+			SetWaitableTimer(mWaitTimer, &dueTime, 0, nullptr, nullptr, FALSE);
+
+			HANDLE timer = mWaitTimer;
+			if (MsgWaitForMultipleObjectsEx(1, &timer, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE) == WAIT_OBJECT_0 + 1)
+			{
+				CancelWaitableTimer(mWaitTimer);
+				return false;
+			}
+		}
+		else
+		{
+			Sleep(static_cast<DWORD>(std::chrono::duration_cast<std::chrono::milliseconds>(sleepTime).count()));
+		}
+#else
+		std::this_thread::sleep_for(sleepTime);
+#endif
+	}
+}
+
+uint32_t GFrameScheduler::BeginFrame(double deltaTime, Clock::time_point now)
+{
+	// The next deadline follows from this one rather than from now, so small wake-up delays do not
+	// add up.  A frame that started more than a whole interval late restarts the cadence instead of
+	// rushing the frames after it.
+	if (mFrameInterval > Clock::duration::zero())
+	{
+		mNextFrame += mFrameInterval;
+		if (mNextFrame < now)
+		{
+			mNextFrame = now + mFrameInterval;
+		}
+	}
+
+	if (mFixedTimestep <= 0.0)
+	{
+		mStepTime = (std::min)(deltaTime, mMaxFrameTime);
+		mAlpha = 1.0f;
+		return 1;
+	}
+
+	mAccumulator += deltaTime;
+
+	double maxTime = mFixedTimestep * mMaxStepsPerFrame;
+	if (mAccumulator > maxTime)
+	{
+		mAccumulator = maxTime;
+	}
+
+	uint32_t steps = static_cast<uint32_t>(mAccumulator / mFixedTimestep);
+	mAccumulator -= steps * mFixedTimestep;
+
+	// Rounding can leave a hair under a whole step behind; it runs next frame.
+	if (mAccumulator < 0.0)
+	{
+		mAccumulator = 0.0;
+	}
+
+	mStepTime = mFixedTimestep;
+	mAlpha = static_cast<float>(mAccumulator / mFixedTimestep);
+	if (mAlpha >= 1.0f)
+	{
+		mAlpha = 0.999999f;
+	}
+
+	return steps;
+}
+
+uint32_t GFrameScheduler::BeginFrame(double deltaTime)
+{
+	return BeginFrame(deltaTime, Clock::now());
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+/*  ===============================================
+	Summary: Fixed-Timestep Frame Scheduler
+	===============================================  */
+
+#ifndef GFRAMESCHEDULER_H
+#define GFRAMESCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+
+// Paces the frame loop.  With a fixed timestep the simulation advances in equal steps however long
+// frames take, and rendering blends the last two steps by GetAlpha.  With a frame-rate cap frames
+// start on a steady cadence: WaitForFrame sleeps on a high-resolution timer through most of the gap
+// and spins only the last stretch, so the cap is accurate without burning a core.  Times can be
+// passed in, so everything but the wait itself runs against a fake clock.
+class GFrameScheduler
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	GFrameScheduler();
+	~GFrameScheduler();
+
+	// Zero runs one step per frame, as long as the frame took up to SetMaxFrameTime.
+	inline void SetFixedTimestep(double seconds) { mFixedTimestep = seconds; mAccumulator = 0.0; }
+	inline double GetFixedTimestep() const { return mFixedTimestep; }
+
+	// After a long stall, such as a breakpoint or a dragged window, at most this many steps run in
+	// one frame and the rest of the time is dropped, so catching up cannot snowball.
+	inline void SetMaxStepsPerFrame(uint32_t steps) { mMaxStepsPerFrame = steps > 0 ? steps : 1; }
+
+	// Without a fixed timestep, the one step a frame runs is at most this long, so a stall the timer
+	// still counted cannot throw the simulation far ahead.
+	inline void SetMaxFrameTime(double seconds) { mMaxFrameTime = seconds; }
+	inline double GetMaxFrameTime() const { return mMaxFrameTime; }
+
+	// Zero leaves the frame rate uncapped.
+	void SetFrameRateLimit(double framesPerSecond);
+	inline double GetFrameRateLimit() const { return mFrameRateLimit; }
+
+	// Whether the system timer resolution is raised to 1 ms, which only the classic waitable timer
+	// needs and only while the frame rate is capped.
+	inline bool IsTimerPeriodRaised() const { return bTimerPeriodRaised; }
+
+	// How long before the deadline WaitForFrame stops sleeping and spins.
+	inline void SetSpinThreshold(Clock::duration threshold) { mSpinThreshold = threshold; }
+
+	// With low latency on, the application keeps no more than one frame queued for the GPU, so input
+	// read at the start of a frame reaches the screen a frame or two sooner.
+	inline void SetLowLatency(bool bLowLatency) { bLowLatencyMode = bLowLatency; }
+	inline bool IsLowLatency() const { return bLowLatencyMode; }
+
+	// Restarts the cadence and drops accumulated simulation time.
+	void Reset(Clock::time_point now);
+	void Reset();
+
+	// When the next frame may start; any time is fine while uncapped.
+	inline Clock::time_point GetFrameDeadline() const { return mNextFrame; }
+	bool IsFrameDue(Clock::time_point now) const;
+
+	// Sleeps until the next frame is due, spinning through the last stretch.  On Windows the wait
+	// also ends when a window message arrives, so the message loop stays responsive; returns true
+	// only once the frame is due.
+	bool WaitForFrame();
+
+	// Starts a frame that took deltaTime since the last one and returns how many simulation steps
+	// to run, each GetStepTime long.
+	uint32_t BeginFrame(double deltaTime, Clock::time_point now);
+	uint32_t BeginFrame(double deltaTime);
+
+	inline double GetStepTime() const { return mStepTime; }
+
+	// How far the render is between the second-to-last and last simulation states, in [0, 1).
+	// Always 1 without a fixed timestep, since the last step ended exactly now.
+	inline float GetAlpha() const { return mAlpha; }
+
+private:
+	// Pairs timeBeginPeriod with timeEndPeriod.
+	void SetTimerPeriodRaised(bool bRaised);
+
+	GFrameScheduler(const GFrameScheduler&);
+	GFrameScheduler& operator=(const GFrameScheduler&);
+
+private:
+	double mFixedTimestep;
+	double mAccumulator;
+	double mStepTime;
+	float mAlpha;
+	uint32_t mMaxStepsPerFrame;
+	double mMaxFrameTime;
+
+	double mFrameRateLimit;
+	Clock::duration mFrameInterval;
+	Clock::duration mSpinThreshold;
+	Clock::time_point mNextFrame;
+
+	bool bLowLatencyMode;
+
+	// Waitable timer handle, high resolution where the OS supports it.
+	void* mWaitTimer;
+	bool bHighResolutionTimer;
+	bool bTimerPeriodRaised;
+};
+
+#endif // GFRAMESCHEDULER_H
\ No newline at end of file
@@ -0,0 +1,107 @@
+/*  ===============================================
+	Summary: 16-Bit Height Quantization
+	===============================================  */
+
+#include "GHeightmapCodec.h"
+
+#include <algorithm>
+#include <emmintrin.h>
+
+void GHeightmapCodec::FindRange(const float* heights, size_t count, float& minHeight, float& maxHeight)
+{
+	if (count == 0)
+	{
+		minHeight = 0.0f;
+		maxHeight = 0.0f;
+		return;
+	}
+
+	__m128 lo = _mm_set1_ps(heights[0]);
+	__m128 hi = lo;
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 h = _mm_loadu_ps(heights + i);
+		lo = _mm_min_ps(lo, h);
+		hi = _mm_max_ps(hi, h);
+	}
+
+	alignas(16) float los[4];
+	alignas(16) float his[4];
+	_mm_store_ps(los, lo);
+	_mm_store_ps(his, hi);
+
+	minHeight = (std::min)((std::min)(los[0], los[1]), (std::min)(los[2], los[3]));
+	maxHeight = (std::max)((std::max)(his[0], his[1]), (std::max)(his[2], his[3]));
+
+	for (; i < count; ++i)
+	{
+		minHeight = (std::min)(minHeight, heights[i]);
+		maxHeight = (std::max)(maxHeight, heights[i]);
+	}
+}
+
+float GHeightmapCodec::GetStep(float minHeight, float maxHeight)
+{
+	return (maxHeight > minHeight) ? (maxHeight - minHeight) / MaxCode : 0.0f;
+}
+
+void GHeightmapCodec::Encode(const float* heights, size_t count, float minHeight, float step, uint16_t* codes)
+{
+	float invStep = (step > 0.0f) ? 1.0f / step : 0.0f;
+
+	const __m128 origin = _mm_set1_ps(minHeight);
+	const __m128 scale = _mm_set1_ps(invStep);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 maxCode = _mm_set1_ps(static_cast<float>(MaxCode));
+
+	// SSE2 has no unsigned 32-to-16 pack, so codes are biased into signed range and back.
+	const __m128i bias = _mm_set1_epi32(32768);
+	const __m128i flip = _mm_set1_epi16(static_cast<short>(0x8000));
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128 a = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(heights + i), origin), scale), half);
+		__m128 b = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(heights + i + 4), origin), scale), half);
+
+		a = _mm_min_ps(_mm_max_ps(a, _mm_setzero_ps()), maxCode);
+		b = _mm_min_ps(_mm_max_ps(b, _mm_setzero_ps()), maxCode);
+
+		__m128i ia = _mm_sub_epi32(_mm_cvttps_epi32(a), bias);
+		__m128i ib = _mm_sub_epi32(_mm_cvttps_epi32(b), bias);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(codes + i), _mm_xor_si128(_mm_packs_epi32(ia, ib), flip));
+	}
+
+	for (; i < count; ++i)
+	{
+		float code = (heights[i] - minHeight) * invStep + 0.5f;
+		codes[i] = static_cast<uint16_t>((std::min)((std::max)(code, 0.0f), static_cast<float>(MaxCode)));
+	}
+}
+
+void GHeightmapCodec::Decode(const uint16_t* codes, size_t count, float minHeight, float step, float* heights)
+{
+	const __m128 origin = _mm_set1_ps(minHeight);
+	const __m128 scale = _mm_set1_ps(step);
+	const __m128i zero = _mm_setzero_si128();
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i));
+
+		__m128 a = _mm_cvtepi32_ps(_mm_unpacklo_epi16(c, zero));
+		__m128 b = _mm_cvtepi32_ps(_mm_unpackhi_epi16(c, zero));
+
+		_mm_storeu_ps(heights + i, _mm_add_ps(_mm_mul_ps(a, scale), origin));
+		_mm_storeu_ps(heights + i + 4, _mm_add_ps(_mm_mul_ps(b, scale), origin));
+	}
+
+	for (; i < count; ++i)
+	{
+		heights[i] = minHeight + codes[i] * step;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+/*  ===============================================
+	Summary: 16-Bit Height Quantization
+	===============================================  */
+
+#ifndef GHEIGHTMAPCODEC_H
+#define GHEIGHTMAPCODEC_H
+
+#include <Windows.h>
+#include <cstdint>
+
+// Stores heights as 16-bit codes over a range, height = minHeight + code * step, at half the
+// size of floats.  Precision follows the range: a tile spanning 100 meters keeps steps of
+// about 1.5 millimeters.  The codes are also what an R16_UNORM texture holds, with
+// minHeight and a range of 65535 * step passed to the shaders.
+class GHeightmapCodec
+{
+public:
+	static const UINT MaxCode = 65535;
+
+	static void FindRange(const float* heights, size_t count, float& minHeight, float& maxHeight);
+
+	// Step that spreads [minHeight, maxHeight] over every code; 0 for a flat range.
+	static float GetStep(float minHeight, float maxHeight);
+
+	// Rounds to the nearest code; heights outside the range are clamped.
+	static void Encode(const float* heights, size_t count, float minHeight, float step, uint16_t* codes);
+	static void Decode(const uint16_t* codes, size_t count, float minHeight, float step, float* heights);
+};
+
+#endif // GHEIGHTMAPCODEC_H
\ No newline at end of file
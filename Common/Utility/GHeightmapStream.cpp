@@ -0,0 +1,442 @@
+/*  ===============================================
+	Summary: Streaming Tiled Heightmap
+	===============================================  */
+
+#include "GHeightmapStream.h"
+#include "GHeightmapCodec.h"
+#include "GThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	const UINT RowsPerRange = 16;
+
+	struct TileRequest
+	{
+		UINT Index;
+		float DistSq;
+
+		bool operator<(const TileRequest& rhs) const { return DistSq < rhs.DistSq; }
+	};
+}
+
+GHeightmapStream::GHeightmapStream() :
+	mFormat(FORMAT_R8),
+	mHeightScale(1.0f),
+	mWidth(0),
+	mDepth(0),
+	mTileSize(0),
+	mTilesX(0),
+	mTilesZ(0),
+	mBudget(64 * 1024 * 1024),
+	mStreamRadius(1024.0f),
+	mFrame(0),
+	mResidentCount(0),
+	mPendingCount(0),
+	mLoadCount(0),
+	mEvictCount(0),
+	mLoaderBusy(false),
+	mShutdown(false)
+{
+}
+
+GHeightmapStream::~GHeightmapStream()
+{
+	Close();
+}
+
+bool GHeightmapStream::Open(LPCWSTR filename, Format format, float heightScale, UINT width, UINT depth, UINT tileSize)
+{
+	Close();
+
+	if (!mFile.Open(filename))
+	{
+		return false;
+	}
+
+	mFormat = format;
+
+	UINT64 numSamples = mFile.GetSize() / GetSampleBytes();
+
+	if (width == 0 || depth == 0)
+	{
+		UINT64 side = static_cast<UINT64>(sqrt(static_cast<double>(numSamples)) + 0.5);
+		width = static_cast<UINT>(side);
+		depth = static_cast<UINT>(side);
+	}
+
+	if (width == 0 || depth == 0 || static_cast<UINT64>(width) * depth > numSamples || tileSize == 0)
+	{
+		mFile.Close();
+		return false;
+	}
+
+	mHeightScale = heightScale;
+	mWidth = width;
+	mDepth = depth;
+	mTileSize = tileSize;
+
+	// Tiles cover cells, not samples, so a (n * tileSize + 1)-sample map splits into exactly n tiles.
+	mTilesX = (std::max)(1u, (mWidth - 1 + mTileSize - 1) / mTileSize);
+	mTilesZ = (std::max)(1u, (mDepth - 1 + mTileSize - 1) / mTileSize);
+
+	Tile empty;
+	empty.State = TILE_UNLOADED;
+	empty.LastUsed = 0;
+	mTiles.assign(mTilesX * mTilesZ, empty);
+
+	mFrame = 0;
+	mResidentCount = 0;
+	mPendingCount = 0;
+	mLoadCount = 0;
+	mEvictCount = 0;
+
+	mShutdown = false;
+	mLoader = std::thread(&GHeightmapStream::LoaderLoop, this);
+
+	return true;
+}
+
+void GHeightmapStream::Close()
+{
+	if (mLoader.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mShutdown = true;
+		}
+
+		mRequestReady.notify_all();
+		mLoader.join();
+	}
+
+	mRequests.clear();
+	mLoaded.clear();
+	mLoaderBusy = false;
+
+	mTiles.clear();
+	mWanted.clear();
+	mResidentCount = 0;
+	mPendingCount = 0;
+
+	mFile.Close();
+}
+
+void GHeightmapStream::ConvertRow(const uint8_t* src, UINT count, float* dst) const
+{
+	switch (mFormat)
+	{
+	case FORMAT_R8:
+	{
+		float scale = mHeightScale / 255.0f;
+		for (UINT i = 0; i < count; ++i)
+		{
+			dst[i] = src[i] * scale;
+		}
+		break;
+	}
+
+	case FORMAT_R16:
+	{
+		float scale = mHeightScale / 65535.0f;
+		for (UINT i = 0; i < count; ++i)
+		{
+			dst[i] = (src[2 * i] | (src[2 * i + 1] << 8)) * scale;
+		}
+		break;
+	}
+
+	case FORMAT_R32F:
+		// The mapping need not be aligned for floats.
+		memcpy(dst, src, count * sizeof(float));
+		for (UINT i = 0; i < count; ++i)
+		{
+			dst[i] *= mHeightScale;
+		}
+		break;
+	}
+}
+
+void GHeightmapStream::ReadRegion(UINT x, UINT z, UINT width, UINT depth, float* out, UINT outPitch) const
+{
+	const uint8_t* data = mFile.GetData();
+
+	GThreadPool::Get().ParallelFor(depth, RowsPerRange, [&](UINT begin, UINT end)
+	{
+		for (UINT row = begin; row < end; ++row)
+		{
+			UINT64 first = static_cast<UINT64>(z + row) * mWidth + x;
+			ConvertRow(data + first * GetSampleBytes(), width, out + static_cast<size_t>(row) * outPitch);
+		}
+	});
+}
+
+void GHeightmapStream::LoadTile(UINT index, TileCodes& data) const
+{
+	UINT x0 = (index % mTilesX) * mTileSize;
+	UINT z0 = (index / mTilesX) * mTileSize;
+	UINT stride = GetTileStride();
+	size_t numSamples = static_cast<size_t>(stride) * stride;
+
+	std::vector<float> heights(numSamples);
+
+	// Samples past the edge of the map repeat the last row or column.
+	UINT cols = (std::min)(stride, mWidth - x0);
+
+	for (UINT row = 0; row < stride; ++row)
+	{
+		UINT z = (std::min)(z0 + row, mDepth - 1);
+		const uint8_t* src = mFile.GetData() + (static_cast<UINT64>(z) * mWidth + x0) * GetSampleBytes();
+		float* dst = &heights[static_cast<size_t>(row) * stride];
+
+		ConvertRow(src, cols, dst);
+
+		for (UINT col = cols; col < stride; ++col)
+		{
+			dst[col] = dst[cols - 1];
+		}
+	}
+
+	float maxHeight;
+	GHeightmapCodec::FindRange(heights.data(), numSamples, data.MinHeight, maxHeight);
+	data.Step = GHeightmapCodec::GetStep(data.MinHeight, maxHeight);
+
+	data.Codes.resize(numSamples);
+	GHeightmapCodec::Encode(heights.data(), numSamples, data.MinHeight, data.Step, data.Codes.data());
+}
+
+void GHeightmapStream::LoaderLoop()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	for (;;)
+	{
+		mRequestReady.wait(lock, [this] { return mShutdown || !mRequests.empty(); });
+
+		if (mShutdown)
+		{
+			return;
+		}
+
+		LoadedTile loaded;
+		loaded.Index = mRequests.front();
+		mRequests.pop_front();
+		mLoaderBusy = true;
+
+		// Page faults on the mapping happen here, off the rendering thread.
+		lock.unlock();
+		LoadTile(loaded.Index, loaded.Data);
+		lock.lock();
+
+		mLoaded.push_back(std::move(loaded));
+		mLoaderBusy = false;
+		mLoadDone.notify_all();
+	}
+}
+
+void GHeightmapStream::RetireLoads()
+{
+	std::vector<LoadedTile> loaded;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		loaded.swap(mLoaded);
+	}
+
+	for (size_t i = 0; i < loaded.size(); ++i)
+	{
+		Tile& tile = mTiles[loaded[i].Index];
+		tile.Data = std::move(loaded[i].Data);
+		tile.State = TILE_RESIDENT;
+		tile.LastUsed = mFrame;
+
+		--mPendingCount;
+		++mResidentCount;
+		++mLoadCount;
+	}
+}
+
+void GHeightmapStream::Evict(UINT maxTiles)
+{
+	if (mResidentCount + mPendingCount <= maxTiles)
+	{
+		return;
+	}
+
+	// Least recently used first; tiles wanted this frame are never evicted.
+	std::vector<UINT> candidates;
+	for (UINT i = 0; i < mTiles.size(); ++i)
+	{
+		if (mTiles[i].State == TILE_RESIDENT && mTiles[i].LastUsed != mFrame)
+		{
+			candidates.push_back(i);
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [this](UINT a, UINT b)
+	{
+		return mTiles[a].LastUsed < mTiles[b].LastUsed;
+	});
+
+	for (size_t i = 0; i < candidates.size() && mResidentCount + mPendingCount > maxTiles; ++i)
+	{
+		Tile& tile = mTiles[candidates[i]];
+		std::vector<uint16_t>().swap(tile.Data.Codes);
+		tile.State = TILE_UNLOADED;
+
+		--mResidentCount;
+		++mEvictCount;
+	}
+}
+
+void GHeightmapStream::SetMemoryBudget(UINT64 bytes)
+{
+	mBudget = bytes;
+}
+
+void GHeightmapStream::SetStreamRadius(float radius)
+{
+	mStreamRadius = radius;
+}
+
+void GHeightmapStream::Update(float x, float z)
+{
+	if (mTiles.empty())
+	{
+		return;
+	}
+
+	RetireLoads();
+	++mFrame;
+
+	UINT maxTiles = static_cast<UINT>(std::max<UINT64>(1, mBudget / GetTileBytes()));
+
+	// Gather the tiles whose bounds come within the stream radius, nearest first.
+	float tileSize = static_cast<float>(mTileSize);
+	int minX = (std::max)(0, static_cast<int>(floorf((x - mStreamRadius) / tileSize)));
+	int maxX = (std::min)(static_cast<int>(mTilesX) - 1, static_cast<int>(floorf((x + mStreamRadius) / tileSize)));
+	int minZ = (std::max)(0, static_cast<int>(floorf((z - mStreamRadius) / tileSize)));
+	int maxZ = (std::min)(static_cast<int>(mTilesZ) - 1, static_cast<int>(floorf((z + mStreamRadius) / tileSize)));
+
+	std::vector<TileRequest> wanted;
+	float radiusSq = mStreamRadius * mStreamRadius;
+
+	for (int tz = minZ; tz <= maxZ; ++tz)
+	{
+		for (int tx = minX; tx <= maxX; ++tx)
+		{
+			float dx = (std::max)(0.0f, (std::max)(tx * tileSize - x, x - (tx + 1) * tileSize));
+			float dz = (std::max)(0.0f, (std::max)(tz * tileSize - z, z - (tz + 1) * tileSize));
+
+			TileRequest request;
+			request.Index = tz * mTilesX + tx;
+			request.DistSq = dx * dx + dz * dz;
+
+			if (request.DistSq <= radiusSq)
+			{
+				wanted.push_back(request);
+			}
+		}
+	}
+
+	std::sort(wanted.begin(), wanted.end());
+
+	// A radius larger than the budget keeps the nearest tiles only.
+	if (wanted.size() > maxTiles)
+	{
+		wanted.resize(maxTiles);
+	}
+
+	mWanted.clear();
+	for (size_t i = 0; i < wanted.size(); ++i)
+	{
+		mTiles[wanted[i].Index].LastUsed = mFrame;
+		mWanted.push_back(wanted[i].Index);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		// Requests that have not started yet are dropped and re-queued in the new order,
+		// so a fast-moving camera does not wait behind tiles it has already left.
+		for (size_t i = 0; i < mRequests.size(); ++i)
+		{
+			mTiles[mRequests[i]].State = TILE_UNLOADED;
+			--mPendingCount;
+		}
+
+		mRequests.clear();
+
+		// Make room for the new loads before issuing them.
+		UINT numNewLoads = 0;
+		for (size_t i = 0; i < mWanted.size(); ++i)
+		{
+			numNewLoads += (mTiles[mWanted[i]].State == TILE_UNLOADED) ? 1 : 0;
+		}
+
+		Evict(maxTiles - numNewLoads);
+
+		for (size_t i = 0; i < mWanted.size(); ++i)
+		{
+			Tile& tile = mTiles[mWanted[i]];
+			if (tile.State == TILE_UNLOADED)
+			{
+				tile.State = TILE_PENDING;
+				++mPendingCount;
+				mRequests.push_back(mWanted[i]);
+			}
+		}
+	}
+
+	mRequestReady.notify_one();
+}
+
+void GHeightmapStream::Flush()
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mLoadDone.wait(lock, [this] { return mShutdown || (mRequests.empty() && !mLoaderBusy); });
+	}
+
+	RetireLoads();
+}
+
+bool GHeightmapStream::DecodeTile(UINT tileX, UINT tileZ, float* out) const
+{
+	if (tileX >= mTilesX || tileZ >= mTilesZ)
+	{
+		return false;
+	}
+
+	const Tile& tile = mTiles[tileZ * mTilesX + tileX];
+	if (tile.State != TILE_RESIDENT)
+	{
+		return false;
+	}
+
+	GHeightmapCodec::Decode(tile.Data.Codes.data(), tile.Data.Codes.size(), tile.Data.MinHeight, tile.Data.Step, out);
+	return true;
+}
+
+bool GHeightmapStream::GetSample(UINT x, UINT z, float& height) const
+{
+	if (x >= mWidth || z >= mDepth)
+	{
+		return false;
+	}
+
+	UINT tileX = (std::min)(x / mTileSize, mTilesX - 1);
+	UINT tileZ = (std::min)(z / mTileSize, mTilesZ - 1);
+
+	const Tile& tile = mTiles[tileZ * mTilesX + tileX];
+	if (tile.State != TILE_RESIDENT)
+	{
+		return false;
+	}
+
+	uint16_t code = tile.Data.Codes[(z - tileZ * mTileSize) * GetTileStride() + (x - tileX * mTileSize)];
+	height = tile.Data.MinHeight + code * tile.Data.Step;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+/*  ===============================================
+	Summary: Streaming Tiled Heightmap
+	===============================================  */
+
+#ifndef GHEIGHTMAPSTREAM_H
+#define GHEIGHTMAPSTREAM_H
+
+#include "GMappedFile.h"
+
+#include <Windows.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Serves a RAW heightmap of any size from a memory-mapped file.  The map is split into
+// square tiles; Update keeps the tiles around a point resident under a memory budget,
+// loading new tiles on a background thread and evicting the least recently used ones.
+// Resident tiles are held as 16-bit codes over their own height range (see GHeightmapCodec)
+// and decoded on demand, so a budget holds twice as many tiles as it would as floats.
+class GHeightmapStream
+{
+public:
+	enum Format
+	{
+		FORMAT_R8,
+		FORMAT_R16,
+		FORMAT_R32F,
+	};
+
+	GHeightmapStream();
+	~GHeightmapStream();
+
+	// Samples are stored row by row and little-endian.  Integer samples are unsigned and map
+	// [0, max] to [0, heightScale]; float samples are multiplied by heightScale.
+	// Passing a width and depth of 0 treats the file as square and derives the size from its length.
+	bool Open(LPCWSTR filename, Format format, float heightScale, UINT width = 0, UINT depth = 0, UINT tileSize = 256);
+	void Close();
+
+	// Converts a block of samples straight from the file, bypassing the tile cache.
+	// outPitch is the distance between rows of out, in floats.
+	void ReadRegion(UINT x, UINT z, UINT width, UINT depth, float* out, UINT outPitch) const;
+
+	void SetMemoryBudget(UINT64 bytes);
+
+	// Radius, in samples, around the streaming centre that should be resident.
+	void SetStreamRadius(float radius);
+
+	// Retires finished loads, then requests the tiles within the stream radius of (x, z),
+	// nearest first.  Coordinates are in samples.  Never blocks on disk.
+	void Update(float x, float z);
+
+	// Blocks until every requested tile is resident.
+	void Flush();
+
+	// Tiles hold (tileSize + 1)^2 samples so a tile can be filtered without its neighbours.
+	// Decodes a tile into out, which must hold that many floats.  Returns false if the tile
+	// is not resident.
+	bool DecodeTile(UINT tileX, UINT tileZ, float* out) const;
+
+	// Returns false if the tile holding the sample is not resident.
+	bool GetSample(UINT x, UINT z, float& height) const;
+
+	inline UINT GetWidth() const { return mWidth; }
+	inline UINT GetDepth() const { return mDepth; }
+	inline UINT GetTileSize() const { return mTileSize; }
+	inline UINT GetTilesX() const { return mTilesX; }
+	inline UINT GetTilesZ() const { return mTilesZ; }
+
+	inline UINT GetResidentTileCount() const { return mResidentCount; }
+	inline UINT GetPendingTileCount() const { return mPendingCount; }
+	inline UINT64 GetResidentBytes() const { return static_cast<UINT64>(mResidentCount) * GetTileBytes(); }
+	inline UINT GetLoadCount() const { return mLoadCount; }
+	inline UINT GetEvictCount() const { return mEvictCount; }
+
+private:
+	enum TileState
+	{
+		TILE_UNLOADED,
+		TILE_PENDING,
+		TILE_RESIDENT,
+	};
+
+	// Height = MinHeight + code * Step.
+	struct TileCodes
+	{
+		std::vector<uint16_t> Codes;
+		float MinHeight;
+		float Step;
+	};
+
+	struct Tile
+	{
+		TileCodes Data;
+		TileState State;
+		UINT64 LastUsed;
+	};
+
+	struct LoadedTile
+	{
+		UINT Index;
+		TileCodes Data;
+	};
+
+	void LoaderLoop();
+	void LoadTile(UINT index, TileCodes& data) const;
+	void RetireLoads();
+	void Evict(UINT maxTiles);
+
+	void ConvertRow(const uint8_t* src, UINT count, float* dst) const;
+	inline UINT GetSampleBytes() const { return (mFormat == FORMAT_R32F) ? 4 : (mFormat == FORMAT_R16) ? 2 : 1; }
+	inline UINT GetTileStride() const { return mTileSize + 1; }
+	inline UINT64 GetTileBytes() const { return static_cast<UINT64>(GetTileStride()) * GetTileStride() * sizeof(uint16_t); }
+
+	GHeightmapStream(const GHeightmapStream&);
+	GHeightmapStream& operator=(const GHeightmapStream&);
+
+private:
+	GMappedFile mFile;
+
+	Format mFormat;
+	float mHeightScale;
+
+	UINT mWidth;
+	UINT mDepth;
+	UINT mTileSize;
+	UINT mTilesX;
+	UINT mTilesZ;
+
+	UINT64 mBudget;
+	float mStreamRadius;
+
+	// Only touched by the thread calling Update; the loader sees tile indices, never tiles.
+	std::vector<Tile> mTiles;
+	std::vector<UINT> mWanted;
+	UINT64 mFrame;
+
+	UINT mResidentCount;
+	UINT mPendingCount;
+	UINT mLoadCount;
+	UINT mEvictCount;
+
+	// Loader thread state, guarded by mMutex.
+	std::thread mLoader;
+	std::mutex mMutex;
+	std::condition_variable mRequestReady;
+	std::condition_variable mLoadDone;
+	std::deque<UINT> mRequests;
+	std::vector<LoadedTile> mLoaded;
+	bool mLoaderBusy;
+	bool mShutdown;
+};
+
+#endif // GHEIGHTMAPSTREAM_H
\ No newline at end of file
@@ -0,0 +1,464 @@
+/*  ===============================================
+	Summary: CPU Separable Blur
+	===============================================  */
+
+#include "GImageBlur.h"
+#include "GThreadPool.h"
+
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	// Lines filtered together before their results are written out as columns.  Sixteen RGBA
+	// float pixels fill four cache lines of each destination row.
+	const UINT LinesPerBand = 16;
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	inline float GetMilliseconds(Clock::time_point start)
+	{
+		return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+	}
+
+	inline UINT GetChannelCount(GImageBlur::Format format)
+	{
+		return format == GImageBlur::FORMAT_R32_FLOAT ? 1 : 4;
+	}
+
+	// Reads count floats from a line stored in format, or already as floats.
+	void LoadLine(GImageBlur::Format format, bool bFormat, const uint8_t* src, UINT count, float* dst)
+	{
+		if (bFormat && format == GImageBlur::FORMAT_R16G16B16A16_FLOAT)
+		{
+			XMConvertHalfToFloatStream(dst, sizeof(float), reinterpret_cast<const HALF*>(src), sizeof(HALF), count);
+		}
+		else
+		{
+			memcpy(dst, src, count * sizeof(float));
+		}
+	}
+
+	void StoreLine(GImageBlur::Format format, bool bFormat, const float* src, UINT count, uint8_t* dst)
+	{
+		if (bFormat && format == GImageBlur::FORMAT_R16G16B16A16_FLOAT)
+		{
+			XMConvertFloatToHalfStream(reinterpret_cast<HALF*>(dst), sizeof(HALF), src, sizeof(float), count);
+		}
+		else
+		{
+			memcpy(dst, src, count * sizeof(float));
+		}
+	}
+
+	inline UINT GetElementBytes(GImageBlur::Format format, bool bFormat)
+	{
+		return (bFormat && format == GImageBlur::FORMAT_R16G16B16A16_FLOAT) ? sizeof(HALF) : sizeof(float);
+	}
+
+	// Repeats the first and last pixel radius times on either side, as CLAMP addressing does.
+	// line points at the first pixel of length, with room for the copies around it.
+	void PadLine(float* line, UINT length, UINT channels, UINT radius)
+	{
+		const float* first = line;
+		const float* last = line + (length - 1) * channels;
+
+		for (UINT i = 1; i <= radius; ++i)
+		{
+			memcpy(line - i * channels, first, channels * sizeof(float));
+			memcpy(line + (length - 1 + i) * channels, last, channels * sizeof(float));
+		}
+	}
+
+	// out[x] = sum of weights[t] * padded[x + t], four pixels per vector.  Two vectors are summed
+	// at once so the additions are not one long dependency chain.
+	void ConvolveLine1(const float* padded, UINT length, const float* weights, UINT taps, float* out)
+	{
+		UINT x = 0;
+		for (; x + 8 <= length; x += 8)
+		{
+			__m128 sum0 = _mm_setzero_ps();
+			__m128 sum1 = _mm_setzero_ps();
+			for (UINT t = 0; t < taps; ++t)
+			{
+				__m128 w = _mm_set1_ps(weights[t]);
+				sum0 = _mm_add_ps(sum0, _mm_mul_ps(w, _mm_loadu_ps(padded + x + t)));
+				sum1 = _mm_add_ps(sum1, _mm_mul_ps(w, _mm_loadu_ps(padded + x + t + 4)));
+			}
+			_mm_storeu_ps(out + x, sum0);
+			_mm_storeu_ps(out + x + 4, sum1);
+		}
+
+		for (; x < length; ++x)
+		{
+			float sum = 0.0f;
+			for (UINT t = 0; t < taps; ++t)
+			{
+				sum += weights[t] * padded[x + t];
+			}
+			out[x] = sum;
+		}
+	}
+
+	// The same for RGBA, one pixel per vector and four pixels at a time.
+	void ConvolveLine4(const float* padded, UINT length, const float* weights, UINT taps, float* out)
+	{
+		UINT x = 0;
+		for (; x + 4 <= length; x += 4)
+		{
+			const float* src = padded + x * 4;
+			__m128 sum0 = _mm_setzero_ps();
+			__m128 sum1 = _mm_setzero_ps();
+			__m128 sum2 = _mm_setzero_ps();
+			__m128 sum3 = _mm_setzero_ps();
+			for (UINT t = 0; t < taps; ++t)
+			{
+				__m128 w = _mm_set1_ps(weights[t]);
+				const float* tap = src + t * 4;
+				sum0 = _mm_add_ps(sum0, _mm_mul_ps(w, _mm_loadu_ps(tap)));
+				sum1 = _mm_add_ps(sum1, _mm_mul_ps(w, _mm_loadu_ps(tap + 4)));
+				sum2 = _mm_add_ps(sum2, _mm_mul_ps(w, _mm_loadu_ps(tap + 8)));
+				sum3 = _mm_add_ps(sum3, _mm_mul_ps(w, _mm_loadu_ps(tap + 12)));
+			}
+			_mm_storeu_ps(out + x * 4, sum0);
+			_mm_storeu_ps(out + x * 4 + 4, sum1);
+			_mm_storeu_ps(out + x * 4 + 8, sum2);
+			_mm_storeu_ps(out + x * 4 + 12, sum3);
+		}
+
+		for (; x < length; ++x)
+		{
+			const float* src = padded + x * 4;
+			__m128 sum = _mm_setzero_ps();
+			for (UINT t = 0; t < taps; ++t)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(src + t * 4)));
+			}
+			_mm_storeu_ps(out + x * 4, sum);
+		}
+	}
+
+	// Guide planes for one padded line, split by component so four pixels load at once.
+	struct GuideLine
+	{
+		const float* NormalX;
+		const float* NormalY;
+		const float* NormalZ;
+		const float* Depth;
+	};
+
+	// Edge-aware version of ConvolveLine1.  The center always counts, as in BlurPS.hlsl.
+	void BilateralLine1(const float* padded, const GuideLine& guide, UINT length, const float* weights, UINT radius,
+		float normalThreshold, float depthThreshold, float* out)
+	{
+		const UINT taps = 2 * radius + 1;
+		const __m128 normalLimit = _mm_set1_ps(normalThreshold);
+		const __m128 depthLimit = _mm_set1_ps(depthThreshold);
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+		UINT x = 0;
+		for (; x + 4 <= length; x += 4)
+		{
+			UINT c = x + radius;
+			__m128 cx = _mm_loadu_ps(guide.NormalX + c);
+			__m128 cy = _mm_loadu_ps(guide.NormalY + c);
+			__m128 cz = _mm_loadu_ps(guide.NormalZ + c);
+			__m128 cd = _mm_loadu_ps(guide.Depth + c);
+
+			__m128 total = _mm_set1_ps(weights[radius]);
+			__m128 sum = _mm_mul_ps(total, _mm_loadu_ps(padded + c));
+
+			for (UINT t = 0; t < taps; ++t)
+			{
+				if (t == radius)
+				{
+					continue;
+				}
+
+				UINT n = x + t;
+				__m128 dot = _mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(cx, _mm_loadu_ps(guide.NormalX + n)),
+					_mm_mul_ps(cy, _mm_loadu_ps(guide.NormalY + n))),
+					_mm_mul_ps(cz, _mm_loadu_ps(guide.NormalZ + n)));
+				__m128 depthDiff = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(guide.Depth + n), cd), absMask);
+				__m128 keep = _mm_and_ps(_mm_cmpge_ps(dot, normalLimit), _mm_cmple_ps(depthDiff, depthLimit));
+
+				__m128 weight = _mm_and_ps(keep, _mm_set1_ps(weights[t]));
+				sum = _mm_add_ps(sum, _mm_mul_ps(weight, _mm_loadu_ps(padded + n)));
+				total = _mm_add_ps(total, weight);
+			}
+
+			_mm_storeu_ps(out + x, _mm_div_ps(sum, total));
+		}
+
+		for (; x < length; ++x)
+		{
+			UINT c = x + radius;
+			float total = weights[radius];
+			float sum = total * padded[c];
+
+			for (UINT t = 0; t < taps; ++t)
+			{
+				UINT n = x + t;
+				float dot = guide.NormalX[c] * guide.NormalX[n] + guide.NormalY[c] * guide.NormalY[n] + guide.NormalZ[c] * guide.NormalZ[n];
+				if (t != radius && dot >= normalThreshold && fabsf(guide.Depth[n] - guide.Depth[c]) <= depthThreshold)
+				{
+					sum += weights[t] * padded[n];
+					total += weights[t];
+				}
+			}
+
+			out[x] = sum / total;
+		}
+	}
+
+	// Edge-aware version of ConvolveLine4.
+	void BilateralLine4(const float* padded, const GuideLine& guide, UINT length, const float* weights, UINT radius,
+		float normalThreshold, float depthThreshold, float* out)
+	{
+		const UINT taps = 2 * radius + 1;
+
+		for (UINT x = 0; x < length; ++x)
+		{
+			UINT c = x + radius;
+			float total = weights[radius];
+			__m128 sum = _mm_mul_ps(_mm_set1_ps(total), _mm_loadu_ps(padded + c * 4));
+
+			for (UINT t = 0; t < taps; ++t)
+			{
+				UINT n = x + t;
+				float dot = guide.NormalX[c] * guide.NormalX[n] + guide.NormalY[c] * guide.NormalY[n] + guide.NormalZ[c] * guide.NormalZ[n];
+				if (t != radius && dot >= normalThreshold && fabsf(guide.Depth[n] - guide.Depth[c]) <= depthThreshold)
+				{
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(padded + n * 4)));
+					total += weights[t];
+				}
+			}
+
+			_mm_storeu_ps(out + x * 4, _mm_div_ps(sum, _mm_set1_ps(total)));
+		}
+	}
+}
+
+const UINT GImageBlur::MaxRadius;
+
+UINT GImageBlur::ComputeGaussianWeights(float sigma, UINT radius, std::vector<float>& weights)
+{
+	sigma = (std::max)(sigma, 1e-3f);
+	if (radius == 0)
+	{
+		radius = static_cast<UINT>(ceilf(3.0f * sigma));
+	}
+	radius = (std::min)((std::max)(radius, 1u), MaxRadius);
+
+	weights.resize(2 * radius + 1);
+
+	float sum = 0.0f;
+	for (UINT i = 0; i < weights.size(); ++i)
+	{
+		float x = static_cast<float>(i) - static_cast<float>(radius);
+		weights[i] = expf(-x * x / (2.0f * sigma * sigma));
+		sum += weights[i];
+	}
+
+	for (UINT i = 0; i < weights.size(); ++i)
+	{
+		weights[i] /= sum;
+	}
+
+	return radius;
+}
+
+GImageBlur::GImageBlur() :
+	mRadius(0),
+	mThreadCount(0),
+	mBlurTime(0.0f)
+{
+	SetGaussian(2.5f, 5);
+}
+
+GImageBlur::~GImageBlur()
+{
+}
+
+void GImageBlur::SetGaussian(float sigma, UINT radius)
+{
+	mRadius = ComputeGaussianWeights(sigma, radius, mWeights);
+}
+
+void GImageBlur::SetWeights(const float* weights, UINT radius)
+{
+	mRadius = (std::min)(radius, MaxRadius);
+	mWeights.assign(weights, weights + 2 * mRadius + 1);
+}
+
+void GImageBlur::Blur(Format format, void* image, UINT width, UINT height, UINT rowPitch, UINT numPasses)
+{
+	Run(format, image, width, height, rowPitch, nullptr, 0.0f, 0.0f, numPasses);
+}
+
+void GImageBlur::BilateralBlur(Format format, void* image, UINT width, UINT height, UINT rowPitch,
+	const XMFLOAT4* normalDepth, float normalThreshold, float depthThreshold, UINT numPasses)
+{
+	Run(format, image, width, height, rowPitch, normalDepth, normalThreshold, depthThreshold, numPasses);
+}
+
+void GImageBlur::Run(Format format, void* image, UINT width, UINT height, UINT rowPitch,
+	const XMFLOAT4* normalDepth, float normalThreshold, float depthThreshold, UINT numPasses)
+{
+	Clock::time_point start = Clock::now();
+
+	if (width == 0 || height == 0)
+	{
+		mBlurTime = 0.0f;
+		return;
+	}
+
+	const UINT channels = GetChannelCount(format);
+	mTransposed.resize(static_cast<size_t>(width) * height * channels);
+
+	// The column half of each pass needs the guide in column order too.
+	if (normalDepth)
+	{
+		mTransposedGuide.resize(static_cast<size_t>(width) * height);
+		XMFLOAT4* transposed = mTransposedGuide.data();
+
+		GThreadPool::Get().ParallelFor(width, 64, [=](UINT begin, UINT end)
+		{
+			for (UINT y = 0; y < height; ++y)
+			{
+				const XMFLOAT4* row = normalDepth + static_cast<size_t>(y) * width;
+				for (UINT x = begin; x < end; ++x)
+				{
+					transposed[static_cast<size_t>(x) * height + y] = row[x];
+				}
+			}
+		});
+	}
+
+	const UINT transposedPitch = height * channels * sizeof(float);
+
+	for (UINT pass = 0; pass < numPasses; ++pass)
+	{
+		FilterLines(image, true, mTransposed.data(), false, format, rowPitch, transposedPitch, width, height,
+			normalDepth, normalThreshold, depthThreshold);
+		FilterLines(mTransposed.data(), false, image, true, format, transposedPitch, rowPitch, height, width,
+			normalDepth ? mTransposedGuide.data() : nullptr, normalThreshold, depthThreshold);
+	}
+
+	mBlurTime = GetMilliseconds(start);
+}
+
+void GImageBlur::FilterLines(const void* src, bool bSrcFormat, void* dst, bool bDstFormat, Format format,
+	UINT srcPitch, UINT dstPitch, UINT lineLength, UINT lineCount,
+	const XMFLOAT4* guide, float normalThreshold, float depthThreshold)
+{
+	const UINT channels = GetChannelCount(format);
+	const UINT radius = mRadius;
+	const UINT taps = 2 * radius + 1;
+	const float* weights = mWeights.data();
+	const UINT dstElementBytes = GetElementBytes(format, bDstFormat);
+
+	const uint8_t* srcBytes = static_cast<const uint8_t*>(src);
+	uint8_t* dstBytes = static_cast<uint8_t*>(dst);
+
+	const UINT numBands = (lineCount + LinesPerBand - 1) / LinesPerBand;
+
+	GThreadPool& pool = GThreadPool::Get();
+	UINT numJobs = pool.GetThreadCount();
+	if (mThreadCount > 0)
+	{
+		numJobs = (std::min)(numJobs, mThreadCount);
+	}
+	numJobs = (std::min)(numJobs, numBands);
+
+	// One job per thread, each taking every numJobs-th band, so SetThreadCount caps the
+	// threads that actually run.
+	pool.Dispatch(numJobs, [&](UINT job)
+	{
+		const UINT paddedLength = lineLength + 2 * radius;
+		std::vector<float> padded(paddedLength * channels);
+		std::vector<float> filtered(static_cast<size_t>(LinesPerBand) * lineLength * channels);
+		std::vector<float> column(LinesPerBand * channels);
+		std::vector<float> guidePlanes(guide ? paddedLength * 4 : 0);
+
+		GuideLine guideLine = {};
+		if (guide)
+		{
+			guideLine.NormalX = guidePlanes.data();
+			guideLine.NormalY = guidePlanes.data() + paddedLength;
+			guideLine.NormalZ = guidePlanes.data() + paddedLength * 2;
+			guideLine.Depth = guidePlanes.data() + paddedLength * 3;
+		}
+
+		for (UINT band = job; band < numBands; band += numJobs)
+		{
+			UINT first = band * LinesPerBand;
+			UINT count = (std::min)(LinesPerBand, lineCount - first);
+
+			for (UINT i = 0; i < count; ++i)
+			{
+				UINT line = first + i;
+				float* lineStart = padded.data() + radius * channels;
+				LoadLine(format, bSrcFormat, srcBytes + static_cast<size_t>(line) * srcPitch, lineLength * channels, lineStart);
+				PadLine(lineStart, lineLength, channels, radius);
+
+				float* out = filtered.data() + static_cast<size_t>(i) * lineLength * channels;
+
+				if (guide)
+				{
+					const XMFLOAT4* texels = guide + static_cast<size_t>(line) * lineLength;
+					for (UINT p = 0; p < paddedLength; ++p)
+					{
+						int x = static_cast<int>(p) - static_cast<int>(radius);
+						const XMFLOAT4& texel = texels[(std::min)((std::max)(x, 0), static_cast<int>(lineLength) - 1)];
+						guidePlanes[p] = texel.x;
+						guidePlanes[paddedLength + p] = texel.y;
+						guidePlanes[paddedLength * 2 + p] = texel.z;
+						guidePlanes[paddedLength * 3 + p] = texel.w;
+					}
+
+					if (channels == 1)
+					{
+						BilateralLine1(padded.data(), guideLine, lineLength, weights, radius, normalThreshold, depthThreshold, out);
+					}
+					else
+					{
+						BilateralLine4(padded.data(), guideLine, lineLength, weights, radius, normalThreshold, depthThreshold, out);
+					}
+				}
+				else if (channels == 1)
+				{
+					ConvolveLine1(padded.data(), lineLength, weights, taps, out);
+				}
+				else
+				{
+					ConvolveLine4(padded.data(), lineLength, weights, taps, out);
+				}
+			}
+
+			// Pixel x of each line in the band lands next to each other in row x of dst.
+			for (UINT x = 0; x < lineLength; ++x)
+			{
+				for (UINT i = 0; i < count; ++i)
+				{
+					const float* pixel = filtered.data() + (static_cast<size_t>(i) * lineLength + x) * channels;
+					for (UINT c = 0; c < channels; ++c)
+					{
+						column[i * channels + c] = pixel[c];
+					}
+				}
+
+				uint8_t* row = dstBytes + static_cast<size_t>(x) * dstPitch + static_cast<size_t>(first) * channels * dstElementBytes;
+				StoreLine(format, bDstFormat, column.data(), count * channels, row);
+			}
+		}
+	});
+}
\ No newline at end of file
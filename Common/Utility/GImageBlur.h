@@ -0,0 +1,82 @@
+/*  ===============================================
+	Summary: CPU Separable Blur
+	===============================================  */
+
+#ifndef GIMAGEBLUR_H
+#define GIMAGEBLUR_H
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <vector>
+
+// The CPU counterpart of the blur shaders (HBlurCS/VBlurCS and the edge-aware BlurPS), for
+// offline tools, as a fallback and to validate the GPU passes.  Each pass filters the rows and
+// writes them out transposed, so the column pass is another row pass over contiguous memory.
+// Bands of rows are spread across the thread pool; edges are clamped like the shaders' samplers.
+class GImageBlur
+{
+public:
+	enum Format
+	{
+		FORMAT_R32_FLOAT,
+		FORMAT_R32G32B32A32_FLOAT,
+		FORMAT_R16G16B16A16_FLOAT,
+	};
+
+	static const UINT MaxRadius = 64;
+
+	// Fills weights with the 2 * radius + 1 taps of a normalized Gaussian.  A radius of 0 picks
+	// ceil(3 * sigma).  Returns the radius used.
+	static UINT ComputeGaussianWeights(float sigma, UINT radius, std::vector<float>& weights);
+
+	GImageBlur();
+	~GImageBlur();
+
+	void SetGaussian(float sigma, UINT radius = 0);
+
+	// Any symmetric table, e.g. the shaders' fixed 11 taps with a radius of 5.
+	void SetWeights(const float* weights, UINT radius);
+
+	inline UINT GetRadius() const { return mRadius; }
+
+	// Limits how many threads a blur runs on, for measuring scaling.  0 uses the whole pool.
+	inline void SetThreadCount(UINT count) { mThreadCount = count; }
+
+	// Blurs horizontally then vertically, numPasses times, in place.
+	void Blur(Format format, void* image, UINT width, UINT height, UINT rowPitch, UINT numPasses = 1);
+
+	// As BlurPS.hlsl: a neighbour only contributes if the dot product of its normal with the
+	// center's is at least normalThreshold and their depths differ by at most depthThreshold.
+	// normalDepth holds width * height texels of (view-space normal, view-space z).
+	void BilateralBlur(Format format, void* image, UINT width, UINT height, UINT rowPitch,
+		const DirectX::XMFLOAT4* normalDepth, float normalThreshold, float depthThreshold, UINT numPasses = 1);
+
+	// Milliseconds spent in the last blur.
+	inline float GetBlurTime() const { return mBlurTime; }
+
+private:
+	void Run(Format format, void* image, UINT width, UINT height, UINT rowPitch,
+		const DirectX::XMFLOAT4* normalDepth, float normalThreshold, float depthThreshold, UINT numPasses);
+
+	// Filters lines of src and writes each one as a column of dst.  Lines of float data are
+	// lineLength pixels long with lineCount of them; guide, if set, is laid out the same way.
+	void FilterLines(const void* src, bool bSrcFormat, void* dst, bool bDstFormat, Format format,
+		UINT srcPitch, UINT dstPitch, UINT lineLength, UINT lineCount,
+		const DirectX::XMFLOAT4* guide, float normalThreshold, float depthThreshold);
+
+	GImageBlur(const GImageBlur&);
+	GImageBlur& operator=(const GImageBlur&);
+
+private:
+	std::vector<float> mWeights;
+	UINT mRadius;
+	UINT mThreadCount;
+
+	// The image and the guide between the row and column halves of a pass.
+	std::vector<float> mTransposed;
+	std::vector<DirectX::XMFLOAT4> mTransposedGuide;
+
+	float mBlurTime;
+};
+
+#endif // GIMAGEBLUR_H
\ No newline at end of file
@@ -0,0 +1,208 @@
+/*  ===============================================
+	Summary: Read-Only Memory-Mapped File
+	===============================================  */
+
+#include "GMappedFile.h"
+
+#if !defined(_WIN32)
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+GMappedFile::GMappedFile() :
+#if defined(_WIN32)
+	mFile(INVALID_HANDLE_VALUE),
+	mMapping(nullptr),
+#else
+	mFile(-1),
+#endif
+	mData(nullptr),
+	mSize(0)
+{
+}
+
+GMappedFile::~GMappedFile()
+{
+	Close();
+}
+
+#if defined(_WIN32)
+
+bool GMappedFile::Open(const wchar_t* filename)
+{
+	Close();
+
+	mFile = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	// Views are limited to the address space; a 32-bit build cannot map anything past 4 GB.
+	if (static_cast<uint64_t>(size.QuadPart) > static_cast<uint64_t>(SIZE_MAX))
+	{
+		Close();
+		return false;
+	}
+
+	mMapping = CreateFileMappingW(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mMapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	mData = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (mData == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	mSize = static_cast<uint64_t>(size.QuadPart);
+	return true;
+}
+
+void GMappedFile::Close()
+{
+	if (mData)
+	{
+		UnmapViewOfFile(mData);
+		mData = nullptr;
+	}
+
+	if (mMapping)
+	{
+		CloseHandle(mMapping);
+		mMapping = nullptr;
+	}
+
+	if (mFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mFile);
+		mFile = INVALID_HANDLE_VALUE;
+	}
+
+	mSize = 0;
+}
+
+void GMappedFile::Prefetch(uint64_t offset, uint64_t size) const
+{
+	if (!mData || offset >= mSize)
+	{
+		return;
+	}
+
+	if (size > mSize - offset)
+	{
+		size = mSize - offset;
+	}
+
+	// PrefetchVirtualMemory only exists on Windows 8 and later, so look it up at run time.
+	// The range struct is declared here because the SDK hides it when targeting Windows 7.
+	struct MemoryRange
+	{
+		PVOID VirtualAddress;
+		SIZE_T NumberOfBytes;
+	};
+
+	typedef BOOL (WINAPI *PrefetchFunc)(HANDLE, ULONG_PTR, MemoryRange*, ULONG);
+	static PrefetchFunc prefetch = reinterpret_cast<PrefetchFunc>(GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "PrefetchVirtualMemory"));
+
+	if (prefetch)
+	{
+		MemoryRange range;
+		range.VirtualAddress = const_cast<uint8_t*>(mData + offset);
+		range.NumberOfBytes = static_cast<SIZE_T>(size);
+		prefetch(GetCurrentProcess(), 1, &range, 0);
+	}
+}
+
+#else
+
+bool GMappedFile::Open(const wchar_t* filename)
+{
+	Close();
+
+	size_t length = wcstombs(nullptr, filename, 0);
+	if (length == static_cast<size_t>(-1))
+	{
+		return false;
+	}
+
+	std::string path(length + 1, '\0');
+	wcstombs(&path[0], filename, path.size());
+
+	mFile = open(path.c_str(), O_RDONLY);
+	if (mFile < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(mFile, &info) != 0 || info.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, mFile, 0);
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	mData = static_cast<const uint8_t*>(data);
+	mSize = static_cast<uint64_t>(info.st_size);
+	return true;
+}
+
+void GMappedFile::Close()
+{
+	if (mData)
+	{
+		munmap(const_cast<uint8_t*>(mData), static_cast<size_t>(mSize));
+		mData = nullptr;
+	}
+
+	if (mFile >= 0)
+	{
+		close(mFile);
+		mFile = -1;
+	}
+
+	mSize = 0;
+}
+
+void GMappedFile::Prefetch(uint64_t offset, uint64_t size) const
+{
+	if (!mData || offset >= mSize)
+	{
+		return;
+	}
+
+	if (size > mSize - offset)
+	{
+		size = mSize - offset;
+	}
+
+	// madvise wants a page-aligned start.
+	uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+	uint64_t alignedOffset = offset & ~(pageSize - 1);
+
+	madvise(const_cast<uint8_t*>(mData + alignedOffset), static_cast<size_t>(size + offset - alignedOffset), MADV_WILLNEED);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,48 @@
+/*  ===============================================
+	Summary: Read-Only Memory-Mapped File
+	===============================================  */
+
+#ifndef GMAPPEDFILE_H
+#define GMAPPEDFILE_H
+
+#include <cstdint>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
+
+// Maps a whole file into the address space for reading.  Works on files larger than 4 GB
+// in 64-bit builds and falls back to mmap outside of Windows so loaders can run headless.
+class GMappedFile
+{
+public:
+	GMappedFile();
+	~GMappedFile();
+
+	bool Open(const wchar_t* filename);
+	void Close();
+
+	inline bool IsOpen() const { return mData != nullptr; }
+	inline const uint8_t* GetData() const { return mData; }
+	inline uint64_t GetSize() const { return mSize; }
+
+	// Hints that [offset, offset + size) will be read soon, so the OS can start paging it in.
+	void Prefetch(uint64_t offset, uint64_t size) const;
+
+private:
+	GMappedFile(const GMappedFile&);
+	GMappedFile& operator=(const GMappedFile&);
+
+private:
+#if defined(_WIN32)
+	HANDLE mFile;
+	HANDLE mMapping;
+#else
+	int mFile;
+#endif
+
+	const uint8_t* mData;
+	uint64_t mSize;
+};
+
+#endif // GMAPPEDFILE_H
\ No newline at end of file
@@ -0,0 +1,583 @@
+/*  ===============================================
+	Summary: Triangle Mesh Bounding Volume Hierarchy
+	===============================================  */
+
+#include "GMeshBVH.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <emmintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT NumBins = 16;
+	const UINT MaxStackDepth = 128;
+
+	inline float Component(const XMFLOAT3& v, UINT axis)
+	{
+		return (&v.x)[axis];
+	}
+
+	struct Bounds
+	{
+		XMFLOAT3 Min;
+		XMFLOAT3 Max;
+
+		void Reset()
+		{
+			Min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+			Max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		}
+
+		bool IsEmpty() const
+		{
+			return Min.x > Max.x;
+		}
+
+		void Grow(const XMFLOAT3& p)
+		{
+			Min = XMFLOAT3((std::min)(Min.x, p.x), (std::min)(Min.y, p.y), (std::min)(Min.z, p.z));
+			Max = XMFLOAT3((std::max)(Max.x, p.x), (std::max)(Max.y, p.y), (std::max)(Max.z, p.z));
+		}
+
+		void Grow(const Bounds& b)
+		{
+			if (!b.IsEmpty())
+			{
+				Grow(b.Min);
+				Grow(b.Max);
+			}
+		}
+
+		// Half the surface area, which is all the heuristic needs.
+		float HalfArea() const
+		{
+			if (IsEmpty())
+			{
+				return 0.0f;
+			}
+			float dx = Max.x - Min.x;
+			float dy = Max.y - Min.y;
+			float dz = Max.z - Min.z;
+			return dx * dy + dy * dz + dz * dx;
+		}
+	};
+
+	// The binary tree the SAH build produces, before it is collapsed.  Leaves hold Count triangles
+	// of the ordered list from First; inner nodes have Count 0 and children at First and First + 1.
+	struct BinaryNode
+	{
+		Bounds Box;
+		UINT First;
+		UINT Count;
+	};
+
+	struct BuildTask
+	{
+		UINT Node;
+		UINT First;
+		UINT Count;
+	};
+
+	struct CollapseTask
+	{
+		UINT BinaryNode;
+		UINT Node;
+	};
+
+	inline __m128 Dot(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+	}
+
+	inline UINT LowestBit(int mask)
+	{
+		UINT lane = 0;
+		while (!(mask & (1 << lane)))
+		{
+			++lane;
+		}
+		return lane;
+	}
+}
+
+const UINT GMeshBVH::MaxLeafTriangles;
+
+// The ray with each component splatted across the lanes.
+struct GMeshBVH::Ray
+{
+	__m128 Origin[3];
+	__m128 Direction[3];
+	__m128 InvDirection[3];
+
+	Ray(const XMFLOAT3& origin, const XMFLOAT3& direction)
+	{
+		for (UINT axis = 0; axis < 3; ++axis)
+		{
+			// A tiny component instead of zero keeps the slab test free of 0 * infinity.
+			float d = Component(direction, axis);
+			Origin[axis] = _mm_set1_ps(Component(origin, axis));
+			Direction[axis] = _mm_set1_ps(d);
+			InvDirection[axis] = _mm_set1_ps(1.0f / (fabsf(d) > 1e-20f ? d : 1e-20f));
+		}
+	}
+};
+
+GMeshBVH::GMeshBVH() :
+	mTriangleCount(0)
+{
+}
+
+GMeshBVH::~GMeshBVH()
+{
+}
+
+void GMeshBVH::Build(const XMFLOAT3* positions, const UINT* indices, UINT indexCount)
+{
+	const UINT numTriangles = indexCount / 3;
+
+	mNodes.clear();
+	mPackets.clear();
+	mTriangleIds.clear();
+	mTriangleCount = numTriangles;
+
+	if (numTriangles == 0)
+	{
+		return;
+	}
+
+	std::vector<Bounds> triBounds(numTriangles);
+	std::vector<XMFLOAT3> centroids(numTriangles);
+	std::vector<UINT> order(numTriangles);
+
+	for (UINT i = 0; i < numTriangles; ++i)
+	{
+		const XMFLOAT3& a = positions[indices[i * 3 + 0]];
+		const XMFLOAT3& b = positions[indices[i * 3 + 1]];
+		const XMFLOAT3& c = positions[indices[i * 3 + 2]];
+
+		triBounds[i].Reset();
+		triBounds[i].Grow(a);
+		triBounds[i].Grow(b);
+		triBounds[i].Grow(c);
+
+		centroids[i] = XMFLOAT3((a.x + b.x + c.x) / 3.0f, (a.y + b.y + c.y) / 3.0f, (a.z + b.z + c.z) / 3.0f);
+		order[i] = i;
+	}
+
+	// Top-down binned SAH build of the binary tree.
+	std::vector<BinaryNode> binary;
+	binary.reserve(2 * numTriangles);
+	binary.push_back(BinaryNode());
+
+	std::vector<BuildTask> tasks;
+	BuildTask root = { 0, 0, numTriangles };
+	tasks.push_back(root);
+
+	while (!tasks.empty())
+	{
+		BuildTask task = tasks.back();
+		tasks.pop_back();
+
+		Bounds bounds;
+		Bounds centroidBounds;
+		bounds.Reset();
+		centroidBounds.Reset();
+		for (UINT i = task.First; i < task.First + task.Count; ++i)
+		{
+			bounds.Grow(triBounds[order[i]]);
+			centroidBounds.Grow(centroids[order[i]]);
+		}
+
+		binary[task.Node].Box = bounds;
+		binary[task.Node].First = task.First;
+		binary[task.Node].Count = task.Count;
+
+		if (task.Count <= MaxLeafTriangles)
+		{
+			continue;
+		}
+
+		// Bin the centroids along each axis and sweep for the cheapest split.
+		float bestCost = FLT_MAX;
+		UINT bestAxis = 0;
+		UINT bestSplit = 0;
+
+		for (UINT axis = 0; axis < 3; ++axis)
+		{
+			float minC = Component(centroidBounds.Min, axis);
+			float extent = Component(centroidBounds.Max, axis) - minC;
+			if (extent <= 0.0f)
+			{
+				continue;
+			}
+
+			Bounds binBounds[NumBins];
+			UINT binCounts[NumBins] = {};
+			for (UINT b = 0; b < NumBins; ++b)
+			{
+				binBounds[b].Reset();
+			}
+
+			float scale = NumBins / extent;
+			for (UINT i = task.First; i < task.First + task.Count; ++i)
+			{
+				UINT id = order[i];
+				UINT b = (std::min)(static_cast<UINT>((Component(centroids[id], axis) - minC) * scale), NumBins - 1);
+				binBounds[b].Grow(triBounds[id]);
+				++binCounts[b];
+			}
+
+			float rightArea[NumBins];
+			UINT rightCount[NumBins];
+			Bounds sweep;
+			sweep.Reset();
+			UINT count = 0;
+			for (UINT b = NumBins - 1; b > 0; --b)
+			{
+				sweep.Grow(binBounds[b]);
+				count += binCounts[b];
+				rightArea[b] = sweep.HalfArea();
+				rightCount[b] = count;
+			}
+
+			sweep.Reset();
+			count = 0;
+			for (UINT split = 1; split < NumBins; ++split)
+			{
+				sweep.Grow(binBounds[split - 1]);
+				count += binCounts[split - 1];
+
+				if (count == 0 || rightCount[split] == 0)
+				{
+					continue;
+				}
+
+				float cost = count * sweep.HalfArea() + rightCount[split] * rightArea[split];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = split;
+				}
+			}
+		}
+
+		// Identical centroids cannot be split; neither is a split that costs more than a leaf.
+		if (bestSplit == 0 || bestCost >= task.Count * bounds.HalfArea())
+		{
+			continue;
+		}
+
+		float minC = Component(centroidBounds.Min, bestAxis);
+		float scale = NumBins / (Component(centroidBounds.Max, bestAxis) - minC);
+		UINT* begin = order.data() + task.First;
+		UINT* middle = std::partition(begin, begin + task.Count, [&](UINT id)
+		{
+			UINT b = (std::min)(static_cast<UINT>((Component(centroids[id], bestAxis) - minC) * scale), NumBins - 1);
+			return b < bestSplit;
+		});
+
+		UINT leftCount = static_cast<UINT>(middle - begin);
+		UINT left = static_cast<UINT>(binary.size());
+
+		binary[task.Node].First = left;
+		binary[task.Node].Count = 0;
+		binary.push_back(BinaryNode());
+		binary.push_back(BinaryNode());
+
+		BuildTask leftTask = { left, task.First, leftCount };
+		BuildTask rightTask = { left + 1, task.First + leftCount, task.Count - leftCount };
+		tasks.push_back(leftTask);
+		tasks.push_back(rightTask);
+	}
+
+	// Collapse into four-wide nodes by repeatedly opening the largest inner child, then pack each
+	// leaf's triangles into whole packets.
+	mNodes.reserve(binary.size() / 2 + 1);
+	mNodes.push_back(Node());
+
+	std::vector<CollapseTask> collapse;
+	CollapseTask rootTask = { 0, 0 };
+	collapse.push_back(rootTask);
+
+	while (!collapse.empty())
+	{
+		CollapseTask task = collapse.back();
+		collapse.pop_back();
+
+		UINT children[4] = { task.BinaryNode };
+		UINT numChildren = 1;
+
+		while (numChildren < 4)
+		{
+			UINT largest = numChildren;
+			float largestArea = -1.0f;
+			for (UINT i = 0; i < numChildren; ++i)
+			{
+				const BinaryNode& child = binary[children[i]];
+				if (child.Count == 0 && child.Box.HalfArea() > largestArea)
+				{
+					largest = i;
+					largestArea = child.Box.HalfArea();
+				}
+			}
+
+			if (largest == numChildren)
+			{
+				break;
+			}
+
+			UINT opened = children[largest];
+			children[largest] = binary[opened].First;
+			children[numChildren++] = binary[opened].First + 1;
+		}
+
+		Node node;
+		for (UINT i = 0; i < 4; ++i)
+		{
+			node.MinX[i] = node.MinY[i] = node.MinZ[i] = FLT_MAX;
+			node.MaxX[i] = node.MaxY[i] = node.MaxZ[i] = -FLT_MAX;
+			node.Child[i] = 0;
+			node.Count[i] = 0;
+		}
+
+		for (UINT i = 0; i < numChildren; ++i)
+		{
+			const BinaryNode& child = binary[children[i]];
+			node.MinX[i] = child.Box.Min.x;
+			node.MinY[i] = child.Box.Min.y;
+			node.MinZ[i] = child.Box.Min.z;
+			node.MaxX[i] = child.Box.Max.x;
+			node.MaxY[i] = child.Box.Max.y;
+			node.MaxZ[i] = child.Box.Max.z;
+
+			if (child.Count == 0)
+			{
+				node.Child[i] = static_cast<UINT>(mNodes.size());
+				mNodes.push_back(Node());
+
+				CollapseTask childTask = { children[i], node.Child[i] };
+				collapse.push_back(childTask);
+				continue;
+			}
+
+			node.Child[i] = static_cast<UINT>(mPackets.size());
+			node.Count[i] = child.Count;
+
+			for (UINT first = 0; first < child.Count; first += 4)
+			{
+				TrianglePacket packet;
+				for (UINT lane = 0; lane < 4; ++lane)
+				{
+					UINT id = first + lane < child.Count ? order[child.First + first + lane] : ~0u;
+					XMFLOAT3 a(0.0f, 0.0f, 0.0f);
+					XMFLOAT3 b = a;
+					XMFLOAT3 c = a;
+
+					if (id != ~0u)
+					{
+						a = positions[indices[id * 3 + 0]];
+						b = positions[indices[id * 3 + 1]];
+						c = positions[indices[id * 3 + 2]];
+					}
+
+					for (UINT axis = 0; axis < 3; ++axis)
+					{
+						packet.V0[axis][lane] = Component(a, axis);
+						packet.Edge1[axis][lane] = Component(b, axis) - Component(a, axis);
+						packet.Edge2[axis][lane] = Component(c, axis) - Component(a, axis);
+					}
+
+					mTriangleIds.push_back(id);
+				}
+				mPackets.push_back(packet);
+			}
+		}
+
+		mNodes[task.Node] = node;
+	}
+}
+
+bool GMeshBVH::Occluded(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance) const
+{
+	float distance = maxDistance;
+	UINT triangle = 0;
+	return Trace<true>(Ray(origin, direction), distance, triangle);
+}
+
+bool GMeshBVH::Intersect(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance,
+	float& distance, UINT& triangle) const
+{
+	distance = maxDistance;
+	if (!Trace<false>(Ray(origin, direction), distance, triangle))
+	{
+		return false;
+	}
+
+	triangle = mTriangleIds[triangle];
+	return true;
+}
+
+template <bool bAnyHit>
+bool GMeshBVH::Trace(const Ray& ray, float& distance, UINT& triangle) const
+{
+	if (mNodes.empty())
+	{
+		return false;
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 epsilon = _mm_set1_ps(1e-12f);
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+	// Inner nodes still to visit, with the distance at which the ray enters them.
+	UINT stack[MaxStackDepth];
+	float stackNear[MaxStackDepth];
+	UINT stackSize = 1;
+	stack[0] = 0;
+	stackNear[0] = 0.0f;
+
+	bool bHit = false;
+
+	while (stackSize > 0)
+	{
+		--stackSize;
+		if (stackNear[stackSize] >= distance)
+		{
+			continue;
+		}
+
+		const Node& node = mNodes[stack[stackSize]];
+		__m128 tMax = _mm_set1_ps(distance);
+
+		// Slab test of the four children at once.
+		__m128 t0x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MinX), ray.Origin[0]), ray.InvDirection[0]);
+		__m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MaxX), ray.Origin[0]), ray.InvDirection[0]);
+		__m128 t0y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MinY), ray.Origin[1]), ray.InvDirection[1]);
+		__m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MaxY), ray.Origin[1]), ray.InvDirection[1]);
+		__m128 t0z = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MinZ), ray.Origin[2]), ray.InvDirection[2]);
+		__m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.MaxZ), ray.Origin[2]), ray.InvDirection[2]);
+
+		__m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)), _mm_max_ps(_mm_min_ps(t0z, t1z), zero));
+		__m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)), _mm_min_ps(_mm_max_ps(t0z, t1z), tMax));
+
+		int mask = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		float nearest[4];
+		_mm_storeu_ps(nearest, tNear);
+
+		UINT firstPushed = stackSize;
+
+		for (UINT i = 0; i < 4; ++i)
+		{
+			if (!(mask & (1 << i)))
+			{
+				continue;
+			}
+
+			if (node.Count[i] == 0)
+			{
+				// Empty slots have inverted boxes, which the slab test does not reject.
+				if (node.Child[i] != 0 && stackSize < MaxStackDepth)
+				{
+					stack[stackSize] = node.Child[i];
+					stackNear[stackSize] = nearest[i];
+					++stackSize;
+				}
+				continue;
+			}
+
+			// Moller-Trumbore on four triangles at once, accepting both windings.
+			UINT lastPacket = node.Child[i] + (node.Count[i] + 3) / 4;
+			for (UINT p = node.Child[i]; p < lastPacket; ++p)
+			{
+				const TrianglePacket& packet = mPackets[p];
+				__m128 e1x = _mm_loadu_ps(packet.Edge1[0]);
+				__m128 e1y = _mm_loadu_ps(packet.Edge1[1]);
+				__m128 e1z = _mm_loadu_ps(packet.Edge1[2]);
+				__m128 e2x = _mm_loadu_ps(packet.Edge2[0]);
+				__m128 e2y = _mm_loadu_ps(packet.Edge2[1]);
+				__m128 e2z = _mm_loadu_ps(packet.Edge2[2]);
+
+				__m128 px = _mm_sub_ps(_mm_mul_ps(ray.Direction[1], e2z), _mm_mul_ps(ray.Direction[2], e2y));
+				__m128 py = _mm_sub_ps(_mm_mul_ps(ray.Direction[2], e2x), _mm_mul_ps(ray.Direction[0], e2z));
+				__m128 pz = _mm_sub_ps(_mm_mul_ps(ray.Direction[0], e2y), _mm_mul_ps(ray.Direction[1], e2x));
+
+				__m128 det = Dot(e1x, e1y, e1z, px, py, pz);
+				__m128 invDet = _mm_div_ps(one, det);
+
+				__m128 sx = _mm_sub_ps(ray.Origin[0], _mm_loadu_ps(packet.V0[0]));
+				__m128 sy = _mm_sub_ps(ray.Origin[1], _mm_loadu_ps(packet.V0[1]));
+				__m128 sz = _mm_sub_ps(ray.Origin[2], _mm_loadu_ps(packet.V0[2]));
+
+				__m128 u = _mm_mul_ps(Dot(sx, sy, sz, px, py, pz), invDet);
+
+				__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+				__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+				__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+
+				__m128 v = _mm_mul_ps(Dot(ray.Direction[0], ray.Direction[1], ray.Direction[2], qx, qy, qz), invDet);
+				__m128 t = _mm_mul_ps(Dot(e2x, e2y, e2z, qx, qy, qz), invDet);
+
+				// Padding lanes are degenerate and fail the determinant test.
+				__m128 hit = _mm_cmpgt_ps(_mm_and_ps(det, absMask), epsilon);
+				hit = _mm_and_ps(hit, _mm_cmpge_ps(u, zero));
+				hit = _mm_and_ps(hit, _mm_cmpge_ps(v, zero));
+				hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), one));
+				hit = _mm_and_ps(hit, _mm_cmpgt_ps(t, zero));
+				hit = _mm_and_ps(hit, _mm_cmplt_ps(t, tMax));
+
+				int hitMask = _mm_movemask_ps(hit);
+				if (hitMask == 0)
+				{
+					continue;
+				}
+
+				if (bAnyHit)
+				{
+					triangle = p * 4 + LowestBit(hitMask);
+					return true;
+				}
+
+				// Keep the nearest of the lanes that hit.
+				float hits[4];
+				_mm_storeu_ps(hits, t);
+				for (UINT lane = 0; lane < 4; ++lane)
+				{
+					if ((hitMask & (1 << lane)) && hits[lane] < distance)
+					{
+						distance = hits[lane];
+						triangle = p * 4 + lane;
+					}
+				}
+
+				tMax = _mm_set1_ps(distance);
+				bHit = true;
+			}
+		}
+
+		// Order the children just pushed so the nearest is popped first.
+		if (!bAnyHit)
+		{
+			for (UINT i = firstPushed + 1; i < stackSize; ++i)
+			{
+				for (UINT j = i; j > firstPushed && stackNear[j - 1] < stackNear[j]; --j)
+				{
+					std::swap(stack[j - 1], stack[j]);
+					std::swap(stackNear[j - 1], stackNear[j]);
+				}
+			}
+		}
+	}
+
+	return bHit;
+}
\ No newline at end of file
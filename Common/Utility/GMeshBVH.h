@@ -0,0 +1,81 @@
+/*  ===============================================
+	Summary: Triangle Mesh Bounding Volume Hierarchy
+	===============================================  */
+
+#ifndef GMESHBVH_H
+#define GMESHBVH_H
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <vector>
+
+// Bounding volume hierarchy over an indexed triangle list for ray queries, built top-down with
+// the binned surface area heuristic and then collapsed to four children per node, so a ray tests
+// four boxes, and a leaf four triangles, in one SSE pass.  Several meshes can go in one tree by
+// concatenating their vertices and offsetting their indices, so a scene can be queried as a whole.
+class GMeshBVH
+{
+public:
+	static const UINT MaxLeafTriangles = 4;
+
+	GMeshBVH();
+	~GMeshBVH();
+
+	// Three indices per triangle.  The positions are copied, so the arrays may be freed afterwards.
+	void Build(const DirectX::XMFLOAT3* positions, const UINT* indices, UINT indexCount);
+
+	// Whether any triangle, facing either way, crosses the ray within (0, maxDistance).
+	// Returns at the first hit found, which is all visibility queries need.
+	bool Occluded(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float maxDistance) const;
+
+	// Nearest hit within (0, maxDistance): its distance and the index of the triangle in the
+	// index list given to Build.
+	bool Intersect(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float maxDistance,
+		float& distance, UINT& triangle) const;
+
+	inline UINT GetNodeCount() const { return static_cast<UINT>(mNodes.size()); }
+	inline UINT GetTriangleCount() const { return mTriangleCount; }
+
+private:
+	// Boxes of up to four children, one per lane.  A child with Count > 0 is a leaf of Count
+	// triangles starting at packet Child; otherwise Child is an inner node, or 0 for an empty slot
+	// (the root is never a child).
+	struct Node
+	{
+		float MinX[4];
+		float MinY[4];
+		float MinZ[4];
+		float MaxX[4];
+		float MaxY[4];
+		float MaxZ[4];
+		UINT Child[4];
+		UINT Count[4];
+	};
+
+	// Four triangles of a leaf, one per lane, ready for the ray test.  Leaves are padded to whole
+	// packets with degenerate triangles that nothing hits.
+	struct TrianglePacket
+	{
+		float V0[3][4];
+		float Edge1[3][4];
+		float Edge2[3][4];
+	};
+
+	struct Ray;
+
+	template <bool bAnyHit>
+	bool Trace(const Ray& ray, float& distance, UINT& triangle) const;
+
+	GMeshBVH(const GMeshBVH&);
+	GMeshBVH& operator=(const GMeshBVH&);
+
+private:
+	std::vector<Node> mNodes;
+	std::vector<TrianglePacket> mPackets;
+	UINT mTriangleCount;
+
+	// Index in the original list of the triangle in each packet lane.
+	std::vector<UINT> mTriangleIds;
+};
+
+#endif // GMESHBVH_H
\ No newline at end of file
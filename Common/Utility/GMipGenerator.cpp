@@ -0,0 +1,578 @@
+/*  ===============================================
+	Summary: CPU Mip-Chain Generation
+	===============================================  */
+
+#include "GMipGenerator.h"
+#include "GThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace
+{
+	const UINT RowsPerRange = 16;
+
+	// Kaiser-windowed sinc reaching three destination texels either side of the centre.
+	const float KaiserWidth = 3.0f;
+	const float KaiserAlpha = 4.0f;
+
+	const float Pi = 3.14159265f;
+
+	// Entries in the linear-to-sRGB table; fine enough that every 8-bit code survives a round trip.
+	const UINT LinearToSRGBSize = 4096;
+
+	struct SRGBTables
+	{
+		float ToLinear[256];
+		uint8_t FromLinear[LinearToSRGBSize];
+
+		SRGBTables()
+		{
+			for (UINT i = 0; i < 256; ++i)
+			{
+				float s = i / 255.0f;
+				ToLinear[i] = s <= 0.04045f ? s / 12.92f : powf((s + 0.055f) / 1.055f, 2.4f);
+			}
+
+			for (UINT i = 0; i < LinearToSRGBSize; ++i)
+			{
+				float l = i / static_cast<float>(LinearToSRGBSize - 1);
+				float s = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+				FromLinear[i] = static_cast<uint8_t>(s * 255.0f + 0.5f);
+			}
+		}
+	};
+
+	const SRGBTables& GetSRGBTables()
+	{
+		static const SRGBTables tables;
+		return tables;
+	}
+
+	inline __m128 DecodeSRGB(const uint8_t* texel, const SRGBTables& tables)
+	{
+		return _mm_setr_ps(tables.ToLinear[texel[0]], tables.ToLinear[texel[1]], tables.ToLinear[texel[2]], texel[3] * (1.0f / 255.0f));
+	}
+
+	inline void EncodeSRGB(__m128 value, const SRGBTables& tables, uint8_t* texel)
+	{
+		value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+
+		alignas(16) float v[4];
+		_mm_store_ps(v, value);
+
+		const float scale = static_cast<float>(LinearToSRGBSize - 1);
+		texel[0] = tables.FromLinear[static_cast<UINT>(v[0] * scale + 0.5f)];
+		texel[1] = tables.FromLinear[static_cast<UINT>(v[1] * scale + 0.5f)];
+		texel[2] = tables.FromLinear[static_cast<UINT>(v[2] * scale + 0.5f)];
+		texel[3] = static_cast<uint8_t>(v[3] * 255.0f + 0.5f);
+	}
+
+	inline __m128 Combine(GMipGenerator::Filter filter, __m128 a, __m128 b)
+	{
+		switch (filter)
+		{
+		case GMipGenerator::FILTER_MIN: return _mm_min_ps(a, b);
+		case GMipGenerator::FILTER_MAX: return _mm_max_ps(a, b);
+		default: return _mm_add_ps(a, b);
+		}
+	}
+
+	inline float Combine(GMipGenerator::Filter filter, float a, float b)
+	{
+		switch (filter)
+		{
+		case GMipGenerator::FILTER_MIN: return (std::min)(a, b);
+		case GMipGenerator::FILTER_MAX: return (std::max)(a, b);
+		default: return a + b;
+		}
+	}
+
+	//
+	// 2:1 reductions, used whenever both dimensions halve exactly.
+	//
+
+	void ReduceRowRGBA8(GMipGenerator::Filter filter, const uint8_t* row0, const uint8_t* row1, uint8_t* dst, UINT dstWidth)
+	{
+		UINT x = 0;
+
+		if (filter == GMipGenerator::FILTER_BOX)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i round = _mm_set1_epi16(2);
+
+			for (; x + 2 <= dstWidth; x += 2)
+			{
+				__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x));
+				__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x));
+
+				// Column sums of source texels 0 and 1 in lo, 2 and 3 in hi; then add neighbours.
+				__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+				__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+				__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+
+				sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 4 * x), _mm_packus_epi16(sum, sum));
+			}
+
+			for (; x < dstWidth; ++x)
+			{
+				const uint8_t* a = row0 + 8 * x;
+				const uint8_t* b = row1 + 8 * x;
+				for (UINT c = 0; c < 4; ++c)
+				{
+					dst[4 * x + c] = static_cast<uint8_t>((a[c] + a[c + 4] + b[c] + b[c + 4] + 2) >> 2);
+				}
+			}
+		}
+		else
+		{
+			bool bMin = filter == GMipGenerator::FILTER_MIN;
+
+			for (; x + 2 <= dstWidth; x += 2)
+			{
+				__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x));
+				__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x));
+
+				__m128i v = bMin ? _mm_min_epu8(a, b) : _mm_max_epu8(a, b);
+				__m128i neighbours = _mm_srli_epi64(v, 32);
+				v = bMin ? _mm_min_epu8(v, neighbours) : _mm_max_epu8(v, neighbours);
+
+				// Results sit in texels 0 and 2.
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 4 * x), _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 2, 0)));
+			}
+
+			for (; x < dstWidth; ++x)
+			{
+				const uint8_t* a = row0 + 8 * x;
+				const uint8_t* b = row1 + 8 * x;
+				for (UINT c = 0; c < 4; ++c)
+				{
+					dst[4 * x + c] = bMin ?
+						(std::min)((std::min)(a[c], a[c + 4]), (std::min)(b[c], b[c + 4])) :
+						(std::max)((std::max)(a[c], a[c + 4]), (std::max)(b[c], b[c + 4]));
+				}
+			}
+		}
+	}
+
+	void ReduceRowSRGB(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, UINT dstWidth)
+	{
+		const SRGBTables& tables = GetSRGBTables();
+		const __m128 quarter = _mm_set1_ps(0.25f);
+
+		for (UINT x = 0; x < dstWidth; ++x)
+		{
+			const uint8_t* a = row0 + 8 * x;
+			const uint8_t* b = row1 + 8 * x;
+
+			__m128 sum = _mm_add_ps(
+				_mm_add_ps(DecodeSRGB(a, tables), DecodeSRGB(a + 4, tables)),
+				_mm_add_ps(DecodeSRGB(b, tables), DecodeSRGB(b + 4, tables)));
+
+			EncodeSRGB(_mm_mul_ps(sum, quarter), tables, dst + 4 * x);
+		}
+	}
+
+	void ReduceRowFloat(GMipGenerator::Filter filter, const float* row0, const float* row1, float* dst, UINT dstWidth)
+	{
+		const float scale = filter == GMipGenerator::FILTER_BOX ? 0.25f : 1.0f;
+		const __m128 scale4 = _mm_set1_ps(scale);
+
+		UINT x = 0;
+		for (; x + 4 <= dstWidth; x += 4)
+		{
+			__m128 lo = Combine(filter, _mm_loadu_ps(row0 + 2 * x), _mm_loadu_ps(row1 + 2 * x));
+			__m128 hi = Combine(filter, _mm_loadu_ps(row0 + 2 * x + 4), _mm_loadu_ps(row1 + 2 * x + 4));
+
+			__m128 even = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+			__m128 odd = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+
+			_mm_storeu_ps(dst + x, _mm_mul_ps(Combine(filter, even, odd), scale4));
+		}
+
+		for (; x < dstWidth; ++x)
+		{
+			float a = Combine(filter, row0[2 * x], row0[2 * x + 1]);
+			float b = Combine(filter, row1[2 * x], row1[2 * x + 1]);
+			dst[x] = Combine(filter, a, b) * scale;
+		}
+	}
+
+	//
+	// General separable path for the Kaiser filter, odd sizes and arbitrary resizes, where a
+	// destination texel covers a fractional number of source texels.
+	//
+
+	struct FilterTable
+	{
+		// Taps per destination texel, with source indices clamped to the edge.
+		UINT Taps;
+		std::vector<UINT> Indices;
+		std::vector<float> Weights;
+	};
+
+	float BesselI0(float x)
+	{
+		float sum = 1.0f;
+		float term = 1.0f;
+		float halfXSq = 0.25f * x * x;
+
+		for (int k = 1; k < 32 && term > 1.0e-8f * sum; ++k)
+		{
+			term *= halfXSq / static_cast<float>(k * k);
+			sum += term;
+		}
+
+		return sum;
+	}
+
+	// x is measured in destination texels.
+	float Kaiser(float x)
+	{
+		if (fabsf(x) >= KaiserWidth)
+		{
+			return 0.0f;
+		}
+
+		float sinc = x == 0.0f ? 1.0f : sinf(Pi * x) / (Pi * x);
+		float t = x / KaiserWidth;
+
+		return sinc * BesselI0(KaiserAlpha * sqrtf(1.0f - t * t)) / BesselI0(KaiserAlpha);
+	}
+
+	void BuildFilterTable(GMipGenerator::Filter filter, UINT srcSize, UINT dstSize, FilterTable& table)
+	{
+		float scale = static_cast<float>(srcSize) / dstSize;
+
+		// When enlarging, the Kaiser filter keeps its width in source texels instead of shrinking
+		// with the destination; box, min and max cover the destination texel's footprint.
+		float support = (std::max)(scale, 1.0f);
+		float radius = filter == GMipGenerator::FILTER_KAISER ? KaiserWidth * support : 0.5f * scale;
+
+		table.Taps = static_cast<UINT>(ceilf(2.0f * radius)) + 1;
+		table.Indices.resize(dstSize * table.Taps);
+		table.Weights.resize(dstSize * table.Taps);
+
+		for (UINT i = 0; i < dstSize; ++i)
+		{
+			float center = (i + 0.5f) * scale;
+			int first = static_cast<int>(floorf(center - radius));
+
+			UINT* indices = &table.Indices[i * table.Taps];
+			float* weights = &table.Weights[i * table.Taps];
+			float total = 0.0f;
+
+			for (UINT t = 0; t < table.Taps; ++t)
+			{
+				int j = first + static_cast<int>(t);
+
+				float w;
+				if (filter == GMipGenerator::FILTER_KAISER)
+				{
+					w = Kaiser((j + 0.5f - center) / support);
+				}
+				else
+				{
+					// Share of the source texel inside the destination texel's footprint.
+					float lo = (std::max)(static_cast<float>(j), center - radius);
+					float hi = (std::min)(j + 1.0f, center + radius);
+					w = (std::max)(0.0f, hi - lo);
+				}
+
+				indices[t] = static_cast<UINT>((std::min)((std::max)(j, 0), static_cast<int>(srcSize) - 1));
+				weights[t] = w;
+				total += w;
+			}
+
+			for (UINT t = 0; t < table.Taps; ++t)
+			{
+				weights[t] /= total;
+			}
+		}
+	}
+
+	// Returns the row as floats, converting into scratch when it is not already float.
+	const float* DecodeRow(GMipGenerator::Format format, const uint8_t* src, UINT width, float* scratch)
+	{
+		if (format == GMipGenerator::FORMAT_R32_FLOAT)
+		{
+			return reinterpret_cast<const float*>(src);
+		}
+
+		if (format == GMipGenerator::FORMAT_R8G8B8A8_SRGB)
+		{
+			const SRGBTables& tables = GetSRGBTables();
+			for (UINT x = 0; x < width; ++x)
+			{
+				_mm_storeu_ps(scratch + 4 * x, DecodeSRGB(src + 4 * x, tables));
+			}
+			return scratch;
+		}
+
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+
+		for (UINT x = 0; x < width; ++x)
+		{
+			int32_t packed;
+			memcpy(&packed, src + 4 * x, sizeof(packed));
+
+			__m128i texel = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+			_mm_storeu_ps(scratch + 4 * x, _mm_mul_ps(_mm_cvtepi32_ps(texel), scale));
+		}
+
+		return scratch;
+	}
+
+	void EncodeRow(GMipGenerator::Format format, const float* src, UINT width, uint8_t* dst)
+	{
+		if (format == GMipGenerator::FORMAT_R32_FLOAT)
+		{
+			memcpy(dst, src, width * sizeof(float));
+			return;
+		}
+
+		if (format == GMipGenerator::FORMAT_R8G8B8A8_SRGB)
+		{
+			const SRGBTables& tables = GetSRGBTables();
+			for (UINT x = 0; x < width; ++x)
+			{
+				EncodeSRGB(_mm_loadu_ps(src + 4 * x), tables, dst + 4 * x);
+			}
+			return;
+		}
+
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps(255.0f);
+
+		for (UINT x = 0; x < width; ++x)
+		{
+			__m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + 4 * x), _mm_setzero_ps()), one);
+			__m128i texel = _mm_cvtps_epi32(_mm_mul_ps(v, scale));
+			texel = _mm_packs_epi32(texel, texel);
+			texel = _mm_packus_epi16(texel, texel);
+
+			int32_t packed = _mm_cvtsi128_si32(texel);
+			memcpy(dst + 4 * x, &packed, sizeof(packed));
+		}
+	}
+
+	void FilterRow(GMipGenerator::Filter filter, UINT channels, const float* texels, const FilterTable& table, UINT dstWidth, float* out)
+	{
+		const float identity = filter == GMipGenerator::FILTER_MIN ? FLT_MAX : filter == GMipGenerator::FILTER_MAX ? -FLT_MAX : 0.0f;
+		const bool bWeighted = filter == GMipGenerator::FILTER_BOX || filter == GMipGenerator::FILTER_KAISER;
+
+		for (UINT x = 0; x < dstWidth; ++x)
+		{
+			const UINT* indices = &table.Indices[x * table.Taps];
+			const float* weights = &table.Weights[x * table.Taps];
+
+			if (channels == 4)
+			{
+				__m128 acc = _mm_set1_ps(identity);
+				for (UINT t = 0; t < table.Taps; ++t)
+				{
+					if (weights[t] == 0.0f)
+					{
+						continue;
+					}
+
+					__m128 v = _mm_loadu_ps(texels + 4 * indices[t]);
+					acc = Combine(filter, acc, bWeighted ? _mm_mul_ps(v, _mm_set1_ps(weights[t])) : v);
+				}
+				_mm_storeu_ps(out + 4 * x, acc);
+			}
+			else
+			{
+				float acc = identity;
+				for (UINT t = 0; t < table.Taps; ++t)
+				{
+					if (weights[t] == 0.0f)
+					{
+						continue;
+					}
+
+					float v = texels[indices[t]];
+					acc = Combine(filter, acc, bWeighted ? v * weights[t] : v);
+				}
+				out[x] = acc;
+			}
+		}
+	}
+
+	// Filters rows [begin, end) of the destination: the source rows they read are filtered
+	// horizontally into a band-local buffer, then combined down each column.
+	void FilterBand(GMipGenerator::Format format, GMipGenerator::Filter filter,
+		const uint8_t* src, UINT srcWidth, UINT srcRowPitch, const FilterTable& horizontal, const FilterTable& vertical,
+		uint8_t* dst, UINT dstWidth, UINT dstRowPitch, UINT begin, UINT end)
+	{
+		const UINT channels = format == GMipGenerator::FORMAT_R32_FLOAT ? 1 : 4;
+		const UINT rowFloats = dstWidth * channels;
+
+		const float identity = filter == GMipGenerator::FILTER_MIN ? FLT_MAX : filter == GMipGenerator::FILTER_MAX ? -FLT_MAX : 0.0f;
+		const bool bWeighted = filter == GMipGenerator::FILTER_BOX || filter == GMipGenerator::FILTER_KAISER;
+
+		UINT firstRow = UINT_MAX;
+		UINT lastRow = 0;
+		for (UINT i = begin * vertical.Taps; i < end * vertical.Taps; ++i)
+		{
+			firstRow = (std::min)(firstRow, vertical.Indices[i]);
+			lastRow = (std::max)(lastRow, vertical.Indices[i]);
+		}
+
+		std::vector<float> scratch(srcWidth * channels);
+		std::vector<float> rows((lastRow - firstRow + 1) * rowFloats);
+		std::vector<float> out(rowFloats);
+
+		for (UINT r = firstRow; r <= lastRow; ++r)
+		{
+			const float* texels = DecodeRow(format, src + static_cast<size_t>(r) * srcRowPitch, srcWidth, scratch.data());
+			FilterRow(filter, channels, texels, horizontal, dstWidth, &rows[(r - firstRow) * rowFloats]);
+		}
+
+		for (UINT y = begin; y < end; ++y)
+		{
+			const UINT* indices = &vertical.Indices[y * vertical.Taps];
+			const float* weights = &vertical.Weights[y * vertical.Taps];
+
+			std::fill(out.begin(), out.end(), identity);
+
+			for (UINT t = 0; t < vertical.Taps; ++t)
+			{
+				if (weights[t] == 0.0f)
+				{
+					continue;
+				}
+
+				const float* row = &rows[(indices[t] - firstRow) * rowFloats];
+				const float w = bWeighted ? weights[t] : 1.0f;
+				const __m128 w4 = _mm_set1_ps(w);
+
+				UINT i = 0;
+				for (; i + 4 <= rowFloats; i += 4)
+				{
+					__m128 v = _mm_loadu_ps(row + i);
+					_mm_storeu_ps(&out[i], Combine(filter, _mm_loadu_ps(&out[i]), bWeighted ? _mm_mul_ps(v, w4) : v));
+				}
+				for (; i < rowFloats; ++i)
+				{
+					out[i] = Combine(filter, out[i], bWeighted ? row[i] * w : row[i]);
+				}
+			}
+
+			EncodeRow(format, out.data(), dstWidth, dst + static_cast<size_t>(y) * dstRowPitch);
+		}
+	}
+}
+
+UINT GMipGenerator::GetMipCount(UINT width, UINT height)
+{
+	UINT count = 1;
+	while (width > 1 || height > 1)
+	{
+		width = (std::max)(1u, width / 2);
+		height = (std::max)(1u, height / 2);
+		++count;
+	}
+
+	return count;
+}
+
+UINT GMipGenerator::GetPixelBytes(Format format)
+{
+	// Every supported format is 32 bits per texel.
+	return 4;
+}
+
+void GMipGenerator::GenerateChain(Format format, Filter filter, const void* src, UINT width, UINT height, UINT rowPitch,
+	std::vector<Level>& levels, UINT mipLevels)
+{
+	UINT fullCount = GetMipCount(width, height);
+	UINT count = mipLevels == 0 ? fullCount : (std::min)(mipLevels, fullCount);
+	UINT pixelBytes = GetPixelBytes(format);
+
+	levels.resize(count);
+	for (UINT mip = 0; mip < count; ++mip)
+	{
+		Level& level = levels[mip];
+		level.Width = (std::max)(1u, width >> mip);
+		level.Height = (std::max)(1u, height >> mip);
+		level.RowPitch = level.Width * pixelBytes;
+		level.Data.resize(static_cast<size_t>(level.RowPitch) * level.Height);
+	}
+
+	const uint8_t* srcBytes = static_cast<const uint8_t*>(src);
+	for (UINT y = 0; y < height; ++y)
+	{
+		memcpy(&levels[0].Data[static_cast<size_t>(y) * levels[0].RowPitch], srcBytes + static_cast<size_t>(y) * rowPitch, levels[0].RowPitch);
+	}
+
+	for (UINT mip = 1; mip < count; ++mip)
+	{
+		const Level& parent = levels[mip - 1];
+		Downsample(format, filter, parent.Data.data(), parent.Width, parent.Height, parent.RowPitch, levels[mip].Data.data(), levels[mip].RowPitch);
+	}
+}
+
+void GMipGenerator::Downsample(Format format, Filter filter, const void* src, UINT srcWidth, UINT srcHeight, UINT srcRowPitch,
+	void* dst, UINT dstRowPitch)
+{
+	UINT dstWidth = (std::max)(1u, srcWidth / 2);
+	UINT dstHeight = (std::max)(1u, srcHeight / 2);
+
+	const uint8_t* srcBytes = static_cast<const uint8_t*>(src);
+	uint8_t* dstBytes = static_cast<uint8_t*>(dst);
+
+	if (filter != FILTER_KAISER && srcWidth == 2 * dstWidth && srcHeight == 2 * dstHeight)
+	{
+		GThreadPool::Get().ParallelFor(dstHeight, RowsPerRange, [&](UINT begin, UINT end)
+		{
+			for (UINT y = begin; y < end; ++y)
+			{
+				const uint8_t* row0 = srcBytes + static_cast<size_t>(2 * y) * srcRowPitch;
+				const uint8_t* row1 = row0 + srcRowPitch;
+				uint8_t* out = dstBytes + static_cast<size_t>(y) * dstRowPitch;
+
+				if (format == FORMAT_R32_FLOAT)
+				{
+					ReduceRowFloat(filter, reinterpret_cast<const float*>(row0), reinterpret_cast<const float*>(row1), reinterpret_cast<float*>(out), dstWidth);
+				}
+				else if (format == FORMAT_R8G8B8A8_SRGB && filter == FILTER_BOX)
+				{
+					ReduceRowSRGB(row0, row1, out, dstWidth);
+				}
+				else
+				{
+					// Min and max pick the same texel whichever side of the sRGB curve they run on.
+					ReduceRowRGBA8(filter, row0, row1, out, dstWidth);
+				}
+			}
+		});
+
+		return;
+	}
+
+	Resize(format, filter, src, srcWidth, srcHeight, srcRowPitch, dst, dstWidth, dstHeight, dstRowPitch);
+}
+
+void GMipGenerator::Resize(Format format, Filter filter, const void* src, UINT srcWidth, UINT srcHeight, UINT srcRowPitch,
+	void* dst, UINT dstWidth, UINT dstHeight, UINT dstRowPitch)
+{
+	const uint8_t* srcBytes = static_cast<const uint8_t*>(src);
+	uint8_t* dstBytes = static_cast<uint8_t*>(dst);
+
+	FilterTable horizontal;
+	FilterTable vertical;
+	BuildFilterTable(filter, srcWidth, dstWidth, horizontal);
+	BuildFilterTable(filter, srcHeight, dstHeight, vertical);
+
+	GThreadPool::Get().ParallelFor(dstHeight, RowsPerRange, [&](UINT begin, UINT end)
+	{
+		FilterBand(format, filter, srcBytes, srcWidth, srcRowPitch, horizontal, vertical, dstBytes, dstWidth, dstRowPitch, begin, end);
+	});
+}
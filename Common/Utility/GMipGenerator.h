@@ -0,0 +1,61 @@
+/*  ===============================================
+	Summary: CPU Mip-Chain Generation
+	===============================================  */
+
+#ifndef GMIPGENERATOR_H
+#define GMIPGENERATOR_H
+
+#include <Windows.h>
+#include <cstdint>
+#include <vector>
+
+// Builds mip chains on the CPU, either while a texture is being loaded or offline before it is
+// written to a DDS file.  Each level is filtered from the one above it, with its rows spread
+// across the thread pool.
+class GMipGenerator
+{
+public:
+	// The 8-bit formats filter every channel independently, so BGRA data works as well.
+	enum Format
+	{
+		FORMAT_R8G8B8A8,
+		FORMAT_R8G8B8A8_SRGB,	// colour is averaged in linear space; alpha is left linear
+		FORMAT_R32_FLOAT,
+	};
+
+	enum Filter
+	{
+		FILTER_BOX,		// 2x2 average
+		FILTER_KAISER,	// Kaiser-windowed sinc; sharper than a box without much ringing
+		FILTER_MIN,		// smallest value under the texel, e.g. conservative heightmap bounds
+		FILTER_MAX,		// largest value under the texel
+	};
+
+	struct Level
+	{
+		UINT Width;
+		UINT Height;
+		UINT RowPitch;
+		std::vector<uint8_t> Data;
+	};
+
+	// Number of levels in a full chain down to 1x1.
+	static UINT GetMipCount(UINT width, UINT height);
+	static UINT GetPixelBytes(Format format);
+
+	// Copies the source into levels[0] and fills in the levels below it, mipLevels in total or
+	// the full chain when mipLevels is 0.  Levels are tightly packed.
+	static void GenerateChain(Format format, Filter filter, const void* src, UINT width, UINT height, UINT rowPitch,
+		std::vector<Level>& levels, UINT mipLevels = 0);
+
+	// Filters one level into the next, which is max(1, srcWidth / 2) by max(1, srcHeight / 2).
+	static void Downsample(Format format, Filter filter, const void* src, UINT srcWidth, UINT srcHeight, UINT srcRowPitch,
+		void* dst, UINT dstRowPitch);
+
+	// Resamples to any size, e.g. to bring textures to a common size before packing them.
+	// Kaiser suits both shrinking and enlarging; box, min and max pick the nearest texel when enlarging.
+	static void Resize(Format format, Filter filter, const void* src, UINT srcWidth, UINT srcHeight, UINT srcRowPitch,
+		void* dst, UINT dstWidth, UINT dstHeight, UINT dstRowPitch);
+};
+
+#endif // GMIPGENERATOR_H
\ No newline at end of file
@@ -0,0 +1,175 @@
+/*  ===============================================
+	Summary: Model File Reader and Writer
+	===============================================  */
+
+#include "GModelFile.h"
+#include "GProfiler.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	const uint32_t ModelMagic = 0x4C444D47; // "GMDL"
+	const uint32_t ModelVersion = 1;
+
+	const uint32_t ModelFlagAmbientAccess = 0x1;
+
+	struct Header
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t VertexCount;
+		uint32_t IndexCount;
+		uint32_t Flags;
+	};
+
+	FILE* OpenFile(LPCWSTR filename, const wchar_t* mode)
+	{
+#if defined(_WIN32)
+		FILE* file = nullptr;
+		return _wfopen_s(&file, filename, mode) == 0 ? file : nullptr;
+#else
+		char path[4096];
+		char narrowMode[8];
+		size_t length = wcstombs(path, filename, sizeof(path));
+		if (length == static_cast<size_t>(-1) || length >= sizeof(path) || wcstombs(narrowMode, mode, sizeof(narrowMode)) >= sizeof(narrowMode))
+		{
+			return nullptr;
+		}
+		return fopen(path, narrowMode);
+#endif
+	}
+
+	template <typename T>
+	bool ReadArray(FILE* file, std::vector<T>& data, uint32_t count)
+	{
+		data.resize(count);
+		return count == 0 || fread(data.data(), sizeof(T), count, file) == count;
+	}
+
+	template <typename T>
+	bool WriteArray(FILE* file, const std::vector<T>& data)
+	{
+		return data.empty() || fwrite(data.data(), sizeof(T), data.size(), file) == data.size();
+	}
+}
+
+bool GModelFile::ReadText(LPCWSTR filename, Mesh& mesh)
+{
+	GPROFILE_SCOPE("GModelFile::ReadText");
+
+	FILE* file = OpenFile(filename, L"r");
+	if (!file)
+	{
+		return false;
+	}
+
+	UINT vertexCount = 0;
+	UINT triangleCount = 0;
+
+	bool bOk = fscanf(file, " VertexCount: %u TriangleCount: %u VertexList (pos, normal) {", &vertexCount, &triangleCount) == 2;
+
+	mesh.Positions.resize(bOk ? vertexCount : 0);
+	mesh.Normals.resize(bOk ? vertexCount : 0);
+	mesh.Indices.resize(bOk ? triangleCount * 3 : 0);
+	mesh.AmbientAccess.clear();
+
+	for (UINT i = 0; i < vertexCount && bOk; ++i)
+	{
+		DirectX::XMFLOAT3& p = mesh.Positions[i];
+		DirectX::XMFLOAT3& n = mesh.Normals[i];
+		bOk = fscanf(file, "%f %f %f %f %f %f", &p.x, &p.y, &p.z, &n.x, &n.y, &n.z) == 6;
+	}
+
+	bOk = bOk && fscanf(file, " } TriangleList {") == 0;
+
+	for (UINT i = 0; i < triangleCount && bOk; ++i)
+	{
+		bOk = fscanf(file, "%u %u %u", &mesh.Indices[i * 3 + 0], &mesh.Indices[i * 3 + 1], &mesh.Indices[i * 3 + 2]) == 3;
+	}
+
+	fclose(file);
+
+	for (size_t i = 0; i < mesh.Indices.size() && bOk; ++i)
+	{
+		bOk = mesh.Indices[i] < vertexCount;
+	}
+
+	return bOk;
+}
+
+bool GModelFile::Read(LPCWSTR filename, Mesh& mesh)
+{
+	GPROFILE_SCOPE("GModelFile::Read");
+
+	FILE* file = OpenFile(filename, L"rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	Header header = {};
+	bool bOk = fread(&header, sizeof(header), 1, file) == 1 && header.Magic == ModelMagic && header.Version == ModelVersion;
+
+	bOk = bOk &&
+		ReadArray(file, mesh.Positions, header.VertexCount) &&
+		ReadArray(file, mesh.Normals, header.VertexCount) &&
+		ReadArray(file, mesh.Indices, header.IndexCount) &&
+		ReadArray(file, mesh.AmbientAccess, (header.Flags & ModelFlagAmbientAccess) ? header.VertexCount : 0);
+
+	fclose(file);
+
+	for (size_t i = 0; i < mesh.Indices.size() && bOk; ++i)
+	{
+		bOk = mesh.Indices[i] < header.VertexCount;
+	}
+
+	return bOk;
+}
+
+bool GModelFile::Write(LPCWSTR filename, const Mesh& mesh)
+{
+	if (mesh.Normals.size() != mesh.Positions.size() ||
+		(!mesh.AmbientAccess.empty() && mesh.AmbientAccess.size() != mesh.Positions.size()))
+	{
+		return false;
+	}
+
+	FILE* file = OpenFile(filename, L"wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	Header header = {};
+	header.Magic = ModelMagic;
+	header.Version = ModelVersion;
+	header.VertexCount = static_cast<uint32_t>(mesh.Positions.size());
+	header.IndexCount = static_cast<uint32_t>(mesh.Indices.size());
+	header.Flags = mesh.AmbientAccess.empty() ? 0 : ModelFlagAmbientAccess;
+
+	bool bOk = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		WriteArray(file, mesh.Positions) &&
+		WriteArray(file, mesh.Normals) &&
+		WriteArray(file, mesh.Indices) &&
+		WriteArray(file, mesh.AmbientAccess);
+
+	return fclose(file) == 0 && bOk;
+}
+
+bool GModelFile::ReadAny(LPCWSTR filename, Mesh& mesh)
+{
+	FILE* file = OpenFile(filename, L"rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	uint32_t magic = 0;
+	bool bBinary = fread(&magic, sizeof(magic), 1, file) == 1 && magic == ModelMagic;
+	fclose(file);
+
+	return bBinary ? Read(filename, mesh) : ReadText(filename, mesh);
+}
\ No newline at end of file
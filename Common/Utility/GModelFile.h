@@ -0,0 +1,39 @@
+/*  ===============================================
+	Summary: Model File Reader and Writer
+	===============================================  */
+
+#ifndef GMODELFILE_H
+#define GMODELFILE_H
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <vector>
+
+// Reads the text models under Models/ (VertexList of position and normal, then TriangleList),
+// and reads and writes a binary form that loads without parsing and can carry baked per-vertex
+// ambient access.
+class GModelFile
+{
+public:
+	struct Mesh
+	{
+		std::vector<DirectX::XMFLOAT3> Positions;
+		std::vector<DirectX::XMFLOAT3> Normals;
+
+		// Three per triangle.
+		std::vector<UINT> Indices;
+
+		// One per vertex, or empty if the model has not been baked.
+		std::vector<float> AmbientAccess;
+	};
+
+	static bool ReadText(LPCWSTR filename, Mesh& mesh);
+
+	static bool Read(LPCWSTR filename, Mesh& mesh);
+	static bool Write(LPCWSTR filename, const Mesh& mesh);
+
+	// Reads either form, by whether the file starts with the binary header.
+	static bool ReadAny(LPCWSTR filename, Mesh& mesh);
+};
+
+#endif // GMODELFILE_H
\ No newline at end of file
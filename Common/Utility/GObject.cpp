@@ -5,6 +5,7 @@
 #include "GObject.h"
 #include "GTriangle.h"
 #include "D3DUtil.h"
+#include "GProfiler.h"
 
 GObject::GObject()
 {
@@ -43,6 +44,8 @@ bool GObject::Init()
 
 bool GObject::ReadObjFile()
 {
+	GPROFILE_SCOPE("GObject::ReadObjFile");
+
 	DirectX::XMFLOAT3 vMinf3(+MathHelper::Infinity, +MathHelper::Infinity, +MathHelper::Infinity);
 	DirectX::XMFLOAT3 vMaxf3(-MathHelper::Infinity, -MathHelper::Infinity, -MathHelper::Infinity);
 
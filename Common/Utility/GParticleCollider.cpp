@@ -0,0 +1,253 @@
+/*  ===============================================
+	Summary: Particle vs. Scene Collision
+	===============================================  */
+
+#include "GParticleCollider.h"
+#include "GThreadPool.h"
+
+#include <atomic>
+#include <cmath>
+
+namespace
+{
+	const UINT BucketsPerRange = 1024;
+
+	void Respond(DirectX::XMFLOAT3& p, DirectX::XMFLOAT3& v, const DirectX::XMFLOAT3& n, float penetration, float restitution, float friction)
+	{
+		// Push the particle back onto the surface.
+		p.x += n.x * penetration;
+		p.y += n.y * penetration;
+		p.z += n.z * penetration;
+
+		// Only respond if the particle is moving into the surface.
+		float vn = v.x * n.x + v.y * n.y + v.z * n.z;
+		if (vn >= 0.0f)
+		{
+			return;
+		}
+
+		DirectX::XMFLOAT3 vNormal(n.x * vn, n.y * vn, n.z * vn);
+		DirectX::XMFLOAT3 vTangent(v.x - vNormal.x, v.y - vNormal.y, v.z - vNormal.z);
+
+		v.x = vTangent.x * (1.0f - friction) - vNormal.x * restitution;
+		v.y = vTangent.y * (1.0f - friction) - vNormal.y * restitution;
+		v.z = vTangent.z * (1.0f - friction) - vNormal.z * restitution;
+	}
+
+	bool CollideSphere(const DirectX::BoundingSphere& s, const DirectX::XMFLOAT3& p, DirectX::XMFLOAT3& n, float& penetration)
+	{
+		float dx = p.x - s.Center.x;
+		float dy = p.y - s.Center.y;
+		float dz = p.z - s.Center.z;
+		float distSq = dx*dx + dy*dy + dz*dz;
+
+		if (distSq >= s.Radius * s.Radius)
+		{
+			return false;
+		}
+
+		float dist = sqrtf(distSq);
+		if (dist > 1e-6f)
+		{
+			n = DirectX::XMFLOAT3(dx / dist, dy / dist, dz / dist);
+		}
+		else
+		{
+			n = DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f);
+		}
+
+		penetration = s.Radius - dist;
+		return true;
+	}
+
+	bool CollideBox(const DirectX::BoundingBox& b, const DirectX::XMFLOAT3& p, DirectX::XMFLOAT3& n, float& penetration)
+	{
+		float d[3] = { p.x - b.Center.x, p.y - b.Center.y, p.z - b.Center.z };
+		float e[3] = { b.Extents.x, b.Extents.y, b.Extents.z };
+
+		// Leave through the closest face.
+		int axis = -1;
+		float minDepth = 0.0f;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			float depth = e[i] - fabsf(d[i]);
+			if (depth <= 0.0f)
+			{
+				return false;
+			}
+
+			if (axis < 0 || depth < minDepth)
+			{
+				axis = i;
+				minDepth = depth;
+			}
+		}
+
+		float normal[3] = { 0.0f, 0.0f, 0.0f };
+		normal[axis] = d[axis] < 0.0f ? -1.0f : 1.0f;
+
+		n = DirectX::XMFLOAT3(normal[0], normal[1], normal[2]);
+		penetration = minDepth;
+		return true;
+	}
+}
+
+GParticleCollider::GParticleCollider() :
+	mRestitution(0.3f),
+	mFriction(0.2f),
+	mContactCount(0),
+	mCollidersDirty(true)
+{
+}
+
+GParticleCollider::~GParticleCollider()
+{
+}
+
+void GParticleCollider::Init(float cellSize, UINT maxParticles)
+{
+	// Twice as many buckets as particles keeps most buckets to a single cell.
+	UINT tableSize = maxParticles * 2 > 1024 ? maxParticles * 2 : 1024;
+
+	mParticleHash.Init(cellSize, tableSize);
+	mColliderHash.Init(cellSize, tableSize);
+
+	mCollidersDirty = true;
+}
+
+void GParticleCollider::ClearColliders()
+{
+	mSpheres.clear();
+	mBoxes.clear();
+	mPlanes.clear();
+	mCollidersDirty = true;
+}
+
+void GParticleCollider::AddSphere(const DirectX::BoundingSphere& sphere)
+{
+	mSpheres.push_back(sphere);
+	mCollidersDirty = true;
+}
+
+void GParticleCollider::AddBox(const DirectX::BoundingBox& box)
+{
+	mBoxes.push_back(box);
+	mCollidersDirty = true;
+}
+
+void GParticleCollider::AddPlane(const DirectX::XMFLOAT4& plane)
+{
+	mPlanes.push_back(plane);
+}
+
+void GParticleCollider::SetResponse(float restitution, float friction)
+{
+	mRestitution = restitution;
+	mFriction = friction;
+}
+
+void GParticleCollider::BinColliders()
+{
+	mColliderBounds.clear();
+	mColliderBounds.reserve(mSpheres.size() + mBoxes.size());
+
+	for (size_t i = 0; i < mSpheres.size(); ++i)
+	{
+		DirectX::BoundingBox bounds;
+		DirectX::BoundingBox::CreateFromSphere(bounds, mSpheres[i]);
+		mColliderBounds.push_back(bounds);
+	}
+
+	mColliderBounds.insert(mColliderBounds.end(), mBoxes.begin(), mBoxes.end());
+
+	mColliderHash.BuildBounds(mColliderBounds.data(), static_cast<UINT>(mColliderBounds.size()));
+	mCollidersDirty = false;
+}
+
+void GParticleCollider::Collide(GParticleSystem& particles)
+{
+	if (mCollidersDirty)
+	{
+		BinColliders();
+	}
+
+	DirectX::XMFLOAT3* positions = particles.GetPositions();
+	DirectX::XMFLOAT3* velocities = particles.GetVelocities();
+
+	mParticleHash.BuildPoints(positions, particles.GetMaxParticles());
+
+	UINT numSpheres = static_cast<UINT>(mSpheres.size());
+	std::atomic<UINT> contacts(0);
+
+	// Every particle sits in exactly one bucket, so buckets can be resolved in parallel without
+	// locking.  The collider lookup happens once per bucket instead of once per particle.
+	GThreadPool::Get().ParallelFor(mParticleHash.GetTableSize(), BucketsPerRange, [&](UINT begin, UINT end)
+	{
+		UINT localContacts = 0;
+
+		for (UINT hash = begin; hash < end; ++hash)
+		{
+			UINT numItems = mParticleHash.GetBucketSize(hash);
+			if (numItems == 0)
+			{
+				continue;
+			}
+
+			const UINT* items = mParticleHash.GetBucket(hash);
+			const UINT* colliders = mColliderHash.GetBucket(hash);
+			UINT numColliders = mColliderHash.GetBucketSize(hash);
+
+			if (numColliders == 0 && mPlanes.empty())
+			{
+				continue;
+			}
+
+			for (UINT i = 0; i < numItems; ++i)
+			{
+				UINT slot = items[i];
+				if (!particles.IsAlive(slot))
+				{
+					continue;
+				}
+
+				DirectX::XMFLOAT3& p = positions[slot];
+				DirectX::XMFLOAT3& v = velocities[slot];
+
+				DirectX::XMFLOAT3 n;
+				float penetration;
+
+				for (UINT c = 0; c < numColliders; ++c)
+				{
+					UINT collider = colliders[c];
+
+					bool bHit = collider < numSpheres ?
+						CollideSphere(mSpheres[collider], p, n, penetration) :
+						CollideBox(mBoxes[collider - numSpheres], p, n, penetration);
+
+					if (bHit)
+					{
+						Respond(p, v, n, penetration, mRestitution, mFriction);
+						++localContacts;
+					}
+				}
+
+				for (size_t c = 0; c < mPlanes.size(); ++c)
+				{
+					const DirectX::XMFLOAT4& plane = mPlanes[c];
+					float dist = plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w;
+
+					if (dist < 0.0f)
+					{
+						Respond(p, v, DirectX::XMFLOAT3(plane.x, plane.y, plane.z), -dist, mRestitution, mFriction);
+						++localContacts;
+					}
+				}
+			}
+		}
+
+		contacts += localContacts;
+	});
+
+	mContactCount = contacts;
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+/*  ===============================================
+	Summary: Particle vs. Scene Collision
+	===============================================  */
+
+#ifndef GPARTICLECOLLIDER_H
+#define GPARTICLECOLLIDER_H
+
+#include "GParticleSystem.h"
+#include "GSpatialHash.h"
+
+#include <DirectXCollision.h>
+#include <vector>
+
+class GParticleCollider
+{
+public:
+	GParticleCollider();
+	~GParticleCollider();
+
+	// Particles and colliders are binned into two hashes that share the cell size and table
+	// size, so a particle bucket maps straight onto the collider bucket with the same hash.
+	void Init(float cellSize, UINT maxParticles);
+
+	void ClearColliders();
+	void AddSphere(const DirectX::BoundingSphere& sphere);
+	void AddBox(const DirectX::BoundingBox& box);
+
+	// Plane (a, b, c, d) with a unit normal; particles are kept on the positive side.
+	// Planes are unbounded, so they are tested against every particle instead of being binned.
+	void AddPlane(const DirectX::XMFLOAT4& plane);
+
+	// Restitution scales the bounce along the contact normal, friction damps the tangential velocity.
+	void SetResponse(float restitution, float friction);
+
+	// Rebins the particles, then pushes every live particle out of the colliders it penetrates.
+	void Collide(GParticleSystem& particles);
+
+	// Valid after Collide; use for particle neighbour queries.
+	inline const GSpatialHash& GetParticleHash() const { return mParticleHash; }
+
+	inline UINT GetContactCount() const { return mContactCount; }
+
+private:
+	void BinColliders();
+
+private:
+	std::vector<DirectX::BoundingSphere> mSpheres;
+	std::vector<DirectX::BoundingBox> mBoxes;
+	std::vector<DirectX::XMFLOAT4> mPlanes;
+
+	// Spheres first, then boxes.
+	std::vector<DirectX::BoundingBox> mColliderBounds;
+
+	GSpatialHash mParticleHash;
+	GSpatialHash mColliderHash;
+
+	float mRestitution;
+	float mFriction;
+
+	UINT mContactCount;
+	bool mCollidersDirty;
+};
+
+#endif // GPARTICLECOLLIDER_H
\ No newline at end of file
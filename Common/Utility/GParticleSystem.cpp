@@ -0,0 +1,202 @@
+/*  ================================================
+	Summary: CPU Simulated Particle System
+	================================================  */
+
+#include "GParticleSystem.h"
+#include "GThreadPool.h"
+#include "MathHelper.h"
+
+#include <mutex>
+
+namespace
+{
+	const UINT ParticlesPerRange = 4096;
+	const float DeadAge = -1.0f;
+}
+
+GParticleSystem::GParticleSystem() :
+	mEmitPosW(0.0f, 0.0f, 0.0f),
+	mEmitDirW(0.0f, 1.0f, 0.0f),
+	mAccelW(0.0f, 0.0f, 0.0f),
+	mMaxParticles(0),
+	mAliveCount(0),
+	mLifetime(1.0f),
+	mEmitRate(0.0f),
+	mEmitAccumulator(0.0f),
+	mSpeed(1.0f),
+	mSpread(0.5f),
+	mStartSize(1.0f),
+	mEndSize(1.0f)
+{
+}
+
+GParticleSystem::~GParticleSystem()
+{
+}
+
+void GParticleSystem::Init(UINT maxParticles, float lifetime, float emitRate)
+{
+	mMaxParticles = maxParticles;
+	mLifetime = lifetime;
+	mEmitRate = emitRate;
+
+	mPositions.resize(maxParticles);
+	mVelocities.resize(maxParticles);
+	mAges.resize(maxParticles);
+	mSortKeys.resize(maxParticles);
+	mDrawOrder.resize(maxParticles);
+
+	Reset();
+}
+
+void GParticleSystem::Reset()
+{
+	mAliveCount = 0;
+	mEmitAccumulator = 0.0f;
+
+	mFreeSlots.resize(mMaxParticles);
+
+	for (UINT i = 0; i < mMaxParticles; ++i)
+	{
+		mAges[i] = DeadAge;
+		mDrawOrder[i] = i;
+
+		// Hand out low slots first.
+		mFreeSlots[i] = mMaxParticles - 1 - i;
+	}
+
+	mSorter.Reset();
+}
+
+void GParticleSystem::SetEmitter(const DirectX::XMFLOAT3& posW, const DirectX::XMFLOAT3& dirW)
+{
+	mEmitPosW = posW;
+	mEmitDirW = dirW;
+}
+
+void GParticleSystem::SetAcceleration(const DirectX::XMFLOAT3& accelW)
+{
+	mAccelW = accelW;
+}
+
+void GParticleSystem::SetSpeed(float speed, float spread)
+{
+	mSpeed = speed;
+	mSpread = spread;
+}
+
+void GParticleSystem::SetSize(float startSize, float endSize)
+{
+	mStartSize = startSize;
+	mEndSize = endSize;
+}
+
+float GParticleSystem::GetSize(UINT slot) const
+{
+	return MathHelper::Lerp(mStartSize, mEndSize, mAges[slot] / mLifetime);
+}
+
+void GParticleSystem::Update(float dt)
+{
+	std::mutex deadMutex;
+	UINT numDied = 0;
+
+	DirectX::XMFLOAT3 accelW = mAccelW;
+	float lifetime = mLifetime;
+
+	GThreadPool::Get().ParallelFor(mMaxParticles, ParticlesPerRange, [&](UINT begin, UINT end)
+	{
+		std::vector<UINT> died;
+
+		for (UINT i = begin; i < end; ++i)
+		{
+			if (mAges[i] < 0.0f)
+			{
+				continue;
+			}
+
+			mAges[i] += dt;
+
+			if (mAges[i] > lifetime)
+			{
+				mAges[i] = DeadAge;
+				died.push_back(i);
+				continue;
+			}
+
+			DirectX::XMFLOAT3& v = mVelocities[i];
+			v.x += accelW.x * dt;
+			v.y += accelW.y * dt;
+			v.z += accelW.z * dt;
+
+			DirectX::XMFLOAT3& p = mPositions[i];
+			p.x += v.x * dt;
+			p.y += v.y * dt;
+			p.z += v.z * dt;
+		}
+
+		if (!died.empty())
+		{
+			std::lock_guard<std::mutex> lock(deadMutex);
+			mFreeSlots.insert(mFreeSlots.end(), died.begin(), died.end());
+			numDied += static_cast<UINT>(died.size());
+		}
+	});
+
+	mAliveCount -= numDied;
+
+	mEmitAccumulator += mEmitRate * dt;
+	UINT numToEmit = static_cast<UINT>(mEmitAccumulator);
+	mEmitAccumulator -= static_cast<float>(numToEmit);
+
+	Emit(numToEmit);
+}
+
+void GParticleSystem::Emit(UINT numParticles)
+{
+	DirectX::XMVECTOR dir = DirectX::XMVector3Normalize(DirectX::XMLoadFloat3(&mEmitDirW));
+
+	for (UINT n = 0; n < numParticles && !mFreeSlots.empty(); ++n)
+	{
+		UINT slot = mFreeSlots.back();
+		mFreeSlots.pop_back();
+
+		DirectX::XMVECTOR jitter = DirectX::XMVectorScale(MathHelper::RandUnitVec3(), mSpread);
+		DirectX::XMVECTOR vel = DirectX::XMVectorScale(DirectX::XMVectorAdd(dir, jitter), mSpeed);
+
+		mPositions[slot] = mEmitPosW;
+		DirectX::XMStoreFloat3(&mVelocities[slot], vel);
+		mAges[slot] = 0.0f;
+
+		++mAliveCount;
+	}
+}
+
+void GParticleSystem::SortBackToFront(const DirectX::XMFLOAT3& eyePosW, const DirectX::XMFLOAT3& lookW)
+{
+	if (mMaxParticles == 0)
+	{
+		return;
+	}
+
+	// Dead slots get the largest key so they collect at the end of the draw order.  Keying
+	// every slot keeps the count constant, which lets the sorter reuse last frame's order.
+	GThreadPool::Get().ParallelFor(mMaxParticles, ParticlesPerRange, [&](UINT begin, UINT end)
+	{
+		for (UINT i = begin; i < end; ++i)
+		{
+			if (mAges[i] < 0.0f)
+			{
+				mSortKeys[i] = 0xFFFFFFFF;
+				continue;
+			}
+
+			const DirectX::XMFLOAT3& p = mPositions[i];
+			float depth = (p.x - eyePosW.x) * lookW.x + (p.y - eyePosW.y) * lookW.y + (p.z - eyePosW.z) * lookW.z;
+
+			mSortKeys[i] = GRadixSort::BackToFrontKey(depth);
+		}
+	});
+
+	mSorter.Sort(&mSortKeys[0], mMaxParticles, &mDrawOrder[0]);
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+/*  ================================================
+	Summary: CPU Simulated Particle System
+	================================================  */
+
+#ifndef GPARTICLESYSTEM_H
+#define GPARTICLESYSTEM_H
+
+#include "GRadixSort.h"
+
+#include <DirectXMath.h>
+#include <vector>
+
+class GParticleSystem
+{
+public:
+	GParticleSystem();
+	~GParticleSystem();
+
+	// Particles live in fixed slots so the draw order stays stable between frames.
+	void Init(UINT maxParticles, float lifetime, float emitRate);
+	void Reset();
+
+	void SetEmitter(const DirectX::XMFLOAT3& posW, const DirectX::XMFLOAT3& dirW);
+	void SetAcceleration(const DirectX::XMFLOAT3& accelW);
+	void SetSpeed(float speed, float spread);
+	void SetSize(float startSize, float endSize);
+
+	void Update(float dt);
+
+	// Sorts the live particles back to front along the camera look direction.
+	void SortBackToFront(const DirectX::XMFLOAT3& eyePosW, const DirectX::XMFLOAT3& lookW);
+
+	inline UINT GetMaxParticles() const { return mMaxParticles; }
+	inline UINT GetAliveCount() const { return mAliveCount; }
+	inline float GetLifetime() const { return mLifetime; }
+
+	// The first GetAliveCount() entries are the slots of live particles, farthest first.
+	inline const UINT* GetDrawOrder() const { return &mDrawOrder[0]; }
+	inline GRadixSort::SortPath GetLastSortPath() const { return mSorter.GetLastPath(); }
+
+	inline const DirectX::XMFLOAT3& GetPosition(UINT slot) const { return mPositions[slot]; }
+	inline const DirectX::XMFLOAT3& GetVelocity(UINT slot) const { return mVelocities[slot]; }
+	inline float GetAge(UINT slot) const { return mAges[slot]; }
+	inline bool IsAlive(UINT slot) const { return mAges[slot] >= 0.0f; }
+	float GetSize(UINT slot) const;
+
+	// Direct access for systems that move particles after the simulation step, such as collision.
+	inline DirectX::XMFLOAT3* GetPositions() { return &mPositions[0]; }
+	inline DirectX::XMFLOAT3* GetVelocities() { return &mVelocities[0]; }
+
+private:
+	void Emit(UINT numParticles);
+
+private:
+	std::vector<DirectX::XMFLOAT3> mPositions;
+	std::vector<DirectX::XMFLOAT3> mVelocities;
+	std::vector<float> mAges;
+
+	std::vector<UINT> mFreeSlots;
+	std::vector<UINT> mSortKeys;
+	std::vector<UINT> mDrawOrder;
+
+	GRadixSort mSorter;
+
+	DirectX::XMFLOAT3 mEmitPosW;
+	DirectX::XMFLOAT3 mEmitDirW;
+	DirectX::XMFLOAT3 mAccelW;
+
+	UINT mMaxParticles;
+	UINT mAliveCount;
+
+	float mLifetime;
+	float mEmitRate;
+	float mEmitAccumulator;
+
+	float mSpeed;
+	float mSpread;
+	float mStartSize;
+	float mEndSize;
+};
+
+#endif // GPARTICLESYSTEM_H
\ No newline at end of file
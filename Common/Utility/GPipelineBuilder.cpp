@@ -0,0 +1,235 @@
+/*  ===============================================
+	Summary: Parallel Shader Pipeline Builder
+	===============================================  */
+
+#include "GPipelineBuilder.h"
+#include "GShaderCache.h"
+#include "GThreadPool.h"
+
+#include <chrono>
+#include <sstream>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// Target profiles, by ShaderStage.
+	const char* const Targets[] = { "vs_5_0", "hs_5_0", "ds_5_0", "gs_5_0", "ps_5_0", "cs_5_0" };
+
+	double ToMs(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+}
+
+GPipelineBuilder::GPipelineBuilder() :
+	mCache(GShaderCache::Get()),
+	mPool(GThreadPool::Get()),
+	mBuildMs(0.0),
+	mThreadCount(0)
+{
+}
+
+GPipelineBuilder::GPipelineBuilder(GShaderCache& cache) :
+	mCache(cache),
+	mPool(GThreadPool::Get()),
+	mBuildMs(0.0),
+	mThreadCount(0)
+{
+}
+
+GPipelineBuilder::GPipelineBuilder(GShaderCache& cache, GThreadPool& pool) :
+	mCache(cache),
+	mPool(pool),
+	mBuildMs(0.0),
+	mThreadCount(0)
+{
+}
+
+GPipelineBuilder::~GPipelineBuilder()
+{
+}
+
+UINT GPipelineBuilder::AddJob(ShaderStage stage, void* shader, LPCWSTR filename, LPCSTR entryPoint)
+{
+	Job job;
+	job.Filename = filename;
+	job.EntryPoint = entryPoint;
+	job.Stage = stage;
+	job.Shader = shader;
+	job.Layout = nullptr;
+	job.RasterizedStream = 0;
+	job.Result = E_PENDING;
+	job.CompileMs = 0.0;
+	job.CreateMs = 0.0;
+
+	mJobs.push_back(job);
+	return static_cast<UINT>(mJobs.size() - 1);
+}
+
+UINT GPipelineBuilder::AddVertexShader(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint,
+	const D3D11_INPUT_ELEMENT_DESC* layoutDesc, UINT numElements, ID3D11InputLayout** layout)
+{
+	UINT index = AddJob(STAGE_VERTEX, shader, filename, entryPoint);
+
+	if (layoutDesc && layout)
+	{
+		mJobs[index].InputLayout.assign(layoutDesc, layoutDesc + numElements);
+		mJobs[index].Layout = layout;
+	}
+
+	return index;
+}
+
+UINT GPipelineBuilder::AddHullShader(ID3D11HullShader** shader, LPCWSTR filename, LPCSTR entryPoint)
+{
+	return AddJob(STAGE_HULL, shader, filename, entryPoint);
+}
+
+UINT GPipelineBuilder::AddDomainShader(ID3D11DomainShader** shader, LPCWSTR filename, LPCSTR entryPoint)
+{
+	return AddJob(STAGE_DOMAIN, shader, filename, entryPoint);
+}
+
+UINT GPipelineBuilder::AddGeometryShader(ID3D11GeometryShader** shader, LPCWSTR filename, LPCSTR entryPoint,
+	const D3D11_SO_DECLARATION_ENTRY* soDecl, UINT numEntries, UINT rasterizedStream)
+{
+	UINT index = AddJob(STAGE_GEOMETRY, shader, filename, entryPoint);
+
+	if (soDecl)
+	{
+		mJobs[index].StreamOut.assign(soDecl, soDecl + numEntries);
+		mJobs[index].RasterizedStream = rasterizedStream;
+	}
+
+	return index;
+}
+
+UINT GPipelineBuilder::AddPixelShader(ID3D11PixelShader** shader, LPCWSTR filename, LPCSTR entryPoint)
+{
+	return AddJob(STAGE_PIXEL, shader, filename, entryPoint);
+}
+
+UINT GPipelineBuilder::AddComputeShader(ID3D11ComputeShader** shader, LPCWSTR filename, LPCSTR entryPoint)
+{
+	return AddJob(STAGE_COMPUTE, shader, filename, entryPoint);
+}
+
+bool GPipelineBuilder::Build(ID3D11Device* device)
+{
+	Clock::time_point start = Clock::now();
+
+	mThreadCount = mPool.GetThreadCount();
+
+	mPool.Dispatch(static_cast<UINT>(mJobs.size()), [this, device](UINT i) { RunJob(device, mJobs[i]); });
+
+	mBuildMs = ToMs(Clock::now() - start);
+
+	for (size_t i = 0; i < mJobs.size(); ++i)
+	{
+		if (FAILED(mJobs[i].Result))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void GPipelineBuilder::RunJob(ID3D11Device* device, Job& job)
+{
+	Clock::time_point start = Clock::now();
+
+	std::vector<uint8_t> bytecode;
+	bool bCompiled = mCache.Load(job.Filename.c_str(), job.EntryPoint.c_str(), Targets[job.Stage],
+		GShaderCache::GetDefaultFlags(), bytecode, &job.Errors);
+
+	Clock::time_point compiled = Clock::now();
+	job.CompileMs = ToMs(compiled - start);
+
+	if (!bCompiled)
+	{
+		job.Result = E_FAIL;
+		return;
+	}
+
+	job.Result = device ? CreateObjects(device, job, bytecode) : S_OK;
+	job.CreateMs = device ? ToMs(Clock::now() - compiled) : 0.0;
+}
+
+HRESULT GPipelineBuilder::CreateObjects(ID3D11Device* device, Job& job, const std::vector<uint8_t>& bytecode)
+{
+	const void* code = bytecode.data();
+	SIZE_T size = bytecode.size();
+
+	switch (job.Stage)
+	{
+	case STAGE_VERTEX:
+	{
+		HRESULT hr = device->CreateVertexShader(code, size, nullptr, static_cast<ID3D11VertexShader**>(job.Shader));
+		if (SUCCEEDED(hr) && job.Layout)
+		{
+			hr = device->CreateInputLayout(job.InputLayout.data(), static_cast<UINT>(job.InputLayout.size()), code, size, job.Layout);
+		}
+		return hr;
+	}
+
+	case STAGE_HULL:
+		return device->CreateHullShader(code, size, nullptr, static_cast<ID3D11HullShader**>(job.Shader));
+
+	case STAGE_DOMAIN:
+		return device->CreateDomainShader(code, size, nullptr, static_cast<ID3D11DomainShader**>(job.Shader));
+
+	case STAGE_GEOMETRY:
+		if (!job.StreamOut.empty())
+		{
+			return device->CreateGeometryShaderWithStreamOutput(code, size, job.StreamOut.data(), static_cast<UINT>(job.StreamOut.size()),
+				nullptr, 0, job.RasterizedStream, nullptr, static_cast<ID3D11GeometryShader**>(job.Shader));
+		}
+		return device->CreateGeometryShader(code, size, nullptr, static_cast<ID3D11GeometryShader**>(job.Shader));
+
+	case STAGE_PIXEL:
+		return device->CreatePixelShader(code, size, nullptr, static_cast<ID3D11PixelShader**>(job.Shader));
+
+	case STAGE_COMPUTE:
+		return device->CreateComputeShader(code, size, nullptr, static_cast<ID3D11ComputeShader**>(job.Shader));
+	}
+
+	return E_INVALIDARG;
+}
+
+std::wstring GPipelineBuilder::GetReport() const
+{
+	std::wostringstream report;
+	report.precision(2);
+	report << std::fixed;
+
+	double jobMs = 0.0;
+
+	for (size_t i = 0; i < mJobs.size(); ++i)
+	{
+		const Job& job = mJobs[i];
+		jobMs += job.CompileMs + job.CreateMs;
+
+		report << job.Filename << L" " << std::wstring(job.EntryPoint.begin(), job.EntryPoint.end())
+			<< L": compile " << job.CompileMs << L" ms, create " << job.CreateMs << L" ms"
+			<< (FAILED(job.Result) ? L", FAILED" : L"") << L"\n";
+
+		if (!job.Errors.empty())
+		{
+			report << std::wstring(job.Errors.begin(), job.Errors.end()) << L"\n";
+		}
+	}
+
+	// The job total over the wall time is how much the threads bought.
+	report << mJobs.size() << L" shaders built in " << mBuildMs << L" ms on " << mThreadCount
+		<< L" threads (" << jobMs << L" ms of work)\n";
+
+	return report.str();
+}
+
+void GPipelineBuilder::Clear()
+{
+	mJobs.clear();
+	mBuildMs = 0.0;
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+/*  ===============================================
+	Summary: Parallel Shader Pipeline Builder
+	===============================================  */
+
+#ifndef GPIPELINEBUILDER_H
+#define GPIPELINEBUILDER_H
+
+#include <Windows.h>
+#include <d3d11.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class GShaderCache;
+class GThreadPool;
+
+// Builds a list of shaders on the shared thread pool.  Each job compiles through the shader cache
+// and then creates its shader, and the input layout or stream output declared with it, on the same
+// worker as soon as the bytecode is ready; the device is free-threaded, so nothing waits for the
+// slowest compile.  Build returns once every job is done, so the demo can draw right after.
+class GPipelineBuilder
+{
+public:
+	enum ShaderStage
+	{
+		STAGE_VERTEX,
+		STAGE_HULL,
+		STAGE_DOMAIN,
+		STAGE_GEOMETRY,
+		STAGE_PIXEL,
+		STAGE_COMPUTE
+	};
+
+	struct Job
+	{
+		std::wstring Filename;
+		std::string EntryPoint;
+		ShaderStage Stage;
+
+		// Receives the shader: an ID3D11VertexShader** for a vertex shader, and so on.
+		void* Shader;
+
+		// Vertex shaders: with elements, an input layout is created against this shader's signature.
+		std::vector<D3D11_INPUT_ELEMENT_DESC> InputLayout;
+		ID3D11InputLayout** Layout;
+
+		// Geometry shaders: with entries, the shader streams them out.
+		std::vector<D3D11_SO_DECLARATION_ENTRY> StreamOut;
+		UINT RasterizedStream;
+
+		// Filled in by Build.
+		HRESULT Result;
+		std::string Errors;
+		double CompileMs;
+		double CreateMs;
+	};
+
+	// Compiles through the process-wide shader cache, on the shared thread pool.
+	GPipelineBuilder();
+	explicit GPipelineBuilder(GShaderCache& cache);
+	GPipelineBuilder(GShaderCache& cache, GThreadPool& pool);
+	~GPipelineBuilder();
+
+	// Each returns the job's index.  Semantic names are not copied, so they must outlive Build;
+	// string literals do.
+	UINT AddVertexShader(ID3D11VertexShader** shader, LPCWSTR filename, LPCSTR entryPoint,
+		const D3D11_INPUT_ELEMENT_DESC* layoutDesc = nullptr, UINT numElements = 0, ID3D11InputLayout** layout = nullptr);
+	UINT AddHullShader(ID3D11HullShader** shader, LPCWSTR filename, LPCSTR entryPoint);
+	UINT AddDomainShader(ID3D11DomainShader** shader, LPCWSTR filename, LPCSTR entryPoint);
+	UINT AddGeometryShader(ID3D11GeometryShader** shader, LPCWSTR filename, LPCSTR entryPoint,
+		const D3D11_SO_DECLARATION_ENTRY* soDecl = nullptr, UINT numEntries = 0, UINT rasterizedStream = 0);
+	UINT AddPixelShader(ID3D11PixelShader** shader, LPCWSTR filename, LPCSTR entryPoint);
+	UINT AddComputeShader(ID3D11ComputeShader** shader, LPCWSTR filename, LPCSTR entryPoint);
+
+	// Runs every job and waits for all of them.  Without a device the shaders are only compiled,
+	// which fills the shader cache.  Returns false if any job failed.
+	bool Build(ID3D11Device* device);
+
+	inline UINT GetJobCount() const { return static_cast<UINT>(mJobs.size()); }
+	inline const Job& GetJob(UINT index) const { return mJobs[index]; }
+
+	// Wall time of the last Build.
+	inline double GetBuildMs() const { return mBuildMs; }
+
+	// A line per job with its compile and create times and any compiler messages, then the total.
+	std::wstring GetReport() const;
+
+	void Clear();
+
+private:
+	UINT AddJob(ShaderStage stage, void* shader, LPCWSTR filename, LPCSTR entryPoint);
+	void RunJob(ID3D11Device* device, Job& job);
+	HRESULT CreateObjects(ID3D11Device* device, Job& job, const std::vector<uint8_t>& bytecode);
+
+	GPipelineBuilder(const GPipelineBuilder&);
+	GPipelineBuilder& operator=(const GPipelineBuilder&);
+
+private:
+	GShaderCache& mCache;
+	GThreadPool& mPool;
+
+	std::vector<Job> mJobs;
+
+	double mBuildMs;
+	UINT mThreadCount;
+};
+
+#endif // GPIPELINEBUILDER_H
\ No newline at end of file
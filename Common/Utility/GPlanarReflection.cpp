@@ -0,0 +1,174 @@
+/*  ===============================================
+	Summary: Planar Mirror Reflection
+	===============================================  */
+
+#include "GPlanarReflection.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	// A quad clipped by one plane has at most one more corner.
+	const UINT MaxClippedCorners = 5;
+
+	// Column of a row-vector matrix, as the plane it tests in homogeneous clip space.
+	XMVECTOR GetColumn(const XMFLOAT4X4& m, UINT column)
+	{
+		return XMVectorSet(m.m[0][column], m.m[1][column], m.m[2][column], m.m[3][column]);
+	}
+}
+
+GPlanarReflection::GPlanarReflection() :
+	mPlane(0.0f, 0.0f, -1.0f, 0.0f),
+	mScreenBounds(0.0f, 0.0f, 0.0f, 0.0f)
+{
+	for (UINT i = 0; i < 4; ++i)
+	{
+		mCorners[i] = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	}
+
+	for (UINT i = 0; i < 6; ++i)
+	{
+		mFrustumPlanes[i] = XMFLOAT4(0.0f, 0.0f, 0.0f, -1.0f);
+	}
+
+	XMStoreFloat4x4(&mReflection, XMMatrixReflect(XMLoadFloat4(&mPlane)));
+}
+
+GPlanarReflection::~GPlanarReflection()
+{
+}
+
+void GPlanarReflection::SetMirror(const XMFLOAT3 corners[4])
+{
+	for (UINT i = 0; i < 4; ++i)
+	{
+		mCorners[i] = corners[i];
+	}
+
+	// Clockwise from the front, so in a left-handed space the normal faces the viewer.
+	XMVECTOR c0 = XMLoadFloat3(&corners[0]);
+	XMVECTOR normal = XMVector3Normalize(XMVector3Cross(
+		XMVectorSubtract(XMLoadFloat3(&corners[1]), c0),
+		XMVectorSubtract(XMLoadFloat3(&corners[2]), c0)));
+
+	XMVECTOR plane = XMPlaneFromPointNormal(c0, normal);
+	XMStoreFloat4(&mPlane, plane);
+	XMStoreFloat4x4(&mReflection, XMMatrixReflect(plane));
+}
+
+bool GPlanarReflection::Update(const XMFLOAT4X4& view, const XMFLOAT4X4& proj)
+{
+	// Skip a mirror the camera sees from behind or edge on.
+	XMMATRIX V = XMLoadFloat4x4(&view);
+	XMVECTOR eye = XMMatrixInverse(nullptr, V).r[3];
+	if (XMVectorGetX(XMPlaneDotCoord(XMLoadFloat4(&mPlane), eye)) <= 0.0f)
+	{
+		return false;
+	}
+
+	XMFLOAT4X4 viewProj;
+	XMStoreFloat4x4(&viewProj, XMMatrixMultiply(V, XMLoadFloat4x4(&proj)));
+	XMMATRIX VP = XMLoadFloat4x4(&viewProj);
+
+	// Clip the quad to the near plane, z >= 0 in clip space, so corners behind the camera do not
+	// project to the wrong side of the screen.
+	XMFLOAT4 clipped[MaxClippedCorners];
+	UINT clippedCount = 0;
+
+	for (UINT i = 0; i < 4; ++i)
+	{
+		XMFLOAT4 a;
+		XMFLOAT4 b;
+		XMStoreFloat4(&a, XMVector4Transform(XMVectorSetW(XMLoadFloat3(&mCorners[i]), 1.0f), VP));
+		XMStoreFloat4(&b, XMVector4Transform(XMVectorSetW(XMLoadFloat3(&mCorners[(i + 1) % 4]), 1.0f), VP));
+
+		if (a.z >= 0.0f)
+		{
+			clipped[clippedCount++] = a;
+		}
+
+		if ((a.z >= 0.0f) != (b.z >= 0.0f))
+		{
+			float t = a.z / (a.z - b.z);
+			clipped[clippedCount++] = XMFLOAT4(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, 0.0f, a.w + (b.w - a.w) * t);
+		}
+	}
+
+	// The screen rectangle of what is left, cut to the viewport.
+	float minX = FLT_MAX;
+	float minY = FLT_MAX;
+	float maxX = -FLT_MAX;
+	float maxY = -FLT_MAX;
+
+	for (UINT i = 0; i < clippedCount; ++i)
+	{
+		float invW = 1.0f / (std::max)(clipped[i].w, 1e-6f);
+		minX = (std::min)(minX, clipped[i].x * invW);
+		minY = (std::min)(minY, clipped[i].y * invW);
+		maxX = (std::max)(maxX, clipped[i].x * invW);
+		maxY = (std::max)(maxY, clipped[i].y * invW);
+	}
+
+	minX = (std::max)(minX, -1.0f);
+	minY = (std::max)(minY, -1.0f);
+	maxX = (std::min)(maxX, 1.0f);
+	maxY = (std::min)(maxY, 1.0f);
+
+	if (clippedCount == 0 || minX >= maxX || minY >= maxY)
+	{
+		return false;
+	}
+
+	mScreenBounds = XMFLOAT4(minX, minY, maxX, maxY);
+
+	// Planes of the narrowed frustum, from the clip-space inequalities x >= minX * w and so on.
+	XMVECTOR colX = GetColumn(viewProj, 0);
+	XMVECTOR colY = GetColumn(viewProj, 1);
+	XMVECTOR colZ = GetColumn(viewProj, 2);
+	XMVECTOR colW = GetColumn(viewProj, 3);
+
+	XMVECTOR planes[6] =
+	{
+		XMVectorSubtract(colX, XMVectorScale(colW, minX)),
+		XMVectorSubtract(XMVectorScale(colW, maxX), colX),
+		XMVectorSubtract(colY, XMVectorScale(colW, minY)),
+		XMVectorSubtract(XMVectorScale(colW, maxY), colY),
+		XMVectorSubtract(colW, colZ),
+
+		// What the camera sees in the mirror is behind it.
+		XMVectorNegate(XMLoadFloat4(&mPlane))
+	};
+
+	// A world point p is reflected to p * R, so plane c holds for the reflection when R c holds for p.
+	XMMATRIX RT = XMMatrixTranspose(GetReflection());
+	for (UINT i = 0; i < 6; ++i)
+	{
+		XMStoreFloat4(&mFrustumPlanes[i], XMVector4Transform(planes[i], RT));
+	}
+
+	return true;
+}
+
+bool GPlanarReflection::IsVisible(const BoundingBox& bounds) const
+{
+	for (UINT i = 0; i < 6; ++i)
+	{
+		const XMFLOAT4& p = mFrustumPlanes[i];
+
+		// The box corner furthest along the plane normal.
+		float distance = p.x * bounds.Center.x + p.y * bounds.Center.y + p.z * bounds.Center.z + p.w +
+			fabsf(p.x) * bounds.Extents.x + fabsf(p.y) * bounds.Extents.y + fabsf(p.z) * bounds.Extents.z;
+
+		if (distance < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
\ No newline at end of file
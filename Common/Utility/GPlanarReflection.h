@@ -0,0 +1,53 @@
+/*  ===============================================
+	Summary: Planar Mirror Reflection
+	===============================================  */
+
+#ifndef GPLANARREFLECTION_H
+#define GPLANARREFLECTION_H
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+// Fits a planar mirror to the camera each frame.  The reflected camera sees the world through the
+// mirror quad only, so its frustum is the camera frustum narrowed to the quad's screen rectangle and
+// starting at the mirror plane; reflected back into world space, it culls the objects whose
+// reflections cannot show up in the mirror.
+class GPlanarReflection
+{
+public:
+	GPlanarReflection();
+	~GPlanarReflection();
+
+	// The mirror quad's world-space corners, clockwise as seen from the reflective side.
+	void SetMirror(const DirectX::XMFLOAT3 corners[4]);
+
+	// Returns false when the reflection pass can be skipped: the camera is behind the mirror or the
+	// mirror is off screen.
+	bool Update(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& proj);
+
+	// Reflects world space through the mirror plane.
+	inline DirectX::XMMATRIX GetReflection() const { return DirectX::XMLoadFloat4x4(&mReflection); }
+
+	// The mirror plane, with the normal facing the reflective side.
+	inline const DirectX::XMFLOAT4& GetPlane() const { return mPlane; }
+
+	// The part of the screen the mirror covers, in NDC: min x, min y, max x, max y.
+	inline const DirectX::XMFLOAT4& GetScreenBounds() const { return mScreenBounds; }
+
+	// Whether the reflection of a world-space box can be seen in the mirror.  Only meaningful after
+	// Update has returned true.
+	bool IsVisible(const DirectX::BoundingBox& bounds) const;
+
+private:
+	DirectX::XMFLOAT3 mCorners[4];
+	DirectX::XMFLOAT4 mPlane;
+	DirectX::XMFLOAT4X4 mReflection;
+	DirectX::XMFLOAT4 mScreenBounds;
+
+	// The narrowed frustum, reflected into world space: left, right, bottom, top, far, and the mirror.
+	// A point is inside when it is on the positive side of all six.
+	DirectX::XMFLOAT4 mFrustumPlanes[6];
+};
+
+#endif // GPLANARREFLECTION_H
\ No newline at end of file
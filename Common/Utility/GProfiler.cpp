@@ -0,0 +1,413 @@
+/*  ===============================================
+	Summary: Hierarchical CPU Profiler
+	===============================================  */
+
+#include "GProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cwchar>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	FILE* OpenTraceFile(const std::wstring& filename)
+	{
+#if defined(_WIN32)
+		FILE* file = nullptr;
+		return _wfopen_s(&file, filename.c_str(), L"wb") == 0 ? file : nullptr;
+#else
+		char path[4096];
+		size_t length = wcstombs(path, filename.c_str(), sizeof(path));
+		if (length == static_cast<size_t>(-1) || length >= sizeof(path))
+		{
+			return nullptr;
+		}
+		return fopen(path, "wb");
+#endif
+	}
+
+	void WriteJsonString(FILE* file, const char* text)
+	{
+		fputc('"', file);
+		for (const char* c = text; *c; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				fputc('\\', file);
+				fputc(*c, file);
+			}
+			else if (static_cast<unsigned char>(*c) < 0x20)
+			{
+				fprintf(file, "\\u%04x", static_cast<unsigned int>(static_cast<unsigned char>(*c)));
+			}
+			else
+			{
+				fputc(*c, file);
+			}
+		}
+		fputc('"', file);
+	}
+}
+
+thread_local GProfiler::ThreadBuffer* GProfiler::tThreadBuffer = nullptr;
+
+GProfiler::GProfiler() :
+	mFrameCount(0),
+	mDroppedCount(0),
+	mStartTicks(Now()),
+	mStartTime(Clock::now())
+{
+}
+
+GProfiler::~GProfiler()
+{
+	for (size_t i = 0; i < mThreads.size(); ++i)
+	{
+		delete mThreads[i];
+	}
+}
+
+GProfiler& GProfiler::Get()
+{
+	static GProfiler profiler;
+	return profiler;
+}
+
+double GProfiler::GetTicksPerSecond() const
+{
+#if GPROFILER_USE_RDTSC
+	// The TSC runs at a constant rate on any CPU that runs these demos; measuring it over the
+	// whole run keeps the error well under a part in a million after the first second.
+	Clock::duration elapsed = Clock::now() - mStartTime;
+	if (elapsed < std::chrono::milliseconds(1))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		elapsed = Clock::now() - mStartTime;
+	}
+
+	int64_t ticks = Now() - mStartTicks;
+	return static_cast<double>(ticks) / std::chrono::duration<double>(elapsed).count();
+#else
+	return static_cast<double>(Clock::period::den) / Clock::period::num;
+#endif
+}
+
+GProfiler::ThreadBuffer& GProfiler::RegisterThread()
+{
+	ThreadBuffer* buffer = new ThreadBuffer;
+	buffer->Events.resize(EventsPerThread);
+	buffer->Write.store(0, std::memory_order_relaxed);
+	buffer->Depth = 0;
+	buffer->Read = 0;
+	std::fill(buffer->ChildTicks, buffer->ChildTicks + MaxDepth + 1, 0);
+
+	std::lock_guard<std::mutex> lock(mThreadMutex);
+	buffer->ThreadIndex = static_cast<uint32_t>(mThreads.size());
+	mThreads.push_back(buffer);
+
+	tThreadBuffer = buffer;
+	return *buffer;
+}
+
+void GProfiler::SetThreadName(const char* name)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+
+	std::lock_guard<std::mutex> lock(mThreadMutex);
+	buffer.Name = name;
+}
+
+uint64_t GProfiler::CopyEvents(const ThreadBuffer& buffer, uint64_t first, std::vector<Event>& events, uint64_t& dropped)
+{
+	uint64_t last = buffer.Write.load(std::memory_order_acquire);
+	if (last - first > EventsPerThread)
+	{
+		dropped += last - first - EventsPerThread;
+		first = last - EventsPerThread;
+	}
+
+	size_t begin = events.size();
+	for (uint64_t i = first; i < last; ++i)
+	{
+		events.push_back(buffer.Events[i & (EventsPerThread - 1)]);
+	}
+
+	// The owner may have lapped the oldest copies while they were read.  Its next write goes to
+	// slot Write, so everything at or before Write - EventsPerThread may be torn.
+	uint64_t written = buffer.Write.load(std::memory_order_acquire);
+	if (written >= first + EventsPerThread)
+	{
+		uint64_t torn = (std::min)(written - EventsPerThread + 1, last) - first;
+		events.erase(events.begin() + begin, events.begin() + begin + static_cast<size_t>(torn));
+		dropped += torn;
+	}
+
+	return last;
+}
+
+GProfiler::History& GProfiler::FindHistory(const char* name, bool bCounter)
+{
+	// Literals with the same text may have different addresses in different files, so the
+	// pointer only caches the lookup by text.
+	std::unordered_map<const char*, History*>::iterator cached = mHistoryByName.find(name);
+	if (cached != mHistoryByName.end())
+	{
+		return *cached->second;
+	}
+
+	std::unordered_map<std::string, History>::iterator it = mHistory.find(name);
+	if (it == mHistory.end())
+	{
+		History history;
+		history.Name = name;
+		history.bCounter = bCounter;
+		history.FrameTicks = 0;
+		history.FrameSelfTicks = 0;
+		history.FrameCalls = 0;
+		history.Value = 0.0;
+		history.Totals.assign(SummaryFrames, 0.0f);
+		history.SelfTotals.assign(SummaryFrames, 0.0f);
+		history.Calls.assign(SummaryFrames, 0);
+
+		it = mHistory.insert(std::make_pair(history.Name, history)).first;
+	}
+
+	mHistoryByName[name] = &it->second;
+	return it->second;
+}
+
+void GProfiler::EndFrame()
+{
+	std::vector<ThreadBuffer*> threads;
+	{
+		std::lock_guard<std::mutex> lock(mThreadMutex);
+		threads = mThreads;
+	}
+
+	std::lock_guard<std::mutex> lock(mHistoryMutex);
+
+	for (size_t t = 0; t < threads.size(); ++t)
+	{
+		ThreadBuffer& buffer = *threads[t];
+
+		mScratch.clear();
+		uint64_t dropped = 0;
+		buffer.Read = CopyEvents(buffer, buffer.Read, mScratch, dropped);
+
+		// Parents and children no longer pair up across a gap.
+		if (dropped > 0)
+		{
+			mDroppedCount += dropped;
+			std::fill(buffer.ChildTicks, buffer.ChildTicks + MaxDepth + 1, 0);
+		}
+
+		// Events are in the order zones closed, so a zone's children are all in before it.
+		for (size_t i = 0; i < mScratch.size(); ++i)
+		{
+			const Event& event = mScratch[i];
+
+			if (event.Type == EVENT_COUNTER)
+			{
+				FindHistory(event.Name, true).Value = event.Value;
+				continue;
+			}
+
+			uint32_t depth = (std::min)(event.Depth, MaxDepth - 1);
+			int64_t ticks = event.End - event.Start;
+
+			History& history = FindHistory(event.Name, false);
+			history.FrameTicks += ticks;
+			history.FrameSelfTicks += ticks - buffer.ChildTicks[depth + 1];
+			history.FrameCalls++;
+
+			buffer.ChildTicks[depth + 1] = 0;
+			buffer.ChildTicks[depth] += ticks;
+		}
+	}
+
+	double msPerTick = 1000.0 / GetTicksPerSecond();
+	uint32_t slot = mFrameCount % SummaryFrames;
+
+	for (std::unordered_map<std::string, History>::iterator it = mHistory.begin(); it != mHistory.end(); ++it)
+	{
+		History& history = it->second;
+
+		if (history.bCounter)
+		{
+			// A counter holds its value until it is set again.
+			history.Totals[slot] = static_cast<float>(history.Value);
+		}
+		else
+		{
+			history.Totals[slot] = static_cast<float>(history.FrameTicks * msPerTick);
+			history.SelfTotals[slot] = static_cast<float>(history.FrameSelfTicks * msPerTick);
+			history.Calls[slot] = history.FrameCalls;
+		}
+
+		history.FrameTicks = 0;
+		history.FrameSelfTicks = 0;
+		history.FrameCalls = 0;
+	}
+
+	mFrameCount++;
+}
+
+void GProfiler::GetSummary(std::vector<SummaryRow>& rows) const
+{
+	rows.clear();
+
+	std::lock_guard<std::mutex> lock(mHistoryMutex);
+
+	uint32_t frames = mFrameCount < SummaryFrames ? mFrameCount : SummaryFrames;
+	if (frames == 0)
+	{
+		return;
+	}
+
+	for (std::unordered_map<std::string, History>::const_iterator it = mHistory.begin(); it != mHistory.end(); ++it)
+	{
+		const History& history = it->second;
+
+		SummaryRow row;
+		row.Name = history.Name;
+		row.bCounter = history.bCounter;
+		row.Average = 0.0;
+		row.Peak = 0.0;
+		row.AverageSelf = 0.0;
+		row.AverageCalls = 0.0;
+
+		for (uint32_t i = 0; i < frames; ++i)
+		{
+			row.Average += history.Totals[i];
+			row.Peak = (std::max)(row.Peak, static_cast<double>(history.Totals[i]));
+			row.AverageSelf += history.SelfTotals[i];
+			row.AverageCalls += history.Calls[i];
+		}
+
+		row.Average /= frames;
+		row.AverageSelf /= frames;
+		row.AverageCalls /= frames;
+
+		rows.push_back(row);
+	}
+
+	// Zones first, slowest on top; then counters by name.
+	std::sort(rows.begin(), rows.end(), [](const SummaryRow& a, const SummaryRow& b)
+	{
+		if (a.bCounter != b.bCounter)
+		{
+			return !a.bCounter;
+		}
+		return a.bCounter ? a.Name < b.Name : a.Average > b.Average;
+	});
+}
+
+std::wstring GProfiler::GetReport() const
+{
+	std::vector<SummaryRow> rows;
+	GetSummary(rows);
+
+	std::wostringstream report;
+	report.precision(3);
+	report << std::fixed;
+
+	for (size_t i = 0; i < rows.size(); ++i)
+	{
+		const SummaryRow& row = rows[i];
+		report << std::wstring(row.Name.begin(), row.Name.end());
+
+		if (row.bCounter)
+		{
+			report << L": average " << row.Average << L", peak " << row.Peak << L"\n";
+		}
+		else
+		{
+			report << L": " << row.Average << L" ms (self " << row.AverageSelf << L" ms, peak " << row.Peak
+				<< L" ms, " << row.AverageCalls << L" calls)\n";
+		}
+	}
+
+	report << L"Averaged over the last " << (mFrameCount < SummaryFrames ? mFrameCount : SummaryFrames) << L" frames";
+	if (mDroppedCount > 0)
+	{
+		report << L"; " << mDroppedCount << L" events dropped";
+	}
+	report << L"\n";
+
+	return report.str();
+}
+
+bool GProfiler::WriteTrace(const std::wstring& filename) const
+{
+	std::vector<ThreadBuffer*> threads;
+	std::vector<std::string> names;
+	{
+		std::lock_guard<std::mutex> lock(mThreadMutex);
+		threads = mThreads;
+		for (size_t t = 0; t < threads.size(); ++t)
+		{
+			names.push_back(threads[t]->Name);
+		}
+	}
+
+	FILE* file = OpenTraceFile(filename);
+	if (!file)
+	{
+		return false;
+	}
+
+	double usPerTick = 1000000.0 / GetTicksPerSecond();
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool bFirst = true;
+
+	std::vector<Event> events;
+	for (size_t t = 0; t < threads.size(); ++t)
+	{
+		uint32_t tid = threads[t]->ThreadIndex;
+
+		std::string name = names[t];
+		if (name.empty())
+		{
+			name = "Thread " + std::to_string(tid);
+		}
+
+		fprintf(file, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":", bFirst ? "" : ",\n", tid);
+		WriteJsonString(file, name.c_str());
+		fprintf(file, "}}");
+		bFirst = false;
+
+		events.clear();
+		uint64_t dropped = 0;
+		CopyEvents(*threads[t], 0, events, dropped);
+
+		for (size_t i = 0; i < events.size(); ++i)
+		{
+			const Event& event = events[i];
+			double start = (event.Start - mStartTicks) * usPerTick;
+
+			if (event.Type == EVENT_COUNTER)
+			{
+				fprintf(file, ",\n{\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"name\":", tid, start);
+				WriteJsonString(file, event.Name);
+				fprintf(file, ",\"args\":{\"value\":%.17g}}", event.Value);
+			}
+			else
+			{
+				fprintf(file, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":", tid, start,
+					(event.End - event.Start) * usPerTick);
+				WriteJsonString(file, event.Name);
+				fprintf(file, "}");
+			}
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+
+	bool bWritten = ferror(file) == 0;
+	return fclose(file) == 0 && bWritten;
+}
\ No newline at end of file
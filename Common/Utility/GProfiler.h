@@ -0,0 +1,248 @@
+/*  ===============================================
+	Summary: Hierarchical CPU Profiler
+	===============================================  */
+
+#ifndef GPROFILER_H
+#define GPROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define GPROFILER_USE_RDTSC 1
+#else
+#define GPROFILER_USE_RDTSC 0
+#endif
+
+// Define GPROFILER_ENABLED as 0 to compile every GPROFILE_ macro away.
+#ifndef GPROFILER_ENABLED
+#define GPROFILER_ENABLED 1
+#endif
+
+// Records timed zones and counters from any thread.  Each thread writes into its own ring buffer,
+// so a zone costs two timestamp reads and one store, with no lock and no allocation once the
+// thread's ring exists.  Zones nest; the depth is kept so EndFrame can split each zone's time into
+// its own and its children's.  EndFrame folds the events recorded since the last frame into a
+// rolling per-zone summary, and WriteTrace exports whatever the rings still hold as Chrome trace
+// JSON, which chrome://tracing and ui.perfetto.dev both open.  Names must be string literals, or
+// otherwise outlive the profiler.
+class GProfiler
+{
+public:
+	enum EventType
+	{
+		EVENT_ZONE,
+		EVENT_COUNTER
+	};
+
+	struct Event
+	{
+		const char* Name;
+		int64_t Start;
+		union
+		{
+			int64_t End;
+			double Value;
+		};
+		uint32_t Depth;
+		uint32_t Type;
+	};
+
+	// One zone or counter, averaged over the summary window.  For a zone the times are per frame
+	// and in milliseconds; for a counter Average and Peak are its values.
+	struct SummaryRow
+	{
+		std::string Name;
+		bool bCounter;
+		double Average;
+		double Peak;
+		double AverageSelf;
+		double AverageCalls;
+	};
+
+	GProfiler();
+	~GProfiler();
+
+	// Process-wide profiler used by the GPROFILE_ macros.
+	static GProfiler& Get();
+
+	static inline int64_t Now()
+	{
+#if GPROFILER_USE_RDTSC
+		return static_cast<int64_t>(__rdtsc());
+#else
+		return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+	}
+
+	// Timestamps per second, measured against the steady clock when timestamps come from the TSC.
+	double GetTicksPerSecond() const;
+
+	static inline void Counter(const char* name, double value)
+	{
+		Event event;
+		event.Name = name;
+		event.Start = Now();
+		event.Value = value;
+		event.Depth = 0;
+		event.Type = EVENT_COUNTER;
+		Push(GetThreadBuffer(), event);
+	}
+
+	// Names the calling thread in the trace.
+	void SetThreadName(const char* name);
+
+	// Folds the events recorded since the last call into the summary.  Call once per frame, from
+	// one thread, after the frame's outermost zone has closed.
+	void EndFrame();
+
+	// Frames the summary averages over.
+	static const uint32_t SummaryFrames = 120;
+
+	void GetSummary(std::vector<SummaryRow>& rows) const;
+
+	// A line per zone and counter, slowest zone first.
+	std::wstring GetReport() const;
+
+	// Writes the events still in the rings as a Chrome trace.
+	bool WriteTrace(const std::wstring& filename) const;
+
+	// Events overwritten before EndFrame read them; a larger ring or more frequent frames fix it.
+	inline uint64_t GetDroppedCount() const { return mDroppedCount; }
+
+private:
+	friend class GProfileScope;
+
+	static const uint32_t EventsPerThread = 1 << 16;
+	static const uint32_t MaxDepth = 64;
+
+	struct ThreadBuffer
+	{
+		std::vector<Event> Events;
+		std::atomic<uint64_t> Write;
+		uint32_t Depth;
+		uint32_t ThreadIndex;
+		std::string Name;
+
+		// Owned by EndFrame.
+		uint64_t Read;
+		int64_t ChildTicks[MaxDepth + 1];
+	};
+
+	struct History
+	{
+		std::string Name;
+		bool bCounter;
+
+		// This frame, in ticks, or the counter's latest value.
+		int64_t FrameTicks;
+		int64_t FrameSelfTicks;
+		uint32_t FrameCalls;
+		double Value;
+
+		// Last SummaryFrames frames, oldest overwritten first.
+		std::vector<float> Totals;
+		std::vector<float> SelfTotals;
+		std::vector<uint32_t> Calls;
+	};
+
+	static inline ThreadBuffer& GetThreadBuffer()
+	{
+		ThreadBuffer* buffer = tThreadBuffer;
+		return buffer ? *buffer : Get().RegisterThread();
+	}
+
+	// Only the owning thread writes, so publishing the event is a single release store.
+	static inline void Push(ThreadBuffer& buffer, const Event& event)
+	{
+		uint64_t index = buffer.Write.load(std::memory_order_relaxed);
+		buffer.Events[index & (EventsPerThread - 1)] = event;
+		buffer.Write.store(index + 1, std::memory_order_release);
+	}
+
+	ThreadBuffer& RegisterThread();
+
+	// Copies events [first, Write) that survive being read while the owner keeps writing.  Returns
+	// the index after the last one.
+	static uint64_t CopyEvents(const ThreadBuffer& buffer, uint64_t first, std::vector<Event>& events, uint64_t& dropped);
+
+	History& FindHistory(const char* name, bool bCounter);
+
+	GProfiler(const GProfiler&);
+	GProfiler& operator=(const GProfiler&);
+
+private:
+	static thread_local ThreadBuffer* tThreadBuffer;
+
+	std::vector<ThreadBuffer*> mThreads;
+	mutable std::mutex mThreadMutex;
+
+	std::unordered_map<std::string, History> mHistory;
+	std::unordered_map<const char*, History*> mHistoryByName;
+	mutable std::mutex mHistoryMutex;
+	uint32_t mFrameCount;
+
+	std::vector<Event> mScratch;
+	uint64_t mDroppedCount;
+
+	// Ties timestamps to the steady clock; the trace starts here.
+	int64_t mStartTicks;
+	std::chrono::steady_clock::time_point mStartTime;
+};
+
+// Times the enclosing scope.
+class GProfileScope
+{
+public:
+	inline explicit GProfileScope(const char* name) :
+		mBuffer(GProfiler::GetThreadBuffer())
+	{
+		mEvent.Name = name;
+		mEvent.Depth = mBuffer.Depth++;
+		mEvent.Type = GProfiler::EVENT_ZONE;
+		mEvent.Start = GProfiler::Now();
+	}
+
+	inline ~GProfileScope()
+	{
+		mEvent.End = GProfiler::Now();
+		--mBuffer.Depth;
+		GProfiler::Push(mBuffer, mEvent);
+	}
+
+private:
+	GProfileScope(const GProfileScope&);
+	GProfileScope& operator=(const GProfileScope&);
+
+private:
+	GProfiler::ThreadBuffer& mBuffer;
+	GProfiler::Event mEvent;
+};
+
+#if GPROFILER_ENABLED
+#define GPROFILE_CONCAT_INNER(a, b) a##b
+#define GPROFILE_CONCAT(a, b) GPROFILE_CONCAT_INNER(a, b)
+#define GPROFILE_SCOPE(name) GProfileScope GPROFILE_CONCAT(profileScope, __LINE__)(name)
+#define GPROFILE_FUNCTION() GPROFILE_SCOPE(__FUNCTION__)
+#define GPROFILE_COUNTER(name, value) GProfiler::Counter(name, static_cast<double>(value))
+#define GPROFILE_THREAD(name) GProfiler::Get().SetThreadName(name)
+#define GPROFILE_END_FRAME() GProfiler::Get().EndFrame()
+#else
+#define GPROFILE_SCOPE(name) ((void)0)
+#define GPROFILE_FUNCTION() ((void)0)
+#define GPROFILE_COUNTER(name, value) ((void)0)
+#define GPROFILE_THREAD(name) ((void)0)
+#define GPROFILE_END_FRAME() ((void)0)
+#endif
+
+#endif // GPROFILER_H
\ No newline at end of file
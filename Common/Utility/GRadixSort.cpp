@@ -0,0 +1,275 @@
+/*  ===============================================
+	Summary: Parallel LSD Radix Sort for Draw Order
+	===============================================  */
+
+#include "GRadixSort.h"
+#include "GThreadPool.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+	const UINT RadixBits = 8;
+	const UINT RadixBuckets = 1 << RadixBits;
+	const UINT RadixPasses = 32 / RadixBits;
+
+	// Below this many keys per chunk the cost of waking workers outweighs the sort itself.
+	const UINT MinKeysPerChunk = 16384;
+}
+
+GRadixSort::GRadixSort() :
+	mCoherenceTolerance(0.01f),
+	mLastPath(SORT_NONE)
+{
+}
+
+GRadixSort::~GRadixSort()
+{
+}
+
+void GRadixSort::Reset()
+{
+	mPrevOrder.clear();
+	mLastPath = SORT_NONE;
+}
+
+void GRadixSort::SetCoherenceTolerance(float fraction)
+{
+	mCoherenceTolerance = fraction < 0.0f ? 0.0f : fraction;
+}
+
+UINT GRadixSort::FloatToKey(float f)
+{
+	// Flip every bit of negative floats and only the sign bit of positive floats,
+	// so the raw bits compare in the same order as the float values.
+	UINT bits;
+	memcpy(&bits, &f, sizeof(UINT));
+
+	UINT mask = (bits & 0x80000000) ? 0xFFFFFFFF : 0x80000000;
+	return bits ^ mask;
+}
+
+void GRadixSort::Sort(const UINT* keys, UINT count, UINT* outIndices)
+{
+	if (count == 0)
+	{
+		mPrevOrder.clear();
+		mLastPath = SORT_NONE;
+		return;
+	}
+
+	if (mKeys[0].size() < count)
+	{
+		for (int i = 0; i < 2; ++i)
+		{
+			mKeys[i].resize(count);
+			mValues[i].resize(count);
+		}
+	}
+
+	if (!TryPreviousOrder(keys, count))
+	{
+		RadixSort(keys, count);
+		mLastPath = SORT_RADIX;
+	}
+
+	memcpy(outIndices, &mPrevOrder[0], count * sizeof(UINT));
+}
+
+bool GRadixSort::TryPreviousOrder(const UINT* keys, UINT count)
+{
+	if (mPrevOrder.size() != count)
+	{
+		return false;
+	}
+
+	UINT* orderKeys = &mKeys[0][0];
+	UINT* orderValues = &mValues[0][0];
+	const UINT* prevOrder = &mPrevOrder[0];
+
+	// Gather the new keys in last frame's order and count the neighbours that are out of order.
+	std::atomic<UINT> descents(0);
+
+	GThreadPool::Get().ParallelFor(count, MinKeysPerChunk, [&](UINT begin, UINT end)
+	{
+		UINT localDescents = 0;
+
+		for (UINT i = begin; i < end; ++i)
+		{
+			orderValues[i] = prevOrder[i];
+			orderKeys[i] = keys[prevOrder[i]];
+		}
+
+		for (UINT i = (begin > 0 ? begin : 1); i < end; ++i)
+		{
+			localDescents += orderKeys[i - 1] > orderKeys[i] ? 1 : 0;
+		}
+
+		// The pair straddling the range boundary is read from the input, which is already final.
+		if (begin > 0 && keys[prevOrder[begin - 1]] > orderKeys[begin])
+		{
+			++localDescents;
+		}
+
+		descents += localDescents;
+	});
+
+	if (descents == 0)
+	{
+		mLastPath = SORT_REUSED;
+		return true;
+	}
+
+	if (descents > static_cast<UINT>(mCoherenceTolerance * count))
+	{
+		return false;
+	}
+
+	// Few descents usually means few, short moves.  Cap the work so a handful of keys
+	// that jumped across the whole range still fall back to the radix sort.
+	size_t moveBudget = static_cast<size_t>(count) * 4 + 64;
+	size_t moves = 0;
+
+	for (UINT i = 1; i < count; ++i)
+	{
+		UINT key = orderKeys[i];
+		if (orderKeys[i - 1] <= key)
+		{
+			continue;
+		}
+
+		UINT value = orderValues[i];
+		UINT j = i;
+
+		while (j > 0 && orderKeys[j - 1] > key)
+		{
+			orderKeys[j] = orderKeys[j - 1];
+			orderValues[j] = orderValues[j - 1];
+			--j;
+		}
+
+		orderKeys[j] = key;
+		orderValues[j] = value;
+
+		moves += i - j;
+		if (moves > moveBudget)
+		{
+			return false;
+		}
+	}
+
+	memcpy(&mPrevOrder[0], orderValues, count * sizeof(UINT));
+	mLastPath = SORT_REFINED;
+	return true;
+}
+
+void GRadixSort::RadixSort(const UINT* keys, UINT count)
+{
+	GThreadPool& pool = GThreadPool::Get();
+
+	UINT numChunks = count / MinKeysPerChunk;
+	if (numChunks > pool.GetThreadCount())
+	{
+		numChunks = pool.GetThreadCount();
+	}
+	if (numChunks == 0)
+	{
+		numChunks = 1;
+	}
+
+	UINT chunkSize = (count + numChunks - 1) / numChunks;
+
+	mHistograms.resize(numChunks * RadixBuckets);
+	UINT* histograms = &mHistograms[0];
+
+	int src = 0;
+
+	pool.Dispatch(numChunks, [&](UINT chunk)
+	{
+		UINT begin = chunk * chunkSize;
+		UINT end = begin + chunkSize < count ? begin + chunkSize : count;
+
+		for (UINT i = begin; i < end; ++i)
+		{
+			mKeys[0][i] = keys[i];
+			mValues[0][i] = i;
+		}
+	});
+
+	for (UINT pass = 0; pass < RadixPasses; ++pass)
+	{
+		UINT shift = pass * RadixBits;
+
+		const UINT* srcKeys = &mKeys[src][0];
+		const UINT* srcValues = &mValues[src][0];
+		UINT* dstKeys = &mKeys[1 - src][0];
+		UINT* dstValues = &mValues[1 - src][0];
+
+		// Each chunk counts its own digits so the scatter below stays stable.
+		pool.Dispatch(numChunks, [&](UINT chunk)
+		{
+			UINT* histogram = histograms + chunk * RadixBuckets;
+			memset(histogram, 0, RadixBuckets * sizeof(UINT));
+
+			UINT begin = chunk * chunkSize;
+			UINT end = begin + chunkSize < count ? begin + chunkSize : count;
+
+			for (UINT i = begin; i < end; ++i)
+			{
+				++histogram[(srcKeys[i] >> shift) & (RadixBuckets - 1)];
+			}
+		});
+
+		// Skip the pass when every key shares this digit; depth keys rarely use all 32 bits.
+		bool bSingleDigit = false;
+		for (UINT digit = 0; digit < RadixBuckets && !bSingleDigit; ++digit)
+		{
+			UINT total = 0;
+			for (UINT chunk = 0; chunk < numChunks; ++chunk)
+			{
+				total += histograms[chunk * RadixBuckets + digit];
+			}
+
+			bSingleDigit = (total == count);
+		}
+
+		if (bSingleDigit)
+		{
+			continue;
+		}
+
+		// Turn the counts into scatter offsets, digit-major then chunk-major.
+		UINT offset = 0;
+		for (UINT digit = 0; digit < RadixBuckets; ++digit)
+		{
+			for (UINT chunk = 0; chunk < numChunks; ++chunk)
+			{
+				UINT& slot = histograms[chunk * RadixBuckets + digit];
+				UINT digitCount = slot;
+				slot = offset;
+				offset += digitCount;
+			}
+		}
+
+		pool.Dispatch(numChunks, [&](UINT chunk)
+		{
+			UINT* offsets = histograms + chunk * RadixBuckets;
+
+			UINT begin = chunk * chunkSize;
+			UINT end = begin + chunkSize < count ? begin + chunkSize : count;
+
+			for (UINT i = begin; i < end; ++i)
+			{
+				UINT key = srcKeys[i];
+				UINT dst = offsets[(key >> shift) & (RadixBuckets - 1)]++;
+				dstKeys[dst] = key;
+				dstValues[dst] = srcValues[i];
+			}
+		});
+
+		src = 1 - src;
+	}
+
+	mPrevOrder.assign(mValues[src].begin(), mValues[src].begin() + count);
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+/*  ===============================================
+	Summary: Parallel LSD Radix Sort for Draw Order
+	===============================================  */
+
+#ifndef GRADIXSORT_H
+#define GRADIXSORT_H
+
+#include <Windows.h>
+#include <vector>
+
+class GRadixSort
+{
+public:
+	enum SortPath
+	{
+		SORT_NONE,        // Nothing to sort
+		SORT_REUSED,      // Previous order was still sorted
+		SORT_REFINED,     // Previous order was fixed up with an insertion sort
+		SORT_RADIX        // Full radix sort
+	};
+
+public:
+	GRadixSort();
+	~GRadixSort();
+
+	// Sorts keys in ascending order and writes the index of each key into outIndices.
+	// If count matches the previous call, the previous order is tried first and kept
+	// when it is still (nearly) sorted.
+	void Sort(const UINT* keys, UINT count, UINT* outIndices);
+
+	// Forgets the order from the previous call.
+	void Reset();
+
+	// Fraction of out-of-order neighbours that may be fixed up without a full sort.
+	void SetCoherenceTolerance(float fraction);
+
+	inline SortPath GetLastPath() const { return mLastPath; }
+
+	// Maps a float to a key with the same ordering under unsigned integer comparison.
+	static UINT FloatToKey(float f);
+
+	// Key that sorts larger view depths first, for drawing back to front.
+	static UINT BackToFrontKey(float viewDepth) { return ~FloatToKey(viewDepth); }
+
+private:
+	bool TryPreviousOrder(const UINT* keys, UINT count);
+	void RadixSort(const UINT* keys, UINT count);
+
+private:
+	std::vector<UINT> mKeys[2];
+	std::vector<UINT> mValues[2];
+	std::vector<UINT> mHistograms;
+
+	std::vector<UINT> mPrevOrder;
+
+	float mCoherenceTolerance;
+	SortPath mLastPath;
+};
+
+#endif // GRADIXSORT_H
\ No newline at end of file
@@ -0,0 +1,472 @@
+/*  ===============================================
+	Summary: On-Disk Shader Bytecode Cache
+	===============================================  */
+
+#include "GShaderCache.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <d3dcompiler.h>
+#pragma comment(lib, "d3dcompiler.lib")
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const uint32_t EntryMagic = 0x43485347; // "GSHC"
+
+	// Bump when the key or the entry layout changes, so old entries are ignored.
+	const uint32_t EntryVersion = 1;
+
+	// The D3DCOMPILE_ flags, spelled out so the cache builds without the Direct3D headers.
+	const uint32_t CompileDebug = 1 << 0;
+	const uint32_t CompileSkipOptimization = 1 << 2;
+	const uint32_t CompileEnableStrictness = 1 << 11;
+	const uint32_t CompileOptimizationLevel3 = 1 << 15;
+
+#if defined(_WIN32)
+	static_assert(CompileDebug == D3DCOMPILE_DEBUG && CompileSkipOptimization == D3DCOMPILE_SKIP_OPTIMIZATION &&
+		CompileEnableStrictness == D3DCOMPILE_ENABLE_STRICTNESS && CompileOptimizationLevel3 == D3DCOMPILE_OPTIMIZATION_LEVEL3,
+		"D3DCOMPILE_ flag values changed");
+#endif
+
+	struct EntryHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t Key;
+		uint64_t Size;
+
+		// Catches entries damaged on disk.
+		uint64_t BytecodeHash;
+	};
+
+	std::atomic<uint32_t> TempFileCounter(0);
+
+	FILE* OpenCacheFile(const std::wstring& filename, bool bWrite)
+	{
+#if defined(_WIN32)
+		FILE* file = nullptr;
+		return _wfopen_s(&file, filename.c_str(), bWrite ? L"wb" : L"rb") == 0 ? file : nullptr;
+#else
+		char path[4096];
+		size_t length = wcstombs(path, filename.c_str(), sizeof(path));
+		if (length == static_cast<size_t>(-1) || length >= sizeof(path))
+		{
+			return nullptr;
+		}
+		return fopen(path, bWrite ? "wb" : "rb");
+#endif
+	}
+
+#if !defined(_WIN32)
+	bool ToNarrow(const std::wstring& wide, std::string& narrow)
+	{
+		size_t length = wcstombs(nullptr, wide.c_str(), 0);
+		if (length == static_cast<size_t>(-1))
+		{
+			return false;
+		}
+
+		narrow.assign(length + 1, '\0');
+		wcstombs(&narrow[0], wide.c_str(), narrow.size());
+		narrow.resize(length);
+		return true;
+	}
+#endif
+
+	// Already existing counts as success.
+	void CreateDirectoryIfMissing(const std::wstring& directory)
+	{
+#if defined(_WIN32)
+		CreateDirectoryW(directory.c_str(), nullptr);
+#else
+		std::string path;
+		if (ToNarrow(directory, path))
+		{
+			mkdir(path.c_str(), 0755);
+		}
+#endif
+	}
+
+	bool MoveOverFile(const std::wstring& from, const std::wstring& to)
+	{
+#if defined(_WIN32)
+		return MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		std::string narrowFrom;
+		std::string narrowTo;
+		return ToNarrow(from, narrowFrom) && ToNarrow(to, narrowTo) && rename(narrowFrom.c_str(), narrowTo.c_str()) == 0;
+#endif
+	}
+
+	void RemoveFile(const std::wstring& filename)
+	{
+#if defined(_WIN32)
+		DeleteFileW(filename.c_str());
+#else
+		std::string path;
+		if (ToNarrow(filename, path))
+		{
+			unlink(path.c_str());
+		}
+#endif
+	}
+
+	uint32_t CurrentProcessId()
+	{
+#if defined(_WIN32)
+		return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+		return static_cast<uint32_t>(getpid());
+#endif
+	}
+
+	// Folder part of a path, including the trailing separator; empty for a bare file name.
+	std::wstring GetFolder(const std::wstring& filename)
+	{
+		size_t slash = filename.find_last_of(L"/\\");
+		return slash == std::wstring::npos ? std::wstring() : filename.substr(0, slash + 1);
+	}
+
+	// Names in #include "name" and #include <name> directives, in order.  Directives inside
+	// comments or inactive #if blocks are picked up too, which at worst makes the key cover a
+	// file the shader does not use.
+	void ScanIncludes(const std::vector<uint8_t>& source, std::vector<std::string>& names)
+	{
+		const char* p = reinterpret_cast<const char*>(source.data());
+		const char* end = p + source.size();
+
+		while (p < end)
+		{
+			const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+			if (!lineEnd)
+			{
+				lineEnd = end;
+			}
+
+			while (p < lineEnd && (*p == ' ' || *p == '\t'))
+			{
+				++p;
+			}
+
+			if (p < lineEnd && *p == '#')
+			{
+				++p;
+				while (p < lineEnd && (*p == ' ' || *p == '\t'))
+				{
+					++p;
+				}
+
+				const size_t keywordLength = 7;
+				if (lineEnd - p > static_cast<ptrdiff_t>(keywordLength) && strncmp(p, "include", keywordLength) == 0)
+				{
+					p += keywordLength;
+					while (p < lineEnd && (*p == ' ' || *p == '\t'))
+					{
+						++p;
+					}
+
+					if (p < lineEnd && (*p == '"' || *p == '<'))
+					{
+						char close = (*p == '"') ? '"' : '>';
+						const char* nameEnd = static_cast<const char*>(memchr(p + 1, close, lineEnd - p - 1));
+						if (nameEnd)
+						{
+							names.push_back(std::string(p + 1, nameEnd));
+						}
+					}
+				}
+			}
+
+			p = (lineEnd < end) ? lineEnd + 1 : end;
+		}
+	}
+
+#if defined(_WIN32)
+	bool CompileWithD3D(const wchar_t* filename, const char* entryPoint, const char* target, uint32_t flags,
+		std::vector<uint8_t>& bytecode, std::string& errors)
+	{
+		ID3DBlob* code = nullptr;
+		ID3DBlob* messages = nullptr;
+
+		HRESULT hr = D3DCompileFromFile(filename, nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE, entryPoint, target, flags, 0, &code, &messages);
+
+		if (messages)
+		{
+			errors.assign(static_cast<const char*>(messages->GetBufferPointer()), messages->GetBufferSize());
+			messages->Release();
+		}
+
+		if (FAILED(hr) || !code)
+		{
+			if (code)
+			{
+				code->Release();
+			}
+			return false;
+		}
+
+		const uint8_t* data = static_cast<const uint8_t*>(code->GetBufferPointer());
+		bytecode.assign(data, data + code->GetBufferSize());
+		code->Release();
+
+		return true;
+	}
+#endif
+}
+
+const uint32_t GShaderCache::DebugFlags = CompileDebug | CompileSkipOptimization | CompileEnableStrictness;
+const uint32_t GShaderCache::ReleaseFlags = CompileOptimizationLevel3 | CompileEnableStrictness;
+
+uint32_t GShaderCache::GetDefaultFlags()
+{
+#if defined(_DEBUG)
+	return DebugFlags;
+#else
+	return ReleaseFlags;
+#endif
+}
+
+GShaderCache::GShaderCache() :
+	mDirectory(L"ShaderCache"),
+	mHitCount(0),
+	mMissCount(0)
+{
+#if defined(_WIN32)
+	mCompile = CompileWithD3D;
+#endif
+}
+
+GShaderCache::~GShaderCache()
+{
+}
+
+GShaderCache& GShaderCache::Get()
+{
+	static GShaderCache cache;
+	return cache;
+}
+
+uint64_t GShaderCache::Hash(const void* data, size_t size, uint64_t hash)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+bool GShaderCache::GatherDependencies(const std::wstring& filename, std::vector<std::wstring>& files)
+{
+	std::vector<uint8_t> source;
+	if (!ReadFile(filename, source))
+	{
+		return false;
+	}
+
+	files.push_back(filename);
+
+	std::vector<std::string> names;
+	ScanIncludes(source, names);
+
+	std::wstring folder = GetFolder(filename);
+
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		std::wstring include = folder + std::wstring(names[i].begin(), names[i].end());
+
+		bool bSeen = false;
+		for (size_t j = 0; j < files.size() && !bSeen; ++j)
+		{
+			bSeen = files[j] == include;
+		}
+
+		// An include that cannot be read may sit in an inactive #if block; if not, the compiler
+		// reports it.
+		if (!bSeen)
+		{
+			GatherDependencies(include, files);
+		}
+	}
+
+	return true;
+}
+
+bool GShaderCache::MakeKey(const wchar_t* filename, const char* entryPoint, const char* target, uint32_t flags, uint64_t& key)
+{
+	std::vector<std::wstring> files;
+	if (!GatherDependencies(filename, files))
+	{
+		return false;
+	}
+
+	uint64_t hash = Hash(&EntryVersion, sizeof(EntryVersion));
+
+	// Names and contents both count: the same text included under another name is another shader.
+	std::vector<uint8_t> contents;
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		ReadFile(files[i], contents);
+
+		uint64_t size = contents.size();
+		hash = Hash(files[i].c_str(), files[i].size() * sizeof(wchar_t), hash);
+		hash = Hash(&size, sizeof(size), hash);
+		hash = Hash(contents.data(), contents.size(), hash);
+	}
+
+	// Lengths are hashed with the strings so "VS", "ps_5_0" cannot collide with "VSp", "s_5_0".
+	uint64_t entryLength = strlen(entryPoint);
+	uint64_t targetLength = strlen(target);
+	hash = Hash(&entryLength, sizeof(entryLength), hash);
+	hash = Hash(entryPoint, entryLength, hash);
+	hash = Hash(&targetLength, sizeof(targetLength), hash);
+	hash = Hash(target, targetLength, hash);
+	hash = Hash(&flags, sizeof(flags), hash);
+
+	key = hash;
+	return true;
+}
+
+bool GShaderCache::Load(const wchar_t* filename, const char* entryPoint, const char* target, uint32_t flags,
+	std::vector<uint8_t>& bytecode, std::string* errors)
+{
+	uint64_t key = 0;
+	if (!MakeKey(filename, entryPoint, target, flags, key))
+	{
+		if (errors)
+		{
+			*errors = "Cannot read shader source.";
+		}
+		return false;
+	}
+
+	std::wstring path = GetEntryPath(key);
+
+	std::vector<uint8_t> entry;
+	if (ReadFile(path, entry) && entry.size() >= sizeof(EntryHeader))
+	{
+		EntryHeader header;
+		memcpy(&header, entry.data(), sizeof(header));
+
+		const uint8_t* code = entry.data() + sizeof(header);
+		if (header.Magic == EntryMagic && header.Version == EntryVersion && header.Key == key &&
+			header.Size == entry.size() - sizeof(header) && header.BytecodeHash == Hash(code, static_cast<size_t>(header.Size)))
+		{
+			bytecode.assign(code, code + header.Size);
+			++mHitCount;
+			return true;
+		}
+	}
+
+	++mMissCount;
+
+	std::string messages;
+	if (!mCompile || !mCompile(filename, entryPoint, target, flags, bytecode, messages))
+	{
+		if (errors)
+		{
+			*errors = mCompile ? messages : "No shader compiler set.";
+		}
+		return false;
+	}
+
+	if (errors)
+	{
+		*errors = messages;
+	}
+
+	EntryHeader header;
+	header.Magic = EntryMagic;
+	header.Version = EntryVersion;
+	header.Key = key;
+	header.Size = bytecode.size();
+	header.BytecodeHash = Hash(bytecode.data(), bytecode.size());
+
+	entry.resize(sizeof(header) + bytecode.size());
+	memcpy(entry.data(), &header, sizeof(header));
+	if (!bytecode.empty())
+	{
+		memcpy(entry.data() + sizeof(header), bytecode.data(), bytecode.size());
+	}
+
+	// A failed store only costs a compile next run.
+	CreateDirectoryIfMissing(mDirectory);
+	WriteFileAtomic(path, entry.data(), entry.size());
+
+	return true;
+}
+
+std::wstring GShaderCache::GetEntryPath(uint64_t key) const
+{
+	wchar_t name[32];
+	swprintf(name, sizeof(name) / sizeof(name[0]), L"%016llx.cso", static_cast<unsigned long long>(key));
+
+	if (mDirectory.empty())
+	{
+		return name;
+	}
+
+	wchar_t last = mDirectory[mDirectory.size() - 1];
+	return (last == L'/' || last == L'\\') ? mDirectory + name : mDirectory + L"/" + name;
+}
+
+bool GShaderCache::ReadFile(const std::wstring& path, std::vector<uint8_t>& data)
+{
+	data.clear();
+
+	FILE* file = OpenCacheFile(path, false);
+	if (!file)
+	{
+		return false;
+	}
+
+	uint8_t buffer[4096];
+	size_t count = 0;
+	while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + count);
+	}
+
+	bool bOk = ferror(file) == 0;
+	fclose(file);
+
+	return bOk;
+}
+
+bool GShaderCache::WriteFileAtomic(const std::wstring& path, const void* data, size_t size)
+{
+	// The process id and a counter keep writers of the same entry, in this process or another, apart.
+	wchar_t suffix[48];
+	swprintf(suffix, sizeof(suffix) / sizeof(suffix[0]), L".%u.%u.tmp", CurrentProcessId(), static_cast<uint32_t>(TempFileCounter++));
+	std::wstring tempPath = path + suffix;
+
+	FILE* file = OpenCacheFile(tempPath, true);
+	if (!file)
+	{
+		return false;
+	}
+
+	bool bOk = size == 0 || fwrite(data, 1, size, file) == size;
+	bOk = fclose(file) == 0 && bOk;
+
+	// Whoever renames last wins; both wrote the same bytes.
+	if (!bOk || !MoveOverFile(tempPath, path))
+	{
+		RemoveFile(tempPath);
+		return false;
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+/*  ===============================================
+	Summary: On-Disk Shader Bytecode Cache
+	===============================================  */
+
+#ifndef GSHADERCACHE_H
+#define GSHADERCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Keeps compiled shader bytecode on disk between runs.  An entry is keyed by a hash of the source
+// file, every file it pulls in through #include, the entry point, the target profile and the
+// compile flags, so editing LightHelper.hlsl recompiles the shaders that use it and debug and
+// release flags keep separate entries.  Entries are written to a temporary file and renamed into
+// place, so a crash or a second process never leaves a partial entry behind.  The compiler is passed
+// in; only the default one needs Direct3D, so the rest runs headless.
+class GShaderCache
+{
+public:
+	// Compiles a shader into bytecode.  On failure writes the compiler's messages to errors.
+	typedef std::function<bool(const wchar_t* filename, const char* entryPoint, const char* target, uint32_t flags,
+		std::vector<uint8_t>& bytecode, std::string& errors)> CompileFunc;
+
+	// The D3DCOMPILE_ flag sets used for debug and release builds, and the one for this build.
+	static const uint32_t DebugFlags;
+	static const uint32_t ReleaseFlags;
+	static uint32_t GetDefaultFlags();
+
+	GShaderCache();
+	~GShaderCache();
+
+	// Process-wide cache shared by the demos.
+	static GShaderCache& Get();
+
+	// Where entries are stored; created on the first store.
+	inline void SetDirectory(const std::wstring& directory) { mDirectory = directory; }
+	inline const std::wstring& GetDirectory() const { return mDirectory; }
+
+	// Outside of Windows there is no default compiler, so misses fail until one is set.
+	inline void SetCompiler(const CompileFunc& compile) { mCompile = compile; }
+
+	// 64-bit FNV-1a, continued from hash.
+	static uint64_t Hash(const void* data, size_t size, uint64_t hash = 14695981039346656037ULL);
+
+	// Appends filename and every file it includes, directly or not, each once.  Includes are
+	// resolved against the including file's folder, as D3D_COMPILE_STANDARD_FILE_INCLUDE does.
+	// Returns false if filename itself cannot be read; a missing include is left to the compiler.
+	static bool GatherDependencies(const std::wstring& filename, std::vector<std::wstring>& files);
+
+	// Key for compiling filename with these options.  Returns false if filename cannot be read.
+	static bool MakeKey(const wchar_t* filename, const char* entryPoint, const char* target, uint32_t flags, uint64_t& key);
+
+	// Loads the bytecode from disk, or compiles and stores it on a miss.  Safe to call from
+	// several threads at once.
+	bool Load(const wchar_t* filename, const char* entryPoint, const char* target, uint32_t flags,
+		std::vector<uint8_t>& bytecode, std::string* errors = nullptr);
+
+	std::wstring GetEntryPath(uint64_t key) const;
+
+	static bool ReadFile(const std::wstring& path, std::vector<uint8_t>& data);
+
+	// Writes to a uniquely named temporary file next to path, then renames it over path.
+	static bool WriteFileAtomic(const std::wstring& path, const void* data, size_t size);
+
+	inline uint32_t GetHitCount() const { return mHitCount; }
+	inline uint32_t GetMissCount() const { return mMissCount; }
+
+private:
+	GShaderCache(const GShaderCache&);
+	GShaderCache& operator=(const GShaderCache&);
+
+private:
+	std::wstring mDirectory;
+	CompileFunc mCompile;
+
+	std::atomic<uint32_t> mHitCount;
+	std::atomic<uint32_t> mMissCount;
+};
+
+#endif // GSHADERCACHE_H
\ No newline at end of file
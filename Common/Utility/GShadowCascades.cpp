@@ -0,0 +1,195 @@
+/*  ===============================================
+	Summary: Cascaded Shadow Map Fitting
+	===============================================  */
+
+#include "GShadowCascades.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT DefaultResolution = 2048;
+	const float DefaultSplitLambda = 0.75f;
+
+	// Stabilized radii are rounded up to this step so float noise cannot change the texel size.
+	const float RadiusStep = 1.0f / 16.0f;
+
+	// NDC [-1, 1] to texture space [0, 1], y flipped.
+	const XMFLOAT4X4 NDCToTexture(
+		0.5f, 0.0f, 0.0f, 0.0f,
+		0.0f, -0.5f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.5f, 0.5f, 0.0f, 1.0f);
+}
+
+const UINT GShadowCascades::MaxCascades;
+
+void GShadowCascades::ComputeSplits(float nearZ, float farZ, UINT numCascades, float lambda, float* splits)
+{
+	splits[0] = nearZ;
+
+	for (UINT i = 1; i < numCascades; ++i)
+	{
+		float f = static_cast<float>(i) / numCascades;
+		float logSplit = nearZ * powf(farZ / nearZ, f);
+		float uniformSplit = nearZ + (farZ - nearZ) * f;
+		splits[i] = lambda * logSplit + (1.0f - lambda) * uniformSplit;
+	}
+
+	splits[numCascades] = farZ;
+}
+
+GShadowCascades::GShadowCascades() :
+	mCascadeCount(MaxCascades),
+	mResolution(DefaultResolution),
+	mSplitLambda(DefaultSplitLambda),
+	mShadowDistance(FLT_MAX),
+	bStabilizeCascades(true)
+{
+	XMMATRIX I = XMMatrixIdentity();
+	for (UINT i = 0; i < MaxCascades; ++i)
+	{
+		XMStoreFloat4x4(&mCascades[i].View, I);
+		XMStoreFloat4x4(&mCascades[i].Proj, I);
+		XMStoreFloat4x4(&mCascades[i].ShadowTransform, I);
+		mCascades[i].SplitNear = 0.0f;
+		mCascades[i].SplitFar = 0.0f;
+	}
+}
+
+GShadowCascades::~GShadowCascades()
+{
+}
+
+void GShadowCascades::SetCascadeCount(UINT count)
+{
+	mCascadeCount = (std::min)((std::max)(count, 1u), MaxCascades);
+}
+
+void GShadowCascades::SetResolution(UINT size)
+{
+	mResolution = (std::max)(size, 1u);
+}
+
+void GShadowCascades::Update(const XMFLOAT4X4& cameraView, float fovY, float aspect, float nearZ, float farZ,
+	const XMFLOAT3& lightDir, const BoundingBox* casters, UINT casterCount)
+{
+	float splits[MaxCascades + 1];
+	ComputeSplits(nearZ, (std::min)(farZ, mShadowDistance), mCascadeCount, mSplitLambda, splits);
+
+	XMMATRIX invView = XMMatrixInverse(nullptr, XMLoadFloat4x4(&cameraView));
+
+	// The light looks down its direction from the origin; the projection does the framing.
+	XMVECTOR dir = XMVector3Normalize(XMLoadFloat3(&lightDir));
+	XMVECTOR up = fabsf(XMVectorGetY(dir)) > 0.99f ? XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+	XMMATRIX V = XMMatrixLookToLH(XMVectorZero(), dir, up);
+
+	// Light-space bounds of every caster, shared by all cascades.
+	mLightCasters.resize(casterCount);
+	mCasterMasks.assign(casterCount, 0);
+	for (UINT i = 0; i < casterCount; ++i)
+	{
+		casters[i].Transform(mLightCasters[i], V);
+	}
+
+	float tanY = tanf(0.5f * fovY);
+	float tanX = tanY * aspect;
+
+	for (UINT c = 0; c < mCascadeCount; ++c)
+	{
+		Cascade& cascade = mCascades[c];
+		cascade.SplitNear = splits[c];
+		cascade.SplitFar = splits[c + 1];
+
+		// Corners of the frustum slice in world space.
+		XMVECTOR corners[8];
+		for (UINT i = 0; i < 8; ++i)
+		{
+			float z = (i & 4) ? cascade.SplitFar : cascade.SplitNear;
+			float x = (i & 1) ? z * tanX : -z * tanX;
+			float y = (i & 2) ? z * tanY : -z * tanY;
+			corners[i] = XMVector3TransformCoord(XMVectorSet(x, y, z, 1.0f), invView);
+		}
+
+		XMFLOAT3 minP;
+		XMFLOAT3 maxP;
+		float depthStep = 0.0f;
+
+		if (bStabilizeCascades)
+		{
+			// The bounding sphere of the slice keeps its size however the camera turns.
+			XMVECTOR center = XMVectorZero();
+			for (UINT i = 0; i < 8; ++i)
+			{
+				center = XMVectorAdd(center, corners[i]);
+			}
+			center = XMVectorScale(center, 1.0f / 8.0f);
+
+			float radius = 0.0f;
+			for (UINT i = 0; i < 8; ++i)
+			{
+				radius = (std::max)(radius, XMVectorGetX(XMVector3Length(XMVectorSubtract(corners[i], center))));
+			}
+			radius = (std::max)(ceilf(radius / RadiusStep), 1.0f) * RadiusStep;
+
+			// Move the window in whole texels, so texels map to the same world positions every frame.
+			XMFLOAT3 c;
+			XMStoreFloat3(&c, XMVector3TransformCoord(center, V));
+
+			float texelSize = 2.0f * radius / mResolution;
+			c.x = floorf(c.x / texelSize) * texelSize;
+			c.y = floorf(c.y / texelSize) * texelSize;
+
+			// Depths only need to cover the sphere, so round the range out to whole radii.
+			minP = XMFLOAT3(c.x - radius, c.y - radius, floorf(c.z / radius) * radius - radius);
+			maxP = XMFLOAT3(c.x + radius, c.y + radius, ceilf(c.z / radius) * radius + radius);
+			depthStep = radius;
+		}
+		else
+		{
+			XMVECTOR vMin = XMVectorReplicate(FLT_MAX);
+			XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+			for (UINT i = 0; i < 8; ++i)
+			{
+				XMVECTOR p = XMVector3TransformCoord(corners[i], V);
+				vMin = XMVectorMin(vMin, p);
+				vMax = XMVectorMax(vMax, p);
+			}
+			XMStoreFloat3(&minP, vMin);
+			XMStoreFloat3(&maxP, vMax);
+		}
+
+		// Start the depth range at the nearest caster over the cascade, so casters between the
+		// light and the slice still shadow it.  Casters wholly behind the slice cannot.
+		float nearest = FLT_MAX;
+		for (UINT i = 0; i < casterCount; ++i)
+		{
+			const BoundingBox& box = mLightCasters[i];
+			XMFLOAT3 boxMin(box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z);
+			XMFLOAT3 boxMax(box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z);
+
+			if (boxMax.x < minP.x || boxMin.x > maxP.x || boxMax.y < minP.y || boxMin.y > maxP.y || boxMin.z >= maxP.z)
+			{
+				continue;
+			}
+
+			nearest = (std::min)(nearest, boxMin.z);
+			mCasterMasks[i] |= 1u << c;
+		}
+
+		if (nearest != FLT_MAX)
+		{
+			minP.z = depthStep > 0.0f ? floorf(nearest / depthStep) * depthStep : nearest;
+		}
+
+		XMMATRIX P = XMMatrixOrthographicOffCenterLH(minP.x, maxP.x, minP.y, maxP.y, minP.z, maxP.z);
+
+		XMStoreFloat4x4(&cascade.View, V);
+		XMStoreFloat4x4(&cascade.Proj, P);
+		XMStoreFloat4x4(&cascade.ShadowTransform, V * P * XMLoadFloat4x4(&NDCToTexture));
+	}
+}
\ No newline at end of file
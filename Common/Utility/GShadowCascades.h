@@ -0,0 +1,84 @@
+/*  ===============================================
+	Summary: Cascaded Shadow Map Fitting
+	===============================================  */
+
+#ifndef GSHADOWCASCADES_H
+#define GSHADOWCASCADES_H
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <vector>
+
+// Splits the camera frustum into depth slices and fits a directional light's orthographic
+// projection to each one.  With stabilization on, every cascade covers the bounding sphere of its
+// slice and is snapped to whole shadow map texels, so the shadows do not shimmer as the camera
+// turns or moves, and the depth range is rounded to whole radii, so a cascade's matrices stay
+// exactly the same until the camera or a caster moves far enough to matter; off, the cascade is the
+// tight light-space box of the slice.  Either way the depth range starts at the nearest caster that
+// can throw a shadow into the cascade.
+class GShadowCascades
+{
+public:
+	static const UINT MaxCascades = 4;
+
+	struct Cascade
+	{
+		DirectX::XMFLOAT4X4 View;
+		DirectX::XMFLOAT4X4 Proj;
+
+		// World space to shadow map texture coordinates and depth: View * Proj * NDC-to-texture.
+		DirectX::XMFLOAT4X4 ShadowTransform;
+
+		// The camera view depths the cascade covers.
+		float SplitNear;
+		float SplitFar;
+	};
+
+	// The practical split scheme: each split blends the logarithmic split, weighted by lambda,
+	// with the uniform one.  Writes numCascades + 1 depths, from nearZ to farZ.
+	static void ComputeSplits(float nearZ, float farZ, UINT numCascades, float lambda, float* splits);
+
+	GShadowCascades();
+	~GShadowCascades();
+
+	void SetCascadeCount(UINT count);
+	void SetResolution(UINT size);
+	inline void SetSplitLambda(float lambda) { mSplitLambda = lambda; }
+	inline void SetStabilize(bool bStabilize) { bStabilizeCascades = bStabilize; }
+
+	// Shadows are only cast up to this distance from the camera, even if its far plane is further.
+	inline void SetShadowDistance(float distance) { mShadowDistance = distance; }
+
+	// Fits the cascades to a perspective camera.  lightDir points from the light into the scene;
+	// casters are the world-space bounds of everything that casts a shadow.
+	void Update(const DirectX::XMFLOAT4X4& cameraView, float fovY, float aspect, float nearZ, float farZ,
+		const DirectX::XMFLOAT3& lightDir, const DirectX::BoundingBox* casters, UINT casterCount);
+
+	inline UINT GetCascadeCount() const { return mCascadeCount; }
+	inline const Cascade& GetCascade(UINT index) const { return mCascades[index]; }
+
+	// Whether a caster passed to the last Update can throw a shadow into a cascade: it overlaps the
+	// cascade's light-space rectangle and is not wholly behind it.
+	inline bool CastsInto(UINT cascade, UINT caster) const { return (mCasterMasks[caster] & (1u << cascade)) != 0; }
+
+private:
+	GShadowCascades(const GShadowCascades&);
+	GShadowCascades& operator=(const GShadowCascades&);
+
+private:
+	UINT mCascadeCount;
+	UINT mResolution;
+	float mSplitLambda;
+	float mShadowDistance;
+	bool bStabilizeCascades;
+
+	Cascade mCascades[MaxCascades];
+
+	std::vector<DirectX::BoundingBox> mLightCasters;
+
+	// Per caster, a bit for each cascade it casts into.
+	std::vector<UINT> mCasterMasks;
+};
+
+#endif // GSHADOWCASCADES_H
\ No newline at end of file
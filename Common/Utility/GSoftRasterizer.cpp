@@ -0,0 +1,686 @@
+/*  ===============================================
+	Summary: Tile-Binning Software Rasterizer
+	===============================================  */
+
+#include "GSoftRasterizer.h"
+#include "GThreadPool.h"
+#include "MathHelper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <emmintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT VerticesPerRange = 1024;
+	const UINT TrianglesPerRange = 1024;
+
+	// Vertices are snapped to 1/16 of a pixel, like the hardware's subpixel grid.
+	const float SubpixelScale = 16.0f;
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	inline float GetMilliseconds(Clock::time_point start)
+	{
+		return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+	}
+
+	inline uint32_t ToUNORM8(float x)
+	{
+		x = (std::min)((std::max)(x, 0.0f), 1.0f);
+		return static_cast<uint32_t>(x * 255.0f + 0.5f);
+	}
+
+	// Byte order R, G, B, A in memory.
+	inline uint32_t PackColor(float r, float g, float b, float a)
+	{
+		return ToUNORM8(r) | (ToUNORM8(g) << 8) | (ToUNORM8(b) << 16) | (ToUNORM8(a) << 24);
+	}
+
+	inline float Snap(float x)
+	{
+		return floorf(x * SubpixelScale + 0.5f) / SubpixelScale;
+	}
+
+	inline int WrapTexel(int x, int size)
+	{
+		x %= size;
+		return x < 0 ? x + size : x;
+	}
+
+	inline int ClampTexel(int x, int size)
+	{
+		return (std::min)((std::max)(x, 0), size - 1);
+	}
+}
+
+void GSoftRasterizer::Texture::Create(const uint8_t* rgba, UINT width, UINT height, UINT rowPitch)
+{
+	GMipGenerator::GenerateChain(GMipGenerator::FORMAT_R8G8B8A8, GMipGenerator::FILTER_BOX, rgba, width, height, rowPitch, mLevels);
+}
+
+void GSoftRasterizer::Texture::SampleLevel(UINT level, float u, float v, AddressMode address, float color[4]) const
+{
+	const GMipGenerator::Level& mip = mLevels[level];
+	int width = static_cast<int>(mip.Width);
+	int height = static_cast<int>(mip.Height);
+
+	// Texel centers sit at half-integer coordinates.
+	float x = u * width - 0.5f;
+	float y = v * height - 0.5f;
+	float fx = floorf(x);
+	float fy = floorf(y);
+	float s = x - fx;
+	float t = y - fy;
+
+	int x0 = static_cast<int>(fx);
+	int y0 = static_cast<int>(fy);
+	int x1, y1;
+
+	if (address == ADDRESS_WRAP)
+	{
+		x1 = WrapTexel(x0 + 1, width);
+		y1 = WrapTexel(y0 + 1, height);
+		x0 = WrapTexel(x0, width);
+		y0 = WrapTexel(y0, height);
+	}
+	else
+	{
+		x1 = ClampTexel(x0 + 1, width);
+		y1 = ClampTexel(y0 + 1, height);
+		x0 = ClampTexel(x0, width);
+		y0 = ClampTexel(y0, height);
+	}
+
+	const uint8_t* row0 = &mip.Data[static_cast<size_t>(y0) * mip.RowPitch];
+	const uint8_t* row1 = &mip.Data[static_cast<size_t>(y1) * mip.RowPitch];
+
+	for (int c = 0; c < 4; ++c)
+	{
+		float a = row0[4*x0 + c] + s * (row0[4*x1 + c] - row0[4*x0 + c]);
+		float b = row1[4*x0 + c] + s * (row1[4*x1 + c] - row1[4*x0 + c]);
+		color[c] = (a + t * (b - a)) * (1.0f / 255.0f);
+	}
+}
+
+void GSoftRasterizer::Texture::Sample(float u, float v, float lod, AddressMode address, float color[4]) const
+{
+	UINT lastLevel = static_cast<UINT>(mLevels.size()) - 1;
+	lod = (std::min)((std::max)(lod, 0.0f), static_cast<float>(lastLevel));
+
+	UINT level = static_cast<UINT>(lod);
+	float t = lod - level;
+
+	SampleLevel(level, u, v, address, color);
+
+	if (t > 0.0f && level < lastLevel)
+	{
+		float next[4];
+		SampleLevel(level + 1, u, v, address, next);
+
+		for (int c = 0; c < 4; ++c)
+		{
+			color[c] += t * (next[c] - color[c]);
+		}
+	}
+}
+
+GSoftRasterizer::GSoftRasterizer() :
+	mWidth(0),
+	mHeight(0),
+	mTilesX(0),
+	mTilesY(0),
+	mDepthPitch(0),
+	mClearColor(0),
+	mEyePosW(0.0f, 0.0f, 0.0f),
+	mLightCount(0),
+	mDrawTime(0.0f),
+	mResolveTime(0.0f)
+{
+	XMStoreFloat4x4(&mViewProj, XMMatrixIdentity());
+}
+
+GSoftRasterizer::~GSoftRasterizer()
+{
+}
+
+void GSoftRasterizer::Resize(UINT width, UINT height)
+{
+	mWidth = width;
+	mHeight = height;
+	mTilesX = (width + TileSize - 1) / TileSize;
+	mTilesY = (height + TileSize - 1) / TileSize;
+
+	mDepthPitch = (width + 3) & ~3u;
+	mDepthBuffer.assign(static_cast<size_t>(mDepthPitch) * height, 1.0f);
+	mColorBuffer.assign(static_cast<size_t>(width) * height, 0);
+
+	mBins.resize(mTilesX * mTilesY);
+	for (size_t i = 0; i < mBins.size(); ++i)
+	{
+		mBins[i].clear();
+	}
+
+	mDraws.clear();
+	mTriangles.clear();
+}
+
+void GSoftRasterizer::Clear(const float color[4])
+{
+	mClearColor = PackColor(color[0], color[1], color[2], color[3]);
+
+	mDraws.clear();
+	mTriangles.clear();
+
+	for (size_t i = 0; i < mBins.size(); ++i)
+	{
+		mBins[i].clear();
+	}
+
+	mDrawTime = 0.0f;
+}
+
+void GSoftRasterizer::SetViewProj(CXMMATRIX viewProj)
+{
+	XMStoreFloat4x4(&mViewProj, viewProj);
+}
+
+void GSoftRasterizer::SetEyePosW(const XMFLOAT3& eyePosW)
+{
+	mEyePosW = eyePosW;
+}
+
+void GSoftRasterizer::SetLights(const DirectionalLight* lights, UINT count)
+{
+	mLightCount = (std::min)(count, MaxLights);
+
+	for (UINT i = 0; i < mLightCount; ++i)
+	{
+		mLights[i] = lights[i];
+	}
+}
+
+void GSoftRasterizer::Draw(const DrawCall& draw)
+{
+	Clock::time_point start = Clock::now();
+
+	UINT drawIndex = static_cast<UINT>(mDraws.size());
+
+	DrawState state;
+	state.Mat = draw.Mat;
+	state.DiffuseMap = draw.DiffuseMap;
+	state.Address = draw.Address;
+	mDraws.push_back(state);
+
+	// Vertex stage.
+	XMMATRIX world = XMLoadFloat4x4(&draw.World);
+	XMMATRIX worldInvTranspose = MathHelper::InverseTranspose(world);
+	XMMATRIX worldViewProj = world * XMLoadFloat4x4(&mViewProj);
+	XMMATRIX texTransform = XMLoadFloat4x4(&draw.TexTransform);
+
+	mClipVertices.resize(draw.VertexCount);
+
+	GThreadPool::Get().ParallelFor(draw.VertexCount, VerticesPerRange, [&](UINT begin, UINT end)
+	{
+		for (UINT i = begin; i < end; ++i)
+		{
+			const Vertex& vin = draw.Vertices[i];
+			ClipVertex& vout = mClipVertices[i];
+
+			XMVECTOR pos = XMVectorSetW(XMLoadFloat3(&vin.Pos), 1.0f);
+
+			XMStoreFloat4(&vout.PosH, XMVector4Transform(pos, worldViewProj));
+			XMStoreFloat3(&vout.PosW, XMVector3TransformCoord(pos, world));
+			XMStoreFloat3(&vout.NormalW, XMVector3TransformNormal(XMLoadFloat3(&vin.Normal), worldInvTranspose));
+
+			XMVECTOR tex = XMVectorSet(vin.Tex.x, vin.Tex.y, 0.0f, 1.0f);
+			XMStoreFloat2(&vout.Tex, XMVector4Transform(tex, texTransform));
+		}
+	});
+
+	// Clip, cull and set up the triangles in ranges, each range writing its own list so the
+	// triangles can be appended in submission order afterwards.
+	UINT numTriangles = draw.IndexCount / 3;
+	UINT numRanges = (numTriangles + TrianglesPerRange - 1) / TrianglesPerRange;
+
+	if (mRangeTriangles.size() < numRanges)
+	{
+		mRangeTriangles.resize(numRanges);
+	}
+
+	GThreadPool::Get().Dispatch(numRanges, [&](UINT range)
+	{
+		std::vector<Triangle>& out = mRangeTriangles[range];
+		out.clear();
+
+		UINT begin = range * TrianglesPerRange;
+		UINT end = (std::min)(begin + TrianglesPerRange, numTriangles);
+
+		for (UINT i = begin; i < end; ++i)
+		{
+			const UINT* indices = draw.Indices + 3 * i;
+			ClipTriangle(mClipVertices[indices[0]], mClipVertices[indices[1]], mClipVertices[indices[2]],
+				draw.bCullBack, drawIndex, out);
+		}
+	});
+
+	// Bin into every tile the bounds overlap.
+	for (UINT range = 0; range < numRanges; ++range)
+	{
+		const std::vector<Triangle>& triangles = mRangeTriangles[range];
+
+		for (size_t i = 0; i < triangles.size(); ++i)
+		{
+			const Triangle& tri = triangles[i];
+			UINT index = static_cast<UINT>(mTriangles.size());
+			mTriangles.push_back(tri);
+
+			UINT tileX0 = tri.MinX / TileSize;
+			UINT tileX1 = tri.MaxX / TileSize;
+			UINT tileY0 = tri.MinY / TileSize;
+			UINT tileY1 = tri.MaxY / TileSize;
+
+			for (UINT ty = tileY0; ty <= tileY1; ++ty)
+			{
+				for (UINT tx = tileX0; tx <= tileX1; ++tx)
+				{
+					mBins[ty * mTilesX + tx].push_back(index);
+				}
+			}
+		}
+	}
+
+	mDrawTime += GetMilliseconds(start);
+}
+
+void GSoftRasterizer::ClipTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, bool bCullBack,
+	UINT drawIndex, std::vector<Triangle>& out) const
+{
+	const ClipVertex* in[3] = { &v0, &v1, &v2 };
+
+	// Reject triangles entirely outside one of the frustum planes.
+	UINT outside = 0x3F;
+	UINT behindNear = 0;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const XMFLOAT4& p = in[i]->PosH;
+		UINT code = 0;
+		code |= (p.x < -p.w) ? 0x01 : 0;
+		code |= (p.x > p.w) ? 0x02 : 0;
+		code |= (p.y < -p.w) ? 0x04 : 0;
+		code |= (p.y > p.w) ? 0x08 : 0;
+		code |= (p.z < 0.0f) ? 0x10 : 0;
+		code |= (p.z > p.w) ? 0x20 : 0;
+
+		outside &= code;
+		behindNear += (p.z < 0.0f) ? 1 : 0;
+	}
+
+	if (outside)
+	{
+		return;
+	}
+
+	if (behindNear == 0)
+	{
+		SetupTriangle(v0, v1, v2, bCullBack, drawIndex, out);
+		return;
+	}
+
+	// Only the near plane is clipped, since w must stay positive for the divide.  The other
+	// planes are handled by clamping the bounds to the screen.
+	ClipVertex poly[4];
+	UINT count = 0;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const ClipVertex& a = *in[i];
+		const ClipVertex& b = *in[(i + 1) % 3];
+
+		bool bInsideA = a.PosH.z >= 0.0f;
+		bool bInsideB = b.PosH.z >= 0.0f;
+
+		if (bInsideA)
+		{
+			poly[count++] = a;
+		}
+
+		if (bInsideA != bInsideB)
+		{
+			// Everything is linear in clip space, so the new vertex is a plain lerp.
+			float t = a.PosH.z / (a.PosH.z - b.PosH.z);
+
+			ClipVertex& v = poly[count++];
+			XMStoreFloat4(&v.PosH, XMVectorLerp(XMLoadFloat4(&a.PosH), XMLoadFloat4(&b.PosH), t));
+			XMStoreFloat3(&v.PosW, XMVectorLerp(XMLoadFloat3(&a.PosW), XMLoadFloat3(&b.PosW), t));
+			XMStoreFloat3(&v.NormalW, XMVectorLerp(XMLoadFloat3(&a.NormalW), XMLoadFloat3(&b.NormalW), t));
+			XMStoreFloat2(&v.Tex, XMVectorLerp(XMLoadFloat2(&a.Tex), XMLoadFloat2(&b.Tex), t));
+			v.PosH.z = 0.0f;
+		}
+	}
+
+	for (UINT i = 2; i < count; ++i)
+	{
+		SetupTriangle(poly[0], poly[i - 1], poly[i], bCullBack, drawIndex, out);
+	}
+}
+
+void GSoftRasterizer::SetupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, bool bCullBack,
+	UINT drawIndex, std::vector<Triangle>& out) const
+{
+	const ClipVertex* v[3] = { &v0, &v1, &v2 };
+
+	float sx[3];
+	float sy[3];
+	float invW[3];
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const XMFLOAT4& p = v[i]->PosH;
+		invW[i] = 1.0f / p.w;
+		sx[i] = Snap((p.x * invW[i] * 0.5f + 0.5f) * mWidth);
+		sy[i] = Snap((0.5f - p.y * invW[i] * 0.5f) * mHeight);
+	}
+
+	// Twice the signed area; positive for clockwise triangles, since y points down.
+	float area2 = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sx[2] - sx[0]) * (sy[1] - sy[0]);
+
+	if (area2 == 0.0f || (area2 < 0.0f && bCullBack))
+	{
+		return;
+	}
+
+	// Rasterize back faces as if they were front faces.
+	if (area2 < 0.0f)
+	{
+		std::swap(v[1], v[2]);
+		std::swap(sx[1], sx[2]);
+		std::swap(sy[1], sy[2]);
+		std::swap(invW[1], invW[2]);
+		area2 = -area2;
+	}
+
+	float minX = (std::max)((std::min)((std::min)(sx[0], sx[1]), sx[2]), 0.0f);
+	float minY = (std::max)((std::min)((std::min)(sy[0], sy[1]), sy[2]), 0.0f);
+	float maxX = (std::min)((std::max)((std::max)(sx[0], sx[1]), sx[2]), static_cast<float>(mWidth - 1));
+	float maxY = (std::min)((std::max)((std::max)(sy[0], sy[1]), sy[2]), static_cast<float>(mHeight - 1));
+
+	if (minX > maxX || minY > maxY)
+	{
+		return;
+	}
+
+	Triangle tri;
+	tri.MinX = static_cast<int>(minX);
+	tri.MinY = static_cast<int>(minY);
+	tri.MaxX = static_cast<int>(maxX);
+	tri.MaxY = static_cast<int>(maxY);
+	tri.DrawIndex = drawIndex;
+
+	// Work relative to the bounds so the edge functions keep their precision.
+	for (int i = 0; i < 3; ++i)
+	{
+		sx[i] -= tri.MinX;
+		sy[i] -= tri.MinY;
+	}
+
+	// Edge i is opposite vertex i, so edge i divided by the area is vertex i's barycentric.
+	float invArea2 = 1.0f / area2;
+	Plane bary[3];
+
+	for (int i = 0; i < 3; ++i)
+	{
+		int j = (i + 1) % 3;
+		int k = (i + 2) % 3;
+
+		Plane& edge = tri.Edges[i];
+		edge.A = sy[j] - sy[k];
+		edge.B = sx[k] - sx[j];
+		edge.C = -(edge.A * sx[j] + edge.B * sy[j]);
+
+		// Pixels exactly on an edge belong to the triangle only if it is a top or left edge.
+		tri.bTopLeft[i] = edge.A > 0.0f || (edge.A == 0.0f && edge.B > 0.0f);
+
+		bary[i].A = edge.A * invArea2;
+		bary[i].B = edge.B * invArea2;
+		bary[i].C = edge.C * invArea2;
+	}
+
+	float depth[3];
+	float values[3][INTERP_COUNT];
+
+	for (int i = 0; i < 3; ++i)
+	{
+		const ClipVertex& cv = *v[i];
+		depth[i] = cv.PosH.z * invW[i];
+
+		values[i][INTERP_INV_W] = invW[i];
+		values[i][INTERP_POS_X] = cv.PosW.x * invW[i];
+		values[i][INTERP_POS_Y] = cv.PosW.y * invW[i];
+		values[i][INTERP_POS_Z] = cv.PosW.z * invW[i];
+		values[i][INTERP_NORMAL_X] = cv.NormalW.x * invW[i];
+		values[i][INTERP_NORMAL_Y] = cv.NormalW.y * invW[i];
+		values[i][INTERP_NORMAL_Z] = cv.NormalW.z * invW[i];
+		values[i][INTERP_TEX_U] = cv.Tex.x * invW[i];
+		values[i][INTERP_TEX_V] = cv.Tex.y * invW[i];
+	}
+
+	tri.Depth.A = bary[0].A * depth[0] + bary[1].A * depth[1] + bary[2].A * depth[2];
+	tri.Depth.B = bary[0].B * depth[0] + bary[1].B * depth[1] + bary[2].B * depth[2];
+	tri.Depth.C = bary[0].C * depth[0] + bary[1].C * depth[1] + bary[2].C * depth[2];
+
+	for (int n = 0; n < INTERP_COUNT; ++n)
+	{
+		Plane& plane = tri.Interpolants[n];
+		plane.A = bary[0].A * values[0][n] + bary[1].A * values[1][n] + bary[2].A * values[2][n];
+		plane.B = bary[0].B * values[0][n] + bary[1].B * values[1][n] + bary[2].B * values[2][n];
+		plane.C = bary[0].C * values[0][n] + bary[1].C * values[1][n] + bary[2].C * values[2][n];
+	}
+
+	out.push_back(tri);
+}
+
+void GSoftRasterizer::Resolve()
+{
+	Clock::time_point start = Clock::now();
+
+	GThreadPool::Get().Dispatch(mTilesX * mTilesY, [this](UINT tile)
+	{
+		ResolveTile(tile);
+	});
+
+	mResolveTime = GetMilliseconds(start);
+}
+
+void GSoftRasterizer::ResolveTile(UINT tileIndex)
+{
+	int tileX0 = (tileIndex % mTilesX) * TileSize;
+	int tileY0 = (tileIndex / mTilesX) * TileSize;
+	int tileX1 = (std::min)(tileX0 + static_cast<int>(TileSize), static_cast<int>(mWidth)) - 1;
+	int tileY1 = (std::min)(tileY0 + static_cast<int>(TileSize), static_cast<int>(mHeight)) - 1;
+
+	// Clearing here keeps the tile in cache for the triangles that follow.
+	for (int y = tileY0; y <= tileY1; ++y)
+	{
+		std::fill_n(&mColorBuffer[static_cast<size_t>(y) * mWidth + tileX0], tileX1 - tileX0 + 1, mClearColor);
+		std::fill_n(&mDepthBuffer[static_cast<size_t>(y) * mDepthPitch + tileX0], tileX1 - tileX0 + 1, 1.0f);
+	}
+
+	const __m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 four = _mm_set1_ps(4.0f);
+
+	const std::vector<UINT>& bin = mBins[tileIndex];
+
+	for (size_t b = 0; b < bin.size(); ++b)
+	{
+		const Triangle& tri = mTriangles[bin[b]];
+
+		int xStart = (std::max)(tileX0, tri.MinX);
+		int xEnd = (std::min)(tileX1, tri.MaxX);
+		int yStart = (std::max)(tileY0, tri.MinY);
+		int yEnd = (std::min)(tileY1, tri.MaxY);
+
+		// Step in aligned groups of four; lanes outside [xStart, xEnd] are masked off.
+		int xAligned = xStart & ~3;
+
+		__m128 edgeA[3], edgeB[3], edgeC[3], edgeStep[3], topLeft[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			edgeA[i] = _mm_set1_ps(tri.Edges[i].A);
+			edgeB[i] = _mm_set1_ps(tri.Edges[i].B);
+			edgeC[i] = _mm_set1_ps(tri.Edges[i].C);
+			edgeStep[i] = _mm_set1_ps(4.0f * tri.Edges[i].A);
+			topLeft[i] = _mm_castsi128_ps(_mm_set1_epi32(tri.bTopLeft[i] ? -1 : 0));
+		}
+
+		__m128 depthA = _mm_set1_ps(tri.Depth.A);
+		__m128 depthB = _mm_set1_ps(tri.Depth.B);
+		__m128 depthC = _mm_set1_ps(tri.Depth.C);
+		__m128 depthStep = _mm_set1_ps(4.0f * tri.Depth.A);
+
+		__m128 firstX = _mm_set1_ps(static_cast<float>(xStart));
+		__m128 lastX = _mm_set1_ps(static_cast<float>(xEnd));
+
+		for (int y = yStart; y <= yEnd; ++y)
+		{
+			// Pixel centers, relative to the triangle's origin.
+			float py = (y - tri.MinY) + 0.5f;
+			__m128 cy = _mm_set1_ps(py);
+			__m128 cx = _mm_add_ps(_mm_set1_ps((xAligned - tri.MinX) + 0.5f), laneOffsets);
+			__m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(xAligned)), laneOffsets);
+
+			__m128 edge[3];
+			for (int i = 0; i < 3; ++i)
+			{
+				edge[i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[i], cx), _mm_mul_ps(edgeB[i], cy)), edgeC[i]);
+			}
+
+			__m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(depthA, cx), _mm_mul_ps(depthB, cy)), depthC);
+
+			float* depthRow = &mDepthBuffer[static_cast<size_t>(y) * mDepthPitch];
+			uint32_t* colorRow = &mColorBuffer[static_cast<size_t>(y) * mWidth];
+
+			for (int x = xAligned; x <= xEnd; x += 4)
+			{
+				__m128 mask = _mm_and_ps(_mm_cmpge_ps(px, firstX), _mm_cmple_ps(px, lastX));
+
+				for (int i = 0; i < 3; ++i)
+				{
+					__m128 inside = _mm_or_ps(_mm_cmpgt_ps(edge[i], zero), _mm_and_ps(_mm_cmpeq_ps(edge[i], zero), topLeft[i]));
+					mask = _mm_and_ps(mask, inside);
+				}
+
+				if (_mm_movemask_ps(mask))
+				{
+					__m128 stored = _mm_loadu_ps(depthRow + x);
+					mask = _mm_and_ps(mask, _mm_cmplt_ps(z, stored));
+
+					int bits = _mm_movemask_ps(mask);
+					if (bits)
+					{
+						_mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, stored)));
+
+						for (int lane = 0; lane < 4; ++lane)
+						{
+							if (bits & (1 << lane))
+							{
+								ShadePixel(tri, (x + lane - tri.MinX) + 0.5f, py, colorRow[x + lane]);
+							}
+						}
+					}
+				}
+
+				for (int i = 0; i < 3; ++i)
+				{
+					edge[i] = _mm_add_ps(edge[i], edgeStep[i]);
+				}
+
+				z = _mm_add_ps(z, depthStep);
+				px = _mm_add_ps(px, four);
+			}
+		}
+	}
+}
+
+void GSoftRasterizer::ShadePixel(const Triangle& tri, float x, float y, uint32_t& color) const
+{
+	float values[INTERP_COUNT];
+	for (int n = 0; n < INTERP_COUNT; ++n)
+	{
+		const Plane& plane = tri.Interpolants[n];
+		values[n] = plane.A * x + plane.B * y + plane.C;
+	}
+
+	float w = 1.0f / values[INTERP_INV_W];
+
+	XMVECTOR posW = XMVectorSet(values[INTERP_POS_X], values[INTERP_POS_Y], values[INTERP_POS_Z], 0.0f) * w;
+	XMVECTOR normal = XMVector3Normalize(XMVectorSet(values[INTERP_NORMAL_X], values[INTERP_NORMAL_Y], values[INTERP_NORMAL_Z], 0.0f));
+	XMVECTOR toEye = XMVector3Normalize(XMLoadFloat3(&mEyePosW) - posW);
+
+	const DrawState& state = mDraws[tri.DrawIndex];
+	const Material& mat = state.Mat;
+
+	float texColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	if (state.DiffuseMap)
+	{
+		float u = values[INTERP_TEX_U] * w;
+		float v = values[INTERP_TEX_V] * w;
+
+		// Screen-space derivatives of (u, v) in texels, from the quotient rule on the planes.
+		// They pick the mip level as the hardware would from a 2x2 quad.
+		const Plane& planeU = tri.Interpolants[INTERP_TEX_U];
+		const Plane& planeV = tri.Interpolants[INTERP_TEX_V];
+		const Plane& planeQ = tri.Interpolants[INTERP_INV_W];
+
+		float texWidth = static_cast<float>(state.DiffuseMap->GetWidth());
+		float texHeight = static_cast<float>(state.DiffuseMap->GetHeight());
+
+		float dudx = (planeU.A - u * planeQ.A) * w * texWidth;
+		float dvdx = (planeV.A - v * planeQ.A) * w * texHeight;
+		float dudy = (planeU.B - u * planeQ.B) * w * texWidth;
+		float dvdy = (planeV.B - v * planeQ.B) * w * texHeight;
+
+		float rho2 = (std::max)(dudx*dudx + dvdx*dvdx, dudy*dudy + dvdy*dvdy);
+		float lod = rho2 > 0.0f ? 0.5f * log2f(rho2) : 0.0f;
+
+		state.DiffuseMap->Sample(u, v, lod, state.Address, texColor);
+	}
+
+	// ComputeDirectionalLight from LightHelper.hlsl, summed over the lights.
+	XMVECTOR matAmbient = XMLoadFloat4(&mat.Ambient);
+	XMVECTOR matDiffuse = XMLoadFloat4(&mat.Diffuse);
+	XMVECTOR matSpecular = XMLoadFloat4(&mat.Specular);
+
+	XMVECTOR ambient = XMVectorZero();
+	XMVECTOR diffuse = XMVectorZero();
+	XMVECTOR spec = XMVectorZero();
+
+	for (UINT i = 0; i < mLightCount; ++i)
+	{
+		const DirectionalLight& light = mLights[i];
+		XMVECTOR direction = XMLoadFloat3(&light.Direction);
+
+		ambient += matAmbient * XMLoadFloat4(&light.Ambient);
+
+		float diffuseFactor = XMVectorGetX(XMVector3Dot(-direction, normal));
+
+		if (diffuseFactor > 0.0f)
+		{
+			XMVECTOR v = XMVector3Reflect(direction, normal);
+			float specFactor = powf((std::max)(XMVectorGetX(XMVector3Dot(v, toEye)), 0.0f), mat.Specular.w);
+
+			diffuse += diffuseFactor * matDiffuse * XMLoadFloat4(&light.Diffuse);
+			spec += specFactor * matSpecular * XMLoadFloat4(&light.Specular);
+		}
+	}
+
+	XMFLOAT4 lit;
+	XMStoreFloat4(&lit, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(texColor)) * (ambient + diffuse) + spec);
+
+	color = PackColor(lit.x, lit.y, lit.z, mat.Diffuse.w * texColor[3]);
+}
\ No newline at end of file
@@ -0,0 +1,210 @@
+/*  ===============================================
+	Summary: Tile-Binning Software Rasterizer
+	===============================================  */
+
+#ifndef GSOFTRASTERIZER_H
+#define GSOFTRASTERIZER_H
+
+#include "LightHelper.h"
+#include "GMipGenerator.h"
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+// Renders the subset of the pipeline the lighting and texturing demos use without a GPU:
+// indexed triangle lists, a LESS depth test, the per-pixel directional lighting of
+// LightHelper.hlsl and trilinear texture sampling.  Draw transforms and clips the triangles
+// and bins them into screen tiles; Resolve then shades the tiles in parallel on the thread
+// pool, four pixels at a time for coverage and depth.  Output is RGBA8, suitable for
+// comparing against golden images.
+class GSoftRasterizer
+{
+public:
+	// Same layout as the texturing demo's Vertex.
+	struct Vertex
+	{
+		DirectX::XMFLOAT3 Pos;
+		DirectX::XMFLOAT3 Normal;
+		DirectX::XMFLOAT2 Tex;
+	};
+
+	enum AddressMode
+	{
+		ADDRESS_WRAP,
+		ADDRESS_CLAMP,
+	};
+
+	// RGBA8 image and its mip chain.
+	class Texture
+	{
+	public:
+		void Create(const uint8_t* rgba, UINT width, UINT height, UINT rowPitch);
+
+		inline UINT GetWidth() const { return mLevels.empty() ? 0 : mLevels[0].Width; }
+		inline UINT GetHeight() const { return mLevels.empty() ? 0 : mLevels[0].Height; }
+		inline UINT GetMipCount() const { return static_cast<UINT>(mLevels.size()); }
+
+		// Linear between texels and between the two levels around lod.
+		void Sample(float u, float v, float lod, AddressMode address, float color[4]) const;
+
+	private:
+		void SampleLevel(UINT level, float u, float v, AddressMode address, float color[4]) const;
+
+	private:
+		std::vector<GMipGenerator::Level> mLevels;
+	};
+
+	struct DrawCall
+	{
+		const Vertex* Vertices;
+		UINT VertexCount;
+		const UINT* Indices;
+		UINT IndexCount;
+
+		DirectX::XMFLOAT4X4 World;
+		DirectX::XMFLOAT4X4 TexTransform;
+		Material Mat;
+
+		// Null draws untextured, as the lighting demo does.  Must stay alive until Resolve.
+		const Texture* DiffuseMap;
+		AddressMode Address;
+
+		// Clockwise triangles face the camera, as with the default rasterizer state.
+		bool bCullBack;
+	};
+
+	static const UINT MaxLights = 3;
+	static const UINT TileSize = 64;
+
+	GSoftRasterizer();
+	~GSoftRasterizer();
+
+	void Resize(UINT width, UINT height);
+
+	// Starts a frame.  The buffers are cleared tile by tile during Resolve.
+	void Clear(const float color[4]);
+
+	void SetViewProj(DirectX::CXMMATRIX viewProj);
+	void SetEyePosW(const DirectX::XMFLOAT3& eyePosW);
+	void SetLights(const DirectionalLight* lights, UINT count);
+
+	void Draw(const DrawCall& draw);
+
+	// Rasterizes and shades everything drawn since Clear.  Lights and the eye position are the
+	// ones set when Resolve runs.
+	void Resolve();
+
+	// Rows of GetWidth() RGBA8 pixels, tightly packed.
+	inline const uint8_t* GetColorBuffer() const { return reinterpret_cast<const uint8_t*>(mColorBuffer.data()); }
+	inline UINT GetWidth() const { return mWidth; }
+	inline UINT GetHeight() const { return mHeight; }
+
+	// Triangles that survived culling and clipping in the last frame.
+	inline UINT GetTriangleCount() const { return static_cast<UINT>(mTriangles.size()); }
+
+	// Milliseconds spent in the Draw calls and the Resolve of the last frame.
+	inline float GetDrawTime() const { return mDrawTime; }
+	inline float GetResolveTime() const { return mResolveTime; }
+
+private:
+	struct ClipVertex
+	{
+		DirectX::XMFLOAT4 PosH;
+		DirectX::XMFLOAT3 PosW;
+		DirectX::XMFLOAT3 NormalW;
+		DirectX::XMFLOAT2 Tex;
+	};
+
+	// A*x + B*y + C over the screen, in pixels relative to the triangle's origin.
+	struct Plane
+	{
+		float A;
+		float B;
+		float C;
+	};
+
+	// Interpolants divided by w, so a plane evaluated at a pixel and multiplied by w there
+	// gives the perspective-correct value.
+	enum Interpolant
+	{
+		INTERP_INV_W,
+		INTERP_POS_X,
+		INTERP_POS_Y,
+		INTERP_POS_Z,
+		INTERP_NORMAL_X,
+		INTERP_NORMAL_Y,
+		INTERP_NORMAL_Z,
+		INTERP_TEX_U,
+		INTERP_TEX_V,
+		INTERP_COUNT
+	};
+
+	struct Triangle
+	{
+		// Edge functions, positive inside.
+		Plane Edges[3];
+		bool bTopLeft[3];
+
+		Plane Depth;
+		Plane Interpolants[INTERP_COUNT];
+
+		// Pixel bounds, inclusive and clamped to the screen.  The planes use (MinX, MinY) as origin.
+		int MinX;
+		int MinY;
+		int MaxX;
+		int MaxY;
+
+		UINT DrawIndex;
+	};
+
+	struct DrawState
+	{
+		Material Mat;
+		const Texture* DiffuseMap;
+		AddressMode Address;
+	};
+
+	void SetupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, bool bCullBack,
+		UINT drawIndex, std::vector<Triangle>& out) const;
+	void ClipTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, bool bCullBack,
+		UINT drawIndex, std::vector<Triangle>& out) const;
+
+	void ResolveTile(UINT tileIndex);
+	void ShadePixel(const Triangle& tri, float x, float y, uint32_t& color) const;
+
+	GSoftRasterizer(const GSoftRasterizer&);
+	GSoftRasterizer& operator=(const GSoftRasterizer&);
+
+private:
+	UINT mWidth;
+	UINT mHeight;
+	UINT mTilesX;
+	UINT mTilesY;
+
+	// Depth rows are padded to a multiple of four pixels so depth can be tested four at a time.
+	UINT mDepthPitch;
+	std::vector<float> mDepthBuffer;
+	std::vector<uint32_t> mColorBuffer;
+	uint32_t mClearColor;
+
+	DirectX::XMFLOAT4X4 mViewProj;
+	DirectX::XMFLOAT3 mEyePosW;
+	DirectionalLight mLights[MaxLights];
+	UINT mLightCount;
+
+	std::vector<DrawState> mDraws;
+	std::vector<Triangle> mTriangles;
+
+	// Triangle indices overlapping each tile, in submission order.
+	std::vector<std::vector<UINT>> mBins;
+
+	std::vector<ClipVertex> mClipVertices;
+	std::vector<std::vector<Triangle>> mRangeTriangles;
+
+	float mDrawTime;
+	float mResolveTime;
+};
+
+#endif // GSOFTRASTERIZER_H
\ No newline at end of file
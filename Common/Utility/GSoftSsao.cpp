@@ -0,0 +1,403 @@
+/*  ===============================================
+	Summary: CPU Reference SSAO
+	===============================================  */
+
+#include "GSoftSsao.h"
+#include "GThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <emmintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// Constants from SSAOPS.hlsl.
+	const float OcclusionRadius = 0.5f;
+	const float SurfaceEpsilon = 0.05f;
+	const float FadeStart = 0.2f;
+	const float FadeEnd = 2.0f;
+
+	// samNormalDepth's border color alpha, so samples off screen never occlude.
+	const float BorderDepth = 1e5f;
+
+	// The random vector map is tiled four times across the screen.
+	const float RandomVectorTiling = 4.0f;
+
+	const UINT RowsPerRange = 4;
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	inline float GetMilliseconds(Clock::time_point start)
+	{
+		return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+	}
+
+	inline float Saturate(float x)
+	{
+		return (std::min)((std::max)(x, 0.0f), 1.0f);
+	}
+
+	// SSE2 has no floor instruction: truncate, then step down where that rounded up.
+	inline __m128 Floor(__m128 x)
+	{
+		__m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+		return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+	}
+
+	// Bilinear filter of the padded depth plane at four points, as MIN_MAG_LINEAR with BORDER
+	// addressing.  size is (width, height) of the unpadded map in texels.
+	inline __m128 SampleDepth(const float* plane, UINT pitch, __m128 sizeX, __m128 sizeY, __m128 u, __m128 v)
+	{
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 minusOne = _mm_set1_ps(-1.0f);
+
+		// Everything past the border texels is border too, so clamp into the padding.
+		__m128 x = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_mul_ps(u, sizeX), half), minusOne), sizeX);
+		__m128 y = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_mul_ps(v, sizeY), half), minusOne), sizeY);
+		__m128 fx = Floor(x);
+		__m128 fy = Floor(y);
+		__m128 s = _mm_sub_ps(x, fx);
+		__m128 t = _mm_sub_ps(y, fy);
+
+		alignas(16) int column[4], row[4];
+		alignas(16) float t00[4], t10[4], t01[4], t11[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(column), _mm_cvttps_epi32(fx));
+		_mm_store_si128(reinterpret_cast<__m128i*>(row), _mm_cvttps_epi32(fy));
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			const float* texel = plane + (row[lane] + 1) * pitch + column[lane] + 1;
+			t00[lane] = texel[0];
+			t10[lane] = texel[1];
+			t01[lane] = texel[pitch];
+			t11[lane] = texel[pitch + 1];
+		}
+
+		__m128 top = _mm_load_ps(t00);
+		__m128 bottom = _mm_load_ps(t01);
+		top = _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(t10), top), s));
+		bottom = _mm_add_ps(bottom, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(t11), bottom), s));
+		return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), t));
+	}
+
+	// Same filter over the full normal/depth texels for the center sample.
+	inline XMFLOAT4 SampleNormalDepth(const XMFLOAT4* texels, int width, int height, float u, float v)
+	{
+		float x = u * width - 0.5f;
+		float y = v * height - 0.5f;
+		float fx = floorf(x);
+		float fy = floorf(y);
+		float s = x - fx;
+		float t = y - fy;
+		int x0 = static_cast<int>(fx);
+		int y0 = static_cast<int>(fy);
+
+		const XMFLOAT4 border(0.0f, 0.0f, 0.0f, BorderDepth);
+		XMFLOAT4 result(0.0f, 0.0f, 0.0f, 0.0f);
+		for (int j = 0; j < 2; ++j)
+		{
+			for (int i = 0; i < 2; ++i)
+			{
+				int tx = x0 + i;
+				int ty = y0 + j;
+				const XMFLOAT4& texel = (tx < 0 || ty < 0 || tx >= width || ty >= height) ? border : texels[ty * width + tx];
+				float weight = (i ? s : 1.0f - s) * (j ? t : 1.0f - t);
+				result.x += texel.x * weight;
+				result.y += texel.y * weight;
+				result.z += texel.z * weight;
+				result.w += texel.w * weight;
+			}
+		}
+		return result;
+	}
+
+	// Wrapped bilinear filter of the random vector map, decoded from [0, 1] to [-1, 1].
+	inline void SampleRandomVector(const float* map, float u, float v, float vec[3])
+	{
+		const int size = static_cast<int>(GSoftSsao::RandomVectorMapSize);
+		float x = u * size - 0.5f;
+		float y = v * size - 0.5f;
+		float fx = floorf(x);
+		float fy = floorf(y);
+		float s = x - fx;
+		float t = y - fy;
+
+		// The size is a power of two, so masking wraps negative coordinates too.
+		int x0 = static_cast<int>(fx) & (size - 1);
+		int y0 = static_cast<int>(fy) & (size - 1);
+		int x1 = (x0 + 1) & (size - 1);
+		int y1 = (y0 + 1) & (size - 1);
+
+		const float* t00 = map + (y0 * size + x0) * 3;
+		const float* t10 = map + (y0 * size + x1) * 3;
+		const float* t01 = map + (y1 * size + x0) * 3;
+		const float* t11 = map + (y1 * size + x1) * 3;
+
+		for (int c = 0; c < 3; ++c)
+		{
+			float top = t00[c] + (t10[c] - t00[c]) * s;
+			float bottom = t01[c] + (t11[c] - t01[c]) * s;
+			vec[c] = 2.0f * (top + (bottom - top) * t) - 1.0f;
+		}
+	}
+
+	inline __m128 Dot3(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+	}
+}
+
+void GSoftSsao::BuildOffsetVectors(UINT seed, XMFLOAT4 offsets[NumOffsets])
+{
+	// Cube corners and face centers, in opposite pairs so the directions stay evenly spread.
+	offsets[0] = XMFLOAT4(+1.0f, +1.0f, +1.0f, 0.0f);
+	offsets[1] = XMFLOAT4(-1.0f, -1.0f, -1.0f, 0.0f);
+
+	offsets[2] = XMFLOAT4(+1.0f, +1.0f, -1.0f, 0.0f);
+	offsets[3] = XMFLOAT4(-1.0f, -1.0f, +1.0f, 0.0f);
+
+	offsets[4] = XMFLOAT4(+1.0f, -1.0f, +1.0f, 0.0f);
+	offsets[5] = XMFLOAT4(-1.0f, +1.0f, -1.0f, 0.0f);
+
+	offsets[6] = XMFLOAT4(-1.0f, +1.0f, +1.0f, 0.0f);
+	offsets[7] = XMFLOAT4(+1.0f, -1.0f, -1.0f, 0.0f);
+
+	offsets[8] = XMFLOAT4(-1.0f, 0.0f, 0.0f, 0.0f);
+	offsets[9] = XMFLOAT4(+1.0f, 0.0f, 0.0f, 0.0f);
+
+	offsets[10] = XMFLOAT4(0.0f, +1.0f, 0.0f, 0.0f);
+	offsets[11] = XMFLOAT4(0.0f, -1.0f, 0.0f, 0.0f);
+
+	offsets[12] = XMFLOAT4(0.0f, 0.0f, +1.0f, 0.0f);
+	offsets[13] = XMFLOAT4(0.0f, 0.0f, -1.0f, 0.0f);
+
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> length(0.25f, 1.0f);
+
+	for (UINT i = 0; i < NumOffsets; ++i)
+	{
+		XMVECTOR v = XMVectorScale(XMVector3Normalize(XMLoadFloat4(&offsets[i])), length(rng));
+		XMStoreFloat4(&offsets[i], v);
+	}
+}
+
+void GSoftSsao::BuildRandomVectors(UINT seed, std::vector<uint8_t>& rgba)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> channel(0, 255);
+
+	rgba.resize(RandomVectorMapSize * RandomVectorMapSize * 4);
+	for (size_t i = 0; i < rgba.size(); i += 4)
+	{
+		rgba[i + 0] = static_cast<uint8_t>(channel(rng));
+		rgba[i + 1] = static_cast<uint8_t>(channel(rng));
+		rgba[i + 2] = static_cast<uint8_t>(channel(rng));
+		rgba[i + 3] = 0;
+	}
+}
+
+GSoftSsao::GSoftSsao() :
+	mMapWidth(0),
+	mMapHeight(0),
+	mComputeTime(0.0f)
+{
+	ZeroMemory(mOffsets, sizeof(mOffsets));
+	mRandomVectors.assign(RandomVectorMapSize * RandomVectorMapSize * 3, 0.5f);
+}
+
+GSoftSsao::~GSoftSsao()
+{
+}
+
+void GSoftSsao::SetOffsetVectors(const XMFLOAT4 offsets[NumOffsets])
+{
+	std::copy(offsets, offsets + NumOffsets, mOffsets);
+}
+
+void GSoftSsao::SetRandomVectors(const uint8_t* rgba)
+{
+	for (UINT i = 0; i < RandomVectorMapSize * RandomVectorMapSize; ++i)
+	{
+		mRandomVectors[i * 3 + 0] = rgba[i * 4 + 0] / 255.0f;
+		mRandomVectors[i * 3 + 1] = rgba[i * 4 + 1] / 255.0f;
+		mRandomVectors[i * 3 + 2] = rgba[i * 4 + 2] / 255.0f;
+	}
+}
+
+float GSoftSsao::GetMegapixelsPerSecond() const
+{
+	if (mComputeTime <= 0.0f)
+	{
+		return 0.0f;
+	}
+	return (mMapWidth * mMapHeight) / (mComputeTime * 1000.0f);
+}
+
+void GSoftSsao::Compute(const XMFLOAT4* normalDepth, UINT width, UINT height,
+	CXMMATRIX proj, float farZ, bool bHalfResolution, std::vector<float>& ambientMap)
+{
+	Clock::time_point start = Clock::now();
+
+	mMapWidth = bHalfResolution ? (std::max)(width / 2, 1u) : width;
+	mMapHeight = bHalfResolution ? (std::max)(height / 2, 1u) : height;
+	ambientMap.resize(mMapWidth * mMapHeight);
+
+	// Depth alone is fetched for every occluder sample, so pull it out of the float4s once.
+	UINT pitch = width + 3;
+	mDepthPlane.assign(pitch * (height + 3), BorderDepth);
+	for (UINT y = 0; y < height; ++y)
+	{
+		float* dst = &mDepthPlane[(y + 1) * pitch + 1];
+		const XMFLOAT4* src = normalDepth + y * width;
+		for (UINT x = 0; x < width; ++x)
+		{
+			dst[x] = src[x].w;
+		}
+	}
+
+	// The far plane corners the vertex shader interpolates, and the same view to texture
+	// transform the demo builds.
+	XMFLOAT4X4 p;
+	XMStoreFloat4x4(&p, proj);
+	float farHalfWidth = farZ / p._11;
+	float farHalfHeight = farZ / p._22;
+
+	static const XMMATRIX T(
+		0.5f, 0.0f, 0.0f, 0.0f,
+		0.0f, -0.5f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.5f, 0.5f, 0.0f, 1.0f);
+
+	XMFLOAT4X4 viewTex;
+	XMStoreFloat4x4(&viewTex, XMMatrixMultiply(proj, T));
+
+	const __m128 m11 = _mm_set1_ps(viewTex._11), m21 = _mm_set1_ps(viewTex._21), m31 = _mm_set1_ps(viewTex._31), m41 = _mm_set1_ps(viewTex._41);
+	const __m128 m12 = _mm_set1_ps(viewTex._12), m22 = _mm_set1_ps(viewTex._22), m32 = _mm_set1_ps(viewTex._32), m42 = _mm_set1_ps(viewTex._42);
+	const __m128 m14 = _mm_set1_ps(viewTex._14), m24 = _mm_set1_ps(viewTex._24), m34 = _mm_set1_ps(viewTex._34), m44 = _mm_set1_ps(viewTex._44);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 radius = _mm_set1_ps(OcclusionRadius);
+	const __m128 epsilon = _mm_set1_ps(SurfaceEpsilon);
+	const __m128 fadeEnd = _mm_set1_ps(FadeEnd);
+	const __m128 invFadeLength = _mm_set1_ps(1.0f / (FadeEnd - FadeStart));
+
+	const int srcWidth = static_cast<int>(width);
+	const int srcHeight = static_cast<int>(height);
+	const __m128 sizeX = _mm_set1_ps(static_cast<float>(width));
+	const __m128 sizeY = _mm_set1_ps(static_cast<float>(height));
+	const float* depthPlane = mDepthPlane.data();
+	const float* randomVectors = mRandomVectors.data();
+	const XMFLOAT4* offsets = mOffsets;
+	const UINT mapWidth = mMapWidth;
+	const UINT mapHeight = mMapHeight;
+	float* output = ambientMap.data();
+
+	GThreadPool::Get().ParallelFor(mMapHeight, RowsPerRange, [&](UINT begin, UINT end)
+	{
+		alignas(16) float px[4], py[4], pz[4];
+		alignas(16) float nx[4], ny[4], nz[4];
+		alignas(16) float rx[4], ry[4], rz[4];
+		alignas(16) float access[4];
+
+		for (UINT y = begin; y < end; ++y)
+		{
+			float v = (y + 0.5f) / mapHeight;
+
+			for (UINT x = 0; x < mapWidth; x += 4)
+			{
+				// Per-lane fetches: the center normal/depth, the position on the ray to the far
+				// plane and the random vector.  Lanes past the row end repeat the last pixel.
+				for (UINT lane = 0; lane < 4; ++lane)
+				{
+					UINT column = (std::min)(x + lane, mapWidth - 1);
+					float u = (column + 0.5f) / mapWidth;
+
+					XMFLOAT4 center = SampleNormalDepth(normalDepth, srcWidth, srcHeight, u, v);
+					float scale = center.w / farZ;
+					px[lane] = scale * (2.0f * u - 1.0f) * farHalfWidth;
+					py[lane] = scale * (1.0f - 2.0f * v) * farHalfHeight;
+					pz[lane] = center.w;
+					nx[lane] = center.x;
+					ny[lane] = center.y;
+					nz[lane] = center.z;
+
+					float randVec[3];
+					SampleRandomVector(randomVectors, RandomVectorTiling * u, RandomVectorTiling * v, randVec);
+					rx[lane] = randVec[0];
+					ry[lane] = randVec[1];
+					rz[lane] = randVec[2];
+				}
+
+				__m128 pX = _mm_load_ps(px), pY = _mm_load_ps(py), pZ = _mm_load_ps(pz);
+				__m128 nX = _mm_load_ps(nx), nY = _mm_load_ps(ny), nZ = _mm_load_ps(nz);
+				__m128 rX = _mm_load_ps(rx), rY = _mm_load_ps(ry), rZ = _mm_load_ps(rz);
+				__m128 occlusionSum = zero;
+
+				for (UINT i = 0; i < NumOffsets; ++i)
+				{
+					// reflect(offset, randVec) = offset - 2 * dot(offset, randVec) * randVec.
+					__m128 oX = _mm_set1_ps(offsets[i].x);
+					__m128 oY = _mm_set1_ps(offsets[i].y);
+					__m128 oZ = _mm_set1_ps(offsets[i].z);
+					__m128 d = _mm_mul_ps(two, Dot3(oX, oY, oZ, rX, rY, rZ));
+					oX = _mm_sub_ps(oX, _mm_mul_ps(d, rX));
+					oY = _mm_sub_ps(oY, _mm_mul_ps(d, rY));
+					oZ = _mm_sub_ps(oZ, _mm_mul_ps(d, rZ));
+
+					// sign(dot(offset, n)), zero when the offset lies in the tangent plane.
+					__m128 facing = Dot3(oX, oY, oZ, nX, nY, nZ);
+					__m128 flip = _mm_sub_ps(_mm_and_ps(_mm_cmpgt_ps(facing, zero), one), _mm_and_ps(_mm_cmplt_ps(facing, zero), one));
+
+					__m128 s = _mm_mul_ps(radius, flip);
+					__m128 qX = _mm_add_ps(pX, _mm_mul_ps(oX, s));
+					__m128 qY = _mm_add_ps(pY, _mm_mul_ps(oY, s));
+					__m128 qZ = _mm_add_ps(pZ, _mm_mul_ps(oZ, s));
+
+					__m128 projX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qX, m11), _mm_mul_ps(qY, m21)), _mm_add_ps(_mm_mul_ps(qZ, m31), m41));
+					__m128 projY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qX, m12), _mm_mul_ps(qY, m22)), _mm_add_ps(_mm_mul_ps(qZ, m32), m42));
+					__m128 projW = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qX, m14), _mm_mul_ps(qY, m24)), _mm_add_ps(_mm_mul_ps(qZ, m34), m44));
+					__m128 sampled = SampleDepth(depthPlane, pitch, sizeX, sizeY, _mm_div_ps(projX, projW), _mm_div_ps(projY, projW));
+
+					// r = (rz / q.z) * q, the visible point along the ray through q.
+					__m128 rScale = _mm_div_ps(sampled, qZ);
+					__m128 occX = _mm_mul_ps(qX, rScale);
+					__m128 occY = _mm_mul_ps(qY, rScale);
+					__m128 occZ = _mm_mul_ps(qZ, rScale);
+
+					__m128 distZ = _mm_sub_ps(pZ, occZ);
+					__m128 inRange = _mm_cmpgt_ps(distZ, epsilon);
+
+					__m128 toX = _mm_sub_ps(occX, pX);
+					__m128 toY = _mm_sub_ps(occY, pY);
+					__m128 toZ = _mm_sub_ps(occZ, pZ);
+					__m128 length = _mm_sqrt_ps(Dot3(toX, toY, toZ, toX, toY, toZ));
+					__m128 dp = _mm_max_ps(_mm_div_ps(Dot3(nX, nY, nZ, toX, toY, toZ), length), zero);
+
+					__m128 fade = _mm_mul_ps(_mm_sub_ps(fadeEnd, distZ), invFadeLength);
+					fade = _mm_min_ps(_mm_max_ps(fade, zero), one);
+
+					// The mask also drops the NaN of a zero-length r - p out of range lanes can produce.
+					occlusionSum = _mm_add_ps(occlusionSum, _mm_and_ps(inRange, _mm_mul_ps(fade, dp)));
+				}
+
+				__m128 a = _mm_sub_ps(one, _mm_div_ps(occlusionSum, _mm_set1_ps(static_cast<float>(NumOffsets))));
+				a = _mm_max_ps(a, zero);
+				a = _mm_mul_ps(a, a);
+				_mm_store_ps(access, _mm_mul_ps(a, a));
+
+				float* dst = output + y * mapWidth + x;
+				for (UINT lane = 0; lane < 4 && x + lane < mapWidth; ++lane)
+				{
+					dst[lane] = Saturate(access[lane]);
+				}
+			}
+		}
+	});
+
+	mComputeTime = GetMilliseconds(start);
+}
\ No newline at end of file
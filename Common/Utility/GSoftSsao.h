@@ -0,0 +1,67 @@
+/*  ===============================================
+	Summary: CPU Reference SSAO
+	===============================================  */
+
+#ifndef GSOFTSSAO_H
+#define GSOFTSSAO_H
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+// Computes the same ambient map as SSAOPS.hlsl from a view-space normal/depth buffer, so the
+// effect can be tuned and checked without a GPU, or its output diffed against the GPU's.
+// Pixels are processed four at a time with SSE and rows are spread across the thread pool.
+class GSoftSsao
+{
+public:
+	static const UINT NumOffsets = 14;
+	static const UINT RandomVectorMapSize = 256;
+
+	// The eight cube corners and six face centres, each scaled to a random length in [0.25, 1].
+	static void BuildOffsetVectors(UINT seed, DirectX::XMFLOAT4 offsets[NumOffsets]);
+
+	// RandomVectorMapSize squared RGBA8 texels with random rgb, for the random vector texture.
+	static void BuildRandomVectors(UINT seed, std::vector<uint8_t>& rgba);
+
+	GSoftSsao();
+	~GSoftSsao();
+
+	// Must match what the shader is given for the outputs to agree.
+	void SetOffsetVectors(const DirectX::XMFLOAT4 offsets[NumOffsets]);
+	void SetRandomVectors(const uint8_t* rgba);
+
+	// normalDepth holds width * height texels of (view-space normal, view-space z), as
+	// NormalDepthPS writes them.  proj and farZ are the camera's.  At half resolution the
+	// map is (width / 2) by (height / 2), like rendering the SSAO quad to a half-size target.
+	void Compute(const DirectX::XMFLOAT4* normalDepth, UINT width, UINT height,
+		DirectX::CXMMATRIX proj, float farZ, bool bHalfResolution, std::vector<float>& ambientMap);
+
+	inline UINT GetMapWidth() const { return mMapWidth; }
+	inline UINT GetMapHeight() const { return mMapHeight; }
+
+	// Milliseconds spent in the last Compute, and its throughput in output megapixels per second.
+	inline float GetComputeTime() const { return mComputeTime; }
+	float GetMegapixelsPerSecond() const;
+
+private:
+	GSoftSsao(const GSoftSsao&);
+	GSoftSsao& operator=(const GSoftSsao&);
+
+private:
+	DirectX::XMFLOAT4 mOffsets[NumOffsets];
+
+	// Decoded to [0, 1] as the sampler returns them.
+	std::vector<float> mRandomVectors;
+
+	// Depth surrounded by the sampler's border depth, one texel wide before and two after, so a
+	// bilinear footprint clamped into the border never leaves the plane.
+	std::vector<float> mDepthPlane;
+
+	UINT mMapWidth;
+	UINT mMapHeight;
+	float mComputeTime;
+};
+
+#endif // GSOFTSSAO_H
\ No newline at end of file
@@ -0,0 +1,313 @@
+/*  ===============================================
+	Summary: Uniform Grid Spatial Hash
+	===============================================  */
+
+#include "GSpatialHash.h"
+#include "GThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const UINT ItemsPerRange = 8192;
+	const UINT BucketsPerRange = 16384;
+
+	// Boxes that cover more cells than this are clamped; such colliders belong in a coarser grid.
+	const int MaxCellsPerAxis = 64;
+}
+
+GSpatialHash::GSpatialHash() :
+	mCellSize(1.0f),
+	mInvCellSize(1.0f),
+	mTableSize(0),
+	mEntryCount(0)
+{
+}
+
+GSpatialHash::~GSpatialHash()
+{
+}
+
+void GSpatialHash::Init(float cellSize, UINT tableSize)
+{
+	mCellSize = cellSize;
+	mInvCellSize = 1.0f / cellSize;
+
+	mTableSize = 1;
+	while (mTableSize < tableSize)
+	{
+		mTableSize <<= 1;
+	}
+
+	mBucketStart.assign(mTableSize + 1, 0);
+	mBucketCursor.reset(new std::atomic<UINT>[mTableSize]);
+	mEntryCount = 0;
+}
+
+UINT GSpatialHash::GetCellHash(int x, int y, int z) const
+{
+	// Large primes from Teschner et al., "Optimized Spatial Hashing for Collision Detection of Deformable Objects".
+	UINT h = (static_cast<UINT>(x) * 73856093u) ^ (static_cast<UINT>(y) * 19349663u) ^ (static_cast<UINT>(z) * 83492791u);
+	return h & (mTableSize - 1);
+}
+
+UINT GSpatialHash::GetCellHash(const DirectX::XMFLOAT3& p) const
+{
+	return GetCellHash(
+		static_cast<int>(floorf(p.x * mInvCellSize)),
+		static_cast<int>(floorf(p.y * mInvCellSize)),
+		static_cast<int>(floorf(p.z * mInvCellSize)));
+}
+
+void GSpatialHash::CellRange(const DirectX::XMFLOAT3& minP, const DirectX::XMFLOAT3& maxP, int cellMin[3], int cellMax[3]) const
+{
+	const float* lo = &minP.x;
+	const float* hi = &maxP.x;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		cellMin[axis] = static_cast<int>(floorf(lo[axis] * mInvCellSize));
+		cellMax[axis] = static_cast<int>(floorf(hi[axis] * mInvCellSize));
+
+		if (cellMax[axis] - cellMin[axis] >= MaxCellsPerAxis)
+		{
+			cellMax[axis] = cellMin[axis] + MaxCellsPerAxis - 1;
+		}
+	}
+}
+
+void GSpatialHash::BuildPoints(const DirectX::XMFLOAT3* points, UINT count)
+{
+	mEntryCount = count;
+	mEntryHashes.resize(count);
+	mUnsortedItems.resize(count);
+
+	GThreadPool::Get().ParallelFor(count, ItemsPerRange, [&](UINT begin, UINT end)
+	{
+		for (UINT i = begin; i < end; ++i)
+		{
+			mEntryHashes[i] = GetCellHash(points[i]);
+			mUnsortedItems[i] = i;
+		}
+	});
+
+	SortEntries();
+}
+
+void GSpatialHash::BuildBounds(const DirectX::BoundingBox* boxes, UINT count)
+{
+	// First count the cells each box covers so every box knows where its entries start.
+	mItemOffsets.resize(count + 1);
+	mItemOffsets[0] = 0;
+
+	for (UINT i = 0; i < count; ++i)
+	{
+		DirectX::XMFLOAT3 minP(boxes[i].Center.x - boxes[i].Extents.x, boxes[i].Center.y - boxes[i].Extents.y, boxes[i].Center.z - boxes[i].Extents.z);
+		DirectX::XMFLOAT3 maxP(boxes[i].Center.x + boxes[i].Extents.x, boxes[i].Center.y + boxes[i].Extents.y, boxes[i].Center.z + boxes[i].Extents.z);
+
+		int cellMin[3];
+		int cellMax[3];
+		CellRange(minP, maxP, cellMin, cellMax);
+
+		UINT numCells = (cellMax[0] - cellMin[0] + 1) * (cellMax[1] - cellMin[1] + 1) * (cellMax[2] - cellMin[2] + 1);
+		mItemOffsets[i + 1] = mItemOffsets[i] + numCells;
+	}
+
+	mEntryCount = mItemOffsets[count];
+	mEntryHashes.resize(mEntryCount);
+	mUnsortedItems.resize(mEntryCount);
+
+	GThreadPool::Get().ParallelFor(count, 1, [&](UINT begin, UINT end)
+	{
+		for (UINT i = begin; i < end; ++i)
+		{
+			DirectX::XMFLOAT3 minP(boxes[i].Center.x - boxes[i].Extents.x, boxes[i].Center.y - boxes[i].Extents.y, boxes[i].Center.z - boxes[i].Extents.z);
+			DirectX::XMFLOAT3 maxP(boxes[i].Center.x + boxes[i].Extents.x, boxes[i].Center.y + boxes[i].Extents.y, boxes[i].Center.z + boxes[i].Extents.z);
+
+			int cellMin[3];
+			int cellMax[3];
+			CellRange(minP, maxP, cellMin, cellMax);
+
+			UINT entry = mItemOffsets[i];
+			for (int z = cellMin[2]; z <= cellMax[2]; ++z)
+			{
+				for (int y = cellMin[1]; y <= cellMax[1]; ++y)
+				{
+					for (int x = cellMin[0]; x <= cellMax[0]; ++x)
+					{
+						mEntryHashes[entry] = GetCellHash(x, y, z);
+						mUnsortedItems[entry] = i;
+						++entry;
+					}
+				}
+			}
+		}
+	});
+
+	SortEntries();
+}
+
+void GSpatialHash::SortEntries()
+{
+	GThreadPool& pool = GThreadPool::Get();
+
+	mEntryItems.resize(mEntryCount);
+
+	std::atomic<UINT>* cursor = mBucketCursor.get();
+	UINT* bucketStart = &mBucketStart[0];
+
+	// Counting sort: count entries per bucket, scan the counts into offsets, then scatter.
+	// The table can be much larger than the entry count, so every step over it runs in parallel.
+	pool.ParallelFor(mTableSize, BucketsPerRange, [&](UINT begin, UINT end)
+	{
+		for (UINT h = begin; h < end; ++h)
+		{
+			cursor[h].store(0, std::memory_order_relaxed);
+		}
+	});
+
+	pool.ParallelFor(mEntryCount, ItemsPerRange, [&](UINT begin, UINT end)
+	{
+		for (UINT i = begin; i < end; ++i)
+		{
+			cursor[mEntryHashes[i]].fetch_add(1, std::memory_order_relaxed);
+		}
+	});
+
+	UINT numBlocks = (mTableSize + BucketsPerRange - 1) / BucketsPerRange;
+	std::vector<UINT> blockSums(numBlocks + 1, 0);
+
+	pool.Dispatch(numBlocks, [&](UINT block)
+	{
+		UINT begin = block * BucketsPerRange;
+		UINT end = (std::min)(begin + BucketsPerRange, mTableSize);
+
+		UINT sum = 0;
+		for (UINT h = begin; h < end; ++h)
+		{
+			sum += cursor[h].load(std::memory_order_relaxed);
+		}
+
+		blockSums[block + 1] = sum;
+	});
+
+	for (UINT block = 0; block < numBlocks; ++block)
+	{
+		blockSums[block + 1] += blockSums[block];
+	}
+
+	pool.Dispatch(numBlocks, [&](UINT block)
+	{
+		UINT begin = block * BucketsPerRange;
+		UINT end = (std::min)(begin + BucketsPerRange, mTableSize);
+
+		UINT offset = blockSums[block];
+		for (UINT h = begin; h < end; ++h)
+		{
+			UINT bucketCount = cursor[h].load(std::memory_order_relaxed);
+			bucketStart[h] = offset;
+			cursor[h].store(offset, std::memory_order_relaxed);
+			offset += bucketCount;
+		}
+	});
+
+	bucketStart[mTableSize] = mEntryCount;
+
+	pool.ParallelFor(mEntryCount, ItemsPerRange, [&](UINT begin, UINT end)
+	{
+		for (UINT i = begin; i < end; ++i)
+		{
+			UINT slot = cursor[mEntryHashes[i]].fetch_add(1, std::memory_order_relaxed);
+			mEntryItems[slot] = mUnsortedItems[i];
+		}
+	});
+}
+
+void GSpatialHash::QueryNeighbors(const DirectX::XMFLOAT3& pos, float radius, const DirectX::XMFLOAT3* points, std::vector<UINT>& out) const
+{
+	DirectX::XMFLOAT3 minP(pos.x - radius, pos.y - radius, pos.z - radius);
+	DirectX::XMFLOAT3 maxP(pos.x + radius, pos.y + radius, pos.z + radius);
+
+	int cellMin[3];
+	int cellMax[3];
+	CellRange(minP, maxP, cellMin, cellMax);
+
+	float radiusSq = radius * radius;
+
+	// Several cells in range may share a bucket; visit each bucket only once.  Small queries
+	// gather their buckets on the stack, large radii fall back to the heap.
+	UINT numCells = (cellMax[0] - cellMin[0] + 1) * (cellMax[1] - cellMin[1] + 1) * (cellMax[2] - cellMin[2] + 1);
+
+	UINT localHashes[64];
+	std::vector<UINT> heapHashes;
+	UINT* hashes = localHashes;
+
+	if (numCells > 64)
+	{
+		heapHashes.resize(numCells);
+		hashes = heapHashes.data();
+	}
+
+	UINT numHashes = 0;
+	for (int z = cellMin[2]; z <= cellMax[2]; ++z)
+	{
+		for (int y = cellMin[1]; y <= cellMax[1]; ++y)
+		{
+			for (int x = cellMin[0]; x <= cellMax[0]; ++x)
+			{
+				hashes[numHashes++] = GetCellHash(x, y, z);
+			}
+		}
+	}
+
+	std::sort(hashes, hashes + numHashes);
+	numHashes = static_cast<UINT>(std::unique(hashes, hashes + numHashes) - hashes);
+
+	for (UINT b = 0; b < numHashes; ++b)
+	{
+		const UINT* items = GetBucket(hashes[b]);
+		UINT numItems = GetBucketSize(hashes[b]);
+
+		for (UINT i = 0; i < numItems; ++i)
+		{
+			const DirectX::XMFLOAT3& p = points[items[i]];
+			float dx = p.x - pos.x;
+			float dy = p.y - pos.y;
+			float dz = p.z - pos.z;
+
+			if (dx*dx + dy*dy + dz*dz <= radiusSq)
+			{
+				out.push_back(items[i]);
+			}
+		}
+	}
+}
+
+void GSpatialHash::QueryBounds(const DirectX::BoundingBox& box, std::vector<UINT>& out) const
+{
+	DirectX::XMFLOAT3 minP(box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z);
+	DirectX::XMFLOAT3 maxP(box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z);
+
+	int cellMin[3];
+	int cellMax[3];
+	CellRange(minP, maxP, cellMin, cellMax);
+
+	size_t first = out.size();
+
+	for (int z = cellMin[2]; z <= cellMax[2]; ++z)
+	{
+		for (int y = cellMin[1]; y <= cellMax[1]; ++y)
+		{
+			for (int x = cellMin[0]; x <= cellMax[0]; ++x)
+			{
+				UINT hash = GetCellHash(x, y, z);
+				out.insert(out.end(), GetBucket(hash), GetBucket(hash) + GetBucketSize(hash));
+			}
+		}
+	}
+
+	// Boxes span several cells, so the same item shows up once per shared cell.
+	std::sort(out.begin() + first, out.end());
+	out.erase(std::unique(out.begin() + first, out.end()), out.end());
+}
\ No newline at end of file
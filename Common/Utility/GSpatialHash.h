@@ -0,0 +1,70 @@
+/*  ===============================================
+	Summary: Uniform Grid Spatial Hash
+	===============================================  */
+
+#ifndef GSPATIALHASH_H
+#define GSPATIALHASH_H
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class GSpatialHash
+{
+public:
+	GSpatialHash();
+	~GSpatialHash();
+
+	// Cells are cubes of cellSize.  Cell coordinates are hashed into tableSize buckets,
+	// which is rounded up to a power of two.
+	void Init(float cellSize, UINT tableSize);
+
+	// Rebuild the table from scratch.  Points land in exactly one bucket; boxes are
+	// inserted into every cell they overlap.
+	void BuildPoints(const DirectX::XMFLOAT3* points, UINT count);
+	void BuildBounds(const DirectX::BoundingBox* boxes, UINT count);
+
+	UINT GetCellHash(const DirectX::XMFLOAT3& p) const;
+	UINT GetCellHash(int x, int y, int z) const;
+
+	// Items stored in a bucket.  A bucket may also hold items from other cells that share its hash.
+	inline UINT GetBucketSize(UINT hash) const { return mBucketStart[hash + 1] - mBucketStart[hash]; }
+	inline const UINT* GetBucket(UINT hash) const { return mEntryItems.data() + mBucketStart[hash]; }
+
+	// Appends every point within radius of pos.  Only valid after BuildPoints with the same points.
+	void QueryNeighbors(const DirectX::XMFLOAT3& pos, float radius, const DirectX::XMFLOAT3* points, std::vector<UINT>& out) const;
+
+	// Appends every item stored in the cells overlapping the box, without duplicates from shared buckets.
+	void QueryBounds(const DirectX::BoundingBox& box, std::vector<UINT>& out) const;
+
+	inline float GetCellSize() const { return mCellSize; }
+	inline UINT GetTableSize() const { return mTableSize; }
+	inline UINT GetEntryCount() const { return mEntryCount; }
+
+private:
+	void CellRange(const DirectX::XMFLOAT3& minP, const DirectX::XMFLOAT3& maxP, int cellMin[3], int cellMax[3]) const;
+	void SortEntries();
+
+private:
+	float mCellSize;
+	float mInvCellSize;
+
+	UINT mTableSize;
+	UINT mEntryCount;
+
+	// Unsorted (hash, item) pairs for the current build.
+	std::vector<UINT> mEntryHashes;
+	std::vector<UINT> mUnsortedItems;
+
+	// Items grouped by bucket after the counting sort; bucket h spans [mBucketStart[h], mBucketStart[h + 1]).
+	std::vector<UINT> mEntryItems;
+	std::vector<UINT> mBucketStart;
+
+	std::unique_ptr<std::atomic<UINT>[]> mBucketCursor;
+	std::vector<UINT> mItemOffsets;
+};
+
+#endif // GSPATIALHASH_H
\ No newline at end of file
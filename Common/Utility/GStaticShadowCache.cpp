@@ -0,0 +1,47 @@
+/*  ===============================================
+	Summary: Static Shadow Layer Cache
+	===============================================  */
+
+#include "GStaticShadowCache.h"
+
+#include <cstring>
+
+GStaticShadowCache::GStaticShadowCache()
+{
+	Invalidate();
+}
+
+GStaticShadowCache::~GStaticShadowCache()
+{
+}
+
+void GStaticShadowCache::Invalidate()
+{
+	for (UINT c = 0; c < GShadowCascades::MaxCascades; ++c)
+	{
+		mStaticValid[c] = false;
+		mSliceDirty[c] = true;
+	}
+}
+
+GStaticShadowCache::CascadeUpdate GStaticShadowCache::Update(UINT cascade, const DirectX::XMFLOAT4X4& viewProj, bool bDynamic)
+{
+	CascadeUpdate update;
+
+	// Compared bit for bit: stabilized cascades repeat their matrices exactly until they move.
+	update.bRedrawStatic = !mStaticValid[cascade] || memcmp(&viewProj, &mStaticViewProj[cascade], sizeof(viewProj)) != 0;
+	if (update.bRedrawStatic)
+	{
+		mStaticViewProj[cascade] = viewProj;
+		mStaticValid[cascade] = true;
+		mSliceDirty[cascade] = true;
+	}
+
+	// A slice that already holds exactly the static layer is left alone.
+	update.bCopyStatic = mSliceDirty[cascade] || bDynamic;
+	update.bDrawDynamic = bDynamic;
+
+	mSliceDirty[cascade] = bDynamic;
+
+	return update;
+}
\ No newline at end of file
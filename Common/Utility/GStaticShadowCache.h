@@ -0,0 +1,56 @@
+/*  ===============================================
+	Summary: Static Shadow Layer Cache
+	===============================================  */
+
+#ifndef GSTATICSHADOWCACHE_H
+#define GSTATICSHADOWCACHE_H
+
+#include "GShadowCascades.h"
+
+#include <Windows.h>
+#include <DirectXMath.h>
+
+// Decides, per cascade and frame, how much of a cascaded shadow map has to be redrawn when static
+// casters are kept in a separate depth array.  The static layer of a cascade is redrawn when its
+// view-projection changes or after Invalidate; it is copied into the shadow map slice when it was
+// redrawn or when dynamic casters were drawn on top of the slice, this frame or the last one.
+class GStaticShadowCache
+{
+public:
+	struct CascadeUpdate
+	{
+		// Clear the cascade's static layer and draw the static casters into it.
+		bool bRedrawStatic;
+
+		// Copy the static layer into the cascade's slice of the shadow map.
+		bool bCopyStatic;
+
+		// Draw the dynamic casters into the slice, on top of the static layer.
+		bool bDrawDynamic;
+	};
+
+	GStaticShadowCache();
+	~GStaticShadowCache();
+
+	// Call whenever a static caster moves or changes; light and camera changes show up in the
+	// cascades' matrices.
+	void Invalidate();
+
+	// viewProj is the cascade's View * Proj; bDynamic is whether any dynamic caster can throw a
+	// shadow into it.  Assumes the returned work is done before the next call for the cascade.
+	CascadeUpdate Update(UINT cascade, const DirectX::XMFLOAT4X4& viewProj, bool bDynamic);
+
+private:
+	GStaticShadowCache(const GStaticShadowCache&);
+	GStaticShadowCache& operator=(const GStaticShadowCache&);
+
+private:
+	// The matrices the static layer was last drawn with.
+	DirectX::XMFLOAT4X4 mStaticViewProj[GShadowCascades::MaxCascades];
+	bool mStaticValid[GShadowCascades::MaxCascades];
+
+	// Set while a slice of the shadow map holds more than its static layer.
+	bool mSliceDirty[GShadowCascades::MaxCascades];
+};
+
+#endif // GSTATICSHADOWCACHE_H
\ No newline at end of file
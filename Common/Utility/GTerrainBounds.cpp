@@ -0,0 +1,157 @@
+/*  ===============================================
+	Summary: Terrain Min/Max Height Pyramid
+	===============================================  */
+
+#include "GTerrainBounds.h"
+#include "GThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace
+{
+	const UINT RowsPerRange = 4;
+}
+
+GTerrainBounds::GTerrainBounds() :
+	mLeafCells(8),
+	mNumCellsWide(0),
+	mNumCellsDeep(0)
+{
+}
+
+GTerrainBounds::~GTerrainBounds()
+{
+}
+
+void GTerrainBounds::Build(const float* heights, UINT width, UINT depth, UINT leafCells)
+{
+	mLeafCells = leafCells;
+	mNumCellsWide = width - 1;
+	mNumCellsDeep = depth - 1;
+
+	mLevels.clear();
+
+	Level leaves;
+	leaves.Width = (mNumCellsWide + leafCells - 1) / leafCells;
+	leaves.Depth = (mNumCellsDeep + leafCells - 1) / leafCells;
+	leaves.Nodes.resize(leaves.Width * leaves.Depth);
+	mLevels.push_back(leaves);
+
+	GThreadPool& pool = GThreadPool::Get();
+
+	// A leaf covers its cells, which includes the samples on its far edges.
+	Level& base = mLevels[0];
+	pool.ParallelFor(base.Depth, RowsPerRange, [&](UINT begin, UINT end)
+	{
+		for (UINT lz = begin; lz < end; ++lz)
+		{
+			UINT z0 = lz * leafCells;
+			UINT z1 = (std::min)(z0 + leafCells, mNumCellsDeep);
+
+			for (UINT lx = 0; lx < base.Width; ++lx)
+			{
+				UINT x0 = lx * leafCells;
+				UINT x1 = (std::min)(x0 + leafCells, mNumCellsWide);
+
+				float minY = FLT_MAX;
+				float maxY = -FLT_MAX;
+
+				for (UINT z = z0; z <= z1; ++z)
+				{
+					const float* row = heights + static_cast<size_t>(z) * width;
+					for (UINT x = x0; x <= x1; ++x)
+					{
+						minY = (std::min)(minY, row[x]);
+						maxY = (std::max)(maxY, row[x]);
+					}
+				}
+
+				base.Nodes[lz * base.Width + lx] = DirectX::XMFLOAT2(minY, maxY);
+			}
+		}
+	});
+
+	// Each parent merges up to 2x2 children; odd edges have a single child column or row.
+	while (mLevels.back().Width > 1 || mLevels.back().Depth > 1)
+	{
+		Level parent;
+		parent.Width = (mLevels.back().Width + 1) / 2;
+		parent.Depth = (mLevels.back().Depth + 1) / 2;
+		parent.Nodes.resize(parent.Width * parent.Depth);
+		mLevels.push_back(parent);
+
+		const Level& child = mLevels[mLevels.size() - 2];
+		Level& level = mLevels.back();
+
+		pool.ParallelFor(level.Depth, RowsPerRange * 8, [&](UINT begin, UINT end)
+		{
+			for (UINT z = begin; z < end; ++z)
+			{
+				for (UINT x = 0; x < level.Width; ++x)
+				{
+					DirectX::XMFLOAT2 bounds(FLT_MAX, -FLT_MAX);
+
+					for (UINT cz = 2 * z; cz < (std::min)(2 * z + 2, child.Depth); ++cz)
+					{
+						for (UINT cx = 2 * x; cx < (std::min)(2 * x + 2, child.Width); ++cx)
+						{
+							const DirectX::XMFLOAT2& c = child.Nodes[cz * child.Width + cx];
+							bounds.x = (std::min)(bounds.x, c.x);
+							bounds.y = (std::max)(bounds.y, c.y);
+						}
+					}
+
+					level.Nodes[z * level.Width + x] = bounds;
+				}
+			}
+		});
+	}
+}
+
+void GTerrainBounds::MergeBounds(UINT level, UINT x, UINT z, UINT cellX0, UINT cellZ0, UINT cellX1, UINT cellZ1, DirectX::XMFLOAT2& bounds) const
+{
+	UINT nodeCells = mLeafCells << level;
+	UINT nodeX0 = x * nodeCells;
+	UINT nodeZ0 = z * nodeCells;
+	UINT nodeX1 = nodeX0 + nodeCells;
+	UINT nodeZ1 = nodeZ0 + nodeCells;
+
+	if (nodeX0 >= cellX1 || nodeZ0 >= cellZ1 || nodeX1 <= cellX0 || nodeZ1 <= cellZ0)
+	{
+		return;
+	}
+
+	bool bInside = nodeX0 >= cellX0 && nodeZ0 >= cellZ0 && (std::min)(nodeX1, mNumCellsWide) <= cellX1 && (std::min)(nodeZ1, mNumCellsDeep) <= cellZ1;
+
+	if (bInside || level == 0)
+	{
+		const DirectX::XMFLOAT2& node = GetNode(level, x, z);
+		bounds.x = (std::min)(bounds.x, node.x);
+		bounds.y = (std::max)(bounds.y, node.y);
+		return;
+	}
+
+	const Level& child = mLevels[level - 1];
+	for (UINT cz = 2 * z; cz < (std::min)(2 * z + 2, child.Depth); ++cz)
+	{
+		for (UINT cx = 2 * x; cx < (std::min)(2 * x + 2, child.Width); ++cx)
+		{
+			MergeBounds(level - 1, cx, cz, cellX0, cellZ0, cellX1, cellZ1, bounds);
+		}
+	}
+}
+
+DirectX::XMFLOAT2 GTerrainBounds::GetBounds(UINT cellX0, UINT cellZ0, UINT cellX1, UINT cellZ1) const
+{
+	DirectX::XMFLOAT2 bounds(FLT_MAX, -FLT_MAX);
+
+	if (mLevels.empty())
+	{
+		return DirectX::XMFLOAT2(0.0f, 0.0f);
+	}
+
+	MergeBounds(GetLevelCount() - 1, 0, 0, cellX0, cellZ0, (std::min)(cellX1, mNumCellsWide), (std::min)(cellZ1, mNumCellsDeep), bounds);
+
+	return bounds;
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+/*  ===============================================
+	Summary: Terrain Min/Max Height Pyramid
+	===============================================  */
+
+#ifndef GTERRAINBOUNDS_H
+#define GTERRAINBOUNDS_H
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <vector>
+
+// Quadtree of (min, max) heights over a grid heightmap.  Leaves cover leafCells x leafCells
+// cells and each level above halves the resolution, so any block of cells can be bounded
+// by visiting a handful of nodes instead of every sample.
+class GTerrainBounds
+{
+public:
+	GTerrainBounds();
+	~GTerrainBounds();
+
+	// heights holds width x depth samples row by row, i.e. (width - 1) x (depth - 1) cells.
+	void Build(const float* heights, UINT width, UINT depth, UINT leafCells = 8);
+
+	// (min, max) height over the cells [cellX0, cellX1) x [cellZ0, cellZ1).  Ranges that
+	// do not line up with leaves are rounded out, so the bounds are always conservative.
+	DirectX::XMFLOAT2 GetBounds(UINT cellX0, UINT cellZ0, UINT cellX1, UINT cellZ1) const;
+
+	inline UINT GetLevelCount() const { return static_cast<UINT>(mLevels.size()); }
+	inline UINT GetLevelWidth(UINT level) const { return mLevels[level].Width; }
+	inline UINT GetLevelDepth(UINT level) const { return mLevels[level].Depth; }
+	inline const DirectX::XMFLOAT2& GetNode(UINT level, UINT x, UINT z) const { return mLevels[level].Nodes[z * mLevels[level].Width + x]; }
+
+	inline UINT GetLeafCells() const { return mLeafCells; }
+
+private:
+	struct Level
+	{
+		UINT Width;
+		UINT Depth;
+		std::vector<DirectX::XMFLOAT2> Nodes;
+	};
+
+	void MergeBounds(UINT level, UINT x, UINT z, UINT cellX0, UINT cellZ0, UINT cellX1, UINT cellZ1, DirectX::XMFLOAT2& bounds) const;
+
+private:
+	// Level 0 holds the leaves; the last level is a single node covering the whole map.
+	std::vector<Level> mLevels;
+
+	UINT mLeafCells;
+	UINT mNumCellsWide;
+	UINT mNumCellsDeep;
+};
+
+#endif // GTERRAINBOUNDS_H
\ No newline at end of file
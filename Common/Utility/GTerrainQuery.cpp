@@ -0,0 +1,248 @@
+/*  ===============================================
+	Summary: Terrain Height and Normal Queries
+	===============================================  */
+
+#include "GTerrainQuery.h"
+
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+
+namespace
+{
+	// Corner heights and cell fractions for four points at once.
+	// A = (col, row), B = (col + 1, row), C = (col, row + 1), D = (col + 1, row + 1).
+	struct Cell4
+	{
+		__m128 A, B, C, D;
+		__m128 S, T;
+	};
+
+	struct GridParams4
+	{
+		__m128 HalfWidth, HalfDepth, InvSpacing;
+		__m128 MaxC, MaxD, MaxCol, MaxRow;
+		__m128i MaxColIndex, MaxRowIndex, Stride;
+	};
+
+	void SetGridParams(GridParams4& params, float halfWidth, float halfDepth, float invSpacing, UINT width, UINT depth)
+	{
+		params.HalfWidth = _mm_set1_ps(halfWidth);
+		params.HalfDepth = _mm_set1_ps(halfDepth);
+		params.InvSpacing = _mm_set1_ps(invSpacing);
+		params.MaxC = _mm_set1_ps(static_cast<float>(width - 1));
+		params.MaxD = _mm_set1_ps(static_cast<float>(depth - 1));
+		params.MaxCol = _mm_set1_ps(static_cast<float>(width - 2));
+		params.MaxRow = _mm_set1_ps(static_cast<float>(depth - 2));
+		params.MaxColIndex = _mm_set1_epi32(static_cast<int>(width - 2));
+		params.MaxRowIndex = _mm_set1_epi32(static_cast<int>(depth - 2));
+		params.Stride = _mm_set1_epi32(static_cast<int>(width));
+	}
+
+	// SSE2 has no 32-bit integer min or low multiply; both are built from what it has.
+	inline __m128i Min4(__m128i a, __m128i b)
+	{
+		__m128i greater = _mm_cmpgt_epi32(a, b);
+		return _mm_or_si128(_mm_and_si128(greater, b), _mm_andnot_si128(greater, a));
+	}
+
+	inline __m128i MulLo4(__m128i a, __m128i b)
+	{
+		__m128i even = _mm_mul_epu32(a, b);
+		__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	// Two horizontally adjacent heights in the low half of a register.
+	inline __m128 LoadPair(const float* p)
+	{
+		return _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(p)));
+	}
+
+	inline __m128 LoadPairs(const float* p0, const float* p1)
+	{
+		return _mm_loadh_pi(LoadPair(p0), reinterpret_cast<const __m64*>(p1));
+	}
+
+	inline void LoadCell4(const float* heights, const GridParams4& params, const float* x, const float* z, Cell4& cell)
+	{
+		__m128 zero = _mm_setzero_ps();
+
+		__m128 c = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(x), params.HalfWidth), params.InvSpacing);
+		__m128 d = _mm_mul_ps(_mm_sub_ps(params.HalfDepth, _mm_loadu_ps(z)), params.InvSpacing);
+
+		c = _mm_min_ps(_mm_max_ps(c, zero), params.MaxC);
+		d = _mm_min_ps(_mm_max_ps(d, zero), params.MaxD);
+
+		// c and d are non-negative, so truncation is floor.
+		__m128i col = Min4(_mm_cvttps_epi32(c), params.MaxColIndex);
+		__m128i row = Min4(_mm_cvttps_epi32(d), params.MaxRowIndex);
+
+		cell.S = _mm_sub_ps(c, _mm_cvtepi32_ps(col));
+		cell.T = _mm_sub_ps(d, _mm_cvtepi32_ps(row));
+
+		alignas(16) int index[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_add_epi32(MulLo4(row, params.Stride), col));
+
+		// SSE2 has no gather, but A and B, and C and D, are neighbours in memory: fetch each
+		// pair with one 64-bit load, then split the pairs into corners.
+		const float* p0 = heights + index[0];
+		const float* p1 = heights + index[1];
+		const float* p2 = heights + index[2];
+		const float* p3 = heights + index[3];
+
+		int width = _mm_cvtsi128_si32(params.Stride);
+
+		__m128 top01 = LoadPairs(p0, p1);
+		__m128 top23 = LoadPairs(p2, p3);
+		__m128 bottom01 = LoadPairs(p0 + width, p1 + width);
+		__m128 bottom23 = LoadPairs(p2 + width, p3 + width);
+
+		cell.A = _mm_shuffle_ps(top01, top23, _MM_SHUFFLE(2, 0, 2, 0));
+		cell.B = _mm_shuffle_ps(top01, top23, _MM_SHUFFLE(3, 1, 3, 1));
+		cell.C = _mm_shuffle_ps(bottom01, bottom23, _MM_SHUFFLE(2, 0, 2, 0));
+		cell.D = _mm_shuffle_ps(bottom01, bottom23, _MM_SHUFFLE(3, 1, 3, 1));
+	}
+
+	inline __m128 Lerp4(__m128 a, __m128 b, __m128 t)
+	{
+		return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+	}
+}
+
+GTerrainQuery::GTerrainQuery() :
+	mHeights(nullptr),
+	mWidth(0),
+	mDepth(0),
+	mCellSpacing(1.0f),
+	mInvCellSpacing(1.0f),
+	mHalfWidth(0.0f),
+	mHalfDepth(0.0f)
+{
+}
+
+GTerrainQuery::~GTerrainQuery()
+{
+}
+
+void GTerrainQuery::Init(const float* heights, UINT width, UINT depth, float cellSpacing)
+{
+	mHeights = heights;
+	mWidth = width;
+	mDepth = depth;
+
+	mCellSpacing = cellSpacing;
+	mInvCellSpacing = 1.0f / cellSpacing;
+	mHalfWidth = 0.5f * (width - 1) * cellSpacing;
+	mHalfDepth = 0.5f * (depth - 1) * cellSpacing;
+}
+
+void GTerrainQuery::ToGrid(float x, float z, UINT& col, UINT& row, float& s, float& t) const
+{
+	float c = (x + mHalfWidth) * mInvCellSpacing;
+	float d = (mHalfDepth - z) * mInvCellSpacing;
+
+	c = (std::min)((std::max)(c, 0.0f), static_cast<float>(mWidth - 1));
+	d = (std::min)((std::max)(d, 0.0f), static_cast<float>(mDepth - 1));
+
+	col = (std::min)(static_cast<UINT>(c), mWidth - 2);
+	row = (std::min)(static_cast<UINT>(d), mDepth - 2);
+
+	s = c - col;
+	t = d - row;
+}
+
+float GTerrainQuery::GetHeight(float x, float z) const
+{
+	UINT col, row;
+	float s, t;
+	ToGrid(x, z, col, row, s, t);
+
+	// A*--*B
+	//  |  |
+	// C*--*D
+	const float* p = mHeights + static_cast<size_t>(row) * mWidth + col;
+	float top = p[0] + (p[1] - p[0]) * s;
+	float bottom = p[mWidth] + (p[mWidth + 1] - p[mWidth]) * s;
+
+	return top + (bottom - top) * t;
+}
+
+DirectX::XMFLOAT3 GTerrainQuery::GetNormal(float x, float z) const
+{
+	UINT col, row;
+	float s, t;
+	ToGrid(x, z, col, row, s, t);
+
+	const float* p = mHeights + static_cast<size_t>(row) * mWidth + col;
+	float A = p[0];
+	float B = p[1];
+	float C = p[mWidth];
+	float D = p[mWidth + 1];
+
+	// Partial derivatives of the bilinear patch.  Rows run towards -z, hence the sign flip.
+	float dhdx = ((B - A) + ((D - C) - (B - A)) * t) * mInvCellSpacing;
+	float dhdz = -((C - A) + ((D - B) - (C - A)) * s) * mInvCellSpacing;
+
+	float invLength = 1.0f / sqrtf(dhdx * dhdx + 1.0f + dhdz * dhdz);
+	return DirectX::XMFLOAT3(-dhdx * invLength, invLength, -dhdz * invLength);
+}
+
+void GTerrainQuery::GetHeights(const float* x, const float* z, float* outY, UINT count) const
+{
+	GridParams4 params;
+	SetGridParams(params, mHalfWidth, mHalfDepth, mInvCellSpacing, mWidth, mDepth);
+
+	UINT i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		Cell4 cell;
+		LoadCell4(mHeights, params, x + i, z + i, cell);
+
+		__m128 top = Lerp4(cell.A, cell.B, cell.S);
+		__m128 bottom = Lerp4(cell.C, cell.D, cell.S);
+		_mm_storeu_ps(outY + i, Lerp4(top, bottom, cell.T));
+	}
+
+	for (; i < count; ++i)
+	{
+		outY[i] = GetHeight(x[i], z[i]);
+	}
+}
+
+void GTerrainQuery::GetNormals(const float* x, const float* z, float* outNx, float* outNy, float* outNz, UINT count) const
+{
+	GridParams4 params;
+	SetGridParams(params, mHalfWidth, mHalfDepth, mInvCellSpacing, mWidth, mDepth);
+
+	UINT i = 0;
+
+	__m128 invSpacing = _mm_set1_ps(mInvCellSpacing);
+	__m128 one = _mm_set1_ps(1.0f);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		Cell4 cell;
+		LoadCell4(mHeights, params, x + i, z + i, cell);
+
+		__m128 dhdx = _mm_mul_ps(Lerp4(_mm_sub_ps(cell.B, cell.A), _mm_sub_ps(cell.D, cell.C), cell.T), invSpacing);
+		__m128 dhdr = _mm_mul_ps(Lerp4(_mm_sub_ps(cell.C, cell.A), _mm_sub_ps(cell.D, cell.B), cell.S), invSpacing);
+
+		// n = (-dh/dx, 1, -dh/dz) with dh/dz = -dh/drow.
+		__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dhdx, dhdx), one), _mm_mul_ps(dhdr, dhdr));
+		__m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+
+		_mm_storeu_ps(outNx + i, _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(dhdx, invLength)));
+		_mm_storeu_ps(outNy + i, invLength);
+		_mm_storeu_ps(outNz + i, _mm_mul_ps(dhdr, invLength));
+	}
+
+	for (; i < count; ++i)
+	{
+		DirectX::XMFLOAT3 n = GetNormal(x[i], z[i]);
+		outNx[i] = n.x;
+		outNy[i] = n.y;
+		outNz[i] = n.z;
+	}
+}
\ No newline at end of file
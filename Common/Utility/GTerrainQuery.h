@@ -0,0 +1,50 @@
+/*  ===============================================
+	Summary: Terrain Height and Normal Queries
+	===============================================  */
+
+#ifndef GTERRAINQUERY_H
+#define GTERRAINQUERY_H
+
+#include <Windows.h>
+#include <DirectXMath.h>
+
+// Bilinear height and normal lookups on a grid heightmap laid out like the Chapter 19 terrain:
+// centred on the origin, sample (0, 0) at the (-x, +z) corner and rows running towards -z.
+// Points off the map are clamped to its edge.
+class GTerrainQuery
+{
+public:
+	GTerrainQuery();
+	~GTerrainQuery();
+
+	// The query reads heights in place; the array must outlive it.
+	void Init(const float* heights, UINT width, UINT depth, float cellSpacing);
+
+	float GetHeight(float x, float z) const;
+	DirectX::XMFLOAT3 GetNormal(float x, float z) const;
+
+	// Structure-of-arrays batches.  Points are processed four at a time with SSE2.
+	void GetHeights(const float* x, const float* z, float* outY, UINT count) const;
+	void GetNormals(const float* x, const float* z, float* outNx, float* outNy, float* outNz, UINT count) const;
+
+	inline UINT GetWidth() const { return mWidth; }
+	inline UINT GetDepth() const { return mDepth; }
+	inline float GetCellSpacing() const { return mCellSpacing; }
+
+private:
+	// Grid position of a world point, clamped so (col + 1, row + 1) stays on the map.
+	void ToGrid(float x, float z, UINT& col, UINT& row, float& s, float& t) const;
+
+private:
+	const float* mHeights;
+
+	UINT mWidth;
+	UINT mDepth;
+
+	float mCellSpacing;
+	float mInvCellSpacing;
+	float mHalfWidth;
+	float mHalfDepth;
+};
+
+#endif // GTERRAINQUERY_H
\ No newline at end of file
@@ -0,0 +1,177 @@
+/*  ===============================================
+	Summary: Sprite Texture Atlas
+	===============================================  */
+
+#include "GTextureAtlas.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace
+{
+	inline UINT AlignToBlock(UINT size)
+	{
+		return (size + 3) & ~3u;
+	}
+
+	// Places the sprites in order on shelves of the given size.  Returns false if they overflow.
+	bool PackShelves(const UINT* widths, const UINT* heights, const std::vector<UINT>& order, UINT gutter,
+		UINT atlasWidth, UINT atlasHeight, GTextureAtlas::Rect* rects)
+	{
+		UINT shelfX = 0;
+		UINT shelfY = 0;
+		UINT shelfHeight = 0;
+
+		for (size_t i = 0; i < order.size(); ++i)
+		{
+			UINT index = order[i];
+			UINT cellWidth = AlignToBlock(widths[index] + 2 * gutter);
+			UINT cellHeight = AlignToBlock(heights[index] + 2 * gutter);
+
+			if (cellWidth > atlasWidth)
+			{
+				return false;
+			}
+
+			// Start a new shelf under the current one.
+			if (shelfX + cellWidth > atlasWidth)
+			{
+				shelfY += shelfHeight;
+				shelfX = 0;
+				shelfHeight = 0;
+			}
+
+			// The first sprite on a shelf is the tallest, since they are sorted.
+			if (shelfHeight == 0)
+			{
+				shelfHeight = cellHeight;
+			}
+
+			if (shelfY + shelfHeight > atlasHeight)
+			{
+				return false;
+			}
+
+			GTextureAtlas::Rect& rect = rects[index];
+			rect.X = shelfX + gutter;
+			rect.Y = shelfY + gutter;
+			rect.Width = widths[index];
+			rect.Height = heights[index];
+
+			shelfX += cellWidth;
+		}
+
+		return true;
+	}
+}
+
+bool GTextureAtlas::Pack(const UINT* widths, const UINT* heights, UINT count, UINT gutter, UINT maxSize,
+	UINT& atlasWidth, UINT& atlasHeight, Rect* rects)
+{
+	std::vector<UINT> order(count);
+	for (UINT i = 0; i < count; ++i)
+	{
+		order[i] = i;
+	}
+
+	std::stable_sort(order.begin(), order.end(), [=](UINT a, UINT b) { return heights[a] > heights[b]; });
+
+	// Try sizes in order of area: wide rectangles first, then squares.
+	for (UINT size = 4; size <= maxSize; size *= 2)
+	{
+		if (size >= 8 && PackShelves(widths, heights, order, gutter, size, size / 2, rects))
+		{
+			atlasWidth = size;
+			atlasHeight = size / 2;
+			return true;
+		}
+
+		if (PackShelves(widths, heights, order, gutter, size, size, rects))
+		{
+			atlasWidth = size;
+			atlasHeight = size;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void GTextureAtlas::Blit(const uint8_t* src, UINT srcRowPitch, const Rect& rect, UINT gutter,
+	uint8_t* atlas, UINT atlasWidth, UINT atlasHeight, UINT atlasRowPitch)
+{
+	UINT x0 = rect.X - gutter;
+	UINT x1 = (std::min)(rect.X + rect.Width + gutter, atlasWidth);
+	UINT y0 = rect.Y - gutter;
+	UINT y1 = (std::min)(rect.Y + rect.Height + gutter, atlasHeight);
+
+	for (UINT y = y0; y < y1; ++y)
+	{
+		// Gutter rows and columns repeat the nearest edge texel.
+		UINT srcY = (std::min)((std::max)(y, rect.Y), rect.Y + rect.Height - 1) - rect.Y;
+		const uint8_t* srcRow = src + static_cast<size_t>(srcY) * srcRowPitch;
+		uint8_t* dstRow = atlas + static_cast<size_t>(y) * atlasRowPitch;
+
+		memcpy(dstRow + 4 * rect.X, srcRow, 4 * rect.Width);
+
+		for (UINT x = x0; x < rect.X; ++x)
+		{
+			memcpy(dstRow + 4 * x, srcRow, 4);
+		}
+
+		for (UINT x = rect.X + rect.Width; x < x1; ++x)
+		{
+			memcpy(dstRow + 4 * x, srcRow + 4 * (rect.Width - 1), 4);
+		}
+	}
+}
+
+bool GTextureAtlas::WriteLayout(LPCWSTR filename, UINT atlasWidth, UINT atlasHeight, const Rect* rects, UINT count)
+{
+	std::ofstream fout(filename);
+
+	if (!fout) { return false; }
+
+	fout << "AtlasSize: " << atlasWidth << " " << atlasHeight << "\n";
+	fout << "SpriteCount: " << count << "\n";
+
+	for (UINT i = 0; i < count; ++i)
+	{
+		fout << rects[i].X << " " << rects[i].Y << " " << rects[i].Width << " " << rects[i].Height << "\n";
+	}
+
+	return fout.good();
+}
+
+bool GTextureAtlas::ReadLayout(LPCWSTR filename, std::vector<DirectX::XMFLOAT4>& uvRects)
+{
+	std::ifstream fin(filename);
+
+	if (!fin) { return false; }
+
+	std::string ignore;
+	float atlasWidth = 0.0f;
+	float atlasHeight = 0.0f;
+	UINT count = 0;
+
+	fin >> ignore >> atlasWidth >> atlasHeight;
+	fin >> ignore >> count;
+
+	if (!fin || atlasWidth <= 0.0f || atlasHeight <= 0.0f)
+	{
+		return false;
+	}
+
+	uvRects.resize(count);
+	for (UINT i = 0; i < count; ++i)
+	{
+		float x, y, width, height;
+		fin >> x >> y >> width >> height;
+
+		uvRects[i] = DirectX::XMFLOAT4(x / atlasWidth, y / atlasHeight, (x + width) / atlasWidth, (y + height) / atlasHeight);
+	}
+
+	return !fin.fail();
+}
\ No newline at end of file
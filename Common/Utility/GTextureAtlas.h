@@ -0,0 +1,45 @@
+/*  ===============================================
+	Summary: Sprite Texture Atlas
+	===============================================  */
+
+#ifndef GTEXTUREATLAS_H
+#define GTEXTUREATLAS_H
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+// Packs several sprites into one texture so billboards with different images draw in a single
+// batch.  The texture is built offline (see TextureTools atlas); a small text layout next to it
+// gives each sprite's rect, which the demos read back as texture coordinates.
+class GTextureAtlas
+{
+public:
+	struct Rect
+	{
+		UINT X;
+		UINT Y;
+		UINT Width;
+		UINT Height;
+	};
+
+	// Shelf packer: sprites are placed tallest first in rows, left to right.  Every rect is
+	// surrounded by gutter texels and the padded rects cover whole 4x4 blocks, so neither
+	// filtering nor block compression mixes two sprites.  The atlas is the smallest
+	// power-of-two size up to maxSize that fits; returns false if none does.
+	static bool Pack(const UINT* widths, const UINT* heights, UINT count, UINT gutter, UINT maxSize,
+		UINT& atlasWidth, UINT& atlasHeight, Rect* rects);
+
+	// Copies an RGBA8 sprite into its rect and repeats its edge texels across the gutter.
+	static void Blit(const uint8_t* src, UINT srcRowPitch, const Rect& rect, UINT gutter,
+		uint8_t* atlas, UINT atlasWidth, UINT atlasHeight, UINT atlasRowPitch);
+
+	// The layout holds the atlas size, then "x y width height" for each sprite.
+	static bool WriteLayout(LPCWSTR filename, UINT atlasWidth, UINT atlasHeight, const Rect* rects, UINT count);
+
+	// Reads a layout back as (u0, v0, u1, v1) per sprite.
+	static bool ReadLayout(LPCWSTR filename, std::vector<DirectX::XMFLOAT4>& uvRects);
+};
+
+#endif // GTEXTUREATLAS_H
\ No newline at end of file
@@ -0,0 +1,188 @@
+/*  ===============================================
+	Summary: Shared Texture Cache
+	===============================================  */
+
+#include "GTextureCache.h"
+#include "DDSTextureLoader.h"
+#include "D3DUtil.h"
+#include "GProfiler.h"
+
+#include <cwctype>
+
+namespace
+{
+	const UINT64 DefaultBudget = 256 * 1024 * 1024;
+
+	// Number of references held on a view, found by taking and dropping one.
+	ULONG GetRefCount(IUnknown* object)
+	{
+		object->AddRef();
+		return object->Release();
+	}
+}
+
+GTextureCache::GTextureCache() :
+	mBudget(DefaultBudget),
+	mResidentBytes(0),
+	mHitCount(0),
+	mMissCount(0),
+	mEvictCount(0)
+{
+}
+
+GTextureCache::~GTextureCache()
+{
+	Clear();
+}
+
+GTextureCache& GTextureCache::Get()
+{
+	static GTextureCache cache;
+	return cache;
+}
+
+std::wstring GTextureCache::MakeKey(LPCWSTR filename, bool forceSRGB, size_t maxsize)
+{
+	WCHAR fullPath[MAX_PATH];
+	DWORD length = GetFullPathNameW(filename, MAX_PATH, fullPath, nullptr);
+
+	std::wstring key = (length > 0 && length < MAX_PATH) ? fullPath : filename;
+
+	// Windows paths are case-insensitive and accept either separator.
+	for (size_t i = 0; i < key.size(); ++i)
+	{
+		key[i] = (key[i] == L'/') ? L'\\' : static_cast<WCHAR>(towlower(key[i]));
+	}
+
+	key += forceSRGB ? L"|srgb" : L"|linear";
+	key += L"|" + std::to_wstring(maxsize);
+
+	return key;
+}
+
+HRESULT GTextureCache::Acquire(ID3D11Device* device, LPCWSTR filename, ID3D11ShaderResourceView** srv, bool forceSRGB, size_t maxsize)
+{
+	GPROFILE_SCOPE("GTextureCache::Acquire");
+
+	std::wstring key = MakeKey(filename, forceSRGB, maxsize);
+
+	*srv = Find(key);
+	if (*srv)
+	{
+		return S_OK;
+	}
+
+	DirectX::DDS_TEXTURE_DATA data;
+	HRESULT hr = DirectX::LoadDDSTextureDataFromFile(filename, data, maxsize);
+	if (SUCCEEDED(hr))
+	{
+		hr = DirectX::CreateDDSTextureFromData(device, data, D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, forceSRGB, nullptr, srv);
+	}
+
+	if (SUCCEEDED(hr))
+	{
+		Insert(key, *srv, data.bitSize);
+	}
+
+	return hr;
+}
+
+ID3D11ShaderResourceView* GTextureCache::Find(const std::wstring& key)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto it = mEntries.find(key);
+	if (it == mEntries.end())
+	{
+		++mMissCount;
+		return 0;
+	}
+
+	++mHitCount;
+	Touch(it->second);
+
+	it->second.SRV->AddRef();
+	return it->second.SRV;
+}
+
+void GTextureCache::Insert(const std::wstring& key, ID3D11ShaderResourceView* srv, UINT64 bytes)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	// Two loads of the same file raced; keep the first and let the second be released by its owners.
+	if (mEntries.find(key) != mEntries.end())
+	{
+		return;
+	}
+
+	srv->AddRef();
+
+	mLru.push_front(key);
+
+	Entry entry;
+	entry.SRV = srv;
+	entry.Bytes = bytes;
+	entry.LruPosition = mLru.begin();
+	mEntries[key] = entry;
+
+	mResidentBytes += bytes;
+
+	TrimLocked();
+}
+
+void GTextureCache::Touch(Entry& entry)
+{
+	mLru.splice(mLru.begin(), mLru, entry.LruPosition);
+}
+
+void GTextureCache::SetMemoryBudget(UINT64 bytes)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mBudget = bytes;
+	TrimLocked();
+}
+
+void GTextureCache::Trim()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	TrimLocked();
+}
+
+void GTextureCache::TrimLocked()
+{
+	// Views still bound to objects stay resident even over budget; evicting them would free
+	// nothing and only break sharing for the next load.
+	auto it = mLru.end();
+	while (mResidentBytes > mBudget && it != mLru.begin())
+	{
+		--it;
+
+		Entry& entry = mEntries[*it];
+		if (GetRefCount(entry.SRV) > 1)
+		{
+			continue;
+		}
+
+		mResidentBytes -= entry.Bytes;
+		ReleaseCOM(entry.SRV);
+		++mEvictCount;
+
+		mEntries.erase(*it);
+		it = mLru.erase(it);
+	}
+}
+
+void GTextureCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	for (auto it = mEntries.begin(); it != mEntries.end(); ++it)
+	{
+		ReleaseCOM(it->second.SRV);
+	}
+
+	mEntries.clear();
+	mLru.clear();
+	mResidentBytes = 0;
+}
\ No newline at end of file
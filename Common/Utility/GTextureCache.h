@@ -0,0 +1,84 @@
+/*  ===============================================
+	Summary: Shared Texture Cache
+	===============================================  */
+
+#ifndef GTEXTURECACHE_H
+#define GTEXTURECACHE_H
+
+#include <Windows.h>
+#include <d3d11.h>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Process-wide cache of shader resource views keyed by canonical file path and load options,
+// so objects that use the same file share one texture.  Views are handed out with a reference
+// the caller releases as usual.  Views only the cache still references are evicted, least
+// recently used first, whenever the resident size goes over the budget.
+class GTextureCache
+{
+public:
+	GTextureCache();
+	~GTextureCache();
+
+	static GTextureCache& Get();
+
+	// Key for a file and the options it is loaded with.  Paths that name the same file match.
+	static std::wstring MakeKey(LPCWSTR filename, bool forceSRGB = false, size_t maxsize = 0);
+
+	// Returns a referenced view, creating the texture on a miss.
+	HRESULT Acquire(ID3D11Device* device, LPCWSTR filename, ID3D11ShaderResourceView** srv, bool forceSRGB = false, size_t maxsize = 0);
+
+	// Returns a referenced view, or null without loading anything.  Counts a hit or a miss.
+	ID3D11ShaderResourceView* Find(const std::wstring& key);
+
+	// Adds a view created elsewhere; the cache takes its own reference.
+	void Insert(const std::wstring& key, ID3D11ShaderResourceView* srv, UINT64 bytes);
+
+	void SetMemoryBudget(UINT64 bytes);
+
+	// Evicts unreferenced views until the resident size fits the budget.
+	void Trim();
+
+	// Drops every cache reference.  Call before the device is destroyed.
+	void Clear();
+
+	inline UINT GetHitCount() const { return mHitCount; }
+	inline UINT GetMissCount() const { return mMissCount; }
+	inline UINT GetEvictCount() const { return mEvictCount; }
+	inline UINT GetTextureCount() const { return static_cast<UINT>(mEntries.size()); }
+	inline UINT64 GetResidentBytes() const { return mResidentBytes; }
+
+private:
+	struct Entry
+	{
+		ID3D11ShaderResourceView* SRV;
+		UINT64 Bytes;
+		std::list<std::wstring>::iterator LruPosition;
+	};
+
+	// Both expect mMutex to be held.
+	void Touch(Entry& entry);
+	void TrimLocked();
+
+	GTextureCache(const GTextureCache&);
+	GTextureCache& operator=(const GTextureCache&);
+
+private:
+	std::mutex mMutex;
+
+	std::unordered_map<std::wstring, Entry> mEntries;
+
+	// Most recently used key at the front.
+	std::list<std::wstring> mLru;
+
+	UINT64 mBudget;
+	UINT64 mResidentBytes;
+
+	UINT mHitCount;
+	UINT mMissCount;
+	UINT mEvictCount;
+};
+
+#endif // GTEXTURECACHE_H
\ No newline at end of file
@@ -0,0 +1,264 @@
+/*  ===============================================
+	Summary: Asynchronous DDS Texture Loader
+	===============================================  */
+
+#include "GTextureLoader.h"
+#include "GTextureCache.h"
+#include "GProfiler.h"
+#include "GThreadPool.h"
+#include "D3DUtil.h"
+
+namespace
+{
+	// Packed R8G8B8A8 placeholder colours.
+	const UINT WhiteColor = 0xffffffff;
+	const UINT FlatNormalColor = 0xffff8080;
+}
+
+GTextureLoader::GTextureLoader() :
+	mDevice(0),
+	mUploadBudget(0),
+	mMaxParsed(0),
+	mPendingCount(0),
+	mUploadCount(0),
+	mFailureCount(0),
+	mUploadedBytes(0),
+	mParsing(0)
+{
+	for (UINT i = 0; i < PLACEHOLDER_COUNT; ++i)
+	{
+		mPlaceholders[i] = 0;
+	}
+}
+
+GTextureLoader::~GTextureLoader()
+{
+	// Workers hold raw pointers into this object, so wait for the parses in flight.
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mWaiting.clear();
+		mParseDone.wait(lock, [this] { return mParsing == 0; });
+		mParsed.clear();
+	}
+
+	for (UINT i = 0; i < PLACEHOLDER_COUNT; ++i)
+	{
+		ReleaseCOM(mPlaceholders[i]);
+	}
+}
+
+bool GTextureLoader::Init(ID3D11Device* device, UINT64 uploadBudget, UINT maxParsed)
+{
+	mDevice = device;
+	mUploadBudget = uploadBudget;
+	mMaxParsed = maxParsed > 0 ? maxParsed : 1;
+
+	return CreatePlaceholder(PLACEHOLDER_WHITE, WhiteColor, false) &&
+		CreatePlaceholder(PLACEHOLDER_FLAT_NORMAL, FlatNormalColor, false) &&
+		CreatePlaceholder(PLACEHOLDER_CUBE, WhiteColor, true);
+}
+
+bool GTextureLoader::CreatePlaceholder(Placeholder placeholder, UINT color, bool bCube)
+{
+	UINT faces[6] = { color, color, color, color, color, color };
+
+	D3D11_TEXTURE2D_DESC texDesc;
+	texDesc.Width = 1;
+	texDesc.Height = 1;
+	texDesc.MipLevels = 1;
+	texDesc.ArraySize = bCube ? 6 : 1;
+	texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	texDesc.SampleDesc.Count = 1;
+	texDesc.SampleDesc.Quality = 0;
+	texDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	texDesc.CPUAccessFlags = 0;
+	texDesc.MiscFlags = bCube ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+	D3D11_SUBRESOURCE_DATA initData[6];
+	for (UINT i = 0; i < texDesc.ArraySize; ++i)
+	{
+		initData[i].pSysMem = &faces[i];
+		initData[i].SysMemPitch = sizeof(UINT);
+		initData[i].SysMemSlicePitch = sizeof(UINT);
+	}
+
+	ID3D11Texture2D* texture = 0;
+	if (FAILED(mDevice->CreateTexture2D(&texDesc, initData, &texture)))
+	{
+		return false;
+	}
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc;
+	viewDesc.Format = texDesc.Format;
+	if (bCube)
+	{
+		viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+		viewDesc.TextureCube.MostDetailedMip = 0;
+		viewDesc.TextureCube.MipLevels = 1;
+	}
+	else
+	{
+		viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		viewDesc.Texture2D.MostDetailedMip = 0;
+		viewDesc.Texture2D.MipLevels = 1;
+	}
+
+	HRESULT hr = mDevice->CreateShaderResourceView(texture, &viewDesc, &mPlaceholders[placeholder]);
+	ReleaseCOM(texture); // view saves reference
+
+	return SUCCEEDED(hr);
+}
+
+std::shared_future<HRESULT> GTextureLoader::Load(LPCWSTR filename, ID3D11ShaderResourceView** srv, Placeholder placeholder)
+{
+	std::wstring key = GTextureCache::MakeKey(filename);
+
+	*srv = GTextureCache::Get().Find(key);
+	if (*srv)
+	{
+		std::promise<HRESULT> loaded;
+		loaded.set_value(S_OK);
+		return loaded.get_future().share();
+	}
+
+	*srv = mPlaceholders[placeholder];
+	if (*srv)
+	{
+		(*srv)->AddRef();
+	}
+
+	// Share a load that is already on its way.
+	auto inFlight = mInFlight.find(key);
+	if (inFlight != mInFlight.end())
+	{
+		inFlight->second->Slots.push_back(srv);
+		return inFlight->second->Future;
+	}
+
+	std::unique_ptr<Request> request(new Request);
+	request->Filename = filename;
+	request->Key = key;
+	request->Slots.push_back(srv);
+	request->Result = E_PENDING;
+	request->Future = request->Promise.get_future().share();
+
+	std::shared_future<HRESULT> result = request->Future;
+
+	mInFlight[key] = request.get();
+	++mPendingCount;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mWaiting.push_back(std::move(request));
+	StartParses();
+
+	return result;
+}
+
+bool GTextureLoader::IsQueueFull() const
+{
+	return mParsing + mParsed.size() >= mMaxParsed;
+}
+
+void GTextureLoader::StartParses()
+{
+	while (!mWaiting.empty() && !IsQueueFull())
+	{
+		Request* request = mWaiting.front().release();
+		mWaiting.pop_front();
+		++mParsing;
+
+		GThreadPool::Get().Submit([this, request] { Parse(request); });
+	}
+}
+
+void GTextureLoader::Parse(Request* request)
+{
+	GPROFILE_SCOPE("GTextureLoader::Parse");
+
+	request->Result = DirectX::LoadDDSTextureDataFromFile(request->Filename.c_str(), request->Data);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mParsed.push_back(std::unique_ptr<Request>(request));
+	--mParsing;
+	mParseDone.notify_all();
+}
+
+void GTextureLoader::ProcessUploads()
+{
+	UINT64 bytes = 0;
+
+	for (;;)
+	{
+		std::unique_ptr<Request> request;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			if (mParsed.empty() || (bytes > 0 && bytes + mParsed.front()->Data.bitSize > mUploadBudget))
+			{
+				break;
+			}
+
+			request = std::move(mParsed.front());
+			mParsed.pop_front();
+
+			// A queue slot just opened up.
+			StartParses();
+		}
+
+		bytes += Upload(*request);
+	}
+}
+
+UINT64 GTextureLoader::Upload(Request& request)
+{
+	GPROFILE_SCOPE("GTextureLoader::Upload");
+
+	mInFlight.erase(request.Key);
+	--mPendingCount;
+
+	HRESULT hr = request.Result;
+	ID3D11ShaderResourceView* srv = 0;
+
+	if (SUCCEEDED(hr))
+	{
+		hr = DirectX::CreateDDSTextureFromData(mDevice, request.Data, D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, false, nullptr, &srv);
+	}
+
+	if (FAILED(hr))
+	{
+		++mFailureCount;
+		request.Promise.set_value(hr);
+		return 0;
+	}
+
+	GTextureCache::Get().Insert(request.Key, srv, request.Data.bitSize);
+
+	for (size_t i = 0; i < request.Slots.size(); ++i)
+	{
+		ID3D11ShaderResourceView*& slot = *request.Slots[i];
+		ReleaseCOM(slot);
+		slot = srv;
+		slot->AddRef();
+	}
+	ReleaseCOM(srv);
+
+	++mUploadCount;
+	mUploadedBytes += request.Data.bitSize;
+
+	request.Promise.set_value(hr);
+	return request.Data.bitSize;
+}
+
+void GTextureLoader::Flush()
+{
+	while (mPendingCount > 0)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mParseDone.wait(lock, [this] { return !mParsed.empty(); });
+		}
+
+		ProcessUploads();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+/*  ===============================================
+	Summary: Asynchronous DDS Texture Loader
+	===============================================  */
+
+#ifndef GTEXTURELOADER_H
+#define GTEXTURELOADER_H
+
+#include "DDSTextureLoader.h"
+
+#include <Windows.h>
+#include <d3d11.h>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Loads DDS files without stalling the frame.  Pool workers read and parse files in parallel;
+// the device thread then creates the textures in ProcessUploads, spending at most a fixed number
+// of bytes per call.  Until its texture arrives, a slot holds a 1x1 placeholder view.
+// Textures go through GTextureCache, so every slot asking for the same file shares one texture.
+class GTextureLoader
+{
+public:
+	enum Placeholder
+	{
+		PLACEHOLDER_WHITE,
+		PLACEHOLDER_FLAT_NORMAL,
+		PLACEHOLDER_CUBE,
+		PLACEHOLDER_COUNT,
+	};
+
+	GTextureLoader();
+	~GTextureLoader();
+
+	// At most maxParsed files are parsed but not yet uploaded at a time, which bounds the
+	// memory held by the queue.
+	bool Init(ID3D11Device* device, UINT64 uploadBudget = 32 * 1024 * 1024, UINT maxParsed = 8);
+
+	// Stores a referenced placeholder in *srv and queues the file, unless the cache already holds it.
+	// When the texture is created the placeholder reference is released and replaced, so *srv must
+	// stay valid until the future is ready.
+	// On failure the placeholder is left in place and the future holds the error.
+	std::shared_future<HRESULT> Load(LPCWSTR filename, ID3D11ShaderResourceView** srv, Placeholder placeholder = PLACEHOLDER_WHITE);
+
+	// Creates textures for parsed files until the upload budget is spent; always makes progress
+	// on at least one.  Call once per frame from the thread that owns the device.
+	void ProcessUploads();
+
+	// Blocks until every queued texture has been created.
+	void Flush();
+
+	inline UINT GetPendingCount() const { return mPendingCount; }
+	inline UINT GetUploadCount() const { return mUploadCount; }
+	inline UINT GetFailureCount() const { return mFailureCount; }
+	inline UINT64 GetUploadedBytes() const { return mUploadedBytes; }
+
+private:
+	struct Request
+	{
+		std::wstring Filename;
+		std::wstring Key;
+		std::vector<ID3D11ShaderResourceView**> Slots;
+		std::promise<HRESULT> Promise;
+		std::shared_future<HRESULT> Future;
+		DirectX::DDS_TEXTURE_DATA Data;
+		HRESULT Result;
+	};
+
+	bool CreatePlaceholder(Placeholder placeholder, UINT color, bool bCube);
+
+	// Both expect mMutex to be held.
+	void StartParses();
+	bool IsQueueFull() const;
+
+	void Parse(Request* request);
+	UINT64 Upload(Request& request);
+
+	GTextureLoader(const GTextureLoader&);
+	GTextureLoader& operator=(const GTextureLoader&);
+
+private:
+	ID3D11Device* mDevice;
+	ID3D11ShaderResourceView* mPlaceholders[PLACEHOLDER_COUNT];
+
+	UINT64 mUploadBudget;
+	UINT mMaxParsed;
+
+	// Only touched by the device thread.  Requests not yet uploaded, by cache key.
+	std::unordered_map<std::wstring, Request*> mInFlight;
+	UINT mPendingCount;
+	UINT mUploadCount;
+	UINT mFailureCount;
+	UINT64 mUploadedBytes;
+
+	// Shared with the pool workers, guarded by mMutex.
+	std::mutex mMutex;
+	std::condition_variable mParseDone;
+	std::deque<std::unique_ptr<Request>> mWaiting;
+	std::deque<std::unique_ptr<Request>> mParsed;
+	UINT mParsing;
+};
+
+#endif // GTEXTURELOADER_H
\ No newline at end of file
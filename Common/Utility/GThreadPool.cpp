@@ -0,0 +1,200 @@
+/*  ===========================================
+	Summary: Fixed-Size Worker Thread Pool
+	===========================================  */
+
+#include "GThreadPool.h"
+#include "GProfiler.h"
+
+#include <memory>
+
+namespace
+{
+	// Shared between the caller of Dispatch and the helper tasks it queues.  Helpers that
+	// start after every job has been claimed still touch this, so it must outlive the call.
+	struct DispatchState
+	{
+		std::function<void(UINT)> Job;
+		UINT NumJobs;
+		std::atomic<UINT> NextJob;
+		std::atomic<UINT> JobsDone;
+		std::mutex DoneMutex;
+		std::condition_variable DoneCondition;
+	};
+
+	void RunDispatchJobs(DispatchState& state)
+	{
+		UINT finished = 0;
+
+		for (;;)
+		{
+			UINT i = state.NextJob.fetch_add(1);
+			if (i >= state.NumJobs)
+			{
+				break;
+			}
+
+			state.Job(i);
+			++finished;
+		}
+
+		if (finished > 0 && state.JobsDone.fetch_add(finished) + finished == state.NumJobs)
+		{
+			std::lock_guard<std::mutex> lock(state.DoneMutex);
+			state.DoneCondition.notify_all();
+		}
+	}
+}
+
+GThreadPool::GThreadPool(UINT numWorkers) :
+	mShutdown(false)
+{
+	if (numWorkers == 0)
+	{
+		UINT hardwareThreads = std::thread::hardware_concurrency();
+		numWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	mWorkers.reserve(numWorkers);
+	for (UINT i = 0; i < numWorkers; ++i)
+	{
+		mWorkers.push_back(std::thread(&GThreadPool::WorkerLoop, this));
+	}
+}
+
+GThreadPool::~GThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mShutdown = true;
+	}
+
+	mCondition.notify_all();
+
+	for (size_t i = 0; i < mWorkers.size(); ++i)
+	{
+		mWorkers[i].join();
+	}
+}
+
+GThreadPool& GThreadPool::Get()
+{
+	static GThreadPool pool;
+	return pool;
+}
+
+UINT GThreadPool::GetThreadCount() const
+{
+	return static_cast<UINT>(mWorkers.size()) + 1;
+}
+
+void GThreadPool::WorkerLoop()
+{
+	GPROFILE_THREAD("Worker");
+
+	for (;;)
+	{
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this] { return mShutdown || !mTasks.empty(); });
+
+			if (mShutdown && mTasks.empty())
+			{
+				return;
+			}
+
+			task = std::move(mTasks.front());
+			mTasks.pop_front();
+		}
+
+		task();
+	}
+}
+
+void GThreadPool::Dispatch(UINT numJobs, const std::function<void(UINT)>& job)
+{
+	if (numJobs == 0)
+	{
+		return;
+	}
+
+	if (numJobs == 1)
+	{
+		job(0);
+		return;
+	}
+
+	std::shared_ptr<DispatchState> state = std::make_shared<DispatchState>();
+	state->Job = job;
+	state->NumJobs = numJobs;
+	state->NextJob = 0;
+	state->JobsDone = 0;
+
+	// One helper per worker is enough; each helper keeps claiming jobs until none are left.
+	UINT numHelpers = numJobs - 1 < mWorkers.size() ? numJobs - 1 : static_cast<UINT>(mWorkers.size());
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (UINT i = 0; i < numHelpers; ++i)
+		{
+			mTasks.push_back([state] { RunDispatchJobs(*state); });
+		}
+	}
+
+	mCondition.notify_all();
+
+	RunDispatchJobs(*state);
+
+	std::unique_lock<std::mutex> lock(state->DoneMutex);
+	state->DoneCondition.wait(lock, [&state] { return state->JobsDone.load() == state->NumJobs; });
+}
+
+void GThreadPool::ParallelFor(UINT count, UINT grainSize, const std::function<void(UINT, UINT)>& func)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (grainSize == 0)
+	{
+		grainSize = 1;
+	}
+
+	// Aim for a few ranges per thread so uneven ranges still balance out.
+	UINT numRanges = GetThreadCount() * 4;
+	UINT maxRanges = (count + grainSize - 1) / grainSize;
+	if (numRanges > maxRanges)
+	{
+		numRanges = maxRanges;
+	}
+
+	UINT rangeSize = (count + numRanges - 1) / numRanges;
+
+	Dispatch(numRanges, [&](UINT range)
+	{
+		UINT begin = range * rangeSize;
+		UINT end = begin + rangeSize < count ? begin + rangeSize : count;
+
+		if (begin < end)
+		{
+			func(begin, end);
+		}
+	});
+}
+
+std::future<void> GThreadPool::Submit(std::function<void()> task)
+{
+	std::shared_ptr<std::packaged_task<void()>> packaged = std::make_shared<std::packaged_task<void()>>(std::move(task));
+	std::future<void> result = packaged->get_future();
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mTasks.push_back([packaged] { (*packaged)(); });
+	}
+
+	mCondition.notify_one();
+
+	return result;
+}
\ No newline at end of file
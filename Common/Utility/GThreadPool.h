@@ -0,0 +1,57 @@
+/*  ===========================================
+	Summary: Fixed-Size Worker Thread Pool
+	===========================================  */
+
+#ifndef GTHREADPOOL_H
+#define GTHREADPOOL_H
+
+#include <Windows.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class GThreadPool
+{
+public:
+	// A thread count of 0 creates one worker per hardware thread, minus the calling thread.
+	GThreadPool(UINT numWorkers = 0);
+	~GThreadPool();
+
+	// Process-wide pool shared by the utility classes.
+	static GThreadPool& Get();
+
+	// Number of threads that take part in Dispatch, including the calling thread.
+	UINT GetThreadCount() const;
+
+	// Runs job(i) for every i in [0, numJobs) and blocks until all jobs have finished.
+	// The calling thread works on jobs too, so Dispatch may be nested inside a job.
+	void Dispatch(UINT numJobs, const std::function<void(UINT)>& job);
+
+	// Splits [0, count) into ranges of at least grainSize elements and runs func(begin, end) on each.
+	void ParallelFor(UINT count, UINT grainSize, const std::function<void(UINT, UINT)>& func);
+
+	// Queues a task to run on a worker thread without waiting for it.
+	std::future<void> Submit(std::function<void()> task);
+
+private:
+	void WorkerLoop();
+
+	GThreadPool(const GThreadPool&);
+	GThreadPool& operator=(const GThreadPool&);
+
+private:
+	std::vector<std::thread> mWorkers;
+	std::deque<std::function<void()>> mTasks;
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+
+	bool mShutdown;
+};
+
+#endif // GTHREADPOOL_H
\ No newline at end of file
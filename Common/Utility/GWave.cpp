@@ -11,6 +11,8 @@ GWave::GWave() : GObject()
 	mVertexCount = mWaves.VertexCount();
 	mIndexCount = mWaves.TriangleCount() * 3;
 
+	mPrevHeights.assign(mVertexCount, 0.0f);
+
 	mVertices.resize(mVertexCount);
 	mIndices.resize(mIndexCount);
 	UINT m = mWaves.RowCount();
@@ -37,8 +39,15 @@ GWave::~GWave()
 {
 }
 
-void GWave::Update(float currentTime, float dt, void* data)
+void GWave::Update(float currentTime, float dt)
 {
+	// The simulation steps on its own clock, so remember where the surface was when this step
+	// began; WriteVertices blends from here.
+	for (UINT i = 0; i < mWaves.VertexCount(); ++i)
+	{
+		mPrevHeights[i] = GetHeight(i);
+	}
+
 	static float t_base = 0.0f;
 	if ((currentTime - t_base) >= 0.1f)
 	{
@@ -53,17 +62,6 @@ void GWave::Update(float currentTime, float dt, void* data)
 	}
 	mWaves.Update(dt);
 
-	Vertex* v = reinterpret_cast<Vertex*>(data);
-	for (UINT i = 0; i < mWaves.VertexCount(); ++i)
-	{
-		v[i].Pos = mWaves[i];
-		v[i].Normal = mWaves.Normal(i);
-
-		// Derive tex-coords in [0,1] from position.
-		v[i].Tex.x = 0.5f + mWaves[i].x / mWaves.Width();
-		v[i].Tex.y = 0.5f - mWaves[i].z / mWaves.Depth();
-	}
-
 	// Tile water texture.
 	DirectX::XMMATRIX wavesScale = DirectX::XMMatrixScaling(5.0f, 5.0f, 0.0f);
 
@@ -75,3 +73,33 @@ void GWave::Update(float currentTime, float dt, void* data)
 	// Combine scale and translation.
 	XMStoreFloat4x4(&mTexTransform, wavesScale*wavesOffset);
 }
+
+float GWave::GetHeight(UINT i) const
+{
+	float prev = mWaves.Previous(i).y;
+	return prev + (mWaves[i].y - prev)*mWaves.StepAlpha();
+}
+
+void GWave::WriteVertices(void* data, float alpha) const
+{
+	Vertex* v = reinterpret_cast<Vertex*>(data);
+	for (UINT i = 0; i < mWaves.VertexCount(); ++i)
+	{
+		const DirectX::XMFLOAT3& curr = mWaves[i];
+
+		// Only the height changes between steps.
+		float prevHeight = mPrevHeights[i];
+		v[i].Pos = DirectX::XMFLOAT3(curr.x, prevHeight + (GetHeight(i) - prevHeight)*alpha, curr.z);
+		v[i].Normal = mWaves.Normal(i);
+
+		// Derive tex-coords in [0,1] from position.
+		v[i].Tex.x = 0.5f + curr.x / mWaves.Width();
+		v[i].Tex.y = 0.5f - curr.z / mWaves.Depth();
+	}
+}
+
+void GWave::Update(float currentTime, float dt, void* data)
+{
+	Update(currentTime, dt);
+	WriteVertices(data, 1.0f);
+}
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "Waves.h"
 #include "MathHelper.h"
 #include "D3DUtil.h"
+#include <vector>
 
 __declspec(align(16))
 class GWave : public GObject
@@ -20,11 +21,25 @@ public:
 	void* operator new(size_t i) { return _mm_malloc(i,16);	}
 	void operator delete(void* p) { _mm_free(p); }
 
+	// Advances the simulation by one caller step; the vertices are not touched.
+	void Update(float currentTime, float dt);
+
+	// Writes the surface alpha of the way from its state before the last Update to its state
+	// after it.  Pass the frame scheduler's alpha so the water moves with everything else.
+	void WriteVertices(void* data, float alpha) const;
+
 	void Update(float currentTime, float dt, void* data);
 
+private:
+	// Surface height as of now, between the simulation's last two steps.
+	float GetHeight(UINT i) const;
+
 private:
 	Waves mWaves;
 
+	// Heights at the start of the last Update.
+	std::vector<float> mPrevHeights;
+
 	DirectX::XMFLOAT2 mWaterTexOffset;
 };
 
@@ -4,20 +4,22 @@
 
 #include "GameTimer.h"
 
-#include <Windows.h>
+namespace
+{
+	float ToSeconds(GameTimer::Clock::duration duration)
+	{
+		return std::chrono::duration<float>(duration).count();
+	}
+}
 
 GameTimer::GameTimer() : 
-	mSecondsPerCount(0.0), 
 	mDeltaTime(-1.0), 
-	mBaseTime(0),	
-	mPausedTime(0), 
-	mPrevTime(0), 
-	mCurrTime(0), 
+	mPausedTime(Clock::duration::zero()), 
 	mStopped(false)
 {
-	__int64 countsPerSec;
-	QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
-	mSecondsPerCount = 1.0 / (double)countsPerSec;
+	// steady_clock never jumps with wall-clock changes and, like the performance counter it
+	// replaces, has sub-microsecond resolution on Windows.
+	Reset(Clock::now());
 }
 
 // Returns the total time elapsed since Reset() was called, NOT counting any
@@ -35,7 +37,7 @@ float GameTimer::TotalTime() const
 
 	if (mStopped)
 	{
-		return (float)(((mStopTime - mPausedTime) - mBaseTime)*mSecondsPerCount);
+		return ToSeconds((mStopTime - mPausedTime) - mBaseTime);
 	}
 
 	// The distance mCurrTime - mBaseTime includes paused time,
@@ -50,7 +52,7 @@ float GameTimer::TotalTime() const
 
 	else
 	{
-		return (float)(((mCurrTime - mPausedTime) - mBaseTime)*mSecondsPerCount);
+		return ToSeconds((mCurrTime - mPausedTime) - mBaseTime);
 	}
 }
 
@@ -61,20 +63,36 @@ float GameTimer::DeltaTime() const
 
 void GameTimer::Reset()
 {
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
-
-	mBaseTime = currTime;
-	mPrevTime = currTime;
-	mStopTime = 0;
-	mStopped = false;
+	Reset(Clock::now());
 }
 
 void GameTimer::Start()
 {
-	__int64 startTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+	Start(Clock::now());
+}
+
+void GameTimer::Stop()
+{
+	Stop(Clock::now());
+}
 
+void GameTimer::Tick()
+{
+	Tick(Clock::now());
+}
+
+void GameTimer::Reset(Clock::time_point now)
+{
+	mBaseTime = now;
+	mPrevTime = now;
+	mCurrTime = now;
+	mStopTime = now;
+	mPausedTime = Clock::duration::zero();
+	mStopped = false;
+}
+
+void GameTimer::Start(Clock::time_point startTime)
+{
 	// Accumulate the time elapsed between stop and start pairs.
 	//
 	//                     |<-------d------->|
@@ -86,24 +104,20 @@ void GameTimer::Start()
 		mPausedTime += (startTime - mStopTime);
 
 		mPrevTime = startTime;
-		mStopTime = 0;
 		mStopped = false;
 	}
 }
 
-void GameTimer::Stop()
+void GameTimer::Stop(Clock::time_point currTime)
 {
 	if (!mStopped)
 	{
-		__int64 currTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
-
 		mStopTime = currTime;
 		mStopped = true;
 	}
 }
 
-void GameTimer::Tick()
+void GameTimer::Tick(Clock::time_point currTime)
 {
 	if (mStopped)
 	{
@@ -111,12 +125,10 @@ void GameTimer::Tick()
 		return;
 	}
 
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
 	mCurrTime = currTime;
 
 	// Time difference between this frame and the previous.
-	mDeltaTime = (mCurrTime - mPrevTime)*mSecondsPerCount;
+	mDeltaTime = std::chrono::duration<double>(mCurrTime - mPrevTime).count();
 
 	// Prepare for next frame.
 	mPrevTime = mCurrTime;
@@ -5,9 +5,13 @@
 #ifndef GAMETIMER_H
 #define GAMETIMER_H
 
+#include <chrono>
+
 class GameTimer
 {
 public:
+	typedef std::chrono::steady_clock Clock;
+
 	GameTimer();
 
 	float TotalTime() const;  // in seconds
@@ -18,15 +22,20 @@ public:
 	void Stop();  // Call when paused.
 	void Tick();  // Call every frame.
 
+	// The same, at a given time rather than now, so the timer can run on a fake clock.
+	void Reset(Clock::time_point now);
+	void Start(Clock::time_point now);
+	void Stop(Clock::time_point now);
+	void Tick(Clock::time_point now);
+
 private:
-	double mSecondsPerCount;
 	double mDeltaTime;
 
-	__int64 mBaseTime;
-	__int64 mPausedTime;
-	__int64 mStopTime;
-	__int64 mPrevTime;
-	__int64 mCurrTime;
+	Clock::time_point mBaseTime;
+	Clock::duration mPausedTime;
+	Clock::time_point mStopTime;
+	Clock::time_point mPrevTime;
+	Clock::time_point mCurrTime;
 
 	bool mStopped;
 };
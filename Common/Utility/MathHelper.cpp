@@ -77,4 +77,35 @@ DirectX::XMVECTOR MathHelper::RandHemisphereUnitVec3(DirectX::XMVECTOR n)
 
 		return DirectX::XMVector3Normalize(v);
 	}
+}
+
+void MathHelper::ExtractFrustumPlanes(DirectX::XMFLOAT4 planes[6], DirectX::CXMMATRIX M)
+{
+	DirectX::XMFLOAT4X4 m;
+	DirectX::XMStoreFloat4x4(&m, M);
+
+	// Left
+	planes[0] = DirectX::XMFLOAT4(m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41);
+
+	// Right
+	planes[1] = DirectX::XMFLOAT4(m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41);
+
+	// Bottom
+	planes[2] = DirectX::XMFLOAT4(m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42);
+
+	// Top
+	planes[3] = DirectX::XMFLOAT4(m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42);
+
+	// Near
+	planes[4] = DirectX::XMFLOAT4(m._13, m._23, m._33, m._43);
+
+	// Far
+	planes[5] = DirectX::XMFLOAT4(m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43);
+
+	// Normalize the plane equations.
+	for(int i = 0; i < 6; ++i)
+	{
+		DirectX::XMVECTOR v = DirectX::XMPlaneNormalize(DirectX::XMLoadFloat4(&planes[i]));
+		DirectX::XMStoreFloat4(&planes[i], v);
+	}
 }
\ No newline at end of file
@@ -68,6 +68,10 @@ public:
 	static DirectX::XMVECTOR RandUnitVec3();
 	static DirectX::XMVECTOR RandHemisphereUnitVec3(DirectX::XMVECTOR n);
 
+	// Extracts the normalized left, right, bottom, top, near and far planes of the frustum
+	// described by M, with normals pointing inward.  Pass ViewProj for world space planes.
+	static void ExtractFrustumPlanes(DirectX::XMFLOAT4 planes[6], DirectX::CXMMATRIX M);
+
 	static const float Infinity;
 	static const float Pi;
 
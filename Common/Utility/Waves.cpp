@@ -3,13 +3,20 @@
 //***************************************************************************************
 
 #include "Waves.h"
+#include "GProfiler.h"
 #include <algorithm>
 #include <vector>
 #include <cassert>
 
+namespace
+{
+	// Most simulation steps taken in one Update; time beyond that is dropped.
+	const float MaxStepsPerUpdate = 4.0f;
+}
+
 Waves::Waves()
 : mNumRows(0), mNumCols(0), mVertexCount(0), mTriangleCount(0), 
-  mK1(0.0f), mK2(0.0f), mK3(0.0f), mTimeStep(0.0f), mSpatialStep(0.0f),
+  mK1(0.0f), mK2(0.0f), mK3(0.0f), mTimeStep(0.0f), mSpatialStep(0.0f), mAccumulatedTime(0.0f),
   mPrevSolution(0), mCurrSolution(0), mNormals(0), mTangentX(0)
 {
 }
@@ -62,6 +69,7 @@ void Waves::Init(UINT m, UINT n, float dx, float dt, float speed, float damping)
 
 	mTimeStep    = dt;
 	mSpatialStep = dx;
+	mAccumulatedTime = 0.0f;
 
 	float d = damping*dt+2.0f;
 	float e = (speed*speed)*(dt*dt)/(dx*dx);
@@ -101,13 +109,20 @@ void Waves::Init(UINT m, UINT n, float dx, float dt, float speed, float damping)
 
 void Waves::Update(float dt)
 {
-	static float t = 0;
+	GPROFILE_SCOPE("Waves::Update");
 
-	// Accumulate time.
-	t += dt;
+	// Accumulate time.  After a long frame only a few steps are taken and the rest is dropped,
+	// so one stall does not make every following frame slower.
+	mAccumulatedTime = (std::min)(mAccumulatedTime + dt, MaxStepsPerUpdate*mTimeStep);
+
+	if( mAccumulatedTime < mTimeStep )
+	{
+		return;
+	}
 
-	// Only update the simulation at the specified time step.
-	if( t >= mTimeStep )
+	// Take as many steps of the specified size as the time covers, so the waves move at the same
+	// speed whatever the frame rate.
+	while( mAccumulatedTime >= mTimeStep )
 	{
 		// Only update interior points; we use zero boundary conditions.
 		for(UINT i = 1; i < mNumRows-1; ++i)
@@ -138,30 +153,30 @@ void Waves::Update(float dt)
 		// current solution becomes the new previous solution.
 		std::swap(mPrevSolution, mCurrSolution);
 
-		t = 0.0f; // reset time
+		mAccumulatedTime -= mTimeStep; // keep the remainder
+	}
 
-		//
-		// Compute normals using finite difference scheme.
-		//
-		for(UINT i = 1; i < mNumRows-1; ++i)
+	//
+	// Compute normals using finite difference scheme.
+	//
+	for(UINT i = 1; i < mNumRows-1; ++i)
+	{
+		for(UINT j = 1; j < mNumCols-1; ++j)
 		{
-			for(UINT j = 1; j < mNumCols-1; ++j)
-			{
-				float l = mCurrSolution[i*mNumCols+j-1].y;
-				float r = mCurrSolution[i*mNumCols+j+1].y;
-				float t = mCurrSolution[(i-1)*mNumCols+j].y;
-				float b = mCurrSolution[(i+1)*mNumCols+j].y;
-				mNormals[i*mNumCols+j].x = -r+l;
-				mNormals[i*mNumCols+j].y = 2.0f*mSpatialStep;
-				mNormals[i*mNumCols+j].z = b-t;
-
-				DirectX::XMVECTOR n = DirectX::XMVector3Normalize(XMLoadFloat3(&mNormals[i*mNumCols+j]));
-				XMStoreFloat3(&mNormals[i*mNumCols+j], n);
-
-				mTangentX[i*mNumCols+j] = DirectX::XMFLOAT3(2.0f*mSpatialStep, r-l, 0.0f);
-				DirectX::XMVECTOR T = DirectX::XMVector3Normalize(XMLoadFloat3(&mTangentX[i*mNumCols+j]));
-				XMStoreFloat3(&mTangentX[i*mNumCols+j], T);
-			}
+			float l = mCurrSolution[i*mNumCols+j-1].y;
+			float r = mCurrSolution[i*mNumCols+j+1].y;
+			float t = mCurrSolution[(i-1)*mNumCols+j].y;
+			float b = mCurrSolution[(i+1)*mNumCols+j].y;
+			mNormals[i*mNumCols+j].x = -r+l;
+			mNormals[i*mNumCols+j].y = 2.0f*mSpatialStep;
+			mNormals[i*mNumCols+j].z = b-t;
+
+			DirectX::XMVECTOR n = DirectX::XMVector3Normalize(XMLoadFloat3(&mNormals[i*mNumCols+j]));
+			XMStoreFloat3(&mNormals[i*mNumCols+j], n);
+
+			mTangentX[i*mNumCols+j] = DirectX::XMFLOAT3(2.0f*mSpatialStep, r-l, 0.0f);
+			DirectX::XMVECTOR T = DirectX::XMVector3Normalize(XMLoadFloat3(&mTangentX[i*mNumCols+j]));
+			XMStoreFloat3(&mTangentX[i*mNumCols+j], T);
 		}
 	}
 }
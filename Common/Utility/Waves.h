@@ -28,6 +28,13 @@ public:
 	// Returns the solution at the ith grid point.
 	const DirectX::XMFLOAT3& operator[](int i)const { return mCurrSolution[i]; }
 
+	// Returns the solution one step before the current one at the ith grid point.
+	const DirectX::XMFLOAT3& Previous(int i)const { return mPrevSolution[i]; }
+
+	// Returns how much time has passed since the current solution, as a fraction of a time step.
+	// Drawing Previous blended toward the current solution by this moves smoothly at any frame rate.
+	float StepAlpha()const { return mTimeStep > 0.0f ? mAccumulatedTime/mTimeStep : 1.0f; }
+
 	// Returns the solution normal at the ith grid point.
 	const DirectX::XMFLOAT3& Normal(int i)const { return mNormals[i]; }
 
@@ -53,6 +60,9 @@ private:
 	float mTimeStep;
 	float mSpatialStep;
 
+	// Time not yet simulated, less than a time step after Update.
+	float mAccumulatedTime;
+
 	DirectX::XMFLOAT3* mPrevSolution;
 	DirectX::XMFLOAT3* mCurrSolution;
 	DirectX::XMFLOAT3* mNormals;
@@ -0,0 +1,322 @@
+/*  ===============================================
+	Summary: Block Compressor Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GBlockCompressor.h"
+#include "GThreadPool.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	const uint32_t ColorCodes[4] = { 0, 2, 3, 1 };
+	const uint32_t AlphaCodes[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+
+	void Unpack565(uint16_t v, int* c)
+	{
+		int r = (v >> 11) & 31;
+		int g = (v >> 5) & 63;
+		int b = v & 31;
+		c[0] = (r << 3) | (r >> 2);
+		c[1] = (g << 2) | (g >> 4);
+		c[2] = (b << 3) | (b >> 2);
+	}
+
+	// Scalar projection of every texel onto the axis from e0 to e1, as index codes for a block
+	// whose endpoints are stored in that order (flip 0) or swapped (flip 1).
+	uint32_t ProjectIndices(const uint8_t* block, const int* e0, const int* e1, uint32_t flip)
+	{
+		int d[3] = { e1[0] - e0[0], e1[1] - e0[1], e1[2] - e0[2] };
+		int lengthSq = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+
+		float origin = static_cast<float>(e0[0] * d[0] + e0[1] * d[1] + e0[2] * d[2]);
+		float scale = 3.0f / lengthSq;
+
+		uint32_t indices = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			const uint8_t* t = block + 4 * i;
+			float dot = static_cast<float>(t[0] * d[0] + t[1] * d[1] + t[2] * d[2]);
+			float step = (std::min)((std::max)((dot - origin) * scale, 0.0f), 3.0f);
+			indices |= (ColorCodes[static_cast<int>(nearbyintf(step))] ^ flip) << (2 * i);
+		}
+		return indices;
+	}
+
+	// Whether the colour indices are the ones the scalar projection gives for the endpoints the
+	// SSE2 encoder chose.  The encoder projects before putting the larger endpoint first, so the
+	// stored order may be swapped; projecting the other way can round ties differently, so the
+	// block must match one of the two orders exactly.
+	bool MatchesReferenceIndices(const uint8_t* block, const uint8_t* encoded)
+	{
+		uint16_t c0 = static_cast<uint16_t>(encoded[0] | (encoded[1] << 8));
+		uint16_t c1 = static_cast<uint16_t>(encoded[2] | (encoded[3] << 8));
+		uint32_t indices = encoded[4] | (encoded[5] << 8) | (encoded[6] << 16) | (static_cast<uint32_t>(encoded[7]) << 24);
+
+		if (c0 == c1)
+		{
+			return indices == 0;
+		}
+
+		int e0[3];
+		int e1[3];
+		Unpack565(c0, e0);
+		Unpack565(c1, e1);
+
+		return indices == ProjectIndices(block, e0, e1, 0) || indices == ProjectIndices(block, e1, e0, 1);
+	}
+
+	// Scalar BC4 encoding of one channel, written the way the SSE2 encoder is specified.
+	void ReferenceChannelBlock(const uint8_t* block, UINT channel, uint8_t* out)
+	{
+		int a0 = 0;
+		int a1 = 255;
+		for (int i = 0; i < 16; ++i)
+		{
+			a0 = (std::max)(a0, static_cast<int>(block[4 * i + channel]));
+			a1 = (std::min)(a1, static_cast<int>(block[4 * i + channel]));
+		}
+
+		out[0] = static_cast<uint8_t>(a0);
+		out[1] = static_cast<uint8_t>(a1);
+
+		uint64_t indices = 0;
+		if (a0 != a1)
+		{
+			float scale = 7.0f / (a0 - a1);
+			for (int i = 0; i < 16; ++i)
+			{
+				float step = (a0 - static_cast<float>(block[4 * i + channel])) * scale;
+				indices |= static_cast<uint64_t>(AlphaCodes[static_cast<int>(nearbyintf(step))]) << (3 * i);
+			}
+		}
+
+		for (int i = 0; i < 6; ++i)
+		{
+			out[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+		}
+	}
+
+	// Smooth colour and alpha with noise on top, like a photographic texture.
+	void MakeImage(std::vector<uint8_t>& rgba, UINT width, UINT height, UINT rowPitch, std::mt19937& rng)
+	{
+		std::uniform_int_distribution<int> noise(-12, 12);
+		rgba.assign(static_cast<size_t>(rowPitch) * height, 0xcd);
+
+		for (UINT y = 0; y < height; ++y)
+		{
+			for (UINT x = 0; x < width; ++x)
+			{
+				uint8_t* p = &rgba[static_cast<size_t>(y) * rowPitch + 4 * x];
+				float base[4] =
+				{
+					128.0f + 100.0f * sinf(x * 0.09f),
+					128.0f + 100.0f * cosf(y * 0.07f),
+					128.0f + 90.0f * sinf((x + y) * 0.05f),
+					128.0f + 120.0f * cosf(x * 0.03f - y * 0.04f),
+				};
+				for (int c = 0; c < 4; ++c)
+				{
+					p[c] = static_cast<uint8_t>((std::min)((std::max)(static_cast<int>(base[c]) + noise(rng), 0), 255));
+				}
+			}
+		}
+	}
+
+	// The block Compress reads at (blockX, blockY), repeating the last column and row.
+	void ReferenceLoadBlock(const uint8_t* rgba, UINT width, UINT height, UINT rowPitch, UINT blockX, UINT blockY, uint8_t* block)
+	{
+		for (UINT y = 0; y < 4; ++y)
+		{
+			for (UINT x = 0; x < 4; ++x)
+			{
+				UINT sx = (std::min)(blockX * 4 + x, width - 1);
+				UINT sy = (std::min)(blockY * 4 + y, height - 1);
+				memcpy(block + 16 * y + 4 * x, rgba + static_cast<size_t>(sy) * rowPitch + 4 * sx, 4);
+			}
+		}
+	}
+
+	const GBlockCompressor::Format Formats[] = { GBlockCompressor::FORMAT_BC1, GBlockCompressor::FORMAT_BC3, GBlockCompressor::FORMAT_BC5 };
+	const wchar_t* const FormatNames[] = { L"BC1", L"BC3", L"BC5" };
+}
+
+void TestBlockCompressor()
+{
+	std::mt19937 rng(17);
+	std::uniform_int_distribution<int> byteValue(0, 255);
+
+	// Single blocks: random, flat, two-colour and ramp blocks against the scalar references.
+	UINT colorMismatches = 0;
+	UINT channelMismatches = 0;
+	for (int trial = 0; trial < 4000; ++trial)
+	{
+		alignas(16) uint8_t block[64];
+		for (int i = 0; i < 64; ++i)
+		{
+			switch (trial % 4)
+			{
+			case 0: block[i] = static_cast<uint8_t>(byteValue(rng)); break;
+			case 1: block[i] = static_cast<uint8_t>(trial * 7 + (i & 3) * 50); break;
+			case 2: block[i] = static_cast<uint8_t>(((i / 4) & 1) ? 255 - (i & 3) * 40 : (i & 3) * 30); break;
+			default: block[i] = static_cast<uint8_t>((i / 4) * 16 + (i & 3) * 5 + trial % 11); break;
+			}
+		}
+
+		uint8_t bc1[8];
+		GBlockCompressor::CompressBlockBC1(block, bc1);
+		colorMismatches += MatchesReferenceIndices(block, bc1) ? 0 : 1;
+
+		// BC3 is a BC4 alpha block followed by a four-colour block.
+		uint8_t bc3[16];
+		uint8_t alpha[8];
+		GBlockCompressor::CompressBlockBC3(block, bc3);
+		ReferenceChannelBlock(block, 3, alpha);
+		channelMismatches += memcmp(bc3, alpha, 8) == 0 ? 0 : 1;
+		colorMismatches += MatchesReferenceIndices(block, bc3 + 8) ? 0 : 1;
+
+		uint8_t bc5[16];
+		uint8_t red[8];
+		uint8_t green[8];
+		GBlockCompressor::CompressBlockBC5(block, bc5);
+		ReferenceChannelBlock(block, 0, red);
+		ReferenceChannelBlock(block, 1, green);
+		channelMismatches += memcmp(bc5, red, 8) == 0 && memcmp(bc5 + 8, green, 8) == 0 ? 0 : 1;
+	}
+	CHECK(colorMismatches == 0);
+	CHECK(channelMismatches == 0);
+
+	// A flat block round-trips exactly through BC3 and BC5, and to 565 precision through BC1.
+	{
+		alignas(16) uint8_t block[64];
+		for (int i = 0; i < 16; ++i)
+		{
+			block[4 * i] = 200;
+			block[4 * i + 1] = 100;
+			block[4 * i + 2] = 50;
+			block[4 * i + 3] = 77;
+		}
+
+		uint8_t encoded[16];
+		uint8_t decoded[64];
+		GBlockCompressor::CompressBlockBC3(block, encoded);
+		GBlockCompressor::DecompressBlockBC3(encoded, decoded);
+		CHECK(decoded[3] == 77 && decoded[63] == 77);
+		CHECK(abs(decoded[0] - 200) <= 4 && abs(decoded[1] - 100) <= 2 && abs(decoded[2] - 50) <= 4);
+
+		GBlockCompressor::CompressBlockBC5(block, encoded);
+		GBlockCompressor::DecompressBlockBC5(encoded, decoded);
+		CHECK(decoded[0] == 200 && decoded[1] == 100 && decoded[60] == 200 && decoded[61] == 100);
+	}
+
+	// Whole images of every width and height up to two blocks and a bit: the threaded compressor
+	// matches block-by-block compression with edge repeat, decompression writes only the image,
+	// and quality holds up.
+	UINT imageMismatches = 0;
+	UINT overwrites = 0;
+	UINT lowQuality = 0;
+	for (size_t f = 0; f < sizeof(Formats) / sizeof(Formats[0]); ++f)
+	{
+		GBlockCompressor::Format format = Formats[f];
+		UINT blockBytes = GBlockCompressor::GetBlockBytes(format);
+
+		for (UINT height = 1; height <= 9; ++height)
+		{
+			for (UINT width = 1; width <= 9; ++width)
+			{
+				UINT rowPitch = 4 * width + 12;
+				std::vector<uint8_t> image;
+				MakeImage(image, width, height, rowPitch, rng);
+
+				std::vector<uint8_t> blocks(static_cast<size_t>(GBlockCompressor::GetCompressedSize(format, width, height)));
+				GBlockCompressor::Compress(format, image.data(), width, height, rowPitch, blocks.data());
+
+				UINT blocksX = (width + 3) / 4;
+				for (UINT by = 0; by < (height + 3) / 4; ++by)
+				{
+					for (UINT bx = 0; bx < blocksX; ++bx)
+					{
+						alignas(16) uint8_t block[64];
+						uint8_t expected[16];
+						ReferenceLoadBlock(image.data(), width, height, rowPitch, bx, by, block);
+
+						switch (format)
+						{
+						case GBlockCompressor::FORMAT_BC1: GBlockCompressor::CompressBlockBC1(block, expected); break;
+						case GBlockCompressor::FORMAT_BC3: GBlockCompressor::CompressBlockBC3(block, expected); break;
+						case GBlockCompressor::FORMAT_BC5: GBlockCompressor::CompressBlockBC5(block, expected); break;
+						}
+
+						imageMismatches += memcmp(&blocks[(by * blocksX + bx) * blockBytes], expected, blockBytes) == 0 ? 0 : 1;
+					}
+				}
+
+				// The padding after each row keeps its fill.
+				std::vector<uint8_t> decoded(image.size(), 0xcd);
+				GBlockCompressor::Decompress(format, blocks.data(), width, height, decoded.data(), rowPitch);
+				for (UINT y = 0; y < height; ++y)
+				{
+					for (UINT x = 4 * width; x < rowPitch; ++x)
+					{
+						overwrites += decoded[static_cast<size_t>(y) * rowPitch + x] == 0xcd ? 0 : 1;
+					}
+				}
+
+				UINT mask = format == GBlockCompressor::FORMAT_BC5 ? 0x3 : format == GBlockCompressor::FORMAT_BC3 ? 0xf : 0x7;
+				lowQuality += GBlockCompressor::ComputePSNR(image.data(), decoded.data(), width, height, rowPitch, mask) >= 28.0 ? 0 : 1;
+			}
+		}
+	}
+	CHECK(imageMismatches == 0);
+	CHECK(overwrites == 0);
+	CHECK(lowQuality == 0);
+
+	CHECK(GBlockCompressor::GetCompressedSize(GBlockCompressor::FORMAT_BC1, 5, 9) == 2 * 3 * 8);
+	CHECK(GBlockCompressor::GetCompressedSize(GBlockCompressor::FORMAT_BC3, 4, 4) == 16);
+}
+
+int BenchBlockCompressor(int argc, wchar_t* argv[])
+{
+	UINT size = (std::max)(GetOption(argc, argv, L"size", 2048), 4u);
+	UINT runs = (std::max)(GetOption(argc, argv, L"runs", 5), 1u);
+
+	std::mt19937 rng(3);
+	std::vector<uint8_t> image;
+	MakeImage(image, size, size, size * 4, rng);
+
+	wprintf(L"%u x %u RGBA8, %u runs, %u pool threads\n", size, size, runs, GThreadPool::Get().GetThreadCount());
+
+	for (size_t f = 0; f < sizeof(Formats) / sizeof(Formats[0]); ++f)
+	{
+		GBlockCompressor::Format format = Formats[f];
+		std::vector<uint8_t> blocks(static_cast<size_t>(GBlockCompressor::GetCompressedSize(format, size, size)));
+		std::vector<uint8_t> decoded(image.size());
+
+		double compressMs = 0.0;
+		double decompressMs = 0.0;
+		for (UINT run = 0; run < runs; ++run)
+		{
+			Clock::time_point start = Clock::now();
+			GBlockCompressor::Compress(format, image.data(), size, size, size * 4, blocks.data());
+			Clock::time_point compressed = Clock::now();
+			GBlockCompressor::Decompress(format, blocks.data(), size, size, decoded.data(), size * 4);
+
+			compressMs += ElapsedMs(start, compressed);
+			decompressMs += ElapsedMs(compressed, Clock::now());
+		}
+
+		double megapixels = static_cast<double>(size) * size / 1e6;
+		UINT mask = format == GBlockCompressor::FORMAT_BC5 ? 0x3 : format == GBlockCompressor::FORMAT_BC3 ? 0xf : 0x7;
+		wprintf(L"  %ls: compress %8.2f ms (%6.1f MP/s), decompress %7.2f ms, PSNR %.2f dB\n", FormatNames[f],
+			compressMs / runs, megapixels * runs / (compressMs / 1000.0), decompressMs / runs,
+			GBlockCompressor::ComputePSNR(image.data(), decoded.data(), size, size, size * 4, mask));
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,225 @@
+/*  ===============================================
+	Summary: Cube Map Scheduler Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GCubeMapScheduler.h"
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	const XMFLOAT3 Center(0.0f, 2.0f, 0.0f);
+	const float NearZ = 0.1f;
+	const float FarZ = 1000.0f;
+
+	enum Face { POS_X, NEG_X, POS_Y, NEG_Y, POS_Z, NEG_Z };
+
+	UINT VisibleMask(const GCubeMapScheduler& scheduler, UINT object)
+	{
+		UINT mask = 0;
+		for (UINT face = 0; face < GCubeMapScheduler::FaceCount; ++face)
+		{
+			mask |= scheduler.IsVisible(face, object) ? 1u << face : 0u;
+		}
+		return mask;
+	}
+
+	UINT ScheduleMask(GCubeMapScheduler& scheduler)
+	{
+		UINT faces[GCubeMapScheduler::FaceCount];
+		UINT count = scheduler.Schedule(faces);
+
+		UINT mask = 0;
+		for (UINT i = 0; i < count; ++i)
+		{
+			mask |= 1u << faces[i];
+		}
+		return mask;
+	}
+
+	// The faces whose 90-degree frustum holds a point relative to the center.
+	UINT PointMask(const float p[3])
+	{
+		UINT mask = 0;
+		for (UINT axis = 0; axis < 3; ++axis)
+		{
+			for (UINT side = 0; side < 2; ++side)
+			{
+				float depth = side == 0 ? p[axis] : -p[axis];
+				if (depth >= NearZ && depth <= FarZ && depth >= fabsf(p[(axis + 1) % 3]) && depth >= fabsf(p[(axis + 2) % 3]))
+				{
+					mask |= 1u << (axis * 2 + side);
+				}
+			}
+		}
+		return mask;
+	}
+
+	BoundingBox Box(float x, float y, float z, float extent)
+	{
+		return BoundingBox(XMFLOAT3(Center.x + x, Center.y + y, Center.z + z), XMFLOAT3(extent, extent, extent));
+	}
+}
+
+void TestCubeMapScheduler()
+{
+	GCubeMapScheduler scheduler;
+	scheduler.SetCenter(Center, NearZ, FarZ);
+
+	// Boxes with a known set of faces.
+	CHECK(VisibleMask(scheduler, scheduler.AddObject(Box(10.0f, 0.0f, 0.0f, 1.0f))) == 1u << POS_X);
+	CHECK(VisibleMask(scheduler, scheduler.AddObject(Box(0.0f, -10.0f, 0.0f, 1.0f))) == 1u << NEG_Y);
+	CHECK(VisibleMask(scheduler, scheduler.AddObject(Box(0.0f, 0.0f, 0.0f, 1.0f))) == 0x3Fu);
+	CHECK(VisibleMask(scheduler, scheduler.AddObject(Box(10.0f, 0.0f, 10.0f, 0.5f))) == ((1u << POS_X) | (1u << POS_Z)));
+	CHECK(VisibleMask(scheduler, scheduler.AddObject(Box(0.0f, 0.0f, -2000.0f, 1.0f))) == 0u);
+
+	// Random boxes: no face that sees some point of a box may leave it out.
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	UINT missed = 0;
+	for (UINT i = 0; i < 500; ++i)
+	{
+		BoundingBox box(XMFLOAT3(20.0f * unit(rng) - 10.0f, 20.0f * unit(rng) - 8.0f, 20.0f * unit(rng) - 10.0f),
+			XMFLOAT3(3.0f * unit(rng), 3.0f * unit(rng), 3.0f * unit(rng)));
+		UINT object = scheduler.AddObject(box);
+
+		UINT sampled = 0;
+		for (UINT k = 0; k < 1000; ++k)
+		{
+			float p[3] =
+			{
+				box.Center.x - Center.x + (2.0f * unit(rng) - 1.0f) * box.Extents.x,
+				box.Center.y - Center.y + (2.0f * unit(rng) - 1.0f) * box.Extents.y,
+				box.Center.z - Center.z + (2.0f * unit(rng) - 1.0f) * box.Extents.z
+			};
+			sampled |= PointMask(p);
+		}
+
+		missed += (sampled & ~VisibleMask(scheduler, object)) != 0 ? 1 : 0;
+	}
+	CHECK(missed == 0);
+
+	// Budgeted round robin: every face once, then nothing until something changes.
+	GCubeMapScheduler budget;
+	budget.SetCenter(Center, NearZ, FarZ);
+	budget.SetFacesPerFrame(2);
+
+	CHECK(ScheduleMask(budget) == 0x03u);
+	CHECK(ScheduleMask(budget) == 0x0Cu);
+	CHECK(ScheduleMask(budget) == 0x30u);
+	CHECK(ScheduleMask(budget) == 0u);
+
+	// Moving an object from +X to +Z dirties exactly the faces that saw it before and after.
+	UINT object = budget.AddObject(Box(10.0f, 0.0f, 0.0f, 1.0f));
+	CHECK(ScheduleMask(budget) == 1u << POS_X);
+	budget.UpdateObject(object, Box(0.0f, 0.0f, 10.0f, 1.0f));
+	CHECK(ScheduleMask(budget) == ((1u << POS_X) | (1u << POS_Z)));
+	CHECK(ScheduleMask(budget) == 0u);
+
+	// Moving the center redraws everything.
+	budget.SetCenter(XMFLOAT3(0.0f, 3.0f, 0.0f), NearZ, FarZ);
+	UINT redrawn = 0;
+	for (UINT frame = 0; frame < 3; ++frame)
+	{
+		redrawn |= ScheduleMask(budget);
+	}
+	CHECK(redrawn == 0x3Fu);
+
+	// Without skipping the faces keep coming in turn; without culling every object is seen.
+	budget.SetSkipUnchanged(false);
+	UINT first = ScheduleMask(budget);
+	UINT second = ScheduleMask(budget);
+	UINT third = ScheduleMask(budget);
+	CHECK((first | second | third) == 0x3Fu && (first & second) == 0u && (second & third) == 0u);
+
+	budget.SetCulling(false);
+	CHECK(VisibleMask(budget, object) == 0x3Fu);
+}
+
+int BenchCubeMapScheduler(int argc, wchar_t* argv[])
+{
+	UINT objectCount = GetOption(argc, argv, L"objects", 200);
+	UINT frames = (std::max)(GetOption(argc, argv, L"frames", 600), 1u);
+
+	// Static boxes around the probe and one orbiting it, like the skull in the Chapter 17 demo.
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> position(-30.0f, 30.0f);
+	std::uniform_real_distribution<float> extent(0.2f, 2.0f);
+
+	std::vector<BoundingBox> objects;
+	for (UINT i = 0; i < objectCount; ++i)
+	{
+		objects.push_back(BoundingBox(XMFLOAT3(position(rng), position(rng), position(rng)), XMFLOAT3(extent(rng), extent(rng), extent(rng))));
+	}
+
+	struct Policy
+	{
+		const wchar_t* Name;
+		bool bCull;
+		bool bSkip;
+		UINT FacesPerFrame;
+	};
+
+	const Policy policies[] =
+	{
+		{ L"all faces", false, false, 6 },
+		{ L"culled", true, false, 6 },
+		{ L"culled, changed", true, true, 6 },
+		{ L"culled, changed, 2/frame", true, true, 2 },
+	};
+
+	wprintf(L"%u static objects and one moving, %u frames\n", objectCount, frames);
+
+	for (size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); ++p)
+	{
+		GCubeMapScheduler scheduler;
+		scheduler.SetCenter(Center, NearZ, FarZ);
+		scheduler.SetCulling(policies[p].bCull);
+		scheduler.SetSkipUnchanged(policies[p].bSkip);
+		scheduler.SetFacesPerFrame(policies[p].FacesPerFrame);
+
+		for (size_t i = 0; i < objects.size(); ++i)
+		{
+			scheduler.AddObject(objects[i]);
+		}
+		UINT moving = scheduler.AddObject(Box(3.0f, 0.0f, 0.0f, 0.5f));
+
+		UINT64 faceCount = 0;
+		UINT64 drawCount = 0;
+
+		Clock::time_point start = Clock::now();
+		for (UINT frame = 0; frame < frames; ++frame)
+		{
+			float angle = 0.01f * frame;
+			scheduler.UpdateObject(moving, Box(3.0f * cosf(angle), 0.0f, 3.0f * sinf(angle), 0.5f));
+
+			UINT faces[GCubeMapScheduler::FaceCount];
+			UINT count = scheduler.Schedule(faces);
+			faceCount += count;
+
+			for (UINT i = 0; i < count; ++i)
+			{
+				for (UINT object = 0; object <= moving; ++object)
+				{
+					drawCount += scheduler.IsVisible(faces[i], object) ? 1 : 0;
+				}
+			}
+		}
+		double ms = ElapsedMs(start, Clock::now());
+
+		wprintf(L"  %-26ls %5.2f faces, %8.1f draws per frame  (%.2f us per frame)\n", policies[p].Name,
+			static_cast<double>(faceCount) / frames, static_cast<double>(drawCount) / frames, 1000.0 * ms / frames);
+	}
+
+	return 0;
+}
\ No newline at end of file
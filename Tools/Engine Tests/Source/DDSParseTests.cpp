@@ -0,0 +1,302 @@
+/*  ===============================================
+	Summary: DDS Parser Fuzz Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "DDSTextureLoader.h"
+
+#include <d3d11.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Magic number, DDS_HEADER and DDS_HEADER_DXT10.
+	const size_t HeaderBytes = 4 + 124 + 20;
+
+	// Fuzzed inputs copy at most this much of a file, so large textures stay cheap to mutate.
+	const size_t MaxInputBytes = 256 * 1024;
+
+	// Offsets of the header fields the parser decodes: size, flags, height, width, depth, mip count,
+	// pixel format size, flags, fourCC, bit count and masks, caps2, then the DXT10 format, dimension,
+	// misc flag and array size.
+	const size_t FieldOffsets[] = { 4, 8, 12, 16, 24, 28, 76, 80, 84, 88, 92, 96, 100, 104, 112, 128, 132, 136, 140 };
+
+	const uint32_t FieldValues[] =
+	{
+		0, 1, 2, 3, 4, 6, 7, 0x10, 0x7F, 0x80, 0xFF, 0x100, 0x3FFF, 0x4000, 0x4001, 0x8000, 0xFFFF, 0x10000,
+		0x7FFFFFFF, 0x80000000, 0xFFFFFFFF,
+		MAKEFOURCC('D', 'X', '1', '0'), MAKEFOURCC('D', 'X', 'T', '1'), MAKEFOURCC('D', 'X', 'T', '5'),
+		MAKEFOURCC('A', 'T', 'I', '2'), MAKEFOURCC('B', 'C', '5', 'S'), MAKEFOURCC('R', 'G', 'B', 'G'),
+		0x00000004, 0x00000040, 0x00020000, 0x00000200, 0x0000FE00, 0x00200000
+	};
+
+	const size_t FieldCount = sizeof(FieldOffsets) / sizeof(FieldOffsets[0]);
+	const size_t ValueCount = sizeof(FieldValues) / sizeof(FieldValues[0]);
+
+	struct SeedFile
+	{
+		DirectX::DDS_TEXTURE_DATA Data;
+		const uint8_t* Bytes;
+		size_t Size;
+	};
+
+	bool LoadSeeds(std::vector<SeedFile>& seeds)
+	{
+		std::wstring root = FindRepoRoot();
+		if (root.empty())
+		{
+			return false;
+		}
+
+		std::vector<std::wstring> files;
+		FindFiles(root, L".dds", files);
+
+		seeds.resize(files.size());
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			// The mapping stays open in Data.fileData; the pixel data ends the file.
+			if (FAILED(DirectX::LoadDDSTextureDataFromFile(files[i].c_str(), seeds[i].Data)))
+			{
+				return false;
+			}
+
+			seeds[i].Bytes = seeds[i].Data.fileData.get();
+			seeds[i].Size = (seeds[i].Data.bitData + seeds[i].Data.bitSize) - seeds[i].Bytes;
+		}
+
+		return !seeds.empty();
+	}
+
+	// A parse that succeeds must describe subresources that lie inside the input.
+	bool IsContained(const DirectX::DDS_TEXTURE_DATA& data, const uint8_t* bytes, size_t size)
+	{
+		const uint8_t* end = bytes + size;
+		if (data.bitData < bytes || data.bitData + data.bitSize != end)
+		{
+			return false;
+		}
+
+		if (data.initData.size() != data.mipCount * data.arraySize || data.skipMip >= (std::max)(data.mipCount, size_t(1)))
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < data.initData.size(); ++i)
+		{
+			const D3D11_SUBRESOURCE_DATA& sub = data.initData[i];
+			if (!sub.pSysMem)
+			{
+				continue;
+			}
+
+			// Volume mips hold one slice per depth level; everything else is a single slice.
+			size_t slices = 1;
+			if (data.resDim == D3D11_RESOURCE_DIMENSION_TEXTURE3D)
+			{
+				slices = (std::max)(data.depth >> (data.skipMip + i), size_t(1));
+			}
+
+			const uint8_t* p = static_cast<const uint8_t*>(sub.pSysMem);
+			if (p < data.bitData || sub.SysMemPitch > sub.SysMemSlicePitch || static_cast<size_t>(end - p) < sub.SysMemSlicePitch * slices)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Copies a random prefix of a seed file, mutates its header and parses it.  The copy is
+	// exactly the input size, so an address sanitizer build also catches any read past the end.
+	bool FuzzOne(const std::vector<SeedFile>& seeds, std::mt19937& rng, std::vector<uint8_t>& input, bool& bParsed)
+	{
+		const SeedFile& seed = seeds[rng() % seeds.size()];
+		size_t header = (std::min)(seed.Size, HeaderBytes);
+
+		size_t size;
+		switch (rng() % 4)
+		{
+		case 0:
+			size = rng() % (header + 64);
+			break;
+		case 1:
+			size = seed.Size <= MaxInputBytes ? seed.Size : header;
+			break;
+		default:
+			size = header + rng() % ((std::min)(seed.Size, MaxInputBytes) - header + 1);
+			break;
+		}
+		size = (std::min)(size, (std::max)(seed.Size, HeaderBytes));
+
+		input.assign(seed.Bytes, seed.Bytes + (std::min)(size, seed.Size));
+		input.resize(size, 0);
+
+		UINT mutations = 1 + rng() % 4;
+		for (UINT m = 0; m < mutations && size > 0; ++m)
+		{
+			switch (rng() % 3)
+			{
+			case 0:
+			{
+				size_t offset = FieldOffsets[rng() % FieldCount];
+				uint32_t value = (rng() % 4) ? FieldValues[rng() % ValueCount] : static_cast<uint32_t>(rng() % 200);
+				if (offset + sizeof(value) <= size)
+				{
+					memcpy(&input[offset], &value, sizeof(value));
+				}
+				break;
+			}
+			case 1:
+				input[rng() % (std::min)(size, header)] ^= static_cast<uint8_t>(1u << (rng() % 8));
+				break;
+			default:
+				input[rng() % (std::min)(size, header)] = static_cast<uint8_t>(rng());
+				break;
+			}
+		}
+
+		// input keeps its capacity between iterations; the parser gets a copy with none to spare.
+		std::vector<uint8_t> exact(input.begin(), input.end());
+
+		DirectX::DDS_TEXTURE_DATA data;
+		HRESULT hr = DirectX::LoadDDSTextureDataFromMemory(exact.data(), exact.size(), data);
+		bParsed = SUCCEEDED(hr);
+
+		return !bParsed || IsContained(data, exact.data(), exact.size());
+	}
+
+	// Returns the number of inputs that broke an invariant.
+	UINT Fuzz(const std::vector<SeedFile>& seeds, UINT iterations, UINT seed, UINT& parsed)
+	{
+		std::mt19937 rng(seed);
+		std::vector<uint8_t> input;
+
+		UINT failures = 0;
+		parsed = 0;
+
+		for (UINT i = 0; i < iterations; ++i)
+		{
+			bool bParsed = false;
+			if (!FuzzOne(seeds, rng, input, bParsed))
+			{
+				if (failures++ < 8)
+				{
+					fprintf(stderr, "  iteration %u (seed %u): subresources outside a %u byte input\n", i, seed, static_cast<UINT>(input.size()));
+				}
+			}
+
+			parsed += bParsed ? 1 : 0;
+		}
+
+		return failures;
+	}
+}
+
+void TestDDSParse()
+{
+	std::vector<SeedFile> seeds;
+	if (!CHECK(LoadSeeds(seeds)))
+	{
+		return;
+	}
+
+	// The mapped files and the same bytes parsed from memory describe the same textures.
+	for (size_t i = 0; i < seeds.size(); ++i)
+	{
+		const DirectX::DDS_TEXTURE_DATA& mapped = seeds[i].Data;
+
+		DirectX::DDS_TEXTURE_DATA data;
+		if (!CHECK(SUCCEEDED(DirectX::LoadDDSTextureDataFromMemory(seeds[i].Bytes, seeds[i].Size, data))))
+		{
+			continue;
+		}
+
+		CHECK(data.width == mapped.width && data.height == mapped.height && data.depth == mapped.depth);
+		CHECK(data.format == mapped.format && data.mipCount == mapped.mipCount && data.arraySize == mapped.arraySize);
+		CHECK(data.bitData == mapped.bitData && data.bitSize == mapped.bitSize);
+		CHECK(IsContained(mapped, seeds[i].Bytes, seeds[i].Size));
+	}
+
+	// Too short, a wrong magic number and a null pointer are all refused.
+	DirectX::DDS_TEXTURE_DATA data;
+	CHECK(FAILED(DirectX::LoadDDSTextureDataFromMemory(seeds[0].Bytes, HeaderBytes - 21, data)));
+	CHECK(FAILED(DirectX::LoadDDSTextureDataFromMemory(seeds[0].Bytes + 1, seeds[0].Size - 1, data)));
+	CHECK(FAILED(DirectX::LoadDDSTextureDataFromMemory(nullptr, seeds[0].Size, data)));
+
+	UINT parsed = 0;
+	CHECK(Fuzz(seeds, 50000, 1, parsed) == 0);
+
+	// Some mutations must still parse, or the fuzzer only exercises the early outs.
+	CHECK(parsed > 0);
+}
+
+int BenchDDSParse(int argc, wchar_t* argv[])
+{
+	UINT runs = (std::max)(GetOption(argc, argv, L"runs", 5), 1u);
+
+	std::vector<std::wstring> files;
+	FindFiles(FindRepoRoot(), L".dds", files);
+
+	std::vector<SeedFile> seeds;
+	if (files.empty() || !LoadSeeds(seeds))
+	{
+		wprintf(L"No .dds files found; run from inside the repository.\n");
+		return 1;
+	}
+
+	double mapMs = 0.0;
+	double parseMs = 0.0;
+
+	for (UINT run = 0; run < runs; ++run)
+	{
+		// Map each file and validate it in place; no pixel data is read.
+		Clock::time_point start = Clock::now();
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			DirectX::DDS_TEXTURE_DATA data;
+			DirectX::LoadDDSTextureDataFromFile(files[i].c_str(), data);
+		}
+		mapMs += ElapsedMs(start, Clock::now());
+
+		// The header decode and subresource layout alone.
+		start = Clock::now();
+		for (size_t i = 0; i < seeds.size(); ++i)
+		{
+			DirectX::DDS_TEXTURE_DATA data;
+			DirectX::LoadDDSTextureDataFromMemory(seeds[i].Bytes, seeds[i].Size, data);
+		}
+		parseMs += ElapsedMs(start, Clock::now());
+	}
+
+	double perFile = 1000.0 / (runs * files.size());
+	wprintf(L"%u DDS files, %u runs\n", static_cast<UINT>(files.size()), runs);
+	wprintf(L"  map and parse   %8.2f us per file\n", mapMs * perFile);
+	wprintf(L"  parse only      %8.2f us per file\n", parseMs * perFile);
+	return 0;
+}
+
+int BenchDDSFuzz(int argc, wchar_t* argv[])
+{
+	UINT iterations = GetOption(argc, argv, L"iterations", 1000000);
+	UINT seed = GetOption(argc, argv, L"seed", 1);
+
+	std::vector<SeedFile> seeds;
+	if (!LoadSeeds(seeds))
+	{
+		wprintf(L"No .dds files found; run from inside the repository.\n");
+		return 1;
+	}
+
+	UINT parsed = 0;
+	Clock::time_point start = Clock::now();
+	UINT failures = Fuzz(seeds, iterations, seed, parsed);
+	double ms = ElapsedMs(start, Clock::now());
+
+	wprintf(L"%u inputs from %u seed files, seed %u: %u parsed, %u failures\n", iterations, static_cast<UINT>(seeds.size()), seed, parsed, failures);
+	wprintf(L"  %.0f inputs per second\n", iterations / (ms / 1000.0));
+	return failures ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+/*  ===============================================
+	Summary: Engine Tests
+	===============================================  */
+
+#ifndef ENGINETESTS_H
+#define ENGINETESTS_H
+
+#include <Windows.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// Reports a failed check and counts it against the running test.  Returns whether it passed.
+bool Check(bool bPassed, const char* expression, const char* file, int line);
+
+#define CHECK(expression) Check(!!(expression), #expression, __FILE__, __LINE__)
+
+// Value following "-name" in a benchmark's options, or defaultValue when it is absent.
+UINT GetOption(int argc, wchar_t* argv[], const wchar_t* name, UINT defaultValue);
+
+// Directory holding DX11Renderer.sln, with a trailing separator, found by walking up from the
+// working directory.  Empty if there is none.
+std::wstring FindRepoRoot();
+
+// Appends every file below dir whose name ends in extension, ignoring case, in sorted order.
+void FindFiles(const std::wstring& dir, const wchar_t* extension, std::vector<std::wstring>& out);
+
+// Scratch folders for the tests that write files.  MakeDirectory returns whether dir exists after
+// the call; ClearDirectory removes every file a test left in dir and its Cache folder, then the
+// folders themselves.
+bool MakeDirectory(const std::wstring& dir);
+void ClearDirectory(const std::wstring& dir);
+
+inline double ElapsedMs(Clock::time_point start, Clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Tests check results and return nothing; benchmarks print timings and return an exit code.
+void TestRadixSort();
+int BenchRadixSort(int argc, wchar_t* argv[]);
+
+void TestSpatialHash();
+int BenchCollide(int argc, wchar_t* argv[]);
+
+void TestTerrainBounds();
+int BenchTerrainCull(int argc, wchar_t* argv[]);
+
+void TestTerrainQuery();
+int BenchTerrainQuery(int argc, wchar_t* argv[]);
+
+void TestTextureLoader();
+int BenchTextureLoad(int argc, wchar_t* argv[]);
+
+void TestDDSParse();
+int BenchDDSParse(int argc, wchar_t* argv[]);
+int BenchDDSFuzz(int argc, wchar_t* argv[]);
+
+void TestShadowCascades();
+int BenchShadowCascades(int argc, wchar_t* argv[]);
+
+void TestCubeMapScheduler();
+int BenchCubeMapScheduler(int argc, wchar_t* argv[]);
+
+void TestPlanarReflection();
+int BenchPlanarReflection(int argc, wchar_t* argv[]);
+
+void TestShaderCache();
+int BenchShaderCache(int argc, wchar_t* argv[]);
+
+void TestFrameScheduler();
+int BenchFrameScheduler(int argc, wchar_t* argv[]);
+
+void TestParticleSort();
+int BenchParticleSort(int argc, wchar_t* argv[]);
+
+void TestHeightmapStream();
+int BenchHeightmapStream(int argc, wchar_t* argv[]);
+
+void TestTextureCache();
+
+void TestBlockCompressor();
+int BenchBlockCompressor(int argc, wchar_t* argv[]);
+
+void TestMipGenerator();
+int BenchMipGenerator(int argc, wchar_t* argv[]);
+
+void TestHeightmapCodec();
+int BenchHeightmapCodec(int argc, wchar_t* argv[]);
+
+void TestForest();
+int BenchForest(int argc, wchar_t* argv[]);
+
+void TestTextureAtlas();
+
+void TestHeadlessRender();
+
+void TestSoftSsao();
+int BenchSoftSsao(int argc, wchar_t* argv[]);
+
+void TestImageBlur();
+int BenchImageBlur(int argc, wchar_t* argv[]);
+
+void TestStaticShadowCache();
+
+void TestPipelineBuilder();
+int BenchPipelineBuilder(int argc, wchar_t* argv[]);
+
+int BenchProfiler(int argc, wchar_t* argv[]);
+
+#endif // ENGINETESTS_H
\ No newline at end of file
@@ -0,0 +1,575 @@
+/*  ===============================================
+	Summary: Forest and Texture Atlas Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GForest.h"
+#include "GTextureAtlas.h"
+#include "GThreadPool.h"
+#include "MathHelper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	const float AreaMinX = -200.0f;
+	const float AreaMaxX = 200.0f;
+	const float AreaMinZ = -100.0f;
+	const float AreaMaxZ = 300.0f;
+
+	float GetGroundHeight(float x, float z)
+	{
+		return 10.0f * sinf(0.02f * x) * cosf(0.03f * z) + 2.0f;
+	}
+
+	// The left seventh of the area is a clearing; the rest thins out from left to right.
+	const UINT DensityMapWidth = 8;
+	const UINT DensityMapDepth = 6;
+
+	void BuildDensityMap(std::vector<float>& densityMap)
+	{
+		densityMap.resize(DensityMapWidth * DensityMapDepth);
+		for (UINT z = 0; z < DensityMapDepth; ++z)
+		{
+			for (UINT x = 0; x < DensityMapWidth; ++x)
+			{
+				densityMap[z * DensityMapWidth + x] = x < 2 ? 0.0f : 1.0f - 0.1f * x;
+			}
+		}
+	}
+
+	// Cells of 32 units do not divide the area, so the last row and column are partial.
+	GForest::Desc MakeDesc(const std::vector<float>* densityMap, float density, UINT seed)
+	{
+		GForest::Desc desc;
+		desc.MinX = AreaMinX;
+		desc.MinZ = AreaMinZ;
+		desc.MaxX = AreaMaxX;
+		desc.MaxZ = AreaMaxZ;
+		desc.CellSize = 32.0f;
+		desc.Density = density;
+		desc.DensityMap = densityMap ? densityMap->data() : nullptr;
+		desc.DensityMapWidth = DensityMapWidth;
+		desc.DensityMapDepth = DensityMapDepth;
+		desc.GetHeight = GetGroundHeight;
+		desc.MinHeight = 0.0f;
+		desc.MinSize = XMFLOAT2(4.0f, 6.0f);
+		desc.MaxSize = XMFLOAT2(8.0f, 12.0f);
+		desc.NumSpriteTypes = 3;
+		desc.Seed = seed;
+		return desc;
+	}
+
+	// Every tree in the forest, in cell order, through a cull that keeps every cell.
+	void GetAllTrees(GForest& forest, std::vector<GForest::Sprite>& trees)
+	{
+		XMFLOAT4 planes[6];
+		for (UINT p = 0; p < 6; ++p)
+		{
+			planes[p] = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+		forest.Cull(planes, XMFLOAT3(0.0f, 0.0f, 0.0f), 1.0e30f);
+
+		trees.resize(forest.GetTreeCount());
+		trees.resize(forest.Upload(trees.data(), forest.GetTreeCount()));
+	}
+
+	bool SameTrees(const std::vector<GForest::Sprite>& a, const std::vector<GForest::Sprite>& b)
+	{
+		return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(GForest::Sprite)) == 0);
+	}
+
+	uint64_t TreeKey(const GForest::Sprite& tree)
+	{
+		uint32_t x, z;
+		memcpy(&x, &tree.CenterW.x, sizeof(x));
+		memcpy(&z, &tree.CenterW.z, sizeof(z));
+		return (static_cast<uint64_t>(x) << 32) | z;
+	}
+
+	void GetFrustumPlanes(const XMFLOAT3& eye, const XMFLOAT3& look, XMFLOAT4 planes[6])
+	{
+		XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&eye), XMVector3Normalize(XMLoadFloat3(&look)), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 1.0f, 1000.0f);
+		MathHelper::ExtractFrustumPlanes(planes, XMMatrixMultiply(view, proj));
+	}
+
+	// The tree's own billboard, turned any way about its axis, against the same frustum and range.
+	bool IsTreeVisible(const GForest::Sprite& tree, const XMFLOAT4 planes[6], const XMFLOAT3& eye, float maxDistance)
+	{
+		XMFLOAT3 extents(0.5f * tree.SizeW.x, 0.5f * tree.SizeW.y, 0.5f * tree.SizeW.x);
+
+		float dx = (std::max)(fabsf(eye.x - tree.CenterW.x) - extents.x, 0.0f);
+		float dy = (std::max)(fabsf(eye.y - tree.CenterW.y) - extents.y, 0.0f);
+		float dz = (std::max)(fabsf(eye.z - tree.CenterW.z) - extents.z, 0.0f);
+		if (dx * dx + dy * dy + dz * dz > maxDistance * maxDistance)
+		{
+			return false;
+		}
+
+		for (UINT p = 0; p < 6; ++p)
+		{
+			float r = fabsf(planes[p].x) * extents.x + fabsf(planes[p].y) * extents.y + fabsf(planes[p].z) * extents.z;
+			float s = planes[p].x * tree.CenterW.x + planes[p].y * tree.CenterW.y + planes[p].z * tree.CenterW.z + planes[p].w;
+			if (s + r < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool RemoveFile(const std::wstring& path)
+	{
+#if defined(_WIN32)
+		return DeleteFileW(path.c_str()) != 0;
+#else
+		std::string narrow(path.size() * 4 + 1, '\0');
+		narrow.resize(wcstombs(&narrow[0], path.c_str(), narrow.size()));
+		return unlink(narrow.c_str()) == 0;
+#endif
+	}
+
+	bool IsPowerOfTwo(UINT value)
+	{
+		return value != 0 && (value & (value - 1)) == 0;
+	}
+
+	// The texel Blit should leave at (x, y): the sprite's nearest texel inside its rect and
+	// gutter, the old contents everywhere else.
+	bool ReferenceTexel(const std::vector<uint8_t>& sprite, const GTextureAtlas::Rect& rect, UINT gutter, UINT x, UINT y, uint8_t texel[4])
+	{
+		if (x + gutter < rect.X || x >= rect.X + rect.Width + gutter || y + gutter < rect.Y || y >= rect.Y + rect.Height + gutter)
+		{
+			return false;
+		}
+
+		UINT sx = (std::min)((std::max)(x, rect.X), rect.X + rect.Width - 1) - rect.X;
+		UINT sy = (std::min)((std::max)(y, rect.Y), rect.Y + rect.Height - 1) - rect.Y;
+		memcpy(texel, &sprite[4 * (static_cast<size_t>(sy) * rect.Width + sx)], 4);
+		return true;
+	}
+}
+
+void TestForest()
+{
+	std::vector<float> densityMap;
+	BuildDensityMap(densityMap);
+
+	// The same description always gives the same forest, whichever workers fill which cells.
+	GForest forest;
+	GForest::Desc desc = MakeDesc(&densityMap, 0.4f, 7);
+	forest.Generate(desc);
+
+	std::vector<GForest::Sprite> trees;
+	GetAllTrees(forest, trees);
+	CHECK(trees.size() == forest.GetTreeCount() && !trees.empty());
+
+	UINT changedRuns = 0;
+	for (UINT run = 0; run < 4; ++run)
+	{
+		GForest again;
+		again.Generate(desc);
+
+		std::vector<GForest::Sprite> againTrees;
+		GetAllTrees(again, againTrees);
+		changedRuns += SameTrees(trees, againTrees) ? 0 : 1;
+	}
+	CHECK(changedRuns == 0);
+
+	GForest reseeded;
+	reseeded.Generate(MakeDesc(&densityMap, 0.4f, 8));
+	std::vector<GForest::Sprite> reseededTrees;
+	GetAllTrees(reseeded, reseededTrees);
+	CHECK(!SameTrees(trees, reseededTrees));
+
+	// Every tree stands on dry ground inside the area, outside the clearing, with a size from
+	// the range and an atlas entry that exists.
+	const float ClearingEndX = AreaMinX + (AreaMaxX - AreaMinX) / (DensityMapWidth - 1);
+
+	UINT misplaced = 0;
+	UINT inClearing = 0;
+	UINT badSprites = 0;
+	for (size_t i = 0; i < trees.size(); ++i)
+	{
+		const GForest::Sprite& tree = trees[i];
+		float groundY = tree.CenterW.y - 0.5f * tree.SizeW.y;
+
+		misplaced += tree.CenterW.x >= AreaMinX && tree.CenterW.x <= AreaMaxX &&
+			tree.CenterW.z >= AreaMinZ && tree.CenterW.z <= AreaMaxZ &&
+			groundY >= desc.MinHeight && fabsf(groundY - GetGroundHeight(tree.CenterW.x, tree.CenterW.z)) < 1.0e-3f ? 0 : 1;
+
+		inClearing += tree.CenterW.x < ClearingEndX ? 1 : 0;
+
+		badSprites += tree.SizeW.x >= desc.MinSize.x && tree.SizeW.x <= desc.MaxSize.x &&
+			tree.SizeW.y >= desc.MinSize.y && tree.SizeW.y <= desc.MaxSize.y &&
+			tree.AtlasIndex < desc.NumSpriteTypes ? 0 : 1;
+	}
+	CHECK(misplaced == 0);
+	CHECK(inClearing == 0);
+	CHECK(badSprites == 0);
+
+	// Without a density map or water the count follows the density, to within the randomness.
+	{
+		GForest::Desc flat = MakeDesc(nullptr, 0.25f, 11);
+		flat.GetHeight = [](float, float) { return 1.0f; };
+
+		GForest uniform;
+		uniform.Generate(flat);
+
+		double expected = 0.25 * (AreaMaxX - AreaMinX) * (AreaMaxZ - AreaMinZ);
+		CHECK(fabs(uniform.GetTreeCount() - expected) < 0.03 * expected);
+	}
+
+	// Culling against a frustum keeps every cell holding a tree the frustum sees, from
+	// cameras inside, above and outside the forest.
+	struct Camera
+	{
+		XMFLOAT3 Eye;
+		XMFLOAT3 Look;
+		float MaxDistance;
+	};
+	const Camera Cameras[] =
+	{
+		{ XMFLOAT3(0.0f, 10.0f, 100.0f), XMFLOAT3(1.0f, 0.0f, 0.3f), 1000.0f },
+		{ XMFLOAT3(0.0f, 10.0f, 100.0f), XMFLOAT3(-0.2f, -0.1f, -1.0f), 90.0f },
+		{ XMFLOAT3(150.0f, 300.0f, 50.0f), XMFLOAT3(-0.3f, -1.0f, 0.2f), 1000.0f },
+		{ XMFLOAT3(-400.0f, 20.0f, -250.0f), XMFLOAT3(1.0f, 0.0f, 1.0f), 500.0f },
+		{ XMFLOAT3(0.0f, 10.0f, 600.0f), XMFLOAT3(0.0f, 0.0f, 1.0f), 1000.0f },
+	};
+
+	UINT missed = 0;
+	UINT overfull = 0;
+	std::vector<GForest::Sprite> uploaded(trees.size());
+	std::vector<uint64_t> uploadedKeys;
+
+	for (size_t c = 0; c < sizeof(Cameras) / sizeof(Cameras[0]); ++c)
+	{
+		const Camera& camera = Cameras[c];
+		XMFLOAT4 planes[6];
+		GetFrustumPlanes(camera.Eye, camera.Look, planes);
+
+		forest.Cull(planes, camera.Eye, camera.MaxDistance);
+		UINT count = forest.Upload(uploaded.data(), static_cast<UINT>(uploaded.size()));
+		CHECK(count == forest.GetVisibleTreeCount());
+
+		uploadedKeys.resize(count);
+		for (UINT i = 0; i < count; ++i)
+		{
+			uploadedKeys[i] = TreeKey(uploaded[i]);
+		}
+		std::sort(uploadedKeys.begin(), uploadedKeys.end());
+
+		UINT visible = 0;
+		for (size_t i = 0; i < trees.size(); ++i)
+		{
+			if (IsTreeVisible(trees[i], planes, camera.Eye, camera.MaxDistance))
+			{
+				++visible;
+				missed += std::binary_search(uploadedKeys.begin(), uploadedKeys.end(), TreeKey(trees[i])) ? 0 : 1;
+			}
+		}
+
+		// Cells are coarser than trees but should not let through much more than the view holds.
+		overfull += count <= 2 * visible + forest.GetTreeCount() / 10 ? 0 : 1;
+	}
+	CHECK(missed == 0);
+	CHECK(overfull == 0);
+
+	// Single planes swept across the cell edges, along each axis and from both sides, find
+	// any cell whose bounds leave out part of a tree: the half of a billboard that can turn
+	// past the cell's edge, or the crown above the highest ground.
+	UINT sweepMissed = 0;
+	for (UINT axis = 0; axis < 3; ++axis)
+	{
+		for (float sign = -1.0f; sign <= 1.0f; sign += 2.0f)
+		{
+			for (float offset = -6.0f; offset <= 6.0f; offset += 1.5f)
+			{
+				// Cell edges in x; 100 further on they are cell edges in z.
+				const float Edges[] = { -136.0f, -8.0f, 56.0f, 120.0f };
+				for (size_t e = 0; e < sizeof(Edges) / sizeof(Edges[0]); ++e)
+				{
+					// Heights sweep the ground and crowns instead of the cell edges.
+					float at = axis == 1 ? 3.0f * static_cast<float>(e) + offset : (axis == 0 ? Edges[e] : Edges[e] + 100.0f) + offset;
+
+					XMFLOAT4 planes[6];
+					for (UINT p = 0; p < 6; ++p)
+					{
+						planes[p] = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+					}
+					planes[0] = XMFLOAT4(axis == 0 ? sign : 0.0f, axis == 1 ? sign : 0.0f, axis == 2 ? sign : 0.0f, -sign * at);
+
+					XMFLOAT3 eye(0.0f, 0.0f, 0.0f);
+					forest.Cull(planes, eye, 1.0e30f);
+					UINT count = forest.Upload(uploaded.data(), static_cast<UINT>(uploaded.size()));
+
+					uploadedKeys.resize(count);
+					for (UINT i = 0; i < count; ++i)
+					{
+						uploadedKeys[i] = TreeKey(uploaded[i]);
+					}
+					std::sort(uploadedKeys.begin(), uploadedKeys.end());
+
+					for (size_t i = 0; i < trees.size(); ++i)
+					{
+						if (IsTreeVisible(trees[i], planes, eye, 1.0e30f))
+						{
+							sweepMissed += std::binary_search(uploadedKeys.begin(), uploadedKeys.end(), TreeKey(trees[i])) ? 0 : 1;
+						}
+					}
+				}
+			}
+		}
+	}
+	CHECK(sweepMissed == 0);
+
+	// The camera behind the forest looking away sees nothing.
+	{
+		const Camera& away = Cameras[sizeof(Cameras) / sizeof(Cameras[0]) - 1];
+		XMFLOAT4 planes[6];
+		GetFrustumPlanes(away.Eye, away.Look, planes);
+		forest.Cull(planes, away.Eye, away.MaxDistance);
+		CHECK(forest.GetVisibleCellCount() == 0 && forest.Upload(uploaded.data(), static_cast<UINT>(uploaded.size())) == 0);
+	}
+
+	// Cull reports a change only when the visible cells change.
+	{
+		const Camera& camera = Cameras[0];
+		XMFLOAT4 planes[6];
+		GetFrustumPlanes(camera.Eye, camera.Look, planes);
+		CHECK(forest.Cull(planes, camera.Eye, camera.MaxDistance));
+		CHECK(!forest.Cull(planes, camera.Eye, camera.MaxDistance));
+
+		// Too small a buffer takes whole cells, in order, as long as they fit.
+		UINT full = forest.Upload(uploaded.data(), static_cast<UINT>(uploaded.size()));
+		std::vector<GForest::Sprite> prefix(uploaded.begin(), uploaded.begin() + full);
+
+		UINT limit = full / 2;
+		std::vector<GForest::Sprite> partial(limit);
+		UINT written = forest.Upload(partial.data(), limit);
+		CHECK(written <= limit && written > 0);
+		CHECK(memcmp(partial.data(), prefix.data(), written * sizeof(GForest::Sprite)) == 0);
+	}
+
+	// With no density there are no trees, and the empty cells are not kept.
+	{
+		GForest::Desc none = MakeDesc(nullptr, 0.0f, 1);
+		GForest empty;
+		empty.Generate(none);
+		CHECK(empty.GetTreeCount() == 0 && empty.GetCellCount() == 0);
+	}
+}
+
+void TestTextureAtlas()
+{
+	std::mt19937 rng(38);
+
+	// Sprites of every size from 1 texel up, with and without a gutter.
+	const UINT Gutters[] = { 0, 1, 2, 5 };
+	for (size_t g = 0; g < sizeof(Gutters) / sizeof(Gutters[0]); ++g)
+	{
+		const UINT Gutter = Gutters[g];
+		const UINT Count = 40;
+
+		std::vector<UINT> widths(Count);
+		std::vector<UINT> heights(Count);
+		for (UINT i = 0; i < Count; ++i)
+		{
+			widths[i] = 1 + rng() % 70;
+			heights[i] = 1 + rng() % 70;
+		}
+
+		UINT atlasWidth = 0;
+		UINT atlasHeight = 0;
+		std::vector<GTextureAtlas::Rect> rects(Count);
+		if (!CHECK(GTextureAtlas::Pack(widths.data(), heights.data(), Count, Gutter, 2048, atlasWidth, atlasHeight, rects.data())))
+		{
+			continue;
+		}
+		CHECK(IsPowerOfTwo(atlasWidth) && IsPowerOfTwo(atlasHeight));
+
+		// Each padded rect keeps its size, starts on a block and stays inside the atlas; no two
+		// padded rects, rounded out to whole blocks, overlap.
+		UINT badRects = 0;
+		UINT overlaps = 0;
+		for (UINT i = 0; i < Count; ++i)
+		{
+			const GTextureAtlas::Rect& a = rects[i];
+			badRects += a.Width == widths[i] && a.Height == heights[i] &&
+				a.X >= Gutter && a.Y >= Gutter && (a.X - Gutter) % 4 == 0 && (a.Y - Gutter) % 4 == 0 &&
+				a.X + a.Width + Gutter <= atlasWidth && a.Y + a.Height + Gutter <= atlasHeight ? 0 : 1;
+
+			for (UINT j = i + 1; j < Count; ++j)
+			{
+				const GTextureAtlas::Rect& b = rects[j];
+				UINT ax1 = (a.X + a.Width + Gutter + 3) & ~3u;
+				UINT ay1 = (a.Y + a.Height + Gutter + 3) & ~3u;
+				UINT bx1 = (b.X + b.Width + Gutter + 3) & ~3u;
+				UINT by1 = (b.Y + b.Height + Gutter + 3) & ~3u;
+				overlaps += a.X - Gutter < bx1 && b.X - Gutter < ax1 && a.Y - Gutter < by1 && b.Y - Gutter < ay1 ? 1 : 0;
+			}
+		}
+		CHECK(badRects == 0);
+		CHECK(overlaps == 0);
+
+		// The atlas is the smallest that fits: capping the size below it fails.
+		UINT smallerWidth = 0;
+		UINT smallerHeight = 0;
+		std::vector<GTextureAtlas::Rect> unused(Count);
+		CHECK(!GTextureAtlas::Pack(widths.data(), heights.data(), Count, Gutter, atlasWidth / 2,
+			smallerWidth, smallerHeight, unused.data()));
+
+		// Blitting every sprite gives the reference texel by texel, and touches nothing outside
+		// the padded rects.
+		const UINT RowPitch = atlasWidth * 4 + 16;
+		std::vector<uint8_t> atlas(static_cast<size_t>(RowPitch) * atlasHeight, 0xCD);
+		std::vector<std::vector<uint8_t> > sprites(Count);
+		for (UINT i = 0; i < Count; ++i)
+		{
+			sprites[i].resize(4 * static_cast<size_t>(widths[i]) * heights[i]);
+			for (size_t t = 0; t < sprites[i].size(); ++t)
+			{
+				sprites[i][t] = static_cast<uint8_t>(rng() & 0xFF);
+			}
+			GTextureAtlas::Blit(sprites[i].data(), widths[i] * 4, rects[i], Gutter, atlas.data(), atlasWidth, atlasHeight, RowPitch);
+		}
+
+		UINT wrongTexels = 0;
+		for (UINT y = 0; y < atlasHeight; ++y)
+		{
+			for (UINT x = 0; x < atlasWidth; ++x)
+			{
+				uint8_t expected[4] = { 0xCD, 0xCD, 0xCD, 0xCD };
+				for (UINT i = 0; i < Count && !ReferenceTexel(sprites[i], rects[i], Gutter, x, y, expected); ++i)
+				{
+				}
+				wrongTexels += memcmp(&atlas[static_cast<size_t>(y) * RowPitch + 4 * x], expected, 4) == 0 ? 0 : 1;
+			}
+			for (UINT i = atlasWidth * 4; i < RowPitch; ++i)
+			{
+				wrongTexels += atlas[static_cast<size_t>(y) * RowPitch + i] == 0xCD ? 0 : 1;
+			}
+		}
+		CHECK(wrongTexels == 0);
+
+		// The layout reads back as the rects in texture coordinates.
+		const std::wstring LayoutFile = L"AtlasTestLayout.txt";
+		std::vector<XMFLOAT4> uvRects;
+		CHECK(GTextureAtlas::WriteLayout(LayoutFile.c_str(), atlasWidth, atlasHeight, rects.data(), Count));
+		CHECK(GTextureAtlas::ReadLayout(LayoutFile.c_str(), uvRects) && uvRects.size() == Count);
+		RemoveFile(LayoutFile);
+
+		UINT wrongUVs = 0;
+		for (UINT i = 0; i < uvRects.size(); ++i)
+		{
+			wrongUVs += uvRects[i].x == rects[i].X / static_cast<float>(atlasWidth) &&
+				uvRects[i].w == (rects[i].Y + rects[i].Height) / static_cast<float>(atlasHeight) ? 0 : 1;
+		}
+		CHECK(wrongUVs == 0);
+	}
+
+	// Small sets land in the exact size: the square, or the wide half of the next size up.
+	{
+		const UINT Widths[] = { 2, 3, 3, 3, 30 };
+		const UINT Heights[] = { 2, 3, 3, 3, 2 };
+		const UINT Expected[][3] = { { 1, 4, 4 }, { 2, 8, 4 }, { 3, 8, 8 } };
+
+		for (size_t e = 0; e < sizeof(Expected) / sizeof(Expected[0]); ++e)
+		{
+			UINT first = Expected[e][0] == 1 ? 0 : 1;
+			UINT atlasWidth = 0;
+			UINT atlasHeight = 0;
+			GTextureAtlas::Rect rects[3];
+			CHECK(GTextureAtlas::Pack(Widths + first, Heights + first, Expected[e][0], 0, 64, atlasWidth, atlasHeight, rects));
+			CHECK(atlasWidth == Expected[e][1] && atlasHeight == Expected[e][2]);
+		}
+
+		// With its gutter the flat sprite is exactly 32 texels wide.
+		UINT atlasWidth = 0;
+		UINT atlasHeight = 0;
+		GTextureAtlas::Rect rect;
+		CHECK(GTextureAtlas::Pack(Widths + 4, Heights + 4, 1, 1, 64, atlasWidth, atlasHeight, &rect));
+		CHECK(atlasWidth == 32 && atlasHeight == 16);
+	}
+
+	// A sprite wider than the largest atlas does not pack.
+	{
+		UINT width = 300;
+		UINT height = 10;
+		UINT atlasWidth = 0;
+		UINT atlasHeight = 0;
+		GTextureAtlas::Rect rect;
+		CHECK(!GTextureAtlas::Pack(&width, &height, 1, 2, 256, atlasWidth, atlasHeight, &rect));
+	}
+
+	std::vector<XMFLOAT4> missing;
+	CHECK(!GTextureAtlas::ReadLayout(L"AtlasTestMissing.txt", missing));
+}
+
+int BenchForest(int argc, wchar_t* argv[])
+{
+	UINT trees = GetOption(argc, argv, L"trees", 1000000);
+	UINT frames = GetOption(argc, argv, L"frames", 120);
+
+	if (trees == 0 || frames == 0)
+	{
+		wprintf(L"-trees and -frames must be positive.\n");
+		return 1;
+	}
+
+	// The Chapter 11 stress forest: 4-unit cells, with the density set for the tree count.
+	GForest::Desc desc = MakeDesc(nullptr, 1.0f, 1);
+	desc.CellSize = 4.0f;
+	desc.GetHeight = [](float, float) { return 1.0f; };
+	desc.Density = trees / ((AreaMaxX - AreaMinX) * (AreaMaxZ - AreaMinZ));
+
+	GForest forest;
+	Clock::time_point start = Clock::now();
+	forest.Generate(desc);
+	double generateMs = ElapsedMs(start, Clock::now());
+
+	std::vector<GForest::Sprite> buffer(forest.GetTreeCount());
+
+	// The camera turns on the spot, so the visible cells change every frame.
+	double cullMs = 0.0;
+	double uploadMs = 0.0;
+	double visibleTrees = 0.0;
+	for (UINT frame = 0; frame < frames; ++frame)
+	{
+		float angle = frame * 0.01f;
+		XMFLOAT3 eye(0.0f, 10.0f, 100.0f);
+		XMFLOAT3 look(sinf(angle), -0.1f, cosf(angle));
+		XMFLOAT4 planes[6];
+		GetFrustumPlanes(eye, look, planes);
+
+		Clock::time_point t0 = Clock::now();
+		forest.Cull(planes, eye, 1000.0f);
+		Clock::time_point t1 = Clock::now();
+		UINT count = forest.Upload(buffer.data(), static_cast<UINT>(buffer.size()));
+		Clock::time_point t2 = Clock::now();
+
+		cullMs += ElapsedMs(t0, t1);
+		uploadMs += ElapsedMs(t1, t2);
+		visibleTrees += count;
+	}
+
+	wprintf(L"%u trees in %u cells, %u threads\n", forest.GetTreeCount(), forest.GetCellCount(), GThreadPool::Get().GetThreadCount());
+	wprintf(L"  generate: %.2f ms\n", generateMs);
+	wprintf(L"  cull:     %.3f ms per frame\n", cullMs / frames);
+	wprintf(L"  upload:   %.3f ms per frame (%.0f trees)\n", uploadMs / frames, visibleTrees / frames);
+
+	return 0;
+}
\ No newline at end of file
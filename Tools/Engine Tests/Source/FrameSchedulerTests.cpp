@@ -0,0 +1,255 @@
+/*  ===============================================
+	Summary: Frame Scheduler Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GFrameScheduler.h"
+#include "GameTimer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	typedef GFrameScheduler::Clock::duration Duration;
+
+	Duration Seconds(double seconds)
+	{
+		return std::chrono::duration_cast<Duration>(std::chrono::duration<double>(seconds));
+	}
+
+	bool Near(double a, double b, double tolerance)
+	{
+		return fabs(a - b) <= tolerance;
+	}
+
+	// Runs frames deltaTime apart for duration seconds and returns the simulated time, counting the
+	// blend into the step after the last one.  Clears bAlphaInRange if any frame's alpha leaves [0, 1).
+	double Simulate(GFrameScheduler& scheduler, double deltaTime, double duration, uint32_t& steps, bool& bAlphaInRange)
+	{
+		steps = 0;
+		bAlphaInRange = true;
+
+		GFrameScheduler::Clock::time_point now;
+		scheduler.Reset(now);
+
+		uint32_t frames = static_cast<uint32_t>(duration / deltaTime + 0.5);
+		for (uint32_t i = 0; i < frames; ++i)
+		{
+			now += Seconds(deltaTime);
+			steps += scheduler.BeginFrame(deltaTime, now);
+			bAlphaInRange = bAlphaInRange && scheduler.GetAlpha() >= 0.0f && scheduler.GetAlpha() < 1.0f;
+		}
+
+		return (steps + scheduler.GetAlpha()) * scheduler.GetStepTime();
+	}
+}
+
+void TestFrameScheduler()
+{
+	typedef GameTimer::Clock::time_point TimePoint;
+
+	// GameTimer against a fake clock: pauses are not counted and time never runs backwards.
+	GameTimer timer;
+	TimePoint t0;
+	timer.Reset(t0);
+	timer.Tick(t0 + Seconds(0.016));
+	CHECK(Near(timer.DeltaTime(), 0.016, 1e-6));
+	CHECK(Near(timer.TotalTime(), 0.016, 1e-6));
+
+	timer.Stop(t0 + Seconds(0.5));
+	timer.Tick(t0 + Seconds(0.6));
+	CHECK(timer.DeltaTime() == 0.0f);
+	CHECK(Near(timer.TotalTime(), 0.5, 1e-6));
+
+	timer.Start(t0 + Seconds(2.5));
+	timer.Tick(t0 + Seconds(2.6));
+	CHECK(Near(timer.DeltaTime(), 0.1, 1e-6));
+	CHECK(Near(timer.TotalTime(), 0.6, 1e-6));
+
+	timer.Tick(t0 + Seconds(2.0));
+	CHECK(timer.DeltaTime() == 0.0f);
+
+	// A pause after a Stop that is already stopped, as when a window that lost focus is then
+	// minimized, still ends with the first Start.
+	timer.Reset(t0);
+	timer.Stop(t0 + Seconds(1.0));
+	timer.Stop(t0 + Seconds(1.5));
+	timer.Start(t0 + Seconds(60.0));
+	timer.Start(t0 + Seconds(60.01));
+	timer.Tick(t0 + Seconds(60.02));
+	CHECK(Near(timer.DeltaTime(), 0.02, 1e-6));
+	CHECK(Near(timer.TotalTime(), 1.02, 1e-6));
+
+	timer.Reset(t0 + Seconds(10.0));
+	timer.Tick(t0 + Seconds(10.25));
+	CHECK(Near(timer.TotalTime(), 0.25, 1e-6));
+
+	// Without a fixed timestep every frame is one step as long as the frame.
+	GFrameScheduler scheduler;
+	GFrameScheduler::Clock::time_point now;
+	scheduler.Reset(now);
+	CHECK(scheduler.BeginFrame(0.02, now) == 1);
+	CHECK(scheduler.GetStepTime() == 0.02 && scheduler.GetAlpha() == 1.0f);
+
+	// A frame after a stall the timer counted, such as a breakpoint, is cut to the frame time cap.
+	CHECK(scheduler.BeginFrame(30.0, now) == 1 && scheduler.GetStepTime() == 0.25);
+	scheduler.SetMaxFrameTime(0.1);
+	CHECK(scheduler.BeginFrame(0.5, now) == 1 && scheduler.GetStepTime() == 0.1);
+	CHECK(scheduler.BeginFrame(0.02, now) == 1 && scheduler.GetStepTime() == 0.02);
+
+	// With one, the step count follows the frame time and the simulation keeps pace with real time
+	// at any frame rate, to within the blend.
+	const double Step = 1.0 / 60.0;
+	scheduler.SetFixedTimestep(Step);
+
+	const double FrameTimes[] = { 1.0 / 30.0, 1.0 / 60.0, 1.0 / 75.0, 1.0 / 144.0, 1.0 / 500.0 };
+	for (size_t i = 0; i < sizeof(FrameTimes) / sizeof(FrameTimes[0]); ++i)
+	{
+		uint32_t steps = 0;
+		bool bAlphaInRange = false;
+		double simulated = Simulate(scheduler, FrameTimes[i], 2.0, steps, bAlphaInRange);
+		CHECK(bAlphaInRange);
+		CHECK(Near(simulated, 2.0, 1e-6));
+		CHECK(steps >= 119 && steps <= 120);
+	}
+
+	// Two steps per frame at 30 Hz, none on some frames at 144 Hz.
+	scheduler.Reset(now);
+	CHECK(scheduler.BeginFrame(1.0 / 30.0 + 1e-9, now) == 2);
+	scheduler.Reset(now);
+	CHECK(scheduler.BeginFrame(1.0 / 144.0, now) == 0);
+	CHECK(Near(scheduler.GetAlpha(), 60.0 / 144.0, 1e-6));
+
+	// Reset drops the leftover time.
+	scheduler.Reset(now);
+	CHECK(scheduler.GetAlpha() == 0.0f);
+
+	// A stall runs at most the step cap and drops the rest, so the next frame is back to normal.
+	scheduler.SetMaxStepsPerFrame(4);
+	scheduler.Reset(now);
+	CHECK(scheduler.BeginFrame(1.0, now) == 4);
+	CHECK(scheduler.BeginFrame(Step, now) == 1);
+	scheduler.SetMaxStepsPerFrame(0);
+	scheduler.Reset(now);
+	CHECK(scheduler.BeginFrame(1.0, now) == 1);
+
+	// Uncapped, every frame is due.
+	GFrameScheduler capped;
+	GFrameScheduler::Clock::time_point start;
+	capped.Reset(start);
+	CHECK(capped.IsFrameDue(start - Seconds(1.0)));
+	CHECK(!capped.IsTimerPeriodRaised());
+
+	// Capped, deadlines advance by the interval from the last deadline, so a late wake-up does not
+	// push the frames after it back.
+	const double Interval = 0.01;
+	capped.SetFrameRateLimit(1.0 / Interval);
+	capped.Reset(start);
+	CHECK(capped.IsFrameDue(start));
+	capped.BeginFrame(0.0, start);
+	CHECK(capped.GetFrameDeadline() == start + Seconds(Interval));
+	CHECK(!capped.IsFrameDue(start + Seconds(0.5 * Interval)));
+	CHECK(capped.IsFrameDue(start + Seconds(Interval)));
+
+	capped.BeginFrame(Interval, start + Seconds(1.05 * Interval));
+	CHECK(capped.GetFrameDeadline() == start + Seconds(Interval) + Seconds(Interval));
+
+	// A frame more than a whole interval late restarts the cadence from now.
+	GFrameScheduler::Clock::time_point late = start + Seconds(5.5 * Interval);
+	capped.BeginFrame(Interval, late);
+	CHECK(capped.GetFrameDeadline() == late + Seconds(Interval));
+
+	// Removing the cap makes every frame due again and lowers the timer resolution.
+	capped.SetFrameRateLimit(0.0);
+	CHECK(capped.IsFrameDue(start));
+	CHECK(!capped.IsTimerPeriodRaised());
+	CHECK(capped.GetFrameRateLimit() == 0.0);
+
+	capped.SetFrameRateLimit(-5.0);
+	CHECK(capped.GetFrameRateLimit() == 0.0 && !capped.IsTimerPeriodRaised());
+
+	// The real wait keeps a 200 fps cap: 20 frames take 100 ms, give or take scheduling.
+	GFrameScheduler paced;
+	paced.SetFrameRateLimit(200.0);
+	paced.Reset();
+
+	Clock::time_point waitStart = Clock::now();
+	for (int frame = 0; frame < 20; ++frame)
+	{
+		while (!paced.WaitForFrame())
+		{
+		}
+		paced.BeginFrame(0.005);
+	}
+	double waitMs = ElapsedMs(waitStart, Clock::now());
+	CHECK(waitMs >= 94.0);
+	CHECK(waitMs < 400.0);
+}
+
+int BenchFrameScheduler(int argc, wchar_t* argv[])
+{
+	UINT fps = GetOption(argc, argv, L"fps", 144);
+	UINT frames = GetOption(argc, argv, L"frames", 600);
+	UINT spinUs = GetOption(argc, argv, L"spin", 0);
+
+	if (fps == 0 || frames == 0)
+	{
+		wprintf(L"-fps and -frames must be positive.\n");
+		return 1;
+	}
+
+	GFrameScheduler scheduler;
+	scheduler.SetFrameRateLimit(fps);
+	if (spinUs > 0)
+	{
+		scheduler.SetSpinThreshold(std::chrono::microseconds(spinUs));
+	}
+	scheduler.Reset();
+
+	// Time between frame starts; nothing runs between frames, so this measures the wait alone.
+	std::vector<double> intervals;
+	intervals.reserve(frames);
+
+	Clock::time_point begin = Clock::now();
+	Clock::time_point previous = begin;
+	for (UINT frame = 0; frame <= frames; ++frame)
+	{
+		while (!scheduler.WaitForFrame())
+		{
+		}
+
+		Clock::time_point now = Clock::now();
+		if (frame > 0)
+		{
+			intervals.push_back(ElapsedMs(previous, now));
+		}
+		previous = now;
+
+		scheduler.BeginFrame(0.0);
+	}
+	double totalMs = ElapsedMs(begin, previous);
+
+	double target = 1000.0 / fps;
+	double sum = 0.0;
+	double sumSq = 0.0;
+	for (size_t i = 0; i < intervals.size(); ++i)
+	{
+		sum += intervals[i];
+		sumSq += (intervals[i] - target) * (intervals[i] - target);
+	}
+
+	std::sort(intervals.begin(), intervals.end());
+
+	wprintf(L"%u frames capped at %u fps, target %.3f ms\n", frames, fps, target);
+	wprintf(L"  mean: %.3f ms (%.1f fps overall)\n", sum / intervals.size(), frames * 1000.0 / totalMs);
+	wprintf(L"  min:  %.3f ms\n", intervals.front());
+	wprintf(L"  p99:  %.3f ms\n", intervals[(intervals.size() * 99) / 100]);
+	wprintf(L"  max:  %.3f ms\n", intervals.back());
+	wprintf(L"  rms error: %.3f ms\n", sqrt(sumSq / intervals.size()));
+	wprintf(L"  timer period raised: %ls\n", scheduler.IsTimerPeriodRaised() ? L"yes" : L"no");
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+/*  ===============================================
+	Summary: Headless Renderer Golden-Image Tests
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GSoftRasterizer.h"
+#include "../../Headless Renderer/Source/Scenes.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	// The reference images in Tools/Headless Renderer/Golden are rendered at this size.  To
+	// regenerate them after an intended change, run from the Headless Renderer folder:
+	//   HeadlessRenderer lighting Golden/lighting.dds -size 400 300
+	//   HeadlessRenderer crate Golden/crate.dds -size 400 300
+	const UINT GoldenWidth = 400;
+	const UINT GoldenHeight = 300;
+
+	// The Headless Renderer's default -psnr.
+	const double MinPSNR = 40.0;
+
+	struct GoldenScene
+	{
+		const wchar_t* Name;
+		const wchar_t* DataDir;
+		bool (*Build)(const std::wstring& dataDir, Scenes::Scene& scene);
+	};
+}
+
+void TestHeadlessRender()
+{
+	std::wstring root = FindRepoRoot();
+	if (!CHECK(!root.empty()))
+	{
+		return;
+	}
+
+	const GoldenScene Goldens[] =
+	{
+		{ L"lighting", L"Chapter 07/Lighting/", Scenes::BuildLightingScene },
+		{ L"crate", L"Chapter 08/Texturing/", Scenes::BuildCrateScene },
+	};
+
+	GSoftRasterizer rasterizer;
+	rasterizer.Resize(GoldenWidth, GoldenHeight);
+
+	for (size_t i = 0; i < sizeof(Goldens) / sizeof(Goldens[0]); ++i)
+	{
+		Scenes::Scene scene;
+		if (!CHECK(Goldens[i].Build(root + Goldens[i].DataDir, scene)))
+		{
+			continue;
+		}
+
+		std::wstring golden = root + L"Tools/Headless Renderer/Golden/" + Goldens[i].Name + L".dds";
+
+		Scenes::RenderScene(scene, rasterizer);
+		double psnr = Scenes::CompareWithGolden(golden, rasterizer);
+		if (!CHECK(psnr >= MinPSNR))
+		{
+			fwprintf(stderr, L"  %s: PSNR %.2f dB against %s\n", Goldens[i].Name, psnr, golden.c_str());
+		}
+
+		// The tiles are shaded on the thread pool, but a second frame gives the same pixels.
+		const uint8_t* color = rasterizer.GetColorBuffer();
+		std::vector<uint8_t> first(color, color + static_cast<size_t>(GoldenWidth) * GoldenHeight * 4);
+		Scenes::RenderScene(scene, rasterizer);
+		CHECK(memcmp(first.data(), rasterizer.GetColorBuffer(), first.size()) == 0);
+
+		// The comparison can fail: the camera turned by three degrees falls well below it.
+		scene.Theta += 0.05f;
+		Scenes::RenderScene(scene, rasterizer);
+		double turnedPSNR = Scenes::CompareWithGolden(golden, rasterizer);
+		if (!CHECK(turnedPSNR >= 0.0 && turnedPSNR < MinPSNR))
+		{
+			fwprintf(stderr, L"  %s: PSNR %.2f dB with the camera turned\n", Goldens[i].Name, turnedPSNR);
+		}
+	}
+}
\ No newline at end of file
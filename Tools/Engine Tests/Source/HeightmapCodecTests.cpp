@@ -0,0 +1,255 @@
+/*  ===============================================
+	Summary: Heightmap Codec Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GHeightmapCodec.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Written past the end of every output, to catch the vector loops overrunning.
+	const uint16_t CodeGuard = 0xBEEF;
+	const float HeightGuard = -12345.0f;
+	const size_t GuardCount = 8;
+
+	//
+	// One element at a time, as the scalar tails do it.
+	//
+
+	void ReferenceFindRange(const float* heights, size_t count, float& minHeight, float& maxHeight)
+	{
+		minHeight = count > 0 ? heights[0] : 0.0f;
+		maxHeight = minHeight;
+		for (size_t i = 1; i < count; ++i)
+		{
+			minHeight = (std::min)(minHeight, heights[i]);
+			maxHeight = (std::max)(maxHeight, heights[i]);
+		}
+	}
+
+	void ReferenceEncode(const float* heights, size_t count, float minHeight, float step, uint16_t* codes)
+	{
+		float invStep = step > 0.0f ? 1.0f / step : 0.0f;
+		for (size_t i = 0; i < count; ++i)
+		{
+			float code = (heights[i] - minHeight) * invStep + 0.5f;
+			code = (std::min)((std::max)(code, 0.0f), static_cast<float>(GHeightmapCodec::MaxCode));
+			codes[i] = static_cast<uint16_t>(code);
+		}
+	}
+
+	void ReferenceDecode(const uint16_t* codes, size_t count, float minHeight, float step, float* heights)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			heights[i] = minHeight + codes[i] * step;
+		}
+	}
+
+	void MakeHeights(size_t count, float lo, float hi, std::mt19937& rng, std::vector<float>& heights)
+	{
+		std::uniform_real_distribution<float> height(lo, hi);
+		heights.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			heights[i] = height(rng);
+		}
+	}
+}
+
+void TestHeightmapCodec()
+{
+	std::mt19937 rng(37);
+
+	// Lengths around the four-wide range search and the eight-wide encoder and decoder, each
+	// also started one float in, so the loads are unaligned.
+	const size_t Lengths[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 11, 12, 13, 15, 16, 17, 23, 31, 33, 63, 1021, 4099 };
+
+	UINT rangeMismatches = 0;
+	UINT codeMismatches = 0;
+	UINT heightMismatches = 0;
+	UINT overruns = 0;
+	double worstRoundTrip = 0.0;
+
+	for (size_t l = 0; l < sizeof(Lengths) / sizeof(Lengths[0]); ++l)
+	{
+		for (size_t offset = 0; offset < 2; ++offset)
+		{
+			const size_t count = Lengths[l];
+
+			std::vector<float> source;
+			MakeHeights(count + offset, -40.0f, 360.0f, rng, source);
+			const float* heights = source.data() + offset;
+
+			// Put the extremes in the scalar tail now and then, so it has to find them.
+			if (count > 2 && (l % 2) == 1)
+			{
+				source[offset + count - 1] = 500.0f;
+				source[offset + count - 2] = -100.0f;
+			}
+
+			float minHeight, maxHeight, refMin, refMax;
+			GHeightmapCodec::FindRange(heights, count, minHeight, maxHeight);
+			ReferenceFindRange(heights, count, refMin, refMax);
+			rangeMismatches += minHeight == refMin && maxHeight == refMax ? 0 : 1;
+
+			float step = GHeightmapCodec::GetStep(minHeight, maxHeight);
+
+			std::vector<uint16_t> codes(count + GuardCount, CodeGuard);
+			std::vector<uint16_t> refCodes(count);
+			GHeightmapCodec::Encode(heights, count, minHeight, step, codes.data());
+			ReferenceEncode(heights, count, minHeight, step, refCodes.data());
+
+			std::vector<float> decoded(count + GuardCount, HeightGuard);
+			std::vector<float> refDecoded(count);
+			GHeightmapCodec::Decode(codes.data(), count, minHeight, step, decoded.data());
+			ReferenceDecode(refCodes.data(), count, minHeight, step, refDecoded.data());
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				codeMismatches += codes[i] == refCodes[i] ? 0 : 1;
+				heightMismatches += decoded[i] == refDecoded[i] ? 0 : 1;
+
+				// Within half a step, give or take float rounding at the height's magnitude.
+				double error = fabs(static_cast<double>(decoded[i]) - heights[i]);
+				double allowed = 0.5 * step + 4.0 * FLT_EPSILON * (std::max)(fabs(minHeight), fabs(maxHeight));
+				worstRoundTrip = (std::max)(worstRoundTrip, error / allowed);
+			}
+
+			for (size_t i = count; i < count + GuardCount; ++i)
+			{
+				overruns += codes[i] == CodeGuard && decoded[i] == HeightGuard ? 0 : 1;
+			}
+		}
+	}
+
+	CHECK(rangeMismatches == 0);
+	CHECK(codeMismatches == 0);
+	CHECK(heightMismatches == 0);
+	CHECK(overruns == 0);
+	if (!CHECK(worstRoundTrip <= 1.0))
+	{
+		fwprintf(stderr, L"  round trip error is %.3f times half a step\n", worstRoundTrip);
+	}
+
+	// The range ends map to the first and last codes and decode exactly.
+	{
+		const float Heights[] = { 10.0f, 20.0f, 12.5f, 19.75f, 10.0f, 20.0f, 15.0f, 11.0f, 20.0f };
+		const size_t Count = sizeof(Heights) / sizeof(Heights[0]);
+
+		float minHeight, maxHeight;
+		GHeightmapCodec::FindRange(Heights, Count, minHeight, maxHeight);
+		CHECK(minHeight == 10.0f && maxHeight == 20.0f);
+
+		float step = GHeightmapCodec::GetStep(minHeight, maxHeight);
+		uint16_t codes[Count];
+		float decoded[Count];
+		GHeightmapCodec::Encode(Heights, Count, minHeight, step, codes);
+		GHeightmapCodec::Decode(codes, Count, minHeight, step, decoded);
+		CHECK(codes[0] == 0 && codes[1] == GHeightmapCodec::MaxCode && codes[8] == GHeightmapCodec::MaxCode);
+		CHECK(decoded[0] == 10.0f && fabs(decoded[1] - 20.0f) <= 0.5f * step);
+	}
+
+	// Heights outside the range clamp to the end codes, in the vector loop and the tail alike.
+	{
+		std::vector<float> heights(19);
+		for (size_t i = 0; i < heights.size(); ++i)
+		{
+			heights[i] = (i % 2) == 0 ? -1000.0f : 1000.0f;
+		}
+
+		std::vector<uint16_t> codes(heights.size());
+		GHeightmapCodec::Encode(heights.data(), heights.size(), 0.0f, GHeightmapCodec::GetStep(0.0f, 1.0f), codes.data());
+
+		UINT unclamped = 0;
+		for (size_t i = 0; i < codes.size(); ++i)
+		{
+			unclamped += codes[i] == ((i % 2) == 0 ? 0 : GHeightmapCodec::MaxCode) ? 0 : 1;
+		}
+		CHECK(unclamped == 0);
+	}
+
+	// A flat tile has no step; every code is 0 and decodes to the tile's height.
+	{
+		std::vector<float> heights(21, 7.25f);
+		float minHeight, maxHeight;
+		GHeightmapCodec::FindRange(heights.data(), heights.size(), minHeight, maxHeight);
+		float step = GHeightmapCodec::GetStep(minHeight, maxHeight);
+		CHECK(step == 0.0f);
+
+		std::vector<uint16_t> codes(heights.size(), CodeGuard);
+		std::vector<float> decoded(heights.size());
+		GHeightmapCodec::Encode(heights.data(), heights.size(), minHeight, step, codes.data());
+		GHeightmapCodec::Decode(codes.data(), codes.size(), minHeight, step, decoded.data());
+		CHECK(std::count(codes.begin(), codes.end(), 0) == static_cast<ptrdiff_t>(codes.size()));
+		CHECK(std::count(decoded.begin(), decoded.end(), 7.25f) == static_cast<ptrdiff_t>(decoded.size()));
+	}
+
+	// An empty range reads nothing.
+	float emptyMin = 1.0f, emptyMax = 1.0f;
+	GHeightmapCodec::FindRange(nullptr, 0, emptyMin, emptyMax);
+	CHECK(emptyMin == 0.0f && emptyMax == 0.0f);
+}
+
+int BenchHeightmapCodec(int argc, wchar_t* argv[])
+{
+	UINT count = GetOption(argc, argv, L"count", 2049 * 2049);
+	UINT runs = GetOption(argc, argv, L"runs", 20);
+
+	if (count == 0 || runs == 0)
+	{
+		wprintf(L"-count and -runs must be positive.\n");
+		return 1;
+	}
+
+	std::mt19937 rng(37);
+	std::vector<float> heights;
+	MakeHeights(count, 0.0f, 300.0f, rng, heights);
+
+	std::vector<uint16_t> codes(count);
+	std::vector<float> decoded(count);
+
+	float minHeight = 0.0f, maxHeight = 0.0f;
+	double best[6] = { DBL_MAX, DBL_MAX, DBL_MAX, DBL_MAX, DBL_MAX, DBL_MAX };
+
+	for (UINT run = 0; run < runs; ++run)
+	{
+		Clock::time_point t0 = Clock::now();
+		GHeightmapCodec::FindRange(heights.data(), count, minHeight, maxHeight);
+		Clock::time_point t1 = Clock::now();
+		float step = GHeightmapCodec::GetStep(minHeight, maxHeight);
+		GHeightmapCodec::Encode(heights.data(), count, minHeight, step, codes.data());
+		Clock::time_point t2 = Clock::now();
+		GHeightmapCodec::Decode(codes.data(), count, minHeight, step, decoded.data());
+		Clock::time_point t3 = Clock::now();
+
+		ReferenceFindRange(heights.data(), count, minHeight, maxHeight);
+		Clock::time_point t4 = Clock::now();
+		ReferenceEncode(heights.data(), count, minHeight, step, codes.data());
+		Clock::time_point t5 = Clock::now();
+		ReferenceDecode(codes.data(), count, minHeight, step, decoded.data());
+		Clock::time_point t6 = Clock::now();
+
+		best[0] = (std::min)(best[0], ElapsedMs(t0, t1));
+		best[1] = (std::min)(best[1], ElapsedMs(t1, t2));
+		best[2] = (std::min)(best[2], ElapsedMs(t2, t3));
+		best[3] = (std::min)(best[3], ElapsedMs(t3, t4));
+		best[4] = (std::min)(best[4], ElapsedMs(t4, t5));
+		best[5] = (std::min)(best[5], ElapsedMs(t5, t6));
+	}
+
+	wprintf(L"%u heights, best of %u runs (SSE2 vs one at a time)\n", count, runs);
+	wprintf(L"  range:  %.3f ms vs %.3f ms\n", best[0], best[3]);
+	wprintf(L"  encode: %.3f ms vs %.3f ms\n", best[1], best[4]);
+	wprintf(L"  decode: %.3f ms vs %.3f ms\n", best[2], best[5]);
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,326 @@
+/*  ===============================================
+	Summary: Heightmap Stream Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GHeightmapStream.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const char* const TestFileName = "HeightmapStreamTest.raw";
+	const wchar_t* const TestFile = L"HeightmapStreamTest.raw";
+	const float HeightScale = 50.0f;
+	const UINT TileSize = 16;
+
+	uint16_t SampleCode(UINT x, UINT z)
+	{
+		float h = 0.5f + 0.3f * sinf(x * 0.11f) + 0.15f * cosf(z * 0.07f + x * 0.02f);
+		return static_cast<uint16_t>(h * 65535.0f);
+	}
+
+	float SampleHeight(UINT x, UINT z)
+	{
+		return SampleCode(x, z) * (HeightScale / 65535.0f);
+	}
+
+	bool WriteBytes(const char* filename, const void* data, size_t size)
+	{
+		FILE* file = fopen(filename, "wb");
+		if (!file)
+		{
+			return false;
+		}
+		bool bOk = fwrite(data, 1, size, file) == size;
+		return fclose(file) == 0 && bOk;
+	}
+
+	// Little-endian 16-bit samples, row by row.
+	bool WriteR16(const char* filename, UINT width, UINT depth)
+	{
+		std::vector<uint8_t> bytes(static_cast<size_t>(width) * depth * 2);
+		for (UINT z = 0; z < depth; ++z)
+		{
+			for (UINT x = 0; x < width; ++x)
+			{
+				uint16_t code = SampleCode(x, z);
+				size_t i = (static_cast<size_t>(z) * width + x) * 2;
+				bytes[i] = static_cast<uint8_t>(code & 0xff);
+				bytes[i + 1] = static_cast<uint8_t>(code >> 8);
+			}
+		}
+		return WriteBytes(filename, bytes.data(), bytes.size());
+	}
+
+	bool IsResident(const GHeightmapStream& stream, UINT tileX, UINT tileZ)
+	{
+		float height = 0.0f;
+		return stream.GetSample(tileX * stream.GetTileSize() + 1, tileZ * stream.GetTileSize() + 1, height);
+	}
+
+	// Streams in the single tile under the point and waits for it.
+	void Visit(GHeightmapStream& stream, UINT tileX, UINT tileZ)
+	{
+		float half = stream.GetTileSize() * 0.5f;
+		stream.Update(tileX * stream.GetTileSize() + half, tileZ * stream.GetTileSize() + half);
+		stream.Flush();
+	}
+
+	UINT64 TileBytes(UINT tileSize)
+	{
+		return static_cast<UINT64>(tileSize + 1) * (tileSize + 1) * sizeof(uint16_t);
+	}
+
+	// Largest error of every decoded tile sample against the source, in steps of that tile.
+	// Samples past the map's edge must repeat the last row or column.
+	bool CheckTiles(const GHeightmapStream& stream, UINT& nonResident)
+	{
+		UINT stride = stream.GetTileSize() + 1;
+		std::vector<float> decoded(static_cast<size_t>(stride) * stride);
+
+		nonResident = 0;
+		bool bOk = true;
+		for (UINT tz = 0; tz < stream.GetTilesZ(); ++tz)
+		{
+			for (UINT tx = 0; tx < stream.GetTilesX(); ++tx)
+			{
+				if (!stream.DecodeTile(tx, tz, decoded.data()))
+				{
+					++nonResident;
+					continue;
+				}
+
+				// A tile spans at most the full code range, so half a step is at most this.
+				const float tolerance = HeightScale / 65535.0f;
+				for (UINT row = 0; row < stride; ++row)
+				{
+					for (UINT col = 0; col < stride; ++col)
+					{
+						UINT x = (std::min)(tx * stream.GetTileSize() + col, stream.GetWidth() - 1);
+						UINT z = (std::min)(tz * stream.GetTileSize() + row, stream.GetDepth() - 1);
+						bOk = bOk && fabsf(decoded[row * stride + col] - SampleHeight(x, z)) <= tolerance;
+					}
+				}
+			}
+		}
+		return bOk;
+	}
+}
+
+void TestHeightmapStream()
+{
+	GHeightmapStream stream;
+
+	// Files that cannot hold the requested size are refused.
+	CHECK(!stream.Open(L"NoSuchHeightmap.raw", GHeightmapStream::FORMAT_R16, HeightScale));
+
+	const UINT Width = TileSize * 6 + 1;
+	const UINT Depth = TileSize * 4 + 1;
+	if (!CHECK(WriteR16(TestFileName, Width, Depth)))
+	{
+		return;
+	}
+
+	CHECK(!stream.Open(TestFile, GHeightmapStream::FORMAT_R16, HeightScale, Width, Depth + 1, TileSize));
+	CHECK(!stream.Open(TestFile, GHeightmapStream::FORMAT_R16, HeightScale, Width, Depth, 0));
+
+	CHECK(stream.Open(TestFile, GHeightmapStream::FORMAT_R16, HeightScale, Width, Depth, TileSize));
+	CHECK(stream.GetTilesX() == 6 && stream.GetTilesZ() == 4);
+
+	// Regions convert straight from the file into a pitched buffer.
+	const UINT Pitch = 40;
+	std::vector<float> region(Pitch * 20, -1.0f);
+	stream.ReadRegion(50, 30, 33, 20, region.data(), Pitch);
+
+	UINT regionErrors = 0;
+	for (UINT z = 0; z < 20; ++z)
+	{
+		for (UINT x = 0; x < Pitch; ++x)
+		{
+			float expected = x < 33 ? SampleHeight(50 + x, 30 + z) : -1.0f;
+			regionErrors += fabsf(region[z * Pitch + x] - expected) <= 1e-4f ? 0 : 1;
+		}
+	}
+	CHECK(regionErrors == 0);
+
+	// The budget holds five tiles, so a radius covering the whole map keeps the five nearest.
+	const UINT64 tileBytes = TileBytes(TileSize);
+	stream.SetMemoryBudget(tileBytes * 5);
+	stream.SetStreamRadius(1000.0f);
+	stream.Update(1.0f, 1.0f);
+	CHECK(stream.GetResidentTileCount() + stream.GetPendingTileCount() <= 5);
+	stream.Flush();
+	CHECK(stream.GetResidentTileCount() == 5 && stream.GetPendingTileCount() == 0);
+	CHECK(stream.GetResidentBytes() <= tileBytes * 5);
+	CHECK(IsResident(stream, 0, 0) && IsResident(stream, 1, 0) && IsResident(stream, 0, 1) && IsResident(stream, 1, 1));
+	CHECK(!IsResident(stream, 5, 3) && !IsResident(stream, 3, 3));
+
+	// Moving across the map never goes over the budget.
+	UINT overBudget = 0;
+	for (UINT i = 0; i < 40; ++i)
+	{
+		stream.Update(static_cast<float>((i * 37) % Width), static_cast<float>((i * 23) % Depth));
+		overBudget += stream.GetResidentTileCount() + stream.GetPendingTileCount() <= 5 ? 0 : 1;
+	}
+	stream.Flush();
+	CHECK(overBudget == 0);
+	CHECK(stream.GetResidentTileCount() <= 5 && stream.GetPendingTileCount() == 0);
+
+	// After requests were superseded mid-flight, the last position's tiles all arrive.
+	stream.Update(Width - 2.0f, Depth - 2.0f);
+	stream.Flush();
+	CHECK(IsResident(stream, 5, 3));
+
+	// Three tiles' budget: the least recently used tile goes first, and touching one saves it.
+	stream.SetMemoryBudget(tileBytes * 3);
+	stream.SetStreamRadius(0.0f);
+	Visit(stream, 0, 0);
+	Visit(stream, 1, 0);
+	Visit(stream, 2, 0);
+	CHECK(stream.GetResidentTileCount() == 3);
+	CHECK(IsResident(stream, 0, 0) && IsResident(stream, 1, 0) && IsResident(stream, 2, 0));
+
+	UINT evictsBefore = stream.GetEvictCount();
+	Visit(stream, 0, 0);
+	Visit(stream, 3, 0);
+	CHECK(stream.GetEvictCount() == evictsBefore + 1);
+	CHECK(IsResident(stream, 0, 0) && !IsResident(stream, 1, 0) && IsResident(stream, 2, 0) && IsResident(stream, 3, 0));
+
+	Visit(stream, 4, 0);
+	CHECK(IsResident(stream, 0, 0) && !IsResident(stream, 2, 0) && IsResident(stream, 3, 0) && IsResident(stream, 4, 0));
+
+	// With every tile resident, shared borders and interiors decode to the source heights.
+	stream.SetMemoryBudget(tileBytes * 64);
+	stream.SetStreamRadius(1000.0f);
+	stream.Update(0.0f, 0.0f);
+	stream.Flush();
+
+	UINT nonResident = 0;
+	CHECK(CheckTiles(stream, nonResident));
+	CHECK(nonResident == 0);
+
+	float height = 0.0f;
+	CHECK(stream.GetSample(Width - 1, Depth - 1, height) && fabsf(height - SampleHeight(Width - 1, Depth - 1)) <= HeightScale / 65535.0f);
+	CHECK(!stream.GetSample(Width, 0, height));
+
+	// A map that does not split into whole tiles repeats its last row and column.
+	stream.Close();
+	const UINT OddWidth = 90;
+	const UINT OddDepth = 70;
+	CHECK(WriteR16(TestFileName, OddWidth, OddDepth));
+	CHECK(stream.Open(TestFile, GHeightmapStream::FORMAT_R16, HeightScale, OddWidth, OddDepth, TileSize));
+	CHECK(stream.GetTilesX() == 6 && stream.GetTilesZ() == 5);
+	stream.SetStreamRadius(1000.0f);
+	stream.Update(0.0f, 0.0f);
+	stream.Flush();
+	CHECK(CheckTiles(stream, nonResident));
+	CHECK(nonResident == 0);
+
+	// Closing while the loader is mid-job waits for it and leaves nothing behind; the stream
+	// then reopens cleanly.
+	UINT leftovers = 0;
+	for (int i = 0; i < 50; ++i)
+	{
+		if (!stream.Open(TestFile, GHeightmapStream::FORMAT_R16, HeightScale, OddWidth, OddDepth, 4))
+		{
+			++leftovers;
+			continue;
+		}
+		stream.SetStreamRadius(1000.0f);
+		stream.Update(static_cast<float>(i), 0.0f);
+		stream.Close();
+
+		stream.Flush();
+		leftovers += stream.GetResidentTileCount() + stream.GetPendingTileCount();
+		leftovers += stream.GetSample(0, 0, height) ? 1 : 0;
+		stream.Update(0.0f, 0.0f);
+		leftovers += stream.GetPendingTileCount();
+	}
+	CHECK(leftovers == 0);
+
+	// Eight-bit and float samples convert with the scale.
+	stream.Close();
+	const uint8_t bytes8[4] = { 0, 51, 204, 255 };
+	CHECK(WriteBytes(TestFileName, bytes8, sizeof(bytes8)));
+	CHECK(stream.Open(TestFile, GHeightmapStream::FORMAT_R8, 10.0f));
+	float converted[4];
+	stream.ReadRegion(0, 0, 2, 2, converted, 2);
+	CHECK(stream.GetWidth() == 2 && converted[0] == 0.0f && fabsf(converted[1] - 2.0f) < 1e-5f && fabsf(converted[3] - 10.0f) < 1e-5f);
+
+	stream.Close();
+	const float floats[4] = { -1.5f, 0.0f, 2.25f, 100.0f };
+	CHECK(WriteBytes(TestFileName, floats, sizeof(floats)));
+	CHECK(stream.Open(TestFile, GHeightmapStream::FORMAT_R32F, 2.0f));
+	stream.ReadRegion(0, 0, 2, 2, converted, 2);
+	CHECK(converted[0] == -3.0f && converted[2] == 4.5f && converted[3] == 200.0f);
+
+	stream.Close();
+	remove(TestFileName);
+}
+
+int BenchHeightmapStream(int argc, wchar_t* argv[])
+{
+	UINT tiles = GetOption(argc, argv, L"tiles", 32);
+	UINT tileSize = GetOption(argc, argv, L"tile", 256);
+	UINT budgetMB = GetOption(argc, argv, L"budget", 16);
+	UINT frames = GetOption(argc, argv, L"frames", 600);
+	UINT frameUs = GetOption(argc, argv, L"frameus", 4000);
+
+	UINT width = tiles * tileSize + 1;
+	wprintf(L"Writing a %u x %u map...\n", width, width);
+	if (!WriteR16(TestFileName, width, width))
+	{
+		wprintf(L"Cannot write %hs.\n", TestFileName);
+		return 1;
+	}
+
+	GHeightmapStream stream;
+	if (!stream.Open(TestFile, GHeightmapStream::FORMAT_R16, HeightScale, width, width, tileSize))
+	{
+		wprintf(L"Cannot open %hs.\n", TestFileName);
+		remove(TestFileName);
+		return 1;
+	}
+
+	stream.SetMemoryBudget(static_cast<UINT64>(budgetMB) * 1024 * 1024);
+	stream.SetStreamRadius(tileSize * 2.5f);
+
+	// A camera crossing the map, with each frame padded to frameUs so the loader runs alongside
+	// as it would behind rendering.
+	double worstMs = 0.0;
+	double totalMs = 0.0;
+	UINT misses = 0;
+	for (UINT frame = 0; frame < frames; ++frame)
+	{
+		float t = static_cast<float>(frame) / frames;
+		float x = t * (width - 1);
+		float z = (0.5f + 0.4f * sinf(t * 6.28f)) * (width - 1);
+
+		Clock::time_point start = Clock::now();
+		stream.Update(x, z);
+		double ms = ElapsedMs(start, Clock::now());
+
+		totalMs += ms;
+		worstMs = (std::max)(worstMs, ms);
+
+		float height = 0.0f;
+		misses += stream.GetSample(static_cast<UINT>(x), static_cast<UINT>(z), height) ? 0 : 1;
+
+		std::this_thread::sleep_until(start + std::chrono::microseconds(frameUs));
+	}
+
+	wprintf(L"%u x %u tiles of %u, %u MB budget, %u frames of %u us\n", tiles, tiles, tileSize, budgetMB, frames, frameUs);
+	wprintf(L"  update: %.4f ms average, %.4f ms worst\n", totalMs / frames, worstMs);
+	wprintf(L"  loads %u, evictions %u, resident %.1f MB\n", stream.GetLoadCount(), stream.GetEvictCount(),
+		stream.GetResidentBytes() / (1024.0 * 1024.0));
+	wprintf(L"  frames with the camera's tile not yet resident: %u\n", misses);
+
+	stream.Close();
+	remove(TestFileName);
+	return 0;
+}
\ No newline at end of file
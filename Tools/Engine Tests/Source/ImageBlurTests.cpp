@@ -0,0 +1,485 @@
+/*  ===============================================
+	Summary: CPU Blur Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GImageBlur.h"
+
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	// The fixed taps of BlurPS.hlsl and the compute shader blurs.
+	const float ShaderWeights[11] = { 0.05f, 0.05f, 0.1f, 0.1f, 0.1f, 0.2f, 0.1f, 0.1f, 0.1f, 0.05f, 0.05f };
+	const UINT ShaderRadius = 5;
+
+	// BlurPS.hlsl's edge tests.
+	const float NormalThreshold = 0.8f;
+	const float DepthThreshold = 0.2f;
+
+	// Written into the padding at the end of every row, which the blur must leave alone.
+	const uint8_t PadByte = 0xCD;
+	const UINT PadBytes = 12;
+
+	UINT GetChannelCount(GImageBlur::Format format)
+	{
+		return format == GImageBlur::FORMAT_R32_FLOAT ? 1 : 4;
+	}
+
+	UINT GetPixelBytes(GImageBlur::Format format)
+	{
+		return format == GImageBlur::FORMAT_R32_FLOAT ? 4 : (format == GImageBlur::FORMAT_R32G32B32A32_FLOAT ? 16 : 8);
+	}
+
+	// Pixels as floats, rows of width * channels.
+	struct Image
+	{
+		UINT Width;
+		UINT Height;
+		UINT Channels;
+		std::vector<double> Values;
+
+		inline double& At(UINT x, UINT y, UINT c) { return Values[(static_cast<size_t>(y) * Width + x) * Channels + c]; }
+	};
+
+	void Pack(const Image& image, GImageBlur::Format format, UINT rowPitch, std::vector<uint8_t>& bytes)
+	{
+		bytes.assign(static_cast<size_t>(rowPitch) * image.Height, PadByte);
+		UINT count = image.Width * image.Channels;
+		for (UINT y = 0; y < image.Height; ++y)
+		{
+			uint8_t* row = &bytes[static_cast<size_t>(y) * rowPitch];
+			for (UINT i = 0; i < count; ++i)
+			{
+				float value = static_cast<float>(image.Values[static_cast<size_t>(y) * count + i]);
+				if (format == GImageBlur::FORMAT_R16G16B16A16_FLOAT)
+				{
+					HALF half = XMConvertFloatToHalf(value);
+					memcpy(row + i * sizeof(HALF), &half, sizeof(HALF));
+				}
+				else
+				{
+					memcpy(row + i * sizeof(float), &value, sizeof(float));
+				}
+			}
+		}
+	}
+
+	void Unpack(const std::vector<uint8_t>& bytes, GImageBlur::Format format, UINT rowPitch, Image& image)
+	{
+		UINT count = image.Width * image.Channels;
+		for (UINT y = 0; y < image.Height; ++y)
+		{
+			const uint8_t* row = &bytes[static_cast<size_t>(y) * rowPitch];
+			for (UINT i = 0; i < count; ++i)
+			{
+				float value;
+				if (format == GImageBlur::FORMAT_R16G16B16A16_FLOAT)
+				{
+					HALF half;
+					memcpy(&half, row + i * sizeof(HALF), sizeof(HALF));
+					value = XMConvertHalfToFloat(half);
+				}
+				else
+				{
+					memcpy(&value, row + i * sizeof(float), sizeof(float));
+				}
+				image.Values[static_cast<size_t>(y) * count + i] = value;
+			}
+		}
+	}
+
+	// A sixteen-bit image holds what the blur stores back after each pass.
+	void RoundToFormat(GImageBlur::Format format, Image& image)
+	{
+		for (size_t i = 0; i < image.Values.size(); ++i)
+		{
+			float value = static_cast<float>(image.Values[i]);
+			image.Values[i] = format == GImageBlur::FORMAT_R16G16B16A16_FLOAT ? XMConvertHalfToFloat(XMConvertFloatToHalf(value)) : value;
+		}
+	}
+
+	//
+	// One pixel and one tap at a time in double precision, reading clamped coordinates.
+	// Neighbours are kept or dropped by the same float tests as BlurPS.hlsl.
+	//
+
+	bool KeepNeighbour(const XMFLOAT4& center, const XMFLOAT4& neighbour)
+	{
+		float dot = center.x * neighbour.x + center.y * neighbour.y + center.z * neighbour.z;
+		return dot >= NormalThreshold && fabsf(neighbour.w - center.w) <= DepthThreshold;
+	}
+
+	void ReferenceBlur(GImageBlur::Format format, const std::vector<float>& weights, const XMFLOAT4* normalDepth,
+		UINT numPasses, Image& image)
+	{
+		const int radius = static_cast<int>(weights.size() / 2);
+		const int width = static_cast<int>(image.Width);
+		const int height = static_cast<int>(image.Height);
+
+		for (UINT pass = 0; pass < numPasses; ++pass)
+		{
+			for (int direction = 0; direction < 2; ++direction)
+			{
+				Image source = image;
+				for (int y = 0; y < height; ++y)
+				{
+					for (int x = 0; x < width; ++x)
+					{
+						for (UINT c = 0; c < image.Channels; ++c)
+						{
+							double sum = 0.0;
+							double total = 0.0;
+							for (int i = -radius; i <= radius; ++i)
+							{
+								int nx = direction == 0 ? (std::min)((std::max)(x + i, 0), width - 1) : x;
+								int ny = direction == 1 ? (std::min)((std::max)(y + i, 0), height - 1) : y;
+
+								if (normalDepth && i != 0 && !KeepNeighbour(normalDepth[y * width + x], normalDepth[ny * width + nx]))
+								{
+									continue;
+								}
+
+								sum += weights[i + radius] * source.At(nx, ny, c);
+								total += weights[i + radius];
+							}
+							image.At(x, y, c) = normalDepth ? sum / total : sum;
+						}
+					}
+				}
+			}
+			RoundToFormat(format, image);
+		}
+	}
+
+	void MakeImage(UINT width, UINT height, UINT channels, std::mt19937& rng, Image& image)
+	{
+		std::uniform_real_distribution<float> value(0.0f, 1.0f);
+		image.Width = width;
+		image.Height = height;
+		image.Channels = channels;
+		image.Values.resize(static_cast<size_t>(width) * height * channels);
+		for (size_t i = 0; i < image.Values.size(); ++i)
+		{
+			image.Values[i] = value(rng);
+		}
+	}
+
+	// A few normals and depth layers, each pixel either repeating its left neighbour or picking
+	// afresh, so neighbours pass and fail the edge tests in both directions, right up to the
+	// lines' ends.  Two of the normals are exactly NormalThreshold apart.
+	void MakeNormalDepth(UINT width, UINT height, std::mt19937& rng, std::vector<XMFLOAT4>& normalDepth)
+	{
+		const XMFLOAT3 Normals[] = { XMFLOAT3(0.0f, 0.0f, -1.0f), XMFLOAT3(0.0f, 0.6f, -0.8f), XMFLOAT3(0.8f, 0.0f, -0.6f), XMFLOAT3(0.0f, 1.0f, 0.0f) };
+		std::uniform_int_distribution<int> normal(0, 3);
+		std::uniform_int_distribution<int> layer(0, 2);
+		std::uniform_int_distribution<int> repeat(0, 1);
+		std::uniform_real_distribution<float> jitter(-0.05f, 0.05f);
+
+		normalDepth.resize(static_cast<size_t>(width) * height);
+		for (UINT y = 0; y < height; ++y)
+		{
+			int n = normal(rng);
+			int l = layer(rng);
+			for (UINT x = 0; x < width; ++x)
+			{
+				if (!repeat(rng))
+				{
+					n = normal(rng);
+					l = layer(rng);
+				}
+				const XMFLOAT3& v = Normals[n];
+				normalDepth[static_cast<size_t>(y) * width + x] = XMFLOAT4(v.x, v.y, v.z, 5.0f + 0.3f * l + jitter(rng));
+			}
+		}
+	}
+
+	struct Outcome
+	{
+		double WorstError;
+		UINT PadChanges;
+	};
+
+	// Blurs a copy of image with blur and the reference and folds the difference into outcome.
+	void CompareBlur(GImageBlur& blur, GImageBlur::Format format, const std::vector<float>& weights, const Image& image,
+		const XMFLOAT4* normalDepth, UINT numPasses, Outcome& outcome)
+	{
+		UINT rowPitch = image.Width * GetPixelBytes(format) + PadBytes;
+
+		std::vector<uint8_t> bytes;
+		Pack(image, format, rowPitch, bytes);
+
+		// The reference starts from what the blur reads, so sixteen-bit rounding of the input
+		// is not counted against it.
+		Image expected = image;
+		Unpack(bytes, format, rowPitch, expected);
+		ReferenceBlur(format, weights, normalDepth, numPasses, expected);
+
+		if (normalDepth)
+		{
+			blur.BilateralBlur(format, bytes.data(), image.Width, image.Height, rowPitch, normalDepth, NormalThreshold, DepthThreshold, numPasses);
+		}
+		else
+		{
+			blur.Blur(format, bytes.data(), image.Width, image.Height, rowPitch, numPasses);
+		}
+
+		Image result = image;
+		Unpack(bytes, format, rowPitch, result);
+
+		// A sixteen-bit result may round the other way from the reference: one step is 2^-10
+		// below 1.0.  Float results agree to a few rounding errors per tap.
+		double allowed = format == GImageBlur::FORMAT_R16G16B16A16_FLOAT ? 1.0 / 1024.0 : 1e-5;
+		for (size_t i = 0; i < result.Values.size(); ++i)
+		{
+			outcome.WorstError = (std::max)(outcome.WorstError, fabs(result.Values[i] - expected.Values[i]) / allowed);
+		}
+
+		for (UINT y = 0; y < image.Height; ++y)
+		{
+			const uint8_t* pad = &bytes[static_cast<size_t>(y) * rowPitch + rowPitch - PadBytes];
+			outcome.PadChanges += static_cast<UINT>(PadBytes - std::count(pad, pad + PadBytes, PadByte));
+		}
+	}
+}
+
+void TestImageBlur()
+{
+	// Gaussian weights are symmetric, sum to one and default to a radius of ceil(3 sigma).
+	{
+		std::vector<float> weights;
+		CHECK(GImageBlur::ComputeGaussianWeights(2.0f, 0, weights) == 6 && weights.size() == 13);
+
+		double sum = 0.0;
+		UINT asymmetric = 0;
+		for (size_t i = 0; i < weights.size(); ++i)
+		{
+			sum += weights[i];
+			asymmetric += weights[i] == weights[weights.size() - 1 - i] ? 0 : 1;
+		}
+		CHECK(fabs(sum - 1.0) < 1e-6 && asymmetric == 0);
+		CHECK(weights[6] > weights[5] && weights[5] > weights[0]);
+
+		CHECK(GImageBlur::ComputeGaussianWeights(100.0f, 0, weights) == GImageBlur::MaxRadius);
+		CHECK(GImageBlur::ComputeGaussianWeights(0.0f, 0, weights) == 1);
+		CHECK(GImageBlur::ComputeGaussianWeights(1.0f, 9, weights) == 9 && weights.size() == 19);
+	}
+
+	std::mt19937 rng(41);
+
+	// Sizes ending on every lane of the eight-wide single-channel loop and the four-pixel RGBA
+	// loop, with heights crossing the sixteen-line bands.
+	const UINT Sizes[][2] = { { 1, 1 }, { 1, 7 }, { 7, 1 }, { 2, 3 }, { 3, 5 }, { 4, 4 }, { 5, 9 }, { 6, 2 },
+		{ 8, 8 }, { 9, 17 }, { 12, 16 }, { 15, 33 }, { 16, 17 }, { 31, 18 }, { 33, 40 }, { 67, 35 } };
+
+	const GImageBlur::Format Formats[] =
+	{
+		GImageBlur::FORMAT_R32_FLOAT,
+		GImageBlur::FORMAT_R32G32B32A32_FLOAT,
+		GImageBlur::FORMAT_R16G16B16A16_FLOAT,
+	};
+
+	// The shaders' table, a one-tap radius, a wide Gaussian, and a radius longer than most of
+	// the lines, which clamps past both ends at once.
+	std::vector<float> shader(ShaderWeights, ShaderWeights + 2 * ShaderRadius + 1);
+	std::vector<float> narrow, wide, longer;
+	GImageBlur::ComputeGaussianWeights(0.7f, 1, narrow);
+	GImageBlur::ComputeGaussianWeights(3.0f, 0, wide);
+	GImageBlur::ComputeGaussianWeights(6.0f, 20, longer);
+	const std::vector<float>* Weights[] = { &shader, &narrow, &wide, &longer };
+
+	Outcome blurOutcome = {};
+	Outcome bilateralOutcome = {};
+	UINT threadMismatches = 0;
+
+	GImageBlur blur;
+	for (size_t w = 0; w < sizeof(Weights) / sizeof(Weights[0]); ++w)
+	{
+		const std::vector<float>& weights = *Weights[w];
+		blur.SetWeights(weights.data(), static_cast<UINT>(weights.size() / 2));
+
+		for (size_t s = 0; s < sizeof(Sizes) / sizeof(Sizes[0]); ++s)
+		{
+			const UINT width = Sizes[s][0];
+			const UINT height = Sizes[s][1];
+
+			std::vector<XMFLOAT4> normalDepth;
+			MakeNormalDepth(width, height, rng, normalDepth);
+
+			for (size_t f = 0; f < sizeof(Formats) / sizeof(Formats[0]); ++f)
+			{
+				Image image;
+				MakeImage(width, height, GetChannelCount(Formats[f]), rng, image);
+
+				UINT numPasses = 1 + static_cast<UINT>((s + w) % 2);
+				CompareBlur(blur, Formats[f], weights, image, nullptr, numPasses, blurOutcome);
+				CompareBlur(blur, Formats[f], weights, image, normalDepth.data(), numPasses, bilateralOutcome);
+			}
+		}
+	}
+
+	if (!CHECK(blurOutcome.WorstError <= 1.0 && blurOutcome.PadChanges == 0))
+	{
+		fwprintf(stderr, L"  blur: worst error %.2f times the tolerance, %u padding bytes changed\n", blurOutcome.WorstError, blurOutcome.PadChanges);
+	}
+	if (!CHECK(bilateralOutcome.WorstError <= 1.0 && bilateralOutcome.PadChanges == 0))
+	{
+		fwprintf(stderr, L"  bilateral: worst error %.2f times the tolerance, %u padding bytes changed\n", bilateralOutcome.WorstError, bilateralOutcome.PadChanges);
+	}
+
+	// Capping the threads changes which thread takes each band, never the result.
+	{
+		Image image;
+		MakeImage(70, 90, 4, rng, image);
+		std::vector<XMFLOAT4> normalDepth;
+		MakeNormalDepth(70, 90, rng, normalDepth);
+
+		UINT rowPitch = 70 * 16;
+		std::vector<uint8_t> all, one, allBilateral, oneBilateral;
+		Pack(image, GImageBlur::FORMAT_R32G32B32A32_FLOAT, rowPitch, all);
+		one = all;
+		allBilateral = all;
+		oneBilateral = all;
+
+		blur.SetGaussian(2.0f);
+		blur.SetThreadCount(0);
+		blur.Blur(GImageBlur::FORMAT_R32G32B32A32_FLOAT, all.data(), 70, 90, rowPitch, 2);
+		blur.BilateralBlur(GImageBlur::FORMAT_R32G32B32A32_FLOAT, allBilateral.data(), 70, 90, rowPitch, normalDepth.data(), NormalThreshold, DepthThreshold);
+		blur.SetThreadCount(1);
+		blur.Blur(GImageBlur::FORMAT_R32G32B32A32_FLOAT, one.data(), 70, 90, rowPitch, 2);
+		blur.BilateralBlur(GImageBlur::FORMAT_R32G32B32A32_FLOAT, oneBilateral.data(), 70, 90, rowPitch, normalDepth.data(), NormalThreshold, DepthThreshold);
+		blur.SetThreadCount(0);
+
+		threadMismatches += all == one ? 0 : 1;
+		threadMismatches += allBilateral == oneBilateral ? 0 : 1;
+	}
+	CHECK(threadMismatches == 0);
+
+	// A flat image stays flat, and an empty one is not touched.
+	{
+		std::vector<float> flat(37 * 21, 0.375f);
+		blur.SetGaussian(4.0f);
+		blur.Blur(GImageBlur::FORMAT_R32_FLOAT, flat.data(), 37, 21, 37 * sizeof(float), 3);
+
+		float worst = 0.0f;
+		for (size_t i = 0; i < flat.size(); ++i)
+		{
+			worst = (std::max)(worst, fabsf(flat[i] - 0.375f));
+		}
+		CHECK(worst <= 1e-6f);
+
+		blur.Blur(GImageBlur::FORMAT_R32_FLOAT, nullptr, 0, 0, 0);
+		CHECK(blur.GetBlurTime() == 0.0f);
+	}
+
+	// A bilateral blur across two surfaces keeps the edge between them.
+	{
+		const UINT Width = 20;
+		const UINT Height = 6;
+		std::vector<float> image(Width * Height);
+		std::vector<XMFLOAT4> normalDepth(Width * Height);
+		for (UINT y = 0; y < Height; ++y)
+		{
+			for (UINT x = 0; x < Width; ++x)
+			{
+				bool bNear = x < Width / 2;
+				image[y * Width + x] = bNear ? 0.25f : 0.75f;
+				normalDepth[y * Width + x] = XMFLOAT4(0.0f, 0.0f, -1.0f, bNear ? 4.0f : 9.0f);
+			}
+		}
+
+		blur.SetWeights(ShaderWeights, ShaderRadius);
+		blur.BilateralBlur(GImageBlur::FORMAT_R32_FLOAT, image.data(), Width, Height, Width * sizeof(float), normalDepth.data(), NormalThreshold, DepthThreshold, 4);
+
+		UINT bled = 0;
+		for (UINT i = 0; i < image.size(); ++i)
+		{
+			bool bNear = (i % Width) < Width / 2;
+			bled += fabsf(image[i] - (bNear ? 0.25f : 0.75f)) <= 1e-6f ? 0 : 1;
+		}
+		CHECK(bled == 0);
+	}
+}
+
+int BenchImageBlur(int argc, wchar_t* argv[])
+{
+	UINT width = GetOption(argc, argv, L"width", 1920);
+	UINT height = GetOption(argc, argv, L"height", 1080);
+	UINT runs = GetOption(argc, argv, L"runs", 3);
+
+	if (width == 0 || height == 0 || runs == 0)
+	{
+		wprintf(L"-width, -height and -runs must be positive.\n");
+		return 1;
+	}
+
+	std::mt19937 rng(41);
+	std::vector<XMFLOAT4> normalDepth;
+	MakeNormalDepth(width, height, rng, normalDepth);
+
+	std::vector<float> weights(ShaderWeights, ShaderWeights + 2 * ShaderRadius + 1);
+	GImageBlur blur;
+	blur.SetWeights(ShaderWeights, ShaderRadius);
+
+	wprintf(L"%ux%u, 11 taps, best of %u runs (SSE2 on one thread vs one tap at a time)\n", width, height, runs);
+
+	const GImageBlur::Format Formats[] = { GImageBlur::FORMAT_R32_FLOAT, GImageBlur::FORMAT_R16G16B16A16_FLOAT };
+	const wchar_t* const Names[] = { L"R32F", L"RGBA16F" };
+
+	// One thread, so the kernels are compared rather than the pool.
+	blur.SetThreadCount(1);
+
+	for (size_t f = 0; f < sizeof(Formats) / sizeof(Formats[0]); ++f)
+	{
+		Image image;
+		MakeImage(width, height, GetChannelCount(Formats[f]), rng, image);
+		UINT rowPitch = width * GetPixelBytes(Formats[f]);
+
+		std::vector<uint8_t> source;
+		Pack(image, Formats[f], rowPitch, source);
+
+		for (int bilateral = 0; bilateral < 2; ++bilateral)
+		{
+			const XMFLOAT4* guide = bilateral ? normalDepth.data() : nullptr;
+			double best = DBL_MAX;
+			double bestReference = DBL_MAX;
+
+			for (UINT run = 0; run < runs; ++run)
+			{
+				std::vector<uint8_t> bytes = source;
+				Clock::time_point t0 = Clock::now();
+				if (guide)
+				{
+					blur.BilateralBlur(Formats[f], bytes.data(), width, height, rowPitch, guide, NormalThreshold, DepthThreshold);
+				}
+				else
+				{
+					blur.Blur(Formats[f], bytes.data(), width, height, rowPitch);
+				}
+				Clock::time_point t1 = Clock::now();
+
+				Image expected = image;
+				Clock::time_point t2 = Clock::now();
+				ReferenceBlur(Formats[f], weights, guide, 1, expected);
+				Clock::time_point t3 = Clock::now();
+
+				best = (std::min)(best, ElapsedMs(t0, t1));
+				bestReference = (std::min)(bestReference, ElapsedMs(t2, t3));
+			}
+
+			wprintf(L"  %s %s: %.1f ms vs %.1f ms\n", Names[f], bilateral ? L"bilateral" : L"gaussian", best, bestReference);
+		}
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,410 @@
+/*  ===============================================
+	Summary: Engine Tests
+	===============================================  */
+
+#include "EngineTests.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+#include <cwctype>
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	struct TestEntry
+	{
+		const wchar_t* Name;
+		void (*Run)();
+	};
+
+	struct BenchEntry
+	{
+		const wchar_t* Name;
+		int (*Run)(int argc, wchar_t* argv[]);
+		const wchar_t* Options;
+	};
+
+	const TestEntry Tests[] =
+	{
+		{ L"radixsort", TestRadixSort },
+		{ L"spatialhash", TestSpatialHash },
+		{ L"terrainbounds", TestTerrainBounds },
+		{ L"terrainquery", TestTerrainQuery },
+		{ L"textureloader", TestTextureLoader },
+		{ L"ddsparse", TestDDSParse },
+		{ L"shadowcascades", TestShadowCascades },
+		{ L"cubemapscheduler", TestCubeMapScheduler },
+		{ L"planarreflection", TestPlanarReflection },
+		{ L"shadercache", TestShaderCache },
+		{ L"framescheduler", TestFrameScheduler },
+		{ L"particlesort", TestParticleSort },
+		{ L"heightmapstream", TestHeightmapStream },
+		{ L"texturecache", TestTextureCache },
+		{ L"blockcompressor", TestBlockCompressor },
+		{ L"mipgenerator", TestMipGenerator },
+		{ L"heightmapcodec", TestHeightmapCodec },
+		{ L"forest", TestForest },
+		{ L"textureatlas", TestTextureAtlas },
+		{ L"headlessrender", TestHeadlessRender },
+		{ L"softssao", TestSoftSsao },
+		{ L"imageblur", TestImageBlur },
+		{ L"staticshadowcache", TestStaticShadowCache },
+		{ L"pipelinebuilder", TestPipelineBuilder },
+	};
+
+	const BenchEntry Benches[] =
+	{
+		{ L"radixsort", BenchRadixSort, L"[-count <keys>] [-runs <n>]" },
+		{ L"collide", BenchCollide, L"[-count <particles>] [-colliders <n>] [-runs <n>]" },
+		{ L"terraincull", BenchTerrainCull, L"[-runs <n>]" },
+		{ L"terrainquery", BenchTerrainQuery, L"[-count <points>] [-size <samples>] [-runs <n>]" },
+		{ L"textureload", BenchTextureLoad, L"[-runs <n>] [-hardware 1]" },
+		{ L"ddsparse", BenchDDSParse, L"[-runs <n>]" },
+		{ L"ddsfuzz", BenchDDSFuzz, L"[-iterations <n>] [-seed <n>]" },
+		{ L"shadowcascades", BenchShadowCascades, L"[-casters <n>] [-frames <n>]" },
+		{ L"cubemapscheduler", BenchCubeMapScheduler, L"[-objects <n>] [-frames <n>]" },
+		{ L"planarreflection", BenchPlanarReflection, L"[-objects <n>] [-frames <n>]" },
+		{ L"shadercache", BenchShaderCache, L"[-runs <n>]" },
+		{ L"framescheduler", BenchFrameScheduler, L"[-fps <n>] [-frames <n>] [-spin <us>]" },
+		{ L"particlesort", BenchParticleSort, L"[-count <particles>] [-frames <n>]" },
+		{ L"heightmapstream", BenchHeightmapStream, L"[-tiles <n>] [-tile <samples>] [-budget <MB>] [-frames <n>] [-frameus <us>]" },
+		{ L"blockcompressor", BenchBlockCompressor, L"[-size <pixels>] [-runs <n>]" },
+		{ L"mipgenerator", BenchMipGenerator, L"[-size <pixels>] [-runs <n>]" },
+		{ L"heightmapcodec", BenchHeightmapCodec, L"[-count <heights>] [-runs <n>]" },
+		{ L"forest", BenchForest, L"[-trees <n>] [-frames <n>]" },
+		{ L"softssao", BenchSoftSsao, L"[-width <pixels>] [-height <pixels>] [-runs <n>]" },
+		{ L"imageblur", BenchImageBlur, L"[-width <pixels>] [-height <pixels>] [-runs <n>]" },
+		{ L"pipelinebuilder", BenchPipelineBuilder, L"[-shaders <n>] [-compileus <us>] [-runs <n>] [-threads <n>]" },
+		{ L"profiler", BenchProfiler, L"[-count <calls>] [-runs <n>] [-budget <ns>]" },
+	};
+
+	const size_t TestCount = sizeof(Tests) / sizeof(Tests[0]);
+	const size_t BenchCount = sizeof(Benches) / sizeof(Benches[0]);
+
+	UINT gFailedChecks = 0;
+
+#if defined(_WIN32)
+	const wchar_t PathSeparator = L'\\';
+#else
+	const wchar_t PathSeparator = L'/';
+#endif
+
+	bool FileExists(const std::wstring& filename)
+	{
+#if defined(_WIN32)
+		return GetFileAttributesW(filename.c_str()) != INVALID_FILE_ATTRIBUTES;
+#else
+		std::string narrow(filename.size() * 4 + 1, '\0');
+		narrow.resize(wcstombs(&narrow[0], filename.c_str(), narrow.size()));
+
+		struct stat info;
+		return stat(narrow.c_str(), &info) == 0;
+#endif
+	}
+
+	void RemovePath(const std::wstring& path, bool bDirectory)
+	{
+#if defined(_WIN32)
+		if (bDirectory)
+		{
+			RemoveDirectoryW(path.c_str());
+		}
+		else
+		{
+			DeleteFileW(path.c_str());
+		}
+#else
+		std::string narrow(path.size() * 4 + 1, '\0');
+		narrow.resize(wcstombs(&narrow[0], path.c_str(), narrow.size()));
+		if (bDirectory)
+		{
+			rmdir(narrow.c_str());
+		}
+		else
+		{
+			unlink(narrow.c_str());
+		}
+#endif
+	}
+
+	bool HasExtension(const std::wstring& name, const wchar_t* extension)
+	{
+		size_t length = wcslen(extension);
+		if (name.size() < length)
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < length; ++i)
+		{
+			if (towlower(name[name.size() - length + i]) != towlower(extension[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void FindFilesRecursive(const std::wstring& dir, const wchar_t* extension, std::vector<std::wstring>& out)
+	{
+#if defined(_WIN32)
+		WIN32_FIND_DATAW data;
+		HANDLE find = FindFirstFileW((dir + L"*").c_str(), &data);
+		if (find == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+
+		do
+		{
+			std::wstring name = data.cFileName;
+			if (name == L"." || name == L"..")
+			{
+				continue;
+			}
+
+			if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			{
+				FindFilesRecursive(dir + name + PathSeparator, extension, out);
+			}
+			else if (HasExtension(name, extension))
+			{
+				out.push_back(dir + name);
+			}
+		} while (FindNextFileW(find, &data));
+
+		FindClose(find);
+#else
+		std::string narrow(dir.size() * 4 + 1, '\0');
+		narrow.resize(wcstombs(&narrow[0], dir.c_str(), narrow.size()));
+
+		DIR* handle = opendir(narrow.c_str());
+		if (!handle)
+		{
+			return;
+		}
+
+		while (dirent* entry = readdir(handle))
+		{
+			std::wstring name(strlen(entry->d_name) + 1, L'\0');
+			name.resize(mbstowcs(&name[0], entry->d_name, name.size()));
+			if (name == L"." || name == L"..")
+			{
+				continue;
+			}
+
+			struct stat info;
+			if (stat((narrow + entry->d_name).c_str(), &info) != 0)
+			{
+				continue;
+			}
+
+			if (S_ISDIR(info.st_mode))
+			{
+				FindFilesRecursive(dir + name + PathSeparator, extension, out);
+			}
+			else if (HasExtension(name, extension))
+			{
+				out.push_back(dir + name);
+			}
+		}
+
+		closedir(handle);
+#endif
+	}
+
+	void PrintUsage()
+	{
+		wprintf(L"Usage:\n");
+		wprintf(L"  EngineTests test [name]...\n");
+		wprintf(L"  EngineTests bench <name> [options]\n");
+		wprintf(L"\n");
+		wprintf(L"  test runs every test, or only those named, and exits with the number that failed.\n");
+		wprintf(L"\n");
+		wprintf(L"Tests:\n");
+		for (size_t i = 0; i < TestCount; ++i)
+		{
+			wprintf(L"  %ls\n", Tests[i].Name);
+		}
+		wprintf(L"\n");
+		wprintf(L"Benchmarks:\n");
+		for (size_t i = 0; i < BenchCount; ++i)
+		{
+			wprintf(L"  %ls %ls\n", Benches[i].Name, Benches[i].Options);
+		}
+	}
+
+	bool IsSelected(const wchar_t* name, int argc, wchar_t* argv[])
+	{
+		if (argc <= 2)
+		{
+			return true;
+		}
+
+		for (int i = 2; i < argc; ++i)
+		{
+			if (wcscmp(argv[i], name) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	int TestCommand(int argc, wchar_t* argv[])
+	{
+		for (int i = 2; i < argc; ++i)
+		{
+			bool bFound = false;
+			for (size_t j = 0; j < TestCount; ++j)
+			{
+				bFound = bFound || wcscmp(argv[i], Tests[j].Name) == 0;
+			}
+
+			if (!bFound)
+			{
+				wprintf(L"Unknown test: %ls\n", argv[i]);
+				return 1;
+			}
+		}
+
+		int failedTests = 0;
+		for (size_t i = 0; i < TestCount; ++i)
+		{
+			if (!IsSelected(Tests[i].Name, argc, argv))
+			{
+				continue;
+			}
+
+			UINT failedBefore = gFailedChecks;
+			Tests[i].Run();
+
+			if (gFailedChecks == failedBefore)
+			{
+				wprintf(L"%ls: passed\n", Tests[i].Name);
+			}
+			else
+			{
+				wprintf(L"%ls: FAILED (%u checks)\n", Tests[i].Name, gFailedChecks - failedBefore);
+				++failedTests;
+			}
+		}
+		return failedTests;
+	}
+
+	int BenchCommand(int argc, wchar_t* argv[])
+	{
+		if (argc < 3)
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		for (size_t i = 0; i < BenchCount; ++i)
+		{
+			if (wcscmp(argv[2], Benches[i].Name) == 0)
+			{
+				return Benches[i].Run(argc - 3, argv + 3);
+			}
+		}
+
+		wprintf(L"Unknown benchmark: %ls\n", argv[2]);
+		return 1;
+	}
+}
+
+bool Check(bool bPassed, const char* expression, const char* file, int line)
+{
+	if (!bPassed)
+	{
+		fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expression);
+		++gFailedChecks;
+	}
+	return bPassed;
+}
+
+UINT GetOption(int argc, wchar_t* argv[], const wchar_t* name, UINT defaultValue)
+{
+	for (int i = 0; i + 1 < argc; ++i)
+	{
+		if (argv[i][0] == L'-' && wcscmp(argv[i] + 1, name) == 0)
+		{
+			return static_cast<UINT>(wcstoul(argv[i + 1], nullptr, 10));
+		}
+	}
+	return defaultValue;
+}
+
+std::wstring FindRepoRoot()
+{
+	std::wstring dir;
+	for (int level = 0; level < 6; ++level)
+	{
+		if (FileExists(dir + L"DX11Renderer.sln"))
+		{
+			return dir.empty() ? std::wstring(L".") + PathSeparator : dir;
+		}
+		dir += L"..";
+		dir += PathSeparator;
+	}
+	return std::wstring();
+}
+
+void FindFiles(const std::wstring& dir, const wchar_t* extension, std::vector<std::wstring>& out)
+{
+	size_t first = out.size();
+	FindFilesRecursive(dir, extension, out);
+	std::sort(out.begin() + first, out.end());
+}
+
+bool MakeDirectory(const std::wstring& dir)
+{
+#if defined(_WIN32)
+	return CreateDirectoryW(dir.c_str(), nullptr) != 0 || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+	std::string narrow(dir.size() * 4 + 1, '\0');
+	narrow.resize(wcstombs(&narrow[0], dir.c_str(), narrow.size()));
+	return mkdir(narrow.c_str(), 0755) == 0 || access(narrow.c_str(), F_OK) == 0;
+#endif
+}
+
+void ClearDirectory(const std::wstring& dir)
+{
+	std::vector<std::wstring> files;
+	FindFiles(dir, L"", files);
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		RemovePath(files[i], false);
+	}
+
+	RemovePath(dir + L"Cache", true);
+	RemovePath(dir, true);
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+	if (argc < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (wcscmp(argv[1], L"test") == 0)
+	{
+		return TestCommand(argc, argv);
+	}
+	else if (wcscmp(argv[1], L"bench") == 0)
+	{
+		return BenchCommand(argc, argv);
+	}
+
+	PrintUsage();
+	return 1;
+}
\ No newline at end of file
@@ -0,0 +1,523 @@
+/*  ===============================================
+	Summary: Mip Generator Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GMipGenerator.h"
+#include "GThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Bytes past the end of each source row, so row pitch is honoured rather than assumed.
+	const UINT RowPadding = 12;
+
+	struct Image
+	{
+		UINT Width;
+		UINT Height;
+		UINT RowPitch;
+		std::vector<uint8_t> Data;
+	};
+
+	void MakeImage(GMipGenerator::Format format, UINT width, UINT height, UINT padding, std::mt19937& rng, Image& image)
+	{
+		image.Width = width;
+		image.Height = height;
+		image.RowPitch = width * GMipGenerator::GetPixelBytes(format) + padding;
+		image.Data.assign(static_cast<size_t>(image.RowPitch) * height, 0xCD);
+
+		for (UINT y = 0; y < height; ++y)
+		{
+			uint8_t* row = &image.Data[static_cast<size_t>(y) * image.RowPitch];
+			for (UINT x = 0; x < width; ++x)
+			{
+				if (format == GMipGenerator::FORMAT_R32_FLOAT)
+				{
+					float v = std::uniform_real_distribution<float>(-1.0f, 1.0f)(rng);
+					memcpy(row + 4 * x, &v, sizeof(v));
+				}
+				else
+				{
+					for (UINT c = 0; c < 4; ++c)
+					{
+						row[4 * x + c] = static_cast<uint8_t>(rng() & 0xFF);
+					}
+				}
+			}
+		}
+	}
+
+	//
+	// Straightforward double-precision references, one destination texel at a time.
+	//
+
+	double ToLinear(uint8_t s)
+	{
+		double v = s / 255.0;
+		return v <= 0.04045 ? v / 12.92 : pow((v + 0.055) / 1.055, 2.4);
+	}
+
+	double FromLinear(double l)
+	{
+		l = (std::min)((std::max)(l, 0.0), 1.0);
+		double s = l <= 0.0031308 ? l * 12.92 : 1.055 * pow(l, 1.0 / 2.4) - 0.055;
+		return s * 255.0;
+	}
+
+	double ReferenceKaiser(double x)
+	{
+		const double Width = 3.0;
+		const double Alpha = 4.0;
+		const double Pi = 3.14159265358979;
+
+		if (fabs(x) >= Width)
+		{
+			return 0.0;
+		}
+
+		struct Bessel
+		{
+			static double I0(double v)
+			{
+				double sum = 1.0;
+				double term = 1.0;
+				for (int k = 1; k < 50; ++k)
+				{
+					term *= 0.25 * v * v / (k * k);
+					sum += term;
+				}
+				return sum;
+			}
+		};
+
+		double sinc = x == 0.0 ? 1.0 : sin(Pi * x) / (Pi * x);
+		double t = x / Width;
+		return sinc * Bessel::I0(Alpha * sqrt(1.0 - t * t)) / Bessel::I0(Alpha);
+	}
+
+	// Source texels and weights for destination texel i along one axis, edges clamped.
+	void ReferenceTaps(GMipGenerator::Filter filter, UINT srcSize, UINT dstSize, UINT i, std::vector<UINT>& indices, std::vector<double>& weights)
+	{
+		indices.clear();
+		weights.clear();
+
+		double scale = static_cast<double>(srcSize) / dstSize;
+		double center = (i + 0.5) * scale;
+		double support = (std::max)(scale, 1.0);
+		double radius = filter == GMipGenerator::FILTER_KAISER ? 3.0 * support : 0.5 * scale;
+
+		double total = 0.0;
+		for (int j = static_cast<int>(floor(center - radius)) - 1; j <= static_cast<int>(ceil(center + radius)); ++j)
+		{
+			double w;
+			if (filter == GMipGenerator::FILTER_KAISER)
+			{
+				w = ReferenceKaiser((j + 0.5 - center) / support);
+			}
+			else
+			{
+				w = (std::min)(j + 1.0, center + radius) - (std::max)(static_cast<double>(j), center - radius);
+			}
+
+			// Slivers below float precision say nothing about which texels a footprint covers.
+			if (filter != GMipGenerator::FILTER_KAISER && w < 1.0e-4)
+			{
+				continue;
+			}
+
+			indices.push_back(static_cast<UINT>((std::min)((std::max)(j, 0), static_cast<int>(srcSize) - 1)));
+			weights.push_back(w);
+			total += w;
+		}
+
+		for (size_t t = 0; t < weights.size(); ++t)
+		{
+			weights[t] /= total;
+		}
+	}
+
+	double ReadChannel(GMipGenerator::Format format, const Image& image, UINT x, UINT y, UINT c)
+	{
+		const uint8_t* texel = &image.Data[static_cast<size_t>(y) * image.RowPitch + 4 * x];
+		if (format == GMipGenerator::FORMAT_R32_FLOAT)
+		{
+			float v;
+			memcpy(&v, texel, sizeof(v));
+			return v;
+		}
+		if (format == GMipGenerator::FORMAT_R8G8B8A8_SRGB && c < 3)
+		{
+			return ToLinear(texel[c]);
+		}
+		return texel[c] / 255.0;
+	}
+
+	// Filters src to dstWidth x dstHeight; 8-bit results are left unrounded, in 0-255.
+	void ReferenceResize(GMipGenerator::Format format, GMipGenerator::Filter filter, const Image& src,
+		UINT dstWidth, UINT dstHeight, std::vector<double>& out)
+	{
+		const UINT channels = format == GMipGenerator::FORMAT_R32_FLOAT ? 1 : 4;
+		const bool bWeighted = filter == GMipGenerator::FILTER_BOX || filter == GMipGenerator::FILTER_KAISER;
+
+		out.assign(static_cast<size_t>(dstWidth) * dstHeight * channels, 0.0);
+
+		std::vector<UINT> xi, yi;
+		std::vector<double> xw, yw;
+		for (UINT y = 0; y < dstHeight; ++y)
+		{
+			ReferenceTaps(filter, src.Height, dstHeight, y, yi, yw);
+			for (UINT x = 0; x < dstWidth; ++x)
+			{
+				ReferenceTaps(filter, src.Width, dstWidth, x, xi, xw);
+				for (UINT c = 0; c < channels; ++c)
+				{
+					double acc = filter == GMipGenerator::FILTER_MIN ? DBL_MAX : filter == GMipGenerator::FILTER_MAX ? -DBL_MAX : 0.0;
+					for (size_t ty = 0; ty < yi.size(); ++ty)
+					{
+						for (size_t tx = 0; tx < xi.size(); ++tx)
+						{
+							double v = ReadChannel(format, src, xi[tx], yi[ty], c);
+							acc = bWeighted ? acc + v * xw[tx] * yw[ty] :
+								filter == GMipGenerator::FILTER_MIN ? (std::min)(acc, v) : (std::max)(acc, v);
+						}
+					}
+
+					if (format == GMipGenerator::FORMAT_R8G8B8A8_SRGB && c < 3)
+					{
+						acc = FromLinear(acc);
+					}
+					else if (format != GMipGenerator::FORMAT_R32_FLOAT)
+					{
+						acc = (std::min)((std::max)(acc, 0.0), 1.0) * 255.0;
+					}
+					out[(static_cast<size_t>(y) * dstWidth + x) * channels + c] = acc;
+				}
+			}
+		}
+	}
+
+	// Largest difference between a filtered level and the reference, in 8-bit steps for the
+	// 8-bit formats.
+	double CompareToReference(GMipGenerator::Format format, const std::vector<double>& reference,
+		const uint8_t* data, UINT width, UINT height, UINT rowPitch)
+	{
+		const UINT channels = format == GMipGenerator::FORMAT_R32_FLOAT ? 1 : 4;
+
+		double worst = 0.0;
+		for (UINT y = 0; y < height; ++y)
+		{
+			const uint8_t* row = data + static_cast<size_t>(y) * rowPitch;
+			for (UINT x = 0; x < width; ++x)
+			{
+				for (UINT c = 0; c < channels; ++c)
+				{
+					double expected = reference[(static_cast<size_t>(y) * width + x) * channels + c];
+					double error;
+					if (format == GMipGenerator::FORMAT_R32_FLOAT)
+					{
+						float v;
+						memcpy(&v, row + 4 * x, sizeof(v));
+						error = fabs(v - expected);
+					}
+					else
+					{
+						error = fabs(row[4 * x + c] - expected);
+					}
+					worst = (std::max)(worst, error);
+				}
+			}
+		}
+		return worst;
+	}
+
+	// The exact 2:1 results: rounded box average, or min or max of the four texels.
+	bool MatchesExactReduction(GMipGenerator::Filter filter, const Image& src, const uint8_t* dst, UINT dstRowPitch)
+	{
+		UINT dstWidth = src.Width / 2;
+		UINT dstHeight = src.Height / 2;
+
+		for (UINT y = 0; y < dstHeight; ++y)
+		{
+			const uint8_t* row0 = &src.Data[static_cast<size_t>(2 * y) * src.RowPitch];
+			const uint8_t* row1 = row0 + src.RowPitch;
+			for (UINT x = 0; x < dstWidth * 4; ++x)
+			{
+				UINT c = x % 4;
+				UINT i = (x / 4) * 8 + c;
+				UINT a = row0[i], b = row0[i + 4], d = row1[i], e = row1[i + 4];
+
+				UINT expected = filter == GMipGenerator::FILTER_BOX ? (a + b + d + e + 2) >> 2 :
+					filter == GMipGenerator::FILTER_MIN ? (std::min)((std::min)(a, b), (std::min)(d, e)) :
+					(std::max)((std::max)(a, b), (std::max)(d, e));
+
+				if (dst[static_cast<size_t>(y) * dstRowPitch + x] != expected)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Allowed error: rounding to the nearest 8-bit step plus float accumulation, a whole step
+	// through the sRGB lookup tables, and accumulation order for R32 data in [-1, 1].
+	double Tolerance(GMipGenerator::Format format)
+	{
+		return format == GMipGenerator::FORMAT_R32_FLOAT ? 1.0e-5 : format == GMipGenerator::FORMAT_R8G8B8A8_SRGB ? 1.0 : 0.55;
+	}
+
+	const wchar_t* FormatName(GMipGenerator::Format format)
+	{
+		return format == GMipGenerator::FORMAT_R32_FLOAT ? L"R32_FLOAT" : format == GMipGenerator::FORMAT_R8G8B8A8_SRGB ? L"RGBA8_SRGB" : L"RGBA8";
+	}
+
+	const wchar_t* FilterName(GMipGenerator::Filter filter)
+	{
+		return filter == GMipGenerator::FILTER_KAISER ? L"kaiser" : filter == GMipGenerator::FILTER_MIN ? L"min" :
+			filter == GMipGenerator::FILTER_MAX ? L"max" : L"box";
+	}
+}
+
+void TestMipGenerator()
+{
+	const GMipGenerator::Format Formats[] =
+	{
+		GMipGenerator::FORMAT_R8G8B8A8, GMipGenerator::FORMAT_R8G8B8A8_SRGB, GMipGenerator::FORMAT_R32_FLOAT,
+	};
+	const GMipGenerator::Filter Filters[] =
+	{
+		GMipGenerator::FILTER_BOX, GMipGenerator::FILTER_KAISER, GMipGenerator::FILTER_MIN, GMipGenerator::FILTER_MAX,
+	};
+
+	CHECK(GMipGenerator::GetMipCount(1, 1) == 1);
+	CHECK(GMipGenerator::GetMipCount(256, 256) == 9);
+	CHECK(GMipGenerator::GetMipCount(7, 1) == 3);
+	CHECK(GMipGenerator::GetMipCount(1, 1000) == 10);
+
+	std::mt19937 rng(35);
+
+	// Widths cover every remainder of the two- and four-texel SIMD loops, on both the 2:1 path
+	// (even sizes) and the general one (odd sizes); each level is checked against the reference
+	// filtered from the level above it, so errors do not compound down the chain.
+	const UINT Widths[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 18, 22, 33, 36 };
+	const UINT Heights[] = { 1, 2, 3, 6, 9 };
+
+	for (size_t f = 0; f < sizeof(Formats) / sizeof(Formats[0]); ++f)
+	{
+		for (size_t k = 0; k < sizeof(Filters) / sizeof(Filters[0]); ++k)
+		{
+			double worst = 0.0;
+			UINT inexact = 0;
+			UINT badCopies = 0;
+
+			for (size_t w = 0; w < sizeof(Widths) / sizeof(Widths[0]); ++w)
+			{
+				for (size_t h = 0; h < sizeof(Heights) / sizeof(Heights[0]); ++h)
+				{
+					Image image;
+					MakeImage(Formats[f], Widths[w], Heights[h], RowPadding, rng, image);
+
+					std::vector<GMipGenerator::Level> levels;
+					GMipGenerator::GenerateChain(Formats[f], Filters[k], image.Data.data(), image.Width, image.Height, image.RowPitch, levels);
+
+					if (levels.size() != GMipGenerator::GetMipCount(image.Width, image.Height))
+					{
+						++badCopies;
+						continue;
+					}
+
+					// Level 0 is the source with its padding dropped.
+					for (UINT y = 0; y < image.Height; ++y)
+					{
+						badCopies += memcmp(&levels[0].Data[static_cast<size_t>(y) * levels[0].RowPitch],
+							&image.Data[static_cast<size_t>(y) * image.RowPitch], levels[0].RowPitch) == 0 ? 0 : 1;
+					}
+
+					for (size_t mip = 1; mip < levels.size(); ++mip)
+					{
+						const GMipGenerator::Level& parent = levels[mip - 1];
+						const GMipGenerator::Level& level = levels[mip];
+
+						Image above;
+						above.Width = parent.Width;
+						above.Height = parent.Height;
+						above.RowPitch = parent.RowPitch;
+						above.Data = parent.Data;
+
+						std::vector<double> reference;
+						ReferenceResize(Formats[f], Filters[k], above, level.Width, level.Height, reference);
+						worst = (std::max)(worst, CompareToReference(Formats[f], reference, level.Data.data(), level.Width, level.Height, level.RowPitch));
+
+						// Integer 2:1 reductions have one right answer.
+						bool bExact = Formats[f] != GMipGenerator::FORMAT_R32_FLOAT && Filters[k] != GMipGenerator::FILTER_KAISER &&
+							(Formats[f] == GMipGenerator::FORMAT_R8G8B8A8 || Filters[k] != GMipGenerator::FILTER_BOX) &&
+							above.Width == 2 * level.Width && above.Height == 2 * level.Height;
+						if (bExact && !MatchesExactReduction(Filters[k], above, level.Data.data(), level.RowPitch))
+						{
+							++inexact;
+						}
+					}
+				}
+			}
+
+			bool bPassed = CHECK(worst <= Tolerance(Formats[f]));
+			bPassed = CHECK(inexact == 0) && bPassed;
+			bPassed = CHECK(badCopies == 0) && bPassed;
+			if (!bPassed)
+			{
+				fwprintf(stderr, L"  %ls %ls: largest error %g\n", FormatName(Formats[f]), FilterName(Filters[k]), worst);
+			}
+		}
+	}
+
+	// Resize in both directions and to unrelated sizes, into a padded destination.
+	const UINT Sizes[][4] =
+	{
+		{ 13, 7, 20, 5 }, { 5, 5, 11, 3 }, { 17, 9, 4, 9 }, { 3, 2, 9, 7 }, { 31, 6, 7, 2 }, { 1, 1, 6, 5 },
+	};
+
+	for (size_t f = 0; f < sizeof(Formats) / sizeof(Formats[0]); ++f)
+	{
+		for (size_t k = 0; k < sizeof(Filters) / sizeof(Filters[0]); ++k)
+		{
+			double worst = 0.0;
+			UINT overwritten = 0;
+
+			for (size_t s = 0; s < sizeof(Sizes) / sizeof(Sizes[0]); ++s)
+			{
+				Image image;
+				MakeImage(Formats[f], Sizes[s][0], Sizes[s][1], RowPadding, rng, image);
+
+				UINT dstWidth = Sizes[s][2];
+				UINT dstHeight = Sizes[s][3];
+				UINT dstRowPitch = dstWidth * 4 + RowPadding;
+				std::vector<uint8_t> dst(static_cast<size_t>(dstRowPitch) * dstHeight, 0xCD);
+
+				GMipGenerator::Resize(Formats[f], Filters[k], image.Data.data(), image.Width, image.Height, image.RowPitch,
+					dst.data(), dstWidth, dstHeight, dstRowPitch);
+
+				std::vector<double> reference;
+				ReferenceResize(Formats[f], Filters[k], image, dstWidth, dstHeight, reference);
+				worst = (std::max)(worst, CompareToReference(Formats[f], reference, dst.data(), dstWidth, dstHeight, dstRowPitch));
+
+				for (UINT y = 0; y < dstHeight; ++y)
+				{
+					for (UINT i = dstWidth * 4; i < dstRowPitch; ++i)
+					{
+						overwritten += dst[static_cast<size_t>(y) * dstRowPitch + i] == 0xCD ? 0 : 1;
+					}
+				}
+			}
+
+			bool bPassed = CHECK(worst <= Tolerance(Formats[f]));
+			bPassed = CHECK(overwritten == 0) && bPassed;
+			if (!bPassed)
+			{
+				fwprintf(stderr, L"  resize %ls %ls: largest error %g\n", FormatName(Formats[f]), FilterName(Filters[k]), worst);
+			}
+		}
+	}
+
+	// A flat image stays flat through every filter, Kaiser's negative lobes included.
+	for (size_t k = 0; k < sizeof(Filters) / sizeof(Filters[0]); ++k)
+	{
+		std::vector<uint8_t> flat(37 * 19 * 4);
+		for (size_t i = 0; i < flat.size(); ++i)
+		{
+			flat[i] = static_cast<uint8_t>(40 + 50 * (i % 4));
+		}
+
+		std::vector<GMipGenerator::Level> levels;
+		GMipGenerator::GenerateChain(GMipGenerator::FORMAT_R8G8B8A8_SRGB, Filters[k], flat.data(), 37, 19, 37 * 4, levels);
+
+		UINT changed = 0;
+		for (size_t mip = 0; mip < levels.size(); ++mip)
+		{
+			for (size_t i = 0; i < levels[mip].Data.size(); ++i)
+			{
+				changed += levels[mip].Data[i] == 40 + 50 * (i % 4) ? 0 : 1;
+			}
+		}
+		CHECK(changed == 0);
+	}
+
+	// A partial chain stops where asked; asking for more than the full chain gives the full chain.
+	{
+		std::vector<uint8_t> texels(64 * 32 * 4, 0x80);
+		std::vector<GMipGenerator::Level> levels;
+		GMipGenerator::GenerateChain(GMipGenerator::FORMAT_R8G8B8A8, GMipGenerator::FILTER_BOX, texels.data(), 64, 32, 64 * 4, levels, 3);
+		CHECK(levels.size() == 3 && levels[2].Width == 16 && levels[2].Height == 8);
+
+		GMipGenerator::GenerateChain(GMipGenerator::FORMAT_R8G8B8A8, GMipGenerator::FILTER_BOX, texels.data(), 64, 32, 64 * 4, levels, 20);
+		CHECK(levels.size() == 7 && levels[6].Width == 1 && levels[6].Height == 1);
+	}
+}
+
+int BenchMipGenerator(int argc, wchar_t* argv[])
+{
+	UINT size = GetOption(argc, argv, L"size", 2048);
+	UINT runs = GetOption(argc, argv, L"runs", 10);
+
+	if (size == 0 || runs == 0)
+	{
+		wprintf(L"-size and -runs must be positive.\n");
+		return 1;
+	}
+
+	struct Case
+	{
+		GMipGenerator::Format Format;
+		GMipGenerator::Filter Filter;
+		UINT Width;
+	};
+
+	// The power-of-two size takes the 2:1 path for box, min and max; one texel less takes the
+	// general filter on every level.
+	const Case Cases[] =
+	{
+		{ GMipGenerator::FORMAT_R8G8B8A8, GMipGenerator::FILTER_BOX, size },
+		{ GMipGenerator::FORMAT_R8G8B8A8_SRGB, GMipGenerator::FILTER_BOX, size },
+		{ GMipGenerator::FORMAT_R8G8B8A8, GMipGenerator::FILTER_MAX, size },
+		{ GMipGenerator::FORMAT_R32_FLOAT, GMipGenerator::FILTER_BOX, size },
+		{ GMipGenerator::FORMAT_R8G8B8A8, GMipGenerator::FILTER_KAISER, size },
+		{ GMipGenerator::FORMAT_R8G8B8A8, GMipGenerator::FILTER_BOX, size - 1 },
+	};
+
+	std::mt19937 rng(35);
+	wprintf(L"%ux%u source, %u runs, %u threads\n", size, size, runs, GThreadPool::Get().GetThreadCount());
+
+	for (size_t i = 0; i < sizeof(Cases) / sizeof(Cases[0]); ++i)
+	{
+		if (Cases[i].Width == 0)
+		{
+			continue;
+		}
+
+		Image image;
+		MakeImage(Cases[i].Format, Cases[i].Width, Cases[i].Width, 0, rng, image);
+
+		std::vector<GMipGenerator::Level> levels;
+		double bestMs = 0.0;
+		for (UINT run = 0; run < runs; ++run)
+		{
+			Clock::time_point start = Clock::now();
+			GMipGenerator::GenerateChain(Cases[i].Format, Cases[i].Filter, image.Data.data(), image.Width, image.Height, image.RowPitch, levels);
+			double ms = ElapsedMs(start, Clock::now());
+			bestMs = run == 0 ? ms : (std::min)(bestMs, ms);
+		}
+
+		double texels = static_cast<double>(image.Width) * image.Height;
+		wprintf(L"  %-10ls %-6ls %5u: %8.2f ms (%.0f Mtexels/s)\n", FormatName(Cases[i].Format), FilterName(Cases[i].Filter),
+			Cases[i].Width, bestMs, texels / (bestMs * 1000.0));
+	}
+
+	return 0;
+}
\ No newline at end of file
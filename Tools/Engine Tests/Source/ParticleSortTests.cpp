@@ -0,0 +1,188 @@
+/*  ===============================================
+	Summary: Particle Sort Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GParticleSystem.h"
+#include "GThreadPool.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	const XMFLOAT3 EyePos(0.0f, 5.0f, -30.0f);
+	const XMFLOAT3 Look(0.0f, 0.0f, 1.0f);
+
+	float Depth(const XMFLOAT3& p, const XMFLOAT3& eye, const XMFLOAT3& look)
+	{
+		return (p.x - eye.x) * look.x + (p.y - eye.y) * look.y + (p.z - eye.z) * look.z;
+	}
+
+	// The draw order must list every live slot once, farthest first, then every dead slot.
+	bool IsBackToFront(const GParticleSystem& particles, const XMFLOAT3& eye, const XMFLOAT3& look)
+	{
+		const UINT* order = particles.GetDrawOrder();
+		UINT count = particles.GetMaxParticles();
+		UINT alive = particles.GetAliveCount();
+
+		std::vector<bool> seen(count, false);
+		for (UINT i = 0; i < count; ++i)
+		{
+			UINT slot = order[i];
+			if (slot >= count || seen[slot] || particles.IsAlive(slot) != (i < alive))
+			{
+				return false;
+			}
+			seen[slot] = true;
+
+			if (i > 0 && i < alive && Depth(particles.GetPosition(order[i - 1]), eye, look) < Depth(particles.GetPosition(slot), eye, look))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	UINT CountAlive(const GParticleSystem& particles)
+	{
+		UINT alive = 0;
+		for (UINT i = 0; i < particles.GetMaxParticles(); ++i)
+		{
+			alive += particles.IsAlive(i) ? 1 : 0;
+		}
+		return alive;
+	}
+
+	void InitPlume(GParticleSystem& particles, UINT count)
+	{
+		// Emits the whole pool over one lifetime, so slots die and are reused every frame.
+		particles.Init(count, 2.0f, count / 2.0f);
+		particles.SetEmitter(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f));
+		particles.SetAcceleration(XMFLOAT3(0.5f, 1.0f, 0.2f));
+		particles.SetSpeed(2.0f, 0.8f);
+	}
+}
+
+void TestParticleSort()
+{
+	// ParallelFor covers every index once for counts that are not a multiple of the grain.
+	const UINT Counts[] = { 0, 1, 7, 4095, 4097, 10001 };
+	for (size_t c = 0; c < sizeof(Counts) / sizeof(Counts[0]); ++c)
+	{
+		std::vector<std::atomic<UINT> > visits(Counts[c] + 1);
+		for (size_t i = 0; i < visits.size(); ++i)
+		{
+			visits[i] = 0;
+		}
+
+		GThreadPool::Get().ParallelFor(Counts[c], 64, [&](UINT begin, UINT end)
+		{
+			for (UINT i = begin; i < end; ++i)
+			{
+				++visits[i];
+			}
+		});
+
+		UINT wrong = 0;
+		for (UINT i = 0; i < Counts[c]; ++i)
+		{
+			wrong += visits[i] == 1 ? 0 : 1;
+		}
+		CHECK(wrong == 0 && visits[Counts[c]] == 0);
+	}
+
+	// An empty system sorts nothing.
+	GParticleSystem empty;
+	empty.Init(0, 1.0f, 0.0f);
+	empty.SortBackToFront(EyePos, Look);
+	CHECK(empty.GetAliveCount() == 0);
+
+	// A plume with births and deaths every frame stays sorted, and the live count matches the ages.
+	GParticleSystem particles;
+	InitPlume(particles, 5000);
+
+	UINT unsorted = 0;
+	UINT miscounted = 0;
+	for (int frame = 0; frame < 240; ++frame)
+	{
+		particles.Update(1.0f / 60.0f);
+
+		// The camera circles the plume, so the order changes from frame to frame.
+		float angle = frame * 0.02f;
+		XMFLOAT3 eye(30.0f * sinf(angle), 5.0f, -30.0f * cosf(angle));
+		XMFLOAT3 look(-sinf(angle), 0.0f, cosf(angle));
+
+		particles.SortBackToFront(eye, look);
+		unsorted += IsBackToFront(particles, eye, look) ? 0 : 1;
+		miscounted += CountAlive(particles) == particles.GetAliveCount() ? 0 : 1;
+	}
+	CHECK(unsorted == 0);
+	CHECK(miscounted == 0);
+	CHECK(particles.GetAliveCount() > 0 && particles.GetAliveCount() <= particles.GetMaxParticles());
+
+	// With nothing moving and the camera still, last frame's order is reused as is.
+	particles.SortBackToFront(EyePos, Look);
+	particles.SortBackToFront(EyePos, Look);
+	CHECK(particles.GetLastSortPath() == GRadixSort::SORT_REUSED);
+	CHECK(IsBackToFront(particles, EyePos, Look));
+
+	// Reset kills everything; the dead keep their slots at the end.
+	particles.Reset();
+	particles.SortBackToFront(EyePos, Look);
+	CHECK(particles.GetAliveCount() == 0 && CountAlive(particles) == 0);
+	CHECK(IsBackToFront(particles, EyePos, Look));
+}
+
+int BenchParticleSort(int argc, wchar_t* argv[])
+{
+	UINT count = GetOption(argc, argv, L"count", 100000);
+	UINT frames = GetOption(argc, argv, L"frames", 300);
+
+	GParticleSystem particles;
+	InitPlume(particles, count);
+
+	// Warm up to a full pool.
+	for (int i = 0; i < 180; ++i)
+	{
+		particles.Update(1.0f / 60.0f);
+	}
+
+	double updateMs = 0.0;
+	double sortMs = 0.0;
+	UINT paths[4] = { 0, 0, 0, 0 };
+
+	for (UINT frame = 0; frame < frames; ++frame)
+	{
+		Clock::time_point start = Clock::now();
+		particles.Update(1.0f / 60.0f);
+		Clock::time_point updated = Clock::now();
+
+		float angle = frame * 0.002f;
+		XMFLOAT3 eye(30.0f * sinf(angle), 5.0f, -30.0f * cosf(angle));
+		XMFLOAT3 look(-sinf(angle), 0.0f, cosf(angle));
+		particles.SortBackToFront(eye, look);
+		Clock::time_point sorted = Clock::now();
+
+		updateMs += ElapsedMs(start, updated);
+		sortMs += ElapsedMs(updated, sorted);
+
+		UINT path = static_cast<UINT>(particles.GetLastSortPath());
+		if (path < 4)
+		{
+			++paths[path];
+		}
+	}
+
+	wprintf(L"%u particles, %u frames, %u threads\n", count, frames, GThreadPool::Get().GetThreadCount());
+	wprintf(L"  update: %.3f ms per frame\n", updateMs / frames);
+	wprintf(L"  sort:   %.3f ms per frame\n", sortMs / frames);
+	wprintf(L"  sort paths: none %u, reused %u, refined %u, radix %u\n",
+		paths[GRadixSort::SORT_NONE], paths[GRadixSort::SORT_REUSED], paths[GRadixSort::SORT_REFINED], paths[GRadixSort::SORT_RADIX]);
+
+	return 0;
+}
\ No newline at end of file
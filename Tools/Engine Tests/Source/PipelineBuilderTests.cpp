@@ -0,0 +1,687 @@
+/*  ===============================================
+	Summary: Pipeline Builder Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GPipelineBuilder.h"
+#include "GShaderCache.h"
+#include "GThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const wchar_t* const TestDirectory = L"PipelineBuilderTest/";
+	const wchar_t* const BenchDirectory = L"PipelineBuilderBench/";
+
+	// GPipelineBuilder's target profiles, by ShaderStage.
+	const char* const Targets[] = { "vs_5_0", "hs_5_0", "ds_5_0", "gs_5_0", "ps_5_0", "cs_5_0" };
+
+	// Stands in for D3DCompileFromFile.  Each compile takes a set time, asleep or spinning, so
+	// the builder's threads have something to overlap; the bytecode is a hash of the source, entry
+	// point and target.  Sources containing "error" fail to compile.
+	class StubCompiler
+	{
+	public:
+		StubCompiler(UINT compileUs, bool bSpin) :
+			mCompileUs(compileUs),
+			bSpinning(bSpin),
+			mCallCount(0)
+		{
+		}
+
+		GShaderCache::CompileFunc GetFunc()
+		{
+			return [this](const wchar_t* filename, const char* entryPoint, const char* target, uint32_t flags,
+				std::vector<uint8_t>& bytecode, std::string& errors)
+			{
+				return Compile(filename, entryPoint, target, flags, bytecode, errors);
+			};
+		}
+
+		bool Compile(const wchar_t* filename, const char* entryPoint, const char* target, uint32_t flags,
+			std::vector<uint8_t>& bytecode, std::string& errors)
+		{
+			++mCallCount;
+			Wait(mCompileUs, bSpinning);
+
+			std::vector<uint8_t> source;
+			if (!GShaderCache::ReadFile(filename, source))
+			{
+				errors = "stub: cannot open source";
+				return false;
+			}
+
+			if (std::string(source.begin(), source.end()).find("error") != std::string::npos)
+			{
+				errors = "stub: error in source";
+				return false;
+			}
+
+			uint64_t hash = GShaderCache::Hash(source.data(), source.size());
+			hash = GShaderCache::Hash(entryPoint, strlen(entryPoint), hash);
+			hash = GShaderCache::Hash(target, strlen(target), hash);
+			hash = GShaderCache::Hash(&flags, sizeof(flags), hash);
+
+			bytecode.resize(32);
+			for (size_t i = 0; i < bytecode.size(); ++i)
+			{
+				bytecode[i] = static_cast<uint8_t>(hash >> ((i % 8) * 8)) ^ static_cast<uint8_t>(i);
+			}
+			return true;
+		}
+
+		inline UINT GetCallCount() const { return mCallCount; }
+
+		static void Wait(UINT us, bool bSpin)
+		{
+			if (!bSpin)
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(us));
+				return;
+			}
+
+			Clock::time_point end = Clock::now() + std::chrono::microseconds(us);
+			while (Clock::now() < end)
+			{
+			}
+		}
+
+	private:
+		UINT mCompileUs;
+		bool bSpinning;
+		std::atomic<UINT> mCallCount;
+	};
+
+	// A device child that only counts references.
+	template <class Interface>
+	class FakeObject : public Interface
+	{
+	public:
+		FakeObject() :
+			mRefCount(1)
+		{
+		}
+
+		virtual ~FakeObject()
+		{
+		}
+
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void** object) { *object = nullptr; return E_NOINTERFACE; }
+		ULONG STDMETHODCALLTYPE AddRef() { return ++mRefCount; }
+		ULONG STDMETHODCALLTYPE Release()
+		{
+			ULONG count = --mRefCount;
+			if (count == 0)
+			{
+				delete this;
+			}
+			return count;
+		}
+
+		void STDMETHODCALLTYPE GetDevice(ID3D11Device** device) { *device = nullptr; }
+		HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID, UINT*, void*) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID, UINT, const void*) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID, const IUnknown*) { return E_NOTIMPL; }
+
+	private:
+		std::atomic<ULONG> mRefCount;
+	};
+
+	enum ObjectKind
+	{
+		OBJECT_VERTEX,
+		OBJECT_HULL,
+		OBJECT_DOMAIN,
+		OBJECT_GEOMETRY,
+		OBJECT_PIXEL,
+		OBJECT_COMPUTE,
+		OBJECT_STREAM_OUT,
+		OBJECT_INPUT_LAYOUT
+	};
+
+	struct CreatedObject
+	{
+		ObjectKind Kind;
+		void* Object;
+		std::vector<uint8_t> Bytecode;
+
+		// Input layout elements or stream output entries, by semantic.
+		std::vector<std::string> Semantics;
+		UINT RasterizedStream;
+	};
+
+	// Records every shader, input layout and stream output the builder creates, from whichever
+	// thread creates it.  Each object takes a set time to create.  The rest of the device is not
+	// implemented.
+	class FakeDevice : public ID3D11Device
+	{
+	public:
+		explicit FakeDevice(UINT createUs) :
+			mCreateUs(createUs)
+		{
+		}
+
+		std::vector<CreatedObject> GetCreated()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			return mCreated;
+		}
+
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void** object) { *object = nullptr; return E_NOINTERFACE; }
+		ULONG STDMETHODCALLTYPE AddRef() { return 1; }
+		ULONG STDMETHODCALLTYPE Release() { return 1; }
+
+		HRESULT STDMETHODCALLTYPE CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, UINT numElements,
+			const void* bytecode, SIZE_T bytecodeLength, ID3D11InputLayout** layout)
+		{
+			CreatedObject record;
+			for (UINT i = 0; i < numElements; ++i)
+			{
+				record.Semantics.push_back(elements[i].SemanticName);
+			}
+			return Create(OBJECT_INPUT_LAYOUT, bytecode, bytecodeLength, layout, record);
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateVertexShader(const void* bytecode, SIZE_T bytecodeLength, ID3D11ClassLinkage*, ID3D11VertexShader** shader)
+		{
+			return Create(OBJECT_VERTEX, bytecode, bytecodeLength, shader, CreatedObject());
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateGeometryShader(const void* bytecode, SIZE_T bytecodeLength, ID3D11ClassLinkage*, ID3D11GeometryShader** shader)
+		{
+			return Create(OBJECT_GEOMETRY, bytecode, bytecodeLength, shader, CreatedObject());
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateGeometryShaderWithStreamOutput(const void* bytecode, SIZE_T bytecodeLength,
+			const D3D11_SO_DECLARATION_ENTRY* entries, UINT numEntries, const UINT*, UINT, UINT rasterizedStream,
+			ID3D11ClassLinkage*, ID3D11GeometryShader** shader)
+		{
+			CreatedObject record;
+			for (UINT i = 0; i < numEntries; ++i)
+			{
+				record.Semantics.push_back(entries[i].SemanticName);
+			}
+			record.RasterizedStream = rasterizedStream;
+			return Create(OBJECT_STREAM_OUT, bytecode, bytecodeLength, shader, record);
+		}
+
+		HRESULT STDMETHODCALLTYPE CreatePixelShader(const void* bytecode, SIZE_T bytecodeLength, ID3D11ClassLinkage*, ID3D11PixelShader** shader)
+		{
+			return Create(OBJECT_PIXEL, bytecode, bytecodeLength, shader, CreatedObject());
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateHullShader(const void* bytecode, SIZE_T bytecodeLength, ID3D11ClassLinkage*, ID3D11HullShader** shader)
+		{
+			return Create(OBJECT_HULL, bytecode, bytecodeLength, shader, CreatedObject());
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateDomainShader(const void* bytecode, SIZE_T bytecodeLength, ID3D11ClassLinkage*, ID3D11DomainShader** shader)
+		{
+			return Create(OBJECT_DOMAIN, bytecode, bytecodeLength, shader, CreatedObject());
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateComputeShader(const void* bytecode, SIZE_T bytecodeLength, ID3D11ClassLinkage*, ID3D11ComputeShader** shader)
+		{
+			return Create(OBJECT_COMPUTE, bytecode, bytecodeLength, shader, CreatedObject());
+		}
+
+		HRESULT STDMETHODCALLTYPE CreateBuffer(const D3D11_BUFFER_DESC*, const D3D11_SUBRESOURCE_DATA*, ID3D11Buffer**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateTexture1D(const D3D11_TEXTURE1D_DESC*, const D3D11_SUBRESOURCE_DATA*, ID3D11Texture1D**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateTexture2D(const D3D11_TEXTURE2D_DESC*, const D3D11_SUBRESOURCE_DATA*, ID3D11Texture2D**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateTexture3D(const D3D11_TEXTURE3D_DESC*, const D3D11_SUBRESOURCE_DATA*, ID3D11Texture3D**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateShaderResourceView(ID3D11Resource*, const D3D11_SHADER_RESOURCE_VIEW_DESC*, ID3D11ShaderResourceView**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateUnorderedAccessView(ID3D11Resource*, const D3D11_UNORDERED_ACCESS_VIEW_DESC*, ID3D11UnorderedAccessView**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateRenderTargetView(ID3D11Resource*, const D3D11_RENDER_TARGET_VIEW_DESC*, ID3D11RenderTargetView**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateDepthStencilView(ID3D11Resource*, const D3D11_DEPTH_STENCIL_VIEW_DESC*, ID3D11DepthStencilView**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateClassLinkage(ID3D11ClassLinkage**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateBlendState(const D3D11_BLEND_DESC*, ID3D11BlendState**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC*, ID3D11DepthStencilState**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateRasterizerState(const D3D11_RASTERIZER_DESC*, ID3D11RasterizerState**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateSamplerState(const D3D11_SAMPLER_DESC*, ID3D11SamplerState**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateQuery(const D3D11_QUERY_DESC*, ID3D11Query**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreatePredicate(const D3D11_QUERY_DESC*, ID3D11Predicate**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateCounter(const D3D11_COUNTER_DESC*, ID3D11Counter**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CreateDeferredContext(UINT, ID3D11DeviceContext**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE OpenSharedResource(HANDLE, REFIID, void**) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CheckFormatSupport(DXGI_FORMAT, UINT*) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CheckMultisampleQualityLevels(DXGI_FORMAT, UINT, UINT*) { return E_NOTIMPL; }
+		void STDMETHODCALLTYPE CheckCounterInfo(D3D11_COUNTER_INFO*) {}
+		HRESULT STDMETHODCALLTYPE CheckCounter(const D3D11_COUNTER_DESC*, D3D11_COUNTER_TYPE*, UINT*, LPSTR, UINT*, LPSTR, UINT*, LPSTR, UINT*) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE CheckFeatureSupport(D3D11_FEATURE, void*, UINT) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID, UINT*, void*) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID, UINT, const void*) { return E_NOTIMPL; }
+		HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID, const IUnknown*) { return E_NOTIMPL; }
+		D3D_FEATURE_LEVEL STDMETHODCALLTYPE GetFeatureLevel() { return D3D_FEATURE_LEVEL_11_0; }
+		UINT STDMETHODCALLTYPE GetCreationFlags() { return 0; }
+		HRESULT STDMETHODCALLTYPE GetDeviceRemovedReason() { return S_OK; }
+		void STDMETHODCALLTYPE GetImmediateContext(ID3D11DeviceContext** context) { *context = nullptr; }
+		HRESULT STDMETHODCALLTYPE SetExceptionMode(UINT) { return E_NOTIMPL; }
+		UINT STDMETHODCALLTYPE GetExceptionMode() { return 0; }
+
+	private:
+		template <class Interface>
+		HRESULT Create(ObjectKind kind, const void* bytecode, SIZE_T bytecodeLength, Interface** object, CreatedObject record)
+		{
+			if (!bytecode || bytecodeLength == 0 || !object)
+			{
+				return E_INVALIDARG;
+			}
+
+			StubCompiler::Wait(mCreateUs, false);
+
+			*object = new FakeObject<Interface>();
+
+			record.Kind = kind;
+			record.Object = *object;
+			record.Bytecode.assign(static_cast<const uint8_t*>(bytecode), static_cast<const uint8_t*>(bytecode) + bytecodeLength);
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			mCreated.push_back(record);
+			return S_OK;
+		}
+
+	private:
+		UINT mCreateUs;
+
+		std::mutex mMutex;
+		std::vector<CreatedObject> mCreated;
+	};
+
+	// Every shader a demo can ask for, one job per stage, plus a vertex shader with an input
+	// layout and a geometry shader streaming out.
+	struct TestPipeline
+	{
+		ID3D11VertexShader* VertexShader;
+		ID3D11VertexShader* LayoutVertexShader;
+		ID3D11InputLayout* Layout;
+		ID3D11HullShader* HullShader;
+		ID3D11DomainShader* DomainShader;
+		ID3D11GeometryShader* GeometryShader;
+		ID3D11GeometryShader* StreamOutShader;
+		ID3D11PixelShader* PixelShader;
+		ID3D11ComputeShader* ComputeShader;
+	};
+
+	const D3D11_INPUT_ELEMENT_DESC LayoutDesc[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+	};
+
+	const D3D11_SO_DECLARATION_ENTRY StreamOutDesc[] =
+	{
+		{ 0, "POSITION", 0, 0, 3, 0 },
+		{ 0, "VELOCITY", 0, 0, 3, 0 },
+		{ 0, "AGE",      0, 0, 1, 0 }
+	};
+
+	const UINT LayoutElementCount = sizeof(LayoutDesc) / sizeof(LayoutDesc[0]);
+	const UINT StreamOutEntryCount = sizeof(StreamOutDesc) / sizeof(StreamOutDesc[0]);
+
+	void AddTestPipeline(GPipelineBuilder& builder, const std::wstring& dir, TestPipeline& pipeline)
+	{
+		memset(&pipeline, 0, sizeof(pipeline));
+
+		std::wstring basic = dir + L"Basic.hlsl";
+		std::wstring tessellation = dir + L"Tessellation.hlsl";
+		std::wstring particles = dir + L"Particles.hlsl";
+		std::wstring blur = dir + L"Blur.hlsl";
+
+		builder.AddVertexShader(&pipeline.VertexShader, basic.c_str(), "VS");
+		builder.AddVertexShader(&pipeline.LayoutVertexShader, basic.c_str(), "LitVS", LayoutDesc, LayoutElementCount, &pipeline.Layout);
+		builder.AddHullShader(&pipeline.HullShader, tessellation.c_str(), "HS");
+		builder.AddDomainShader(&pipeline.DomainShader, tessellation.c_str(), "DS");
+		builder.AddGeometryShader(&pipeline.GeometryShader, particles.c_str(), "DrawGS");
+		builder.AddGeometryShader(&pipeline.StreamOutShader, particles.c_str(), "StreamOutGS", StreamOutDesc, StreamOutEntryCount,
+			D3D11_SO_NO_RASTERIZED_STREAM);
+		builder.AddPixelShader(&pipeline.PixelShader, basic.c_str(), "PS");
+		builder.AddComputeShader(&pipeline.ComputeShader, blur.c_str(), "CS");
+	}
+
+	template <class Interface>
+	void Release(Interface*& object)
+	{
+		if (object)
+		{
+			object->Release();
+			object = nullptr;
+		}
+	}
+
+	void ReleasePipeline(TestPipeline& pipeline)
+	{
+		Release(pipeline.VertexShader);
+		Release(pipeline.LayoutVertexShader);
+		Release(pipeline.Layout);
+		Release(pipeline.HullShader);
+		Release(pipeline.DomainShader);
+		Release(pipeline.GeometryShader);
+		Release(pipeline.StreamOutShader);
+		Release(pipeline.PixelShader);
+		Release(pipeline.ComputeShader);
+	}
+
+	const CreatedObject* FindCreated(const std::vector<CreatedObject>& created, const void* object)
+	{
+		for (size_t i = 0; i < created.size(); ++i)
+		{
+			if (created[i].Object == object)
+			{
+				return &created[i];
+			}
+		}
+		return nullptr;
+	}
+
+	// The object was created once, as kind, from the bytecode the stub gives for the job.
+	bool CreatedFromJob(const std::vector<CreatedObject>& created, const void* object, ObjectKind kind,
+		const GPipelineBuilder::Job& job, StubCompiler& reference)
+	{
+		const CreatedObject* record = FindCreated(created, object);
+		if (!object || !record || record->Kind != kind)
+		{
+			return false;
+		}
+
+		std::vector<uint8_t> bytecode;
+		std::string errors;
+		return reference.Compile(job.Filename.c_str(), job.EntryPoint.c_str(), Targets[job.Stage], GShaderCache::GetDefaultFlags(), bytecode, errors) &&
+			record->Bytecode == bytecode;
+	}
+
+	bool WriteSource(const std::wstring& filename, const std::string& text)
+	{
+		return GShaderCache::WriteFileAtomic(filename, text.data(), text.size());
+	}
+
+	bool Contains(const std::wstring& text, const std::wstring& part)
+	{
+		return text.find(part) != std::wstring::npos;
+	}
+
+	size_t Count(const std::wstring& text, const std::wstring& part)
+	{
+		size_t count = 0;
+		for (size_t at = text.find(part); at != std::wstring::npos; at = text.find(part, at + part.size()))
+		{
+			++count;
+		}
+		return count;
+	}
+
+	// Sources for the shader count a scaling run builds.  The run number changes their contents, so
+	// every run misses the cache and compiles.
+	bool WriteScalingSources(const std::wstring& dir, UINT shaderCount, UINT run, std::vector<std::wstring>& files)
+	{
+		files.clear();
+		bool bWritten = true;
+
+		for (UINT i = 0; i < shaderCount; ++i)
+		{
+			files.push_back(dir + L"Shader" + std::to_wstring(i) + L".hlsl");
+			bWritten = WriteSource(files.back(), "// run " + std::to_string(run) + "\nfloat4 PS() : SV_Target { return 1; }\n") && bWritten;
+		}
+
+		return bWritten;
+	}
+
+	// Wall time to build the shaders on a pool with this many threads, calling thread included.
+	double TimeBuild(const std::vector<std::wstring>& files, GShaderCache& cache, UINT threadCount, FakeDevice& device,
+		UINT& failures)
+	{
+		GThreadPool pool(threadCount - 1);
+		GPipelineBuilder builder(cache, pool);
+
+		std::vector<ID3D11PixelShader*> shaders(files.size(), nullptr);
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			builder.AddPixelShader(&shaders[i], files[i].c_str(), "PS");
+		}
+
+		bool bBuilt = builder.Build(&device);
+
+		failures += bBuilt && pool.GetThreadCount() == threadCount ? 0 : 1;
+
+		for (size_t i = 0; i < shaders.size(); ++i)
+		{
+			Release(shaders[i]);
+		}
+
+		return builder.GetBuildMs();
+	}
+}
+
+void TestPipelineBuilder()
+{
+	std::wstring dir = TestDirectory;
+	ClearDirectory(dir);
+
+	if (!CHECK(MakeDirectory(dir)))
+	{
+		return;
+	}
+
+	CHECK(WriteSource(dir + L"Basic.hlsl", "float4 VS() : SV_POSITION { return 0; }\nfloat4 PS() : SV_Target { return 1; }\n"));
+	CHECK(WriteSource(dir + L"Tessellation.hlsl", "void HS() {}\nvoid DS() {}\n"));
+	CHECK(WriteSource(dir + L"Particles.hlsl", "void DrawGS() {}\nvoid StreamOutGS() {}\n"));
+	CHECK(WriteSource(dir + L"Blur.hlsl", "[numthreads(256, 1, 1)] void CS() {}\n"));
+	CHECK(WriteSource(dir + L"Broken.hlsl", "float4 PS() : SV_Target { error }\n"));
+
+	// Each compile and each object takes long enough to show up in the job times.
+	const UINT CompileUs = 2000;
+	const UINT CreateUs = 1000;
+
+	StubCompiler reference(0, false);
+
+	// Every job creates its shader, and the layout and stream output declared with it, from the
+	// bytecode of its own compile.
+	{
+		StubCompiler stub(CompileUs, false);
+		GShaderCache cache;
+		cache.SetDirectory(dir + L"Cache");
+		cache.SetCompiler(stub.GetFunc());
+
+		GPipelineBuilder builder(cache);
+		TestPipeline pipeline;
+		AddTestPipeline(builder, dir, pipeline);
+
+		FakeDevice device(CreateUs);
+		CHECK(builder.Build(&device));
+		CHECK(builder.GetJobCount() == 8 && stub.GetCallCount() == 8);
+
+		std::vector<CreatedObject> created = device.GetCreated();
+		CHECK(created.size() == 9);
+
+		CHECK(CreatedFromJob(created, pipeline.VertexShader, OBJECT_VERTEX, builder.GetJob(0), reference));
+		CHECK(CreatedFromJob(created, pipeline.LayoutVertexShader, OBJECT_VERTEX, builder.GetJob(1), reference));
+		CHECK(CreatedFromJob(created, pipeline.HullShader, OBJECT_HULL, builder.GetJob(2), reference));
+		CHECK(CreatedFromJob(created, pipeline.DomainShader, OBJECT_DOMAIN, builder.GetJob(3), reference));
+		CHECK(CreatedFromJob(created, pipeline.GeometryShader, OBJECT_GEOMETRY, builder.GetJob(4), reference));
+		CHECK(CreatedFromJob(created, pipeline.StreamOutShader, OBJECT_STREAM_OUT, builder.GetJob(5), reference));
+		CHECK(CreatedFromJob(created, pipeline.PixelShader, OBJECT_PIXEL, builder.GetJob(6), reference));
+		CHECK(CreatedFromJob(created, pipeline.ComputeShader, OBJECT_COMPUTE, builder.GetJob(7), reference));
+
+		// The layout is checked against the signature of the vertex shader it was declared with.
+		const CreatedObject* layout = FindCreated(created, pipeline.Layout);
+		const CreatedObject* layoutShader = FindCreated(created, pipeline.LayoutVertexShader);
+		CHECK(layout && layout->Kind == OBJECT_INPUT_LAYOUT);
+		CHECK(layout && layoutShader && layout->Bytecode == layoutShader->Bytecode);
+		CHECK(layout && layout->Semantics.size() == LayoutElementCount &&
+			layout->Semantics[0] == "POSITION" && layout->Semantics[1] == "NORMAL" && layout->Semantics[2] == "TEXCOORD");
+
+		const CreatedObject* streamOut = FindCreated(created, pipeline.StreamOutShader);
+		CHECK(streamOut && streamOut->Semantics.size() == StreamOutEntryCount &&
+			streamOut->Semantics[0] == "POSITION" && streamOut->Semantics[1] == "VELOCITY" && streamOut->Semantics[2] == "AGE");
+		CHECK(streamOut && streamOut->RasterizedStream == D3D11_SO_NO_RASTERIZED_STREAM);
+
+		// The times cover the stub's compile and the fake's create; the layout is a second object.
+		for (UINT i = 0; i < builder.GetJobCount(); ++i)
+		{
+			const GPipelineBuilder::Job& job = builder.GetJob(i);
+			double objects = i == 1 ? 2.0 : 1.0;
+
+			if (!CHECK(job.Result == S_OK && job.Errors.empty() && job.CompileMs >= CompileUs / 1000.0 && job.CreateMs >= objects * CreateUs / 1000.0))
+			{
+				fwprintf(stderr, L"  %ls %hs: compile %.3f ms, create %.3f ms\n", job.Filename.c_str(), job.EntryPoint.c_str(), job.CompileMs, job.CreateMs);
+			}
+		}
+
+		CHECK(builder.GetBuildMs() > 0.0);
+
+		std::wstring report = builder.GetReport();
+		CHECK(Contains(report, dir + L"Tessellation.hlsl DS: compile "));
+		CHECK(Contains(report, L"8 shaders built in "));
+		CHECK(!Contains(report, L"FAILED"));
+
+		ReleasePipeline(pipeline);
+
+		// Without a device the shaders are only compiled, into the cache the demo's next build hits.
+		GPipelineBuilder warm(cache);
+		TestPipeline unused;
+		AddTestPipeline(warm, dir, unused);
+
+		CHECK(warm.Build(nullptr));
+		CHECK(stub.GetCallCount() == 8 && cache.GetHitCount() == 8);
+		for (UINT i = 0; i < warm.GetJobCount(); ++i)
+		{
+			CHECK(warm.GetJob(i).Result == S_OK && warm.GetJob(i).CreateMs == 0.0);
+		}
+		CHECK(unused.VertexShader == nullptr && unused.Layout == nullptr && unused.StreamOutShader == nullptr);
+		CHECK(device.GetCreated().size() == created.size());
+	}
+
+	// A failing compile fails Build and is reported, and the other jobs are still created.
+	{
+		StubCompiler stub(0, false);
+		GShaderCache cache;
+		cache.SetDirectory(dir + L"Cache");
+		cache.SetCompiler(stub.GetFunc());
+
+		GPipelineBuilder builder(cache);
+
+		ID3D11PixelShader* good = nullptr;
+		ID3D11PixelShader* broken = nullptr;
+		ID3D11ComputeShader* missing = nullptr;
+		ID3D11VertexShader* vertexShader = nullptr;
+		ID3D11InputLayout* layout = nullptr;
+
+		std::wstring basic = dir + L"Basic.hlsl";
+		builder.AddPixelShader(&good, basic.c_str(), "PS");
+		UINT brokenJob = builder.AddPixelShader(&broken, (dir + L"Broken.hlsl").c_str(), "PS");
+		UINT missingJob = builder.AddComputeShader(&missing, (dir + L"Missing.hlsl").c_str(), "CS");
+		builder.AddVertexShader(&vertexShader, basic.c_str(), "VS", LayoutDesc, LayoutElementCount, &layout);
+
+		FakeDevice device(0);
+		CHECK(!builder.Build(&device));
+
+		CHECK(good && vertexShader && layout && device.GetCreated().size() == 3);
+		CHECK(!broken && !missing);
+
+		const GPipelineBuilder::Job& brokenResult = builder.GetJob(brokenJob);
+		CHECK(FAILED(brokenResult.Result) && brokenResult.Errors == "stub: error in source" && brokenResult.CreateMs == 0.0);
+		CHECK(FAILED(builder.GetJob(missingJob).Result) && !builder.GetJob(missingJob).Errors.empty());
+
+		std::wstring report = builder.GetReport();
+		CHECK(Contains(report, dir + L"Broken.hlsl PS: compile "));
+		CHECK(Contains(report, L"ms, FAILED\nstub: error in source\n"));
+		CHECK(Contains(report, dir + L"Missing.hlsl CS: compile "));
+		CHECK(Count(report, L"FAILED") == 2);
+
+		Release(good);
+		Release(vertexShader);
+		Release(layout);
+	}
+
+	// With compiles that wait rather than compute, more threads overlap more of them whatever the
+	// core count, so each doubling has to cut the wall time well down.  The waits are long next to
+	// the cache's own file work, which does not overlap on a single core.
+	{
+		StubCompiler stub(20000, false);
+		GShaderCache cache;
+		cache.SetDirectory(dir + L"Cache");
+		cache.SetCompiler(stub.GetFunc());
+
+		FakeDevice device(1000);
+
+		const UINT ThreadCounts[] = { 2, 4, 8 };
+		double wallMs[3] = {};
+		UINT failures = 0;
+
+		for (UINT i = 0; i < 3; ++i)
+		{
+			std::vector<std::wstring> files;
+			CHECK(WriteScalingSources(dir, 8, i, files));
+			wallMs[i] = TimeBuild(files, cache, ThreadCounts[i], device, failures);
+		}
+
+		CHECK(failures == 0);
+		CHECK(stub.GetCallCount() == 24);
+
+		if (!CHECK(wallMs[1] < 0.8 * wallMs[0] && wallMs[2] < 0.8 * wallMs[1]))
+		{
+			fwprintf(stderr, L"  2, 4, 8 threads: %.2f, %.2f, %.2f ms\n", wallMs[0], wallMs[1], wallMs[2]);
+		}
+	}
+
+	ClearDirectory(dir);
+}
+
+int BenchPipelineBuilder(int argc, wchar_t* argv[])
+{
+	UINT shaderCount = (std::max)(GetOption(argc, argv, L"shaders", 32), 1u);
+	UINT compileUs = GetOption(argc, argv, L"compileus", 2000);
+	UINT runs = (std::max)(GetOption(argc, argv, L"runs", 3), 1u);
+	UINT maxThreads = (std::max)(GetOption(argc, argv, L"threads", GThreadPool::Get().GetThreadCount()), 2u);
+
+	std::wstring dir = BenchDirectory;
+	ClearDirectory(dir);
+	if (!MakeDirectory(dir))
+	{
+		wprintf(L"Cannot create %ls\n", dir.c_str());
+		return 1;
+	}
+
+	// The stub spins, as a compiler would keep a core busy; a sleeping stub would scale past the
+	// core count.
+	StubCompiler stub(compileUs, true);
+	GShaderCache cache;
+	cache.SetDirectory(dir + L"Cache");
+	cache.SetCompiler(stub.GetFunc());
+
+	FakeDevice device(0);
+	UINT failures = 0;
+	UINT run = 0;
+
+	double serialMs = shaderCount * compileUs / 1000.0;
+
+	wprintf(L"%u shaders, %u us per compile, %u runs, %u hardware threads\n", shaderCount, compileUs, runs, std::thread::hardware_concurrency());
+
+	for (UINT threads = 2; threads <= maxThreads; threads *= 2)
+	{
+		double wallMs = 0.0;
+
+		for (UINT r = 0; r < runs; ++r, ++run)
+		{
+			std::vector<std::wstring> files;
+			failures += WriteScalingSources(dir, shaderCount, run, files) ? 0 : 1;
+			wallMs += TimeBuild(files, cache, threads, device, failures);
+		}
+
+		// Against the compile time alone, so the cache's own file work counts against the threads.
+		wprintf(L"  %2u threads: %8.2f ms per build, %5.2fx the speed of compiling one by one\n", threads, wallMs / runs, serialMs * runs / wallMs);
+	}
+
+	ClearDirectory(dir);
+
+	wprintf(L"  failures: %u\n", failures);
+	return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
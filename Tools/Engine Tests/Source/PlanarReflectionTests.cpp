@@ -0,0 +1,203 @@
+/*  ===============================================
+	Summary: Planar Reflection Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GPlanarReflection.h"
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// The Chapter 10 mirror: 5 x 4 in the z = -0.01 plane, its bottom edge on the floor, facing -z.
+	const float MirrorZ = -0.01f;
+	const float MirrorHalfWidth = 2.5f;
+	const float MirrorHeight = 4.0f;
+
+	void SetupMirror(GPlanarReflection& mirror)
+	{
+		XMFLOAT3 corners[4] =
+		{
+			XMFLOAT3(-MirrorHalfWidth, MirrorHeight, MirrorZ),
+			XMFLOAT3(+MirrorHalfWidth, MirrorHeight, MirrorZ),
+			XMFLOAT3(+MirrorHalfWidth, 0.0f, MirrorZ),
+			XMFLOAT3(-MirrorHalfWidth, 0.0f, MirrorZ)
+		};
+		mirror.SetMirror(corners);
+	}
+
+	XMFLOAT4X4 Projection()
+	{
+		XMFLOAT4X4 proj;
+		XMStoreFloat4x4(&proj, XMMatrixPerspectiveFovLH(0.25f * XM_PI, 1.333f, 1.0f, 1000.0f));
+		return proj;
+	}
+
+	XMFLOAT4X4 LookAt(const XMFLOAT3& eye, const XMFLOAT3& target)
+	{
+		XMFLOAT4X4 view;
+		XMStoreFloat4x4(&view, XMMatrixLookAtLH(XMLoadFloat3(&eye), XMLoadFloat3(&target), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+		return view;
+	}
+
+	bool IsInFrustum(const XMFLOAT3& p, const XMMATRIX& viewProj)
+	{
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector4Transform(XMVectorSet(p.x, p.y, p.z, 1.0f), viewProj));
+		return clip.w > 0.0f && clip.z >= 0.0f && clip.z <= clip.w && fabsf(clip.x) <= clip.w && fabsf(clip.y) <= clip.w;
+	}
+
+	// Whether the camera sees a point's reflection: the reflection is in the camera frustum and the
+	// line of sight to it crosses a part of the mirror quad that is drawn, so is not near clipped.
+	bool SeesReflection(const GPlanarReflection& mirror, const XMFLOAT3& eye, const XMFLOAT4X4& view, const XMFLOAT4X4& proj, const XMFLOAT3& p)
+	{
+		XMMATRIX viewProj = XMLoadFloat4x4(&view) * XMLoadFloat4x4(&proj);
+
+		XMFLOAT3 r;
+		XMStoreFloat3(&r, XMVector3TransformCoord(XMLoadFloat3(&p), mirror.GetReflection()));
+		if (!IsInFrustum(r, viewProj))
+		{
+			return false;
+		}
+
+		if (eye.z >= MirrorZ || r.z <= MirrorZ)
+		{
+			return false;
+		}
+
+		float t = (MirrorZ - eye.z) / (r.z - eye.z);
+		XMFLOAT3 crossing(eye.x + t * (r.x - eye.x), eye.y + t * (r.y - eye.y), MirrorZ);
+		return fabsf(crossing.x) <= MirrorHalfWidth && crossing.y >= 0.0f && crossing.y <= MirrorHeight && IsInFrustum(crossing, viewProj);
+	}
+}
+
+void TestPlanarReflection()
+{
+	GPlanarReflection mirror;
+	SetupMirror(mirror);
+
+	// The plane faces the viewer and passes through the quad; the reflection flips z about it.
+	XMFLOAT4 plane = mirror.GetPlane();
+	CHECK(fabsf(plane.x) < 1e-6f && fabsf(plane.y) < 1e-6f && fabsf(plane.z + 1.0f) < 1e-6f);
+	CHECK(fabsf(plane.w - MirrorZ) < 1e-6f);
+
+	XMFLOAT3 reflected;
+	XMStoreFloat3(&reflected, XMVector3TransformCoord(XMVectorSet(1.0f, 2.0f, -3.0f, 1.0f), mirror.GetReflection()));
+	CHECK(fabsf(reflected.x - 1.0f) < 1e-5f && fabsf(reflected.y - 2.0f) < 1e-5f && fabsf(reflected.z - (2.0f * MirrorZ + 3.0f)) < 1e-5f);
+
+	XMFLOAT4X4 proj = Projection();
+
+	// Behind the mirror, looking away from it, or looking past it: nothing to draw.
+	CHECK(!mirror.Update(LookAt(XMFLOAT3(0.0f, 2.0f, 5.0f), XMFLOAT3(0.0f, 2.0f, -5.0f)), proj));
+	CHECK(!mirror.Update(LookAt(XMFLOAT3(0.0f, 2.0f, -10.0f), XMFLOAT3(0.0f, 2.0f, -20.0f)), proj));
+	CHECK(!mirror.Update(LookAt(XMFLOAT3(0.0f, 2.0f, -10.0f), XMFLOAT3(20.0f, 2.0f, -10.0f)), proj));
+
+	// Facing it from afar the mirror covers part of the screen; up close, all of it; closer than the
+	// near plane, none of it.
+	CHECK(mirror.Update(LookAt(XMFLOAT3(0.0f, 2.0f, -10.0f), XMFLOAT3(0.0f, 2.0f, 0.0f)), proj));
+	XMFLOAT4 bounds = mirror.GetScreenBounds();
+	CHECK(bounds.x > -1.0f && bounds.z < 1.0f && bounds.y > -1.0f && bounds.w < 1.0f);
+	CHECK(fabsf(bounds.x + bounds.z) < 1e-4f);
+
+	CHECK(mirror.Update(LookAt(XMFLOAT3(0.0f, 2.0f, -1.5f), XMFLOAT3(0.0f, 2.0f, 5.0f)), proj));
+	bounds = mirror.GetScreenBounds();
+	CHECK(bounds.x == -1.0f && bounds.y == -1.0f && bounds.z == 1.0f && bounds.w == 1.0f);
+	CHECK(!mirror.Update(LookAt(XMFLOAT3(0.0f, 2.0f, -0.5f), XMFLOAT3(0.0f, 2.0f, 5.0f)), proj));
+
+	// From straight in front, a box in front of the mirror shows; one behind it or far off to the side does not.
+	CHECK(mirror.Update(LookAt(XMFLOAT3(0.0f, 2.0f, -10.0f), XMFLOAT3(0.0f, 2.0f, 0.0f)), proj));
+	CHECK(mirror.IsVisible(BoundingBox(XMFLOAT3(0.0f, 1.0f, -3.0f), XMFLOAT3(0.5f, 0.5f, 0.5f))));
+	CHECK(!mirror.IsVisible(BoundingBox(XMFLOAT3(0.0f, 1.0f, 5.0f), XMFLOAT3(0.5f, 0.5f, 0.5f))));
+	CHECK(!mirror.IsVisible(BoundingBox(XMFLOAT3(60.0f, 1.0f, -3.0f), XMFLOAT3(0.5f, 0.5f, 0.5f))));
+
+	// Random cameras in front of the mirror: every point whose reflection can be seen passes the
+	// cull, and most of the ones that cannot are culled.
+	std::mt19937 rng(9);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	UINT seen = 0;
+	UINT missed = 0;
+	UINT hidden = 0;
+	UINT culled = 0;
+
+	for (UINT camera = 0; camera < 200; ++camera)
+	{
+		XMFLOAT3 eye(20.0f * unit(rng) - 10.0f, 6.0f * unit(rng), -15.0f * unit(rng) - 0.5f);
+		XMFLOAT3 target(10.0f * unit(rng) - 5.0f, 4.0f * unit(rng), 4.0f * unit(rng) - 2.0f);
+		XMFLOAT4X4 view = LookAt(eye, target);
+
+		bool bDraw = mirror.Update(view, proj);
+
+		for (UINT i = 0; i < 500; ++i)
+		{
+			XMFLOAT3 p(20.0f * unit(rng) - 10.0f, 8.0f * unit(rng) - 2.0f, -12.0f * unit(rng));
+			bool bSees = SeesReflection(mirror, eye, view, proj, p);
+			bool bPasses = bDraw && mirror.IsVisible(BoundingBox(p, XMFLOAT3(0.0f, 0.0f, 0.0f)));
+
+			seen += bSees ? 1 : 0;
+			missed += bSees && !bPasses ? 1 : 0;
+			hidden += bSees ? 0 : 1;
+			culled += !bSees && !bPasses ? 1 : 0;
+		}
+	}
+
+	CHECK(seen > 0);
+	CHECK(missed == 0);
+	CHECK(culled > hidden / 2);
+}
+
+int BenchPlanarReflection(int argc, wchar_t* argv[])
+{
+	UINT objectCount = GetOption(argc, argv, L"objects", 1000);
+	UINT frames = (std::max)(GetOption(argc, argv, L"frames", 1000), 1u);
+
+	// Boxes filling the room in front of the mirror, and some behind it.
+	std::mt19937 rng(13);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	std::vector<BoundingBox> objects;
+	for (UINT i = 0; i < objectCount; ++i)
+	{
+		objects.push_back(BoundingBox(XMFLOAT3(40.0f * unit(rng) - 20.0f, 4.0f * unit(rng), 30.0f * unit(rng) - 25.0f),
+			XMFLOAT3(0.5f * unit(rng), 0.5f * unit(rng), 0.5f * unit(rng))));
+	}
+
+	GPlanarReflection mirror;
+	SetupMirror(mirror);
+	XMFLOAT4X4 proj = Projection();
+
+	UINT passes = 0;
+	UINT64 draws = 0;
+
+	// The camera orbits the room, facing the mirror half the time.
+	Clock::time_point start = Clock::now();
+	for (UINT frame = 0; frame < frames; ++frame)
+	{
+		float angle = XM_2PI * frame / frames;
+		XMFLOAT3 eye(12.0f * sinf(angle), 3.0f, -12.0f * cosf(angle));
+
+		if (mirror.Update(LookAt(eye, XMFLOAT3(0.0f, 2.0f, 0.0f)), proj))
+		{
+			++passes;
+			for (size_t i = 0; i < objects.size(); ++i)
+			{
+				draws += mirror.IsVisible(objects[i]) ? 1 : 0;
+			}
+		}
+	}
+	double ms = ElapsedMs(start, Clock::now());
+
+	wprintf(L"%u objects, %u frames orbiting the mirror\n", objectCount, frames);
+	wprintf(L"  reflection pass on %5.1f%% of frames\n", 100.0 * passes / frames);
+	wprintf(L"  reflected draws    %8.1f per frame, against %u without culling\n", static_cast<double>(draws) / frames, objectCount);
+	wprintf(L"  update and cull    %8.2f us per frame\n", 1000.0 * ms / frames);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,198 @@
+/*  ===============================================
+	Summary: Radix Sort Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GRadixSort.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	// Indices must be a permutation that orders the keys, with equal keys in input order.
+	bool IsStableOrder(const std::vector<UINT>& keys, const std::vector<UINT>& indices)
+	{
+		std::vector<bool> seen(keys.size(), false);
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			if (indices[i] >= keys.size() || seen[indices[i]])
+			{
+				return false;
+			}
+			seen[indices[i]] = true;
+
+			if (i > 0)
+			{
+				UINT a = keys[indices[i - 1]];
+				UINT b = keys[indices[i]];
+				if (a > b || (a == b && indices[i - 1] > indices[i]))
+				{
+					return false;
+				}
+			}
+		}
+		return indices.size() == keys.size();
+	}
+
+	void CheckSort(UINT count, UINT keyRange, std::mt19937& rng)
+	{
+		std::uniform_int_distribution<UINT> dist(0, keyRange - 1);
+		std::vector<UINT> keys(count);
+		for (UINT i = 0; i < count; ++i)
+		{
+			keys[i] = dist(rng);
+		}
+
+		GRadixSort sorter;
+		std::vector<UINT> indices(count);
+		sorter.Sort(keys.data(), count, indices.data());
+		CHECK(sorter.GetLastPath() == GRadixSort::SORT_RADIX);
+		CHECK(IsStableOrder(keys, indices));
+	}
+}
+
+void TestRadixSort()
+{
+	std::mt19937 rng(26);
+
+	// Below and above the size split across the thread pool, with and without duplicate keys.
+	CheckSort(1, 0xFFFFFFFF, rng);
+	CheckSort(100, 0xFFFFFFFF, rng);
+	CheckSort(100, 4, rng);
+	CheckSort(100000, 0xFFFFFFFF, rng);
+	CheckSort(100000, 1000, rng);
+
+	GRadixSort sorter;
+	sorter.Sort(nullptr, 0, nullptr);
+	CHECK(sorter.GetLastPath() == GRadixSort::SORT_NONE);
+
+	const UINT count = 50000;
+	std::vector<UINT> keys(count);
+	for (UINT i = 0; i < count; ++i)
+	{
+		keys[i] = static_cast<UINT>(rng());
+	}
+
+	std::vector<UINT> indices(count);
+	sorter.Sort(keys.data(), count, indices.data());
+	CHECK(sorter.GetLastPath() == GRadixSort::SORT_RADIX);
+
+	// Unchanged keys keep the previous order.
+	std::vector<UINT> previous = indices;
+	sorter.Sort(keys.data(), count, indices.data());
+	CHECK(sorter.GetLastPath() == GRadixSort::SORT_REUSED);
+	CHECK(indices == previous);
+
+	// A few neighbours trading places are fixed up in place.
+	for (UINT i = 0; i + 1 < count; i += 1000)
+	{
+		std::swap(keys[indices[i]], keys[indices[i + 1]]);
+	}
+	sorter.Sort(keys.data(), count, indices.data());
+	CHECK(sorter.GetLastPath() == GRadixSort::SORT_REFINED);
+	CHECK(IsStableOrder(keys, indices));
+
+	// New keys everywhere fall back to a full sort.
+	for (UINT i = 0; i < count; ++i)
+	{
+		keys[i] = static_cast<UINT>(rng());
+	}
+	sorter.Sort(keys.data(), count, indices.data());
+	CHECK(sorter.GetLastPath() == GRadixSort::SORT_RADIX);
+	CHECK(IsStableOrder(keys, indices));
+
+	// A different count never trusts the previous order.
+	sorter.Sort(keys.data(), count - 1, indices.data());
+	CHECK(sorter.GetLastPath() == GRadixSort::SORT_RADIX);
+
+	const float values[] = { -1e30f, -2.5f, -1.0f, -1e-30f, -0.0f, 0.0f, 1e-30f, 0.5f, 1.0f, 3.0f, 1e30f };
+	const size_t valueCount = sizeof(values) / sizeof(values[0]);
+	for (size_t i = 1; i < valueCount; ++i)
+	{
+		UINT a = GRadixSort::FloatToKey(values[i - 1]);
+		UINT b = GRadixSort::FloatToKey(values[i]);
+		CHECK(values[i - 1] < values[i] ? a < b : a <= b);
+		CHECK(GRadixSort::BackToFrontKey(values[i - 1]) >= GRadixSort::BackToFrontKey(values[i]));
+	}
+}
+
+int BenchRadixSort(int argc, wchar_t* argv[])
+{
+	UINT count = GetOption(argc, argv, L"count", 1000000);
+	UINT runs = (std::max)(GetOption(argc, argv, L"runs", 10), 1u);
+
+	// View depths of objects spread through a scene, sorted back to front.
+	std::mt19937 rng(26);
+	std::uniform_real_distribution<float> depth(0.1f, 1000.0f);
+	std::vector<float> depths(count);
+	std::vector<UINT> keys(count);
+	for (UINT i = 0; i < count; ++i)
+	{
+		depths[i] = depth(rng);
+		keys[i] = GRadixSort::BackToFrontKey(depths[i]);
+	}
+
+	std::vector<std::pair<UINT, UINT>> pairs(count);
+	std::vector<UINT> indices(count);
+	GRadixSort sorter;
+
+	double stdSortMs = 0.0;
+	double radixMs = 0.0;
+	for (UINT run = 0; run < runs; ++run)
+	{
+		Clock::time_point start = Clock::now();
+		for (UINT i = 0; i < count; ++i)
+		{
+			pairs[i] = std::make_pair(keys[i], i);
+		}
+		std::sort(pairs.begin(), pairs.end());
+		for (UINT i = 0; i < count; ++i)
+		{
+			indices[i] = pairs[i].second;
+		}
+		stdSortMs += ElapsedMs(start, Clock::now());
+
+		sorter.Reset();
+		start = Clock::now();
+		sorter.Sort(keys.data(), count, indices.data());
+		radixMs += ElapsedMs(start, Clock::now());
+	}
+
+	// The camera drifting between frames: every depth moves by a fraction of the average gap
+	// between neighbours, so a few of them swap.
+	float gap = 1000.0f / count;
+	std::uniform_real_distribution<float> drift(-0.02f * gap, 0.02f * gap);
+	double coherentMs = 0.0;
+	UINT reused = 0;
+	UINT refined = 0;
+	for (UINT run = 0; run < runs; ++run)
+	{
+		for (UINT i = 0; i < count; ++i)
+		{
+			depths[i] += drift(rng);
+			keys[i] = GRadixSort::BackToFrontKey(depths[i]);
+		}
+
+		Clock::time_point start = Clock::now();
+		sorter.Sort(keys.data(), count, indices.data());
+		coherentMs += ElapsedMs(start, Clock::now());
+
+		reused += sorter.GetLastPath() == GRadixSort::SORT_REUSED ? 1 : 0;
+		refined += sorter.GetLastPath() == GRadixSort::SORT_REFINED ? 1 : 0;
+	}
+
+	stdSortMs /= runs;
+	radixMs /= runs;
+	coherentMs /= runs;
+
+	wprintf(L"%u keys, %u runs\n", count, runs);
+	wprintf(L"  std::sort        %8.3f ms  %7.1f Mkeys/s\n", stdSortMs, count / (stdSortMs * 1000.0));
+	wprintf(L"  radix            %8.3f ms  %7.1f Mkeys/s  %.2fx\n", radixMs, count / (radixMs * 1000.0), stdSortMs / radixMs);
+	wprintf(L"  coherent resort  %8.3f ms  %7.1f Mkeys/s  %.2fx  (%u reused, %u refined)\n",
+		coherentMs, count / (coherentMs * 1000.0), stdSortMs / coherentMs, reused, refined);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,376 @@
+/*  ===============================================
+	Summary: Shader Cache Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GShaderCache.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const wchar_t* const TestDirectory = L"ShaderCacheTest/";
+	const wchar_t* const BenchDirectory = L"ShaderCacheBench/";
+
+	const char* const MainSource =
+		"#include \"LightHelper.hlsl\"\n"
+		"float4 PS(float4 pos : SV_POSITION) : SV_Target { return Shade(pos); }\n"
+		"float4 VS(float4 pos : POSITION) : SV_POSITION { return pos; }\n";
+
+	const char* const LightSource =
+		"  #  include <Common.hlsl>\n"
+		"#include \"Common.hlsl\"\n"
+		"#include \"Missing.hlsl\"\n"
+		"float4 Shade(float4 pos) { return pos * Ambient; }\n";
+
+	const char* const CommonSource =
+		"#include \"LightHelper.hlsl\"\n"
+		"static const float Ambient = 0.25f;\n";
+
+	// Stands in for D3DCompileFromFile: the bytecode is a hash of everything the real compiler
+	// would see, so two calls return the same bytes exactly when they should.  Sources containing
+	// "error" fail to compile.
+	class StubCompiler
+	{
+	public:
+		StubCompiler() :
+			mCallCount(0)
+		{
+		}
+
+		GShaderCache::CompileFunc GetFunc()
+		{
+			return [this](const wchar_t* filename, const char* entryPoint, const char* target, uint32_t flags,
+				std::vector<uint8_t>& bytecode, std::string& errors)
+			{
+				return Compile(filename, entryPoint, target, flags, bytecode, errors);
+			};
+		}
+
+		inline UINT GetCallCount() const { return mCallCount; }
+
+	private:
+		bool Compile(const wchar_t* filename, const char* entryPoint, const char* target, uint32_t flags,
+			std::vector<uint8_t>& bytecode, std::string& errors)
+		{
+			++mCallCount;
+
+			std::vector<std::wstring> files;
+			if (!GShaderCache::GatherDependencies(filename, files))
+			{
+				errors = "cannot open source";
+				return false;
+			}
+
+			uint64_t hash = GShaderCache::Hash(entryPoint, strlen(entryPoint));
+			hash = GShaderCache::Hash(target, strlen(target), hash);
+			hash = GShaderCache::Hash(&flags, sizeof(flags), hash);
+
+			std::vector<uint8_t> source;
+			for (size_t i = 0; i < files.size(); ++i)
+			{
+				GShaderCache::ReadFile(files[i], source);
+				if (std::string(source.begin(), source.end()).find("error") != std::string::npos)
+				{
+					errors = "stub: error in source";
+					return false;
+				}
+				hash = GShaderCache::Hash(source.data(), source.size(), hash);
+			}
+
+			// Vary the length too, so a truncated entry cannot pass for a shorter shader.
+			bytecode.resize(16 + static_cast<size_t>(hash % 48));
+			for (size_t i = 0; i < bytecode.size(); ++i)
+			{
+				bytecode[i] = static_cast<uint8_t>(hash >> ((i % 8) * 8));
+			}
+			return true;
+		}
+
+	private:
+		std::atomic<UINT> mCallCount;
+	};
+
+	bool WriteSource(const std::wstring& filename, const char* text)
+	{
+		return GShaderCache::WriteFileAtomic(filename, text, strlen(text));
+	}
+
+	UINT CountFiles(const std::wstring& dir, const wchar_t* extension)
+	{
+		std::vector<std::wstring> files;
+		FindFiles(dir, extension, files);
+		return static_cast<UINT>(files.size());
+	}
+
+	// Points a cache at dir's cache folder and the stub.
+	void SetUp(GShaderCache& cache, StubCompiler& stub, const std::wstring& dir)
+	{
+		cache.SetDirectory(dir + L"Cache");
+		cache.SetCompiler(stub.GetFunc());
+	}
+}
+
+void TestShaderCache()
+{
+	std::wstring dir = TestDirectory;
+	ClearDirectory(dir);
+
+	if (!CHECK(MakeDirectory(dir)))
+	{
+		return;
+	}
+
+	std::wstring mainFile = dir + L"Basic.hlsl";
+	std::wstring lightFile = dir + L"LightHelper.hlsl";
+	std::wstring commonFile = dir + L"Common.hlsl";
+
+	CHECK(WriteSource(mainFile, MainSource));
+	CHECK(WriteSource(lightFile, LightSource));
+	CHECK(WriteSource(commonFile, CommonSource));
+
+	// Each file once, in include order, through the cycle, without the missing include.
+	std::vector<std::wstring> files;
+	CHECK(GShaderCache::GatherDependencies(mainFile, files));
+	CHECK(files.size() == 3);
+	CHECK(files.size() == 3 && files[0] == mainFile && files[1] == lightFile && files[2] == commonFile);
+
+	files.clear();
+	CHECK(!GShaderCache::GatherDependencies(dir + L"Missing.hlsl", files));
+	CHECK(files.empty());
+
+	// Every option that changes the bytecode changes the key.
+	const uint32_t debug = GShaderCache::DebugFlags;
+	const uint32_t release = GShaderCache::ReleaseFlags;
+	CHECK(debug != release);
+
+	uint64_t keyPS = 0;
+	uint64_t keyRelease = 0;
+	uint64_t keyVS = 0;
+	uint64_t keyTarget = 0;
+	uint64_t keySplit = 0;
+	CHECK(GShaderCache::MakeKey(mainFile.c_str(), "PS", "ps_5_0", debug, keyPS));
+	CHECK(GShaderCache::MakeKey(mainFile.c_str(), "PS", "ps_5_0", release, keyRelease));
+	CHECK(GShaderCache::MakeKey(mainFile.c_str(), "VS", "ps_5_0", debug, keyVS));
+	CHECK(GShaderCache::MakeKey(mainFile.c_str(), "PS", "ps_4_0", debug, keyTarget));
+	CHECK(GShaderCache::MakeKey(mainFile.c_str(), "PSp", "s_5_0", debug, keySplit));
+	CHECK(keyPS != keyRelease && keyPS != keyVS && keyPS != keyTarget && keyPS != keySplit);
+	CHECK(keyRelease != keyVS && keyRelease != keyTarget && keyVS != keyTarget);
+
+	uint64_t keyAgain = 0;
+	CHECK(GShaderCache::MakeKey(mainFile.c_str(), "PS", "ps_5_0", debug, keyAgain) && keyAgain == keyPS);
+
+	StubCompiler stub;
+	GShaderCache cache;
+	SetUp(cache, stub, dir);
+
+	// A miss compiles and stores; the same load then comes from disk without the compiler.
+	std::vector<uint8_t> compiled;
+	std::vector<uint8_t> loaded;
+	CHECK(cache.Load(mainFile.c_str(), "PS", "ps_5_0", debug, compiled));
+	CHECK(stub.GetCallCount() == 1 && cache.GetMissCount() == 1 && cache.GetHitCount() == 0);
+	CHECK(CountFiles(dir + L"Cache/", L".cso") == 1);
+
+	CHECK(cache.Load(mainFile.c_str(), "PS", "ps_5_0", debug, loaded));
+	CHECK(stub.GetCallCount() == 1 && cache.GetHitCount() == 1);
+	CHECK(loaded == compiled);
+
+	// A new cache over the same folder, as on the next run, hits too.
+	StubCompiler nextStub;
+	GShaderCache next;
+	SetUp(next, nextStub, dir);
+	loaded.clear();
+	CHECK(next.Load(mainFile.c_str(), "PS", "ps_5_0", debug, loaded));
+	CHECK(nextStub.GetCallCount() == 0 && loaded == compiled);
+
+	// Release flags keep their own entry.
+	std::vector<uint8_t> releaseCode;
+	CHECK(cache.Load(mainFile.c_str(), "PS", "ps_5_0", release, releaseCode));
+	CHECK(stub.GetCallCount() == 2 && releaseCode != compiled);
+	CHECK(CountFiles(dir + L"Cache/", L".cso") == 2);
+
+	// Editing a file two includes deep recompiles.
+	CHECK(WriteSource(commonFile, "#include \"LightHelper.hlsl\"\nstatic const float Ambient = 0.5f;\n"));
+	uint64_t keyEdited = 0;
+	CHECK(GShaderCache::MakeKey(mainFile.c_str(), "PS", "ps_5_0", debug, keyEdited) && keyEdited != keyPS);
+
+	std::vector<uint8_t> edited;
+	CHECK(cache.Load(mainFile.c_str(), "PS", "ps_5_0", debug, edited));
+	CHECK(stub.GetCallCount() == 3 && edited != compiled);
+
+	// A damaged entry is ignored and replaced.
+	std::vector<uint8_t> entry;
+	std::wstring entryPath = cache.GetEntryPath(keyEdited);
+	CHECK(GShaderCache::ReadFile(entryPath, entry) && !entry.empty());
+	entry.back() ^= 0xff;
+	CHECK(GShaderCache::WriteFileAtomic(entryPath, entry.data(), entry.size()));
+	loaded.clear();
+	CHECK(cache.Load(mainFile.c_str(), "PS", "ps_5_0", debug, loaded));
+	CHECK(stub.GetCallCount() == 4 && loaded == edited);
+
+	entry.resize(entry.size() / 2);
+	CHECK(GShaderCache::WriteFileAtomic(entryPath, entry.data(), entry.size()));
+	loaded.clear();
+	CHECK(cache.Load(mainFile.c_str(), "PS", "ps_5_0", debug, loaded));
+	CHECK(stub.GetCallCount() == 5 && loaded == edited);
+
+	// A failed compile reports the messages and stores nothing.
+	std::wstring brokenFile = dir + L"Broken.hlsl";
+	CHECK(WriteSource(brokenFile, "float4 PS() : SV_Target { error }\n"));
+
+	UINT entriesBefore = CountFiles(dir + L"Cache/", L".cso");
+	std::string errors;
+	std::vector<uint8_t> broken;
+	CHECK(!cache.Load(brokenFile.c_str(), "PS", "ps_5_0", debug, broken, &errors));
+	CHECK(errors == "stub: error in source");
+	CHECK(CountFiles(dir + L"Cache/", L".cso") == entriesBefore);
+
+	errors.clear();
+	CHECK(!cache.Load((dir + L"Missing.hlsl").c_str(), "PS", "ps_5_0", debug, broken, &errors));
+	CHECK(!errors.empty());
+
+	// Without a compiler a miss fails, but a hit still loads.
+	GShaderCache bare;
+	bare.SetDirectory(dir + L"Cache");
+	bare.SetCompiler(GShaderCache::CompileFunc());
+	errors.clear();
+	CHECK(!bare.Load(mainFile.c_str(), "VS", "vs_5_0", debug, broken, &errors));
+	CHECK(errors == "No shader compiler set.");
+	loaded.clear();
+	CHECK(bare.Load(mainFile.c_str(), "PS", "ps_5_0", debug, loaded) && loaded == edited);
+
+	// Threads racing on one missing entry all get the same bytes and leave one entry behind.
+	const UINT ThreadCount = 8;
+	const UINT LoadsPerThread = 16;
+
+	StubCompiler raceStub;
+	GShaderCache race;
+	SetUp(race, raceStub, dir);
+
+	std::vector<std::vector<uint8_t> > results(ThreadCount * LoadsPerThread);
+	std::atomic<UINT> failures(0);
+	std::vector<std::thread> threads;
+	for (UINT t = 0; t < ThreadCount; ++t)
+	{
+		threads.push_back(std::thread([&, t]()
+		{
+			for (UINT i = 0; i < LoadsPerThread; ++i)
+			{
+				if (!race.Load(mainFile.c_str(), "VS", "vs_5_0", release, results[t * LoadsPerThread + i]))
+				{
+					++failures;
+				}
+			}
+		}));
+	}
+	for (size_t t = 0; t < threads.size(); ++t)
+	{
+		threads[t].join();
+	}
+
+	CHECK(failures == 0);
+	CHECK(race.GetHitCount() + race.GetMissCount() == ThreadCount * LoadsPerThread);
+	CHECK(raceStub.GetCallCount() == race.GetMissCount());
+
+	UINT mismatches = 0;
+	for (size_t i = 1; i < results.size(); ++i)
+	{
+		mismatches += results[i] != results[0] ? 1 : 0;
+	}
+	CHECK(mismatches == 0);
+
+	uint64_t keyRace = 0;
+	CHECK(GShaderCache::MakeKey(mainFile.c_str(), "VS", "vs_5_0", release, keyRace));
+	loaded.clear();
+	CHECK(GShaderCache::ReadFile(race.GetEntryPath(keyRace), loaded) && loaded.size() > results[0].size());
+
+	// No writer, racing or not, leaves a temporary file.
+	CHECK(CountFiles(dir, L".tmp") == 0);
+
+	ClearDirectory(dir);
+}
+
+int BenchShaderCache(int argc, wchar_t* argv[])
+{
+	UINT runs = GetOption(argc, argv, L"runs", 5);
+
+	std::wstring root = FindRepoRoot();
+	if (root.empty())
+	{
+		wprintf(L"DX11Renderer.sln not found above the working directory.\n");
+		return 1;
+	}
+
+	// The demos' shaders, so scanning includes and hashing see real sizes.
+	std::vector<std::wstring> shaders;
+	FindFiles(root, L".hlsl", shaders);
+	if (shaders.empty())
+	{
+		wprintf(L"No shaders found below %ls.\n", root.c_str());
+		return 1;
+	}
+
+	std::wstring dir = BenchDirectory;
+	ClearDirectory(dir);
+	if (!MakeDirectory(dir))
+	{
+		wprintf(L"Cannot create %ls.\n", dir.c_str());
+		return 1;
+	}
+
+	double keyMs = 0.0;
+	double missMs = 0.0;
+	double hitMs = 0.0;
+	UINT failures = 0;
+
+	std::vector<uint8_t> bytecode;
+	for (UINT run = 0; run < runs; ++run)
+	{
+		StubCompiler stub;
+		GShaderCache cache;
+		SetUp(cache, stub, dir);
+
+		Clock::time_point start = Clock::now();
+		for (size_t i = 0; i < shaders.size(); ++i)
+		{
+			uint64_t key = 0;
+			failures += GShaderCache::MakeKey(shaders[i].c_str(), "main", "ps_5_0", GShaderCache::ReleaseFlags, key) ? 0 : 1;
+		}
+		Clock::time_point keyed = Clock::now();
+
+		for (size_t i = 0; i < shaders.size(); ++i)
+		{
+			failures += cache.Load(shaders[i].c_str(), "main", "ps_5_0", GShaderCache::ReleaseFlags, bytecode) ? 0 : 1;
+		}
+		Clock::time_point missed = Clock::now();
+
+		for (size_t i = 0; i < shaders.size(); ++i)
+		{
+			failures += cache.Load(shaders[i].c_str(), "main", "ps_5_0", GShaderCache::ReleaseFlags, bytecode) ? 0 : 1;
+		}
+		Clock::time_point hit = Clock::now();
+
+		keyMs += ElapsedMs(start, keyed);
+		missMs += ElapsedMs(keyed, missed);
+		hitMs += ElapsedMs(missed, hit);
+
+		ClearDirectory(dir);
+		MakeDirectory(dir);
+	}
+
+	ClearDirectory(dir);
+
+	double perShader = 1.0 / (static_cast<double>(runs) * shaders.size());
+	wprintf(L"%u shaders, %u runs, stub compiler\n", static_cast<UINT>(shaders.size()), runs);
+	wprintf(L"  key:  %.4f ms per shader\n", keyMs * perShader);
+	wprintf(L"  miss: %.4f ms per shader (key, stub compile, store)\n", missMs * perShader);
+	wprintf(L"  hit:  %.4f ms per shader (key, read, verify)\n", hitMs * perShader);
+	wprintf(L"  failures: %u\n", failures);
+
+	return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
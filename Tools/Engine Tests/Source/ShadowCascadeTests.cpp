@@ -0,0 +1,257 @@
+/*  ===============================================
+	Summary: Shadow Cascade Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GShadowCascades.h"
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	const float FovY = 0.25f * XM_PI;
+	const float Aspect = 1.333f;
+	const float NearZ = 1.0f;
+	const float FarZ = 1000.0f;
+	const UINT ShadowMapSize = 2048;
+
+	// A ground slab and a pillar on it, lit from above at an angle.
+	const XMFLOAT3 LightDir(0.57735f, -0.57735f, 0.57735f);
+
+	void BuildScene(std::vector<BoundingBox>& casters)
+	{
+		casters.clear();
+		casters.push_back(BoundingBox(XMFLOAT3(0.0f, -0.1f, 0.0f), XMFLOAT3(10.0f, 0.1f, 15.0f)));
+		casters.push_back(BoundingBox(XMFLOAT3(0.0f, 5.0f, 0.0f), XMFLOAT3(1.0f, 5.0f, 1.0f)));
+	}
+
+	// A camera walking forward and turning slowly, one step per frame.
+	XMFLOAT4X4 CameraView(UINT frame)
+	{
+		float yaw = 0.02f * frame;
+		XMVECTOR eye = XMVectorSet(0.0048f * frame, 2.0f, -15.0f + 0.0171f * frame, 1.0f);
+		XMVECTOR look = XMVectorSet(sinf(yaw), -0.1f, cosf(yaw), 0.0f);
+
+		XMFLOAT4X4 view;
+		XMStoreFloat4x4(&view, XMMatrixLookToLH(eye, look, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+		return view;
+	}
+
+	void Update(GShadowCascades& cascades, const XMFLOAT4X4& view, const std::vector<BoundingBox>& casters)
+	{
+		cascades.Update(view, FovY, Aspect, NearZ, FarZ, LightDir, casters.data(), static_cast<UINT>(casters.size()));
+	}
+
+	XMFLOAT3 ToShadowMap(const GShadowCascades::Cascade& cascade, FXMVECTOR p)
+	{
+		XMFLOAT3 q;
+		XMStoreFloat3(&q, XMVector3TransformCoord(p, XMLoadFloat4x4(&cascade.ShadowTransform)));
+		return q;
+	}
+
+	// Every point of a cascade's frustum slice must land inside its shadow map and depth range.
+	UINT CountUncovered(const GShadowCascades& cascades, const XMFLOAT4X4& view, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		XMMATRIX invView = XMMatrixInverse(nullptr, XMLoadFloat4x4(&view));
+		float tanHalfFov = tanf(0.5f * FovY);
+
+		UINT uncovered = 0;
+		for (UINT c = 0; c < cascades.GetCascadeCount(); ++c)
+		{
+			const GShadowCascades::Cascade& cascade = cascades.GetCascade(c);
+
+			for (UINT i = 0; i < 200; ++i)
+			{
+				float z = cascade.SplitNear + (cascade.SplitFar - cascade.SplitNear) * unit(rng);
+				float x = (2.0f * unit(rng) - 1.0f) * z * tanHalfFov * Aspect;
+				float y = (2.0f * unit(rng) - 1.0f) * z * tanHalfFov;
+
+				XMFLOAT3 q = ToShadowMap(cascade, XMVector3TransformCoord(XMVectorSet(x, y, z, 1.0f), invView));
+				if (q.x < 0.0f || q.x > 1.0f || q.y < 0.0f || q.y > 1.0f || q.z > 1.0f)
+				{
+					++uncovered;
+				}
+			}
+		}
+
+		return uncovered;
+	}
+}
+
+void TestShadowCascades()
+{
+	// Splits run from near to far, and lambda blends uniform into logarithmic.
+	float splits[GShadowCascades::MaxCascades + 1];
+	GShadowCascades::ComputeSplits(1.0f, 60.0f, 4, 0.75f, splits);
+	CHECK(splits[0] == 1.0f && splits[4] == 60.0f);
+	for (UINT i = 0; i < 4; ++i)
+	{
+		CHECK(splits[i] < splits[i + 1]);
+	}
+
+	GShadowCascades::ComputeSplits(1.0f, 81.0f, 4, 0.0f, splits);
+	CHECK(fabsf(splits[1] - 21.0f) < 1e-3f && fabsf(splits[2] - 41.0f) < 1e-3f);
+
+	GShadowCascades::ComputeSplits(1.0f, 81.0f, 4, 1.0f, splits);
+	CHECK(fabsf(splits[1] - 3.0f) < 1e-3f && fabsf(splits[2] - 9.0f) < 1e-3f && fabsf(splits[3] - 27.0f) < 1e-2f);
+
+	std::vector<BoundingBox> casters;
+	BuildScene(casters);
+
+	std::mt19937 rng(3);
+
+	for (UINT mode = 0; mode < 2; ++mode)
+	{
+		bool bStabilize = mode == 0;
+
+		GShadowCascades cascades;
+		cascades.SetCascadeCount(4);
+		cascades.SetResolution(ShadowMapSize);
+		cascades.SetShadowDistance(60.0f);
+		cascades.SetStabilize(bStabilize);
+
+		double phase[GShadowCascades::MaxCascades][2];
+		double maxPhaseDrift = 0.0;
+		UINT uncovered = 0;
+		UINT clipped = 0;
+
+		for (UINT frame = 0; frame < 50; ++frame)
+		{
+			XMFLOAT4X4 view = CameraView(frame);
+			Update(cascades, view, casters);
+
+			CHECK(cascades.GetCascadeCount() == 4);
+			CHECK(cascades.GetCascade(3).SplitFar == 60.0f);
+
+			uncovered += CountUncovered(cascades, view, rng);
+
+			for (UINT c = 0; c < cascades.GetCascadeCount(); ++c)
+			{
+				const GShadowCascades::Cascade& cascade = cascades.GetCascade(c);
+
+				// The top of the pillar is the caster nearest the light; it must not be clipped away.
+				XMFLOAT3 top = ToShadowMap(cascade, XMVectorSet(0.0f, 10.0f, 0.0f, 1.0f));
+				if (top.x >= 0.0f && top.x <= 1.0f && top.y >= 0.0f && top.y <= 1.0f && top.z < -1e-4f)
+				{
+					++clipped;
+				}
+
+				// Snapped cascades keep the world origin at the same sub-texel position.
+				XMFLOAT3 origin = ToShadowMap(cascade, XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f));
+				double fx = origin.x * ShadowMapSize - floor(origin.x * ShadowMapSize);
+				double fy = origin.y * ShadowMapSize - floor(origin.y * ShadowMapSize);
+
+				if (frame > 0)
+				{
+					double dx = fabs(fx - phase[c][0]);
+					double dy = fabs(fy - phase[c][1]);
+					maxPhaseDrift = (std::max)(maxPhaseDrift, (std::max)((std::min)(dx, 1.0 - dx), (std::min)(dy, 1.0 - dy)));
+				}
+
+				phase[c][0] = fx;
+				phase[c][1] = fy;
+			}
+		}
+
+		CHECK(uncovered == 0);
+		CHECK(clipped == 0);
+
+		if (bStabilize)
+		{
+			CHECK(maxPhaseDrift < 1e-3);
+		}
+	}
+
+	// Small camera moves leave stabilized cascades untouched most frames, and the caster masks
+	// follow which cascades a caster can reach.
+	{
+		GShadowCascades cascades;
+		cascades.SetShadowDistance(60.0f);
+
+		casters[1] = BoundingBox(XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f));
+
+		// Far off to the side, outside every cascade.
+		casters.push_back(BoundingBox(XMFLOAT3(500.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+
+		GShadowCascades::Cascade previous[GShadowCascades::MaxCascades];
+		UINT changes = 0;
+
+		for (UINT frame = 0; frame < 400; ++frame)
+		{
+			XMFLOAT4X4 view;
+			XMStoreFloat4x4(&view, XMMatrixLookToLH(XMVectorSet(0.0005f * frame, 2.0f, -15.0f, 1.0f),
+				XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+			Update(cascades, view, casters);
+
+			for (UINT c = 0; c < cascades.GetCascadeCount(); ++c)
+			{
+				const GShadowCascades::Cascade& cascade = cascades.GetCascade(c);
+				if (frame > 0 && memcmp(&previous[c].ShadowTransform, &cascade.ShadowTransform, sizeof(XMFLOAT4X4)) != 0)
+				{
+					++changes;
+				}
+				previous[c] = cascade;
+			}
+		}
+
+		CHECK(changes < 400 * cascades.GetCascadeCount() / 10);
+
+		for (UINT c = 0; c < cascades.GetCascadeCount(); ++c)
+		{
+			CHECK(cascades.CastsInto(c, 0));
+			CHECK(!cascades.CastsInto(c, 2));
+		}
+	}
+}
+
+int BenchShadowCascades(int argc, wchar_t* argv[])
+{
+	UINT casterCount = GetOption(argc, argv, L"casters", 1000);
+	UINT frames = (std::max)(GetOption(argc, argv, L"frames", 2000), 1u);
+
+	// Boxes scattered over a 200 m square around the camera path.
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> extent(0.2f, 3.0f);
+
+	std::vector<BoundingBox> casters;
+	BuildScene(casters);
+	for (UINT i = 0; i < casterCount; ++i)
+	{
+		float height = extent(rng);
+		casters.push_back(BoundingBox(XMFLOAT3(position(rng), height, position(rng)), XMFLOAT3(extent(rng), height, extent(rng))));
+	}
+
+	wprintf(L"%u casters, %u frames\n", static_cast<UINT>(casters.size()), frames);
+
+	for (UINT mode = 0; mode < 2; ++mode)
+	{
+		GShadowCascades cascades;
+		cascades.SetShadowDistance(60.0f);
+		cascades.SetStabilize(mode == 0);
+
+		UINT casts = 0;
+
+		Clock::time_point start = Clock::now();
+		for (UINT frame = 0; frame < frames; ++frame)
+		{
+			Update(cascades, CameraView(frame % 500), casters);
+			casts += cascades.CastsInto(0, frame % casters.size()) ? 1 : 0;
+		}
+		double ms = ElapsedMs(start, Clock::now());
+
+		wprintf(L"  %-11ls %8.2f us per update  (%u sampled casters in cascade 0)\n", mode == 0 ? L"stabilized" : L"tight", 1000.0 * ms / frames, casts);
+	}
+
+	return 0;
+}
\ No newline at end of file
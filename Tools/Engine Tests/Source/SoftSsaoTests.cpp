@@ -0,0 +1,437 @@
+/*  ===============================================
+	Summary: CPU SSAO Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GSoftSsao.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// The Ambient Occlusion demo's lens.
+	const float FovY = 0.25f * 3.1415926535f;
+	const float NearZ = 1.0f;
+	const float FarZ = 1000.0f;
+
+	// samNormalDepth's border.
+	const XMFLOAT4 Border(0.0f, 0.0f, 0.0f, 1e5f);
+
+	struct Camera
+	{
+		XMFLOAT4X4 Proj;
+		float TanHalfX;
+		float TanHalfY;
+	};
+
+	Camera MakeCamera(UINT width, UINT height)
+	{
+		float aspect = static_cast<float>(width) / height;
+
+		Camera camera;
+		XMStoreFloat4x4(&camera.Proj, XMMatrixPerspectiveFovLH(FovY, aspect, NearZ, FarZ));
+		camera.TanHalfY = tanf(0.5f * FovY);
+		camera.TanHalfX = aspect * camera.TanHalfY;
+		return camera;
+	}
+
+	//
+	// A straight port of SSAOPS.hlsl, one pixel and one sample at a time.
+	//
+
+	// MIN_MAG_LINEAR with BORDER addressing.
+	XMFLOAT4 ReferenceSampleBorder(const std::vector<XMFLOAT4>& texels, UINT width, UINT height, float u, float v)
+	{
+		// Anything this far out only touches border texels; clamping keeps the casts defined.
+		float x = (std::min)((std::max)(u * width - 0.5f, -2.0f), width + 1.0f);
+		float y = (std::min)((std::max)(v * height - 0.5f, -2.0f), height + 1.0f);
+		float x0 = floorf(x);
+		float y0 = floorf(y);
+		float s = x - x0;
+		float t = y - y0;
+
+		XMFLOAT4 taps[4];
+		for (int j = 0; j < 2; ++j)
+		{
+			for (int i = 0; i < 2; ++i)
+			{
+				int tx = static_cast<int>(x0) + i;
+				int ty = static_cast<int>(y0) + j;
+				bool bInside = tx >= 0 && ty >= 0 && tx < static_cast<int>(width) && ty < static_cast<int>(height);
+				taps[2 * j + i] = bInside ? texels[ty * width + tx] : Border;
+			}
+		}
+
+		const float* t00 = &taps[0].x;
+		const float* t10 = &taps[1].x;
+		const float* t01 = &taps[2].x;
+		const float* t11 = &taps[3].x;
+
+		float result[4];
+		for (int c = 0; c < 4; ++c)
+		{
+			float top = t00[c] + (t10[c] - t00[c]) * s;
+			float bottom = t01[c] + (t11[c] - t01[c]) * s;
+			result[c] = top + (bottom - top) * t;
+		}
+		return XMFLOAT4(result[0], result[1], result[2], result[3]);
+	}
+
+	// MIN_MAG_LINEAR with WRAP addressing, rgb decoded to [0, 1].
+	void ReferenceSampleWrap(const std::vector<uint8_t>& rgba, float u, float v, float rgb[3])
+	{
+		const int size = static_cast<int>(GSoftSsao::RandomVectorMapSize);
+		float x = u * size - 0.5f;
+		float y = v * size - 0.5f;
+		float x0 = floorf(x);
+		float y0 = floorf(y);
+		float s = x - x0;
+		float t = y - y0;
+
+		int tx[2], ty[2];
+		for (int i = 0; i < 2; ++i)
+		{
+			tx[i] = ((static_cast<int>(x0) + i) % size + size) % size;
+			ty[i] = ((static_cast<int>(y0) + i) % size + size) % size;
+		}
+
+		for (int c = 0; c < 3; ++c)
+		{
+			float t00 = rgba[(ty[0] * size + tx[0]) * 4 + c] / 255.0f;
+			float t10 = rgba[(ty[0] * size + tx[1]) * 4 + c] / 255.0f;
+			float t01 = rgba[(ty[1] * size + tx[0]) * 4 + c] / 255.0f;
+			float t11 = rgba[(ty[1] * size + tx[1]) * 4 + c] / 255.0f;
+			float top = t00 + (t10 - t00) * s;
+			float bottom = t01 + (t11 - t01) * s;
+			rgb[c] = top + (bottom - top) * t;
+		}
+	}
+
+	float ReferenceAccess(const std::vector<XMFLOAT4>& normalDepth, UINT width, UINT height, const Camera& camera,
+		const XMFLOAT4 offsets[GSoftSsao::NumOffsets], const std::vector<uint8_t>& randomVectors, float u, float v)
+	{
+		XMFLOAT4 center = ReferenceSampleBorder(normalDepth, width, height, u, v);
+		XMVECTOR n = XMVectorSet(center.x, center.y, center.z, 0.0f);
+		float pz = center.w;
+
+		// The vertex shader's far plane corner, interpolated across the full-screen quad.
+		XMVECTOR toFarPlane = XMVectorSet((2.0f * u - 1.0f) * camera.TanHalfX * FarZ, (1.0f - 2.0f * v) * camera.TanHalfY * FarZ, FarZ, 0.0f);
+		XMVECTOR p = XMVectorScale(toFarPlane, pz / FarZ);
+
+		float rgb[3];
+		ReferenceSampleWrap(randomVectors, 4.0f * u, 4.0f * v, rgb);
+		XMVECTOR randVec = XMVectorSet(2.0f * rgb[0] - 1.0f, 2.0f * rgb[1] - 1.0f, 2.0f * rgb[2] - 1.0f, 0.0f);
+
+		XMMATRIX proj = XMLoadFloat4x4(&camera.Proj);
+
+		float occlusionSum = 0.0f;
+		for (UINT i = 0; i < GSoftSsao::NumOffsets; ++i)
+		{
+			XMVECTOR offset = XMVector3Reflect(XMLoadFloat4(&offsets[i]), randVec);
+
+			float facing = XMVectorGetX(XMVector3Dot(offset, n));
+			float flip = facing > 0.0f ? 1.0f : (facing < 0.0f ? -1.0f : 0.0f);
+
+			XMVECTOR q = XMVectorAdd(p, XMVectorScale(offset, 0.5f * flip));
+
+			// Projected to NDC, then to texture space.
+			XMFLOAT4 clip;
+			XMStoreFloat4(&clip, XMVector4Transform(XMVectorSetW(q, 1.0f), proj));
+			float texU = 0.5f * clip.x / clip.w + 0.5f;
+			float texV = -0.5f * clip.y / clip.w + 0.5f;
+
+			float rz = ReferenceSampleBorder(normalDepth, width, height, texU, texV).w;
+			XMVECTOR r = XMVectorScale(q, rz / XMVectorGetZ(q));
+
+			float distZ = pz - XMVectorGetZ(r);
+			if (distZ > 0.05f)
+			{
+				float dp = (std::max)(XMVectorGetX(XMVector3Dot(n, XMVector3Normalize(XMVectorSubtract(r, p)))), 0.0f);
+				float fade = (std::min)((std::max)((2.0f - distZ) / (2.0f - 0.2f), 0.0f), 1.0f);
+				occlusionSum += fade * dp;
+			}
+		}
+
+		float access = 1.0f - occlusionSum / GSoftSsao::NumOffsets;
+		return (std::min)((std::max)(powf(access, 4.0f), 0.0f), 1.0f);
+	}
+
+	void ReferenceCompute(const std::vector<XMFLOAT4>& normalDepth, UINT width, UINT height, const Camera& camera,
+		const XMFLOAT4 offsets[GSoftSsao::NumOffsets], const std::vector<uint8_t>& randomVectors, bool bHalfResolution,
+		std::vector<float>& ambientMap)
+	{
+		UINT mapWidth = bHalfResolution ? (std::max)(width / 2, 1u) : width;
+		UINT mapHeight = bHalfResolution ? (std::max)(height / 2, 1u) : height;
+
+		ambientMap.resize(mapWidth * mapHeight);
+		for (UINT y = 0; y < mapHeight; ++y)
+		{
+			for (UINT x = 0; x < mapWidth; ++x)
+			{
+				float u = (x + 0.5f) / mapWidth;
+				float v = (y + 0.5f) / mapHeight;
+				ambientMap[y * mapWidth + x] = ReferenceAccess(normalDepth, width, height, camera, offsets, randomVectors, u, v);
+			}
+		}
+	}
+
+	//
+	// A ray-cast view-space scene with creases for the samples to find: a floor, a wall behind
+	// it that fills the rest of the view, and spheres resting on both.  Nothing is missed, so
+	// no pixel blends a surface with the far clear depth, where float rounding alone decides
+	// the range check.
+	//
+
+	struct Sphere
+	{
+		float X, Y, Z, Radius;
+	};
+
+	const float FloorY = -1.5f;
+	const float WallZ = 10.0f;
+
+	const Sphere Spheres[] =
+	{
+		{ 0.0f, -0.5f, 6.0f, 1.0f },
+		{ -2.0f, -0.9f, 5.0f, 0.6f },
+		{ 1.8f, -0.7f, 4.5f, 0.8f },
+		{ 1.0f, 0.5f, 9.5f, 0.5f },
+		{ -1.5f, -0.6f, 9.1f, 0.9f },
+	};
+
+	void RenderNormalDepth(UINT width, UINT height, const Camera& camera, std::vector<XMFLOAT4>& normalDepth)
+	{
+		normalDepth.resize(width * height);
+		for (UINT y = 0; y < height; ++y)
+		{
+			for (UINT x = 0; x < width; ++x)
+			{
+				float u = (x + 0.5f) / width;
+				float v = (y + 0.5f) / height;
+				XMVECTOR dir = XMVectorSet((2.0f * u - 1.0f) * camera.TanHalfX, (1.0f - 2.0f * v) * camera.TanHalfY, 1.0f, 0.0f);
+
+				float nearest = WallZ;
+				XMVECTOR normal = XMVectorSet(0.0f, 0.0f, -1.0f, 0.0f);
+
+				float dirY = XMVectorGetY(dir);
+				if (dirY < 0.0f && FloorY / dirY < nearest)
+				{
+					nearest = FloorY / dirY;
+					normal = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+				}
+
+				for (size_t i = 0; i < sizeof(Spheres) / sizeof(Spheres[0]); ++i)
+				{
+					XMVECTOR c = XMVectorSet(Spheres[i].X, Spheres[i].Y, Spheres[i].Z, 0.0f);
+					float a = XMVectorGetX(XMVector3Dot(dir, dir));
+					float b = XMVectorGetX(XMVector3Dot(dir, c));
+					float d = b * b - a * (XMVectorGetX(XMVector3Dot(c, c)) - Spheres[i].Radius * Spheres[i].Radius);
+					if (d < 0.0f)
+					{
+						continue;
+					}
+
+					float t = (b - sqrtf(d)) / a;
+					if (t > 0.0f && t < nearest)
+					{
+						nearest = t;
+						normal = XMVector3Normalize(XMVectorSubtract(XMVectorScale(dir, t), c));
+					}
+				}
+
+				// dir.z is 1, so the hit distance along dir is the view-space depth.
+				XMFLOAT3 n;
+				XMStoreFloat3(&n, normal);
+				normalDepth[y * width + x] = XMFLOAT4(n.x, n.y, n.z, nearest);
+			}
+		}
+	}
+}
+
+void TestSoftSsao()
+{
+	// The offsets: seven opposite pairs of nonzero vectors, each between 0.25 and 1 long.
+	XMFLOAT4 offsets[GSoftSsao::NumOffsets];
+	GSoftSsao::BuildOffsetVectors(7, offsets);
+	{
+		UINT badLengths = 0;
+		UINT unpaired = 0;
+		for (UINT i = 0; i < GSoftSsao::NumOffsets; ++i)
+		{
+			float length = XMVectorGetX(XMVector3Length(XMLoadFloat4(&offsets[i])));
+			badLengths += length >= 0.25f && length <= 1.0f ? 0 : 1;
+
+			if ((i % 2) == 0)
+			{
+				XMVECTOR a = XMVector3Normalize(XMLoadFloat4(&offsets[i]));
+				XMVECTOR b = XMVector3Normalize(XMLoadFloat4(&offsets[i + 1]));
+				unpaired += XMVectorGetX(XMVector3Dot(a, b)) < -0.9999f ? 0 : 1;
+			}
+		}
+		CHECK(badLengths == 0 && unpaired == 0);
+
+		XMFLOAT4 again[GSoftSsao::NumOffsets];
+		XMFLOAT4 other[GSoftSsao::NumOffsets];
+		GSoftSsao::BuildOffsetVectors(7, again);
+		GSoftSsao::BuildOffsetVectors(8, other);
+		CHECK(memcmp(offsets, again, sizeof(offsets)) == 0);
+		CHECK(memcmp(offsets, other, sizeof(offsets)) != 0);
+	}
+
+	std::vector<uint8_t> randomVectors;
+	GSoftSsao::BuildRandomVectors(7, randomVectors);
+	{
+		CHECK(randomVectors.size() == GSoftSsao::RandomVectorMapSize * GSoftSsao::RandomVectorMapSize * 4);
+
+		UINT alpha = 0;
+		for (size_t i = 3; i < randomVectors.size(); i += 4)
+		{
+			alpha += randomVectors[i];
+		}
+		CHECK(alpha == 0);
+
+		std::vector<uint8_t> again;
+		GSoftSsao::BuildRandomVectors(7, again);
+		CHECK(again == randomVectors);
+	}
+
+	GSoftSsao ssao;
+	ssao.SetOffsetVectors(offsets);
+	ssao.SetRandomVectors(randomVectors.data());
+
+	// Source sizes whose maps, at full and half resolution, end on every lane of the
+	// four-wide loop, down to a single pixel.
+	const UINT Sizes[][2] = { { 1, 1 }, { 2, 3 }, { 3, 2 }, { 4, 4 }, { 5, 7 }, { 6, 5 }, { 7, 3 }, { 9, 6 },
+		{ 13, 11 }, { 37, 23 }, { 64, 36 }, { 75, 41 }, { 161, 97 } };
+
+	UINT sizeMismatches = 0;
+	UINT rerunMismatches = 0;
+	UINT pixels = 0;
+	UINT outliers = 0;
+	UINT occluded = 0;
+	double sumDiff = 0.0;
+	double worstDiff = 0.0;
+
+	for (size_t s = 0; s < sizeof(Sizes) / sizeof(Sizes[0]); ++s)
+	{
+		const UINT width = Sizes[s][0];
+		const UINT height = Sizes[s][1];
+		Camera camera = MakeCamera(width, height);
+
+		std::vector<XMFLOAT4> normalDepth;
+		RenderNormalDepth(width, height, camera, normalDepth);
+
+		for (int half = 0; half < 2; ++half)
+		{
+			std::vector<float> map, again, expected;
+			ssao.Compute(normalDepth.data(), width, height, XMLoadFloat4x4(&camera.Proj), FarZ, half != 0, map);
+			ReferenceCompute(normalDepth, width, height, camera, offsets, randomVectors, half != 0, expected);
+
+			UINT mapWidth = half ? (std::max)(width / 2, 1u) : width;
+			UINT mapHeight = half ? (std::max)(height / 2, 1u) : height;
+			sizeMismatches += ssao.GetMapWidth() == mapWidth && ssao.GetMapHeight() == mapHeight && map.size() == expected.size() ? 0 : 1;
+			if (map.size() != expected.size())
+			{
+				continue;
+			}
+
+			// Rows go to whichever thread is free; the map must not depend on it.
+			ssao.Compute(normalDepth.data(), width, height, XMLoadFloat4x4(&camera.Proj), FarZ, half != 0, again);
+			rerunMismatches += again == map ? 0 : 1;
+
+			for (size_t i = 0; i < map.size(); ++i)
+			{
+				double diff = fabs(static_cast<double>(map[i]) - expected[i]);
+				sumDiff += diff;
+				worstDiff = (std::max)(worstDiff, diff);
+				outliers += diff <= 1e-4 ? 0 : 1;
+				occluded += expected[i] < 0.9f ? 1 : 0;
+			}
+			pixels += static_cast<UINT>(map.size());
+		}
+	}
+
+	CHECK(sizeMismatches == 0);
+	CHECK(rerunMismatches == 0);
+
+	// The scene has to have something to find.
+	CHECK(occluded > pixels / 20);
+
+	// Float rounding can move a sample across the 0.05 range check, which changes that pixel
+	// by up to a fourteenth; allow it for one pixel in a thousand.
+	if (!CHECK(outliers <= pixels / 1000 && sumDiff / pixels < 1e-6))
+	{
+		fwprintf(stderr, L"  %u of %u pixels differ by more than 1e-4, mean %g, worst %g\n", outliers, pixels, sumDiff / pixels, worstDiff);
+	}
+
+	// A wall square to the camera hides nothing from itself: every pixel is fully lit.
+	{
+		const UINT Width = 23;
+		const UINT Height = 10;
+		Camera camera = MakeCamera(Width, Height);
+		std::vector<XMFLOAT4> wall(Width * Height, XMFLOAT4(0.0f, 0.0f, -1.0f, 8.0f));
+
+		std::vector<float> map;
+		ssao.Compute(wall.data(), Width, Height, XMLoadFloat4x4(&camera.Proj), FarZ, false, map);
+		CHECK(std::count(map.begin(), map.end(), 1.0f) == static_cast<ptrdiff_t>(map.size()));
+	}
+}
+
+int BenchSoftSsao(int argc, wchar_t* argv[])
+{
+	UINT width = GetOption(argc, argv, L"width", 1280);
+	UINT height = GetOption(argc, argv, L"height", 720);
+	UINT runs = GetOption(argc, argv, L"runs", 5);
+
+	if (width == 0 || height == 0 || runs == 0)
+	{
+		wprintf(L"-width, -height and -runs must be positive.\n");
+		return 1;
+	}
+
+	Camera camera = MakeCamera(width, height);
+	std::vector<XMFLOAT4> normalDepth;
+	RenderNormalDepth(width, height, camera, normalDepth);
+
+	XMFLOAT4 offsets[GSoftSsao::NumOffsets];
+	std::vector<uint8_t> randomVectors;
+	GSoftSsao::BuildOffsetVectors(0, offsets);
+	GSoftSsao::BuildRandomVectors(0, randomVectors);
+
+	GSoftSsao ssao;
+	ssao.SetOffsetVectors(offsets);
+	ssao.SetRandomVectors(randomVectors.data());
+
+	wprintf(L"%ux%u normal/depth, best of %u runs (SSE2 on the thread pool vs one pixel at a time)\n", width, height, runs);
+
+	for (int half = 0; half < 2; ++half)
+	{
+		std::vector<float> map;
+		double best = DBL_MAX;
+		double bestReference = DBL_MAX;
+
+		for (UINT run = 0; run < runs; ++run)
+		{
+			Clock::time_point t0 = Clock::now();
+			ssao.Compute(normalDepth.data(), width, height, XMLoadFloat4x4(&camera.Proj), FarZ, half != 0, map);
+			Clock::time_point t1 = Clock::now();
+			ReferenceCompute(normalDepth, width, height, camera, offsets, randomVectors, half != 0, map);
+			Clock::time_point t2 = Clock::now();
+
+			best = (std::min)(best, ElapsedMs(t0, t1));
+			bestReference = (std::min)(bestReference, ElapsedMs(t1, t2));
+		}
+
+		double megapixels = ssao.GetMapWidth() * ssao.GetMapHeight() / 1e6;
+		wprintf(L"  %s resolution: %.2f ms (%.1f MP/s) vs %.2f ms (%.1f MP/s)\n", half ? L"half" : L"full",
+			best, megapixels / (best / 1000.0), bestReference, megapixels / (bestReference / 1000.0));
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,243 @@
+/*  ===============================================
+	Summary: Spatial Hash Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GParticleCollider.h"
+#include "GParticleSystem.h"
+#include "GSpatialHash.h"
+
+#include <DirectXCollision.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	std::vector<UINT> BruteForceNeighbors(const std::vector<XMFLOAT3>& points, const XMFLOAT3& pos, float radius)
+	{
+		std::vector<UINT> result;
+		for (UINT i = 0; i < points.size(); ++i)
+		{
+			float dx = points[i].x - pos.x;
+			float dy = points[i].y - pos.y;
+			float dz = points[i].z - pos.z;
+
+			if (dx*dx + dy*dy + dz*dz <= radius * radius)
+			{
+				result.push_back(i);
+			}
+		}
+		return result;
+	}
+
+	bool Overlaps(const BoundingBox& a, const BoundingBox& b)
+	{
+		return fabsf(a.Center.x - b.Center.x) <= a.Extents.x + b.Extents.x &&
+			fabsf(a.Center.y - b.Center.y) <= a.Extents.y + b.Extents.y &&
+			fabsf(a.Center.z - b.Center.z) <= a.Extents.z + b.Extents.z;
+	}
+
+	// Particles spread evenly through the volume, all alive and at rest.
+	void SpawnParticles(GParticleSystem& particles, UINT count, const XMFLOAT3& size, std::mt19937& rng)
+	{
+		particles.Init(count, 1000.0f, static_cast<float>(count));
+		particles.SetSpeed(0.0f, 0.0f);
+		particles.Update(1.0f);
+
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		XMFLOAT3* positions = particles.GetPositions();
+		XMFLOAT3* velocities = particles.GetVelocities();
+
+		for (UINT i = 0; i < count; ++i)
+		{
+			positions[i] = XMFLOAT3(unit(rng) * size.x, unit(rng) * size.y, unit(rng) * size.z);
+			velocities[i] = XMFLOAT3(0.0f, -1.0f, 0.0f);
+		}
+	}
+
+	void AddColliders(GParticleCollider& collider, UINT count, const XMFLOAT3& size, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::uniform_real_distribution<float> extent(0.5f, 2.0f);
+
+		collider.ClearColliders();
+		for (UINT i = 0; i < count; ++i)
+		{
+			XMFLOAT3 center(unit(rng) * size.x, unit(rng) * size.y, unit(rng) * size.z);
+			if (i % 2 == 0)
+			{
+				collider.AddSphere(BoundingSphere(center, extent(rng)));
+			}
+			else
+			{
+				collider.AddBox(BoundingBox(center, XMFLOAT3(extent(rng), extent(rng), extent(rng))));
+			}
+		}
+		collider.AddPlane(XMFLOAT4(0.0f, 1.0f, 0.0f, 0.0f));
+	}
+
+	double TimeCollide(GParticleCollider& collider, GParticleSystem& particles, const std::vector<XMFLOAT3>& start, UINT runs)
+	{
+		double totalMs = 0.0;
+		for (UINT run = 0; run < runs; ++run)
+		{
+			std::copy(start.begin(), start.end(), particles.GetPositions());
+
+			Clock::time_point begin = Clock::now();
+			collider.Collide(particles);
+			totalMs += ElapsedMs(begin, Clock::now());
+		}
+		return totalMs / runs;
+	}
+}
+
+void TestSpatialHash()
+{
+	std::mt19937 rng(27);
+	std::uniform_real_distribution<float> coord(0.0f, 20.0f);
+
+	std::vector<XMFLOAT3> points(20000);
+	for (size_t i = 0; i < points.size(); ++i)
+	{
+		points[i] = XMFLOAT3(coord(rng), coord(rng), coord(rng));
+	}
+
+	// A small table makes many cells share a bucket.
+	GSpatialHash hash;
+	hash.Init(1.0f, 1024);
+	hash.BuildPoints(points.data(), static_cast<UINT>(points.size()));
+	CHECK(hash.GetEntryCount() == points.size());
+
+	// Radii from inside one cell to far more cells than a query keeps on the stack.
+	const float radii[] = { 0.3f, 1.5f, 2.5f, 6.0f };
+	for (size_t r = 0; r < sizeof(radii) / sizeof(radii[0]); ++r)
+	{
+		for (int q = 0; q < 8; ++q)
+		{
+			XMFLOAT3 pos(coord(rng), coord(rng), coord(rng));
+
+			std::vector<UINT> found;
+			hash.QueryNeighbors(pos, radii[r], points.data(), found);
+			std::sort(found.begin(), found.end());
+
+			CHECK(std::adjacent_find(found.begin(), found.end()) == found.end());
+			CHECK(found == BruteForceNeighbors(points, pos, radii[r]));
+		}
+	}
+
+	std::vector<BoundingBox> boxes(500);
+	for (size_t i = 0; i < boxes.size(); ++i)
+	{
+		boxes[i] = BoundingBox(XMFLOAT3(coord(rng), coord(rng), coord(rng)), XMFLOAT3(0.1f + coord(rng) * 0.1f, 0.5f, 0.1f + coord(rng) * 0.05f));
+	}
+	hash.BuildBounds(boxes.data(), static_cast<UINT>(boxes.size()));
+
+	for (int q = 0; q < 16; ++q)
+	{
+		BoundingBox query(XMFLOAT3(coord(rng), coord(rng), coord(rng)), XMFLOAT3(1.5f, 1.5f, 1.5f));
+
+		std::vector<UINT> found;
+		hash.QueryBounds(query, found);
+		CHECK(std::adjacent_find(found.begin(), found.end()) == found.end());
+
+		// Candidates may include boxes from shared buckets, but never miss an overlapping one.
+		for (UINT i = 0; i < boxes.size(); ++i)
+		{
+			if (Overlaps(query, boxes[i]))
+			{
+				CHECK(std::binary_search(found.begin(), found.end(), i));
+			}
+		}
+	}
+
+	// One particle in each of a sphere, a box and under the ground, and one in the open.
+	GParticleSystem particles;
+	particles.Init(4, 1000.0f, 4.0f);
+	particles.Update(1.0f);
+	CHECK(particles.GetAliveCount() == 4);
+
+	XMFLOAT3* positions = particles.GetPositions();
+	XMFLOAT3* velocities = particles.GetVelocities();
+	for (UINT i = 0; i < 4; ++i)
+	{
+		velocities[i] = XMFLOAT3(0.0f, -2.0f, 0.0f);
+	}
+	positions[0] = XMFLOAT3(0.0f, 5.9f, 0.0f);
+	positions[1] = XMFLOAT3(10.0f, 5.8f, 10.0f);
+	positions[2] = XMFLOAT3(-10.0f, -0.25f, 3.0f);
+	positions[3] = XMFLOAT3(-10.0f, 4.0f, -10.0f);
+
+	GParticleCollider collider;
+	collider.Init(1.0f, 4);
+	collider.SetResponse(0.5f, 0.0f);
+	collider.AddSphere(BoundingSphere(XMFLOAT3(0.0f, 5.0f, 0.0f), 1.0f));
+	collider.AddBox(BoundingBox(XMFLOAT3(10.0f, 5.0f, 10.0f), XMFLOAT3(2.0f, 1.0f, 2.0f)));
+	collider.AddPlane(XMFLOAT4(0.0f, 1.0f, 0.0f, 0.0f));
+	collider.Collide(particles);
+
+	CHECK(collider.GetContactCount() == 3);
+	CHECK(fabsf(positions[0].y - 6.0f) < 1e-4f);
+	CHECK(fabsf(positions[1].y - 6.0f) < 1e-4f);
+	CHECK(fabsf(positions[2].y) < 1e-4f);
+	CHECK(positions[3].y == 4.0f);
+
+	for (UINT i = 0; i < 3; ++i)
+	{
+		CHECK(fabsf(velocities[i].y - 1.0f) < 1e-4f);
+	}
+	CHECK(velocities[3].y == -2.0f);
+}
+
+int BenchCollide(int argc, wchar_t* argv[])
+{
+	UINT maxCount = GetOption(argc, argv, L"count", 1000000);
+	UINT numColliders = GetOption(argc, argv, L"colliders", 256);
+	UINT runs = (std::max)(GetOption(argc, argv, L"runs", 10), 1u);
+
+	// A fixed scene: particles get denser as their count grows.
+	const XMFLOAT3 sceneSize(100.0f, 20.0f, 100.0f);
+	const float cellSize = 2.0f;
+
+	wprintf(L"Particles vs %u colliders and a ground plane, %u runs\n", numColliders, runs);
+	wprintf(L"  %10ls  %10ls  %12ls  %10ls\n", L"particles", L"ms", L"ns/particle", L"contacts");
+
+	for (UINT count = (std::max)(maxCount / 8, 1u); count <= maxCount; count *= 2)
+	{
+		std::mt19937 rng(27);
+		GParticleSystem particles;
+		SpawnParticles(particles, count, sceneSize, rng);
+		std::vector<XMFLOAT3> start(particles.GetPositions(), particles.GetPositions() + count);
+
+		GParticleCollider collider;
+		collider.Init(cellSize, count);
+		AddColliders(collider, numColliders, sceneSize, rng);
+
+		double ms = TimeCollide(collider, particles, start, runs);
+		wprintf(L"  %10u  %10.3f  %12.2f  %10u\n", count, ms, ms * 1e6 / count, collider.GetContactCount());
+	}
+
+	// Collider count at the full particle count; a grid keeps the cost per particle nearly flat.
+	wprintf(L"\n%u particles\n", maxCount);
+	wprintf(L"  %10ls  %10ls  %12ls  %10ls\n", L"colliders", L"ms", L"ns/particle", L"contacts");
+
+	std::mt19937 rng(27);
+	GParticleSystem particles;
+	SpawnParticles(particles, maxCount, sceneSize, rng);
+	std::vector<XMFLOAT3> start(particles.GetPositions(), particles.GetPositions() + maxCount);
+
+	for (UINT colliders = (std::max)(numColliders / 4, 1u); colliders <= numColliders * 4; colliders *= 2)
+	{
+		GParticleCollider collider;
+		collider.Init(cellSize, maxCount);
+		AddColliders(collider, colliders, sceneSize, rng);
+
+		double ms = TimeCollide(collider, particles, start, runs);
+		wprintf(L"  %10u  %10.3f  %12.2f  %10u\n", colliders, ms, ms * 1e6 / maxCount, collider.GetContactCount());
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+/*  ===============================================
+	Summary: Static Shadow Cache Tests
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GShadowCascades.h"
+#include "GStaticShadowCache.h"
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	const float FovY = 0.25f * XM_PI;
+	const float Aspect = 1.333f;
+	const float NearZ = 1.0f;
+	const float FarZ = 1000.0f;
+
+	typedef GStaticShadowCache::CascadeUpdate CascadeUpdate;
+
+	bool Equals(const CascadeUpdate& update, bool bRedrawStatic, bool bCopyStatic, bool bDrawDynamic)
+	{
+		return update.bRedrawStatic == bRedrawStatic && update.bCopyStatic == bCopyStatic && update.bDrawDynamic == bDrawDynamic;
+	}
+
+	XMFLOAT4X4 ViewProj(const GShadowCascades::Cascade& cascade)
+	{
+		XMFLOAT4X4 viewProj;
+		XMStoreFloat4x4(&viewProj, XMMatrixMultiply(XMLoadFloat4x4(&cascade.View), XMLoadFloat4x4(&cascade.Proj)));
+		return viewProj;
+	}
+
+	// What a depth buffer holds, as the draws that went into it rather than as pixels.
+	struct StaticContent
+	{
+		XMFLOAT4X4 ViewProj;
+		UINT StaticVersion;
+		bool bDrawn;
+	};
+
+	struct SliceContent
+	{
+		StaticContent Static;
+		int DynamicFrame;
+	};
+
+	bool SameStatic(const StaticContent& a, const XMFLOAT4X4& viewProj, UINT staticVersion)
+	{
+		return a.bDrawn && a.StaticVersion == staticVersion && memcmp(&a.ViewProj, &viewProj, sizeof(viewProj)) == 0;
+	}
+}
+
+void TestStaticShadowCache()
+{
+	// One cascade by hand: the static layer and the slice are only touched when they must be.
+	{
+		GStaticShadowCache cache;
+
+		XMFLOAT4X4 viewProj;
+		XMStoreFloat4x4(&viewProj, XMMatrixScaling(0.1f, 0.1f, 0.02f));
+
+		CHECK(Equals(cache.Update(0, viewProj, false), true, true, false));
+		CHECK(Equals(cache.Update(0, viewProj, false), false, false, false));
+
+		// Dynamic casters are drawn over a fresh copy each frame, and cleared off once they leave.
+		CHECK(Equals(cache.Update(0, viewProj, true), false, true, true));
+		CHECK(Equals(cache.Update(0, viewProj, true), false, true, true));
+		CHECK(Equals(cache.Update(0, viewProj, false), false, true, false));
+		CHECK(Equals(cache.Update(0, viewProj, false), false, false, false));
+
+		// Any change to the matrices, however small, redraws the layer.
+		XMFLOAT4X4 moved = viewProj;
+		moved._41 = nextafterf(moved._41, 1.0f);
+		CHECK(Equals(cache.Update(0, moved, false), true, true, false));
+		CHECK(Equals(cache.Update(0, moved, false), false, false, false));
+
+		// Cascades are cached apart, and Invalidate redraws them all.
+		CHECK(Equals(cache.Update(1, viewProj, false), true, true, false));
+		CHECK(Equals(cache.Update(0, moved, false), false, false, false));
+
+		cache.Invalidate();
+		CHECK(Equals(cache.Update(0, moved, false), true, true, false));
+		CHECK(Equals(cache.Update(1, viewProj, true), true, true, true));
+		CHECK(Equals(cache.Update(GShadowCascades::MaxCascades - 1, viewProj, false), true, true, false));
+	}
+
+	// Driven by real cascades over a walk with a moving dynamic caster, light turns and static
+	// changes: after every frame each slice must hold what drawing it from scratch would give.
+	{
+		GShadowCascades cascades;
+		cascades.SetCascadeCount(GShadowCascades::MaxCascades);
+		cascades.SetShadowDistance(60.0f);
+
+		std::vector<BoundingBox> casters;
+		casters.push_back(BoundingBox(XMFLOAT3(0.0f, -0.1f, 0.0f), XMFLOAT3(30.0f, 0.1f, 60.0f)));
+		casters.push_back(BoundingBox(XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(0.5f, 1.0f, 0.5f)));
+		casters.push_back(BoundingBox());
+
+		const UINT DynamicCaster = 2;
+
+		GStaticShadowCache cache;
+		StaticContent staticLayers[GShadowCascades::MaxCascades] = {};
+		SliceContent slices[GShadowCascades::MaxCascades] = {};
+		UINT staticVersion = 0;
+
+		const UINT Frames = 600;
+		UINT wrong = 0;
+		UINT redraws = 0;
+		UINT copies = 0;
+		UINT dynamicFrames = 0;
+
+		for (UINT frame = 0; frame < Frames; ++frame)
+		{
+			// The light turns twice, briefly; a static caster changes once.
+			float lightTurn = (frame >= 200 && frame < 203) || frame == 450 ? 0.01f * frame : 0.0f;
+			XMFLOAT3 lightDir;
+			XMStoreFloat3(&lightDir, XMVector3Normalize(XMVectorSet(0.57735f + lightTurn, -0.57735f, 0.57735f, 0.0f)));
+
+			if (frame == 300)
+			{
+				cache.Invalidate();
+				++staticVersion;
+			}
+
+			// The dynamic caster sweeps back and forth from beside the camera to far off to the side.
+			float sweep = static_cast<float>(frame % 200) / 100.0f;
+			float x = sweep < 1.0f ? sweep : 2.0f - sweep;
+			casters[DynamicCaster] = BoundingBox(XMFLOAT3(200.0f * x, 1.0f, 20.0f * x), XMFLOAT3(1.0f, 1.0f, 1.0f));
+
+			XMFLOAT4X4 view;
+			XMStoreFloat4x4(&view, XMMatrixLookToLH(XMVectorSet(0.0005f * frame, 2.0f, -15.0f, 1.0f),
+				XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+			cascades.Update(view, FovY, Aspect, NearZ, FarZ, lightDir, casters.data(), static_cast<UINT>(casters.size()));
+
+			for (UINT c = 0; c < cascades.GetCascadeCount(); ++c)
+			{
+				XMFLOAT4X4 viewProj = ViewProj(cascades.GetCascade(c));
+				bool bDynamic = cascades.CastsInto(c, DynamicCaster);
+
+				// Do what the update asks, as the demo does on the GPU.
+				CascadeUpdate update = cache.Update(c, viewProj, bDynamic);
+				if (update.bRedrawStatic)
+				{
+					staticLayers[c].ViewProj = viewProj;
+					staticLayers[c].StaticVersion = staticVersion;
+					staticLayers[c].bDrawn = true;
+					++redraws;
+				}
+				if (update.bCopyStatic)
+				{
+					slices[c].Static = staticLayers[c];
+					slices[c].DynamicFrame = -1;
+					++copies;
+				}
+				if (update.bDrawDynamic)
+				{
+					slices[c].DynamicFrame = static_cast<int>(frame);
+				}
+
+				bool bRight = SameStatic(slices[c].Static, viewProj, staticVersion) &&
+					slices[c].DynamicFrame == (bDynamic ? static_cast<int>(frame) : -1);
+				if (!CHECK(bRight) && ++wrong <= 5)
+				{
+					fwprintf(stderr, L"  frame %u, cascade %u: slice holds stale shadows\n", frame, c);
+				}
+
+				dynamicFrames += bDynamic ? 1 : 0;
+			}
+		}
+
+		// The walk crosses a texel now and then, and the caster only reaches some cascades some of
+		// the time, so most of the work is skipped.
+		UINT cascadeFrames = Frames * cascades.GetCascadeCount();
+		CHECK(dynamicFrames > cascadeFrames / 10 && dynamicFrames < cascadeFrames * 9 / 10);
+		CHECK(redraws < cascadeFrames / 10);
+		CHECK(copies < dynamicFrames + cascadeFrames / 10);
+	}
+}
\ No newline at end of file
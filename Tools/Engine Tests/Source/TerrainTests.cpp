@@ -0,0 +1,418 @@
+/*  ===============================================
+	Summary: Terrain Tests and Benchmarks
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GTerrainBounds.h"
+#include "GTerrainQuery.h"
+#include "MathHelper.h"
+
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// Same layout as the Chapter 19 demo: 32 x 32 patches centred on the origin, row 0 at +z.
+	const UINT PatchesPerSide = 32;
+	const UINT CellsPerPatch = 32;
+	const UINT MapSamples = PatchesPerSide * CellsPerPatch + 1;
+	const float CellSize = 1.0f;
+
+	struct Heightmap
+	{
+		std::vector<float> Heights;
+		UINT Width;
+		UINT Depth;
+	};
+
+	// Rolling hills with a ridge, so patch bounds differ a lot across the map.
+	void BuildHills(Heightmap& map, UINT width, UINT depth)
+	{
+		map.Width = width;
+		map.Depth = depth;
+		map.Heights.resize(width * depth);
+
+		for (UINT z = 0; z < depth; ++z)
+		{
+			for (UINT x = 0; x < width; ++x)
+			{
+				float fx = static_cast<float>(x);
+				float fz = static_cast<float>(z);
+				map.Heights[z * width + x] = 30.0f * sinf(0.011f * fx) * cosf(0.017f * fz) +
+					8.0f * sinf(0.07f * fx + 0.05f * fz) + 60.0f * expf(-fabsf(fx - fz) * 0.01f);
+			}
+		}
+	}
+
+	inline XMFLOAT3 SampleToWorld(const Heightmap& map, UINT x, UINT z)
+	{
+		float halfWidth = 0.5f * (map.Width - 1) * CellSize;
+		float halfDepth = 0.5f * (map.Depth - 1) * CellSize;
+		return XMFLOAT3(-halfWidth + x * CellSize, map.Heights[z * map.Width + x], halfDepth - z * CellSize);
+	}
+
+	bool IsInside(const XMFLOAT4 planes[6], const XMFLOAT3& p)
+	{
+		for (UINT i = 0; i < 6; ++i)
+		{
+			if (planes[i].x * p.x + planes[i].y * p.y + planes[i].z * p.z + planes[i].w < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// The demo's CullPatches test: a patch box is culled when it lies behind any one plane.
+	bool IsPatchVisible(const XMFLOAT4 planes[6], const Heightmap& map, const XMFLOAT2& boundsY, UINT row, UINT col)
+	{
+		float halfWidth = 0.5f * (map.Width - 1) * CellSize;
+		float halfDepth = 0.5f * (map.Depth - 1) * CellSize;
+		float patchSize = CellsPerPatch * CellSize;
+
+		XMFLOAT3 center(-halfWidth + (col + 0.5f) * patchSize, 0.5f * (boundsY.x + boundsY.y), halfDepth - (row + 0.5f) * patchSize);
+		XMFLOAT3 extents(0.5f * patchSize, 0.5f * (boundsY.y - boundsY.x), 0.5f * patchSize);
+
+		for (UINT p = 0; p < 6; ++p)
+		{
+			float r = fabsf(planes[p].x) * extents.x + fabsf(planes[p].y) * extents.y + fabsf(planes[p].z) * extents.z;
+			float s = planes[p].x * center.x + planes[p].y * center.y + planes[p].z * center.z + planes[p].w;
+
+			if (s + r < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	struct Waypoint
+	{
+		XMFLOAT3 Position;
+		XMFLOAT3 Look;
+	};
+
+	// Walks around the middle of the map at eye height, then looks down from above it.
+	std::vector<Waypoint> BuildCameraPath(const Heightmap& map)
+	{
+		std::vector<Waypoint> path;
+		const UINT steps = 16;
+		for (UINT i = 0; i < steps; ++i)
+		{
+			float angle = XM_2PI * i / steps;
+
+			UINT x = static_cast<UINT>(map.Width / 2 + 200.0f * cosf(angle));
+			UINT z = static_cast<UINT>(map.Depth / 2 + 200.0f * sinf(angle));
+			XMFLOAT3 p = SampleToWorld(map, x, z);
+
+			Waypoint waypoint;
+			waypoint.Position = XMFLOAT3(p.x, p.y + 2.0f, p.z);
+			waypoint.Look = XMFLOAT3(-sinf(angle), -0.1f, -cosf(angle));
+			path.push_back(waypoint);
+		}
+
+		Waypoint overview;
+		overview.Position = XMFLOAT3(0.0f, 400.0f, -300.0f);
+		overview.Look = XMFLOAT3(0.0f, -1.0f, 0.8f);
+		path.push_back(overview);
+		return path;
+	}
+
+	void GetFrustumPlanes(const Waypoint& waypoint, XMFLOAT4 planes[6])
+	{
+		XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&waypoint.Position), XMVector3Normalize(XMLoadFloat3(&waypoint.Look)), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 1.0f, 1000.0f);
+		MathHelper::ExtractFrustumPlanes(planes, XMMatrixMultiply(view, proj));
+	}
+
+	void BuildPatchBounds(const GTerrainBounds& bounds, std::vector<XMFLOAT2>& patchBoundsY)
+	{
+		patchBoundsY.resize(PatchesPerSide * PatchesPerSide);
+		for (UINT i = 0; i < PatchesPerSide; ++i)
+		{
+			for (UINT j = 0; j < PatchesPerSide; ++j)
+			{
+				patchBoundsY[i * PatchesPerSide + j] = bounds.GetBounds(
+					j * CellsPerPatch, i * CellsPerPatch, (j + 1) * CellsPerPatch, (i + 1) * CellsPerPatch);
+			}
+		}
+	}
+}
+
+void TestTerrainBounds()
+{
+	Heightmap map;
+	BuildHills(map, 301, 257);
+
+	GTerrainBounds bounds;
+	bounds.Build(map.Heights.data(), map.Width, map.Depth, 8);
+	CHECK(bounds.GetLevelCount() > 1);
+	CHECK(bounds.GetLevelWidth(bounds.GetLevelCount() - 1) == 1);
+	CHECK(bounds.GetLevelDepth(bounds.GetLevelCount() - 1) == 1);
+
+	// Any range is conservative; ranges on leaf boundaries are exact.
+	std::mt19937 rng(29);
+	for (int q = 0; q < 200; ++q)
+	{
+		bool bAligned = (q % 2 == 0);
+		UINT step = bAligned ? 8 : 1;
+		UINT cellsX = (map.Width - 1) / step;
+		UINT cellsZ = (map.Depth - 1) / step;
+
+		UINT x0 = static_cast<UINT>(rng() % cellsX) * step;
+		UINT z0 = static_cast<UINT>(rng() % cellsZ) * step;
+		UINT x1 = (std::min)(x0 + static_cast<UINT>(1 + rng() % 12) * step, map.Width - 1);
+		UINT z1 = (std::min)(z0 + static_cast<UINT>(1 + rng() % 12) * step, map.Depth - 1);
+
+		float minHeight = FLT_MAX;
+		float maxHeight = -FLT_MAX;
+		for (UINT z = z0; z <= z1; ++z)
+		{
+			for (UINT x = x0; x <= x1; ++x)
+			{
+				minHeight = (std::min)(minHeight, map.Heights[z * map.Width + x]);
+				maxHeight = (std::max)(maxHeight, map.Heights[z * map.Width + x]);
+			}
+		}
+
+		XMFLOAT2 result = bounds.GetBounds(x0, z0, x1, z1);
+		CHECK(result.x <= minHeight && result.y >= maxHeight);
+
+		bool bOnLeaves = bAligned && (x1 % 8 == 0 || x1 == map.Width - 1) && (z1 % 8 == 0 || z1 == map.Depth - 1);
+		if (bOnLeaves)
+		{
+			CHECK(result.x == minHeight && result.y == maxHeight);
+		}
+	}
+
+	// Along the camera path, culling never drops a patch with a sample inside the frustum.
+	BuildHills(map, MapSamples, MapSamples);
+	bounds.Build(map.Heights.data(), map.Width, map.Depth);
+
+	std::vector<XMFLOAT2> patchBoundsY;
+	BuildPatchBounds(bounds, patchBoundsY);
+
+	std::vector<Waypoint> path = BuildCameraPath(map);
+	for (size_t w = 0; w < path.size(); ++w)
+	{
+		XMFLOAT4 planes[6];
+		GetFrustumPlanes(path[w], planes);
+
+		for (UINT i = 0; i < PatchesPerSide; ++i)
+		{
+			for (UINT j = 0; j < PatchesPerSide; ++j)
+			{
+				if (IsPatchVisible(planes, map, patchBoundsY[i * PatchesPerSide + j], i, j))
+				{
+					continue;
+				}
+
+				bool bSampleInside = false;
+				for (UINT z = i * CellsPerPatch; z <= (i + 1) * CellsPerPatch && !bSampleInside; z += 2)
+				{
+					for (UINT x = j * CellsPerPatch; x <= (j + 1) * CellsPerPatch && !bSampleInside; x += 2)
+					{
+						bSampleInside = IsInside(planes, SampleToWorld(map, x, z));
+					}
+				}
+				CHECK(!bSampleInside);
+			}
+		}
+	}
+}
+
+int BenchTerrainCull(int argc, wchar_t* argv[])
+{
+	UINT runs = (std::max)(GetOption(argc, argv, L"runs", 100), 1u);
+
+	Heightmap map;
+	BuildHills(map, MapSamples, MapSamples);
+
+	Clock::time_point start = Clock::now();
+	GTerrainBounds bounds;
+	bounds.Build(map.Heights.data(), map.Width, map.Depth);
+
+	std::vector<XMFLOAT2> patchBoundsY;
+	BuildPatchBounds(bounds, patchBoundsY);
+	double buildMs = ElapsedMs(start, Clock::now());
+
+	wprintf(L"%u x %u samples, %u x %u patches; bounds built in %.3f ms\n", map.Width, map.Depth, PatchesPerSide, PatchesPerSide, buildMs);
+	wprintf(L"  %8ls  %10ls  %6ls  %10ls\n", L"waypoint", L"visible", L"ranges", L"cull us");
+
+	std::vector<Waypoint> path = BuildCameraPath(map);
+	UINT totalVisible = 0;
+
+	for (size_t w = 0; w < path.size(); ++w)
+	{
+		XMFLOAT4 planes[6];
+		GetFrustumPlanes(path[w], planes);
+
+		UINT numVisible = 0;
+		UINT numRuns = 0;
+		start = Clock::now();
+		for (UINT run = 0; run < runs; ++run)
+		{
+			// Count visible patches and the contiguous index ranges the demo would draw.
+			numVisible = 0;
+			numRuns = 0;
+			bool bPrevVisible = false;
+			for (UINT patch = 0; patch < PatchesPerSide * PatchesPerSide; ++patch)
+			{
+				bool bVisible = IsPatchVisible(planes, map, patchBoundsY[patch], patch / PatchesPerSide, patch % PatchesPerSide);
+				numVisible += bVisible ? 1 : 0;
+				numRuns += (bVisible && !bPrevVisible) ? 1 : 0;
+				bPrevVisible = bVisible;
+			}
+		}
+		double cullUs = ElapsedMs(start, Clock::now()) * 1000.0 / runs;
+
+		totalVisible += numVisible;
+		wprintf(L"  %8u  %9.1f%%  %6u  %10.2f\n", static_cast<UINT>(w), 100.0 * numVisible / (PatchesPerSide * PatchesPerSide), numRuns, cullUs);
+	}
+
+	wprintf(L"Average visible: %.1f%%\n", 100.0 * totalVisible / (path.size() * PatchesPerSide * PatchesPerSide));
+	return 0;
+}
+
+void TestTerrainQuery()
+{
+	Heightmap map;
+	BuildHills(map, 257, 193);
+
+	const float spacing = 0.5f;
+	GTerrainQuery query;
+	query.Init(map.Heights.data(), map.Width, map.Depth, spacing);
+
+	// Exact on samples: sample (x, z) sits at (-halfWidth + x * spacing, halfDepth - z * spacing).
+	float halfWidth = 0.5f * (map.Width - 1) * spacing;
+	float halfDepth = 0.5f * (map.Depth - 1) * spacing;
+	CHECK(query.GetHeight(-halfWidth, halfDepth) == map.Heights[0]);
+	CHECK(query.GetHeight(halfWidth, -halfDepth) == map.Heights.back());
+	CHECK(fabsf(query.GetHeight(-halfWidth + 10 * spacing, halfDepth - 7 * spacing) - map.Heights[7 * map.Width + 10]) < 1e-4f);
+
+	// Off the map clamps to the edge.
+	CHECK(query.GetHeight(-halfWidth - 100.0f, halfDepth + 100.0f) == map.Heights[0]);
+
+	// A plane tilted along x has the same normal everywhere.
+	Heightmap ramp;
+	ramp.Width = 16;
+	ramp.Depth = 16;
+	ramp.Heights.resize(16 * 16);
+	for (UINT i = 0; i < ramp.Heights.size(); ++i)
+	{
+		ramp.Heights[i] = static_cast<float>(i % 16) * spacing;
+	}
+	GTerrainQuery rampQuery;
+	rampQuery.Init(ramp.Heights.data(), ramp.Width, ramp.Depth, spacing);
+
+	XMFLOAT3 n = rampQuery.GetNormal(0.3f, -1.1f);
+	CHECK(fabsf(n.x + sqrtf(0.5f)) < 1e-5f && fabsf(n.y - sqrtf(0.5f)) < 1e-5f && fabsf(n.z) < 1e-5f);
+
+	// Batches match the single point queries, including the remainder and points off the map.
+	std::mt19937 rng(30);
+	std::uniform_real_distribution<float> coordX(-halfWidth - 5.0f, halfWidth + 5.0f);
+	std::uniform_real_distribution<float> coordZ(-halfDepth - 5.0f, halfDepth + 5.0f);
+
+	const UINT count = 1027;
+	std::vector<float> x(count), z(count), y(count), nx(count), ny(count), nz(count);
+	for (UINT i = 0; i < count; ++i)
+	{
+		x[i] = coordX(rng);
+		z[i] = coordZ(rng);
+	}
+
+	query.GetHeights(x.data(), z.data(), y.data(), count);
+	query.GetNormals(x.data(), z.data(), nx.data(), ny.data(), nz.data(), count);
+
+	for (UINT i = 0; i < count; ++i)
+	{
+		CHECK(fabsf(y[i] - query.GetHeight(x[i], z[i])) < 1e-4f);
+
+		XMFLOAT3 expected = query.GetNormal(x[i], z[i]);
+		CHECK(fabsf(nx[i] - expected.x) < 1e-5f && fabsf(ny[i] - expected.y) < 1e-5f && fabsf(nz[i] - expected.z) < 1e-5f);
+	}
+}
+
+int BenchTerrainQuery(int argc, wchar_t* argv[])
+{
+	UINT count = (std::max)(GetOption(argc, argv, L"count", 1000000), 1u);
+	UINT size = (std::max)(GetOption(argc, argv, L"size", 2049), 2u);
+	UINT runs = (std::max)(GetOption(argc, argv, L"runs", 20), 1u);
+
+	Heightmap map;
+	BuildHills(map, size, size);
+
+	const float spacing = 0.5f;
+	GTerrainQuery query;
+	query.Init(map.Heights.data(), map.Width, map.Depth, spacing);
+
+	float halfSize = 0.5f * (size - 1) * spacing;
+	std::mt19937 rng(30);
+	std::uniform_real_distribution<float> anywhere(-halfSize, halfSize);
+	std::uniform_real_distribution<float> nearby(-32.0f, 32.0f);
+
+	// Points spread over the whole map, and points clustered the way agents around the camera are.
+	std::vector<float> spreadX(count), spreadZ(count), nearX(count), nearZ(count);
+	for (UINT i = 0; i < count; ++i)
+	{
+		spreadX[i] = anywhere(rng);
+		spreadZ[i] = anywhere(rng);
+		nearX[i] = nearby(rng);
+		nearZ[i] = nearby(rng);
+	}
+
+	std::vector<float> y(count), nx(count), ny(count), nz(count);
+	const float* pointsX[2] = { spreadX.data(), nearX.data() };
+	const float* pointsZ[2] = { spreadZ.data(), nearZ.data() };
+	const wchar_t* names[2] = { L"spread", L"clustered" };
+
+	wprintf(L"%u x %u map, %u points, %u runs, one thread\n", size, size, count, runs);
+	wprintf(L"  %-10ls  %14ls  %14ls  %14ls\n", L"points", L"GetHeight", L"GetHeights", L"GetNormals");
+
+	float checksum = 0.0f;
+	for (int set = 0; set < 2; ++set)
+	{
+		const float* px = pointsX[set];
+		const float* pz = pointsZ[set];
+
+		Clock::time_point start = Clock::now();
+		for (UINT run = 0; run < runs; ++run)
+		{
+			for (UINT i = 0; i < count; ++i)
+			{
+				y[i] = query.GetHeight(px[i], pz[i]);
+			}
+			checksum += y[run % count];
+		}
+		double scalarMs = ElapsedMs(start, Clock::now()) / runs;
+
+		start = Clock::now();
+		for (UINT run = 0; run < runs; ++run)
+		{
+			query.GetHeights(px, pz, y.data(), count);
+			checksum += y[run % count];
+		}
+		double batchMs = ElapsedMs(start, Clock::now()) / runs;
+
+		start = Clock::now();
+		for (UINT run = 0; run < runs; ++run)
+		{
+			query.GetNormals(px, pz, nx.data(), ny.data(), nz.data(), count);
+			checksum += ny[run % count];
+		}
+		double normalMs = ElapsedMs(start, Clock::now()) / runs;
+
+		wprintf(L"  %-10ls  %10.1f M/s  %10.1f M/s  %10.1f M/s\n", names[set],
+			count / (scalarMs * 1000.0), count / (batchMs * 1000.0), count / (normalMs * 1000.0));
+	}
+
+	// Keeps the compiler from dropping the loops.
+	return checksum == 12345.0f ? 2 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+/*  ===============================================
+	Summary: Texture Cache Tests
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GTextureCache.h"
+#include "DDSTextureLoader.h"
+#include "D3DUtil.h"
+
+#include <cwctype>
+#include <d3d11.h>
+#include <vector>
+
+namespace
+{
+	const UINT FileCount = 5;
+
+	ID3D11Device* CreateNullDevice()
+	{
+		ID3D11Device* device = 0;
+		D3D_FEATURE_LEVEL featureLevel;
+		HRESULT hr = D3D11CreateDevice(0, D3D_DRIVER_TYPE_NULL, 0, 0, 0, 0, D3D11_SDK_VERSION, &device, &featureLevel, 0);
+		return SUCCEEDED(hr) ? device : 0;
+	}
+
+	// The first few repository textures the null device accepts.
+	bool FindLoadableTextures(ID3D11Device* device, std::vector<std::wstring>& files)
+	{
+		std::wstring root = FindRepoRoot();
+		if (root.empty())
+		{
+			return false;
+		}
+
+		std::vector<std::wstring> all;
+		FindFiles(root, L".dds", all);
+
+		for (size_t i = 0; i < all.size() && files.size() < FileCount; ++i)
+		{
+			ID3D11ShaderResourceView* srv = 0;
+			if (SUCCEEDED(DirectX::CreateDDSTextureFromFile(device, all[i].c_str(), nullptr, &srv)))
+			{
+				files.push_back(all[i]);
+			}
+			ReleaseCOM(srv);
+		}
+		return files.size() == FileCount;
+	}
+
+	ULONG GetRefCount(IUnknown* object)
+	{
+		object->AddRef();
+		return object->Release();
+	}
+}
+
+void TestTextureCache()
+{
+	ID3D11Device* device = CreateNullDevice();
+	if (!CHECK(device != 0))
+	{
+		return;
+	}
+
+	std::vector<std::wstring> files;
+	if (!CHECK(FindLoadableTextures(device, files)))
+	{
+		ReleaseCOM(device);
+		return;
+	}
+
+	// Fifty acquires spread over five files create five textures and hand out the same view
+	// for every acquire of a file.
+	{
+		GTextureCache cache;
+		std::vector<ID3D11ShaderResourceView*> first(FileCount, 0);
+
+		UINT failed = 0;
+		UINT unshared = 0;
+		for (UINT i = 0; i < 50; ++i)
+		{
+			UINT file = (i * 3) % FileCount;
+			ID3D11ShaderResourceView* srv = 0;
+			failed += SUCCEEDED(cache.Acquire(device, files[file].c_str(), &srv)) ? 0 : 1;
+
+			if (!first[file])
+			{
+				first[file] = srv;
+				continue;
+			}
+			unshared += srv == first[file] ? 0 : 1;
+			ReleaseCOM(srv);
+		}
+
+		CHECK(failed == 0 && unshared == 0);
+		CHECK(cache.GetTextureCount() == FileCount);
+		CHECK(cache.GetMissCount() == FileCount);
+		CHECK(cache.GetHitCount() == 50 - FileCount);
+		CHECK(cache.GetResidentBytes() > 0);
+
+		// Each view carries the caller's reference and the cache's own.
+		CHECK(GetRefCount(first[0]) == 2);
+
+		// Another spelling of a path names the same texture; other load options do not.
+		std::wstring upper = files[0];
+		for (size_t c = 0; c < upper.size(); ++c)
+		{
+			upper[c] = static_cast<wchar_t>(towupper(upper[c]));
+		}
+		CHECK(GTextureCache::MakeKey(upper.c_str()) == GTextureCache::MakeKey(files[0].c_str()));
+		CHECK(GTextureCache::MakeKey(files[0].c_str(), true) != GTextureCache::MakeKey(files[0].c_str()));
+		CHECK(GTextureCache::MakeKey(files[0].c_str(), false, 512) != GTextureCache::MakeKey(files[0].c_str()));
+
+		// A missing file is a miss that adds nothing.
+		ID3D11ShaderResourceView* missing = 0;
+		CHECK(FAILED(cache.Acquire(device, (files[0] + L".missing").c_str(), &missing)) && missing == 0);
+		CHECK(cache.GetTextureCount() == FileCount && cache.GetMissCount() == FileCount + 1);
+
+		for (UINT i = 0; i < FileCount; ++i)
+		{
+			ReleaseCOM(first[i]);
+		}
+	}
+
+	// Eviction, with sizes set by hand so the budget arithmetic is exact.
+	{
+		std::vector<ID3D11ShaderResourceView*> srvs(FileCount, 0);
+		for (UINT i = 0; i < FileCount; ++i)
+		{
+			DirectX::CreateDDSTextureFromFile(device, files[i].c_str(), nullptr, &srvs[i]);
+		}
+
+		const UINT64 Size = 1000;
+		const wchar_t* const Keys[FileCount] = { L"a", L"b", L"c", L"d", L"e" };
+
+		GTextureCache cache;
+		for (UINT i = 0; i < FileCount; ++i)
+		{
+			cache.Insert(Keys[i], srvs[i], Size);
+		}
+		CHECK(cache.GetResidentBytes() == Size * FileCount);
+
+		// Inserting a key again keeps the first view and its size.
+		cache.Insert(Keys[0], srvs[1], Size);
+		CHECK(cache.GetTextureCount() == FileCount && cache.GetResidentBytes() == Size * FileCount);
+
+		// Only the cache holds "b" to "e" from here on; "a" stays bound to an object.
+		ID3D11ShaderResourceView* viewB = srvs[1];
+		for (UINT i = 1; i < FileCount; ++i)
+		{
+			ReleaseCOM(srvs[i]);
+		}
+
+		// Using "b" makes "c" the least recently used unbound view.
+		ID3D11ShaderResourceView* touched = cache.Find(Keys[1]);
+		CHECK(touched == viewB);
+		ReleaseCOM(touched);
+
+		// Room for four: "a" is the oldest but bound, so "c" goes.
+		cache.SetMemoryBudget(Size * 4);
+		CHECK(cache.GetEvictCount() == 1);
+		CHECK(cache.GetResidentBytes() == Size * 4);
+
+		ID3D11ShaderResourceView* found = cache.Find(Keys[2]);
+		CHECK(found == 0);
+		found = cache.Find(Keys[0]);
+		CHECK(found == srvs[0]);
+		ReleaseCOM(found);
+
+		// Room for two: "d" and "e" go before the recently used "b"; the bound "a" stays.
+		cache.SetMemoryBudget(Size * 2);
+		CHECK(cache.GetEvictCount() == 3);
+		CHECK(cache.GetTextureCount() == 2);
+		found = cache.Find(Keys[1]);
+		CHECK(found != 0);
+		ReleaseCOM(found);
+
+		// No budget at all still keeps the bound view, over budget, until it is released.
+		cache.SetMemoryBudget(0);
+		CHECK(cache.GetTextureCount() == 1 && cache.GetResidentBytes() == Size);
+		CHECK(GetRefCount(srvs[0]) == 2);
+
+		ReleaseCOM(srvs[0]);
+		cache.Trim();
+		CHECK(cache.GetTextureCount() == 0 && cache.GetResidentBytes() == 0);
+		CHECK(cache.GetEvictCount() == 5);
+
+		// The hits and misses of the Find calls above.
+		CHECK(cache.GetHitCount() == 3 && cache.GetMissCount() == 1);
+	}
+
+	ReleaseCOM(device);
+}
\ No newline at end of file
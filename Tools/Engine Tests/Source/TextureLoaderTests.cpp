@@ -0,0 +1,197 @@
+/*  ===============================================
+	Summary: Texture Loader Tests and Benchmark
+	===============================================  */
+
+#include "EngineTests.h"
+#include "GTextureCache.h"
+#include "GTextureLoader.h"
+#include "GThreadPool.h"
+#include "D3DUtil.h"
+
+#include <d3d11.h>
+#include <cstdio>
+#include <future>
+#include <vector>
+
+namespace
+{
+	// The null driver creates resources without a GPU, so loads run anywhere Direct3D 11 does.
+	ID3D11Device* CreateDevice(D3D_DRIVER_TYPE driverType, D3D_FEATURE_LEVEL* featureLevel = 0)
+	{
+		ID3D11Device* device = 0;
+		D3D_FEATURE_LEVEL createdLevel;
+		HRESULT hr = D3D11CreateDevice(0, driverType, 0, 0, 0, 0, D3D11_SDK_VERSION, &device, &createdLevel, 0);
+		if (featureLevel)
+		{
+			*featureLevel = createdLevel;
+		}
+		return SUCCEEDED(hr) ? device : 0;
+	}
+
+	void ReleaseAll(std::vector<ID3D11ShaderResourceView*>& srvs)
+	{
+		for (size_t i = 0; i < srvs.size(); ++i)
+		{
+			ReleaseCOM(srvs[i]);
+		}
+	}
+
+	bool FindTextures(std::vector<std::wstring>& files)
+	{
+		std::wstring root = FindRepoRoot();
+		if (root.empty())
+		{
+			return false;
+		}
+
+		FindFiles(root, L".dds", files);
+		return !files.empty();
+	}
+}
+
+void TestTextureLoader()
+{
+	std::vector<std::wstring> files;
+	if (!CHECK(FindTextures(files)))
+	{
+		return;
+	}
+
+	D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_9_1;
+	ID3D11Device* device = CreateDevice(D3D_DRIVER_TYPE_NULL, &featureLevel);
+	if (!CHECK(device != 0))
+	{
+		fwprintf(stderr, L"The null device needs the Direct3D 11 runtime (Windows 7 SP1 or later).\n");
+		return;
+	}
+
+	// Loading one file at a time is the reference.
+	std::vector<HRESULT> expected(files.size());
+	UINT created = 0;
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		ID3D11ShaderResourceView* srv = 0;
+		expected[i] = DirectX::CreateDDSTextureFromFile(device, files[i].c_str(), nullptr, &srv);
+		created += SUCCEEDED(expected[i]) ? 1 : 0;
+		ReleaseCOM(srv);
+	}
+
+	// Which device and how many textures it took, so a run's log says what was covered.
+	wprintf(L"  null device, feature level %u.%u: %u of %u DDS files created\n",
+		static_cast<UINT>(featureLevel) >> 12, (static_cast<UINT>(featureLevel) >> 8) & 0xf, created, static_cast<UINT>(files.size()));
+
+	{
+		GTextureLoader loader;
+		CHECK(loader.Init(device, 4 * 1024 * 1024, 4));
+
+		// Every file, the first one a second time, and one that does not exist.
+		std::vector<ID3D11ShaderResourceView*> srvs(files.size() + 2, 0);
+		std::vector<ID3D11ShaderResourceView*> placeholders(srvs.size(), 0);
+		std::vector<std::shared_future<HRESULT>> futures(srvs.size());
+
+		for (size_t i = 0; i < srvs.size(); ++i)
+		{
+			std::wstring filename = i < files.size() ? files[i] : i == files.size() ? files[0] : files[0] + L".missing";
+			futures[i] = loader.Load(filename.c_str(), &srvs[i], GTextureLoader::PLACEHOLDER_WHITE);
+			placeholders[i] = srvs[i];
+			CHECK(srvs[i] != 0);
+		}
+
+		// All slots start on the same placeholder.
+		CHECK(placeholders.front() == placeholders.back());
+
+		loader.Flush();
+		CHECK(loader.GetPendingCount() == 0);
+
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			CHECK(futures[i].get() == expected[i]);
+			CHECK(SUCCEEDED(expected[i]) ? srvs[i] != placeholders[i] : srvs[i] == placeholders[i]);
+		}
+
+		size_t shared = files.size();
+		CHECK(futures[shared].get() == expected[0]);
+		CHECK(srvs[shared] == srvs[0]);
+
+		size_t missing = files.size() + 1;
+		CHECK(FAILED(futures[missing].get()));
+		CHECK(srvs[missing] == placeholders[missing]);
+
+		ReleaseAll(srvs);
+	}
+
+	GTextureCache::Get().Clear();
+	ReleaseCOM(device);
+}
+
+int BenchTextureLoad(int argc, wchar_t* argv[])
+{
+	UINT runs = (std::max)(GetOption(argc, argv, L"runs", 5), 1u);
+	bool bHardware = GetOption(argc, argv, L"hardware", 0) != 0;
+
+	std::vector<std::wstring> files;
+	if (!FindTextures(files))
+	{
+		wprintf(L"No .dds files found; run from inside the repository.\n");
+		return 1;
+	}
+
+	ID3D11Device* device = CreateDevice(bHardware ? D3D_DRIVER_TYPE_HARDWARE : D3D_DRIVER_TYPE_NULL);
+	if (!device)
+	{
+		wprintf(L"Could not create a Direct3D 11 device.\n");
+		return 1;
+	}
+
+	std::vector<ID3D11ShaderResourceView*> srvs(files.size(), 0);
+
+	// One untimed pass warms the file system cache, so both paths read from memory.
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		DirectX::CreateDDSTextureFromFile(device, files[i].c_str(), nullptr, &srvs[i]);
+	}
+	ReleaseAll(srvs);
+
+	double syncMs = 0.0;
+	double queueMs = 0.0;
+	double asyncMs = 0.0;
+
+	for (UINT run = 0; run < runs; ++run)
+	{
+		// What every chapter's Init does: load, parse and create each texture in turn.
+		Clock::time_point start = Clock::now();
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			DirectX::CreateDDSTextureFromFile(device, files[i].c_str(), nullptr, &srvs[i]);
+		}
+		syncMs += ElapsedMs(start, Clock::now());
+		ReleaseAll(srvs);
+
+		// Init only queues the files; the first frame can draw with placeholders right away.
+		{
+			GTextureLoader loader;
+			loader.Init(device);
+
+			start = Clock::now();
+			for (size_t i = 0; i < files.size(); ++i)
+			{
+				loader.Load(files[i].c_str(), &srvs[i]);
+			}
+			queueMs += ElapsedMs(start, Clock::now());
+
+			loader.Flush();
+			asyncMs += ElapsedMs(start, Clock::now());
+		}
+
+		ReleaseAll(srvs);
+		GTextureCache::Get().Clear();
+	}
+
+	wprintf(L"%u DDS files on the %ls device, %u runs\n", static_cast<UINT>(files.size()), bHardware ? L"hardware" : L"null", runs);
+	wprintf(L"  synchronous load          %9.2f ms\n", syncMs / runs);
+	wprintf(L"  async: queued (startup)   %9.2f ms\n", queueMs / runs);
+	wprintf(L"  async: all textures ready %9.2f ms  (%u pool threads)\n", asyncMs / runs, GThreadPool::Get().GetThreadCount());
+
+	ReleaseCOM(device);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,159 @@
+/*  ===============================================
+	Summary: Headless Renderer
+	===============================================  */
+
+#include "GDDSWriter.h"
+#include "Scenes.h"
+
+#include <Windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cwchar>
+#include <string>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	void PrintUsage()
+	{
+		wprintf(L"Usage:\n");
+		wprintf(L"  HeadlessRenderer lighting|crate <output.dds> [-data <dir>] [-size <width> <height>] [-frames <n>] [-golden <file.dds>] [-psnr <dB>]\n");
+		wprintf(L"\n");
+		wprintf(L"  -data    folder holding the demo's Models and Textures (default: the demo's folder)\n");
+		wprintf(L"  -frames  renders the frame n times and reports the average time\n");
+		wprintf(L"  -golden  compares the image with a reference and fails below -psnr (default 40 dB)\n");
+	}
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+	if (argc < 3)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	LPCWSTR sceneName = argv[1];
+	LPCWSTR output = argv[2];
+
+	bool bLighting = wcscmp(sceneName, L"lighting") == 0;
+	bool bCrate = wcscmp(sceneName, L"crate") == 0;
+
+	if (!bLighting && !bCrate)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	// Run from the project folder, the demos' data sits two levels up.
+	std::wstring dataDir = bLighting ? L"../../Chapter 07/Lighting/" : L"../../Chapter 08/Texturing/";
+	UINT width = 800;
+	UINT height = 600;
+	UINT frames = 1;
+	LPCWSTR golden = nullptr;
+	double minPSNR = 40.0;
+
+	for (int i = 3; i < argc; ++i)
+	{
+		if (wcscmp(argv[i], L"-data") == 0 && i + 1 < argc)
+		{
+			dataDir = argv[++i];
+			if (!dataDir.empty() && dataDir.back() != L'/' && dataDir.back() != L'\\')
+			{
+				dataDir += L'/';
+			}
+		}
+		else if (wcscmp(argv[i], L"-size") == 0 && i + 2 < argc)
+		{
+			width = static_cast<UINT>(_wtoi(argv[++i]));
+			height = static_cast<UINT>(_wtoi(argv[++i]));
+		}
+		else if (wcscmp(argv[i], L"-frames") == 0 && i + 1 < argc)
+		{
+			frames = (std::max)(1, _wtoi(argv[++i]));
+		}
+		else if (wcscmp(argv[i], L"-golden") == 0 && i + 1 < argc)
+		{
+			golden = argv[++i];
+		}
+		else if (wcscmp(argv[i], L"-psnr") == 0 && i + 1 < argc)
+		{
+			minPSNR = _wtof(argv[++i]);
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if (width == 0 || height == 0)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	Scenes::Scene scene;
+	bool bLoaded = bLighting ? Scenes::BuildLightingScene(dataDir, scene) : Scenes::BuildCrateScene(dataDir, scene);
+	if (!bLoaded)
+	{
+		return 1;
+	}
+
+	GSoftRasterizer rasterizer;
+	rasterizer.Resize(width, height);
+
+	// The first frame warms up the thread pool and the caches, so it is not timed.
+	Scenes::RenderScene(scene, rasterizer);
+
+	double totalTime = 0.0;
+	double drawTime = 0.0;
+	double resolveTime = 0.0;
+
+	for (UINT i = 0; i < frames; ++i)
+	{
+		Clock::time_point start = Clock::now();
+		Scenes::RenderScene(scene, rasterizer);
+		totalTime += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		drawTime += rasterizer.GetDrawTime();
+		resolveTime += rasterizer.GetResolveTime();
+	}
+
+	wprintf(L"%s: %ux%u, %u triangles, %.2f ms/frame (draw %.2f ms, resolve %.2f ms) over %u frames\n",
+		sceneName, width, height, rasterizer.GetTriangleCount(),
+		totalTime / frames, drawTime / frames, resolveTime / frames, frames);
+
+	GDDSWriter::Desc desc;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.Width = width;
+	desc.Height = height;
+	desc.MipLevels = 1;
+	desc.ArraySize = 1;
+	desc.bCubeMap = false;
+
+	const void* subresources[] = { rasterizer.GetColorBuffer() };
+	if (!GDDSWriter::Write(output, desc, subresources))
+	{
+		wprintf(L"Failed to write %s\n", output);
+		return 1;
+	}
+
+	if (golden)
+	{
+		double psnr = Scenes::CompareWithGolden(golden, rasterizer);
+		if (psnr < 0.0)
+		{
+			return 1;
+		}
+
+		bool bPassed = psnr >= minPSNR;
+		wprintf(L"%s against %s: PSNR %.2f dB, %s\n", output, golden, psnr, bPassed ? L"passed" : L"FAILED");
+
+		return bPassed ? 0 : 2;
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,399 @@
+/*  ===============================================
+	Summary: Headless Renderer Scenes
+	===============================================  */
+
+#include "Scenes.h"
+#include "DDSTextureLoader.h"
+#include "GBlockCompressor.h"
+
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using namespace DirectX;
+
+namespace
+{
+	const float Pi = 3.1415926535f;
+
+	// Colors::LightSteelBlue, which both demos clear to.
+	const float ClearColor[4] = { 0.690196097f, 0.768627524f, 0.870588303f, 1.0f };
+
+	// Same vertices and winding as GeometryGenerator::CreateBox.
+	void CreateBox(float width, float height, float depth, Scenes::Mesh& mesh)
+	{
+		float w2 = 0.5f*width;
+		float h2 = 0.5f*height;
+		float d2 = 0.5f*depth;
+
+		const float v[24][8] =
+		{
+			// Front
+			{ -w2, -h2, -d2,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f },
+			{ -w2, +h2, -d2,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f },
+			{ +w2, +h2, -d2,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f },
+			{ +w2, -h2, -d2,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f },
+
+			// Back
+			{ -w2, -h2, +d2,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f },
+			{ +w2, -h2, +d2,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f },
+			{ +w2, +h2, +d2,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f },
+			{ -w2, +h2, +d2,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f },
+
+			// Top
+			{ -w2, +h2, -d2,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f },
+			{ -w2, +h2, +d2,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f },
+			{ +w2, +h2, +d2,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f },
+			{ +w2, +h2, -d2,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f },
+
+			// Bottom
+			{ -w2, -h2, -d2,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f },
+			{ +w2, -h2, -d2,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f },
+			{ +w2, -h2, +d2,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f },
+			{ -w2, -h2, +d2,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f },
+
+			// Left
+			{ -w2, -h2, +d2, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f },
+			{ -w2, +h2, +d2, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f },
+			{ -w2, +h2, -d2, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f },
+			{ -w2, -h2, -d2, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f },
+
+			// Right
+			{ +w2, -h2, -d2,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f },
+			{ +w2, +h2, -d2,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f },
+			{ +w2, +h2, +d2,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f },
+			{ +w2, -h2, +d2,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f },
+		};
+
+		mesh.Vertices.resize(24);
+		for (UINT i = 0; i < 24; ++i)
+		{
+			mesh.Vertices[i].Pos = XMFLOAT3(v[i][0], v[i][1], v[i][2]);
+			mesh.Vertices[i].Normal = XMFLOAT3(v[i][3], v[i][4], v[i][5]);
+			mesh.Vertices[i].Tex = XMFLOAT2(v[i][6], v[i][7]);
+		}
+
+		// Two triangles per face: (0, 1, 2) and (0, 2, 3).
+		mesh.Indices.resize(36);
+		for (UINT face = 0; face < 6; ++face)
+		{
+			UINT* i = &mesh.Indices[6 * face];
+			i[0] = 4 * face; i[1] = 4 * face + 1; i[2] = 4 * face + 2;
+			i[3] = 4 * face; i[4] = 4 * face + 2; i[5] = 4 * face + 3;
+		}
+	}
+
+	// Same vertices and winding as GeometryGenerator::CreateGrid.
+	void CreateGrid(float width, float depth, UINT m, UINT n, Scenes::Mesh& mesh)
+	{
+		float halfWidth = 0.5f*width;
+		float halfDepth = 0.5f*depth;
+
+		float dx = width / (n-1);
+		float dz = depth / (m-1);
+
+		float du = 1.0f / (n-1);
+		float dv = 1.0f / (m-1);
+
+		mesh.Vertices.resize(m*n);
+		for (UINT i = 0; i < m; ++i)
+		{
+			for (UINT j = 0; j < n; ++j)
+			{
+				GSoftRasterizer::Vertex& v = mesh.Vertices[i*n+j];
+				v.Pos = XMFLOAT3(-halfWidth + j*dx, 0.0f, halfDepth - i*dz);
+				v.Normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+				v.Tex = XMFLOAT2(j*du, i*dv);
+			}
+		}
+
+		mesh.Indices.clear();
+		mesh.Indices.reserve((m-1)*(n-1)*6);
+		for (UINT i = 0; i < m-1; ++i)
+		{
+			for (UINT j = 0; j < n-1; ++j)
+			{
+				UINT quad[6] = { i*n+j, i*n+j+1, (i+1)*n+j, (i+1)*n+j, i*n+j+1, (i+1)*n+j+1 };
+				mesh.Indices.insert(mesh.Indices.end(), quad, quad + 6);
+			}
+		}
+	}
+
+	// Reads the demos' text models ("VertexList (pos, normal)" then "TriangleList") as
+	// GObject does, without needing a device.
+	bool LoadModel(const std::wstring& filename, Scenes::Mesh& mesh)
+	{
+		std::ifstream fin(filename.c_str());
+
+		if (!fin) { return false; }
+
+		std::string ignore;
+		UINT vertexCount = 0;
+		UINT triangleCount = 0;
+
+		fin >> ignore >> vertexCount;
+		fin >> ignore >> triangleCount;
+		fin >> ignore >> ignore >> ignore >> ignore;
+
+		mesh.Vertices.resize(vertexCount);
+		for (UINT i = 0; i < vertexCount; ++i)
+		{
+			GSoftRasterizer::Vertex& v = mesh.Vertices[i];
+			fin >> v.Pos.x >> v.Pos.y >> v.Pos.z;
+			fin >> v.Normal.x >> v.Normal.y >> v.Normal.z;
+			v.Tex = XMFLOAT2(0.0f, 0.0f);
+		}
+
+		fin >> ignore >> ignore >> ignore;
+
+		mesh.Indices.resize(3 * triangleCount);
+		for (UINT i = 0; i < 3 * triangleCount; ++i)
+		{
+			fin >> mesh.Indices[i];
+		}
+
+		if (fin.fail())
+		{
+			return false;
+		}
+
+		for (UINT i = 0; i < mesh.Indices.size(); ++i)
+		{
+			if (mesh.Indices[i] >= vertexCount) { return false; }
+		}
+
+		return true;
+	}
+
+	GSoftRasterizer::DrawCall MakeDrawCall(const Scenes::Mesh& mesh, CXMMATRIX world, const Material& mat)
+	{
+		GSoftRasterizer::DrawCall draw;
+		draw.Vertices = mesh.Vertices.data();
+		draw.VertexCount = static_cast<UINT>(mesh.Vertices.size());
+		draw.Indices = mesh.Indices.data();
+		draw.IndexCount = static_cast<UINT>(mesh.Indices.size());
+		draw.Mat = mat;
+		draw.DiffuseMap = nullptr;
+		draw.Address = GSoftRasterizer::ADDRESS_CLAMP;
+		draw.bCullBack = true;
+
+		XMStoreFloat4x4(&draw.World, world);
+		XMStoreFloat4x4(&draw.TexTransform, XMMatrixIdentity());
+
+		return draw;
+	}
+}
+
+namespace Scenes
+{
+	// Chapter 7: a box and the skull on a grid under three directional lights.
+	bool BuildLightingScene(const std::wstring& dataDir, Scene& scene)
+	{
+		if (!LoadModel(dataDir + L"Models/skull.txt", scene.Meshes[2]))
+		{
+			wprintf(L"Cannot load %sModels/skull.txt\n", dataDir.c_str());
+			return false;
+		}
+
+		CreateBox(1.0f, 1.0f, 1.0f, scene.Meshes[0]);
+		CreateGrid(20.0f, 30.0f, 60, 40, scene.Meshes[1]);
+
+		Material boxMat;
+		boxMat.Ambient = XMFLOAT4(0.651f, 0.5f, 0.392f, 1.0f);
+		boxMat.Diffuse = XMFLOAT4(0.651f, 0.5f, 0.392f, 1.0f);
+		boxMat.Specular = XMFLOAT4(0.2f, 0.2f, 0.2f, 16.0f);
+
+		Material gridMat;
+		gridMat.Ambient = XMFLOAT4(0.48f, 0.77f, 0.46f, 1.0f);
+		gridMat.Diffuse = XMFLOAT4(0.48f, 0.77f, 0.46f, 1.0f);
+		gridMat.Specular = XMFLOAT4(0.2f, 0.2f, 0.2f, 16.0f);
+
+		Material skullMat;
+		skullMat.Ambient = XMFLOAT4(0.8f, 0.8f, 0.8f, 1.0f);
+		skullMat.Diffuse = XMFLOAT4(0.8f, 0.8f, 0.8f, 1.0f);
+		skullMat.Specular = XMFLOAT4(0.8f, 0.8f, 0.8f, 16.0f);
+
+		XMMATRIX boxWorld = XMMatrixScaling(3.0f, 1.0f, 3.0f) * XMMatrixTranslation(0.0f, 0.5f, 0.0f);
+		XMMATRIX skullWorld = XMMatrixScaling(0.5f, 0.5f, 0.5f) * XMMatrixTranslation(0.0f, 1.0f, 0.0f);
+
+		// Drawn in the demo's order.
+		scene.Draws.push_back(MakeDrawCall(scene.Meshes[1], XMMatrixIdentity(), gridMat));
+		scene.Draws.push_back(MakeDrawCall(scene.Meshes[0], boxWorld, boxMat));
+		scene.Draws.push_back(MakeDrawCall(scene.Meshes[2], skullWorld, skullMat));
+
+		scene.LightCount = 3;
+
+		scene.Lights[0].Ambient = XMFLOAT4(0.2f, 0.2f, 0.2f, 1.0f);
+		scene.Lights[0].Diffuse = XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f);
+		scene.Lights[0].Specular = XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f);
+		scene.Lights[0].Direction = XMFLOAT3(0.57735f, -0.57735f, 0.57735f);
+
+		scene.Lights[1].Ambient = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+		scene.Lights[1].Diffuse = XMFLOAT4(0.20f, 0.20f, 0.20f, 1.0f);
+		scene.Lights[1].Specular = XMFLOAT4(0.25f, 0.25f, 0.25f, 1.0f);
+		scene.Lights[1].Direction = XMFLOAT3(-0.57735f, -0.57735f, 0.57735f);
+
+		scene.Lights[2].Ambient = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+		scene.Lights[2].Diffuse = XMFLOAT4(0.2f, 0.2f, 0.2f, 1.0f);
+		scene.Lights[2].Specular = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+		scene.Lights[2].Direction = XMFLOAT3(0.0f, -0.707f, -0.707f);
+
+		scene.Theta = 1.5f*Pi;
+		scene.Phi = 0.1f*Pi;
+		scene.Radius = 15.0f;
+
+		return true;
+	}
+
+	// Chapter 8: the textured crate under two directional lights.
+	bool BuildCrateScene(const std::wstring& dataDir, Scene& scene)
+	{
+		std::wstring textureFile = dataDir + L"Textures/WoodCrate02.dds";
+
+		UINT width, height;
+		std::vector<uint8_t> pixels;
+		if (!LoadDDSImage(textureFile, width, height, pixels))
+		{
+			wprintf(L"Cannot load %s\n", textureFile.c_str());
+			return false;
+		}
+
+		scene.DiffuseMap.Create(pixels.data(), width, height, width * 4);
+
+		CreateBox(1.0f, 1.0f, 1.0f, scene.Meshes[0]);
+
+		Material boxMat;
+		boxMat.Ambient = XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f);
+		boxMat.Diffuse = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+		boxMat.Specular = XMFLOAT4(0.6f, 0.6f, 0.6f, 16.0f);
+
+		GSoftRasterizer::DrawCall draw = MakeDrawCall(scene.Meshes[0], XMMatrixIdentity(), boxMat);
+		draw.DiffuseMap = &scene.DiffuseMap;
+		draw.Address = GSoftRasterizer::ADDRESS_CLAMP;
+		scene.Draws.push_back(draw);
+
+		scene.LightCount = 2;
+
+		scene.Lights[0].Ambient = XMFLOAT4(0.3f, 0.3f, 0.3f, 1.0f);
+		scene.Lights[0].Diffuse = XMFLOAT4(0.8f, 0.8f, 0.8f, 1.0f);
+		scene.Lights[0].Specular = XMFLOAT4(0.6f, 0.6f, 0.6f, 16.0f);
+		scene.Lights[0].Direction = XMFLOAT3(0.707f, -0.707f, 0.0f);
+
+		scene.Lights[1].Ambient = XMFLOAT4(0.2f, 0.2f, 0.2f, 1.0f);
+		scene.Lights[1].Diffuse = XMFLOAT4(1.4f, 1.4f, 1.4f, 1.0f);
+		scene.Lights[1].Specular = XMFLOAT4(0.3f, 0.3f, 0.3f, 16.0f);
+		scene.Lights[1].Direction = XMFLOAT3(-0.707f, 0.0f, 0.707f);
+
+		scene.Theta = 1.3f*Pi;
+		scene.Phi = 0.4f*Pi;
+		scene.Radius = 2.5f;
+
+		return true;
+	}
+
+	void RenderScene(const Scene& scene, GSoftRasterizer& rasterizer)
+	{
+		// Orbit camera, as in the demos' UpdateScene.
+		float x = scene.Radius*sinf(scene.Phi)*cosf(scene.Theta);
+		float z = scene.Radius*sinf(scene.Phi)*sinf(scene.Theta);
+		float y = scene.Radius*cosf(scene.Phi);
+
+		XMVECTOR pos = XMVectorSet(x, y, z, 1.0f);
+		XMVECTOR target = XMVectorZero();
+		XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+
+		float aspectRatio = static_cast<float>(rasterizer.GetWidth()) / rasterizer.GetHeight();
+		XMMATRIX V = XMMatrixLookAtLH(pos, target, up);
+		XMMATRIX P = XMMatrixPerspectiveFovLH(0.25f*Pi, aspectRatio, 1.0f, 1000.0f);
+
+		rasterizer.Clear(ClearColor);
+		rasterizer.SetViewProj(V * P);
+		rasterizer.SetEyePosW(XMFLOAT3(x, y, z));
+		rasterizer.SetLights(scene.Lights, scene.LightCount);
+
+		for (size_t i = 0; i < scene.Draws.size(); ++i)
+		{
+			rasterizer.Draw(scene.Draws[i]);
+		}
+
+		rasterizer.Resolve();
+	}
+
+	// Decodes the top level of a DDS file to RGBA8.
+	bool LoadDDSImage(const std::wstring& filename, UINT& width, UINT& height, std::vector<uint8_t>& pixels)
+	{
+		DirectX::DDS_TEXTURE_DATA dds;
+		if (FAILED(DirectX::LoadDDSTextureDataFromFile(filename.c_str(), dds)))
+		{
+			return false;
+		}
+
+		width = static_cast<UINT>(dds.width);
+		height = static_cast<UINT>(dds.height);
+		pixels.resize(static_cast<size_t>(width) * height * 4);
+
+		const D3D11_SUBRESOURCE_DATA& top = dds.initData[0];
+		const uint8_t* src = static_cast<const uint8_t*>(top.pSysMem);
+		UINT rowPitch = width * 4;
+
+		switch (dds.format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			GBlockCompressor::Decompress(GBlockCompressor::FORMAT_BC1, src, width, height, pixels.data(), rowPitch);
+			return true;
+
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			GBlockCompressor::Decompress(GBlockCompressor::FORMAT_BC3, src, width, height, pixels.data(), rowPitch);
+			return true;
+
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			break;
+
+		default:
+			return false;
+		}
+
+		bool bSwapRB = dds.format == DXGI_FORMAT_B8G8R8A8_UNORM || dds.format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+
+		for (UINT y = 0; y < height; ++y)
+		{
+			uint8_t* dest = &pixels[static_cast<size_t>(y) * rowPitch];
+			memcpy(dest, src + static_cast<size_t>(y) * top.SysMemPitch, rowPitch);
+
+			for (UINT x = 0; bSwapRB && x < width; ++x, dest += 4)
+			{
+				std::swap(dest[0], dest[2]);
+			}
+		}
+
+		return true;
+	}
+
+	// Returns the PSNR over RGB, or a negative value if the golden image cannot be compared.
+	double CompareWithGolden(const std::wstring& filename, const GSoftRasterizer& rasterizer)
+	{
+		UINT width, height;
+		std::vector<uint8_t> golden;
+		if (!LoadDDSImage(filename, width, height, golden))
+		{
+			wprintf(L"Cannot load golden image %s\n", filename.c_str());
+			return -1.0;
+		}
+
+		if (width != rasterizer.GetWidth() || height != rasterizer.GetHeight())
+		{
+			wprintf(L"Golden image is %ux%u, rendered image is %ux%u\n", width, height, rasterizer.GetWidth(), rasterizer.GetHeight());
+			return -1.0;
+		}
+
+		return GBlockCompressor::ComputePSNR(rasterizer.GetColorBuffer(), golden.data(), width, height, width * 4);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+/*  ===============================================
+	Summary: Headless Renderer Scenes
+	===============================================  */
+
+#ifndef SCENES_H
+#define SCENES_H
+
+#include "GSoftRasterizer.h"
+#include "LightHelper.h"
+
+#include <string>
+#include <vector>
+
+// The scenes of the lighting and texturing demos, as they appear before the camera is moved.
+// Shared by the Headless Renderer and its golden-image test in Engine Tests.
+namespace Scenes
+{
+	struct Mesh
+	{
+		std::vector<GSoftRasterizer::Vertex> Vertices;
+		std::vector<UINT> Indices;
+	};
+
+	// The draw calls point into Meshes and DiffuseMap, so a scene is filled in place and not copied.
+	struct Scene
+	{
+		Mesh Meshes[3];
+		std::vector<GSoftRasterizer::DrawCall> Draws;
+		GSoftRasterizer::Texture DiffuseMap;
+
+		DirectionalLight Lights[GSoftRasterizer::MaxLights];
+		UINT LightCount;
+
+		float Theta;
+		float Phi;
+		float Radius;
+	};
+
+	// Chapter 7: a box and the skull on a grid under three directional lights.  dataDir holds
+	// Models/skull.txt and ends in a separator.
+	bool BuildLightingScene(const std::wstring& dataDir, Scene& scene);
+
+	// Chapter 8: the textured crate under two directional lights.  dataDir holds
+	// Textures/WoodCrate02.dds and ends in a separator.
+	bool BuildCrateScene(const std::wstring& dataDir, Scene& scene);
+
+	// Clears, draws and resolves one frame from the scene's orbit camera.
+	void RenderScene(const Scene& scene, GSoftRasterizer& rasterizer);
+
+	// Decodes the top level of an RGBA8, BGRA8, BC1 or BC3 DDS file to RGBA8.
+	bool LoadDDSImage(const std::wstring& filename, UINT& width, UINT& height, std::vector<uint8_t>& pixels);
+
+	// Returns the PSNR over RGB, or a negative value if the golden image cannot be compared.
+	double CompareWithGolden(const std::wstring& filename, const GSoftRasterizer& rasterizer);
+}
+
+#endif // SCENES_H
\ No newline at end of file
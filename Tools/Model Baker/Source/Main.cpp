@@ -0,0 +1,190 @@
+/*  ===============================================
+	Summary: Model Baker
+	===============================================  */
+
+#include "GAOBaker.h"
+#include "GMeshBVH.h"
+#include "GModelFile.h"
+#include "GThreadPool.h"
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT DefaultRayCount = 64;
+
+	// Defaults relative to the diagonal of the bounds of everything in the BVH.
+	const float DefaultDistanceScale = 0.25f;
+	const float DefaultBiasScale = 1e-4f;
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	void PrintUsage()
+	{
+		wprintf(L"Usage:\n");
+		wprintf(L"  ModelBaker <input.txt|.bmodel> <output.bmodel> [-rays <n>] [-distance <d>] [-bias <b>] [-occluder <model>]...\n");
+		wprintf(L"\n");
+		wprintf(L"  Bakes per-vertex ambient access into a binary model.\n");
+		wprintf(L"  -rays      rays per vertex (default %u)\n", DefaultRayCount);
+		wprintf(L"  -distance  occluders further than this are ignored (default %g of the scene diagonal)\n", DefaultDistanceScale);
+		wprintf(L"  -bias      offset of ray origins along the normal (default %g of the scene diagonal)\n", DefaultBiasScale);
+		wprintf(L"  -occluder  other geometry that shadows the model, in the same space; may be repeated\n");
+	}
+
+	// Appends a mesh to the occluder soup the BVH is built from.
+	void AppendGeometry(const GModelFile::Mesh& mesh, std::vector<XMFLOAT3>& positions, std::vector<UINT>& indices)
+	{
+		UINT baseVertex = static_cast<UINT>(positions.size());
+		positions.insert(positions.end(), mesh.Positions.begin(), mesh.Positions.end());
+
+		for (size_t i = 0; i < mesh.Indices.size(); ++i)
+		{
+			indices.push_back(baseVertex + mesh.Indices[i]);
+		}
+	}
+
+	float GetDiagonal(const std::vector<XMFLOAT3>& positions)
+	{
+		if (positions.empty())
+		{
+			return 0.0f;
+		}
+
+		XMFLOAT3 minP = positions[0];
+		XMFLOAT3 maxP = positions[0];
+		for (size_t i = 1; i < positions.size(); ++i)
+		{
+			minP = XMFLOAT3((std::min)(minP.x, positions[i].x), (std::min)(minP.y, positions[i].y), (std::min)(minP.z, positions[i].z));
+			maxP = XMFLOAT3((std::max)(maxP.x, positions[i].x), (std::max)(maxP.y, positions[i].y), (std::max)(maxP.z, positions[i].z));
+		}
+
+		float dx = maxP.x - minP.x;
+		float dy = maxP.y - minP.y;
+		float dz = maxP.z - minP.z;
+		return sqrtf(dx * dx + dy * dy + dz * dz);
+	}
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+	if (argc < 3)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	LPCWSTR input = argv[1];
+	LPCWSTR output = argv[2];
+
+	GAOBaker::Desc desc;
+	desc.SampleCount = DefaultRayCount;
+	desc.MaxDistance = 0.0f;
+	desc.Bias = -1.0f;
+
+	std::vector<LPCWSTR> occluders;
+
+	for (int i = 3; i < argc; ++i)
+	{
+		if (wcscmp(argv[i], L"-rays") == 0 && i + 1 < argc)
+		{
+			desc.SampleCount = static_cast<UINT>(_wtoi(argv[++i]));
+		}
+		else if (wcscmp(argv[i], L"-distance") == 0 && i + 1 < argc)
+		{
+			desc.MaxDistance = static_cast<float>(_wtof(argv[++i]));
+		}
+		else if (wcscmp(argv[i], L"-bias") == 0 && i + 1 < argc)
+		{
+			desc.Bias = static_cast<float>(_wtof(argv[++i]));
+		}
+		else if (wcscmp(argv[i], L"-occluder") == 0 && i + 1 < argc)
+		{
+			occluders.push_back(argv[++i]);
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if (desc.SampleCount == 0)
+	{
+		wprintf(L"The ray count must be at least 1.\n");
+		return 1;
+	}
+
+	GModelFile::Mesh mesh;
+	if (!GModelFile::ReadAny(input, mesh))
+	{
+		wprintf(L"Could not read %ls.\n", input);
+		return 1;
+	}
+
+	std::vector<XMFLOAT3> scenePositions;
+	std::vector<UINT> sceneIndices;
+	AppendGeometry(mesh, scenePositions, sceneIndices);
+
+	for (size_t i = 0; i < occluders.size(); ++i)
+	{
+		GModelFile::Mesh occluder;
+		if (!GModelFile::ReadAny(occluders[i], occluder))
+		{
+			wprintf(L"Could not read %ls.\n", occluders[i]);
+			return 1;
+		}
+		AppendGeometry(occluder, scenePositions, sceneIndices);
+	}
+
+	float diagonal = GetDiagonal(scenePositions);
+	if (desc.MaxDistance <= 0.0f)
+	{
+		desc.MaxDistance = DefaultDistanceScale * diagonal;
+	}
+	if (desc.Bias < 0.0f)
+	{
+		desc.Bias = DefaultBiasScale * diagonal;
+	}
+
+	Clock::time_point start = Clock::now();
+
+	GMeshBVH bvh;
+	bvh.Build(scenePositions.data(), sceneIndices.data(), static_cast<UINT>(sceneIndices.size()));
+
+	float buildTime = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+	GAOBaker baker;
+	baker.Bake(bvh, mesh.Positions.data(), mesh.Normals.data(), static_cast<UINT>(mesh.Positions.size()), desc, mesh.AmbientAccess);
+
+	double sum = 0.0;
+	for (size_t i = 0; i < mesh.AmbientAccess.size(); ++i)
+	{
+		sum += mesh.AmbientAccess[i];
+	}
+
+	wprintf(L"%u vertices, %u triangles in the BVH (%u nodes, built in %.1f ms)\n",
+		static_cast<UINT>(mesh.Positions.size()), bvh.GetTriangleCount(), bvh.GetNodeCount(), buildTime);
+	wprintf(L"%u rays per vertex, distance %g, bias %g, %u threads\n",
+		desc.SampleCount, desc.MaxDistance, desc.Bias, GThreadPool::Get().GetThreadCount());
+	wprintf(L"Baked in %.1f ms, %.2f Mrays/s, mean access %.3f\n",
+		baker.GetBakeTime(), baker.GetRaysPerSecond() / 1e6f,
+		mesh.AmbientAccess.empty() ? 1.0 : sum / mesh.AmbientAccess.size());
+
+	if (!GModelFile::Write(output, mesh))
+	{
+		wprintf(L"Could not write %ls.\n", output);
+		return 1;
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,979 @@
+/*  ===============================================
+	Summary: Offline Texture Tools
+	===============================================  */
+
+#include "DDSTextureLoader.h"
+#include "GBlockCompressor.h"
+#include "GDDSWriter.h"
+#include "GImageBlur.h"
+#include "GMipGenerator.h"
+#include "GTextureAtlas.h"
+#include "GThreadPool.h"
+
+#include <Windows.h>
+#include <wincodec.h>
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	// RGBA8, rows packed.
+	struct Image
+	{
+		UINT Width;
+		UINT Height;
+		std::vector<uint8_t> Pixels;
+	};
+
+	template <typename T>
+	void SafeRelease(T*& object)
+	{
+		if (object)
+		{
+			object->Release();
+			object = nullptr;
+		}
+	}
+
+	// Decodes any format WIC understands (PNG, BMP, TGA with codecs installed, ...) to RGBA8.
+	bool LoadImageRGBA(LPCWSTR filename, Image& image)
+	{
+		IWICImagingFactory* factory = nullptr;
+		IWICBitmapDecoder* decoder = nullptr;
+		IWICBitmapFrameDecode* frame = nullptr;
+		IWICFormatConverter* converter = nullptr;
+
+		HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory));
+		if (SUCCEEDED(hr))
+		{
+			hr = factory->CreateDecoderFromFilename(filename, nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &decoder);
+		}
+		if (SUCCEEDED(hr))
+		{
+			hr = decoder->GetFrame(0, &frame);
+		}
+		if (SUCCEEDED(hr))
+		{
+			hr = factory->CreateFormatConverter(&converter);
+		}
+		if (SUCCEEDED(hr))
+		{
+			hr = converter->Initialize(frame, GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom);
+		}
+		if (SUCCEEDED(hr))
+		{
+			hr = converter->GetSize(&image.Width, &image.Height);
+		}
+		if (SUCCEEDED(hr))
+		{
+			image.Pixels.resize(static_cast<size_t>(image.Width) * image.Height * 4);
+			hr = converter->CopyPixels(nullptr, image.Width * 4, static_cast<UINT>(image.Pixels.size()), image.Pixels.data());
+		}
+
+		SafeRelease(converter);
+		SafeRelease(frame);
+		SafeRelease(decoder);
+		SafeRelease(factory);
+
+		return SUCCEEDED(hr);
+	}
+
+	void PrintUsage()
+	{
+		wprintf(L"Usage:\n");
+		wprintf(L"  TextureTools compress <input> <output.dds> [-format bc1|bc3|bc5] [-srgb] [-bench <runs>]\n");
+		wprintf(L"  TextureTools mips <input> <output.dds> [-filter box|kaiser|min|max] [-format rgba8|bc1|bc3|bc5] [-srgb] [-bench <runs>]\n");
+		wprintf(L"  TextureTools pack <output.dds> <input> <input> ... [-size <width> <height>] [-format keep|rgba8|bgra8|bc1|bc3|bc5] [-filter box|kaiser] [-srgb]\n");
+		wprintf(L"  TextureTools atlas <output.dds> <input> <input> ... [-gutter <texels>] [-maxsize <texels>] [-format rgba8|bgra8|bc1|bc3] [-srgb]\n");
+		wprintf(L"  TextureTools blurbench [-size <width> <height>] [-sigma <texels>] [-radius <texels>] [-passes <n>] [-runs <n>]\n");
+		wprintf(L"\n");
+		wprintf(L"  bc1  opaque colour (default for compress)\n");
+		wprintf(L"  bc3  colour with alpha, e.g. billboard trees\n");
+		wprintf(L"  bc5  two-channel normal maps (x and y in red and green)\n");
+		wprintf(L"\n");
+		wprintf(L"  -srgb filters colour in linear space and marks the file as sRGB\n");
+		wprintf(L"\n");
+		wprintf(L"  pack writes one texture array.  Inputs already at the output size and format are\n");
+		wprintf(L"  copied with their own mips; the rest are resampled (Kaiser by default) and rebuilt.\n");
+		wprintf(L"\n");
+		wprintf(L"  atlas packs sprites into one texture (bc3 by default) and writes their rects to\n");
+		wprintf(L"  <output>.atlas.  The gutter (8 by default) keeps log2(gutter) + 1 mips free of bleeding.\n");
+		wprintf(L"\n");
+		wprintf(L"  blurbench times the CPU Gaussian blur on an RGBA16F image (3840x2160 by default) with\n");
+		wprintf(L"  1, 2, 4, ... threads up to the pool size.\n");
+	}
+
+	bool ParseBlockFormat(LPCWSTR name, GBlockCompressor::Format& format)
+	{
+		if (_wcsicmp(name, L"bc1") == 0) { format = GBlockCompressor::FORMAT_BC1; return true; }
+		if (_wcsicmp(name, L"bc3") == 0) { format = GBlockCompressor::FORMAT_BC3; return true; }
+		if (_wcsicmp(name, L"bc5") == 0) { format = GBlockCompressor::FORMAT_BC5; return true; }
+		return false;
+	}
+
+	bool ParseFilter(LPCWSTR name, GMipGenerator::Filter& filter)
+	{
+		if (_wcsicmp(name, L"box") == 0) { filter = GMipGenerator::FILTER_BOX; return true; }
+		if (_wcsicmp(name, L"kaiser") == 0) { filter = GMipGenerator::FILTER_KAISER; return true; }
+		if (_wcsicmp(name, L"min") == 0) { filter = GMipGenerator::FILTER_MIN; return true; }
+		if (_wcsicmp(name, L"max") == 0) { filter = GMipGenerator::FILTER_MAX; return true; }
+		return false;
+	}
+
+	DXGI_FORMAT GetBlockDXGIFormat(GBlockCompressor::Format format, bool bSRGB)
+	{
+		switch (format)
+		{
+		case GBlockCompressor::FORMAT_BC1: return bSRGB ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+		case GBlockCompressor::FORMAT_BC3: return bSRGB ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+		case GBlockCompressor::FORMAT_BC5: return DXGI_FORMAT_BC5_UNORM;
+		}
+		return DXGI_FORMAT_UNKNOWN;
+	}
+
+	// Quality is measured on the channels the format is meant to carry.
+	UINT GetBlockChannelMask(GBlockCompressor::Format format)
+	{
+		switch (format)
+		{
+		case GBlockCompressor::FORMAT_BC3: return 0xf;
+		case GBlockCompressor::FORMAT_BC5: return 0x3;
+		default: return 0x7;
+		}
+	}
+
+	int CompressCommand(int argc, wchar_t* argv[])
+	{
+		if (argc < 2)
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		LPCWSTR input = argv[0];
+		LPCWSTR output = argv[1];
+
+		GBlockCompressor::Format format = GBlockCompressor::FORMAT_BC1;
+		bool bSRGB = false;
+		UINT benchRuns = 0;
+
+		for (int i = 2; i < argc; ++i)
+		{
+			if (wcscmp(argv[i], L"-format") == 0 && i + 1 < argc)
+			{
+				if (!ParseBlockFormat(argv[++i], format))
+				{
+					PrintUsage();
+					return 1;
+				}
+			}
+			else if (wcscmp(argv[i], L"-srgb") == 0)
+			{
+				bSRGB = true;
+			}
+			else if (wcscmp(argv[i], L"-bench") == 0 && i + 1 < argc)
+			{
+				benchRuns = static_cast<UINT>(_wtoi(argv[++i]));
+			}
+			else
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+
+		Image image;
+		if (!LoadImageRGBA(input, image))
+		{
+			wprintf(L"Failed to load %s\n", input);
+			return 1;
+		}
+
+		std::vector<uint8_t> blocks(static_cast<size_t>(GBlockCompressor::GetCompressedSize(format, image.Width, image.Height)));
+		UINT rowPitch = image.Width * 4;
+
+		GBlockCompressor::Compress(format, image.Pixels.data(), image.Width, image.Height, rowPitch, blocks.data());
+
+		std::vector<uint8_t> decoded(image.Pixels.size());
+		GBlockCompressor::Decompress(format, blocks.data(), image.Width, image.Height, decoded.data(), rowPitch);
+		double psnr = GBlockCompressor::ComputePSNR(image.Pixels.data(), decoded.data(), image.Width, image.Height, rowPitch, GetBlockChannelMask(format));
+
+		GDDSWriter::Desc desc;
+		desc.Format = GetBlockDXGIFormat(format, bSRGB);
+		desc.Width = image.Width;
+		desc.Height = image.Height;
+		desc.MipLevels = 1;
+		desc.ArraySize = 1;
+		desc.bCubeMap = false;
+
+		const void* subresources[] = { blocks.data() };
+		if (!GDDSWriter::Write(output, desc, subresources))
+		{
+			wprintf(L"Failed to write %s\n", output);
+			return 1;
+		}
+
+		wprintf(L"%s: %ux%u, %zu bytes, PSNR %.2f dB\n", output, image.Width, image.Height, blocks.size(), psnr);
+
+		if (benchRuns > 0)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			for (UINT run = 0; run < benchRuns; ++run)
+			{
+				GBlockCompressor::Compress(format, image.Pixels.data(), image.Width, image.Height, rowPitch, blocks.data());
+			}
+			std::chrono::duration<double> seconds = std::chrono::high_resolution_clock::now() - start;
+
+			double megapixels = static_cast<double>(image.Width) * image.Height * benchRuns / 1.0e6;
+			wprintf(L"Compressed %u times in %.3f s: %.1f MP/s\n", benchRuns, seconds.count(), megapixels / seconds.count());
+		}
+
+		return 0;
+	}
+
+	int MipsCommand(int argc, wchar_t* argv[])
+	{
+		if (argc < 2)
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		LPCWSTR input = argv[0];
+		LPCWSTR output = argv[1];
+
+		GMipGenerator::Filter filter = GMipGenerator::FILTER_BOX;
+		GBlockCompressor::Format blockFormat = GBlockCompressor::FORMAT_BC1;
+		bool bCompress = false;
+		bool bSRGB = false;
+		UINT benchRuns = 0;
+
+		for (int i = 2; i < argc; ++i)
+		{
+			if (wcscmp(argv[i], L"-filter") == 0 && i + 1 < argc)
+			{
+				if (!ParseFilter(argv[++i], filter))
+				{
+					PrintUsage();
+					return 1;
+				}
+			}
+			else if (wcscmp(argv[i], L"-format") == 0 && i + 1 < argc)
+			{
+				++i;
+				bCompress = _wcsicmp(argv[i], L"rgba8") != 0;
+				if (bCompress && !ParseBlockFormat(argv[i], blockFormat))
+				{
+					PrintUsage();
+					return 1;
+				}
+			}
+			else if (wcscmp(argv[i], L"-srgb") == 0)
+			{
+				bSRGB = true;
+			}
+			else if (wcscmp(argv[i], L"-bench") == 0 && i + 1 < argc)
+			{
+				benchRuns = static_cast<UINT>(_wtoi(argv[++i]));
+			}
+			else
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+
+		Image image;
+		if (!LoadImageRGBA(input, image))
+		{
+			wprintf(L"Failed to load %s\n", input);
+			return 1;
+		}
+
+		GMipGenerator::Format mipFormat = bSRGB ? GMipGenerator::FORMAT_R8G8B8A8_SRGB : GMipGenerator::FORMAT_R8G8B8A8;
+
+		std::vector<GMipGenerator::Level> levels;
+		GMipGenerator::GenerateChain(mipFormat, filter, image.Pixels.data(), image.Width, image.Height, image.Width * 4, levels);
+
+		UINT mipLevels = static_cast<UINT>(levels.size());
+		std::vector<std::vector<uint8_t>> blocks;
+		std::vector<const void*> subresources(mipLevels);
+
+		GDDSWriter::Desc desc;
+		desc.Width = image.Width;
+		desc.Height = image.Height;
+		desc.MipLevels = mipLevels;
+		desc.ArraySize = 1;
+		desc.bCubeMap = false;
+
+		if (bCompress)
+		{
+			desc.Format = GetBlockDXGIFormat(blockFormat, bSRGB);
+
+			blocks.resize(mipLevels);
+			for (UINT mip = 0; mip < mipLevels; ++mip)
+			{
+				const GMipGenerator::Level& level = levels[mip];
+				blocks[mip].resize(static_cast<size_t>(GBlockCompressor::GetCompressedSize(blockFormat, level.Width, level.Height)));
+				GBlockCompressor::Compress(blockFormat, level.Data.data(), level.Width, level.Height, level.RowPitch, blocks[mip].data());
+				subresources[mip] = blocks[mip].data();
+			}
+		}
+		else
+		{
+			desc.Format = bSRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+
+			for (UINT mip = 0; mip < mipLevels; ++mip)
+			{
+				subresources[mip] = levels[mip].Data.data();
+			}
+		}
+
+		if (!GDDSWriter::Write(output, desc, subresources.data()))
+		{
+			wprintf(L"Failed to write %s\n", output);
+			return 1;
+		}
+
+		wprintf(L"%s: %ux%u, %u mips\n", output, image.Width, image.Height, mipLevels);
+
+		if (benchRuns > 0)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			for (UINT run = 0; run < benchRuns; ++run)
+			{
+				GMipGenerator::GenerateChain(mipFormat, filter, image.Pixels.data(), image.Width, image.Height, image.Width * 4, levels);
+			}
+			std::chrono::duration<double> seconds = std::chrono::high_resolution_clock::now() - start;
+
+			// Measured against the top level, the way texture sizes are usually quoted.
+			double megapixels = static_cast<double>(image.Width) * image.Height * benchRuns / 1.0e6;
+			wprintf(L"Built %u chains in %.3f s: %.1f MP/s\n", benchRuns, seconds.count(), megapixels / seconds.count());
+		}
+
+		return 0;
+	}
+
+	bool HasExtension(LPCWSTR filename, LPCWSTR extension)
+	{
+		LPCWSTR dot = wcsrchr(filename, L'.');
+		return dot && _wcsicmp(dot, extension) == 0;
+	}
+
+	bool IsSRGBFormat(DXGI_FORMAT format)
+	{
+		return format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB ||
+			format == DXGI_FORMAT_BC1_UNORM_SRGB || format == DXGI_FORMAT_BC3_UNORM_SRGB;
+	}
+
+	// Formats pack can write, and the ones it can decode when an input has to be resampled.
+	bool IsPackFormat(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8X8_UNORM:
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+		case DXGI_FORMAT_BC5_UNORM:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool ParsePackFormat(LPCWSTR name, bool bSRGB, DXGI_FORMAT& format)
+	{
+		GBlockCompressor::Format blockFormat;
+		if (ParseBlockFormat(name, blockFormat))
+		{
+			format = GetBlockDXGIFormat(blockFormat, bSRGB);
+			return true;
+		}
+
+		if (_wcsicmp(name, L"rgba8") == 0) { format = bSRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM; return true; }
+		if (_wcsicmp(name, L"bgra8") == 0) { format = bSRGB ? DXGI_FORMAT_B8G8R8A8_UNORM_SRGB : DXGI_FORMAT_B8G8R8A8_UNORM; return true; }
+		return false;
+	}
+
+	// Top level of a DDS file as RGBA8.
+	bool DecodeDDSImage(const DirectX::DDS_TEXTURE_DATA& dds, Image& image)
+	{
+		image.Width = static_cast<UINT>(dds.width);
+		image.Height = static_cast<UINT>(dds.height);
+		image.Pixels.resize(static_cast<size_t>(image.Width) * image.Height * 4);
+
+		const D3D11_SUBRESOURCE_DATA& top = dds.initData[0];
+		const uint8_t* src = static_cast<const uint8_t*>(top.pSysMem);
+		UINT rowPitch = image.Width * 4;
+
+		switch (dds.format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			GBlockCompressor::Decompress(GBlockCompressor::FORMAT_BC1, src, image.Width, image.Height, image.Pixels.data(), rowPitch);
+			return true;
+
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			GBlockCompressor::Decompress(GBlockCompressor::FORMAT_BC3, src, image.Width, image.Height, image.Pixels.data(), rowPitch);
+			return true;
+
+		case DXGI_FORMAT_BC5_UNORM:
+			GBlockCompressor::Decompress(GBlockCompressor::FORMAT_BC5, src, image.Width, image.Height, image.Pixels.data(), rowPitch);
+			return true;
+
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8X8_UNORM:
+			break;
+
+		default:
+			return false;
+		}
+
+		bool bSwapRB = dds.format != DXGI_FORMAT_R8G8B8A8_UNORM && dds.format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+		bool bOpaque = dds.format == DXGI_FORMAT_B8G8R8X8_UNORM;
+
+		for (UINT y = 0; y < image.Height; ++y)
+		{
+			uint8_t* dest = &image.Pixels[static_cast<size_t>(y) * rowPitch];
+			memcpy(dest, src + static_cast<size_t>(y) * top.SysMemPitch, rowPitch);
+
+			for (UINT x = 0; x < image.Width; ++x, dest += 4)
+			{
+				if (bSwapRB)
+				{
+					std::swap(dest[0], dest[2]);
+				}
+				if (bOpaque)
+				{
+					dest[3] = 255;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	void EncodeLevel(DXGI_FORMAT format, const GMipGenerator::Level& level, std::vector<uint8_t>& out)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+		case DXGI_FORMAT_BC5_UNORM:
+		{
+			GBlockCompressor::Format blockFormat = GBlockCompressor::FORMAT_BC1;
+			if (format == DXGI_FORMAT_BC3_UNORM || format == DXGI_FORMAT_BC3_UNORM_SRGB) { blockFormat = GBlockCompressor::FORMAT_BC3; }
+			if (format == DXGI_FORMAT_BC5_UNORM) { blockFormat = GBlockCompressor::FORMAT_BC5; }
+
+			out.resize(static_cast<size_t>(GBlockCompressor::GetCompressedSize(blockFormat, level.Width, level.Height)));
+			GBlockCompressor::Compress(blockFormat, level.Data.data(), level.Width, level.Height, level.RowPitch, out.data());
+			break;
+		}
+
+		default:
+			out = level.Data;
+			if (format != DXGI_FORMAT_R8G8B8A8_UNORM && format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)
+			{
+				for (size_t i = 0; i < out.size(); i += 4)
+				{
+					std::swap(out[i], out[i + 2]);
+				}
+			}
+			break;
+		}
+	}
+
+	int PackCommand(int argc, wchar_t* argv[])
+	{
+		LPCWSTR output = nullptr;
+		std::vector<LPCWSTR> inputs;
+
+		UINT width = 0;
+		UINT height = 0;
+		LPCWSTR formatName = nullptr;
+		GMipGenerator::Filter filter = GMipGenerator::FILTER_KAISER;
+		bool bSRGB = false;
+
+		for (int i = 0; i < argc; ++i)
+		{
+			if (wcscmp(argv[i], L"-size") == 0 && i + 2 < argc)
+			{
+				width = static_cast<UINT>(_wtoi(argv[++i]));
+				height = static_cast<UINT>(_wtoi(argv[++i]));
+			}
+			else if (wcscmp(argv[i], L"-format") == 0 && i + 1 < argc)
+			{
+				formatName = argv[++i];
+			}
+			else if (wcscmp(argv[i], L"-filter") == 0 && i + 1 < argc)
+			{
+				if (!ParseFilter(argv[++i], filter))
+				{
+					PrintUsage();
+					return 1;
+				}
+			}
+			else if (wcscmp(argv[i], L"-srgb") == 0)
+			{
+				bSRGB = true;
+			}
+			else if (argv[i][0] == L'-')
+			{
+				PrintUsage();
+				return 1;
+			}
+			else if (!output)
+			{
+				output = argv[i];
+			}
+			else
+			{
+				inputs.push_back(argv[i]);
+			}
+		}
+
+		if (!output || inputs.empty())
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		UINT numLayers = static_cast<UINT>(inputs.size());
+		std::vector<DirectX::DDS_TEXTURE_DATA> dds(numLayers);
+		std::vector<Image> images(numLayers);
+
+		for (UINT i = 0; i < numLayers; ++i)
+		{
+			bool bLoaded = false;
+			if (HasExtension(inputs[i], L".dds"))
+			{
+				bLoaded = SUCCEEDED(DirectX::LoadDDSTextureDataFromFile(inputs[i], dds[i])) &&
+					dds[i].resDim == D3D11_RESOURCE_DIMENSION_TEXTURE2D && dds[i].arraySize == 1 && !dds[i].isCubeMap;
+			}
+			else
+			{
+				bLoaded = LoadImageRGBA(inputs[i], images[i]);
+			}
+
+			if (!bLoaded)
+			{
+				wprintf(L"Failed to load %s\n", inputs[i]);
+				return 1;
+			}
+		}
+
+		// The first input decides the size, and its format is kept when every DDS input shares it.
+		if (width == 0 || height == 0)
+		{
+			width = dds[0].fileData ? static_cast<UINT>(dds[0].width) : images[0].Width;
+			height = dds[0].fileData ? static_cast<UINT>(dds[0].height) : images[0].Height;
+		}
+
+		DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+		if (formatName && _wcsicmp(formatName, L"keep") != 0)
+		{
+			if (!ParsePackFormat(formatName, bSRGB, format))
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+		else
+		{
+			format = dds[0].fileData ? dds[0].format : DXGI_FORMAT_UNKNOWN;
+			for (UINT i = 1; i < numLayers; ++i)
+			{
+				if (!dds[i].fileData || dds[i].format != format)
+				{
+					format = DXGI_FORMAT_UNKNOWN;
+				}
+			}
+
+			if (!IsPackFormat(format))
+			{
+				format = bSRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+			}
+		}
+
+		bSRGB = bSRGB || IsSRGBFormat(format);
+		GMipGenerator::Format mipFormat = bSRGB ? GMipGenerator::FORMAT_R8G8B8A8_SRGB : GMipGenerator::FORMAT_R8G8B8A8;
+		UINT mipLevels = GMipGenerator::GetMipCount(width, height);
+
+		std::vector<std::vector<std::vector<uint8_t>>> encoded(numLayers);
+		std::vector<const void*> subresources(numLayers * mipLevels);
+
+		for (UINT i = 0; i < numLayers; ++i)
+		{
+			// Layers that already match are copied as they are, authored mips included.
+			const DirectX::DDS_TEXTURE_DATA& layer = dds[i];
+			if (layer.fileData && layer.format == format && layer.width == width && layer.height == height && layer.mipCount >= mipLevels)
+			{
+				for (UINT mip = 0; mip < mipLevels; ++mip)
+				{
+					subresources[i * mipLevels + mip] = layer.initData[mip].pSysMem;
+				}
+
+				wprintf(L"  %s: copied\n", inputs[i]);
+				continue;
+			}
+
+			Image& image = images[i];
+			if (layer.fileData && !DecodeDDSImage(layer, image))
+			{
+				wprintf(L"Cannot convert %s from its format\n", inputs[i]);
+				return 1;
+			}
+
+			if (image.Width != width || image.Height != height)
+			{
+				Image resized;
+				resized.Width = width;
+				resized.Height = height;
+				resized.Pixels.resize(static_cast<size_t>(width) * height * 4);
+
+				GMipGenerator::Resize(mipFormat, filter, image.Pixels.data(), image.Width, image.Height, image.Width * 4,
+					resized.Pixels.data(), width, height, width * 4);
+
+				wprintf(L"  %s: resized from %ux%u\n", inputs[i], image.Width, image.Height);
+				image = std::move(resized);
+			}
+			else
+			{
+				wprintf(L"  %s: rebuilt\n", inputs[i]);
+			}
+
+			std::vector<GMipGenerator::Level> levels;
+			GMipGenerator::GenerateChain(mipFormat, filter, image.Pixels.data(), width, height, width * 4, levels);
+
+			encoded[i].resize(mipLevels);
+			for (UINT mip = 0; mip < mipLevels; ++mip)
+			{
+				EncodeLevel(format, levels[mip], encoded[i][mip]);
+				subresources[i * mipLevels + mip] = encoded[i][mip].data();
+			}
+		}
+
+		GDDSWriter::Desc desc;
+		desc.Format = format;
+		desc.Width = width;
+		desc.Height = height;
+		desc.MipLevels = mipLevels;
+		desc.ArraySize = numLayers;
+		desc.bCubeMap = false;
+
+		if (!GDDSWriter::Write(output, desc, subresources.data()))
+		{
+			wprintf(L"Failed to write %s\n", output);
+			return 1;
+		}
+
+		wprintf(L"%s: %u layers, %ux%u, %u mips\n", output, numLayers, width, height, mipLevels);
+		return 0;
+	}
+
+	// Texture name with its extension replaced, e.g. trees.dds -> trees.atlas.
+	std::wstring ReplaceExtension(LPCWSTR filename, LPCWSTR extension)
+	{
+		std::wstring name(filename);
+		size_t dot = name.find_last_of(L'.');
+		size_t slash = name.find_last_of(L"\\/");
+		if (dot != std::wstring::npos && (slash == std::wstring::npos || dot > slash))
+		{
+			name.resize(dot);
+		}
+		return name + extension;
+	}
+
+	int AtlasCommand(int argc, wchar_t* argv[])
+	{
+		LPCWSTR output = nullptr;
+		std::vector<LPCWSTR> inputs;
+
+		UINT gutter = 8;
+		UINT maxSize = 8192;
+		LPCWSTR formatName = L"bc3";
+		bool bSRGB = false;
+
+		for (int i = 0; i < argc; ++i)
+		{
+			if (wcscmp(argv[i], L"-gutter") == 0 && i + 1 < argc)
+			{
+				gutter = static_cast<UINT>(_wtoi(argv[++i]));
+			}
+			else if (wcscmp(argv[i], L"-maxsize") == 0 && i + 1 < argc)
+			{
+				maxSize = static_cast<UINT>(_wtoi(argv[++i]));
+			}
+			else if (wcscmp(argv[i], L"-format") == 0 && i + 1 < argc)
+			{
+				formatName = argv[++i];
+			}
+			else if (wcscmp(argv[i], L"-srgb") == 0)
+			{
+				bSRGB = true;
+			}
+			else if (argv[i][0] == L'-')
+			{
+				PrintUsage();
+				return 1;
+			}
+			else if (!output)
+			{
+				output = argv[i];
+			}
+			else
+			{
+				inputs.push_back(argv[i]);
+			}
+		}
+
+		DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+		if (!output || inputs.empty() || !ParsePackFormat(formatName, bSRGB, format) || format == DXGI_FORMAT_BC5_UNORM)
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		UINT numSprites = static_cast<UINT>(inputs.size());
+		std::vector<Image> images(numSprites);
+		std::vector<UINT> widths(numSprites);
+		std::vector<UINT> heights(numSprites);
+
+		for (UINT i = 0; i < numSprites; ++i)
+		{
+			bool bLoaded = false;
+			if (HasExtension(inputs[i], L".dds"))
+			{
+				DirectX::DDS_TEXTURE_DATA dds;
+				bLoaded = SUCCEEDED(DirectX::LoadDDSTextureDataFromFile(inputs[i], dds)) &&
+					dds.resDim == D3D11_RESOURCE_DIMENSION_TEXTURE2D && DecodeDDSImage(dds, images[i]);
+			}
+			else
+			{
+				bLoaded = LoadImageRGBA(inputs[i], images[i]);
+			}
+
+			if (!bLoaded)
+			{
+				wprintf(L"Failed to load %s\n", inputs[i]);
+				return 1;
+			}
+
+			widths[i] = images[i].Width;
+			heights[i] = images[i].Height;
+		}
+
+		UINT width = 0;
+		UINT height = 0;
+		std::vector<GTextureAtlas::Rect> rects(numSprites);
+		if (!GTextureAtlas::Pack(widths.data(), heights.data(), numSprites, gutter, maxSize, width, height, rects.data()))
+		{
+			wprintf(L"The sprites do not fit in %ux%u\n", maxSize, maxSize);
+			return 1;
+		}
+
+		// Space between the sprites is left transparent.
+		std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4, 0);
+		for (UINT i = 0; i < numSprites; ++i)
+		{
+			GTextureAtlas::Blit(images[i].Pixels.data(), images[i].Width * 4, rects[i], gutter, pixels.data(), width, height, width * 4);
+			wprintf(L"  %s: %ux%u at (%u, %u)\n", inputs[i], rects[i].Width, rects[i].Height, rects[i].X, rects[i].Y);
+		}
+
+		GMipGenerator::Format mipFormat = IsSRGBFormat(format) ? GMipGenerator::FORMAT_R8G8B8A8_SRGB : GMipGenerator::FORMAT_R8G8B8A8;
+
+		std::vector<GMipGenerator::Level> levels;
+		GMipGenerator::GenerateChain(mipFormat, GMipGenerator::FILTER_BOX, pixels.data(), width, height, width * 4, levels);
+
+		UINT mipLevels = static_cast<UINT>(levels.size());
+		std::vector<std::vector<uint8_t>> encoded(mipLevels);
+		std::vector<const void*> subresources(mipLevels);
+
+		for (UINT mip = 0; mip < mipLevels; ++mip)
+		{
+			EncodeLevel(format, levels[mip], encoded[mip]);
+			subresources[mip] = encoded[mip].data();
+		}
+
+		GDDSWriter::Desc desc;
+		desc.Format = format;
+		desc.Width = width;
+		desc.Height = height;
+		desc.MipLevels = mipLevels;
+		desc.ArraySize = 1;
+		desc.bCubeMap = false;
+
+		if (!GDDSWriter::Write(output, desc, subresources.data()))
+		{
+			wprintf(L"Failed to write %s\n", output);
+			return 1;
+		}
+
+		std::wstring layout = ReplaceExtension(output, L".atlas");
+		if (!GTextureAtlas::WriteLayout(layout.c_str(), width, height, rects.data(), numSprites))
+		{
+			wprintf(L"Failed to write %s\n", layout.c_str());
+			return 1;
+		}
+
+		wprintf(L"%s: %u sprites, %ux%u, %u mips\n", output, numSprites, width, height, mipLevels);
+		return 0;
+	}
+
+	int BlurBenchCommand(int argc, wchar_t* argv[])
+	{
+		UINT width = 3840;
+		UINT height = 2160;
+		float sigma = 2.5f;
+		UINT radius = 0;
+		UINT passes = 1;
+		UINT runs = 5;
+
+		for (int i = 0; i < argc; ++i)
+		{
+			if (wcscmp(argv[i], L"-size") == 0 && i + 2 < argc)
+			{
+				width = static_cast<UINT>(_wtoi(argv[++i]));
+				height = static_cast<UINT>(_wtoi(argv[++i]));
+			}
+			else if (wcscmp(argv[i], L"-sigma") == 0 && i + 1 < argc)
+			{
+				sigma = static_cast<float>(_wtof(argv[++i]));
+			}
+			else if (wcscmp(argv[i], L"-radius") == 0 && i + 1 < argc)
+			{
+				radius = static_cast<UINT>(_wtoi(argv[++i]));
+			}
+			else if (wcscmp(argv[i], L"-passes") == 0 && i + 1 < argc)
+			{
+				passes = static_cast<UINT>(_wtoi(argv[++i]));
+			}
+			else if (wcscmp(argv[i], L"-runs") == 0 && i + 1 < argc)
+			{
+				runs = static_cast<UINT>(_wtoi(argv[++i]));
+			}
+			else
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+
+		if (width == 0 || height == 0 || runs == 0)
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		// Smooth gradients with some per-pixel variation, so the data is not all one value.
+		std::vector<DirectX::PackedVector::HALF> image(static_cast<size_t>(width) * height * 4);
+		for (UINT y = 0; y < height; ++y)
+		{
+			for (UINT x = 0; x < width; ++x)
+			{
+				DirectX::PackedVector::HALF* pixel = &image[(static_cast<size_t>(y) * width + x) * 4];
+				pixel[0] = DirectX::PackedVector::XMConvertFloatToHalf(static_cast<float>(x) / width);
+				pixel[1] = DirectX::PackedVector::XMConvertFloatToHalf(static_cast<float>(y) / height);
+				pixel[2] = DirectX::PackedVector::XMConvertFloatToHalf(static_cast<float>((x * 7 + y * 13) % 64) / 64.0f);
+				pixel[3] = DirectX::PackedVector::XMConvertFloatToHalf(1.0f);
+			}
+		}
+
+		GImageBlur blur;
+		blur.SetGaussian(sigma, radius);
+
+		wprintf(L"%ux%u RGBA16F, radius %u, %u pass(es), best of %u runs\n", width, height, blur.GetRadius(), passes, runs);
+
+		UINT maxThreads = GThreadPool::Get().GetThreadCount();
+		float singleThreadTime = 0.0f;
+
+		for (UINT threads = 1; ; threads = (std::min)(threads * 2, maxThreads))
+		{
+			blur.SetThreadCount(threads);
+
+			float best = 0.0f;
+			for (UINT run = 0; run < runs; ++run)
+			{
+				blur.Blur(GImageBlur::FORMAT_R16G16B16A16_FLOAT, image.data(), width, height, width * 8, passes);
+				best = (run == 0) ? blur.GetBlurTime() : (std::min)(best, blur.GetBlurTime());
+			}
+
+			if (threads == 1)
+			{
+				singleThreadTime = best;
+			}
+
+			double megapixels = static_cast<double>(width) * height * passes / 1.0e6;
+			wprintf(L"  %2u threads: %8.2f ms  %8.1f MP/s  %5.2fx\n", threads, best, megapixels / (best / 1000.0), singleThreadTime / best);
+
+			if (threads == maxThreads)
+			{
+				break;
+			}
+		}
+
+		return 0;
+	}
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+	if (argc < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (FAILED(CoInitializeEx(nullptr, COINIT_MULTITHREADED)))
+	{
+		return 1;
+	}
+
+	int result = 1;
+	if (wcscmp(argv[1], L"compress") == 0)
+	{
+		result = CompressCommand(argc - 2, argv + 2);
+	}
+	else if (wcscmp(argv[1], L"mips") == 0)
+	{
+		result = MipsCommand(argc - 2, argv + 2);
+	}
+	else if (wcscmp(argv[1], L"pack") == 0)
+	{
+		result = PackCommand(argc - 2, argv + 2);
+	}
+	else if (wcscmp(argv[1], L"atlas") == 0)
+	{
+		result = AtlasCommand(argc - 2, argv + 2);
+	}
+	else if (wcscmp(argv[1], L"blurbench") == 0)
+	{
+		result = BlurBenchCommand(argc - 2, argv + 2);
+	}
+	else
+	{
+		PrintUsage();
+	}
+
+	CoUninitialize();
+	return result;
+}
\ No newline at end of file